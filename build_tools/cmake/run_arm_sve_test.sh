@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Copyright 2024 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+set -x
+set -e
+
+# Run the test under QEMU once per SVE vector length if
+# `IREE_ARM_SVE_QEMU_AARCH64_BIN` is set. Vector-length-agnostic code otherwise
+# only gets tested at the vector length of the host it happens to run on.
+# It is assumed that if `IREE_ARM_SVE_QEMU_AARCH64_BIN` is set then IREE has
+# been built for AArch64.
+if [[ ! -z "${IREE_ARM_SVE_QEMU_AARCH64_BIN}" ]]; then
+  # Vector lengths in bytes: 128, 256, 512, and 2048 bits.
+  for vector_length in 16 32 64 256; do
+    "${IREE_ARM_SVE_QEMU_AARCH64_BIN}" \
+      "-cpu" "max,sve-default-vector-length=${vector_length}" "--" "$@"
+  done
+else
+  "$@"
+fi
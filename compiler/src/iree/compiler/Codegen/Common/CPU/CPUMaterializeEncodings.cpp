@@ -203,16 +203,32 @@ enumerateMatmulTileX86_64(TypeRange elementTypes,
   Type rhs = elementTypes[1];
   Type out = elementTypes[2];
 
+  // AMX tiles are only implemented by ukernels, so they are only enumerated
+  // when ukernels are enabled. They come ahead of the AVX-512 tiles which stay
+  // enumerated as a fallback when round_dims_to is too small for K0.
+  bool useAMX = hasUkernel(target) && hasFeature(target, "+amx-tile");
+
   if (out.isF32() || out.isF16() || out.isBF16()) {
     if (lhs.isBF16() && rhs.isBF16() && (out.isBF16() || out.isF32())) {
       if (hasFeature(target, "+avx512bf16")) {
-        return {
+        SmallVector<TileMxNxK> tiles;
+        if (useAMX && hasFeature(target, "+amx-bf16")) {
+          tiles.append({
+              TileMxNxK{16, 16, 16}, // Aim to use TDPBF16PS.
+              TileMxNxK{8, 16, 16},  // Truncation of the above.
+              TileMxNxK{4, 16, 16},  // Truncation of the above.
+              TileMxNxK{2, 16, 16},  // Truncation of the above.
+              TileMxNxK{1, 16, 16},  // Truncation of the above.
+          });
+        }
+        tiles.append({
             TileMxNxK{16, 16, 2}, // Aim to use VDPBF16PS (zmm).
             TileMxNxK{8, 16, 2},  // Truncation of the above.
             TileMxNxK{4, 16, 2},  // Truncation of the above.
             TileMxNxK{2, 16, 2},  // Truncation of the above.
             TileMxNxK{1, 16, 2},  // Truncation of the above.
-        };
+        });
+        return tiles;
       }
     }
     if (isa<FloatType>(lhs) && isa<FloatType>(rhs)) {
@@ -221,6 +237,21 @@ enumerateMatmulTileX86_64(TypeRange elementTypes,
       // the arithmetic will have to expand f16 to f32 in registers. We may
       // reconsider when taking advantage of native f16/bf16 arithmetic when the
       // accumulator itself is f16/bf16.
+      if (lhs.isF16() && rhs.isF16() && out.isF16() &&
+          hasFeature(target, "+avx512fp16")) {
+        return {
+            TileMxNxK{16, 32, 1}, // Aim to use VFMADD*PH (zmm).
+            TileMxNxK{8, 32, 1},  // Truncation of the above.
+            TileMxNxK{4, 32, 1},  // Truncation of the above.
+            TileMxNxK{2, 32, 1},  // Truncation of the above.
+            TileMxNxK{1, 32, 1},  // Truncation of the above.
+            TileMxNxK{16, 16, 1}, // Fallback when N is rounded to 16.
+            TileMxNxK{8, 16, 1},  // Truncation of the above.
+            TileMxNxK{4, 16, 1},  // Truncation of the above.
+            TileMxNxK{2, 16, 1},  // Truncation of the above.
+            TileMxNxK{1, 16, 1},  // Truncation of the above.
+        };
+      }
       if (hasFeature(target, "+avx512f")) {
         return {
             TileMxNxK{16, 16, 1}, // Aim to use VFMADD* (zmm).
@@ -255,6 +286,21 @@ enumerateMatmulTileX86_64(TypeRange elementTypes,
   if (out.isSignlessInteger(32) &&
       ((lhs.isSignlessInteger(8) && rhs.isSignlessInteger(8)) ||
        (lhs.isSignlessInteger(16) && rhs.isSignlessInteger(16)))) {
+    if (lhs.isSignlessInteger(8) && useAMX &&
+        hasFeature(target, "+amx-int8") && hasFeature(target, "+avx512bw")) {
+      return {
+          TileMxNxK{16, 16, 32}, // Aim to use TDPBSSD.
+          TileMxNxK{8, 16, 32},  // Truncation of the above.
+          TileMxNxK{4, 16, 32},  // Truncation of the above.
+          TileMxNxK{2, 16, 32},  // Truncation of the above.
+          TileMxNxK{1, 16, 32},  // Truncation of the above.
+          TileMxNxK{16, 16, 2},  // Fallback to VPDPWSSD/VPMADDWD (zmm).
+          TileMxNxK{8, 16, 2},   // Truncation of the above.
+          TileMxNxK{4, 16, 2},   // Truncation of the above.
+          TileMxNxK{2, 16, 2},   // Truncation of the above.
+          TileMxNxK{1, 16, 2},   // Truncation of the above.
+      };
+    }
     if (hasFeature(target, "+avx512vnni")) {
       // This is the same tile size as with VPMADDWD as the only difference
       // is that VPDPWSSD accumulates. VPDPBUSD would call for {16, 16, 4} but
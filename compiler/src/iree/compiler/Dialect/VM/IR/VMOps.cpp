@@ -1534,6 +1534,51 @@ SuccessorOperands CondBreakOp::getSuccessorOperands(unsigned index) {
   return SuccessorOperands(getDestOperandsMutable());
 }
 
+//===----------------------------------------------------------------------===//
+// Fused ops
+//===----------------------------------------------------------------------===//
+
+template <typename OpT>
+static SuccessorOperands getCondBranchCmpSuccessorOperands(OpT op,
+                                                           unsigned index) {
+  assert(index < op->getNumSuccessors() && "invalid successor index");
+  return index == OpT::trueIndex
+             ? SuccessorOperands(op.getTrueDestOperandsMutable())
+             : SuccessorOperands(op.getFalseDestOperandsMutable());
+}
+
+SuccessorOperands CondBranchCmpEQI32Op::getSuccessorOperands(unsigned index) {
+  return getCondBranchCmpSuccessorOperands(*this, index);
+}
+
+SuccessorOperands CondBranchCmpNEI32Op::getSuccessorOperands(unsigned index) {
+  return getCondBranchCmpSuccessorOperands(*this, index);
+}
+
+SuccessorOperands CondBranchCmpLTI32SOp::getSuccessorOperands(unsigned index) {
+  return getCondBranchCmpSuccessorOperands(*this, index);
+}
+
+SuccessorOperands CondBranchCmpLTI32UOp::getSuccessorOperands(unsigned index) {
+  return getCondBranchCmpSuccessorOperands(*this, index);
+}
+
+SuccessorOperands CondBranchCmpEQI64Op::getSuccessorOperands(unsigned index) {
+  return getCondBranchCmpSuccessorOperands(*this, index);
+}
+
+SuccessorOperands CondBranchCmpNEI64Op::getSuccessorOperands(unsigned index) {
+  return getCondBranchCmpSuccessorOperands(*this, index);
+}
+
+SuccessorOperands CondBranchCmpLTI64SOp::getSuccessorOperands(unsigned index) {
+  return getCondBranchCmpSuccessorOperands(*this, index);
+}
+
+SuccessorOperands CondBranchCmpLTI64UOp::getSuccessorOperands(unsigned index) {
+  return getCondBranchCmpSuccessorOperands(*this, index);
+}
+
 } // namespace mlir::iree_compiler::IREE::VM
 
 //===----------------------------------------------------------------------===//
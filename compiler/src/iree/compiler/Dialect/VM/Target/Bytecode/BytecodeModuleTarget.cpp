@@ -179,6 +179,10 @@ canonicalizeModule(IREE::VM::BytecodeTargetOptions bytecodeOptions,
 
   modulePasses.addPass(IREE::Util::createDropCompilerHintsPass());
 
+  if (bytecodeOptions.fuseSuperinstructions) {
+    modulePasses.addPass(IREE::VM::createFuseSuperinstructionsPass());
+  }
+
   // Mark up the module with ordinals for each top-level op (func, etc).
   // This will make it easier to correlate the MLIR textual output to the
   // binary output.
@@ -732,6 +736,11 @@ void BytecodeTargetOptions::bindOptions(OptionsBinder &binder) {
       llvm::cl::cat(vmBytecodeOptionsCategory),
       llvm::cl::desc("Optimizes the VM module with CSE/inlining/etc prior to "
                      "serialization"));
+  binder.opt<bool>(
+      "iree-vm-bytecode-module-fuse-superinstructions", fuseSuperinstructions,
+      llvm::cl::cat(vmBytecodeOptionsCategory),
+      llvm::cl::desc("Fuses common op sequences into bytecode "
+                     "superinstructions prior to serialization"));
   binder.opt<std::string>(
       "iree-vm-bytecode-source-listing", sourceListing,
       llvm::cl::cat(vmBytecodeOptionsCategory),
@@ -38,6 +38,10 @@ struct BytecodeTargetOptions {
   // Run basic CSE/inlining/etc passes prior to serialization.
   bool optimize = true;
 
+  // Fuse common op sequences into superinstructions dispatched as a single op
+  // by the bytecode interpreter.
+  bool fuseSuperinstructions = true;
+
   // Dump a VM MLIR file and annotate source locations with it.
   // This allows for the runtime to serve stack traces referencing both the
   // original source locations and the VM IR.
@@ -0,0 +1,231 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/VM/IR/VMOps.h"
+#include "iree/compiler/Dialect/VM/Transforms/Passes.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassRegistry.h"
+#include "mlir/Support/LLVM.h"
+
+namespace mlir::iree_compiler::IREE::VM {
+
+// Returns true if no op between |first| and |last| (exclusive) in the same
+// block has memory effects.
+static bool isMemoryEffectFreeBetween(Operation *first, Operation *last) {
+  for (auto *op = first->getNextNode(); op && op != last;
+       op = op->getNextNode()) {
+    if (!isMemoryEffectFree(op))
+      return false;
+  }
+  return true;
+}
+
+// Returns true if |value| is available at the point of |op|: it is either a
+// block argument, defined in another block dominating the use, or defined by
+// an op preceding |op| in the same block.
+static bool isDefinedBefore(Value value, Operation *op) {
+  auto *definingOp = value.getDefiningOp();
+  if (!definingOp || definingOp->getBlock() != op->getBlock())
+    return true;
+  return definingOp->isBeforeInBlock(op);
+}
+
+// Returns the comparison op defining the condition of |condBranchOp| if it
+// can be folded into the branch.
+static Operation *getFusableCmpOp(CondBranchOp condBranchOp) {
+  Value condition = condBranchOp.getCondition();
+  auto *cmpOp = condition.getDefiningOp();
+  if (!cmpOp || cmpOp->getBlock() != condBranchOp->getBlock() ||
+      !condition.hasOneUse()) {
+    return nullptr;
+  }
+  return cmpOp;
+}
+
+template <typename FusedOpT>
+static void replaceCondBranchWithFused(CondBranchOp condBranchOp,
+                                       Operation *cmpOp) {
+  OpBuilder builder(condBranchOp);
+  builder.create<FusedOpT>(
+      builder.getFusedLoc({cmpOp->getLoc(), condBranchOp.getLoc()}),
+      cmpOp->getOperand(0), cmpOp->getOperand(1),
+      condBranchOp.getTrueDestOperands(), condBranchOp.getFalseDestOperands(),
+      condBranchOp.getTrueDest(), condBranchOp.getFalseDest());
+  condBranchOp.erase();
+  cmpOp->erase();
+}
+
+// Fuses vm.cmp.* + vm.cond_br into vm.cond_br.cmp.*.
+static bool fuseCondBranchCmp(CondBranchOp condBranchOp) {
+  auto *cmpOp = getFusableCmpOp(condBranchOp);
+  if (!cmpOp)
+    return false;
+  return TypeSwitch<Operation *, bool>(cmpOp)
+      .Case([&](CmpEQI32Op) {
+        replaceCondBranchWithFused<CondBranchCmpEQI32Op>(condBranchOp, cmpOp);
+        return true;
+      })
+      .Case([&](CmpNEI32Op) {
+        replaceCondBranchWithFused<CondBranchCmpNEI32Op>(condBranchOp, cmpOp);
+        return true;
+      })
+      .Case([&](CmpLTI32SOp) {
+        replaceCondBranchWithFused<CondBranchCmpLTI32SOp>(condBranchOp, cmpOp);
+        return true;
+      })
+      .Case([&](CmpLTI32UOp) {
+        replaceCondBranchWithFused<CondBranchCmpLTI32UOp>(condBranchOp, cmpOp);
+        return true;
+      })
+      .Case([&](CmpEQI64Op) {
+        replaceCondBranchWithFused<CondBranchCmpEQI64Op>(condBranchOp, cmpOp);
+        return true;
+      })
+      .Case([&](CmpNEI64Op) {
+        replaceCondBranchWithFused<CondBranchCmpNEI64Op>(condBranchOp, cmpOp);
+        return true;
+      })
+      .Case([&](CmpLTI64SOp) {
+        replaceCondBranchWithFused<CondBranchCmpLTI64SOp>(condBranchOp, cmpOp);
+        return true;
+      })
+      .Case([&](CmpLTI64UOp) {
+        replaceCondBranchWithFused<CondBranchCmpLTI64UOp>(condBranchOp, cmpOp);
+        return true;
+      })
+      .Default([](Operation *) { return false; });
+}
+
+// Fuses a vm.add.* + vm.cmp.* where the sum is compared into vm.add.cmp.*.
+// The fused op is placed at the add so that all existing uses of the sum
+// remain dominated.
+template <typename AddOpT, typename FusedOpT>
+static bool fuseAddCmp(Operation *cmpOp, bool isCommutative) {
+  Value lhs = cmpOp->getOperand(0);
+  Value rhs = cmpOp->getOperand(1);
+  auto addOp = lhs.getDefiningOp<AddOpT>();
+  if (isCommutative && (!addOp || addOp->getBlock() != cmpOp->getBlock())) {
+    addOp = rhs.getDefiningOp<AddOpT>();
+    std::swap(lhs, rhs);
+  }
+  if (!addOp || addOp->getBlock() != cmpOp->getBlock() ||
+      !isDefinedBefore(rhs, addOp)) {
+    return false;
+  }
+  OpBuilder builder(addOp);
+  auto fusedOp = builder.create<FusedOpT>(
+      builder.getFusedLoc({addOp.getLoc(), cmpOp->getLoc()}),
+      addOp.getType(), cmpOp->getResult(0).getType(), addOp.getLhs(),
+      addOp.getRhs(), rhs);
+  addOp.getResult().replaceAllUsesWith(fusedOp.getSum());
+  cmpOp->getResult(0).replaceAllUsesWith(fusedOp.getResult());
+  cmpOp->erase();
+  addOp.erase();
+  return true;
+}
+
+static bool fuseAddCmp(Operation *cmpOp) {
+  return TypeSwitch<Operation *, bool>(cmpOp)
+      .Case([&](CmpEQI32Op) {
+        return fuseAddCmp<AddI32Op, AddCmpEQI32Op>(cmpOp,
+                                                   /*isCommutative=*/true);
+      })
+      .Case([&](CmpNEI32Op) {
+        return fuseAddCmp<AddI32Op, AddCmpNEI32Op>(cmpOp,
+                                                   /*isCommutative=*/true);
+      })
+      .Case([&](CmpLTI32SOp) {
+        return fuseAddCmp<AddI32Op, AddCmpLTI32SOp>(cmpOp,
+                                                    /*isCommutative=*/false);
+      })
+      .Case([&](CmpLTI32UOp) {
+        return fuseAddCmp<AddI32Op, AddCmpLTI32UOp>(cmpOp,
+                                                    /*isCommutative=*/false);
+      })
+      .Case([&](CmpEQI64Op) {
+        return fuseAddCmp<AddI64Op, AddCmpEQI64Op>(cmpOp,
+                                                   /*isCommutative=*/true);
+      })
+      .Case([&](CmpNEI64Op) {
+        return fuseAddCmp<AddI64Op, AddCmpNEI64Op>(cmpOp,
+                                                   /*isCommutative=*/true);
+      })
+      .Case([&](CmpLTI64SOp) {
+        return fuseAddCmp<AddI64Op, AddCmpLTI64SOp>(cmpOp,
+                                                    /*isCommutative=*/false);
+      })
+      .Case([&](CmpLTI64UOp) {
+        return fuseAddCmp<AddI64Op, AddCmpLTI64UOp>(cmpOp,
+                                                    /*isCommutative=*/false);
+      })
+      .Default([](Operation *) { return false; });
+}
+
+// Fuses a vm.list.get.ref of !vm.ref<?> + vm.cast.any.ref into
+// vm.list.get.ref.cast. The fused op is placed at the cast so that it observes
+// the same list contents and raises type errors at the same point.
+static bool fuseListGetRefCast(CastAnyRefOp castOp) {
+  auto getOp = castOp.getOperand().getDefiningOp<ListGetRefOp>();
+  if (!getOp || getOp->getBlock() != castOp->getBlock() ||
+      !getOp.getResult().hasOneUse() ||
+      !isMemoryEffectFreeBetween(getOp, castOp)) {
+    return false;
+  }
+  OpBuilder builder(castOp);
+  auto fusedOp = builder.create<ListGetRefCastOp>(
+      builder.getFusedLoc({getOp.getLoc(), castOp.getLoc()}),
+      castOp.getResult().getType(), getOp.getList(), getOp.getIndex());
+  castOp.getResult().replaceAllUsesWith(fusedOp.getResult());
+  castOp.erase();
+  getOp.erase();
+  return true;
+}
+
+class FuseSuperinstructionsPass
+    : public PassWrapper<FuseSuperinstructionsPass, OperationPass<ModuleOp>> {
+public:
+  StringRef getArgument() const override {
+    return "iree-vm-fuse-superinstructions";
+  }
+
+  StringRef getDescription() const override {
+    return "Fuses common op sequences into bytecode superinstructions.";
+  }
+
+  void runOnOperation() override {
+    for (auto funcOp : getOperation().getOps<FuncOp>()) {
+      for (auto &block : funcOp.getBlocks()) {
+        // Branches first as they consume the most common comparison use.
+        if (auto condBranchOp = dyn_cast<CondBranchOp>(block.getTerminator())) {
+          fuseCondBranchCmp(condBranchOp);
+        }
+
+        // Remaining comparisons (selects, multiple uses, etc) and casts.
+        // Fusion only erases the current op and ops preceding it.
+        for (auto &op : llvm::make_early_inc_range(block)) {
+          if (auto castOp = dyn_cast<CastAnyRefOp>(op)) {
+            fuseListGetRefCast(castOp);
+          } else if (op.getNumOperands() == 2 && op.getNumResults() == 1) {
+            fuseAddCmp(&op);
+          }
+        }
+      }
+    }
+  }
+};
+
+std::unique_ptr<OperationPass<ModuleOp>> createFuseSuperinstructionsPass() {
+  return std::make_unique<FuseSuperinstructionsPass>();
+}
+
+static PassRegistration<FuseSuperinstructionsPass> pass;
+
+} // namespace mlir::iree_compiler::IREE::VM
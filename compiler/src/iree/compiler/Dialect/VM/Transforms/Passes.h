@@ -93,6 +93,12 @@ std::unique_ptr<OperationPass<IREE::VM::ModuleOp>> createDropUnusedCallsPass();
 // number of live registers at the cost of additional storage requirements.
 std::unique_ptr<OperationPass<IREE::VM::ModuleOp>> createSinkDefiningOpsPass();
 
+// Fuses common op sequences (compare and branch, add and compare, etc) into
+// superinstructions that the bytecode interpreter dispatches as a single op.
+// Only valid when targeting bytecode.
+std::unique_ptr<OperationPass<IREE::VM::ModuleOp>>
+createFuseSuperinstructionsPass();
+
 //===----------------------------------------------------------------------===//
 // Register all Passes
 //===----------------------------------------------------------------------===//
@@ -105,6 +111,7 @@ inline void registerVMPasses() {
   createDeduplicateRodataPass();
   createDropEmptyModuleInitializersPass();
   createDropUnusedCallsPass();
+  createFuseSuperinstructionsPass();
   createGlobalInitializationPass();
   createOrdinalAllocationPass();
   createResolveRodataLoadsPass();
@@ -0,0 +1,137 @@
+// RUN: iree-opt --split-input-file --iree-vm-fuse-superinstructions %s | FileCheck %s
+
+vm.module @module {
+  // CHECK-LABEL: @cmp_cond_br
+  vm.func @cmp_cond_br(%arg0 : i32, %arg1 : i32) -> i32 {
+    %c1 = vm.const.i32 1
+    // CHECK-NOT: vm.cmp.lt.i32.s
+    %slt = vm.cmp.lt.i32.s %arg0, %arg1 : i32
+    // CHECK: vm.cond_br.cmp.lt.i32.s %arg0, %arg1, ^bb1(%c1 : i32), ^bb1(%arg0 : i32) : i32
+    vm.cond_br %slt, ^bb1(%c1 : i32), ^bb1(%arg0 : i32)
+  ^bb1(%0 : i32):
+    vm.return %0 : i32
+  }
+}
+
+// -----
+
+vm.module @module {
+  // CHECK-LABEL: @cmp_cond_br_i64
+  vm.func @cmp_cond_br_i64(%arg0 : i64, %arg1 : i64) -> i32 {
+    %c0 = vm.const.i32 0
+    %c1 = vm.const.i32 1
+    // CHECK-NOT: vm.cmp.ne.i64
+    %ne = vm.cmp.ne.i64 %arg0, %arg1 : i64
+    // CHECK: vm.cond_br.cmp.ne.i64 %arg0, %arg1, ^bb1, ^bb2 : i64
+    vm.cond_br %ne, ^bb1, ^bb2
+  ^bb1:
+    vm.return %c1 : i32
+  ^bb2:
+    vm.return %c0 : i32
+  }
+}
+
+// -----
+
+vm.module @module {
+  // CHECK-LABEL: @cmp_multiple_uses
+  vm.func @cmp_multiple_uses(%arg0 : i32, %arg1 : i32) -> i32 {
+    // CHECK: %[[EQ:.+]] = vm.cmp.eq.i32 %arg0, %arg1 : i32
+    %eq = vm.cmp.eq.i32 %arg0, %arg1 : i32
+    // CHECK: vm.cond_br %[[EQ]], ^bb1(%[[EQ]] : i32), ^bb2
+    vm.cond_br %eq, ^bb1(%eq : i32), ^bb2
+  ^bb1(%0 : i32):
+    vm.return %0 : i32
+  ^bb2:
+    vm.return %arg0 : i32
+  }
+}
+
+// -----
+
+vm.module @module {
+  // CHECK-LABEL: @add_cmp
+  vm.func @add_cmp(%arg0 : i64, %arg1 : i64, %arg2 : i64) -> (i64, i32) {
+    // CHECK: %[[FUSED:.+]]:2 = vm.add.cmp.lt.i64.s %arg0, %arg1, %arg2 : i64
+    // CHECK-NOT: vm.add.i64
+    // CHECK-NOT: vm.cmp.lt.i64.s
+    %0 = vm.add.i64 %arg0, %arg1 : i64
+    %slt = vm.cmp.lt.i64.s %0, %arg2 : i64
+    // CHECK: vm.return %[[FUSED]]#0, %[[FUSED]]#1 : i64, i32
+    vm.return %0, %slt : i64, i32
+  }
+}
+
+// -----
+
+vm.module @module {
+  // CHECK-LABEL: @add_cmp_commutative
+  vm.func @add_cmp_commutative(%arg0 : i32, %arg1 : i32, %arg2 : i32) -> i32 {
+    // CHECK: %[[FUSED:.+]]:2 = vm.add.cmp.eq.i32 %arg0, %arg1, %arg2 : i32
+    %0 = vm.add.i32 %arg0, %arg1 : i32
+    %eq = vm.cmp.eq.i32 %arg2, %0 : i32
+    // CHECK: vm.return %[[FUSED]]#1 : i32
+    vm.return %eq : i32
+  }
+}
+
+// -----
+
+vm.module @module {
+  // CHECK-LABEL: @add_cmp_bound_defined_after
+  vm.func @add_cmp_bound_defined_after(%arg0 : i32, %arg1 : i32) -> i32 {
+    // CHECK: vm.add.i32
+    %0 = vm.add.i32 %arg0, %arg1 : i32
+    %c10 = vm.const.i32 10
+    // CHECK: vm.cmp.lt.i32.u
+    %ult = vm.cmp.lt.i32.u %0, %c10 : i32
+    vm.return %ult : i32
+  }
+}
+
+// -----
+
+vm.module @module {
+  // CHECK-LABEL: @add_cmp_cond_br
+  vm.func @add_cmp_cond_br(%arg0 : i64, %arg1 : i64) -> i64 {
+    %c1 = vm.const.i64 1
+    // CHECK: %[[NEXT:.+]] = vm.add.i64 %arg0, %c1 : i64
+    %next = vm.add.i64 %arg0, %c1 : i64
+    %slt = vm.cmp.lt.i64.s %next, %arg1 : i64
+    // CHECK: vm.cond_br.cmp.lt.i64.s %[[NEXT]], %arg1, ^bb1, ^bb2 : i64
+    vm.cond_br %slt, ^bb1, ^bb2
+  ^bb1:
+    vm.return %next : i64
+  ^bb2:
+    vm.return %arg1 : i64
+  }
+}
+
+// -----
+
+vm.module @module {
+  // CHECK-LABEL: @list_get_ref_cast
+  vm.func @list_get_ref_cast(%list : !vm.list<?>, %index : i32) -> !vm.buffer {
+    // CHECK: %[[BUFFER:.+]] = vm.list.get.ref.cast %arg0, %arg1 : (!vm.list<?>, i32) -> !vm.buffer
+    // CHECK-NOT: vm.cast.any.ref
+    %ref = vm.list.get.ref %list, %index : (!vm.list<?>, i32) -> !vm.ref<?>
+    %buffer = vm.cast.any.ref %ref : !vm.ref<?> -> !vm.buffer
+    // CHECK: vm.return %[[BUFFER]]
+    vm.return %buffer : !vm.buffer
+  }
+}
+
+// -----
+
+vm.module @module {
+  // CHECK-LABEL: @list_get_ref_cast_side_effects
+  vm.func @list_get_ref_cast_side_effects(%list : !vm.list<?>,
+                                           %index : i32) -> !vm.buffer {
+    // CHECK: vm.list.get.ref %arg0, %arg1
+    %ref = vm.list.get.ref %list, %index : (!vm.list<?>, i32) -> !vm.ref<?>
+    vm.list.set.ref %list, %index, %list : (!vm.list<?>, i32, !vm.list<?>)
+    // CHECK: vm.cast.any.ref
+    %buffer = vm.cast.any.ref %ref : !vm.ref<?> -> !vm.buffer
+    vm.return %buffer : !vm.buffer
+  }
+}
@@ -26,7 +26,8 @@ iree_status_t create_device_with_loaders(iree_allocator_t host_allocator,
   iree_host_size_t loader_count = 0;
   if (iree_status_is_ok(status)) {
     status = iree_hal_system_library_loader_create(
-        plugin_manager, host_allocator, &loaders[loader_count++]);
+        plugin_manager, /*disk_cache=*/NULL, host_allocator,
+        &loaders[loader_count++]);
   }
   if (iree_status_is_ok(status)) {
     status = iree_hal_vmvx_module_loader_create_isolated(
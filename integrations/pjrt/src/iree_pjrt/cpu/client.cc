@@ -41,8 +41,8 @@ iree_status_t CPUClientInstance::InitializeDeps() {
 
   // loaders_
   IREE_RETURN_IF_ERROR(iree_hal_create_all_available_executable_loaders(
-      plugin_manager_, IREE_ARRAYSIZE(loaders_), &loader_count_, loaders_,
-      host_allocator_));
+      plugin_manager_, /*disk_cache=*/nullptr, IREE_ARRAYSIZE(loaders_),
+      &loader_count_, loaders_, host_allocator_));
 
   // device_allocator_
   IREE_RETURN_IF_ERROR(iree_hal_allocator_create_heap(
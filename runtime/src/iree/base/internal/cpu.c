@@ -248,6 +248,31 @@ static iree_cpuid_regs_t iree_cpuid_or_zero(uint32_t eax, uint32_t ecx,
   return iree_cpuid_raw(eax, ecx);
 }
 
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// NOTE: not all kernel headers have these defined so we define them locally.
+// https://docs.kernel.org/arch/x86/xstate.html
+#define IREE_ARCH_REQ_XCOMP_PERM 0x1023
+#define IREE_XFEATURE_XTILEDATA 18
+
+// Linux enables the AMX tile data state on demand and raises SIGILL on the
+// first AMX instruction of processes that have not requested permission to use
+// it. Permission is per-process and requesting it more than once is harmless.
+// Returns false if the kernel does not allow the use of AMX.
+static bool iree_cpu_request_amx_permission(void) {
+  return syscall(SYS_arch_prctl, IREE_ARCH_REQ_XCOMP_PERM,
+                 IREE_XFEATURE_XTILEDATA) == 0;
+}
+
+#else
+
+static bool iree_cpu_request_amx_permission(void) { return true; }
+
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX
+
 static void iree_cpu_initialize_from_platform_x86_64(uint64_t* out_fields) {
   iree_cpuid_bounds_t bounds = iree_cpuid_query_bounds();
   iree_cpuid_regs_t leaf1 = iree_cpuid_or_zero(1, 0, bounds);
@@ -301,7 +326,9 @@ static void iree_cpu_initialize_from_platform_x86_64(uint64_t* out_fields) {
   }
 
   // Features that depend on AMX TILE state being enabled by the OS.
-  if (iree_all_bits_set(leafD.eax, 0x60000)) {
+  if (iree_all_bits_set(leafD.eax, 0x60000) &&
+      iree_all_bits_set(leaf7_0.edx, 1 << 24) &&
+      iree_cpu_request_amx_permission()) {
     IREE_COPY_BITS(out0, IREE_CPU_DATA0_X86_64_AMXTILE, leaf7_0.edx, 1 << 24);
     IREE_COPY_BITS(out0, IREE_CPU_DATA0_X86_64_AMXINT8, leaf7_0.edx, 1 << 25);
     IREE_COPY_BITS(out0, IREE_CPU_DATA0_X86_64_AMXBF16, leaf7_0.edx, 1 << 22);
@@ -318,12 +345,35 @@ static void iree_cpu_initialize_from_platform_x86_64(uint64_t* out_fields) {
 // expose the features that we need, we can just rely on the basic HWCAP way.
 #include <sys/auxv.h>
 
+#include <sys/syscall.h>
+#include <unistd.h>
+
 #define IREE_HWCAP_ISA_V (1 << ('V' - 'A'))
 
+// Vector sub-extensions such as Zvfh are not in HWCAP and are only exposed by
+// the riscv_hwprobe syscall (Linux 6.4+). Constants from <asm/hwprobe.h>,
+// which older kernel headers lack.
+#define IREE_RISCV_HWPROBE_KEY_IMA_EXT_0 4
+#define IREE_RISCV_HWPROBE_EXT_ZVFH (1ull << 30)
+
+typedef struct iree_riscv_hwprobe_pair_t {
+  int64_t key;
+  uint64_t value;
+} iree_riscv_hwprobe_pair_t;
+
 static void iree_cpu_initialize_from_platform_riscv_64(uint64_t* out_fields) {
   unsigned long hwcap = getauxval(AT_HWCAP);
   IREE_COPY_BITS(out_fields[0], IREE_CPU_DATA0_RISCV_64_RVV, hwcap,
                  IREE_HWCAP_ISA_V);
+#if defined(__NR_riscv_hwprobe)
+  iree_riscv_hwprobe_pair_t pair = {IREE_RISCV_HWPROBE_KEY_IMA_EXT_0, 0};
+  // Fails with ENOSYS on kernels predating hwprobe, leaving the bits clear.
+  if (syscall(__NR_riscv_hwprobe, &pair, 1, 0, NULL, 0) == 0 &&
+      pair.key == IREE_RISCV_HWPROBE_KEY_IMA_EXT_0) {
+    IREE_COPY_BITS(out_fields[0], IREE_CPU_DATA0_RISCV_64_ZVFH, pair.value,
+                   IREE_RISCV_HWPROBE_EXT_ZVFH);
+  }
+#endif  // defined(__NR_riscv_hwprobe)
 }
 
 #else
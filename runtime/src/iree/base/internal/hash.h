@@ -0,0 +1,142 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//==============================================================================
+//
+// Content hashing
+//
+// iree_hash_murmur3_*: **NOT CRYPTOGRAPHICALLY SECURE**
+// Only use these to key caches of trusted contents. Anyone able to choose the
+// hashed data can produce collisions.
+//
+// iree_hash_sha256_*: collision resistant and suitable for keying caches whose
+// entries grant trust to the hashed contents (such as skipping verification).
+//
+//==============================================================================
+
+#ifndef IREE_BASE_INTERNAL_HASH_H_
+#define IREE_BASE_INTERNAL_HASH_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+static inline uint64_t iree_hash_murmur3_fmix64(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xFF51AFD7ED558CCDull;
+  k ^= k >> 33;
+  k *= 0xC4CEB9FE1A85EC53ull;
+  k ^= k >> 33;
+  return k;
+}
+
+static inline uint64_t iree_hash_murmur3_load64(const uint8_t* ptr) {
+  uint64_t value = 0;
+  memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+// MurmurHash3 x64 128-bit: fast, well distributed, and stable across
+// platforms of the same endianness.
+// Hashes |data| into |hash| which is both the seed and result so that multiple
+// ranges can be chained into a single hash.
+static inline void iree_hash_murmur3_x64_128(iree_const_byte_span_t data,
+                                             uint64_t hash[2]) {
+  const uint64_t c1 = 0x87C37B91114253D5ull;
+  const uint64_t c2 = 0x4CF5AD432745937Full;
+  uint64_t h1 = hash[0];
+  uint64_t h2 = hash[1];
+
+  const uint8_t* ptr = data.data;
+  const iree_host_size_t block_count = data.data_length / 16;
+  for (iree_host_size_t i = 0; i < block_count; ++i, ptr += 16) {
+    uint64_t k1 = iree_hash_murmur3_load64(ptr);
+    uint64_t k2 = iree_hash_murmur3_load64(ptr + 8);
+    k1 *= c1;
+    k1 = iree_math_rotl_u64(k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+    h1 = iree_math_rotl_u64(h1, 27);
+    h1 += h2;
+    h1 = h1 * 5 + 0x52DCE729;
+    k2 *= c2;
+    k2 = iree_math_rotl_u64(k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
+    h2 = iree_math_rotl_u64(h2, 31);
+    h2 += h1;
+    h2 = h2 * 5 + 0x38495AB5;
+  }
+
+  // Tail bytes are zero-padded into a final block.
+  const iree_host_size_t tail_length = data.data_length & 15;
+  if (tail_length) {
+    uint8_t tail[16] = {0};
+    memcpy(tail, ptr, tail_length);
+    uint64_t k1 = iree_hash_murmur3_load64(tail);
+    uint64_t k2 = iree_hash_murmur3_load64(tail + 8);
+    k2 *= c2;
+    k2 = iree_math_rotl_u64(k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
+    k1 *= c1;
+    k1 = iree_math_rotl_u64(k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+  }
+
+  h1 ^= (uint64_t)data.data_length;
+  h2 ^= (uint64_t)data.data_length;
+  h1 += h2;
+  h2 += h1;
+  h1 = iree_hash_murmur3_fmix64(h1);
+  h2 = iree_hash_murmur3_fmix64(h2);
+  h1 += h2;
+  h2 += h1;
+  hash[0] = h1;
+  hash[1] = h2;
+}
+
+//===----------------------------------------------------------------------===//
+// SHA-256
+//===----------------------------------------------------------------------===//
+
+// Size, in bytes, of a SHA-256 digest.
+#define IREE_HASH_SHA256_DIGEST_SIZE 32
+
+// Incremental SHA-256 (FIPS 180-4) hashing state.
+typedef struct iree_hash_sha256_t {
+  uint32_t state[8];
+  // Total number of bytes hashed so far.
+  uint64_t length;
+  // Partial block pending compression; |length| % 64 bytes are valid.
+  uint8_t block[64];
+} iree_hash_sha256_t;
+
+// Initializes |hasher| to begin hashing a new message.
+void iree_hash_sha256_initialize(iree_hash_sha256_t* hasher);
+
+// Appends |data| to the message being hashed.
+void iree_hash_sha256_update(iree_hash_sha256_t* hasher,
+                             iree_const_byte_span_t data);
+
+// Finishes hashing and writes the digest of the message to |out_digest|.
+// |hasher| must be reinitialized before it is reused.
+void iree_hash_sha256_finalize(
+    iree_hash_sha256_t* hasher,
+    uint8_t out_digest[IREE_HASH_SHA256_DIGEST_SIZE]);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_BASE_INTERNAL_HASH_H_
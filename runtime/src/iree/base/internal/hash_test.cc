@@ -0,0 +1,96 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "iree/testing/gtest.h"
+
+namespace {
+
+static void HashString(const char* value, uint64_t hash[2]) {
+  iree_hash_murmur3_x64_128(iree_make_const_byte_span(value, strlen(value)),
+                            hash);
+}
+
+// Reference values from the canonical MurmurHash3_x64_128 with seed 0.
+TEST(HashTest, Murmur3ReferenceValues) {
+  uint64_t hash[2] = {0, 0};
+  HashString("", hash);
+  EXPECT_EQ(hash[0], 0ull);
+  EXPECT_EQ(hash[1], 0ull);
+
+  hash[0] = hash[1] = 0;
+  HashString("hello", hash);
+  EXPECT_EQ(hash[0], 0xCBD8A7B341BD9B02ull);
+  EXPECT_EQ(hash[1], 0x5B1E906A48AE1D19ull);
+
+  // Full block plus a tail.
+  hash[0] = hash[1] = 0;
+  HashString("0123456789abcdefXYZ", hash);
+  EXPECT_EQ(hash[0], 0x99D375026C4A901Dull);
+  EXPECT_EQ(hash[1], 0x4E69E256EAF89CF3ull);
+}
+
+// Chained hashes depend on the seed carried from prior ranges.
+TEST(HashTest, Murmur3Chaining) {
+  uint64_t a[2] = {0, 0};
+  HashString("abc", a);
+  HashString("def", a);
+  uint64_t b[2] = {0, 0};
+  HashString("def", b);
+  HashString("abc", b);
+  EXPECT_FALSE(a[0] == b[0] && a[1] == b[1]);
+}
+
+static std::string Sha256String(const std::string& value,
+                                iree_host_size_t chunk_size) {
+  iree_hash_sha256_t hasher;
+  iree_hash_sha256_initialize(&hasher);
+  for (iree_host_size_t i = 0; i < value.size(); i += chunk_size) {
+    iree_host_size_t length = std::min(chunk_size, value.size() - i);
+    iree_hash_sha256_update(
+        &hasher, iree_make_const_byte_span(value.data() + i, length));
+  }
+  uint8_t digest[IREE_HASH_SHA256_DIGEST_SIZE];
+  iree_hash_sha256_finalize(&hasher, digest);
+  static const char kHexDigits[] = "0123456789abcdef";
+  std::string result;
+  for (uint8_t byte : digest) {
+    result.push_back(kHexDigits[byte >> 4]);
+    result.push_back(kHexDigits[byte & 0xF]);
+  }
+  return result;
+}
+
+// Reference values from FIPS 180-4 examples.
+TEST(HashTest, Sha256ReferenceValues) {
+  EXPECT_EQ(Sha256String("", 64),
+            "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+  EXPECT_EQ(Sha256String("abc", 64),
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+  // Padding spills into a second block.
+  EXPECT_EQ(
+      Sha256String("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+                   64),
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+}
+
+// Incremental updates of any size produce the same digest.
+TEST(HashTest, Sha256Chunked) {
+  std::string value(1000000, 'a');
+  static const char kExpected[] =
+      "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0";
+  EXPECT_EQ(Sha256String(value, value.size()), kExpected);
+  EXPECT_EQ(Sha256String(value, 1), kExpected);
+  EXPECT_EQ(Sha256String(value, 63), kExpected);
+  EXPECT_EQ(Sha256String(value, 65), kExpected);
+}
+
+}  // namespace
@@ -760,12 +760,15 @@ void iree_notification_post(iree_notification_t* notification, int32_t count) {
   }
 }
 
+// NOTE: waiters are only counted once they are about to enter the futex wait.
+// Threads that have prepared a wait and are still checking their condition or
+// spinning in iree_notification_commit_wait don't need a futex wake to notice
+// the epoch change and counting them would make every post to them a syscall.
 iree_wait_token_t iree_notification_prepare_wait(
     iree_notification_t* notification) {
-  uint64_t previous_value =
-      iree_atomic_fetch_add(&notification->value, IREE_NOTIFICATION_WAITER_INC,
-                            iree_memory_order_acq_rel);
-  return (iree_wait_token_t)(previous_value >> IREE_NOTIFICATION_EPOCH_SHIFT);
+  uint64_t value =
+      iree_atomic_load(&notification->value, iree_memory_order_acquire);
+  return (iree_wait_token_t)(value >> IREE_NOTIFICATION_EPOCH_SHIFT);
 }
 
 typedef enum iree_notification_result_e {
@@ -810,7 +813,19 @@ bool iree_notification_commit_wait(iree_notification_t* notification,
   // If spinning failed let the kernel do what it does ... okish at.
   // We loop until notified and the epoch increments from what we captured
   // during iree_notification_prepare_wait.
-  if (deadline_ns != IREE_TIME_INFINITE_PAST) {
+  if (result == IREE_NOTIFICATION_RESULT_UNRESOLVED &&
+      deadline_ns != IREE_TIME_INFINITE_PAST) {
+    // Count ourselves as a waiter so that posters know to wake the futex. The
+    // epoch is checked again as part of the same operation: a post that
+    // happened before we were counted would not have woken us.
+    uint64_t previous_value =
+        iree_atomic_fetch_add(&notification->value,
+                              IREE_NOTIFICATION_WAITER_INC,
+                              iree_memory_order_acq_rel);
+    if ((iree_wait_token_t)(previous_value >> IREE_NOTIFICATION_EPOCH_SHIFT) !=
+        wait_token) {
+      result = IREE_NOTIFICATION_RESULT_RESOLVED;
+    }
     while (result == IREE_NOTIFICATION_RESULT_UNRESOLVED) {
       iree_status_code_t status_code =
           iree_futex_wait(iree_notification_epoch_address(notification),
@@ -821,27 +836,23 @@ bool iree_notification_commit_wait(iree_notification_t* notification,
       }
       result = iree_notification_test_wait_condition(notification, wait_token);
     }
-  }
 
-  // TODO(benvanik): benchmark under real workloads.
-  // iree_memory_order_relaxed would suffice for correctness but the faster
-  // the waiter count gets to 0 the less likely we'll wake on the futex.
-  uint64_t previous_value =
-      iree_atomic_fetch_add(&notification->value, IREE_NOTIFICATION_WAITER_DEC,
-                            iree_memory_order_acq_rel);
-  SYNC_ASSERT((previous_value & IREE_NOTIFICATION_WAITER_MASK) != 0);
+    // TODO(benvanik): benchmark under real workloads.
+    // iree_memory_order_relaxed would suffice for correctness but the faster
+    // the waiter count gets to 0 the less likely we'll wake on the futex.
+    previous_value =
+        iree_atomic_fetch_add(&notification->value,
+                              IREE_NOTIFICATION_WAITER_DEC,
+                              iree_memory_order_acq_rel);
+    SYNC_ASSERT((previous_value & IREE_NOTIFICATION_WAITER_MASK) != 0);
+  }
 
   return result == IREE_NOTIFICATION_RESULT_RESOLVED;
 }
 
 void iree_notification_cancel_wait(iree_notification_t* notification) {
-  // TODO(benvanik): benchmark under real workloads.
-  // iree_memory_order_relaxed would suffice for correctness but the faster
-  // the waiter count gets to 0 the less likely we'll wake on the futex.
-  uint64_t previous_value =
-      iree_atomic_fetch_add(&notification->value, IREE_NOTIFICATION_WAITER_DEC,
-                            iree_memory_order_acq_rel);
-  SYNC_ASSERT((previous_value & IREE_NOTIFICATION_WAITER_MASK) != 0);
+  // Waiters are only counted while in iree_notification_commit_wait so there
+  // is nothing to undo here.
 }
 
 #endif  // DISABLED / HAS_FUTEX
@@ -397,9 +397,9 @@ typedef uint32_t iree_wait_token_t;  // opaque
 // Prepares for a wait operation, returning a token that must be passed to
 // iree_notification_commit_wait to perform the actual wait.
 //
-// Acts as a memory_order_acq_rel read-modify-write operation on the
-// notification object. See the comment on iree_notification_commit_wait for a
-// general explanation of acquire/release semantics in this context.
+// Acts as (at least) a memory_order_acquire operation on the notification
+// object. See the comment on iree_notification_commit_wait for a general
+// explanation of acquire/release semantics in this context.
 iree_wait_token_t iree_notification_prepare_wait(
     iree_notification_t* notification);
 
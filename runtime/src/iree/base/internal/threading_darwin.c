@@ -160,7 +160,14 @@ static void iree_thread_delete(iree_thread_t* thread) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_thread_resume(thread);
-  pthread_join(thread->handle, NULL);
+
+  if (pthread_equal(thread->handle, pthread_self())) {
+    // Threads can delete themselves; they can't join with themselves without
+    // deadlocking so detach and let the system reclaim them on exit.
+    pthread_detach(thread->handle);
+  } else {
+    pthread_join(thread->handle, NULL);
+  }
 
   iree_allocator_free(thread->allocator, thread);
 
@@ -19,6 +19,9 @@
 #define IREE_UK_BUILD_ARM_64_BF16
 #define IREE_UK_BUILD_ARM_64_DOTPROD
 #define IREE_UK_BUILD_ARM_64_I8MM
+#define IREE_UK_BUILD_ARM_64_SVE
+#define IREE_UK_BUILD_ARM_64_SVE_BF16
+#define IREE_UK_BUILD_ARM_64_SVE_I8MM
 #else
 // Compiling with the system toolchain. Include the configured header.
 #include "iree/builtins/ukernel/arch/arm_64/config_arm_64.h"
@@ -52,6 +55,29 @@ static inline bool iree_uk_cpu_arm_64_i8mm(const iree_uk_uint64_t* cpu_data) {
   return iree_uk_all_bits_set(cpu_data[0], IREE_CPU_DATA0_ARM_64_I8MM);
 }
 
+static inline bool iree_uk_cpu_arm_64_sve(const iree_uk_uint64_t* cpu_data) {
+  return iree_uk_all_bits_set(cpu_data[0], IREE_CPU_DATA0_ARM_64_SVE);
+}
+
+static inline bool iree_uk_cpu_arm_64_sve_bf16(
+    const iree_uk_uint64_t* cpu_data) {
+  return iree_uk_all_bits_set(
+      cpu_data[0], IREE_CPU_DATA0_ARM_64_SVE | IREE_CPU_DATA0_ARM_64_BF16);
+}
+
+static inline bool iree_uk_cpu_arm_64_sve_i8mm(
+    const iree_uk_uint64_t* cpu_data) {
+  return iree_uk_all_bits_set(
+      cpu_data[0], IREE_CPU_DATA0_ARM_64_SVE | IREE_CPU_DATA0_ARM_64_I8MM);
+}
+
+#if defined(IREE_UK_BUILD_ARM_64_SVE)
+// Returns the SVE vector length in bytes. Defined in mmt4d_arm_64_sve.c, the
+// translation unit built with SVE enabled. Only call this if
+// iree_uk_cpu_arm_64_sve(cpu_data) is true.
+int iree_uk_arm_64_sve_vector_bytes(void);
+#endif  // defined(IREE_UK_BUILD_ARM_64_SVE)
+
 static inline int8x16x2_t iree_uk_neon_load_8x4xi8_strided(
     const iree_uk_int8_t* src, iree_uk_index_t stride) {
   int32x4_t v0_i32 = vdupq_n_s32(0);
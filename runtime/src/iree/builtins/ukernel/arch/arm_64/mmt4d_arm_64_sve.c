@@ -0,0 +1,130 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <arm_sve.h>
+
+#include "iree/builtins/ukernel/arch/arm_64/common_arm_64.h"
+#include "iree/builtins/ukernel/arch/arm_64/mmt4d_arm_64_internal.h"
+
+int iree_uk_arm_64_sve_vector_bytes(void) { return (int)svcntb(); }
+
+// Vector-length-agnostic kernel: the N0 == 16 columns are processed in passes
+// of two vectors each, i.e. a single pass on 256-bit and wider vectors and two
+// passes on 128-bit vectors. Columns past N0 are masked off by predicates.
+IREE_UK_ATTRIBUTE_ALWAYS_INLINE static inline void
+iree_uk_mmt4d_tile_f32f32f32_1x16x1_to_8x16x1_arm_64_sve(
+    void* IREE_UK_RESTRICT out_tile, const void* IREE_UK_RESTRICT lhs_panel,
+    const void* IREE_UK_RESTRICT rhs_panel,
+    const iree_uk_mmt4d_params_t* params, int M0) {
+  IREE_UK_ASSERT(M0 >= 1 && M0 <= 8 && iree_uk_is_po2_u32(M0));
+  const int N0 = 16;
+  const int vl = svcntw();
+  float* IREE_UK_RESTRICT out_ptr = out_tile;
+  for (int n = 0; n < N0; n += 2 * vl) {
+    const svbool_t pg0 = svwhilelt_b32(n, N0);
+    const svbool_t pg1 = svwhilelt_b32(n + vl, N0);
+    float* IREE_UK_RESTRICT out0 = out_ptr + n;
+    float* IREE_UK_RESTRICT out1 = out_ptr + n + vl;
+    // Accumulators acc<row>_<vector>.
+    svfloat32_t acc0_0 = svdup_n_f32(0), acc0_1 = svdup_n_f32(0);
+    svfloat32_t acc1_0 = svdup_n_f32(0), acc1_1 = svdup_n_f32(0);
+    svfloat32_t acc2_0 = svdup_n_f32(0), acc2_1 = svdup_n_f32(0);
+    svfloat32_t acc3_0 = svdup_n_f32(0), acc3_1 = svdup_n_f32(0);
+    svfloat32_t acc4_0 = svdup_n_f32(0), acc4_1 = svdup_n_f32(0);
+    svfloat32_t acc5_0 = svdup_n_f32(0), acc5_1 = svdup_n_f32(0);
+    svfloat32_t acc6_0 = svdup_n_f32(0), acc6_1 = svdup_n_f32(0);
+    svfloat32_t acc7_0 = svdup_n_f32(0), acc7_1 = svdup_n_f32(0);
+    if (params->flags & IREE_UK_FLAG_MMT4D_ACCUMULATE) {
+      acc0_0 = svld1_f32(pg0, out0 + 0 * N0);
+      acc0_1 = svld1_f32(pg1, out1 + 0 * N0);
+      if (M0 >= 2) {
+        acc1_0 = svld1_f32(pg0, out0 + 1 * N0);
+        acc1_1 = svld1_f32(pg1, out1 + 1 * N0);
+      }
+      if (M0 >= 4) {
+        acc2_0 = svld1_f32(pg0, out0 + 2 * N0);
+        acc2_1 = svld1_f32(pg1, out1 + 2 * N0);
+        acc3_0 = svld1_f32(pg0, out0 + 3 * N0);
+        acc3_1 = svld1_f32(pg1, out1 + 3 * N0);
+      }
+      if (M0 >= 8) {
+        acc4_0 = svld1_f32(pg0, out0 + 4 * N0);
+        acc4_1 = svld1_f32(pg1, out1 + 4 * N0);
+        acc5_0 = svld1_f32(pg0, out0 + 5 * N0);
+        acc5_1 = svld1_f32(pg1, out1 + 5 * N0);
+        acc6_0 = svld1_f32(pg0, out0 + 6 * N0);
+        acc6_1 = svld1_f32(pg1, out1 + 6 * N0);
+        acc7_0 = svld1_f32(pg0, out0 + 7 * N0);
+        acc7_1 = svld1_f32(pg1, out1 + 7 * N0);
+      }
+    }
+    const float* IREE_UK_RESTRICT lhs_ptr = lhs_panel;
+    const float* IREE_UK_RESTRICT rhs_ptr = (const float*)rhs_panel + n;
+    for (int k = 0; k < params->K; ++k) {
+      svfloat32_t rhs0 = svld1_f32(pg0, rhs_ptr);
+      svfloat32_t rhs1 = svld1_f32(pg1, rhs_ptr + vl);
+      rhs_ptr += N0;
+      acc0_0 = svmla_n_f32_x(pg0, acc0_0, rhs0, lhs_ptr[0]);
+      acc0_1 = svmla_n_f32_x(pg1, acc0_1, rhs1, lhs_ptr[0]);
+      if (M0 >= 2) {
+        acc1_0 = svmla_n_f32_x(pg0, acc1_0, rhs0, lhs_ptr[1]);
+        acc1_1 = svmla_n_f32_x(pg1, acc1_1, rhs1, lhs_ptr[1]);
+      }
+      if (M0 >= 4) {
+        acc2_0 = svmla_n_f32_x(pg0, acc2_0, rhs0, lhs_ptr[2]);
+        acc2_1 = svmla_n_f32_x(pg1, acc2_1, rhs1, lhs_ptr[2]);
+        acc3_0 = svmla_n_f32_x(pg0, acc3_0, rhs0, lhs_ptr[3]);
+        acc3_1 = svmla_n_f32_x(pg1, acc3_1, rhs1, lhs_ptr[3]);
+      }
+      if (M0 >= 8) {
+        acc4_0 = svmla_n_f32_x(pg0, acc4_0, rhs0, lhs_ptr[4]);
+        acc4_1 = svmla_n_f32_x(pg1, acc4_1, rhs1, lhs_ptr[4]);
+        acc5_0 = svmla_n_f32_x(pg0, acc5_0, rhs0, lhs_ptr[5]);
+        acc5_1 = svmla_n_f32_x(pg1, acc5_1, rhs1, lhs_ptr[5]);
+        acc6_0 = svmla_n_f32_x(pg0, acc6_0, rhs0, lhs_ptr[6]);
+        acc6_1 = svmla_n_f32_x(pg1, acc6_1, rhs1, lhs_ptr[6]);
+        acc7_0 = svmla_n_f32_x(pg0, acc7_0, rhs0, lhs_ptr[7]);
+        acc7_1 = svmla_n_f32_x(pg1, acc7_1, rhs1, lhs_ptr[7]);
+      }
+      lhs_ptr += M0;
+    }
+    svst1_f32(pg0, out0 + 0 * N0, acc0_0);
+    svst1_f32(pg1, out1 + 0 * N0, acc0_1);
+    if (M0 >= 2) {
+      svst1_f32(pg0, out0 + 1 * N0, acc1_0);
+      svst1_f32(pg1, out1 + 1 * N0, acc1_1);
+    }
+    if (M0 >= 4) {
+      svst1_f32(pg0, out0 + 2 * N0, acc2_0);
+      svst1_f32(pg1, out1 + 2 * N0, acc2_1);
+      svst1_f32(pg0, out0 + 3 * N0, acc3_0);
+      svst1_f32(pg1, out1 + 3 * N0, acc3_1);
+    }
+    if (M0 >= 8) {
+      svst1_f32(pg0, out0 + 4 * N0, acc4_0);
+      svst1_f32(pg1, out1 + 4 * N0, acc4_1);
+      svst1_f32(pg0, out0 + 5 * N0, acc5_0);
+      svst1_f32(pg1, out1 + 5 * N0, acc5_1);
+      svst1_f32(pg0, out0 + 6 * N0, acc6_0);
+      svst1_f32(pg1, out1 + 6 * N0, acc6_1);
+      svst1_f32(pg0, out0 + 7 * N0, acc7_0);
+      svst1_f32(pg1, out1 + 7 * N0, acc7_1);
+    }
+  }
+}
+
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_f32f32f32_1x16x1_to_8x16x1_arm_64_sve,
+    iree_uk_mmt4d_tile_f32f32f32_1x16x1_arm_64_sve, 1)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_f32f32f32_1x16x1_to_8x16x1_arm_64_sve,
+    iree_uk_mmt4d_tile_f32f32f32_2x16x1_arm_64_sve, 2)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_f32f32f32_1x16x1_to_8x16x1_arm_64_sve,
+    iree_uk_mmt4d_tile_f32f32f32_4x16x1_arm_64_sve, 4)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_f32f32f32_1x16x1_to_8x16x1_arm_64_sve,
+    iree_uk_mmt4d_tile_f32f32f32_8x16x1_arm_64_sve, 8)
@@ -0,0 +1,221 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <arm_sve.h>
+
+#include "iree/builtins/ukernel/arch/arm_64/common_arm_64.h"
+#include "iree/builtins/ukernel/arch/arm_64/mmt4d_arm_64_internal.h"
+
+// BFMMLA operates on each 128-bit segment independently, accumulating a 2x2
+// block of the output per segment. A vector of accumulators thus covers 2 rows
+// and svcntw() / 2 columns. These helpers convert between that layout and
+// pairs of row-major rows held in the first svcntw() / 2 elements.
+
+static inline svfloat32_t iree_uk_sve_zip1_f32_as_u64(svfloat32_t a,
+                                                      svfloat32_t b) {
+  return svreinterpret_f32_u64(
+      svzip1_u64(svreinterpret_u64_f32(a), svreinterpret_u64_f32(b)));
+}
+
+static inline svfloat32_t iree_uk_sve_uzp1_f32_as_u64(svfloat32_t a) {
+  svuint64_t a_u64 = svreinterpret_u64_f32(a);
+  return svreinterpret_f32_u64(svuzp1_u64(a_u64, a_u64));
+}
+
+static inline svfloat32_t iree_uk_sve_uzp2_f32_as_u64(svfloat32_t a) {
+  svuint64_t a_u64 = svreinterpret_u64_f32(a);
+  return svreinterpret_f32_u64(svuzp2_u64(a_u64, a_u64));
+}
+
+static inline svfloat32_t iree_uk_sve_load_row_as_f32(
+    svbool_t pg, const void* IREE_UK_RESTRICT out_tile, iree_uk_type_t acc_type,
+    int offset) {
+  if (acc_type == IREE_UK_TYPE_FLOAT_32) {
+    return svld1_f32(pg, (const float*)out_tile + offset);
+  }
+  // bf16 is the top half of f32: zero-extend and shift left.
+  svuint32_t u32 =
+      svld1uh_u32(pg, (const iree_uk_uint16_t*)out_tile + offset);
+  return svreinterpret_f32_u32(svlsl_n_u32_x(pg, u32, 16));
+}
+
+static inline void iree_uk_sve_store_row_from_f32(
+    svbool_t pg, void* IREE_UK_RESTRICT out_tile, iree_uk_type_t acc_type,
+    int offset, svfloat32_t row) {
+  if (acc_type == IREE_UK_TYPE_FLOAT_32) {
+    svst1_f32(pg, (float*)out_tile + offset, row);
+    return;
+  }
+  // BFCVT writes each result to the bottom half of its 32-bit container.
+  svbfloat16_t bf16 = svcvt_bf16_f32_x(pg, row);
+  svst1h_u32(pg, (iree_uk_uint16_t*)out_tile + offset,
+             svreinterpret_u32_bf16(bf16));
+}
+
+static inline svfloat32_t iree_uk_sve_load_2_rows_as_f32_2x2(
+    svbool_t pg, const void* IREE_UK_RESTRICT out_tile, iree_uk_type_t acc_type,
+    int offset, int N0, int M0) {
+  svfloat32_t row0 =
+      iree_uk_sve_load_row_as_f32(pg, out_tile, acc_type, offset);
+  svfloat32_t row1 =
+      M0 == 1 ? svdup_n_f32(0)
+              : iree_uk_sve_load_row_as_f32(pg, out_tile, acc_type,
+                                            offset + N0);
+  return iree_uk_sve_zip1_f32_as_u64(row0, row1);
+}
+
+static inline void iree_uk_sve_store_2_rows_from_f32_2x2(
+    svbool_t pg, void* IREE_UK_RESTRICT out_tile, iree_uk_type_t acc_type,
+    int offset, int N0, int M0, svfloat32_t acc) {
+  iree_uk_sve_store_row_from_f32(pg, out_tile, acc_type, offset,
+                                 iree_uk_sve_uzp1_f32_as_u64(acc));
+  if (M0 > 1) {
+    iree_uk_sve_store_row_from_f32(pg, out_tile, acc_type, offset + N0,
+                                   iree_uk_sve_uzp2_f32_as_u64(acc));
+  }
+}
+
+// Vector-length-agnostic kernel: the N0 == 16 columns are processed in passes
+// of two accumulator vectors per pair of rows, i.e. a single pass on 512-bit
+// and wider vectors, two passes on 256-bit vectors and four on 128-bit vectors.
+IREE_UK_ATTRIBUTE_ALWAYS_INLINE static inline void
+iree_uk_mmt4d_tile_bf16bf16fXX_1x16x4_to_8x16x4_arm_64_sve_bf16(
+    void* IREE_UK_RESTRICT out_tile, const void* IREE_UK_RESTRICT lhs_panel,
+    const void* IREE_UK_RESTRICT rhs_panel,
+    const iree_uk_mmt4d_params_t* params, iree_uk_type_t acc_type, int M0) {
+  IREE_UK_ASSERT(acc_type == IREE_UK_TYPE_FLOAT_32 ||
+                 acc_type == IREE_UK_TYPE_BFLOAT_16);
+  IREE_UK_ASSERT(M0 >= 1 && M0 <= 8 && iree_uk_is_po2_u32(M0));
+  const int N0 = 16;
+  const int K0 = 4;
+  const int cols = svcntw() / 2;
+  // Each pair of LHS rows is one 128-bit segment, replicated to all segments.
+  // When M0 == 1 the second row is zero.
+  const svbool_t pg_lhs = svwhilelt_b16(0, M0 == 1 ? K0 : 2 * K0);
+  for (int n = 0; n < N0; n += 2 * cols) {
+    const int n0 = n;
+    const int n1 = n + cols;
+    const svbool_t pg_rhs0 = svwhilelt_b16(n0 * K0, N0 * K0);
+    const svbool_t pg_rhs1 = svwhilelt_b16(n1 * K0, N0 * K0);
+    const svbool_t pg_out0 = svwhilelt_b32(0, N0 - n0 < cols ? N0 - n0 : cols);
+    const svbool_t pg_out1 = svwhilelt_b32(0, N0 - n1 < cols ? N0 - n1 : cols);
+    // Accumulators acc<row pair>_<vector>.
+    svfloat32_t acc0_0 = svdup_n_f32(0), acc0_1 = svdup_n_f32(0);
+    svfloat32_t acc1_0 = svdup_n_f32(0), acc1_1 = svdup_n_f32(0);
+    svfloat32_t acc2_0 = svdup_n_f32(0), acc2_1 = svdup_n_f32(0);
+    svfloat32_t acc3_0 = svdup_n_f32(0), acc3_1 = svdup_n_f32(0);
+    if (params->flags & IREE_UK_FLAG_MMT4D_ACCUMULATE) {
+      acc0_0 = iree_uk_sve_load_2_rows_as_f32_2x2(pg_out0, out_tile, acc_type,
+                                                  0 * N0 + n0, N0, M0);
+      acc0_1 = iree_uk_sve_load_2_rows_as_f32_2x2(pg_out1, out_tile, acc_type,
+                                                  0 * N0 + n1, N0, M0);
+      if (M0 >= 4) {
+        acc1_0 = iree_uk_sve_load_2_rows_as_f32_2x2(
+            pg_out0, out_tile, acc_type, 2 * N0 + n0, N0, M0);
+        acc1_1 = iree_uk_sve_load_2_rows_as_f32_2x2(
+            pg_out1, out_tile, acc_type, 2 * N0 + n1, N0, M0);
+      }
+      if (M0 >= 8) {
+        acc2_0 = iree_uk_sve_load_2_rows_as_f32_2x2(
+            pg_out0, out_tile, acc_type, 4 * N0 + n0, N0, M0);
+        acc2_1 = iree_uk_sve_load_2_rows_as_f32_2x2(
+            pg_out1, out_tile, acc_type, 4 * N0 + n1, N0, M0);
+        acc3_0 = iree_uk_sve_load_2_rows_as_f32_2x2(
+            pg_out0, out_tile, acc_type, 6 * N0 + n0, N0, M0);
+        acc3_1 = iree_uk_sve_load_2_rows_as_f32_2x2(
+            pg_out1, out_tile, acc_type, 6 * N0 + n1, N0, M0);
+      }
+    }
+    const bfloat16_t* IREE_UK_RESTRICT lhs_ptr = lhs_panel;
+    const bfloat16_t* IREE_UK_RESTRICT rhs_ptr = rhs_panel;
+    for (int k = 0; k < params->K; ++k) {
+      svbfloat16_t rhs0 = svld1_bf16(pg_rhs0, rhs_ptr + n0 * K0);
+      svbfloat16_t rhs1 = svld1_bf16(pg_rhs1, rhs_ptr + n1 * K0);
+      rhs_ptr += N0 * K0;
+      svbfloat16_t lhs0 = svld1rq_bf16(pg_lhs, lhs_ptr);
+      acc0_0 = svbfmmla_f32(acc0_0, lhs0, rhs0);
+      acc0_1 = svbfmmla_f32(acc0_1, lhs0, rhs1);
+      if (M0 >= 4) {
+        svbfloat16_t lhs1 = svld1rq_bf16(pg_lhs, lhs_ptr + 2 * K0);
+        acc1_0 = svbfmmla_f32(acc1_0, lhs1, rhs0);
+        acc1_1 = svbfmmla_f32(acc1_1, lhs1, rhs1);
+      }
+      if (M0 >= 8) {
+        svbfloat16_t lhs2 = svld1rq_bf16(pg_lhs, lhs_ptr + 4 * K0);
+        svbfloat16_t lhs3 = svld1rq_bf16(pg_lhs, lhs_ptr + 6 * K0);
+        acc2_0 = svbfmmla_f32(acc2_0, lhs2, rhs0);
+        acc2_1 = svbfmmla_f32(acc2_1, lhs2, rhs1);
+        acc3_0 = svbfmmla_f32(acc3_0, lhs3, rhs0);
+        acc3_1 = svbfmmla_f32(acc3_1, lhs3, rhs1);
+      }
+      lhs_ptr += M0 * K0;
+    }
+    iree_uk_sve_store_2_rows_from_f32_2x2(pg_out0, out_tile, acc_type,
+                                          0 * N0 + n0, N0, M0, acc0_0);
+    iree_uk_sve_store_2_rows_from_f32_2x2(pg_out1, out_tile, acc_type,
+                                          0 * N0 + n1, N0, M0, acc0_1);
+    if (M0 >= 4) {
+      iree_uk_sve_store_2_rows_from_f32_2x2(pg_out0, out_tile, acc_type,
+                                            2 * N0 + n0, N0, M0, acc1_0);
+      iree_uk_sve_store_2_rows_from_f32_2x2(pg_out1, out_tile, acc_type,
+                                            2 * N0 + n1, N0, M0, acc1_1);
+    }
+    if (M0 >= 8) {
+      iree_uk_sve_store_2_rows_from_f32_2x2(pg_out0, out_tile, acc_type,
+                                            4 * N0 + n0, N0, M0, acc2_0);
+      iree_uk_sve_store_2_rows_from_f32_2x2(pg_out1, out_tile, acc_type,
+                                            4 * N0 + n1, N0, M0, acc2_1);
+      iree_uk_sve_store_2_rows_from_f32_2x2(pg_out0, out_tile, acc_type,
+                                            6 * N0 + n0, N0, M0, acc3_0);
+      iree_uk_sve_store_2_rows_from_f32_2x2(pg_out1, out_tile, acc_type,
+                                            6 * N0 + n1, N0, M0, acc3_1);
+    }
+  }
+}
+
+IREE_UK_ATTRIBUTE_ALWAYS_INLINE static inline void
+iree_uk_mmt4d_tile_bf16bf16f32_1x16x4_to_8x16x4_arm_64_sve_bf16(
+    void* IREE_UK_RESTRICT out_tile, const void* IREE_UK_RESTRICT lhs_panel,
+    const void* IREE_UK_RESTRICT rhs_panel,
+    const iree_uk_mmt4d_params_t* params, int M0) {
+  iree_uk_mmt4d_tile_bf16bf16fXX_1x16x4_to_8x16x4_arm_64_sve_bf16(
+      out_tile, lhs_panel, rhs_panel, params, IREE_UK_TYPE_FLOAT_32, M0);
+}
+
+IREE_UK_ATTRIBUTE_ALWAYS_INLINE static inline void
+iree_uk_mmt4d_tile_bf16bf16bf16_1x16x4_to_8x16x4_arm_64_sve_bf16(
+    void* IREE_UK_RESTRICT out_tile, const void* IREE_UK_RESTRICT lhs_panel,
+    const void* IREE_UK_RESTRICT rhs_panel,
+    const iree_uk_mmt4d_params_t* params, int M0) {
+  iree_uk_mmt4d_tile_bf16bf16fXX_1x16x4_to_8x16x4_arm_64_sve_bf16(
+      out_tile, lhs_panel, rhs_panel, params, IREE_UK_TYPE_BFLOAT_16, M0);
+}
+
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16f32_1x16x4_to_8x16x4_arm_64_sve_bf16,
+    iree_uk_mmt4d_tile_bf16bf16f32_1x16x4_arm_64_sve_bf16, 1)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16f32_1x16x4_to_8x16x4_arm_64_sve_bf16,
+    iree_uk_mmt4d_tile_bf16bf16f32_2x16x4_arm_64_sve_bf16, 2)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16f32_1x16x4_to_8x16x4_arm_64_sve_bf16,
+    iree_uk_mmt4d_tile_bf16bf16f32_4x16x4_arm_64_sve_bf16, 4)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16f32_1x16x4_to_8x16x4_arm_64_sve_bf16,
+    iree_uk_mmt4d_tile_bf16bf16f32_8x16x4_arm_64_sve_bf16, 8)
+
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16bf16_1x16x4_to_8x16x4_arm_64_sve_bf16,
+    iree_uk_mmt4d_tile_bf16bf16bf16_1x16x4_arm_64_sve_bf16, 1)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16bf16_1x16x4_to_8x16x4_arm_64_sve_bf16,
+    iree_uk_mmt4d_tile_bf16bf16bf16_2x16x4_arm_64_sve_bf16, 2)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16bf16_1x16x4_to_8x16x4_arm_64_sve_bf16,
+    iree_uk_mmt4d_tile_bf16bf16bf16_4x16x4_arm_64_sve_bf16, 4)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16bf16_1x16x4_to_8x16x4_arm_64_sve_bf16,
+    iree_uk_mmt4d_tile_bf16bf16bf16_8x16x4_arm_64_sve_bf16, 8)
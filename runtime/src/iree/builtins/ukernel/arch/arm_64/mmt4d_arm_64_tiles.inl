@@ -11,6 +11,10 @@ IREE_UK_MMT4D_TILE(arm_64, f32, f32, f32, 1, 8, 1, )
 IREE_UK_MMT4D_TILE(arm_64, f32, f32, f32, 2, 8, 1, )
 IREE_UK_MMT4D_TILE(arm_64, f32, f32, f32, 4, 8, 1, )
 IREE_UK_MMT4D_TILE(arm_64, f32, f32, f32, 8, 8, 1, )
+IREE_UK_MMT4D_TILE(arm_64, f32, f32, f32, 1, 16, 1, _sve)
+IREE_UK_MMT4D_TILE(arm_64, f32, f32, f32, 2, 16, 1, _sve)
+IREE_UK_MMT4D_TILE(arm_64, f32, f32, f32, 4, 16, 1, _sve)
+IREE_UK_MMT4D_TILE(arm_64, f32, f32, f32, 8, 16, 1, _sve)
 IREE_UK_MMT4D_TILE(arm_64, f16, f16, f32, 1, 8, 1, )
 IREE_UK_MMT4D_TILE(arm_64, f16, f16, f32, 2, 8, 1, )
 IREE_UK_MMT4D_TILE(arm_64, f16, f16, f32, 4, 8, 1, )
@@ -35,6 +39,14 @@ IREE_UK_MMT4D_TILE(arm_64, bf16, bf16, bf16, 1, 8, 4, _bf16)
 IREE_UK_MMT4D_TILE(arm_64, bf16, bf16, bf16, 2, 8, 4, _bf16)
 IREE_UK_MMT4D_TILE(arm_64, bf16, bf16, bf16, 4, 8, 4, _bf16)
 IREE_UK_MMT4D_TILE(arm_64, bf16, bf16, bf16, 8, 8, 4, _bf16)
+IREE_UK_MMT4D_TILE(arm_64, bf16, bf16, f32, 1, 16, 4, _sve_bf16)
+IREE_UK_MMT4D_TILE(arm_64, bf16, bf16, f32, 2, 16, 4, _sve_bf16)
+IREE_UK_MMT4D_TILE(arm_64, bf16, bf16, f32, 4, 16, 4, _sve_bf16)
+IREE_UK_MMT4D_TILE(arm_64, bf16, bf16, f32, 8, 16, 4, _sve_bf16)
+IREE_UK_MMT4D_TILE(arm_64, bf16, bf16, bf16, 1, 16, 4, _sve_bf16)
+IREE_UK_MMT4D_TILE(arm_64, bf16, bf16, bf16, 2, 16, 4, _sve_bf16)
+IREE_UK_MMT4D_TILE(arm_64, bf16, bf16, bf16, 4, 16, 4, _sve_bf16)
+IREE_UK_MMT4D_TILE(arm_64, bf16, bf16, bf16, 8, 16, 4, _sve_bf16)
 IREE_UK_MMT4D_TILE(arm_64, s8, s8, s32, 1, 8, 1, )
 IREE_UK_MMT4D_TILE(arm_64, s8, s8, s32, 2, 8, 1, )
 IREE_UK_MMT4D_TILE(arm_64, s8, s8, s32, 4, 8, 1, )
@@ -47,6 +59,10 @@ IREE_UK_MMT4D_TILE(arm_64, s8, s8, s32, 1, 8, 8, _i8mm)
 IREE_UK_MMT4D_TILE(arm_64, s8, s8, s32, 2, 8, 8, _i8mm)
 IREE_UK_MMT4D_TILE(arm_64, s8, s8, s32, 4, 8, 8, _i8mm)
 IREE_UK_MMT4D_TILE(arm_64, s8, s8, s32, 8, 8, 8, _i8mm)
+IREE_UK_MMT4D_TILE(arm_64, s8, s8, s32, 1, 16, 8, _sve_i8mm)
+IREE_UK_MMT4D_TILE(arm_64, s8, s8, s32, 2, 16, 8, _sve_i8mm)
+IREE_UK_MMT4D_TILE(arm_64, s8, s8, s32, 4, 16, 8, _sve_i8mm)
+IREE_UK_MMT4D_TILE(arm_64, s8, s8, s32, 8, 16, 8, _sve_i8mm)
 IREE_UK_MMT4D_TILE(arm_64, s8, s4, s32, 1, 16, 2, )
 IREE_UK_MMT4D_TILE(arm_64, s8, s4, s32, 2, 16, 2, )
 IREE_UK_MMT4D_TILE(arm_64, s8, s4, s32, 4, 16, 2, )
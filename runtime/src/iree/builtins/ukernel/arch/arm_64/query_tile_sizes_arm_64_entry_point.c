@@ -7,15 +7,36 @@
 #include "iree/builtins/ukernel/arch/arm_64/common_arm_64.h"
 #include "iree/builtins/ukernel/query_tile_sizes_internal.h"
 
+#ifdef IREE_UK_BUILD_ARM_64_SVE
+// The SVE tiles are wider than the NEON ones, which only pays off when the SVE
+// vectors are: at 128 bits, NEON has the same width and lower overhead.
+static bool iree_uk_query_tile_sizes_arm_64_prefer_sve(
+    const iree_uk_uint64_t* cpu_data) {
+  return iree_uk_cpu_arm_64_sve(cpu_data) &&
+         iree_uk_arm_64_sve_vector_bytes() > 16;
+}
+#endif
+
 static iree_uk_matmul_tile_sizes_t
 iree_uk_query_matmul_tile_sizes_arm_64_f32f32f32(
     const iree_uk_query_tile_sizes_2d_params_t* params) {
+#ifdef IREE_UK_BUILD_ARM_64_SVE
+  if (iree_uk_query_tile_sizes_arm_64_prefer_sve(params->cpu_data)) {
+    return (iree_uk_matmul_tile_sizes_t){.M = 8, .K = 1, .N = 16};
+  }
+#endif
   return (iree_uk_matmul_tile_sizes_t){.M = 8, .K = 1, .N = 8};
 }
 
 static iree_uk_matmul_tile_sizes_t
 iree_uk_query_matmul_tile_sizes_arm_64_i8i8i32(
     const iree_uk_query_tile_sizes_2d_params_t* params) {
+#if defined(IREE_UK_BUILD_ARM_64_SVE) && defined(IREE_UK_BUILD_ARM_64_SVE_I8MM)
+  if (iree_uk_cpu_arm_64_sve_i8mm(params->cpu_data) &&
+      iree_uk_query_tile_sizes_arm_64_prefer_sve(params->cpu_data)) {
+    return (iree_uk_matmul_tile_sizes_t){.M = 8, .K = 8, .N = 16};
+  }
+#endif
 #ifdef IREE_UK_BUILD_ARM_64_I8MM
   if (iree_uk_cpu_arm_64_i8mm(params->cpu_data)) {
     return (iree_uk_matmul_tile_sizes_t){.M = 8, .K = 8, .N = 8};
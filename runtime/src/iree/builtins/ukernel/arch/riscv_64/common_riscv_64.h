@@ -14,7 +14,7 @@
 
 #if defined(IREE_DEVICE_STANDALONE)
 // Standalone builds (e.g. bitcode) use our own Clang, supporting everything.
-// PLACEHOLDER
+#define IREE_UK_BUILD_RISCV_64_ZVFH
 #else
 // Compiling with the system toolchain. Include the configured header.
 #include "iree/builtins/ukernel/arch/riscv_64/config_riscv_64.h"
@@ -25,5 +25,73 @@ static inline bool iree_uk_cpu_riscv_64(const iree_uk_uint64_t* cpu_data) {
   return true;
 }
 
-#endif  // IREE_BUILTINS_UKERNEL_ARCH_ARM_64_COMMON_ARM_64_H_
+static inline bool iree_uk_cpu_riscv_64_zvfh(
+    const iree_uk_uint64_t* cpu_data) {
+  return iree_uk_all_bits_set(cpu_data[0], IREE_CPU_DATA0_RISCV_64_ZVFH);
+}
+
+// The helpers below are only usable from translation units compiled with the
+// V extension enabled, which is not the case of the entry points in bitcode
+// builds.
+#if defined(__riscv_vector)
+
+// Copies |size| elements between buffers whose consecutive elements are
+// |out_stride| and |in_stride| elements apart. Strip-mined with vsetvl so that
+// it is independent of VLEN; unit strides use the plain (non-strided) loads
+// and stores, which are much faster on current implementations.
+#define IREE_UK_RISCV_64_COPY_STRIDED_IMPL(BITS)                            \
+  static inline void iree_uk_riscv_64_copy_x##BITS##_strided(               \
+      iree_uk_uint##BITS##_t* IREE_UK_RESTRICT out_ptr,                     \
+      iree_uk_index_t out_stride,                                           \
+      const iree_uk_uint##BITS##_t* IREE_UK_RESTRICT in_ptr,                \
+      iree_uk_index_t in_stride, iree_uk_index_t size) {                    \
+    while (size > 0) {                                                      \
+      size_t vl = __riscv_vsetvl_e##BITS##m8(size);                         \
+      vuint##BITS##m8_t v =                                                 \
+          in_stride == 1                                                    \
+              ? __riscv_vle##BITS##_v_u##BITS##m8(in_ptr, vl)               \
+              : __riscv_vlse##BITS##_v_u##BITS##m8(                         \
+                    in_ptr, in_stride * sizeof(*in_ptr), vl);               \
+      if (out_stride == 1) {                                                \
+        __riscv_vse##BITS##_v_u##BITS##m8(out_ptr, v, vl);                  \
+      } else {                                                              \
+        __riscv_vsse##BITS##_v_u##BITS##m8(                                 \
+            out_ptr, out_stride * sizeof(*out_ptr), v, vl);                 \
+      }                                                                     \
+      in_ptr += vl * in_stride;                                             \
+      out_ptr += vl * out_stride;                                           \
+      size -= vl;                                                           \
+    }                                                                       \
+  }
+
+IREE_UK_RISCV_64_COPY_STRIDED_IMPL(8)
+IREE_UK_RISCV_64_COPY_STRIDED_IMPL(16)
+IREE_UK_RISCV_64_COPY_STRIDED_IMPL(32)
+
+#undef IREE_UK_RISCV_64_COPY_STRIDED_IMPL
+
+// Element-size-generic variant of the above. Strides are in elements.
+IREE_UK_ATTRIBUTE_ALWAYS_INLINE static inline void
+iree_uk_riscv_64_copy_strided(void* IREE_UK_RESTRICT out_ptr,
+                              iree_uk_index_t out_stride,
+                              const void* IREE_UK_RESTRICT in_ptr,
+                              iree_uk_index_t in_stride, iree_uk_index_t size,
+                              iree_uk_index_t elem_size) {
+  if (elem_size == 1) {
+    iree_uk_riscv_64_copy_x8_strided(out_ptr, out_stride, in_ptr, in_stride,
+                                     size);
+  } else if (elem_size == 2) {
+    iree_uk_riscv_64_copy_x16_strided(out_ptr, out_stride, in_ptr, in_stride,
+                                      size);
+  } else if (elem_size == 4) {
+    iree_uk_riscv_64_copy_x32_strided(out_ptr, out_stride, in_ptr, in_stride,
+                                      size);
+  } else {
+    IREE_UK_ASSERT(false && "unhandled element size");
+  }
+}
+
+#endif  // defined(__riscv_vector)
+
+#endif  // IREE_BUILTINS_UKERNEL_ARCH_RISCV_64_COMMON_RISCV_64_H_
 
@@ -7,131 +7,68 @@
 #include "iree/builtins/ukernel/arch/riscv_64/common_riscv_64.h"
 #include "iree/builtins/ukernel/arch/riscv_64/mmt4d_riscv_64_internal.h"
 
+// The kernels in this file are vector-length-agnostic: the N0 == 32 columns
+// are processed in chunks of vl columns, where vl is what vsetvl grants for
+// LMUL=4, i.e. a single chunk on VLEN >= 256 and two chunks on VLEN == 128.
+// With M0 == 7 that is 7 LMUL=4 accumulators plus one for the RHS row, i.e.
+// all 32 vector registers.
+
 IREE_UK_ATTRIBUTE_ALWAYS_INLINE static inline void
 iree_uk_mmt4d_tile_f32f32f32_1x32x1_to_7x32x1_riscv_64(
     void* IREE_UK_RESTRICT out_tile, const void* IREE_UK_RESTRICT lhs_panel,
     const void* IREE_UK_RESTRICT rhs_panel,
     const iree_uk_mmt4d_params_t* params, int M0) {
-  IREE_UK_ASSERT(M0 >= 1 && M0 <= 7 && iree_uk_is_po2_u32(M0));
-  const float* IREE_UK_RESTRICT lhs_ptr = lhs_panel;
-  const float* IREE_UK_RESTRICT rhs_ptr = rhs_panel;
+  IREE_UK_ASSERT(M0 == 1 || M0 == 2 || M0 == 4 || M0 == 7);
+  const int N0 = 32;
   float* IREE_UK_RESTRICT out_ptr = out_tile;
-
-  // Need 7 accumulators at most
-  vfloat32m4_t acc0, acc1, acc2, acc3, acc4, acc5, acc6;
-
-  size_t vlmax =  __riscv_vsetvlmax_e32m4();
-  // TODO: Handle M0 == 1 case in a separate function, have 
-  // to set LMUL=8, and use different tile sizes for
-  // better register utilization
-  if (M0 == 1) {
-    if (params->flags & IREE_UK_FLAG_MMT4D_ACCUMULATE) {
-      acc0 =  __riscv_vle32_v_f32m4(out_ptr, vlmax);
-    } else {
-      acc0 =  __riscv_vfmv_v_f_f32m4(0.0, vlmax);
-    }
-    for (int k = 0; k < params->K; ++k) {
-      vfloat32m4_t rhs = __riscv_vle32_v_f32m4(rhs_ptr, vlmax);
-      rhs_ptr += 32;
-      float lhs = *lhs_ptr++;
-      acc0 = __riscv_vfmacc_vf_f32m4(acc0, lhs, rhs, vlmax);
-
-    }
-    __riscv_vse32_v_f32m4(out_ptr, acc0, vlmax);
-  }
-
-  else if (M0 == 2) {
+  for (int n = 0; n < N0;) {
+    size_t vl = __riscv_vsetvl_e32m4(N0 - n);
+    vfloat32m4_t acc0 = __riscv_vfmv_v_f_f32m4(0.0f, vl);
+    vfloat32m4_t acc1 = acc0, acc2 = acc0, acc3 = acc0, acc4 = acc0,
+                 acc5 = acc0, acc6 = acc0;
     if (params->flags & IREE_UK_FLAG_MMT4D_ACCUMULATE) {
-      acc0 =  __riscv_vle32_v_f32m4(out_ptr, vlmax);
-      acc1 =  __riscv_vle32_v_f32m4(out_ptr + 32 , vlmax);
-    } else {
-      acc0 =  __riscv_vfmv_v_f_f32m4(0.0, vlmax);
-      acc1 =  __riscv_vfmv_v_f_f32m4(0.0, vlmax);
+      acc0 = __riscv_vle32_v_f32m4(out_ptr + 0 * N0 + n, vl);
+      if (M0 >= 2) acc1 = __riscv_vle32_v_f32m4(out_ptr + 1 * N0 + n, vl);
+      if (M0 >= 4) {
+        acc2 = __riscv_vle32_v_f32m4(out_ptr + 2 * N0 + n, vl);
+        acc3 = __riscv_vle32_v_f32m4(out_ptr + 3 * N0 + n, vl);
+      }
+      if (M0 >= 7) {
+        acc4 = __riscv_vle32_v_f32m4(out_ptr + 4 * N0 + n, vl);
+        acc5 = __riscv_vle32_v_f32m4(out_ptr + 5 * N0 + n, vl);
+        acc6 = __riscv_vle32_v_f32m4(out_ptr + 6 * N0 + n, vl);
+      }
     }
+    const float* IREE_UK_RESTRICT lhs_ptr = lhs_panel;
+    const float* IREE_UK_RESTRICT rhs_ptr = (const float*)rhs_panel + n;
     for (int k = 0; k < params->K; ++k) {
-      vfloat32m4_t rhs = __riscv_vle32_v_f32m4(rhs_ptr, vlmax);
-      rhs_ptr += 32;
-      float lhs0 = *lhs_ptr++;
-      float lhs1 = *lhs_ptr++;
-      acc0 = __riscv_vfmacc_vf_f32m4(acc0, lhs0, rhs, vlmax);
-      acc1 = __riscv_vfmacc_vf_f32m4(acc1, lhs1, rhs, vlmax);
+      vfloat32m4_t rhs = __riscv_vle32_v_f32m4(rhs_ptr, vl);
+      rhs_ptr += N0;
+      acc0 = __riscv_vfmacc_vf_f32m4(acc0, lhs_ptr[0], rhs, vl);
+      if (M0 >= 2) acc1 = __riscv_vfmacc_vf_f32m4(acc1, lhs_ptr[1], rhs, vl);
+      if (M0 >= 4) {
+        acc2 = __riscv_vfmacc_vf_f32m4(acc2, lhs_ptr[2], rhs, vl);
+        acc3 = __riscv_vfmacc_vf_f32m4(acc3, lhs_ptr[3], rhs, vl);
+      }
+      if (M0 >= 7) {
+        acc4 = __riscv_vfmacc_vf_f32m4(acc4, lhs_ptr[4], rhs, vl);
+        acc5 = __riscv_vfmacc_vf_f32m4(acc5, lhs_ptr[5], rhs, vl);
+        acc6 = __riscv_vfmacc_vf_f32m4(acc6, lhs_ptr[6], rhs, vl);
+      }
+      lhs_ptr += M0;
     }
-    __riscv_vse32_v_f32m4(out_ptr, acc0, vlmax);
-    __riscv_vse32_v_f32m4(out_ptr + 32, acc1, vlmax);
-  }
-  else if (M0 == 4) {
-    if (params->flags & IREE_UK_FLAG_MMT4D_ACCUMULATE) {
-      acc0 =  __riscv_vle32_v_f32m4(out_ptr, vlmax);
-      acc1 =  __riscv_vle32_v_f32m4(out_ptr + 32 , vlmax);
-      acc2 =  __riscv_vle32_v_f32m4(out_ptr + 64, vlmax);
-      acc3 =  __riscv_vle32_v_f32m4(out_ptr + 96 , vlmax);
-    } else {
-      acc0 =  __riscv_vfmv_v_f_f32m4(0.0, vlmax);
-      acc1 =  __riscv_vfmv_v_f_f32m4(0.0, vlmax);
-      acc2 =  __riscv_vfmv_v_f_f32m4(0.0, vlmax);
-      acc3 =  __riscv_vfmv_v_f_f32m4(0.0, vlmax);
-    }
-    for (int k = 0; k < params->K; ++k) {
-      vfloat32m4_t rhs = __riscv_vle32_v_f32m4(rhs_ptr, vlmax);
-      rhs_ptr += 32;
-      float lhs0 = *lhs_ptr++;
-      float lhs1 = *lhs_ptr++;
-      float lhs2 = *lhs_ptr++;
-      float lhs3 = *lhs_ptr++;
-      acc0 = __riscv_vfmacc_vf_f32m4(acc0, lhs0, rhs, vlmax);
-      acc1 = __riscv_vfmacc_vf_f32m4(acc1, lhs1, rhs, vlmax);
-      acc2 = __riscv_vfmacc_vf_f32m4(acc2, lhs2, rhs, vlmax);
-      acc3 = __riscv_vfmacc_vf_f32m4(acc3, lhs3, rhs, vlmax);
+    __riscv_vse32_v_f32m4(out_ptr + 0 * N0 + n, acc0, vl);
+    if (M0 >= 2) __riscv_vse32_v_f32m4(out_ptr + 1 * N0 + n, acc1, vl);
+    if (M0 >= 4) {
+      __riscv_vse32_v_f32m4(out_ptr + 2 * N0 + n, acc2, vl);
+      __riscv_vse32_v_f32m4(out_ptr + 3 * N0 + n, acc3, vl);
     }
-    __riscv_vse32_v_f32m4(out_ptr, acc0, vlmax);
-    __riscv_vse32_v_f32m4(out_ptr + 32, acc1, vlmax);
-    __riscv_vse32_v_f32m4(out_ptr + 64, acc2, vlmax);
-    __riscv_vse32_v_f32m4(out_ptr + 96, acc3, vlmax);
-  }
-  
-  else if (M0 == 7) {
-    if (params->flags & IREE_UK_FLAG_MMT4D_ACCUMULATE) {
-      acc0 = __riscv_vle32_v_f32m4(out_ptr, vlmax);
-      acc1 = __riscv_vle32_v_f32m4(out_ptr + 32, vlmax);
-      acc2 = __riscv_vle32_v_f32m4(out_ptr + 64, vlmax);
-      acc3 = __riscv_vle32_v_f32m4(out_ptr + 96, vlmax);
-      acc4 = __riscv_vle32_v_f32m4(out_ptr + 128, vlmax);
-      acc5 = __riscv_vle32_v_f32m4(out_ptr + 160, vlmax);
-      acc6 = __riscv_vle32_v_f32m4(out_ptr + 192, vlmax);
-    } else {
-      acc0 = __riscv_vfmv_v_f_f32m4(0.0, vlmax);
-      acc1 = __riscv_vfmv_v_f_f32m4(0.0, vlmax);
-      acc2 = __riscv_vfmv_v_f_f32m4(0.0, vlmax);
-      acc3 = __riscv_vfmv_v_f_f32m4(0.0, vlmax);
-      acc4 = __riscv_vfmv_v_f_f32m4(0.0, vlmax);
-      acc5 = __riscv_vfmv_v_f_f32m4(0.0, vlmax);
-      acc6 = __riscv_vfmv_v_f_f32m4(0.0, vlmax);
-    }
-    for (int k = 0; k < params->K; ++k) {
-      vfloat32m4_t rhs = __riscv_vle32_v_f32m4(rhs_ptr, vlmax);
-      rhs_ptr += 32;
-      float lhs0 = *lhs_ptr++;
-      float lhs1 = *lhs_ptr++; 
-      float lhs2 = *lhs_ptr++; 
-      float lhs3 = *lhs_ptr++; 
-      float lhs4 = *lhs_ptr++; 
-      float lhs5 = *lhs_ptr++;
-      float lhs6 = *lhs_ptr++; 
-      acc0 = __riscv_vfmacc_vf_f32m4(acc0, lhs0, rhs, vlmax);
-      acc1 = __riscv_vfmacc_vf_f32m4(acc1, lhs1, rhs, vlmax);
-      acc2 = __riscv_vfmacc_vf_f32m4(acc2, lhs2, rhs, vlmax);
-      acc3 = __riscv_vfmacc_vf_f32m4(acc3, lhs3, rhs, vlmax);
-      acc4 = __riscv_vfmacc_vf_f32m4(acc4, lhs4, rhs, vlmax);
-      acc5 = __riscv_vfmacc_vf_f32m4(acc5, lhs5, rhs, vlmax);
-      acc6 = __riscv_vfmacc_vf_f32m4(acc6, lhs6, rhs, vlmax);
+    if (M0 >= 7) {
+      __riscv_vse32_v_f32m4(out_ptr + 4 * N0 + n, acc4, vl);
+      __riscv_vse32_v_f32m4(out_ptr + 5 * N0 + n, acc5, vl);
+      __riscv_vse32_v_f32m4(out_ptr + 6 * N0 + n, acc6, vl);
     }
-    __riscv_vse32_v_f32m4(out_ptr, acc0, vlmax);
-    __riscv_vse32_v_f32m4(out_ptr + 32, acc1, vlmax);
-    __riscv_vse32_v_f32m4(out_ptr + 64, acc2, vlmax);
-    __riscv_vse32_v_f32m4(out_ptr + 96, acc3, vlmax);
-    __riscv_vse32_v_f32m4(out_ptr + 128, acc4, vlmax);
-    __riscv_vse32_v_f32m4(out_ptr + 160, acc5, vlmax);
-    __riscv_vse32_v_f32m4(out_ptr + 192, acc6, vlmax);
+    n += vl;
   }
 }
 
@@ -146,4 +83,82 @@ IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
     iree_uk_mmt4d_tile_f32f32f32_4x32x1_riscv_64, 4)
 IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
     iree_uk_mmt4d_tile_f32f32f32_1x32x1_to_7x32x1_riscv_64,
-    iree_uk_mmt4d_tile_f32f32f32_7x32x1_riscv_64, 7)
\ No newline at end of file
+    iree_uk_mmt4d_tile_f32f32f32_7x32x1_riscv_64, 7)
+
+// RVV 1.0 has no 8-bit dot-product instruction, so the RHS row is sign-extended
+// to 16 bits and accumulated with the widening vwmacc.vx, which multiplies by
+// a scalar LHS element (sign-extended to 16 bits by C promotion rules).
+IREE_UK_ATTRIBUTE_ALWAYS_INLINE static inline void
+iree_uk_mmt4d_tile_s8s8s32_1x32x1_to_7x32x1_riscv_64(
+    void* IREE_UK_RESTRICT out_tile, const void* IREE_UK_RESTRICT lhs_panel,
+    const void* IREE_UK_RESTRICT rhs_panel,
+    const iree_uk_mmt4d_params_t* params, int M0) {
+  IREE_UK_ASSERT(M0 == 1 || M0 == 2 || M0 == 4 || M0 == 7);
+  const int N0 = 32;
+  iree_uk_int32_t* IREE_UK_RESTRICT out_ptr = out_tile;
+  for (int n = 0; n < N0;) {
+    // e8m1, e16m2 and e32m4 share the same SEW/LMUL ratio, hence the same vl.
+    size_t vl = __riscv_vsetvl_e32m4(N0 - n);
+    vint32m4_t acc0 = __riscv_vmv_v_x_i32m4(0, vl);
+    vint32m4_t acc1 = acc0, acc2 = acc0, acc3 = acc0, acc4 = acc0,
+               acc5 = acc0, acc6 = acc0;
+    if (params->flags & IREE_UK_FLAG_MMT4D_ACCUMULATE) {
+      acc0 = __riscv_vle32_v_i32m4(out_ptr + 0 * N0 + n, vl);
+      if (M0 >= 2) acc1 = __riscv_vle32_v_i32m4(out_ptr + 1 * N0 + n, vl);
+      if (M0 >= 4) {
+        acc2 = __riscv_vle32_v_i32m4(out_ptr + 2 * N0 + n, vl);
+        acc3 = __riscv_vle32_v_i32m4(out_ptr + 3 * N0 + n, vl);
+      }
+      if (M0 >= 7) {
+        acc4 = __riscv_vle32_v_i32m4(out_ptr + 4 * N0 + n, vl);
+        acc5 = __riscv_vle32_v_i32m4(out_ptr + 5 * N0 + n, vl);
+        acc6 = __riscv_vle32_v_i32m4(out_ptr + 6 * N0 + n, vl);
+      }
+    }
+    const iree_uk_int8_t* IREE_UK_RESTRICT lhs_ptr = lhs_panel;
+    const iree_uk_int8_t* IREE_UK_RESTRICT rhs_ptr =
+        (const iree_uk_int8_t*)rhs_panel + n;
+    for (int k = 0; k < params->K; ++k) {
+      vint16m2_t rhs =
+          __riscv_vsext_vf2_i16m2(__riscv_vle8_v_i8m1(rhs_ptr, vl), vl);
+      rhs_ptr += N0;
+      acc0 = __riscv_vwmacc_vx_i32m4(acc0, lhs_ptr[0], rhs, vl);
+      if (M0 >= 2) acc1 = __riscv_vwmacc_vx_i32m4(acc1, lhs_ptr[1], rhs, vl);
+      if (M0 >= 4) {
+        acc2 = __riscv_vwmacc_vx_i32m4(acc2, lhs_ptr[2], rhs, vl);
+        acc3 = __riscv_vwmacc_vx_i32m4(acc3, lhs_ptr[3], rhs, vl);
+      }
+      if (M0 >= 7) {
+        acc4 = __riscv_vwmacc_vx_i32m4(acc4, lhs_ptr[4], rhs, vl);
+        acc5 = __riscv_vwmacc_vx_i32m4(acc5, lhs_ptr[5], rhs, vl);
+        acc6 = __riscv_vwmacc_vx_i32m4(acc6, lhs_ptr[6], rhs, vl);
+      }
+      lhs_ptr += M0;
+    }
+    __riscv_vse32_v_i32m4(out_ptr + 0 * N0 + n, acc0, vl);
+    if (M0 >= 2) __riscv_vse32_v_i32m4(out_ptr + 1 * N0 + n, acc1, vl);
+    if (M0 >= 4) {
+      __riscv_vse32_v_i32m4(out_ptr + 2 * N0 + n, acc2, vl);
+      __riscv_vse32_v_i32m4(out_ptr + 3 * N0 + n, acc3, vl);
+    }
+    if (M0 >= 7) {
+      __riscv_vse32_v_i32m4(out_ptr + 4 * N0 + n, acc4, vl);
+      __riscv_vse32_v_i32m4(out_ptr + 5 * N0 + n, acc5, vl);
+      __riscv_vse32_v_i32m4(out_ptr + 6 * N0 + n, acc6, vl);
+    }
+    n += vl;
+  }
+}
+
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_s8s8s32_1x32x1_to_7x32x1_riscv_64,
+    iree_uk_mmt4d_tile_s8s8s32_1x32x1_riscv_64, 1)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_s8s8s32_1x32x1_to_7x32x1_riscv_64,
+    iree_uk_mmt4d_tile_s8s8s32_2x32x1_riscv_64, 2)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_s8s8s32_1x32x1_to_7x32x1_riscv_64,
+    iree_uk_mmt4d_tile_s8s8s32_4x32x1_riscv_64, 4)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_s8s8s32_1x32x1_to_7x32x1_riscv_64,
+    iree_uk_mmt4d_tile_s8s8s32_7x32x1_riscv_64, 7)
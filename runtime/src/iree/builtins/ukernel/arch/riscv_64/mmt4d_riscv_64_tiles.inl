@@ -12,3 +12,15 @@ IREE_UK_MMT4D_TILE(riscv_64, f32, f32, f32, 1, 32, 1, )
 IREE_UK_MMT4D_TILE(riscv_64, f32, f32, f32, 2, 32, 1, )
 IREE_UK_MMT4D_TILE(riscv_64, f32, f32, f32, 4, 32, 1, )
 IREE_UK_MMT4D_TILE(riscv_64, f32, f32, f32, 7, 32, 1, )
+IREE_UK_MMT4D_TILE(riscv_64, s8, s8, s32, 1, 32, 1, )
+IREE_UK_MMT4D_TILE(riscv_64, s8, s8, s32, 2, 32, 1, )
+IREE_UK_MMT4D_TILE(riscv_64, s8, s8, s32, 4, 32, 1, )
+IREE_UK_MMT4D_TILE(riscv_64, s8, s8, s32, 7, 32, 1, )
+IREE_UK_MMT4D_TILE(riscv_64, f16, f16, f32, 1, 32, 1, _zvfh)
+IREE_UK_MMT4D_TILE(riscv_64, f16, f16, f32, 2, 32, 1, _zvfh)
+IREE_UK_MMT4D_TILE(riscv_64, f16, f16, f32, 4, 32, 1, _zvfh)
+IREE_UK_MMT4D_TILE(riscv_64, f16, f16, f32, 7, 32, 1, _zvfh)
+IREE_UK_MMT4D_TILE(riscv_64, f16, f16, f16, 1, 32, 1, _zvfh)
+IREE_UK_MMT4D_TILE(riscv_64, f16, f16, f16, 2, 32, 1, _zvfh)
+IREE_UK_MMT4D_TILE(riscv_64, f16, f16, f16, 4, 32, 1, _zvfh)
+IREE_UK_MMT4D_TILE(riscv_64, f16, f16, f16, 7, 32, 1, _zvfh)
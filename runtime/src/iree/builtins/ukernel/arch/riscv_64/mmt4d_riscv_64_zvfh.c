@@ -0,0 +1,159 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/builtins/ukernel/arch/riscv_64/common_riscv_64.h"
+#include "iree/builtins/ukernel/arch/riscv_64/mmt4d_riscv_64_internal.h"
+
+// Widening f16 multiply-accumulate into f32 with vfwmacc.vf. Same structure and
+// vector-length-agnostic column chunking as the f32 kernel in
+// mmt4d_riscv_64_base.c, with the RHS row held at half the LMUL.
+IREE_UK_ATTRIBUTE_ALWAYS_INLINE static inline void
+iree_uk_mmt4d_tile_f16f16f32_1x32x1_to_7x32x1_riscv_64_zvfh(
+    void* IREE_UK_RESTRICT out_tile, const void* IREE_UK_RESTRICT lhs_panel,
+    const void* IREE_UK_RESTRICT rhs_panel,
+    const iree_uk_mmt4d_params_t* params, int M0) {
+  IREE_UK_ASSERT(M0 == 1 || M0 == 2 || M0 == 4 || M0 == 7);
+  const int N0 = 32;
+  float* IREE_UK_RESTRICT out_ptr = out_tile;
+  for (int n = 0; n < N0;) {
+    size_t vl = __riscv_vsetvl_e32m4(N0 - n);
+    vfloat32m4_t acc0 = __riscv_vfmv_v_f_f32m4(0.0f, vl);
+    vfloat32m4_t acc1 = acc0, acc2 = acc0, acc3 = acc0, acc4 = acc0,
+                 acc5 = acc0, acc6 = acc0;
+    if (params->flags & IREE_UK_FLAG_MMT4D_ACCUMULATE) {
+      acc0 = __riscv_vle32_v_f32m4(out_ptr + 0 * N0 + n, vl);
+      if (M0 >= 2) acc1 = __riscv_vle32_v_f32m4(out_ptr + 1 * N0 + n, vl);
+      if (M0 >= 4) {
+        acc2 = __riscv_vle32_v_f32m4(out_ptr + 2 * N0 + n, vl);
+        acc3 = __riscv_vle32_v_f32m4(out_ptr + 3 * N0 + n, vl);
+      }
+      if (M0 >= 7) {
+        acc4 = __riscv_vle32_v_f32m4(out_ptr + 4 * N0 + n, vl);
+        acc5 = __riscv_vle32_v_f32m4(out_ptr + 5 * N0 + n, vl);
+        acc6 = __riscv_vle32_v_f32m4(out_ptr + 6 * N0 + n, vl);
+      }
+    }
+    const _Float16* IREE_UK_RESTRICT lhs_ptr = lhs_panel;
+    const _Float16* IREE_UK_RESTRICT rhs_ptr = (const _Float16*)rhs_panel + n;
+    for (int k = 0; k < params->K; ++k) {
+      vfloat16m2_t rhs = __riscv_vle16_v_f16m2(rhs_ptr, vl);
+      rhs_ptr += N0;
+      acc0 = __riscv_vfwmacc_vf_f32m4(acc0, lhs_ptr[0], rhs, vl);
+      if (M0 >= 2) acc1 = __riscv_vfwmacc_vf_f32m4(acc1, lhs_ptr[1], rhs, vl);
+      if (M0 >= 4) {
+        acc2 = __riscv_vfwmacc_vf_f32m4(acc2, lhs_ptr[2], rhs, vl);
+        acc3 = __riscv_vfwmacc_vf_f32m4(acc3, lhs_ptr[3], rhs, vl);
+      }
+      if (M0 >= 7) {
+        acc4 = __riscv_vfwmacc_vf_f32m4(acc4, lhs_ptr[4], rhs, vl);
+        acc5 = __riscv_vfwmacc_vf_f32m4(acc5, lhs_ptr[5], rhs, vl);
+        acc6 = __riscv_vfwmacc_vf_f32m4(acc6, lhs_ptr[6], rhs, vl);
+      }
+      lhs_ptr += M0;
+    }
+    __riscv_vse32_v_f32m4(out_ptr + 0 * N0 + n, acc0, vl);
+    if (M0 >= 2) __riscv_vse32_v_f32m4(out_ptr + 1 * N0 + n, acc1, vl);
+    if (M0 >= 4) {
+      __riscv_vse32_v_f32m4(out_ptr + 2 * N0 + n, acc2, vl);
+      __riscv_vse32_v_f32m4(out_ptr + 3 * N0 + n, acc3, vl);
+    }
+    if (M0 >= 7) {
+      __riscv_vse32_v_f32m4(out_ptr + 4 * N0 + n, acc4, vl);
+      __riscv_vse32_v_f32m4(out_ptr + 5 * N0 + n, acc5, vl);
+      __riscv_vse32_v_f32m4(out_ptr + 6 * N0 + n, acc6, vl);
+    }
+    n += vl;
+  }
+}
+
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_f16f16f32_1x32x1_to_7x32x1_riscv_64_zvfh,
+    iree_uk_mmt4d_tile_f16f16f32_1x32x1_riscv_64_zvfh, 1)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_f16f16f32_1x32x1_to_7x32x1_riscv_64_zvfh,
+    iree_uk_mmt4d_tile_f16f16f32_2x32x1_riscv_64_zvfh, 2)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_f16f16f32_1x32x1_to_7x32x1_riscv_64_zvfh,
+    iree_uk_mmt4d_tile_f16f16f32_4x32x1_riscv_64_zvfh, 4)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_f16f16f32_1x32x1_to_7x32x1_riscv_64_zvfh,
+    iree_uk_mmt4d_tile_f16f16f32_7x32x1_riscv_64_zvfh, 7)
+
+// Accumulates in f16 with vfmacc.vf, so this performs intermediate roundings
+// and is valid regardless of IREE_UK_FLAG_MMT4D_SKIP_INTERMEDIATE_ROUNDINGS.
+// The f16 accumulators allow LMUL=4 to cover all N0 == 32 columns in a single
+// chunk from VLEN == 128 up.
+IREE_UK_ATTRIBUTE_ALWAYS_INLINE static inline void
+iree_uk_mmt4d_tile_f16f16f16_1x32x1_to_7x32x1_riscv_64_zvfh(
+    void* IREE_UK_RESTRICT out_tile, const void* IREE_UK_RESTRICT lhs_panel,
+    const void* IREE_UK_RESTRICT rhs_panel,
+    const iree_uk_mmt4d_params_t* params, int M0) {
+  IREE_UK_ASSERT(M0 == 1 || M0 == 2 || M0 == 4 || M0 == 7);
+  const int N0 = 32;
+  _Float16* IREE_UK_RESTRICT out_ptr = out_tile;
+  for (int n = 0; n < N0;) {
+    size_t vl = __riscv_vsetvl_e16m4(N0 - n);
+    vfloat16m4_t acc0 = __riscv_vfmv_v_f_f16m4(0, vl);
+    vfloat16m4_t acc1 = acc0, acc2 = acc0, acc3 = acc0, acc4 = acc0,
+                 acc5 = acc0, acc6 = acc0;
+    if (params->flags & IREE_UK_FLAG_MMT4D_ACCUMULATE) {
+      acc0 = __riscv_vle16_v_f16m4(out_ptr + 0 * N0 + n, vl);
+      if (M0 >= 2) acc1 = __riscv_vle16_v_f16m4(out_ptr + 1 * N0 + n, vl);
+      if (M0 >= 4) {
+        acc2 = __riscv_vle16_v_f16m4(out_ptr + 2 * N0 + n, vl);
+        acc3 = __riscv_vle16_v_f16m4(out_ptr + 3 * N0 + n, vl);
+      }
+      if (M0 >= 7) {
+        acc4 = __riscv_vle16_v_f16m4(out_ptr + 4 * N0 + n, vl);
+        acc5 = __riscv_vle16_v_f16m4(out_ptr + 5 * N0 + n, vl);
+        acc6 = __riscv_vle16_v_f16m4(out_ptr + 6 * N0 + n, vl);
+      }
+    }
+    const _Float16* IREE_UK_RESTRICT lhs_ptr = lhs_panel;
+    const _Float16* IREE_UK_RESTRICT rhs_ptr = (const _Float16*)rhs_panel + n;
+    for (int k = 0; k < params->K; ++k) {
+      vfloat16m4_t rhs = __riscv_vle16_v_f16m4(rhs_ptr, vl);
+      rhs_ptr += N0;
+      acc0 = __riscv_vfmacc_vf_f16m4(acc0, lhs_ptr[0], rhs, vl);
+      if (M0 >= 2) acc1 = __riscv_vfmacc_vf_f16m4(acc1, lhs_ptr[1], rhs, vl);
+      if (M0 >= 4) {
+        acc2 = __riscv_vfmacc_vf_f16m4(acc2, lhs_ptr[2], rhs, vl);
+        acc3 = __riscv_vfmacc_vf_f16m4(acc3, lhs_ptr[3], rhs, vl);
+      }
+      if (M0 >= 7) {
+        acc4 = __riscv_vfmacc_vf_f16m4(acc4, lhs_ptr[4], rhs, vl);
+        acc5 = __riscv_vfmacc_vf_f16m4(acc5, lhs_ptr[5], rhs, vl);
+        acc6 = __riscv_vfmacc_vf_f16m4(acc6, lhs_ptr[6], rhs, vl);
+      }
+      lhs_ptr += M0;
+    }
+    __riscv_vse16_v_f16m4(out_ptr + 0 * N0 + n, acc0, vl);
+    if (M0 >= 2) __riscv_vse16_v_f16m4(out_ptr + 1 * N0 + n, acc1, vl);
+    if (M0 >= 4) {
+      __riscv_vse16_v_f16m4(out_ptr + 2 * N0 + n, acc2, vl);
+      __riscv_vse16_v_f16m4(out_ptr + 3 * N0 + n, acc3, vl);
+    }
+    if (M0 >= 7) {
+      __riscv_vse16_v_f16m4(out_ptr + 4 * N0 + n, acc4, vl);
+      __riscv_vse16_v_f16m4(out_ptr + 5 * N0 + n, acc5, vl);
+      __riscv_vse16_v_f16m4(out_ptr + 6 * N0 + n, acc6, vl);
+    }
+    n += vl;
+  }
+}
+
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_f16f16f16_1x32x1_to_7x32x1_riscv_64_zvfh,
+    iree_uk_mmt4d_tile_f16f16f16_1x32x1_riscv_64_zvfh, 1)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_f16f16f16_1x32x1_to_7x32x1_riscv_64_zvfh,
+    iree_uk_mmt4d_tile_f16f16f16_2x32x1_riscv_64_zvfh, 2)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_f16f16f16_1x32x1_to_7x32x1_riscv_64_zvfh,
+    iree_uk_mmt4d_tile_f16f16f16_4x32x1_riscv_64_zvfh, 4)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_f16f16f16_1x32x1_to_7x32x1_riscv_64_zvfh,
+    iree_uk_mmt4d_tile_f16f16f16_7x32x1_riscv_64_zvfh, 7)
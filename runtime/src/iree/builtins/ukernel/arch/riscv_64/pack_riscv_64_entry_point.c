@@ -0,0 +1,29 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/builtins/ukernel/arch/riscv_64/common_riscv_64.h"
+#include "iree/builtins/ukernel/arch/riscv_64/pack_riscv_64_internal.h"
+
+iree_uk_pack_tile_func_t iree_uk_pack_select_tile_func_arch(
+    const iree_uk_pack_params_t* params) {
+  // As on other architectures, only the element type size matters. The RVV
+  // tile functions are vector-length-agnostic and take the tile shape as a
+  // runtime parameter, so they are selected for any tile shape.
+  iree_uk_pack_type_t pack_type = iree_uk_pack_type(params->flags);
+  int esize = iree_uk_type_size(iree_uk_pack_out_type(pack_type));
+  bool transpose = params->flags & IREE_UK_FLAG_PACK_TRANSPOSE_INNER;
+  if (esize == 4) {
+    return transpose ? iree_uk_pack_tile_x32_riscv_64_transpose
+                     : iree_uk_pack_tile_x32_riscv_64_direct;
+  } else if (esize == 2) {
+    return transpose ? iree_uk_pack_tile_x16_riscv_64_transpose
+                     : iree_uk_pack_tile_x16_riscv_64_direct;
+  } else if (esize == 1) {
+    return transpose ? iree_uk_pack_tile_x8_riscv_64_transpose
+                     : iree_uk_pack_tile_x8_riscv_64_direct;
+  }
+  return 0;
+}
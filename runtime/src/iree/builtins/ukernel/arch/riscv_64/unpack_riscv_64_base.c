@@ -0,0 +1,91 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/builtins/ukernel/arch/riscv_64/common_riscv_64.h"
+#include "iree/builtins/ukernel/arch/riscv_64/unpack_riscv_64_internal.h"
+
+IREE_UK_ATTRIBUTE_ALWAYS_INLINE static inline void
+iree_uk_unpack_tile_riscv_64_direct(void* IREE_UK_RESTRICT out_tile_ptr,
+                                    const void* IREE_UK_RESTRICT in_tile_ptr,
+                                    iree_uk_index_t outer_size1,
+                                    iree_uk_index_t out_stride0,
+                                    iree_uk_index_t in_stride1,
+                                    iree_uk_index_t elem_size,
+                                    iree_uk_index_t tile_size0,
+                                    iree_uk_index_t tile_size1) {
+  char* IREE_UK_RESTRICT out_ptr = out_tile_ptr;
+  const char* IREE_UK_RESTRICT in_ptr = in_tile_ptr;
+  if (tile_size1 == 1) {
+    // Single-column tiles: the inverse of the corresponding pack case, a
+    // strided load across all outer_size1 tiles and a contiguous store.
+    for (iree_uk_index_t tile_i0 = 0; tile_i0 < tile_size0; ++tile_i0) {
+      iree_uk_riscv_64_copy_strided(out_ptr + tile_i0 * out_stride0 * elem_size,
+                                    1, in_ptr + tile_i0 * elem_size,
+                                    in_stride1, outer_size1, elem_size);
+    }
+    return;
+  }
+  for (iree_uk_index_t outer_i1 = 0; outer_i1 < outer_size1; ++outer_i1) {
+    for (iree_uk_index_t tile_i0 = 0; tile_i0 < tile_size0; ++tile_i0) {
+      iree_uk_riscv_64_copy_strided(
+          out_ptr + tile_i0 * out_stride0 * elem_size, 1,
+          in_ptr + tile_i0 * tile_size1 * elem_size, 1, tile_size1, elem_size);
+    }
+    out_ptr += tile_size1 * elem_size;
+    in_ptr += in_stride1 * elem_size;
+  }
+}
+
+IREE_UK_ATTRIBUTE_ALWAYS_INLINE static inline void
+iree_uk_unpack_tile_riscv_64_transpose(void* IREE_UK_RESTRICT out_tile_ptr,
+                                       const void* IREE_UK_RESTRICT in_tile_ptr,
+                                       iree_uk_index_t outer_size1,
+                                       iree_uk_index_t out_stride0,
+                                       iree_uk_index_t in_stride1,
+                                       iree_uk_index_t elem_size,
+                                       iree_uk_index_t tile_size0,
+                                       iree_uk_index_t tile_size1) {
+  if (tile_size1 == 1) {
+    // Transposing a single-column tile does not change its layout.
+    iree_uk_unpack_tile_riscv_64_direct(out_tile_ptr, in_tile_ptr, outer_size1,
+                                        out_stride0, in_stride1, elem_size,
+                                        tile_size0, tile_size1);
+    return;
+  }
+  char* IREE_UK_RESTRICT out_ptr = out_tile_ptr;
+  const char* IREE_UK_RESTRICT in_ptr = in_tile_ptr;
+  for (iree_uk_index_t outer_i1 = 0; outer_i1 < outer_size1; ++outer_i1) {
+    // Each contiguous row of the transposed tile becomes a destination column.
+    for (iree_uk_index_t tile_i1 = 0; tile_i1 < tile_size1; ++tile_i1) {
+      iree_uk_riscv_64_copy_strided(
+          out_ptr + tile_i1 * elem_size, out_stride0,
+          in_ptr + tile_i1 * tile_size0 * elem_size, 1, tile_size0, elem_size);
+    }
+    out_ptr += tile_size1 * elem_size;
+    in_ptr += in_stride1 * elem_size;
+  }
+}
+
+#define IREE_UK_UNPACK_TILE_RISCV_64_IMPL(BITS, VARIANT)                     \
+  void iree_uk_unpack_tile_x##BITS##_riscv_64_##VARIANT(                     \
+      void* IREE_UK_RESTRICT out_tile_ptr,                                   \
+      const void* IREE_UK_RESTRICT in_tile_ptr,                              \
+      iree_uk_index_t outer_size1, iree_uk_index_t out_stride0,              \
+      iree_uk_index_t in_stride1, iree_uk_index_t elem_size,                 \
+      iree_uk_index_t tile_size0, iree_uk_index_t tile_size1) {              \
+    IREE_UK_ASSERT(elem_size == BITS / 8);                                   \
+    iree_uk_unpack_tile_riscv_64_##VARIANT(out_tile_ptr, in_tile_ptr,        \
+                                           outer_size1, out_stride0,         \
+                                           in_stride1, BITS / 8, tile_size0, \
+                                           tile_size1);                      \
+  }
+
+IREE_UK_UNPACK_TILE_RISCV_64_IMPL(8, direct)
+IREE_UK_UNPACK_TILE_RISCV_64_IMPL(16, direct)
+IREE_UK_UNPACK_TILE_RISCV_64_IMPL(32, direct)
+IREE_UK_UNPACK_TILE_RISCV_64_IMPL(8, transpose)
+IREE_UK_UNPACK_TILE_RISCV_64_IMPL(16, transpose)
+IREE_UK_UNPACK_TILE_RISCV_64_IMPL(32, transpose)
@@ -0,0 +1,27 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/builtins/ukernel/arch/riscv_64/common_riscv_64.h"
+#include "iree/builtins/ukernel/arch/riscv_64/unpack_riscv_64_internal.h"
+
+iree_uk_unpack_tile_func_t iree_uk_unpack_select_tile_func_arch(
+    const iree_uk_unpack_params_t* params) {
+  // See the comment in iree_uk_pack_select_tile_func_arch.
+  iree_uk_unpack_type_t unpack_type = iree_uk_unpack_type(params->flags);
+  int esize = iree_uk_type_size(iree_uk_unpack_out_type(unpack_type));
+  bool transpose = params->flags & IREE_UK_FLAG_UNPACK_TRANSPOSE_INNER;
+  if (esize == 4) {
+    return transpose ? iree_uk_unpack_tile_x32_riscv_64_transpose
+                     : iree_uk_unpack_tile_x32_riscv_64_direct;
+  } else if (esize == 2) {
+    return transpose ? iree_uk_unpack_tile_x16_riscv_64_transpose
+                     : iree_uk_unpack_tile_x16_riscv_64_direct;
+  } else if (esize == 1) {
+    return transpose ? iree_uk_unpack_tile_x8_riscv_64_transpose
+                     : iree_uk_unpack_tile_x8_riscv_64_direct;
+  }
+  return 0;
+}
@@ -18,6 +18,9 @@
 #define IREE_UK_BUILD_X86_64_AVX512_BASE
 #define IREE_UK_BUILD_X86_64_AVX512_VNNI
 #define IREE_UK_BUILD_X86_64_AVX512_BF16
+#define IREE_UK_BUILD_X86_64_AVX512_FP16
+#define IREE_UK_BUILD_X86_64_AMX_INT8
+#define IREE_UK_BUILD_X86_64_AMX_BF16
 #else  // IREE_DEVICE_STANDALONE
 // Compiling with the system toolchain. Include the configured header.
 #include "iree/builtins/ukernel/arch/x86_64/config_x86_64.h"
@@ -52,6 +55,28 @@ static inline bool iree_uk_cpu_x86_64_avx512_bf16(
          iree_uk_all_bits_set(cpu_data[0], IREE_CPU_DATA0_X86_64_AVX512BF16);
 }
 
+static inline bool iree_uk_cpu_x86_64_avx512_fp16(
+    const iree_uk_uint64_t* cpu_data) {
+  return iree_uk_cpu_x86_64_avx512_base(cpu_data) &&
+         iree_uk_all_bits_set(cpu_data[0], IREE_CPU_DATA0_X86_64_AVX512FP16);
+}
+
+// The AMX code paths also use AVX-512 to relayout operands. All CPUs with AMX
+// so far (Intel Sapphire Rapids (2023) and newer) also have AVX-512-BF16.
+static inline bool iree_uk_cpu_x86_64_amx_int8(
+    const iree_uk_uint64_t* cpu_data) {
+  return iree_uk_cpu_x86_64_avx512_base(cpu_data) &&
+         iree_uk_all_bits_set(cpu_data[0], IREE_CPU_DATA0_X86_64_AMXTILE |
+                                               IREE_CPU_DATA0_X86_64_AMXINT8);
+}
+
+static inline bool iree_uk_cpu_x86_64_amx_bf16(
+    const iree_uk_uint64_t* cpu_data) {
+  return iree_uk_cpu_x86_64_avx512_bf16(cpu_data) &&
+         iree_uk_all_bits_set(cpu_data[0], IREE_CPU_DATA0_X86_64_AMXTILE |
+                                               IREE_CPU_DATA0_X86_64_AMXBF16);
+}
+
 #if defined(__AVX2__)
 
 static inline __m256i iree_uk_avx_loadu_2x128(const void* src0,
@@ -78,6 +103,15 @@ static inline void iree_uk_copy_8x32xi8_strided_to_strided(
   }
 }
 
+static inline void iree_uk_copy_16x32xi8_strided_to_strided(
+    iree_uk_int8_t* IREE_UK_RESTRICT out_ptr,
+    const iree_uk_int8_t* IREE_UK_RESTRICT in_ptr, iree_uk_index_t out_stride,
+    iree_uk_index_t in_stride) {
+  for (int i = 0; i < 16; ++i) {
+    iree_uk_memcpy(out_ptr + i * out_stride, in_ptr + i * in_stride, 32);
+  }
+}
+
 static inline void iree_uk_copy_16x64xi8_strided_to_strided(
     iree_uk_int8_t* IREE_UK_RESTRICT out_ptr,
     const iree_uk_int8_t* IREE_UK_RESTRICT in_ptr, iree_uk_index_t out_stride,
@@ -446,6 +480,57 @@ iree_uk_avx512_copy_16x16xi8_tiled_1x2_transpose_strided_to_strided(
       r0123456701234567_3);
 }
 
+#if defined(__AMX_TILE__)
+
+// Tile configuration in the memory format expected by LDTILECFG.
+// See the Intel SDM, Vol. 2, "LDTILECFG - Load Tile Configuration".
+typedef struct iree_uk_amx_tile_config_t {
+  iree_uk_uint8_t palette_id;
+  iree_uk_uint8_t start_row;
+  iree_uk_uint8_t reserved[14];
+  iree_uk_uint16_t colsb[16];
+  iree_uk_uint8_t rows[16];
+} iree_uk_amx_tile_config_t;
+
+// Tile registers used by the AMX mmt4d tile functions. These must be macros
+// and not enumerators as the intrinsics stringify them into the instruction.
+#define IREE_UK_AMX_TILE_ACC 0
+#define IREE_UK_AMX_TILE_LHS 1
+#define IREE_UK_AMX_TILE_RHS 2
+
+// Configures the tiles for an mmt4d tile function computing a M0x16 tile with
+// 32-bit accumulators from a M0x32-byte LHS tile and a 16x32-byte RHS tile:
+//   ACC: M0 rows of 16 32-bit accumulators.
+//   LHS: M0 rows of 32 bytes (the LHS tile as-is).
+//   RHS: 8 rows of 64 bytes (the RHS tile in VNNI layout, see
+//        iree_uk_amx_copy_16x32xi8_to_vnni).
+static inline void iree_uk_amx_configure_mmt4d_tiles(int M0) {
+  iree_uk_amx_tile_config_t config IREE_UK_ATTRIBUTE_ALIGNED(64) = {0};
+  config.palette_id = 1;
+  config.rows[IREE_UK_AMX_TILE_ACC] = M0;
+  config.colsb[IREE_UK_AMX_TILE_ACC] = 64;
+  config.rows[IREE_UK_AMX_TILE_LHS] = M0;
+  config.colsb[IREE_UK_AMX_TILE_LHS] = 32;
+  config.rows[IREE_UK_AMX_TILE_RHS] = 8;
+  config.colsb[IREE_UK_AMX_TILE_RHS] = 64;
+  _tile_loadconfig(&config);
+}
+
+// Copies a 16x32-byte RHS tile (16 rows of N, each with 32 bytes along K) to
+// the 8x64-byte layout expected by the second source of TDPBSSD/TDPBF16PS,
+// where row k holds the 4-byte groups (4 x i8 or 2 x bf16) of K-group k of
+// all 16 columns. That is a 16x8 transpose of 32-bit elements.
+static inline void iree_uk_amx_copy_16x32xi8_to_vnni(
+    iree_uk_int8_t* IREE_UK_RESTRICT out_ptr,
+    const iree_uk_int8_t* IREE_UK_RESTRICT in_ptr) {
+  iree_uk_avx512_copy_16x16xi8_tiled_1x4_transpose_strided_to_strided(
+      out_ptr, in_ptr, 64, 32);
+  iree_uk_avx512_copy_16x16xi8_tiled_1x4_transpose_strided_to_strided(
+      out_ptr + 4 * 64, in_ptr + 16, 64, 32);
+}
+
+#endif  // defined(__AMX_TILE__)
+
 #endif  // defined (__AVX512F__)
 
 #endif  // defined(__AVX2__)
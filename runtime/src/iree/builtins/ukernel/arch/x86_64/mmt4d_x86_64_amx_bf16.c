@@ -0,0 +1,113 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/builtins/ukernel/arch/x86_64/common_x86_64.h"
+#include "iree/builtins/ukernel/arch/x86_64/mmt4d_x86_64_internal.h"
+
+// Same structure as the AMX-INT8 tile function: the LHS tile (M0 rows of 16
+// bf16 along K) is used as-is and the RHS tile is transposed in bf16 pairs to
+// the VNNI layout on each K step. TDPBF16PS only accumulates into f32 so bf16
+// accumulators are converted through a f32 stack buffer on entry and exit.
+static inline void
+iree_uk_mmt4d_tile_bf16bf16fXX_1x16x16_to_16x16x16_x86_64_amx_bf16(
+    void* IREE_UK_RESTRICT out_tile, const void* IREE_UK_RESTRICT lhs_panel,
+    const void* IREE_UK_RESTRICT rhs_panel,
+    const iree_uk_mmt4d_params_t* params, iree_uk_type_t acc_type, int M0) {
+  IREE_UK_ASSERT(acc_type == IREE_UK_TYPE_FLOAT_32 ||
+                 acc_type == IREE_UK_TYPE_BFLOAT_16);
+  IREE_UK_ASSERT(M0 >= 1 && M0 <= 16 && iree_uk_is_po2_u32(M0));
+  const iree_uk_int8_t* IREE_UK_RESTRICT lhs_ptr = lhs_panel;
+  const iree_uk_int8_t* IREE_UK_RESTRICT rhs_ptr = rhs_panel;
+  iree_uk_int8_t rhs_vnni[8 * 64] IREE_UK_ATTRIBUTE_ALIGNED(64);
+  float acc_buffer[16 * 16] IREE_UK_ATTRIBUTE_ALIGNED(64);
+  float* IREE_UK_RESTRICT acc_ptr =
+      acc_type == IREE_UK_TYPE_FLOAT_32 ? (float*)out_tile : acc_buffer;
+
+  iree_uk_amx_configure_mmt4d_tiles(M0);
+  if (params->flags & IREE_UK_FLAG_MMT4D_ACCUMULATE) {
+    if (acc_type == IREE_UK_TYPE_BFLOAT_16) {
+      const iree_uk_uint16_t* IREE_UK_RESTRICT out_ptr = out_tile;
+      for (int i = 0; i < M0; ++i) {
+        __m256i loaded = _mm256_loadu_si256((const __m256i*)(out_ptr + i * 16));
+        _mm512_store_ps(acc_buffer + i * 16,
+                        _mm512_cvtpbh_ps(*(const __m256bh*)&loaded));
+      }
+    }
+    _tile_loadd(IREE_UK_AMX_TILE_ACC, acc_ptr, 16 * sizeof(float));
+  } else {
+    _tile_zero(IREE_UK_AMX_TILE_ACC);
+  }
+  for (iree_uk_int32_t k = 0; k < params->K; ++k) {
+    iree_uk_amx_copy_16x32xi8_to_vnni(rhs_vnni, rhs_ptr);
+    _tile_loadd(IREE_UK_AMX_TILE_LHS, lhs_ptr, 32);
+    _tile_loadd(IREE_UK_AMX_TILE_RHS, rhs_vnni, 64);
+    _tile_dpbf16ps(IREE_UK_AMX_TILE_ACC, IREE_UK_AMX_TILE_LHS,
+                   IREE_UK_AMX_TILE_RHS);
+    lhs_ptr += M0 * 32;
+    rhs_ptr += 16 * 32;
+  }
+  _tile_stored(IREE_UK_AMX_TILE_ACC, acc_ptr, 16 * sizeof(float));
+  _tile_release();
+  if (acc_type == IREE_UK_TYPE_BFLOAT_16) {
+    iree_uk_uint16_t* IREE_UK_RESTRICT out_ptr = out_tile;
+    for (int i = 0; i < M0; ++i) {
+      __m256bh converted =
+          _mm512_cvtneps_pbh(_mm512_load_ps(acc_buffer + i * 16));
+      _mm256_storeu_si256((__m256i*)(out_ptr + i * 16),
+                          *(const __m256i*)&converted);
+    }
+  }
+}
+
+static inline void
+iree_uk_mmt4d_tile_bf16bf16f32_1x16x16_to_16x16x16_x86_64_amx_bf16(
+    void* IREE_UK_RESTRICT out_tile, const void* IREE_UK_RESTRICT lhs_panel,
+    const void* IREE_UK_RESTRICT rhs_panel,
+    const iree_uk_mmt4d_params_t* params, int M0) {
+  iree_uk_mmt4d_tile_bf16bf16fXX_1x16x16_to_16x16x16_x86_64_amx_bf16(
+      out_tile, lhs_panel, rhs_panel, params, IREE_UK_TYPE_FLOAT_32, M0);
+}
+
+static inline void
+iree_uk_mmt4d_tile_bf16bf16bf16_1x16x16_to_16x16x16_x86_64_amx_bf16(
+    void* IREE_UK_RESTRICT out_tile, const void* IREE_UK_RESTRICT lhs_panel,
+    const void* IREE_UK_RESTRICT rhs_panel,
+    const iree_uk_mmt4d_params_t* params, int M0) {
+  iree_uk_mmt4d_tile_bf16bf16fXX_1x16x16_to_16x16x16_x86_64_amx_bf16(
+      out_tile, lhs_panel, rhs_panel, params, IREE_UK_TYPE_BFLOAT_16, M0);
+}
+
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16f32_1x16x16_to_16x16x16_x86_64_amx_bf16,
+    iree_uk_mmt4d_tile_bf16bf16f32_1x16x16_x86_64_amx_bf16, 1)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16f32_1x16x16_to_16x16x16_x86_64_amx_bf16,
+    iree_uk_mmt4d_tile_bf16bf16f32_2x16x16_x86_64_amx_bf16, 2)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16f32_1x16x16_to_16x16x16_x86_64_amx_bf16,
+    iree_uk_mmt4d_tile_bf16bf16f32_4x16x16_x86_64_amx_bf16, 4)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16f32_1x16x16_to_16x16x16_x86_64_amx_bf16,
+    iree_uk_mmt4d_tile_bf16bf16f32_8x16x16_x86_64_amx_bf16, 8)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16f32_1x16x16_to_16x16x16_x86_64_amx_bf16,
+    iree_uk_mmt4d_tile_bf16bf16f32_16x16x16_x86_64_amx_bf16, 16)
+
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16bf16_1x16x16_to_16x16x16_x86_64_amx_bf16,
+    iree_uk_mmt4d_tile_bf16bf16bf16_1x16x16_x86_64_amx_bf16, 1)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16bf16_1x16x16_to_16x16x16_x86_64_amx_bf16,
+    iree_uk_mmt4d_tile_bf16bf16bf16_2x16x16_x86_64_amx_bf16, 2)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16bf16_1x16x16_to_16x16x16_x86_64_amx_bf16,
+    iree_uk_mmt4d_tile_bf16bf16bf16_4x16x16_x86_64_amx_bf16, 4)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16bf16_1x16x16_to_16x16x16_x86_64_amx_bf16,
+    iree_uk_mmt4d_tile_bf16bf16bf16_8x16x16_x86_64_amx_bf16, 8)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_bf16bf16bf16_1x16x16_to_16x16x16_x86_64_amx_bf16,
+    iree_uk_mmt4d_tile_bf16bf16bf16_16x16x16_x86_64_amx_bf16, 16)
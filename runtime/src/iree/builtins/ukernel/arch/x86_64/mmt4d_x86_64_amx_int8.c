@@ -0,0 +1,62 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/builtins/ukernel/arch/x86_64/common_x86_64.h"
+#include "iree/builtins/ukernel/arch/x86_64/mmt4d_x86_64_internal.h"
+
+// The LHS tile (M0 rows of 32 i8 along K) is directly usable as the first
+// source of TDPBSSD. The RHS tile (16 rows of N, 32 i8 along K each) has to be
+// transposed in 4-byte groups to the VNNI layout of the second source, which
+// is done on each K step with AVX-512 into a small stack buffer.
+//
+// Tiles are configured on entry and released on exit so that no AMX state is
+// live outside of the tile function: a thread holding dirty AMX state makes
+// every context switch save and restore 8 KiB of tile data.
+static inline void
+iree_uk_mmt4d_tile_s8s8s32_1x16x32_to_16x16x32_x86_64_amx_int8(
+    void* IREE_UK_RESTRICT out_tile, const void* IREE_UK_RESTRICT lhs_panel,
+    const void* IREE_UK_RESTRICT rhs_panel,
+    const iree_uk_mmt4d_params_t* params, int M0) {
+  IREE_UK_ASSERT(M0 >= 1 && M0 <= 16 && iree_uk_is_po2_u32(M0));
+  iree_uk_int32_t* IREE_UK_RESTRICT out_ptr = out_tile;
+  const iree_uk_int8_t* IREE_UK_RESTRICT lhs_ptr = lhs_panel;
+  const iree_uk_int8_t* IREE_UK_RESTRICT rhs_ptr = rhs_panel;
+  iree_uk_int8_t rhs_vnni[8 * 64] IREE_UK_ATTRIBUTE_ALIGNED(64);
+
+  iree_uk_amx_configure_mmt4d_tiles(M0);
+  if (params->flags & IREE_UK_FLAG_MMT4D_ACCUMULATE) {
+    _tile_loadd(IREE_UK_AMX_TILE_ACC, out_ptr, 16 * sizeof(iree_uk_int32_t));
+  } else {
+    _tile_zero(IREE_UK_AMX_TILE_ACC);
+  }
+  for (iree_uk_int32_t k = 0; k < params->K; ++k) {
+    iree_uk_amx_copy_16x32xi8_to_vnni(rhs_vnni, rhs_ptr);
+    _tile_loadd(IREE_UK_AMX_TILE_LHS, lhs_ptr, 32);
+    _tile_loadd(IREE_UK_AMX_TILE_RHS, rhs_vnni, 64);
+    _tile_dpbssd(IREE_UK_AMX_TILE_ACC, IREE_UK_AMX_TILE_LHS,
+                 IREE_UK_AMX_TILE_RHS);
+    lhs_ptr += M0 * 32;
+    rhs_ptr += 16 * 32;
+  }
+  _tile_stored(IREE_UK_AMX_TILE_ACC, out_ptr, 16 * sizeof(iree_uk_int32_t));
+  _tile_release();
+}
+
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_s8s8s32_1x16x32_to_16x16x32_x86_64_amx_int8,
+    iree_uk_mmt4d_tile_s8s8s32_1x16x32_x86_64_amx_int8, 1)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_s8s8s32_1x16x32_to_16x16x32_x86_64_amx_int8,
+    iree_uk_mmt4d_tile_s8s8s32_2x16x32_x86_64_amx_int8, 2)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_s8s8s32_1x16x32_to_16x16x32_x86_64_amx_int8,
+    iree_uk_mmt4d_tile_s8s8s32_4x16x32_x86_64_amx_int8, 4)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_s8s8s32_1x16x32_to_16x16x32_x86_64_amx_int8,
+    iree_uk_mmt4d_tile_s8s8s32_8x16x32_x86_64_amx_int8, 8)
+IREE_UK_MMT4D_TILE_FUNC_IMPL_FOR_M0(
+    iree_uk_mmt4d_tile_s8s8s32_1x16x32_to_16x16x32_x86_64_amx_int8,
+    iree_uk_mmt4d_tile_s8s8s32_16x16x32_x86_64_amx_int8, 16)
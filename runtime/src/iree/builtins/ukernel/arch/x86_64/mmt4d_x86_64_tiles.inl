@@ -47,6 +47,11 @@ IREE_UK_MMT4D_TILE(x86_64, f16, f16, f16, 2, 16, 1, _avx512_base)
 IREE_UK_MMT4D_TILE(x86_64, f16, f16, f16, 4, 16, 1, _avx512_base)
 IREE_UK_MMT4D_TILE(x86_64, f16, f16, f16, 8, 16, 1, _avx512_base)
 IREE_UK_MMT4D_TILE(x86_64, f16, f16, f16, 16, 16, 1, _avx512_base)
+IREE_UK_MMT4D_TILE(x86_64, f16, f16, f16, 1, 32, 1, _avx512_fp16)
+IREE_UK_MMT4D_TILE(x86_64, f16, f16, f16, 2, 32, 1, _avx512_fp16)
+IREE_UK_MMT4D_TILE(x86_64, f16, f16, f16, 4, 32, 1, _avx512_fp16)
+IREE_UK_MMT4D_TILE(x86_64, f16, f16, f16, 8, 32, 1, _avx512_fp16)
+IREE_UK_MMT4D_TILE(x86_64, f16, f16, f16, 16, 32, 1, _avx512_fp16)
 IREE_UK_MMT4D_TILE(x86_64, bf16, bf16, bf16, 1, 16, 2, _avx512_bf16)
 IREE_UK_MMT4D_TILE(x86_64, bf16, bf16, bf16, 2, 16, 2, _avx512_bf16)
 IREE_UK_MMT4D_TILE(x86_64, bf16, bf16, bf16, 4, 16, 2, _avx512_bf16)
@@ -73,3 +78,18 @@ IREE_UK_MMT4D_TILE(x86_64, s16, s16, s32, 4, 16, 2, _avx512_vnni)
 IREE_UK_MMT4D_TILE(x86_64, s16, s16, s32, 8, 16, 2, _avx512_vnni)
 IREE_UK_MMT4D_TILE(x86_64, s16, s16, s32, 16, 16, 2, _avx512_vnni)
 IREE_UK_MMT4D_TILE(x86_64, s16, u4, s32, 1, 32, 8, _avx512_vnni)
+IREE_UK_MMT4D_TILE(x86_64, s8, s8, s32, 1, 16, 32, _amx_int8)
+IREE_UK_MMT4D_TILE(x86_64, s8, s8, s32, 2, 16, 32, _amx_int8)
+IREE_UK_MMT4D_TILE(x86_64, s8, s8, s32, 4, 16, 32, _amx_int8)
+IREE_UK_MMT4D_TILE(x86_64, s8, s8, s32, 8, 16, 32, _amx_int8)
+IREE_UK_MMT4D_TILE(x86_64, s8, s8, s32, 16, 16, 32, _amx_int8)
+IREE_UK_MMT4D_TILE(x86_64, bf16, bf16, f32, 1, 16, 16, _amx_bf16)
+IREE_UK_MMT4D_TILE(x86_64, bf16, bf16, f32, 2, 16, 16, _amx_bf16)
+IREE_UK_MMT4D_TILE(x86_64, bf16, bf16, f32, 4, 16, 16, _amx_bf16)
+IREE_UK_MMT4D_TILE(x86_64, bf16, bf16, f32, 8, 16, 16, _amx_bf16)
+IREE_UK_MMT4D_TILE(x86_64, bf16, bf16, f32, 16, 16, 16, _amx_bf16)
+IREE_UK_MMT4D_TILE(x86_64, bf16, bf16, bf16, 1, 16, 16, _amx_bf16)
+IREE_UK_MMT4D_TILE(x86_64, bf16, bf16, bf16, 2, 16, 16, _amx_bf16)
+IREE_UK_MMT4D_TILE(x86_64, bf16, bf16, bf16, 4, 16, 16, _amx_bf16)
+IREE_UK_MMT4D_TILE(x86_64, bf16, bf16, bf16, 8, 16, 16, _amx_bf16)
+IREE_UK_MMT4D_TILE(x86_64, bf16, bf16, bf16, 16, 16, 16, _amx_bf16)
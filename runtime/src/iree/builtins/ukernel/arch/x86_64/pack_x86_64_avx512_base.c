@@ -203,3 +203,72 @@ void iree_uk_pack_tile_16x2_x8_x86_64_avx512_base_transpose(
     in_ptr += 16;
   }
 }
+
+void iree_uk_pack_tile_16x1_x16_x86_64_avx512_base_direct(
+    void* IREE_UK_RESTRICT out_tile_ptr,
+    const void* IREE_UK_RESTRICT in_tile_ptr, iree_uk_index_t outer_size1,
+    iree_uk_index_t out_stride1, iree_uk_index_t in_stride0,
+    iree_uk_index_t elem_size, iree_uk_index_t tile_size0,
+    iree_uk_index_t tile_size1) {
+  IREE_UK_ASSERT(elem_size == 2);
+  IREE_UK_ASSERT(tile_size0 == 16);
+  IREE_UK_ASSERT(tile_size1 == 1);
+  iree_uk_pack_tile_16x2_x8_x86_64_avx512_base_direct(
+      out_tile_ptr, in_tile_ptr, outer_size1, out_stride1 * 2, in_stride0 * 2,
+      1, 16, 2);
+}
+
+void iree_uk_pack_tile_16x1_x16_x86_64_avx512_base_transpose(
+    void* IREE_UK_RESTRICT out_tile_ptr,
+    const void* IREE_UK_RESTRICT in_tile_ptr, iree_uk_index_t outer_size1,
+    iree_uk_index_t out_stride1, iree_uk_index_t in_stride0,
+    iree_uk_index_t elem_size, iree_uk_index_t tile_size0,
+    iree_uk_index_t tile_size1) {
+  IREE_UK_ASSERT(elem_size == 2);
+  IREE_UK_ASSERT(tile_size0 == 1);
+  IREE_UK_ASSERT(tile_size1 == 16);
+  const iree_uk_int16_t* IREE_UK_RESTRICT in_ptr = in_tile_ptr;
+  iree_uk_int16_t* IREE_UK_RESTRICT out_ptr = out_tile_ptr;
+  for (; outer_size1 > 0; --outer_size1) {
+    iree_uk_memcpy(out_ptr, in_ptr, 32);
+    out_ptr += out_stride1;
+    in_ptr += 16;
+  }
+}
+
+void iree_uk_pack_tile_32x1_x16_x86_64_avx512_base_direct(
+    void* IREE_UK_RESTRICT out_tile_ptr,
+    const void* IREE_UK_RESTRICT in_tile_ptr, iree_uk_index_t outer_size1,
+    iree_uk_index_t out_stride1, iree_uk_index_t in_stride0,
+    iree_uk_index_t elem_size, iree_uk_index_t tile_size0,
+    iree_uk_index_t tile_size1) {
+  IREE_UK_ASSERT(elem_size == 2);
+  IREE_UK_ASSERT(tile_size0 == 32);
+  IREE_UK_ASSERT(tile_size1 == 1);
+  // Each half of the 32 rows fills one contiguous half of the output tile.
+  const iree_uk_int16_t* IREE_UK_RESTRICT in_ptr = in_tile_ptr;
+  iree_uk_int16_t* IREE_UK_RESTRICT out_ptr = out_tile_ptr;
+  iree_uk_pack_tile_16x2_x8_x86_64_avx512_base_direct(
+      out_ptr, in_ptr, outer_size1, out_stride1 * 2, in_stride0 * 2, 1, 16, 2);
+  iree_uk_pack_tile_16x2_x8_x86_64_avx512_base_direct(
+      out_ptr + 16, in_ptr + 16 * in_stride0, outer_size1, out_stride1 * 2,
+      in_stride0 * 2, 1, 16, 2);
+}
+
+void iree_uk_pack_tile_32x1_x16_x86_64_avx512_base_transpose(
+    void* IREE_UK_RESTRICT out_tile_ptr,
+    const void* IREE_UK_RESTRICT in_tile_ptr, iree_uk_index_t outer_size1,
+    iree_uk_index_t out_stride1, iree_uk_index_t in_stride0,
+    iree_uk_index_t elem_size, iree_uk_index_t tile_size0,
+    iree_uk_index_t tile_size1) {
+  IREE_UK_ASSERT(elem_size == 2);
+  IREE_UK_ASSERT(tile_size0 == 1);
+  IREE_UK_ASSERT(tile_size1 == 32);
+  const iree_uk_int16_t* IREE_UK_RESTRICT in_ptr = in_tile_ptr;
+  iree_uk_int16_t* IREE_UK_RESTRICT out_ptr = out_tile_ptr;
+  for (; outer_size1 > 0; --outer_size1) {
+    iree_uk_memcpy(out_ptr, in_ptr, 64);
+    out_ptr += out_stride1;
+    in_ptr += 32;
+  }
+}
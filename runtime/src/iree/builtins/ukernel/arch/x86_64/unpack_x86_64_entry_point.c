@@ -17,8 +17,22 @@ iree_uk_unpack_tile_func_t iree_uk_unpack_select_tile_func_arch(
   iree_uk_unpack_type_t unpack_type = iree_uk_unpack_type(params->flags);
   int esize = iree_uk_type_size(iree_uk_unpack_out_type(unpack_type));
   bool transpose = params->flags & IREE_UK_FLAG_UNPACK_TRANSPOSE_INNER;
-  // Unpack is currently only used in practice with esize==4 and non-transpose.
-  if (esize != 4 || transpose) return 0;
+  // Unpack is currently only used in practice with non-transpose, esize==4
+  // and, for f16 accumulators, esize==2.
+  if (transpose) return 0;
+  if (esize == 2) {
+#if defined(IREE_UK_BUILD_X86_64_AVX512_BASE)
+    if (iree_uk_cpu_x86_64_avx512_base(params->cpu_data)) {
+      if (params->in_size2 == 16 && params->in_size3 == 16) {
+        return iree_uk_unpack_tile_16x16_x16_x86_64_avx512_base_direct;
+      } else if (params->in_size2 == 16 && params->in_size3 == 32) {
+        return iree_uk_unpack_tile_16x32_x16_x86_64_avx512_base_direct;
+      }
+    }
+#endif
+    return 0;
+  }
+  if (esize != 4) return 0;
   if (params->in_size2 == 8 && params->in_size3 == 8) {
 #if defined(IREE_UK_BUILD_X86_64_AVX2_FMA)
     if (iree_uk_cpu_x86_64_avx2_fma(params->cpu_data)) {
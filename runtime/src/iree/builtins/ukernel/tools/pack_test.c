@@ -236,10 +236,23 @@ int main(int argc, char** argv) {
   iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_I32I32, 8, 8, "avx2_fma");
   iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_F32F32, 16, 1, "avx512_base");
   iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_BF16BF16, 16, 2, "avx512_base");
+  iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_F16F16, 16, 1, "avx512_base");
+  // Tile size selected with CPU feature avx512_fp16. The packing code itself
+  // only needs avx512_base.
+  iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_F16F16, 32, 1, "avx512_base");
   iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_I8I8, 16, 2, "avx512_base");
   iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_F32F32, 16, 16, "avx512_base");
   iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_I32I32, 16, 16, "avx512_base");
   // avx512_vnni uses the same tile size and same pack code as avx512_base.
+#elif defined(IREE_ARCH_RISCV_64)
+  // LHS and RHS tiles for the 7x32x1 matmul tile, and the accumulator tile.
+  iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_F32F32, 7, 1, "");
+  iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_F32F32, 32, 1, "");
+  iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_I32I32, 7, 32, "");
+  iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_I8I8, 7, 1, "");
+  iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_I8I8, 32, 1, "");
+  iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_F16F16, 7, 1, "");
+  iree_uk_test_pack(IREE_UK_FLAG_PACK_TYPE_F16F16, 32, 1, "");
 #endif  // defined(IREE_ARCH_ARM_64)
 
   return iree_uk_test_exit_status();
@@ -156,6 +156,17 @@ int main(int argc, char** argv) {
                                     "avx512_base");
   iree_uk_benchmark_register_unpack(IREE_UK_FLAG_UNPACK_TYPE_I32I32, 16, 16,
                                     "avx512_base");
+  iree_uk_benchmark_register_unpack(IREE_UK_FLAG_UNPACK_TYPE_F16F16, 16, 16,
+                                    "avx512_base");
+  iree_uk_benchmark_register_unpack(IREE_UK_FLAG_UNPACK_TYPE_F16F16, 16, 32,
+                                    "avx512_base");
+#elif defined(IREE_ARCH_RISCV_64)
+  iree_uk_benchmark_register_unpack(IREE_UK_FLAG_UNPACK_TYPE_F32F32, 7, 32,
+                                    "");
+  iree_uk_benchmark_register_unpack(IREE_UK_FLAG_UNPACK_TYPE_I32I32, 7, 32,
+                                    "");
+  iree_uk_benchmark_register_unpack(IREE_UK_FLAG_UNPACK_TYPE_F16F16, 7, 32,
+                                    "");
 #else   // defined(IREE_ARCH_ARM_64)
   // Architectures on which we do not have any optimized ukernel code.
   // Benchmark some arbitrary tile shape.
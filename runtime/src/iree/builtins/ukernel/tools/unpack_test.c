@@ -212,6 +212,14 @@ int main(int argc, char** argv) {
   iree_uk_test_unpack(IREE_UK_FLAG_UNPACK_TYPE_I32I32, 8, 8, "avx2_fma");
   iree_uk_test_unpack(IREE_UK_FLAG_UNPACK_TYPE_F32F32, 16, 16, "avx512_base");
   iree_uk_test_unpack(IREE_UK_FLAG_UNPACK_TYPE_I32I32, 16, 16, "avx512_base");
+  iree_uk_test_unpack(IREE_UK_FLAG_UNPACK_TYPE_F16F16, 16, 16, "avx512_base");
+  // Tile size selected with CPU feature avx512_fp16. Same comment as in
+  // pack_test.c.
+  iree_uk_test_unpack(IREE_UK_FLAG_UNPACK_TYPE_F16F16, 16, 32, "avx512_base");
+#elif defined(IREE_ARCH_RISCV_64)
+  iree_uk_test_unpack(IREE_UK_FLAG_UNPACK_TYPE_F32F32, 7, 32, "");
+  iree_uk_test_unpack(IREE_UK_FLAG_UNPACK_TYPE_I32I32, 7, 32, "");
+  iree_uk_test_unpack(IREE_UK_FLAG_UNPACK_TYPE_F16F16, 7, 32, "");
 #endif  // defined(IREE_ARCH_ARM_64)
 
   return iree_uk_test_exit_status();
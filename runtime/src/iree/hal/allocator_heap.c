@@ -153,7 +153,8 @@ iree_hal_heap_allocator_query_buffer_compatibility(
       compatibility |= IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_TRANSFER;
     }
     if (iree_any_bit_set(params->usage,
-                         IREE_HAL_BUFFER_USAGE_DISPATCH_STORAGE)) {
+                         IREE_HAL_BUFFER_USAGE_DISPATCH_STORAGE |
+                             IREE_HAL_BUFFER_USAGE_DISPATCH_INDIRECT_PARAMS)) {
       compatibility |= IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_DISPATCH;
     }
   }
@@ -542,7 +542,7 @@ iree_status_t iree_hal_command_buffer_collective_validation(
     };
     IREE_RETURN_IF_ERROR(iree_hal_command_buffer_validate_buffer_requirements(
         command_buffer, validation_state, send_ref, send_reqs));
-  } else {
+  } else if (send_ref.buffer || send_ref.length) {
     return iree_make_status(
         IREE_STATUS_INVALID_ARGUMENT,
         "collective operation does not use a send buffer binding");
@@ -558,7 +558,7 @@ iree_status_t iree_hal_command_buffer_collective_validation(
     };
     IREE_RETURN_IF_ERROR(iree_hal_command_buffer_validate_buffer_requirements(
         command_buffer, validation_state, recv_ref, recv_reqs));
-  } else {
+  } else if (recv_ref.buffer || recv_ref.length) {
     return iree_make_status(
         IREE_STATUS_INVALID_ARGUMENT,
         "collective operation does not use a recv buffer binding");
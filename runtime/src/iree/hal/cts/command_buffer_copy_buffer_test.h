@@ -273,6 +273,75 @@ TEST_F(CommandBufferCopyBufferTest, CopySubBufferIndirect) {
   iree_hal_buffer_release(host_buffer);
 }
 
+TEST_F(CommandBufferCopyBufferTest, CopyWholeBufferReusableIndirect) {
+  const int kSourceBufferSlot = 0;
+  const int kTargetBufferSlot = 1;
+  const int kBindingSlotCount = 2;
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, IREE_HAL_COMMAND_BUFFER_MODE_DEFAULT,
+      IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+      kBindingSlotCount, &command_buffer));
+
+  // Record once against binding table slots only.
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer,
+      iree_hal_make_indirect_buffer_ref(kSourceBufferSlot, /*offset=*/0,
+                                        kDefaultAllocationSize),
+      iree_hal_make_indirect_buffer_ref(kTargetBufferSlot, /*offset=*/0,
+                                        kDefaultAllocationSize),
+      IREE_HAL_COPY_FLAG_NONE));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  iree_hal_buffer_params_t params = {0};
+  params.type =
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+  params.usage = IREE_HAL_BUFFER_USAGE_DISPATCH_STORAGE |
+                 IREE_HAL_BUFFER_USAGE_TRANSFER |
+                 IREE_HAL_BUFFER_USAGE_MAPPING;
+
+  // Submit the same command buffer twice with different bindings.
+  const uint8_t source_vals[2] = {0x12, 0x34};
+  for (int i = 0; i < 2; ++i) {
+    std::vector<uint8_t> reference_buffer(kDefaultAllocationSize,
+                                          source_vals[i]);
+    iree_hal_buffer_t* source_buffer = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        device_allocator_, params, kDefaultAllocationSize, &source_buffer));
+    IREE_ASSERT_OK(iree_hal_device_transfer_h2d(
+        device_, reference_buffer.data(), source_buffer, 0,
+        reference_buffer.size(), IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT,
+        iree_infinite_timeout()));
+    iree_hal_buffer_t* target_buffer = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        device_allocator_, params, kDefaultAllocationSize, &target_buffer));
+
+    const iree_hal_buffer_binding_t bindings[] = {
+        /*kSourceBufferSlot=*/{source_buffer, 0, IREE_WHOLE_BUFFER},
+        /*kTargetBufferSlot=*/{target_buffer, 0, IREE_WHOLE_BUFFER},
+    };
+    IREE_ASSERT_OK(SubmitCommandBufferAndWait(command_buffer,
+                                              iree_hal_buffer_binding_table_t{
+                                                  IREE_ARRAYSIZE(bindings),
+                                                  bindings,
+                                              }));
+
+    std::vector<uint8_t> actual_data(kDefaultAllocationSize);
+    IREE_ASSERT_OK(iree_hal_device_transfer_d2h(
+        device_, target_buffer, /*source_offset=*/0,
+        /*target_buffer=*/actual_data.data(),
+        /*data_length=*/kDefaultAllocationSize,
+        IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT, iree_infinite_timeout()));
+    EXPECT_THAT(actual_data, ContainerEq(reference_buffer));
+
+    iree_hal_buffer_release(target_buffer);
+    iree_hal_buffer_release(source_buffer);
+  }
+
+  iree_hal_command_buffer_release(command_buffer);
+}
+
 }  // namespace iree::hal::cts
 
 #endif  // IREE_HAL_CTS_COMMAND_BUFFER_COPY_BUFFER_TEST_H_
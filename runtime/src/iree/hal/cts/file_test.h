@@ -8,6 +8,8 @@
 #define IREE_HAL_CTS_FILE_TEST_H_
 
 #include <cstdint>
+#include <cstdlib>
+#include <string>
 #include <vector>
 
 #include "iree/base/api.h"
@@ -16,6 +18,10 @@
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
 
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+#include <unistd.h>
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
+
 namespace iree::hal::cts {
 
 using ::testing::ContainerEq;
@@ -81,6 +87,83 @@ class FileTest : public CTSTestBase<> {
         IREE_HAL_EXTERNAL_FILE_FLAG_NONE, out_file));
     iree_io_file_handle_release(handle);
   }
+
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+  // Creates a temporary file on disk filled with |pattern| and imports it as a
+  // file descriptor-backed HAL file. The file is unlinked immediately and will
+  // be deleted when the HAL file is released.
+  void CreatePatternedFdFile(iree_hal_memory_access_t access,
+                             iree_device_size_t file_size, uint8_t pattern,
+                             iree_hal_file_t** out_file) {
+    const char* tmpdir = getenv("TEST_TMPDIR");
+    if (!tmpdir) tmpdir = getenv("TMPDIR");
+    if (!tmpdir) tmpdir = "/tmp";
+    std::string path = std::string(tmpdir) + "/iree_hal_cts_file_XXXXXX";
+    int fd = mkstemp(&path[0]);
+    ASSERT_NE(fd, -1);
+    std::vector<uint8_t> file_contents(file_size, pattern);
+    ASSERT_EQ(write(fd, file_contents.data(), file_contents.size()),
+                   (ssize_t)file_contents.size());
+    close(fd);
+
+    iree_io_file_handle_t* handle = NULL;
+    IREE_CHECK_OK(iree_io_file_handle_open(
+        IREE_IO_FILE_ACCESS_READ,
+        iree_make_string_view(path.data(), path.size()),
+        iree_allocator_system(), &handle));
+    unlink(path.c_str());
+    IREE_CHECK_OK(iree_hal_file_import(
+        device_, IREE_HAL_QUEUE_AFFINITY_ANY, access, handle,
+        IREE_HAL_EXTERNAL_FILE_FLAG_NONE, out_file));
+    iree_io_file_handle_release(handle);
+  }
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
+
+  // Reads |file_size| bytes of |file| into a new device buffer and checks that
+  // all bytes match |pattern|.
+  void ReadAndVerifyFile(iree_hal_file_t* file, iree_device_size_t file_size,
+                         uint8_t pattern) {
+    iree_hal_buffer_t* buffer = NULL;
+    CreatePatternedDeviceBuffer(file_size, 0xCD, &buffer);
+
+    iree_hal_semaphore_t* semaphore = NULL;
+    IREE_ASSERT_OK(iree_hal_semaphore_create(
+        device_, 0ull, IREE_HAL_SEMAPHORE_FLAG_NONE, &semaphore));
+    iree_hal_fence_t* wait_fence = NULL;
+    IREE_ASSERT_OK(iree_hal_fence_create_at(
+        semaphore, 1ull, iree_allocator_system(), &wait_fence));
+    iree_hal_fence_t* signal_fence = NULL;
+    IREE_ASSERT_OK(iree_hal_fence_create_at(
+        semaphore, 2ull, iree_allocator_system(), &signal_fence));
+
+    // NOTE: synchronously executing here so start with the wait signaled.
+    // We should be able to make this async in the future.
+    IREE_ASSERT_OK(iree_hal_fence_signal(wait_fence));
+
+    IREE_ASSERT_OK(iree_hal_device_queue_read(
+        device_, IREE_HAL_QUEUE_AFFINITY_ANY,
+        iree_hal_fence_semaphore_list(wait_fence),
+        iree_hal_fence_semaphore_list(signal_fence), /*source_file=*/file,
+        /*source_offset=*/0, /*target_buffer=*/buffer, /*target_offset=*/0,
+        /*length=*/file_size, IREE_HAL_READ_FLAG_NONE));
+
+    IREE_ASSERT_OK(iree_hal_fence_wait(signal_fence, iree_infinite_timeout()));
+    iree_hal_fence_release(wait_fence);
+    iree_hal_fence_release(signal_fence);
+    iree_hal_semaphore_release(semaphore);
+
+    std::vector<uint8_t> reference_buffer(file_size);
+    memset(reference_buffer.data(), pattern, file_size);
+    std::vector<uint8_t> actual_data(file_size);
+    IREE_ASSERT_OK(iree_hal_device_transfer_d2h(
+        device_, buffer, /*source_offset=*/0,
+        /*target_buffer=*/actual_data.data(),
+        /*data_length=*/file_size, IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT,
+        iree_infinite_timeout()));
+    EXPECT_THAT(actual_data, ContainerEq(reference_buffer));
+
+    iree_hal_buffer_release(buffer);
+  }
 };
 
 // Reads the entire file into a buffer and check the contents match.
@@ -89,48 +172,22 @@ TEST_F(FileTest, ReadEntireFile) {
   iree_hal_file_t* file = NULL;
   CreatePatternedMemoryFile(IREE_HAL_MEMORY_ACCESS_READ, file_size, 0xDEu,
                             &file);
-  iree_hal_buffer_t* buffer = NULL;
-  CreatePatternedDeviceBuffer(file_size, 0xCD, &buffer);
-
-  iree_hal_semaphore_t* semaphore = NULL;
-  IREE_ASSERT_OK(iree_hal_semaphore_create(
-      device_, 0ull, IREE_HAL_SEMAPHORE_FLAG_NONE, &semaphore));
-  iree_hal_fence_t* wait_fence = NULL;
-  IREE_ASSERT_OK(iree_hal_fence_create_at(
-      semaphore, 1ull, iree_allocator_system(), &wait_fence));
-  iree_hal_fence_t* signal_fence = NULL;
-  IREE_ASSERT_OK(iree_hal_fence_create_at(
-      semaphore, 2ull, iree_allocator_system(), &signal_fence));
-
-  // NOTE: synchronously executing here so start with the wait signaled.
-  // We should be able to make this async in the future.
-  IREE_ASSERT_OK(iree_hal_fence_signal(wait_fence));
-
-  IREE_ASSERT_OK(iree_hal_device_queue_read(
-      device_, IREE_HAL_QUEUE_AFFINITY_ANY,
-      iree_hal_fence_semaphore_list(wait_fence),
-      iree_hal_fence_semaphore_list(signal_fence), /*source_file=*/file,
-      /*source_offset=*/0, /*target_buffer=*/buffer, /*target_offset=*/0,
-      /*length=*/file_size, IREE_HAL_READ_FLAG_NONE));
-
-  IREE_ASSERT_OK(iree_hal_fence_wait(signal_fence, iree_infinite_timeout()));
-  iree_hal_fence_release(wait_fence);
-  iree_hal_fence_release(signal_fence);
-  iree_hal_semaphore_release(semaphore);
-
-  std::vector<uint8_t> reference_buffer(file_size);
-  memset(reference_buffer.data(), 0xDEu, file_size);
-  std::vector<uint8_t> actual_data(file_size);
-  IREE_ASSERT_OK(iree_hal_device_transfer_d2h(
-      device_, buffer, /*source_offset=*/0,
-      /*target_buffer=*/actual_data.data(),
-      /*data_length=*/file_size, IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT,
-      iree_infinite_timeout()));
-  EXPECT_THAT(actual_data, ContainerEq(reference_buffer));
-
-  iree_hal_buffer_release(buffer);
+  ReadAndVerifyFile(file, file_size, 0xDEu);
+  iree_hal_file_release(file);
+}
+
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+// Reads an entire file descriptor-backed file into a buffer and checks the
+// contents match. This exercises the staged streaming path as the file contents
+// are not host-resident.
+TEST_F(FileTest, ReadEntireFdFile) {
+  iree_device_size_t file_size = 3 * 1024 * 1024 + 128;
+  iree_hal_file_t* file = NULL;
+  CreatePatternedFdFile(IREE_HAL_MEMORY_ACCESS_READ, file_size, 0xDEu, &file);
+  ReadAndVerifyFile(file, file_size, 0xDEu);
   iree_hal_file_release(file);
 }
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
 
 }  // namespace iree::hal::cts
 
@@ -10,9 +10,26 @@
 #include <stddef.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/flags.h"
 #include "iree/hal/drivers/local_sync/sync_driver.h"
+#include "iree/hal/local/executable_disk_cache.h"
 #include "iree/hal/local/loaders/registration/init.h"
 #include "iree/hal/local/plugins/registration/init.h"
+#include "iree/hal/utils/large_page_allocator.h"
+
+IREE_FLAG(bool, sync_lazy_executable_preparation, false,
+          "Defers loading executables until they are first dispatched. "
+          "Only applies to executables whose data remains owned by the "
+          "caller (such as those embedded in a loaded module). Executable "
+          "loading errors are reported on first use of the executable.");
+
+IREE_FLAG(string, sync_host_large_pages, "none",
+          "Backs host buffers of 2MB or more with large pages: `none`, "
+          "`transparent` (madvise), `2mb`, or `1gb` (explicit hugetlb pages). "
+          "Falls back to smaller pages when large pages are unavailable.");
+IREE_FLAG(int32_t, sync_host_numa_node, -1,
+          "NUMA node preferred for host buffers backed by large pages or -1 "
+          "to use the default placement.");
 
 static iree_status_t iree_hal_local_sync_driver_factory_enumerate(
     void* self, iree_host_size_t* out_driver_info_count,
@@ -38,24 +55,45 @@ static iree_status_t iree_hal_local_sync_driver_factory_try_create(
 
   iree_hal_sync_device_params_t default_params;
   iree_hal_sync_device_params_initialize(&default_params);
+  default_params.lazy_executable_preparation =
+      FLAG_sync_lazy_executable_preparation;
 
   iree_hal_executable_plugin_manager_t* plugin_manager = NULL;
   iree_status_t status = iree_hal_executable_plugin_manager_create_from_flags(
       host_allocator, &plugin_manager);
 
+  iree_hal_executable_disk_cache_t* disk_cache = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_executable_disk_cache_create_from_flags(host_allocator,
+                                                              &disk_cache);
+  }
+
   iree_hal_executable_loader_t* loaders[8] = {NULL};
   iree_host_size_t loader_count = 0;
   if (iree_status_is_ok(status)) {
     status = iree_hal_create_all_available_executable_loaders(
-        plugin_manager, IREE_ARRAYSIZE(loaders), &loader_count, loaders,
-        host_allocator);
+        plugin_manager, disk_cache, IREE_ARRAYSIZE(loaders), &loader_count,
+        loaders, host_allocator);
   }
 
   iree_hal_allocator_t* device_allocator = NULL;
   if (iree_status_is_ok(status)) {
-    status = iree_hal_allocator_create_heap(iree_make_cstring_view("local"),
-                                            host_allocator, host_allocator,
-                                            &device_allocator);
+    iree_hal_large_page_allocator_options_t large_page_options;
+    iree_hal_large_page_allocator_options_initialize(&large_page_options);
+    large_page_options.numa_node = FLAG_sync_host_numa_node;
+    status = iree_hal_large_page_mode_parse(
+        iree_make_cstring_view(FLAG_sync_host_large_pages),
+        &large_page_options.mode);
+    if (iree_status_is_ok(status)) {
+      iree_allocator_t data_allocator =
+          large_page_options.mode == IREE_HAL_LARGE_PAGE_MODE_NONE &&
+                  large_page_options.numa_node < 0
+              ? host_allocator
+              : iree_hal_large_page_allocator(&large_page_options);
+      status = iree_hal_allocator_create_heap(iree_make_cstring_view("local"),
+                                              data_allocator, host_allocator,
+                                              &device_allocator);
+    }
   }
 
   if (iree_status_is_ok(status)) {
@@ -68,6 +106,7 @@ static iree_status_t iree_hal_local_sync_driver_factory_try_create(
   for (iree_host_size_t i = 0; i < loader_count; ++i) {
     iree_hal_executable_loader_release(loaders[i]);
   }
+  iree_hal_executable_disk_cache_release(disk_cache);
   iree_hal_executable_plugin_manager_release(plugin_manager);
   return status;
 }
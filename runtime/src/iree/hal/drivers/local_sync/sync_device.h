@@ -22,6 +22,11 @@ typedef struct iree_hal_sync_device_params_t {
   // Larger sizes will lower overhead and ensure the heap isn't hit for
   // transient allocations while also increasing memory consumption.
   iree_host_size_t arena_block_size;
+  // Defers loading each executable until it is first dispatched so that
+  // executables that are never used are never loaded. Only applies to
+  // executables whose data is aliased by the caller. Executable loading
+  // errors are reported on first use.
+  bool lazy_executable_preparation;
 } iree_hal_sync_device_params_t;
 
 // Initializes |out_params| to default values.
@@ -0,0 +1,1207 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/drivers/local_task/task_channel.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/call_once.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/wait_handle.h"
+#include "iree/hal/utils/host_collectives.h"
+#include "iree/hal/utils/shm_channel.h"
+#include "iree/task/submission.h"
+
+// Number of bytes each tile of a collective dispatch processes. Must be a
+// multiple of the largest element size. Smaller tiles spread reductions across
+// more workers while larger tiles reduce per-tile overhead.
+#if !defined(IREE_HAL_TASK_COLLECTIVE_TILE_LENGTH)
+#define IREE_HAL_TASK_COLLECTIVE_TILE_LENGTH (64 * 1024)
+#endif  // !IREE_HAL_TASK_COLLECTIVE_TILE_LENGTH
+static_assert(IREE_HAL_TASK_COLLECTIVE_TILE_LENGTH > 0 &&
+                  IREE_HAL_TASK_COLLECTIVE_TILE_LENGTH % sizeof(uint64_t) == 0,
+              "collective tiles must hold whole 64-bit elements");
+
+//===----------------------------------------------------------------------===//
+// iree_hal_task_channel_barrier_t
+//===----------------------------------------------------------------------===//
+
+// Host memory published by a participant when arriving at a barrier.
+// Participants that failed to start the collective still arrive so that their
+// peers are not left waiting and publish |failed| instead of their buffers.
+typedef struct iree_hal_task_channel_slot_t {
+  uint8_t* send;
+  uint8_t* recv;
+  bool failed;
+} iree_hal_task_channel_slot_t;
+
+// A reusable barrier among a fixed number of participants.
+// Each phase completes when all participants have arrived and those arriving
+// before the last wait on the event of the phase. Participants can only arrive
+// at the next phase after the prior one completed such that the event of the
+// previous phase is no longer in use when the next phase completes and can be
+// reset for reuse two phases later.
+struct iree_hal_task_channel_barrier_t {
+  iree_slim_mutex_t mutex;
+  int32_t participant_count;
+  int32_t arrived_count;
+  // Total number of completed phases. Stored with release semantics when a
+  // phase completes so that participants can acquire the slots published by
+  // their peers without relying on the event to order memory.
+  iree_atomic_int64_t phase;
+  // Events signaled when the phase with the matching parity completes.
+  iree_event_t events[2];
+  // Memory published by each participant for the current phase.
+  iree_hal_task_channel_slot_t slots[];
+};
+
+static iree_status_t iree_hal_task_channel_barrier_create(
+    int32_t participant_count, iree_allocator_t host_allocator,
+    iree_hal_task_channel_barrier_t** out_barrier) {
+  *out_barrier = NULL;
+  iree_hal_task_channel_barrier_t* barrier = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      host_allocator,
+      sizeof(*barrier) + participant_count * sizeof(barrier->slots[0]),
+      (void**)&barrier));
+  memset(barrier, 0,
+         sizeof(*barrier) + participant_count * sizeof(barrier->slots[0]));
+  iree_slim_mutex_initialize(&barrier->mutex);
+  barrier->participant_count = participant_count;
+  iree_status_t status = iree_event_initialize(false, &barrier->events[0]);
+  if (iree_status_is_ok(status)) {
+    status = iree_event_initialize(false, &barrier->events[1]);
+    if (!iree_status_is_ok(status)) {
+      iree_event_deinitialize(&barrier->events[0]);
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    *out_barrier = barrier;
+  } else {
+    iree_slim_mutex_deinitialize(&barrier->mutex);
+    iree_allocator_free(host_allocator, barrier);
+  }
+  return status;
+}
+
+static void iree_hal_task_channel_barrier_destroy(
+    iree_hal_task_channel_barrier_t* barrier, iree_allocator_t host_allocator) {
+  if (!barrier) return;
+  iree_event_deinitialize(&barrier->events[0]);
+  iree_event_deinitialize(&barrier->events[1]);
+  iree_slim_mutex_deinitialize(&barrier->mutex);
+  iree_allocator_free(host_allocator, barrier);
+}
+
+// Arrives at the current phase of |barrier| as |participant| and publishes
+// |slot|, if provided. Returns true if this was the last participant to arrive
+// and otherwise returns a wait source in |out_wait_source| that resolves when
+// the phase completes.
+static bool iree_hal_task_channel_barrier_arrive(
+    iree_hal_task_channel_barrier_t* barrier, int32_t participant,
+    const iree_hal_task_channel_slot_t* slot,
+    iree_wait_source_t* out_wait_source) {
+  iree_slim_mutex_lock(&barrier->mutex);
+  if (slot) barrier->slots[participant] = *slot;
+  const uint64_t phase =
+      (uint64_t)iree_atomic_load(&barrier->phase, iree_memory_order_relaxed) +
+      1;
+  const bool completed =
+      ++barrier->arrived_count == barrier->participant_count;
+  if (completed) {
+    barrier->arrived_count = 0;
+    iree_atomic_store(&barrier->phase, (int64_t)phase,
+                      iree_memory_order_release);
+    iree_event_reset(&barrier->events[(phase + 1) & 1]);
+    iree_event_set(&barrier->events[phase & 1]);
+  } else {
+    *out_wait_source = iree_event_await(&barrier->events[phase & 1]);
+  }
+  iree_slim_mutex_unlock(&barrier->mutex);
+  return completed;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_task_channel_group_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_task_channel_group_t iree_hal_task_channel_group_t;
+
+// Per-participant state of an in-progress channel split.
+typedef struct iree_hal_task_channel_split_entry_t {
+  int32_t color;
+  int32_t key;
+  // Assigned when the split completes. |group| is retained for the participant.
+  int32_t rank;
+  int32_t count;
+  iree_hal_task_channel_group_t* group;
+} iree_hal_task_channel_split_entry_t;
+
+// State shared by all participants of a collective group.
+// Root groups are registered in a process-wide registry keyed by their ID so
+// that channels created independently on different devices can find each
+// other. Groups produced by splits are only reachable from their channels.
+struct iree_hal_task_channel_group_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+
+  // Next group in the registry, if registered.
+  iree_hal_task_channel_group_t* next;
+  bool registered;
+  // Registry key composed of the channel ID and group name.
+  iree_const_byte_span_t key;
+
+  int32_t count;
+
+  // Barrier used by collectives involving all participants.
+  iree_hal_task_channel_barrier_t* barrier;
+
+  // Guards the state below.
+  iree_slim_mutex_t mutex;
+  // Participants that have a live channel in the group.
+  bool* joined;
+  // Barriers for point-to-point transfers indexed by [source * count + target]
+  // and created on first use.
+  iree_hal_task_channel_barrier_t** pair_barriers;
+
+  // Split rendezvous state.
+  struct {
+    iree_notification_t notification;
+    // Incremented each time a split completes.
+    iree_atomic_int32_t epoch;
+    int32_t arrived_count;
+    iree_status_code_t status_code;
+    iree_hal_task_channel_split_entry_t* entries;
+  } split;
+};
+
+// Process-wide registry of root groups.
+typedef struct iree_hal_task_channel_registry_t {
+  iree_slim_mutex_t mutex;
+  iree_hal_task_channel_group_t* head;
+} iree_hal_task_channel_registry_t;
+
+static iree_hal_task_channel_registry_t iree_hal_task_channel_registry_;
+static iree_once_flag iree_hal_task_channel_registry_flag_ =
+    IREE_ONCE_FLAG_INIT;
+static void iree_hal_task_channel_registry_initialize(void) {
+  memset(&iree_hal_task_channel_registry_, 0,
+         sizeof(iree_hal_task_channel_registry_));
+  iree_slim_mutex_initialize(&iree_hal_task_channel_registry_.mutex);
+}
+
+static iree_hal_task_channel_registry_t* iree_hal_task_channel_registry(void) {
+  iree_call_once(&iree_hal_task_channel_registry_flag_,
+                 iree_hal_task_channel_registry_initialize);
+  return &iree_hal_task_channel_registry_;
+}
+
+static iree_status_t iree_hal_task_channel_group_create(
+    iree_const_byte_span_t key, int32_t count, iree_allocator_t host_allocator,
+    iree_hal_task_channel_group_t** out_group) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, count);
+  *out_group = NULL;
+
+  iree_hal_task_channel_group_t* group = NULL;
+  const iree_host_size_t total_size =
+      iree_host_align(sizeof(*group), iree_max_align_t) +
+      iree_host_align(count * sizeof(group->joined[0]), iree_max_align_t) +
+      count * count * sizeof(group->pair_barriers[0]) +
+      count * sizeof(group->split.entries[0]) + key.data_length;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&group));
+  memset(group, 0, total_size);
+  iree_atomic_ref_count_init(&group->ref_count);
+  group->host_allocator = host_allocator;
+  group->count = count;
+  iree_slim_mutex_initialize(&group->mutex);
+  iree_notification_initialize(&group->split.notification);
+
+  uint8_t* ptr =
+      (uint8_t*)group + iree_host_align(sizeof(*group), iree_max_align_t);
+  group->joined = (bool*)ptr;
+  ptr += iree_host_align(count * sizeof(group->joined[0]), iree_max_align_t);
+  group->pair_barriers = (iree_hal_task_channel_barrier_t**)ptr;
+  ptr += count * count * sizeof(group->pair_barriers[0]);
+  group->split.entries = (iree_hal_task_channel_split_entry_t*)ptr;
+  ptr += count * sizeof(group->split.entries[0]);
+  if (key.data_length > 0) memcpy(ptr, key.data, key.data_length);
+  group->key = iree_make_const_byte_span(ptr, key.data_length);
+
+  iree_status_t status = iree_hal_task_channel_barrier_create(
+      count, host_allocator, &group->barrier);
+
+  if (iree_status_is_ok(status)) {
+    *out_group = group;
+  } else {
+    iree_notification_deinitialize(&group->split.notification);
+    iree_slim_mutex_deinitialize(&group->mutex);
+    iree_allocator_free(host_allocator, group);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_task_channel_group_destroy(
+    iree_hal_task_channel_group_t* group) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t host_allocator = group->host_allocator;
+  for (int32_t i = 0; i < group->count * group->count; ++i) {
+    iree_hal_task_channel_barrier_destroy(group->pair_barriers[i],
+                                          host_allocator);
+  }
+  iree_hal_task_channel_barrier_destroy(group->barrier, host_allocator);
+  iree_notification_deinitialize(&group->split.notification);
+  iree_slim_mutex_deinitialize(&group->mutex);
+  iree_allocator_free(host_allocator, group);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static void iree_hal_task_channel_group_retain(
+    iree_hal_task_channel_group_t* group) {
+  iree_atomic_ref_count_inc(&group->ref_count);
+}
+
+static void iree_hal_task_channel_group_release(
+    iree_hal_task_channel_group_t* group) {
+  if (!group->registered) {
+    if (iree_atomic_ref_count_dec(&group->ref_count) == 1) {
+      iree_hal_task_channel_group_destroy(group);
+    }
+    return;
+  }
+
+  // Registered groups are unlinked under the registry lock so that lookups
+  // never observe a group that is being destroyed.
+  iree_hal_task_channel_registry_t* registry = iree_hal_task_channel_registry();
+  iree_slim_mutex_lock(&registry->mutex);
+  const bool destroy = iree_atomic_ref_count_dec(&group->ref_count) == 1;
+  if (destroy) {
+    iree_hal_task_channel_group_t** prev = &registry->head;
+    while (*prev != group) prev = &(*prev)->next;
+    *prev = group->next;
+  }
+  iree_slim_mutex_unlock(&registry->mutex);
+  if (destroy) iree_hal_task_channel_group_destroy(group);
+}
+
+// Finds or creates the registered group with |key| and returns a reference.
+static iree_status_t iree_hal_task_channel_group_acquire(
+    iree_const_byte_span_t key, int32_t count, iree_allocator_t host_allocator,
+    iree_hal_task_channel_group_t** out_group) {
+  *out_group = NULL;
+  iree_hal_task_channel_registry_t* registry = iree_hal_task_channel_registry();
+  iree_slim_mutex_lock(&registry->mutex);
+
+  iree_status_t status = iree_ok_status();
+  iree_hal_task_channel_group_t* group = registry->head;
+  for (; group != NULL; group = group->next) {
+    if (group->key.data_length == key.data_length &&
+        memcmp(group->key.data, key.data, key.data_length) == 0) {
+      break;
+    }
+  }
+  if (group) {
+    if (group->count != count) {
+      status = iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "channel group has %d participants but %d were requested",
+          group->count, count);
+    } else {
+      iree_hal_task_channel_group_retain(group);
+    }
+  } else {
+    status = iree_hal_task_channel_group_create(key, count, host_allocator,
+                                                &group);
+    if (iree_status_is_ok(status)) {
+      group->registered = true;
+      group->next = registry->head;
+      registry->head = group;
+    }
+  }
+
+  iree_slim_mutex_unlock(&registry->mutex);
+  if (iree_status_is_ok(status)) *out_group = group;
+  return status;
+}
+
+// Marks |rank| as having a live channel in |group|.
+static iree_status_t iree_hal_task_channel_group_join(
+    iree_hal_task_channel_group_t* group, int32_t rank) {
+  iree_slim_mutex_lock(&group->mutex);
+  iree_status_t status = iree_ok_status();
+  if (group->joined[rank]) {
+    status = iree_make_status(IREE_STATUS_ALREADY_EXISTS,
+                              "rank %d already has a channel in the group",
+                              rank);
+  } else {
+    group->joined[rank] = true;
+  }
+  iree_slim_mutex_unlock(&group->mutex);
+  return status;
+}
+
+static void iree_hal_task_channel_group_leave(
+    iree_hal_task_channel_group_t* group, int32_t rank) {
+  iree_slim_mutex_lock(&group->mutex);
+  group->joined[rank] = false;
+  iree_slim_mutex_unlock(&group->mutex);
+}
+
+// Returns the barrier used for transfers from |source| to |target|.
+static iree_status_t iree_hal_task_channel_group_pair_barrier(
+    iree_hal_task_channel_group_t* group, int32_t source, int32_t target,
+    iree_hal_task_channel_barrier_t** out_barrier) {
+  iree_slim_mutex_lock(&group->mutex);
+  iree_status_t status = iree_ok_status();
+  iree_hal_task_channel_barrier_t** barrier =
+      &group->pair_barriers[source * group->count + target];
+  if (!*barrier) {
+    status = iree_hal_task_channel_barrier_create(
+        /*participant_count=*/2, group->host_allocator, barrier);
+  }
+  *out_barrier = *barrier;
+  iree_slim_mutex_unlock(&group->mutex);
+  return status;
+}
+
+// Assigns the ranks and groups of all split entries in |group|.
+// Must be called with the group lock held once all participants have arrived.
+static iree_status_t iree_hal_task_channel_group_assign_splits(
+    iree_hal_task_channel_group_t* group) {
+  iree_hal_task_channel_split_entry_t* entries = group->split.entries;
+  for (int32_t i = 0; i < group->count; ++i) entries[i].group = NULL;
+
+  iree_status_t status = iree_ok_status();
+  for (int32_t i = 0; i < group->count && iree_status_is_ok(status); ++i) {
+    if (entries[i].color == IREE_HAL_CHANNEL_NO_COLOR) continue;
+    if (entries[i].group) continue;  // already assigned with an earlier color
+
+    // Participants with the same color are ordered by key and then by rank in
+    // the parent group.
+    int32_t count = 0;
+    for (int32_t j = i; j < group->count; ++j) {
+      if (entries[j].color != entries[i].color) continue;
+      int32_t rank = 0;
+      for (int32_t k = 0; k < group->count; ++k) {
+        if (entries[k].color != entries[i].color) continue;
+        if (entries[k].key < entries[j].key ||
+            (entries[k].key == entries[j].key && k < j)) {
+          ++rank;
+        }
+      }
+      entries[j].rank = rank;
+      ++count;
+    }
+
+    iree_hal_task_channel_group_t* split_group = NULL;
+    status = iree_hal_task_channel_group_create(
+        iree_const_byte_span_empty(), count, group->host_allocator,
+        &split_group);
+    if (!iree_status_is_ok(status)) break;
+    iree_atomic_ref_count_init_value(&split_group->ref_count, count);
+    for (int32_t j = i; j < group->count; ++j) {
+      if (entries[j].color != entries[i].color) continue;
+      entries[j].count = count;
+      entries[j].group = split_group;
+      split_group->joined[entries[j].rank] = true;
+    }
+  }
+
+  if (!iree_status_is_ok(status)) {
+    // Drop all groups created so far; each was referenced once per member.
+    for (int32_t i = 0; i < group->count; ++i) {
+      if (entries[i].group) {
+        iree_hal_task_channel_group_release(entries[i].group);
+        entries[i].group = NULL;
+      }
+    }
+  }
+  return status;
+}
+
+typedef struct iree_hal_task_channel_split_wait_t {
+  iree_hal_task_channel_group_t* group;
+  int32_t epoch;
+} iree_hal_task_channel_split_wait_t;
+
+static bool iree_hal_task_channel_split_completed(void* arg) {
+  const iree_hal_task_channel_split_wait_t* wait =
+      (const iree_hal_task_channel_split_wait_t*)arg;
+  return iree_atomic_load(&wait->group->split.epoch,
+                          iree_memory_order_acquire) != wait->epoch;
+}
+
+// Blocks until all participants of |group| have split with their own |color|
+// and |key| and returns the new group and rank of |rank|, if any.
+static iree_status_t iree_hal_task_channel_group_split(
+    iree_hal_task_channel_group_t* group, int32_t rank, int32_t color,
+    int32_t key, iree_hal_task_channel_group_t** out_group,
+    int32_t* out_rank) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  *out_group = NULL;
+  *out_rank = 0;
+
+  iree_slim_mutex_lock(&group->mutex);
+  iree_hal_task_channel_split_entry_t* entry = &group->split.entries[rank];
+  entry->color = color;
+  entry->key = key;
+  iree_hal_task_channel_split_wait_t wait = {
+      .group = group,
+      .epoch = iree_atomic_load(&group->split.epoch, iree_memory_order_relaxed),
+  };
+  if (++group->split.arrived_count == group->count) {
+    group->split.arrived_count = 0;
+    iree_status_t status = iree_hal_task_channel_group_assign_splits(group);
+    group->split.status_code = iree_status_code(status);
+    iree_status_ignore(status);
+    iree_atomic_store(&group->split.epoch, wait.epoch + 1,
+                      iree_memory_order_release);
+    iree_slim_mutex_unlock(&group->mutex);
+    iree_notification_post(&group->split.notification, IREE_ALL_WAITERS);
+  } else {
+    iree_slim_mutex_unlock(&group->mutex);
+    iree_notification_await(&group->split.notification,
+                            iree_hal_task_channel_split_completed, &wait,
+                            iree_infinite_timeout());
+  }
+
+  // The entry is only modified by this participant and the next split cannot
+  // complete until it arrives again.
+  iree_slim_mutex_lock(&group->mutex);
+  iree_status_code_t status_code = group->split.status_code;
+  iree_slim_mutex_unlock(&group->mutex);
+  if (status_code != IREE_STATUS_OK) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(status_code, "failed to split channel group");
+  }
+  *out_group = entry->group;
+  *out_rank = entry->rank;
+  entry->group = NULL;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_task_channel_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_task_channel_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_hal_task_channel_group_t* group;
+  int32_t rank;
+  int32_t count;
+} iree_hal_task_channel_t;
+
+static const iree_hal_channel_vtable_t iree_hal_task_channel_vtable;
+
+static iree_hal_task_channel_t* iree_hal_task_channel_cast(
+    iree_hal_channel_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_task_channel_vtable);
+  return (iree_hal_task_channel_t*)base_value;
+}
+
+static const iree_hal_task_channel_t* iree_hal_task_channel_const_cast(
+    const iree_hal_channel_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_task_channel_vtable);
+  return (const iree_hal_task_channel_t*)base_value;
+}
+
+// Wraps a reference to |group| already joined by |rank| in a new channel.
+// The group reference is consumed even on failure.
+static iree_status_t iree_hal_task_channel_wrap(
+    iree_hal_task_channel_group_t* group, int32_t rank,
+    iree_allocator_t host_allocator, iree_hal_channel_t** out_channel) {
+  iree_hal_task_channel_t* channel = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, sizeof(*channel), (void**)&channel);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_hal_task_channel_vtable,
+                                 &channel->resource);
+    channel->host_allocator = host_allocator;
+    channel->group = group;
+    channel->rank = rank;
+    channel->count = group->count;
+    *out_channel = (iree_hal_channel_t*)channel;
+  } else {
+    iree_hal_task_channel_group_leave(group, rank);
+    iree_hal_task_channel_group_release(group);
+  }
+  return status;
+}
+
+iree_status_t iree_hal_task_channel_create(iree_const_byte_span_t id,
+                                           iree_string_view_t group,
+                                           int32_t rank, int32_t count,
+                                           iree_allocator_t host_allocator,
+                                           iree_hal_channel_t** out_channel) {
+  IREE_ASSERT_ARGUMENT(out_channel);
+  *out_channel = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, rank);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, count);
+
+  if (count <= 0 || rank < 0 || rank >= count) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid channel rank %d of %d participants", rank,
+                            count);
+  }
+
+  // The registry key is the ID followed by the group name.
+  const iree_host_size_t key_length = id.data_length + 1 + group.size;
+  uint8_t* key_data = (uint8_t*)iree_alloca(key_length);
+  if (id.data_length > 0) memcpy(key_data, id.data, id.data_length);
+  key_data[id.data_length] = 0;
+  if (group.size > 0) {
+    memcpy(key_data + id.data_length + 1, group.data, group.size);
+  }
+
+  iree_hal_task_channel_group_t* channel_group = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_task_channel_group_acquire(
+              iree_make_const_byte_span(key_data, key_length), count,
+              host_allocator, &channel_group));
+  iree_status_t status = iree_hal_task_channel_group_join(channel_group, rank);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_task_channel_wrap(channel_group, rank, host_allocator,
+                                        out_channel);
+  } else {
+    iree_hal_task_channel_group_release(channel_group);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+bool iree_hal_task_channel_isa(iree_hal_channel_t* channel) {
+  return iree_hal_resource_is(channel, &iree_hal_task_channel_vtable);
+}
+
+static void iree_hal_task_channel_destroy(iree_hal_channel_t* base_channel) {
+  iree_hal_task_channel_t* channel = iree_hal_task_channel_cast(base_channel);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t host_allocator = channel->host_allocator;
+
+  iree_hal_task_channel_group_leave(channel->group, channel->rank);
+  iree_hal_task_channel_group_release(channel->group);
+  iree_allocator_free(host_allocator, channel);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_status_t iree_hal_task_channel_split(
+    iree_hal_channel_t* base_channel, int32_t color, int32_t key,
+    iree_hal_channel_flags_t flags, iree_hal_channel_t** out_split_channel) {
+  iree_hal_task_channel_t* channel = iree_hal_task_channel_cast(base_channel);
+  *out_split_channel = NULL;
+
+  iree_hal_task_channel_group_t* split_group = NULL;
+  int32_t split_rank = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_task_channel_group_split(
+      channel->group, channel->rank, color, key, &split_group, &split_rank));
+  if (!split_group) return iree_ok_status();  // not participating
+
+  return iree_hal_task_channel_wrap(split_group, split_rank,
+                                    channel->host_allocator, out_split_channel);
+}
+
+static void iree_hal_task_channel_query_rank_and_count(
+    const iree_hal_channel_t* base_channel, int32_t* out_rank,
+    int32_t* out_count) {
+  const iree_hal_task_channel_t* channel =
+      iree_hal_task_channel_const_cast(base_channel);
+  *out_rank = channel->rank;
+  *out_count = channel->count;
+}
+
+static const iree_hal_channel_vtable_t iree_hal_task_channel_vtable = {
+    .destroy = iree_hal_task_channel_destroy,
+    .split = iree_hal_task_channel_split,
+    .query_rank_and_count = iree_hal_task_channel_query_rank_and_count,
+};
+
+//===----------------------------------------------------------------------===//
+// Reductions
+//===----------------------------------------------------------------------===//
+
+// Reduces |length| elements at element |source_offset| of the send buffers of
+// all participants in |slots| and stores the result at element |target_offset|
+// of the recv buffer of |target_rank|, or of all participants if -1.
+static void iree_hal_task_collective_reduce_range(
+    const iree_hal_task_collective_t* cmd,
+    const iree_hal_task_channel_slot_t* slots, int32_t rank_count,
+    iree_host_size_t source_offset, iree_host_size_t target_offset,
+    iree_host_size_t length, int32_t target_rank) {
+  const iree_hal_collective_element_type_t element_type = cmd->op.element_type;
+  const iree_host_size_t element_size =
+      iree_hal_collective_element_byte_count(element_type);
+  uint64_t acc[IREE_HAL_COLLECTIVE_ACCUMULATOR_CHUNK_LENGTH];
+  for (iree_host_size_t i = 0; i < length;
+       i += IREE_HAL_COLLECTIVE_ACCUMULATOR_CHUNK_LENGTH) {
+    const iree_host_size_t count =
+        iree_min(length - i, IREE_HAL_COLLECTIVE_ACCUMULATOR_CHUNK_LENGTH);
+    const iree_host_size_t source_byte_offset =
+        (source_offset + i) * element_size;
+    iree_hal_collective_accumulator_load(
+        element_type, acc, slots[0].send + source_byte_offset, count);
+    for (int32_t j = 1; j < rank_count; ++j) {
+      iree_hal_collective_accumulator_reduce(
+          element_type, cmd->op.reduction, acc,
+          slots[j].send + source_byte_offset, count);
+    }
+    iree_hal_collective_accumulator_finalize(element_type, cmd->op.reduction,
+                                             rank_count, acc, count);
+    const iree_host_size_t target_byte_offset =
+        (target_offset + i) * element_size;
+    if (target_rank >= 0) {
+      iree_hal_collective_accumulator_store(
+          element_type, acc, slots[target_rank].recv + target_byte_offset,
+          count);
+    } else {
+      for (int32_t j = 0; j < rank_count; ++j) {
+        iree_hal_collective_accumulator_store(
+            element_type, acc, slots[j].recv + target_byte_offset, count);
+      }
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_task_collective_t
+//===----------------------------------------------------------------------===//
+
+static iree_status_t iree_hal_task_collective_arrive(
+    void* user_context, iree_task_t* task,
+    iree_task_submission_t* pending_submission);
+
+iree_status_t iree_hal_task_collective_initialize(
+    iree_task_scope_t* scope, iree_hal_channel_t* base_channel,
+    iree_hal_collective_op_t op, uint32_t param,
+    iree_device_size_t element_count,
+    iree_hal_task_collective_t* out_collective) {
+  const bool is_shm_channel = iree_hal_shm_channel_isa(base_channel);
+  if (!is_shm_channel && !iree_hal_task_channel_isa(base_channel)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "collectives on the task system require channels "
+                            "created by a task device");
+  }
+
+  switch (op.kind) {
+    case IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE:
+    case IREE_HAL_COLLECTIVE_KIND_REDUCE:
+    case IREE_HAL_COLLECTIVE_KIND_REDUCE_SCATTER:
+      if (op.reduction == IREE_HAL_COLLECTIVE_REDUCTION_NONE ||
+          op.reduction > IREE_HAL_COLLECTIVE_REDUCTION_MAX_VALUE) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "unsupported collective reduction %u",
+                                op.reduction);
+      }
+      break;
+    default:
+      break;
+  }
+  if (op.element_type > IREE_HAL_COLLECTIVE_ELEMENT_TYPE_MAX_VALUE) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "unsupported collective element type %u",
+                            op.element_type);
+  }
+
+  memset(out_collective, 0, sizeof(*out_collective));
+  iree_task_call_initialize(
+      scope,
+      iree_task_make_call_closure(iree_hal_task_collective_arrive,
+                                  (void*)out_collective),
+      &out_collective->task);
+  out_collective->channel = base_channel;
+  out_collective->op = op;
+  out_collective->param = param;
+  out_collective->element_count = element_count;
+
+  // Shared memory channels perform the whole collective within |task|.
+  if (is_shm_channel) return iree_ok_status();
+
+  // Resolve the barriers the participant will synchronize with.
+  iree_hal_task_channel_t* channel = iree_hal_task_channel_cast(base_channel);
+  iree_hal_task_channel_group_t* group = channel->group;
+  iree_hal_task_collective_t* cmd = out_collective;
+  switch (op.kind) {
+    case IREE_HAL_COLLECTIVE_KIND_ALL_GATHER:
+    case IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE:
+    case IREE_HAL_COLLECTIVE_KIND_ALL_TO_ALL:
+    case IREE_HAL_COLLECTIVE_KIND_BROADCAST:
+    case IREE_HAL_COLLECTIVE_KIND_REDUCE:
+    case IREE_HAL_COLLECTIVE_KIND_REDUCE_SCATTER:
+      if ((op.kind == IREE_HAL_COLLECTIVE_KIND_BROADCAST ||
+           op.kind == IREE_HAL_COLLECTIVE_KIND_REDUCE) &&
+          param >= (uint32_t)channel->count) {
+        return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                "root rank %u out of range of %d participants",
+                                param, channel->count);
+      }
+      if (op.kind == IREE_HAL_COLLECTIVE_KIND_ALL_TO_ALL &&
+          element_count % channel->count != 0) {
+        return iree_make_status(
+            IREE_STATUS_INVALID_ARGUMENT,
+            "all-to-all element count %" PRIu64
+            " must be divisible by the participant count %d",
+            (uint64_t)element_count, channel->count);
+      }
+      cmd->barriers[0] = group->barrier;
+      cmd->participants[0] = channel->rank;
+      cmd->barrier_count = 1;
+      break;
+    case IREE_HAL_COLLECTIVE_KIND_SEND:
+    case IREE_HAL_COLLECTIVE_KIND_RECV:
+    case IREE_HAL_COLLECTIVE_KIND_SEND_RECV: {
+      int32_t target = -1;
+      int32_t source = -1;
+      if (op.kind == IREE_HAL_COLLECTIVE_KIND_SEND) {
+        target = (int32_t)param;
+      } else if (op.kind == IREE_HAL_COLLECTIVE_KIND_RECV) {
+        source = (int32_t)param;
+      } else {
+        iree_hal_collective_send_recv_ranks(param, &target, &source);
+      }
+      if (target >= channel->count || source >= channel->count ||
+          (op.kind == IREE_HAL_COLLECTIVE_KIND_SEND && target < 0) ||
+          (op.kind == IREE_HAL_COLLECTIVE_KIND_RECV && source < 0)) {
+        return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                "peer rank out of range of %d participants",
+                                channel->count);
+      }
+      // Barrier 0 (if any) is the transfer to the target and barrier 1 (if
+      // any) the transfer from the source.
+      if (target >= 0) {
+        IREE_RETURN_IF_ERROR(iree_hal_task_channel_group_pair_barrier(
+            group, channel->rank, target, &cmd->barriers[cmd->barrier_count]));
+        cmd->participants[cmd->barrier_count++] = 0;
+      }
+      if (source >= 0) {
+        IREE_RETURN_IF_ERROR(iree_hal_task_channel_group_pair_barrier(
+            group, source, channel->rank, &cmd->barriers[cmd->barrier_count]));
+        cmd->participants[cmd->barrier_count++] = 1;
+      }
+      break;
+    }
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unhandled collective kind %u", op.kind);
+  }
+
+  return iree_ok_status();
+}
+
+// Returns the receiving barrier of a point-to-point transfer, if any.
+static const iree_hal_task_channel_barrier_t*
+iree_hal_task_collective_recv_barrier(const iree_hal_task_collective_t* cmd) {
+  for (iree_host_size_t i = 0; i < cmd->barrier_count; ++i) {
+    if (cmd->participants[i] == 1) return cmd->barriers[i];
+  }
+  return NULL;
+}
+
+// Acquires the slots published to the barriers of |cmd| in the current phase
+// and returns true if any participant published a failure. Only valid between
+// arriving and departing.
+static bool iree_hal_task_collective_any_failed(
+    const iree_hal_task_collective_t* cmd) {
+  for (iree_host_size_t i = 0; i < cmd->barrier_count; ++i) {
+    iree_hal_task_channel_barrier_t* barrier = cmd->barriers[i];
+    (void)iree_atomic_load(&barrier->phase, iree_memory_order_acquire);
+    for (int32_t j = 0; j < barrier->participant_count; ++j) {
+      if (barrier->slots[j].failed) return true;
+    }
+  }
+  return false;
+}
+
+// Performs the portion of the collective assigned to this participant for the
+// elements in the tile.
+static iree_status_t iree_hal_task_collective_tile(
+    void* user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  const iree_hal_task_collective_t* cmd =
+      (const iree_hal_task_collective_t*)user_context;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  const iree_hal_task_channel_t* channel =
+      iree_hal_task_channel_const_cast(cmd->channel);
+  const int32_t rank = channel->rank;
+  const int32_t rank_count = channel->count;
+  const iree_host_size_t element_size =
+      iree_hal_collective_element_byte_count(cmd->op.element_type);
+  const iree_host_size_t element_count = (iree_host_size_t)cmd->element_count;
+
+  const iree_host_size_t tile_begin =
+      (iree_host_size_t)tile_context->workgroup_xyz[0] *
+      tile_context->workgroup_size[0];
+  const iree_host_size_t tile_end =
+      iree_min(tile_begin + tile_context->workgroup_size[0], cmd->work_count);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (uint64_t)(tile_end - tile_begin));
+
+  // The buffers of failed participants are not published.
+  if (iree_hal_task_collective_any_failed(cmd)) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
+
+  const iree_hal_task_channel_slot_t* slots = cmd->barriers[0]->slots;
+  switch (cmd->op.kind) {
+    case IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE:
+    case IREE_HAL_COLLECTIVE_KIND_REDUCE: {
+      // Reduce this participant's shard and scatter it to the targets.
+      const iree_host_size_t offset = cmd->work_offset + tile_begin;
+      iree_hal_task_collective_reduce_range(
+          cmd, slots, rank_count, offset, offset, tile_end - tile_begin,
+          cmd->op.kind == IREE_HAL_COLLECTIVE_KIND_REDUCE ? (int32_t)cmd->param
+                                                          : -1);
+      break;
+    }
+    case IREE_HAL_COLLECTIVE_KIND_REDUCE_SCATTER: {
+      // Reduce the block of the send buffers owned by this participant.
+      iree_hal_task_collective_reduce_range(
+          cmd, slots, rank_count, rank * element_count + tile_begin, tile_begin,
+          tile_end - tile_begin, rank);
+      break;
+    }
+    case IREE_HAL_COLLECTIVE_KIND_BROADCAST: {
+      // Copy this participant's shard of the root to all other participants.
+      const int32_t root = (int32_t)cmd->param;
+      const iree_host_size_t byte_offset =
+          (cmd->work_offset + tile_begin) * element_size;
+      const iree_host_size_t byte_length =
+          (tile_end - tile_begin) * element_size;
+      for (int32_t j = 0; j < rank_count; ++j) {
+        if (j == root) continue;
+        memcpy(slots[j].recv + byte_offset, slots[root].send + byte_offset,
+               byte_length);
+      }
+      break;
+    }
+    case IREE_HAL_COLLECTIVE_KIND_ALL_GATHER:
+    case IREE_HAL_COLLECTIVE_KIND_ALL_TO_ALL: {
+      // Gather blocks from all participants into the local recv buffer. The
+      // tile may span the blocks of multiple participants.
+      const iree_host_size_t block_length =
+          cmd->op.kind == IREE_HAL_COLLECTIVE_KIND_ALL_GATHER
+              ? element_count
+              : element_count / rank_count;
+      const iree_host_size_t source_base =
+          cmd->op.kind == IREE_HAL_COLLECTIVE_KIND_ALL_GATHER
+              ? 0
+              : rank * block_length;
+      for (iree_host_size_t i = tile_begin; i < tile_end;) {
+        const iree_host_size_t j = i / block_length;
+        const iree_host_size_t block_offset = i % block_length;
+        const iree_host_size_t length =
+            iree_min(tile_end - i, block_length - block_offset);
+        uint8_t* target = slots[rank].recv + i * element_size;
+        const uint8_t* source =
+            slots[j].send + (source_base + block_offset) * element_size;
+        if (target != source) memcpy(target, source, length * element_size);
+        i += length;
+      }
+      break;
+    }
+    case IREE_HAL_COLLECTIVE_KIND_RECV:
+    case IREE_HAL_COLLECTIVE_KIND_SEND_RECV: {
+      // Receives from the source or zero-fills if there is no source.
+      const iree_hal_task_channel_barrier_t* recv_barrier =
+          iree_hal_task_collective_recv_barrier(cmd);
+      uint8_t* target = cmd->recv.data + tile_begin * element_size;
+      const iree_host_size_t byte_length =
+          (tile_end - tile_begin) * element_size;
+      if (recv_barrier) {
+        memcpy(target, recv_barrier->slots[0].send + tile_begin * element_size,
+               byte_length);
+      } else {
+        memset(target, 0, byte_length);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+// Computes the elements processed by this participant.
+static void iree_hal_task_collective_assign_work(
+    iree_hal_task_collective_t* cmd, int32_t rank, int32_t count) {
+  const iree_host_size_t element_count = (iree_host_size_t)cmd->element_count;
+  cmd->work_offset = 0;
+  switch (cmd->op.kind) {
+    case IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE:
+    case IREE_HAL_COLLECTIVE_KIND_REDUCE:
+    case IREE_HAL_COLLECTIVE_KIND_BROADCAST: {
+      // Each participant handles one contiguous shard of the elements.
+      const iree_host_size_t begin = element_count * rank / count;
+      const iree_host_size_t end = element_count * (rank + 1) / count;
+      cmd->work_offset = begin;
+      cmd->work_count = end - begin;
+      break;
+    }
+    case IREE_HAL_COLLECTIVE_KIND_ALL_GATHER:
+      cmd->work_count = element_count * count;
+      break;
+    case IREE_HAL_COLLECTIVE_KIND_ALL_TO_ALL:
+    case IREE_HAL_COLLECTIVE_KIND_REDUCE_SCATTER:
+    case IREE_HAL_COLLECTIVE_KIND_RECV:
+    case IREE_HAL_COLLECTIVE_KIND_SEND_RECV:
+      cmd->work_count = element_count;
+      break;
+    default:
+      cmd->work_count = 0;
+      break;
+  }
+}
+
+// Arrives at all barriers of |cmd| and forks waits for those that have not yet
+// completed as dependencies of |dependent_task|. Returns true if any waits
+// were enqueued.
+static bool iree_hal_task_collective_arrive_all(
+    iree_hal_task_collective_t* cmd, const iree_hal_task_channel_slot_t* slot,
+    iree_task_wait_t* waits, iree_task_t* dependent_task,
+    iree_task_submission_t* pending_submission) {
+  bool any_waits = false;
+  for (iree_host_size_t i = 0; i < cmd->barrier_count; ++i) {
+    iree_wait_source_t wait_source = iree_wait_source_immediate();
+    if (iree_hal_task_channel_barrier_arrive(cmd->barriers[i],
+                                             cmd->participants[i], slot,
+                                             &wait_source)) {
+      continue;
+    }
+    iree_task_wait_initialize(cmd->task.header.scope, wait_source,
+                              IREE_TIME_INFINITE_FUTURE, &waits[i]);
+    if (dependent_task) {
+      iree_task_set_completion_task(&waits[i].header, dependent_task);
+    }
+    iree_task_submission_enqueue(pending_submission, &waits[i].header);
+    any_waits = true;
+  }
+  return any_waits;
+}
+
+static iree_status_t iree_hal_task_collective_depart(
+    void* user_context, iree_task_t* task,
+    iree_task_submission_t* pending_submission) {
+  iree_hal_task_collective_t* cmd = (iree_hal_task_collective_t*)user_context;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Peers may reuse the slots for their next collective as soon as we depart
+  // so failures must be observed first.
+  iree_status_t status = cmd->arrive_status;
+  cmd->arrive_status = iree_ok_status();
+  if (iree_status_is_ok(status) && iree_hal_task_collective_any_failed(cmd)) {
+    status = iree_make_status(IREE_STATUS_ABORTED,
+                              "a peer participant failed the collective");
+  }
+
+  // Holding the completion task until all peers are done with our buffers.
+  iree_hal_task_collective_arrive_all(cmd, /*slot=*/NULL, cmd->depart_waits,
+                                      cmd->depart.header.completion_task,
+                                      pending_submission);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Drops the failure of this participant if |depart| was discarded before it
+// could return it (such as when the scope failed for other reasons).
+static void iree_hal_task_collective_depart_cleanup(
+    iree_task_t* task, iree_status_code_t status_code) {
+  iree_hal_task_collective_t* cmd =
+      (iree_hal_task_collective_t*)((uint8_t*)task -
+                                    offsetof(iree_hal_task_collective_t,
+                                             depart));
+  iree_status_free(cmd->arrive_status);
+  cmd->arrive_status = iree_ok_status();
+}
+
+static iree_status_t iree_hal_task_collective_arrive(
+    void* user_context, iree_task_t* task,
+    iree_task_submission_t* pending_submission) {
+  iree_hal_task_collective_t* cmd = (iree_hal_task_collective_t*)user_context;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Cross-process collectives block the worker until this participant is done.
+  // They are only used when one process runs per host partition and the worker
+  // would otherwise be waiting on the peers anyway.
+  if (iree_hal_shm_channel_isa(cmd->channel)) {
+    iree_status_t status = iree_hal_shm_channel_collective(
+        cmd->channel, cmd->op, cmd->param,
+        iree_make_const_byte_span(cmd->send.data, cmd->send.data_length),
+        cmd->recv, (iree_host_size_t)cmd->element_count);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  // Failures are reported from the depart stage after joining the peers.
+  const iree_hal_task_channel_t* channel =
+      iree_hal_task_channel_const_cast(cmd->channel);
+  cmd->arrive_status = iree_hal_collective_verify_buffer_lengths(
+      cmd->op, cmd->param, channel->rank, channel->count,
+      (iree_host_size_t)cmd->element_count, cmd->send.data_length,
+      cmd->recv.data_length);
+  const bool failed = !iree_status_is_ok(cmd->arrive_status);
+  if (failed) {
+    cmd->work_offset = 0;
+    cmd->work_count = 0;
+  } else {
+    iree_hal_task_collective_assign_work(cmd, channel->rank, channel->count);
+  }
+
+  // Build the chain of stages joining the completion task of the collective.
+  iree_task_scope_t* scope = cmd->task.header.scope;
+  const iree_host_size_t tile_elements =
+      IREE_HAL_TASK_COLLECTIVE_TILE_LENGTH /
+      iree_hal_collective_element_byte_count(cmd->op.element_type);
+  const uint32_t workgroup_size[3] = {
+      /*x=*/(uint32_t)tile_elements,
+      /*y=*/1,
+      /*z=*/1,
+  };
+  const uint32_t workgroup_count[3] = {
+      /*x=*/(uint32_t)iree_host_size_ceil_div(cmd->work_count, tile_elements),
+      /*y=*/1,
+      /*z=*/1,
+  };
+  iree_task_dispatch_initialize(
+      scope,
+      iree_task_make_dispatch_closure(iree_hal_task_collective_tile,
+                                      (void*)cmd),
+      workgroup_size, workgroup_count, &cmd->dispatch);
+  iree_task_call_initialize(
+      scope,
+      iree_task_make_call_closure(iree_hal_task_collective_depart, (void*)cmd),
+      &cmd->depart);
+  iree_task_set_cleanup_fn(&cmd->depart.header,
+                           iree_hal_task_collective_depart_cleanup);
+  iree_task_set_completion_task(&cmd->dispatch.header, &cmd->depart.header);
+  if (cmd->task.header.completion_task) {
+    iree_task_set_completion_task(&cmd->depart.header,
+                                  cmd->task.header.completion_task);
+  }
+
+  // Publish our buffers and start the work once all peers have as well.
+  const iree_hal_task_channel_slot_t slot = {
+      .send = failed ? NULL : cmd->send.data,
+      .recv = failed ? NULL : cmd->recv.data,
+      .failed = failed,
+  };
+  if (!iree_hal_task_collective_arrive_all(cmd, &slot, cmd->arrive_waits,
+                                           &cmd->dispatch.header,
+                                           pending_submission)) {
+    iree_task_submission_enqueue(pending_submission, &cmd->dispatch.header);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_task_channel_provider_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_task_channel_provider_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  int32_t rank;
+  int32_t count;
+  iree_host_size_t id_length;
+  uint8_t id[IREE_HAL_TASK_CHANNEL_DEFAULT_ID_LENGTH];
+} iree_hal_task_channel_provider_t;
+
+static const iree_hal_channel_provider_vtable_t
+    iree_hal_task_channel_provider_vtable;
+
+static iree_hal_task_channel_provider_t* iree_hal_task_channel_provider_cast(
+    iree_hal_channel_provider_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_task_channel_provider_vtable);
+  return (iree_hal_task_channel_provider_t*)base_value;
+}
+
+iree_status_t iree_hal_task_channel_provider_create(
+    iree_string_view_t id, int32_t rank, int32_t count,
+    iree_allocator_t host_allocator,
+    iree_hal_channel_provider_t** out_channel_provider) {
+  IREE_ASSERT_ARGUMENT(out_channel_provider);
+  *out_channel_provider = NULL;
+  if (id.size > IREE_HAL_TASK_CHANNEL_DEFAULT_ID_LENGTH) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "channel ID must be at most %d bytes",
+                            IREE_HAL_TASK_CHANNEL_DEFAULT_ID_LENGTH);
+  }
+  if (count <= 0 || rank < 0 || rank >= count) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid channel rank %d of %d participants", rank,
+                            count);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_task_channel_provider_t* provider = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*provider),
+                                (void**)&provider));
+  memset(provider, 0, sizeof(*provider));
+  iree_hal_resource_initialize(&iree_hal_task_channel_provider_vtable,
+                               &provider->resource);
+  provider->host_allocator = host_allocator;
+  provider->rank = rank;
+  provider->count = count;
+  provider->id_length = id.size;
+  if (id.size > 0) memcpy(provider->id, id.data, id.size);
+  *out_channel_provider = (iree_hal_channel_provider_t*)provider;
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_hal_task_channel_provider_destroy(
+    iree_hal_channel_provider_t* base_channel_provider) {
+  iree_hal_task_channel_provider_t* provider =
+      iree_hal_task_channel_provider_cast(base_channel_provider);
+  iree_allocator_free(provider->host_allocator, provider);
+}
+
+static iree_status_t iree_hal_task_channel_provider_query_default_rank_and_count(
+    iree_hal_channel_provider_t* base_channel_provider, int32_t* out_rank,
+    int32_t* out_count) {
+  iree_hal_task_channel_provider_t* provider =
+      iree_hal_task_channel_provider_cast(base_channel_provider);
+  *out_rank = provider->rank;
+  *out_count = provider->count;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_task_channel_provider_exchange_default_id(
+    iree_hal_channel_provider_t* base_channel_provider, iree_byte_span_t id) {
+  iree_hal_task_channel_provider_t* provider =
+      iree_hal_task_channel_provider_cast(base_channel_provider);
+  if (id.data_length < provider->id_length) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "channel ID storage too small");
+  }
+  memset(id.data, 0, id.data_length);
+  memcpy(id.data, provider->id, provider->id_length);
+  return iree_ok_status();
+}
+
+static const iree_hal_channel_provider_vtable_t
+    iree_hal_task_channel_provider_vtable = {
+        .destroy = iree_hal_task_channel_provider_destroy,
+        .query_default_rank_and_count =
+            iree_hal_task_channel_provider_query_default_rank_and_count,
+        .exchange_default_id =
+            iree_hal_task_channel_provider_exchange_default_id,
+};
@@ -0,0 +1,124 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_DRIVERS_LOCAL_TASK_TASK_CHANNEL_H_
+#define IREE_HAL_DRIVERS_LOCAL_TASK_TASK_CHANNEL_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/task/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Size in bytes of the default channel ID exchanged through channel providers.
+// Providers used with task devices should populate at most this many bytes and
+// leave the remainder zeroed.
+#define IREE_HAL_TASK_CHANNEL_DEFAULT_ID_LENGTH 128
+
+//===----------------------------------------------------------------------===//
+// iree_hal_task_channel_t
+//===----------------------------------------------------------------------===//
+
+// Creates an in-process collective channel for |rank| of |count| participants.
+// All participants creating channels with the same |id|, |group|, and |count|
+// join the same collective group regardless of which device they were created
+// on. Participants exchange data directly through each other's host memory and
+// must all live within the same process.
+//
+// Collectives on a channel are executed in the order they are issued on each
+// participant and all participants must issue the same sequence of collectives.
+// A participant that never issues a matching collective will cause all others
+// to wait indefinitely.
+iree_status_t iree_hal_task_channel_create(iree_const_byte_span_t id,
+                                           iree_string_view_t group,
+                                           int32_t rank, int32_t count,
+                                           iree_allocator_t host_allocator,
+                                           iree_hal_channel_t** out_channel);
+
+// Returns true if |channel| is an in-process task channel.
+bool iree_hal_task_channel_isa(iree_hal_channel_t* channel);
+
+//===----------------------------------------------------------------------===//
+// iree_hal_task_collective_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_task_channel_barrier_t iree_hal_task_channel_barrier_t;
+
+// A collective operation recorded into a task command buffer.
+// Only |task| is part of the command buffer DAG. When it executes it joins the
+// other participants and forks the remaining stages with the final stage
+// joining the completion task of |task|:
+//   task (arrive) -> [arrive_waits] -> dispatch -> depart -> [depart_waits]
+// The dispatch splits the work performed by this participant across workers.
+// All stages are reinitialized on each execution so that reusable command
+// buffers can re-arm |task| alone.
+//
+// A participant that fails to start (such as due to invalid buffers) still
+// joins its peers so that none of them wait indefinitely. All participants
+// then skip the work and fail from |depart| such that the failure propagates
+// to the scope of every participant.
+typedef struct iree_hal_task_collective_t {
+  iree_task_call_t task;
+  iree_task_wait_t arrive_waits[2];
+  iree_task_dispatch_t dispatch;
+  iree_task_call_t depart;
+  iree_task_wait_t depart_waits[2];
+
+  iree_hal_channel_t* channel;
+  iree_hal_collective_op_t op;
+  uint32_t param;
+  iree_device_size_t element_count;
+
+  // Host memory of the send and recv buffers. Populated by the command buffer
+  // either when recorded or when resolved against a binding table.
+  iree_byte_span_t send;
+  iree_byte_span_t recv;
+
+  // Barriers the participant synchronizes with and its index in each.
+  iree_host_size_t barrier_count;
+  iree_hal_task_channel_barrier_t* barriers[2];
+  int32_t participants[2];
+
+  // Total number of elements processed by this participant and the first
+  // element of its shard when the work is divided among participants.
+  iree_host_size_t work_count;
+  iree_host_size_t work_offset;
+
+  // Failure of this participant to start the collective returned from |depart|
+  // once its peers have been released.
+  iree_status_t arrive_status;
+} iree_hal_task_collective_t;
+
+// Initializes |out_collective| to perform |op| on |channel|.
+// |channel| may be either a task channel or a shared memory channel
+// (iree_hal_shm_channel_t) in which case |task| performs the entire operation.
+// The caller must populate the send/recv spans prior to execution and keep
+// |channel| live until the collective is no longer in use.
+iree_status_t iree_hal_task_collective_initialize(
+    iree_task_scope_t* scope, iree_hal_channel_t* channel,
+    iree_hal_collective_op_t op, uint32_t param,
+    iree_device_size_t element_count, iree_hal_task_collective_t* out_collective);
+
+//===----------------------------------------------------------------------===//
+// iree_hal_task_channel_provider_t
+//===----------------------------------------------------------------------===//
+
+// Creates a channel provider for devices participating in an in-process
+// collective group. Each device should be assigned its own provider with a
+// unique |rank| in `[0, count)` and all providers of a group must share the
+// same |id|. Default channels created on the devices will join the group.
+iree_status_t iree_hal_task_channel_provider_create(
+    iree_string_view_t id, int32_t rank, int32_t count,
+    iree_allocator_t host_allocator,
+    iree_hal_channel_provider_t** out_channel_provider);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_DRIVERS_LOCAL_TASK_TASK_CHANNEL_H_
@@ -0,0 +1,575 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/drivers/local_task/task_channel.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/task/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+// Large enough that the work of each participant spans multiple tiles and not
+// evenly divisible by the participant counts used.
+static constexpr iree_host_size_t kElementCount = 40003;
+
+// A participant in a collective with its own scope, as if each was running on
+// its own device sharing the executor.
+struct Participant {
+  iree_task_scope_t scope;
+  iree_hal_channel_t* channel = nullptr;
+  iree_hal_task_collective_t collective;
+  std::vector<int32_t> send;
+  std::vector<int32_t> recv;
+};
+
+static iree_hal_collective_op_t MakeOp(
+    iree_hal_collective_kind_t kind,
+    iree_hal_collective_reduction_t reduction =
+        IREE_HAL_COLLECTIVE_REDUCTION_NONE) {
+  iree_hal_collective_op_t op;
+  op.packed = 0;
+  op.kind = kind;
+  op.reduction = reduction;
+  op.element_type = IREE_HAL_COLLECTIVE_ELEMENT_TYPE_SINT_32;
+  return op;
+}
+
+static uint32_t MakeSendRecvParam(int32_t target, int32_t source) {
+  return (uint32_t)(uint16_t)target | ((uint32_t)(uint16_t)source << 16);
+}
+
+class TaskChannelTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    iree_task_executor_options_t options;
+    iree_task_executor_options_initialize(&options);
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_group_count(4, &topology);
+    IREE_ASSERT_OK(iree_task_executor_create(
+        options, &topology, iree_allocator_system(), &executor_));
+    iree_task_topology_deinitialize(&topology);
+  }
+
+  void TearDown() override {
+    for (auto& participant : participants_) {
+      iree_hal_channel_release(participant.channel);
+      iree_task_scope_deinitialize(&participant.scope);
+    }
+    participants_.clear();
+    iree_task_executor_release(executor_);
+  }
+
+  // Creates |count| participants joined to a channel unique to the test.
+  void CreateParticipants(int32_t count) {
+    const ::testing::TestInfo* test_info =
+        ::testing::UnitTest::GetInstance()->current_test_info();
+    group_name_ = std::string(test_info->test_suite_name()) + "." +
+                  test_info->name();
+    participants_ = std::vector<Participant>(count);
+    for (int32_t i = 0; i < count; ++i) {
+      iree_task_scope_initialize(IREE_SV("participant"),
+                                 IREE_TASK_SCOPE_FLAG_NONE,
+                                 &participants_[i].scope);
+      IREE_ASSERT_OK(iree_hal_task_channel_create(
+          iree_make_const_byte_span("test", 4),
+          iree_make_string_view(group_name_.data(), group_name_.size()), i,
+          count, iree_allocator_system(), &participants_[i].channel));
+    }
+  }
+
+  // Issues |op| on all participants with their current send/recv buffers and
+  // waits for them to complete. Returns the status of each participant.
+  std::vector<iree_status_code_t> Run(iree_hal_collective_op_t op,
+                                      uint32_t param,
+                                      iree_host_size_t element_count) {
+    return RunOn(participants_,
+                 std::vector<iree_hal_collective_op_t>(participants_.size(), op),
+                 std::vector<uint32_t>(participants_.size(), param),
+                 element_count);
+  }
+
+  // Issues |ops|[i] with |params|[i] on each participant i.
+  std::vector<iree_status_code_t> RunOn(
+      std::vector<Participant>& participants,
+      const std::vector<iree_hal_collective_op_t>& ops,
+      const std::vector<uint32_t>& params, iree_host_size_t element_count) {
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    for (size_t i = 0; i < participants.size(); ++i) {
+      Participant& participant = participants[i];
+      IREE_CHECK_OK(iree_hal_task_collective_initialize(
+          &participant.scope, participant.channel, ops[i], params[i],
+          element_count, &participant.collective));
+      participant.collective.send = iree_make_byte_span(
+          participant.send.data(), participant.send.size() * sizeof(int32_t));
+      participant.collective.recv = iree_make_byte_span(
+          participant.recv.data(), participant.recv.size() * sizeof(int32_t));
+      iree_task_fence_t* fence = NULL;
+      IREE_CHECK_OK(iree_task_executor_acquire_fence(
+          executor_, &participant.scope, &fence));
+      iree_task_set_completion_task(&participant.collective.task.header,
+                                    &fence->header);
+      iree_task_submission_enqueue(&submission,
+                                   &participant.collective.task.header);
+    }
+    iree_task_executor_submit(executor_, &submission);
+    iree_task_executor_flush(executor_);
+    std::vector<iree_status_code_t> status_codes(participants.size(),
+                                                 IREE_STATUS_UNKNOWN);
+    for (size_t i = 0; i < participants.size(); ++i) {
+      IREE_CHECK_OK(iree_task_scope_wait_idle(&participants[i].scope,
+                                              IREE_TIME_INFINITE_FUTURE));
+      status_codes[i] = iree_status_consume_code(
+          iree_task_scope_consume_status(&participants[i].scope));
+    }
+    return status_codes;
+  }
+
+  iree_task_executor_t* executor_ = nullptr;
+  std::string group_name_;
+  std::vector<Participant> participants_;
+};
+
+static void ExpectAllOk(const std::vector<iree_status_code_t>& status_codes) {
+  for (size_t i = 0; i < status_codes.size(); ++i) {
+    EXPECT_EQ(status_codes[i], IREE_STATUS_OK) << "participant " << i;
+  }
+}
+
+TEST_F(TaskChannelTest, CreateInvalidRank) {
+  iree_hal_channel_t* channel = NULL;
+  EXPECT_THAT(Status(iree_hal_task_channel_create(
+                  iree_const_byte_span_empty(), IREE_SV("invalid"),
+                  /*rank=*/2, /*count=*/2, iree_allocator_system(), &channel)),
+              StatusIs(StatusCode::kInvalidArgument));
+  EXPECT_EQ(channel, nullptr);
+}
+
+TEST_F(TaskChannelTest, CreateDuplicateRank) {
+  CreateParticipants(2);
+  iree_hal_channel_t* channel = NULL;
+  EXPECT_THAT(Status(iree_hal_task_channel_create(
+                  iree_make_const_byte_span("test", 4),
+                  iree_make_string_view(group_name_.data(), group_name_.size()),
+                  /*rank=*/1, /*count=*/2, iree_allocator_system(), &channel)),
+              StatusIs(StatusCode::kAlreadyExists));
+  EXPECT_THAT(Status(iree_hal_task_channel_create(
+                  iree_make_const_byte_span("test", 4),
+                  iree_make_string_view(group_name_.data(), group_name_.size()),
+                  /*rank=*/1, /*count=*/3, iree_allocator_system(), &channel)),
+              StatusIs(StatusCode::kInvalidArgument));
+  EXPECT_EQ(channel, nullptr);
+}
+
+TEST_F(TaskChannelTest, AllGather) {
+  CreateParticipants(3);
+  for (int32_t i = 0; i < 3; ++i) {
+    auto& participant = participants_[i];
+    participant.send.resize(kElementCount);
+    for (iree_host_size_t j = 0; j < kElementCount; ++j) {
+      participant.send[j] = i * 1000000 + (int32_t)j;
+    }
+    participant.recv.assign(kElementCount * 3, -1);
+  }
+  ExpectAllOk(
+      Run(MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_GATHER), 0, kElementCount));
+  for (int32_t i = 0; i < 3; ++i) {
+    for (iree_host_size_t j = 0; j < kElementCount * 3; ++j) {
+      ASSERT_EQ(participants_[i].recv[j],
+                (int32_t)(j / kElementCount) * 1000000 +
+                    (int32_t)(j % kElementCount))
+          << "participant " << i << " element " << j;
+    }
+  }
+}
+
+TEST_F(TaskChannelTest, AllReduce) {
+  CreateParticipants(4);
+  const struct {
+    iree_hal_collective_reduction_t reduction;
+    int32_t (*expected)(iree_host_size_t j);
+  } cases[] = {
+      {IREE_HAL_COLLECTIVE_REDUCTION_SUM,
+       [](iree_host_size_t j) { return (int32_t)(10 * (j % 97)); }},
+      {IREE_HAL_COLLECTIVE_REDUCTION_PRODUCT,
+       [](iree_host_size_t j) { return j % 3 ? 24 : 0; }},
+      {IREE_HAL_COLLECTIVE_REDUCTION_MINIMUM,
+       [](iree_host_size_t j) { return (int32_t)(j % 97) - 4; }},
+      {IREE_HAL_COLLECTIVE_REDUCTION_MAXIMUM,
+       [](iree_host_size_t j) { return (int32_t)(4 * (j % 97)); }},
+  };
+  for (const auto& test_case : cases) {
+    for (int32_t i = 0; i < 4; ++i) {
+      auto& participant = participants_[i];
+      participant.send.resize(kElementCount);
+      for (iree_host_size_t j = 0; j < kElementCount; ++j) {
+        switch (test_case.reduction) {
+          case IREE_HAL_COLLECTIVE_REDUCTION_PRODUCT:
+            participant.send[j] = j % 3 ? i + 1 : 0;
+            break;
+          case IREE_HAL_COLLECTIVE_REDUCTION_MINIMUM:
+            participant.send[j] = (int32_t)(j % 97) - (i + 1);
+            break;
+          default:
+            participant.send[j] = (i + 1) * (int32_t)(j % 97);
+            break;
+        }
+      }
+      participant.recv.assign(kElementCount, -1);
+    }
+    ExpectAllOk(Run(MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE,
+                           test_case.reduction),
+                    0, kElementCount));
+    for (int32_t i = 0; i < 4; ++i) {
+      for (iree_host_size_t j = 0; j < kElementCount; ++j) {
+        ASSERT_EQ(participants_[i].recv[j], test_case.expected(j))
+            << "reduction " << test_case.reduction << " participant " << i
+            << " element " << j;
+      }
+    }
+  }
+}
+
+TEST_F(TaskChannelTest, AllToAll) {
+  CreateParticipants(3);
+  const iree_host_size_t element_count = 3 * 7001;
+  const iree_host_size_t block_length = element_count / 3;
+  for (int32_t i = 0; i < 3; ++i) {
+    auto& participant = participants_[i];
+    participant.send.resize(element_count);
+    for (iree_host_size_t j = 0; j < element_count; ++j) {
+      participant.send[j] = i * 1000000 + (int32_t)j;
+    }
+    participant.recv.assign(element_count, -1);
+  }
+  ExpectAllOk(
+      Run(MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_TO_ALL), 0, element_count));
+  // Block j of participant i is block i of the send buffer of participant j.
+  for (int32_t i = 0; i < 3; ++i) {
+    for (iree_host_size_t j = 0; j < element_count; ++j) {
+      const int32_t source = (int32_t)(j / block_length);
+      ASSERT_EQ(participants_[i].recv[j],
+                source * 1000000 + (int32_t)(i * block_length) +
+                    (int32_t)(j % block_length))
+          << "participant " << i << " element " << j;
+    }
+  }
+}
+
+TEST_F(TaskChannelTest, AllToAllIndivisible) {
+  CreateParticipants(3);
+  iree_hal_task_collective_t collective;
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(IREE_SV("scope"), IREE_TASK_SCOPE_FLAG_NONE,
+                             &scope);
+  EXPECT_THAT(Status(iree_hal_task_collective_initialize(
+                  &scope, participants_[0].channel,
+                  MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_TO_ALL), 0,
+                  kElementCount, &collective)),
+              StatusIs(StatusCode::kInvalidArgument));
+  iree_task_scope_deinitialize(&scope);
+}
+
+TEST_F(TaskChannelTest, BroadcastNonZeroRoot) {
+  CreateParticipants(4);
+  const int32_t root = 2;
+  for (int32_t i = 0; i < 4; ++i) {
+    auto& participant = participants_[i];
+    participant.send.assign(kElementCount, -2);
+    participant.recv.assign(kElementCount, -1);
+  }
+  for (iree_host_size_t j = 0; j < kElementCount; ++j) {
+    participants_[root].send[j] = (int32_t)j * 3;
+  }
+  ExpectAllOk(
+      Run(MakeOp(IREE_HAL_COLLECTIVE_KIND_BROADCAST), root, kElementCount));
+  for (int32_t i = 0; i < 4; ++i) {
+    for (iree_host_size_t j = 0; j < kElementCount; ++j) {
+      // The root does not receive its own data.
+      ASSERT_EQ(participants_[i].recv[j], i == root ? -1 : (int32_t)j * 3)
+          << "participant " << i << " element " << j;
+    }
+  }
+}
+
+TEST_F(TaskChannelTest, ReduceNonZeroRoot) {
+  CreateParticipants(4);
+  const int32_t root = 3;
+  for (int32_t i = 0; i < 4; ++i) {
+    auto& participant = participants_[i];
+    participant.send.resize(kElementCount);
+    for (iree_host_size_t j = 0; j < kElementCount; ++j) {
+      participant.send[j] = (i + 1) * (int32_t)(j % 101);
+    }
+    participant.recv.assign(kElementCount, -1);
+  }
+  ExpectAllOk(Run(MakeOp(IREE_HAL_COLLECTIVE_KIND_REDUCE,
+                         IREE_HAL_COLLECTIVE_REDUCTION_SUM),
+                  root, kElementCount));
+  for (int32_t i = 0; i < 4; ++i) {
+    for (iree_host_size_t j = 0; j < kElementCount; ++j) {
+      // Only the root receives the result.
+      ASSERT_EQ(participants_[i].recv[j],
+                i == root ? 10 * (int32_t)(j % 101) : -1)
+          << "participant " << i << " element " << j;
+    }
+  }
+}
+
+TEST_F(TaskChannelTest, RootOutOfRange) {
+  CreateParticipants(2);
+  iree_hal_task_collective_t collective;
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(IREE_SV("scope"), IREE_TASK_SCOPE_FLAG_NONE,
+                             &scope);
+  EXPECT_THAT(Status(iree_hal_task_collective_initialize(
+                  &scope, participants_[0].channel,
+                  MakeOp(IREE_HAL_COLLECTIVE_KIND_BROADCAST), /*param=*/2,
+                  kElementCount, &collective)),
+              StatusIs(StatusCode::kOutOfRange));
+  EXPECT_THAT(Status(iree_hal_task_collective_initialize(
+                  &scope, participants_[0].channel,
+                  MakeOp(IREE_HAL_COLLECTIVE_KIND_SEND), /*param=*/5,
+                  kElementCount, &collective)),
+              StatusIs(StatusCode::kOutOfRange));
+  iree_task_scope_deinitialize(&scope);
+}
+
+TEST_F(TaskChannelTest, ReduceScatter) {
+  CreateParticipants(3);
+  for (int32_t i = 0; i < 3; ++i) {
+    auto& participant = participants_[i];
+    participant.send.resize(kElementCount * 3);
+    for (iree_host_size_t j = 0; j < kElementCount * 3; ++j) {
+      participant.send[j] = (int32_t)j + (i == 1 ? 5 : 0);
+    }
+    participant.recv.assign(kElementCount, -1);
+  }
+  ExpectAllOk(Run(MakeOp(IREE_HAL_COLLECTIVE_KIND_REDUCE_SCATTER,
+                         IREE_HAL_COLLECTIVE_REDUCTION_MAXIMUM),
+                  0, kElementCount));
+  for (int32_t i = 0; i < 3; ++i) {
+    for (iree_host_size_t j = 0; j < kElementCount; ++j) {
+      ASSERT_EQ(participants_[i].recv[j], (int32_t)(i * kElementCount + j) + 5)
+          << "participant " << i << " element " << j;
+    }
+  }
+}
+
+TEST_F(TaskChannelTest, SendRecvRing) {
+  CreateParticipants(4);
+  for (int32_t i = 0; i < 4; ++i) {
+    auto& participant = participants_[i];
+    participant.send.resize(kElementCount);
+    for (iree_host_size_t j = 0; j < kElementCount; ++j) {
+      participant.send[j] = i * 1000000 + (int32_t)j;
+    }
+    participant.recv.assign(kElementCount, -1);
+  }
+  // Each participant sends to the next and receives from the previous.
+  std::vector<uint32_t> params;
+  for (int32_t i = 0; i < 4; ++i) {
+    params.push_back(MakeSendRecvParam((i + 1) % 4, (i + 3) % 4));
+  }
+  ExpectAllOk(RunOn(participants_,
+                    std::vector<iree_hal_collective_op_t>(
+                        4, MakeOp(IREE_HAL_COLLECTIVE_KIND_SEND_RECV)),
+                    params, kElementCount));
+  for (int32_t i = 0; i < 4; ++i) {
+    const int32_t source = (i + 3) % 4;
+    for (iree_host_size_t j = 0; j < kElementCount; ++j) {
+      ASSERT_EQ(participants_[i].recv[j], source * 1000000 + (int32_t)j)
+          << "participant " << i << " element " << j;
+    }
+  }
+}
+
+TEST_F(TaskChannelTest, SendRecvWithoutSource) {
+  CreateParticipants(2);
+  participants_[0].send.assign(kElementCount, 7);
+  participants_[0].recv.assign(kElementCount, -1);
+  participants_[1].recv.assign(kElementCount, -1);
+  // Participant 0 only sends to 1 and participant 1 only receives from 0; the
+  // receive of participant 0 has no source and is zero-filled.
+  ExpectAllOk(RunOn(participants_,
+                    std::vector<iree_hal_collective_op_t>(
+                        2, MakeOp(IREE_HAL_COLLECTIVE_KIND_SEND_RECV)),
+                    {MakeSendRecvParam(/*target=*/1, /*source=*/-1),
+                     MakeSendRecvParam(/*target=*/-1, /*source=*/0)},
+                    kElementCount));
+  for (iree_host_size_t j = 0; j < kElementCount; ++j) {
+    ASSERT_EQ(participants_[0].recv[j], 0) << "element " << j;
+    ASSERT_EQ(participants_[1].recv[j], 7) << "element " << j;
+  }
+}
+
+// Tests that back-to-back collectives on the same channels reuse the barriers
+// correctly across phases.
+TEST_F(TaskChannelTest, RepeatedCollectives) {
+  CreateParticipants(3);
+  for (int32_t i = 0; i < 3; ++i) {
+    participants_[i].send.assign(kElementCount, i + 1);
+    participants_[i].recv.assign(kElementCount, -1);
+  }
+  int32_t expected = 6;
+  for (int iteration = 0; iteration < 8; ++iteration, expected *= 3) {
+    ExpectAllOk(Run(MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE,
+                           IREE_HAL_COLLECTIVE_REDUCTION_SUM),
+                    0, kElementCount));
+    for (int32_t i = 0; i < 3; ++i) {
+      ASSERT_EQ(participants_[i].recv.front(), expected);
+      ASSERT_EQ(participants_[i].recv.back(), expected);
+      participants_[i].send = participants_[i].recv;
+    }
+  }
+}
+
+// Tests that splitting remaps ranks by color and key and that collectives on
+// the split channels only involve the members of each split.
+TEST_F(TaskChannelTest, SplitRemapsRanks) {
+  CreateParticipants(4);
+  // Even ranks form one group and odd ranks another, with keys reversing the
+  // order of ranks within each group.
+  std::vector<Participant> splits(4);
+  std::vector<std::thread> threads;
+  std::vector<iree_status_code_t> split_status_codes(4, IREE_STATUS_UNKNOWN);
+  for (int32_t i = 0; i < 4; ++i) {
+    threads.emplace_back([&, i]() {
+      split_status_codes[i] = iree_status_consume_code(iree_hal_channel_split(
+          participants_[i].channel, /*color=*/i % 2, /*key=*/-i,
+          IREE_HAL_CHANNEL_FLAG_NONE, &splits[i].channel));
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  ExpectAllOk(split_status_codes);
+
+  const int32_t expected_ranks[4] = {1, 1, 0, 0};
+  for (int32_t i = 0; i < 4; ++i) {
+    ASSERT_NE(splits[i].channel, nullptr);
+    int32_t rank = -1;
+    int32_t count = 0;
+    iree_hal_channel_query_rank_and_count(splits[i].channel, &rank, &count);
+    EXPECT_EQ(rank, expected_ranks[i]) << "participant " << i;
+    EXPECT_EQ(count, 2) << "participant " << i;
+    iree_task_scope_initialize(IREE_SV("split"), IREE_TASK_SCOPE_FLAG_NONE,
+                               &splits[i].scope);
+    splits[i].send.assign(kElementCount, i);
+    splits[i].recv.assign(kElementCount * 2, -1);
+  }
+
+  // Gathers are ordered by the split rank: {2, 0} and {3, 1}.
+  ExpectAllOk(RunOn(splits,
+                    std::vector<iree_hal_collective_op_t>(
+                        4, MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_GATHER)),
+                    std::vector<uint32_t>(4, 0), kElementCount));
+  for (int32_t i = 0; i < 4; ++i) {
+    const int32_t first = (i % 2) + 2;
+    const int32_t second = i % 2;
+    EXPECT_EQ(splits[i].recv[0], first) << "participant " << i;
+    EXPECT_EQ(splits[i].recv[kElementCount - 1], first) << "participant " << i;
+    EXPECT_EQ(splits[i].recv[kElementCount], second) << "participant " << i;
+    EXPECT_EQ(splits[i].recv.back(), second) << "participant " << i;
+  }
+
+  for (auto& split : splits) {
+    iree_hal_channel_release(split.channel);
+    iree_task_scope_deinitialize(&split.scope);
+  }
+}
+
+// Tests that participants passing NO_COLOR do not join any split.
+TEST_F(TaskChannelTest, SplitNoColor) {
+  CreateParticipants(3);
+  iree_hal_channel_t* splits[3] = {NULL, NULL, NULL};
+  std::vector<std::thread> threads;
+  for (int32_t i = 0; i < 3; ++i) {
+    threads.emplace_back([&, i]() {
+      IREE_CHECK_OK(iree_hal_channel_split(
+          participants_[i].channel,
+          i == 1 ? IREE_HAL_CHANNEL_NO_COLOR : 0, /*key=*/0,
+          IREE_HAL_CHANNEL_FLAG_NONE, &splits[i]));
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(splits[1], nullptr);
+  for (int32_t i : {0, 2}) {
+    ASSERT_NE(splits[i], nullptr);
+    int32_t rank = -1;
+    int32_t count = 0;
+    iree_hal_channel_query_rank_and_count(splits[i], &rank, &count);
+    EXPECT_EQ(rank, i / 2);
+    EXPECT_EQ(count, 2);
+    iree_hal_channel_release(splits[i]);
+  }
+}
+
+// Tests that a participant failing to start a collective fails it on all
+// participants instead of leaving them waiting and that the channel remains
+// usable afterward.
+TEST_F(TaskChannelTest, FailedParticipantPropagates) {
+  CreateParticipants(3);
+  for (int32_t i = 0; i < 3; ++i) {
+    participants_[i].send.assign(kElementCount, i + 1);
+    participants_[i].recv.assign(kElementCount, -1);
+  }
+  // Participant 1 has a recv buffer too small for the collective.
+  participants_[1].recv.resize(kElementCount / 2);
+  std::vector<iree_status_code_t> status_codes =
+      Run(MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE,
+                 IREE_HAL_COLLECTIVE_REDUCTION_SUM),
+          0, kElementCount);
+  EXPECT_EQ(status_codes[0], IREE_STATUS_ABORTED);
+  EXPECT_EQ(status_codes[1], IREE_STATUS_OUT_OF_RANGE);
+  EXPECT_EQ(status_codes[2], IREE_STATUS_ABORTED);
+  // No participant wrote any results.
+  for (int32_t i = 0; i < 3; ++i) {
+    for (int32_t value : participants_[i].recv) ASSERT_EQ(value, -1);
+  }
+
+  // Scope failures are permanent but the channel is not: the next collective
+  // succeeds once all participants are valid again.
+  for (auto& participant : participants_) {
+    iree_task_scope_deinitialize(&participant.scope);
+    iree_task_scope_initialize(IREE_SV("participant"),
+                               IREE_TASK_SCOPE_FLAG_NONE, &participant.scope);
+  }
+  participants_[1].recv.assign(kElementCount, -1);
+  ExpectAllOk(Run(MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE,
+                         IREE_HAL_COLLECTIVE_REDUCTION_SUM),
+                  0, kElementCount));
+  for (int32_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(participants_[i].recv.front(), 6);
+    EXPECT_EQ(participants_[i].recv.back(), 6);
+  }
+}
+
+// Tests that a failed receiver also fails its sender.
+TEST_F(TaskChannelTest, FailedReceiverPropagates) {
+  CreateParticipants(2);
+  participants_[0].send.assign(kElementCount, 1);
+  participants_[1].recv.assign(kElementCount / 2, -1);
+  std::vector<iree_status_code_t> status_codes =
+      RunOn(participants_,
+            {MakeOp(IREE_HAL_COLLECTIVE_KIND_SEND),
+             MakeOp(IREE_HAL_COLLECTIVE_KIND_RECV)},
+            {/*target=*/1, /*source=*/0}, kElementCount);
+  EXPECT_EQ(status_codes[0], IREE_STATUS_ABORTED);
+  EXPECT_EQ(status_codes[1], IREE_STATUS_OUT_OF_RANGE);
+}
+
+}  // namespace
+}  // namespace iree
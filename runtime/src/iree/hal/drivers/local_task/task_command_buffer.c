@@ -12,6 +12,8 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/hal/drivers/local_task/task_channel.h"
 #include "iree/hal/local/executable_environment.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_executable.h"
@@ -25,6 +27,70 @@
 // iree_hal_task_command_buffer_t
 //===----------------------------------------------------------------------===//
 
+// Snapshot of the execution state of a recorded task taken when recording ends.
+// Reusable command buffers restore each task from its snapshot prior to every
+// execution as the task system mutates the task headers as they run.
+typedef struct iree_hal_task_cmd_task_state_t {
+  struct iree_hal_task_cmd_task_state_t* next;
+  iree_task_t* task;
+  // Completion task within the command buffer DAG, if any. Exit tasks have
+  // their completion task assigned per execution.
+  iree_task_t* completion_task;
+  // Original workgroup count pointer of indirect dispatches; the task system
+  // replaces it with the sampled value when the dispatch is issued.
+  const uint32_t* workgroup_count_ptr;
+  int32_t pending_dependency_count;
+  iree_task_flags_t flags;
+} iree_hal_task_cmd_task_state_t;
+
+typedef enum iree_hal_task_cmd_fixup_type_e {
+  // Resolves to a buffer reference stored in |target_ref|. If |dispatch| is
+  // set its x workgroup count is derived from the resolved length.
+  IREE_HAL_TASK_CMD_FIXUP_TYPE_TRANSFER_REF = 0,
+  // Maps the resolved range and stores it in |target_ptr|/|target_length|.
+  IREE_HAL_TASK_CMD_FIXUP_TYPE_DISPATCH_BINDING,
+  // Maps the resolved range and uses it as the workgroup count of |dispatch|.
+  IREE_HAL_TASK_CMD_FIXUP_TYPE_WORKGROUP_COUNT,
+} iree_hal_task_cmd_fixup_type_t;
+
+// A binding table slot reference recorded into a command that must be patched
+// with the buffer from the binding table provided on each submission.
+typedef struct iree_hal_task_cmd_fixup_t {
+  struct iree_hal_task_cmd_fixup_t* next;
+  iree_hal_task_cmd_fixup_type_t type;
+  iree_hal_memory_access_t access;
+  // Slot-relative reference as recorded.
+  iree_hal_buffer_ref_t ref;
+  iree_hal_buffer_ref_t* target_ref;
+  void** target_ptr;
+  size_t* target_length;
+  iree_task_dispatch_t* dispatch;
+} iree_hal_task_cmd_fixup_t;
+
+// Value of a fixup resolved against a particular binding table.
+typedef union iree_hal_task_cmd_fixup_value_t {
+  iree_hal_buffer_ref_t ref;
+  iree_byte_span_t span;
+} iree_hal_task_cmd_fixup_value_t;
+
+typedef struct iree_hal_task_command_buffer_t iree_hal_task_command_buffer_t;
+
+// A single submission of a reusable command buffer.
+// Allocated from the submission arena and joined by all exit tasks of the
+// command buffer DAG prior to the submission retire task. When it runs the
+// recorded DAG is no longer in use and the next pending execution (if any) can
+// re-arm it.
+typedef struct iree_hal_task_command_buffer_execution_t {
+  iree_task_call_t task;
+  iree_hal_task_command_buffer_t* command_buffer;
+  // Fixup values resolved against the submission binding table.
+  iree_hal_task_cmd_fixup_value_t* fixup_values;
+  // Next execution waiting for the command buffer DAG to become available.
+  struct iree_hal_task_command_buffer_execution_t* next;
+  // Set once the execution has released the DAG to the next execution.
+  bool released;
+} iree_hal_task_command_buffer_execution_t;
+
 // iree/task/-based command buffer.
 // We track a minimal amount of state here and incrementally build out the task
 // DAG that we can submit to the task system directly. There's no intermediate
@@ -33,7 +99,14 @@
 // additional allocations required during recording or execution. That means our
 // command buffer here is essentially just a builder for the task system types
 // and manager of the lifetime of the tasks.
-typedef struct iree_hal_task_command_buffer_t {
+//
+// One-shot command buffers hand their tasks to the executor when issued.
+// Reusable command buffers keep ownership of the DAG and re-arm it from the
+// snapshot taken at the end of recording on each submission, patching any
+// binding table references in place. A DAG can only be in flight once at a
+// time and overlapping submissions of the same command buffer are queued until
+// the prior execution has completed.
+struct iree_hal_task_command_buffer_t {
   iree_hal_command_buffer_t base;
   iree_allocator_t host_allocator;
 
@@ -76,8 +149,42 @@ typedef struct iree_hal_task_command_buffer_t {
 
     // All execution tasks emitted that must execute after |open_barrier|.
     iree_task_list_t open_tasks;
+
+    // True if a collective has been emitted since the last barrier. Collectives
+    // on a channel must be issued in the same order on all participants and
+    // are serialized with each other.
+    bool open_collective;
   } state;
-} iree_hal_task_command_buffer_t;
+
+  // Binding table slot references that need to be resolved on submission.
+  iree_host_size_t fixup_count;
+  iree_hal_task_cmd_fixup_t* fixup_head;
+  iree_hal_task_cmd_fixup_t* fixup_tail;
+
+  // State used to re-arm the DAG of reusable command buffers.
+  struct {
+    // Snapshots of all recorded tasks in recording order.
+    iree_host_size_t task_count;
+    iree_hal_task_cmd_task_state_t* task_head;
+    iree_hal_task_cmd_task_state_t* task_tail;
+
+    // Tasks at the root of the DAG enqueued on each execution.
+    iree_host_size_t root_count;
+    iree_task_t** root_tasks;
+
+    // Tasks at the leaves of the DAG joined by each execution.
+    iree_host_size_t exit_count;
+    iree_task_t** exit_tasks;
+
+    // Guards the execution list.
+    iree_slim_mutex_t mutex;
+    // Execution currently using the DAG, if any.
+    iree_hal_task_command_buffer_execution_t* active;
+    // Executions waiting for the active execution to complete, in order.
+    iree_hal_task_command_buffer_execution_t* pending_head;
+    iree_hal_task_command_buffer_execution_t* pending_tail;
+  } reuse;
+};
 
 static const iree_hal_command_buffer_vtable_t
     iree_hal_task_command_buffer_vtable;
@@ -98,25 +205,6 @@ iree_status_t iree_hal_task_command_buffer_create(
   IREE_ASSERT_ARGUMENT(out_command_buffer);
   *out_command_buffer = NULL;
 
-  if (!iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
-    // If we want reuse we'd need to support duplicating the task DAG after
-    // recording or have some kind of copy-on-submit behavior that does so if
-    // a command buffer is submitted for execution twice. Allowing for the same
-    // command buffer to be enqueued multiple times would be fine so long as
-    // execution doesn't overlap (`cmdbuf|cmdbuf` vs
-    // `cmdbuf -> semaphore -> cmdbuf`) though we'd still need to be careful
-    // that we did the enqueuing and reset of the task structures at the right
-    // times. Definitely something that'll be useful in the future... but not
-    // today :)
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "only one-shot command buffer usage is supported");
-  }
-  if (binding_capacity > 0) {
-    // TODO(#10144): support indirect command buffers with binding tables.
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "indirect command buffers not yet implemented");
-  }
-
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_task_command_buffer_t* command_buffer = NULL;
@@ -136,6 +224,11 @@ iree_status_t iree_hal_task_command_buffer_create(
     iree_task_list_initialize(&command_buffer->root_tasks);
     iree_task_list_initialize(&command_buffer->leaf_tasks);
     memset(&command_buffer->state, 0, sizeof(command_buffer->state));
+    command_buffer->fixup_count = 0;
+    command_buffer->fixup_head = NULL;
+    command_buffer->fixup_tail = NULL;
+    memset(&command_buffer->reuse, 0, sizeof(command_buffer->reuse));
+    iree_slim_mutex_initialize(&command_buffer->reuse.mutex);
     status = iree_hal_resource_set_allocate(block_pool,
                                             &command_buffer->resource_set);
   }
@@ -159,6 +252,8 @@ static void iree_hal_task_command_buffer_destroy(
   memset(&command_buffer->state, 0, sizeof(command_buffer->state));
   iree_task_list_discard(&command_buffer->root_tasks);
   iree_task_list_discard(&command_buffer->leaf_tasks);
+  IREE_ASSERT(!command_buffer->reuse.active);
+  iree_slim_mutex_deinitialize(&command_buffer->reuse.mutex);
   iree_arena_deinitialize(&command_buffer->arena);
   iree_hal_resource_set_free(command_buffer->resource_set);
   iree_allocator_free(host_allocator, command_buffer);
@@ -179,17 +274,83 @@ bool iree_hal_task_command_buffer_isa(
 static iree_status_t iree_hal_task_command_buffer_flush_tasks(
     iree_hal_task_command_buffer_t* command_buffer);
 
+static bool iree_hal_task_command_buffer_is_reusable(
+    iree_hal_task_command_buffer_t* command_buffer) {
+  return !iree_all_bits_set(iree_hal_command_buffer_mode(&command_buffer->base),
+                            IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT);
+}
+
 static iree_status_t iree_hal_task_command_buffer_begin(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
-  if (!iree_task_list_is_empty(&command_buffer->root_tasks)) {
+  if (!iree_task_list_is_empty(&command_buffer->root_tasks) ||
+      command_buffer->reuse.task_count > 0) {
     return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
                             "command buffer cannot be re-recorded");
   }
   return iree_ok_status();
 }
 
+// Copies the tasks in |list| into a new array allocated from the command
+// buffer arena.
+static iree_status_t iree_hal_task_command_buffer_copy_task_list(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_list_t* list,
+    iree_host_size_t* out_count, iree_task_t*** out_tasks) {
+  iree_host_size_t count = 0;
+  for (iree_task_t* task = iree_task_list_front(list); task != NULL;
+       task = task->next_task) {
+    ++count;
+  }
+  iree_task_t** tasks = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(
+      &command_buffer->arena, count * sizeof(*tasks), (void**)&tasks));
+  iree_host_size_t i = 0;
+  for (iree_task_t* task = iree_task_list_front(list); task != NULL;
+       task = task->next_task) {
+    tasks[i++] = task;
+  }
+  *out_count = count;
+  *out_tasks = tasks;
+  return iree_ok_status();
+}
+
+// Captures the state of the recorded DAG such that it can be restored prior to
+// each execution of a reusable command buffer. The root and leaf task lists are
+// consumed as the command buffer retains ownership of the tasks.
+static iree_status_t iree_hal_task_command_buffer_snapshot_tasks(
+    iree_hal_task_command_buffer_t* command_buffer) {
+  if (command_buffer->reuse.task_count == 0) return iree_ok_status();
+  for (iree_hal_task_cmd_task_state_t* state = command_buffer->reuse.task_head;
+       state != NULL; state = state->next) {
+    iree_task_t* task = state->task;
+    state->completion_task = task->completion_task;
+    state->pending_dependency_count = iree_atomic_load(
+        &task->pending_dependency_count, iree_memory_order_relaxed);
+    state->flags = task->flags;
+    if (task->type == IREE_TASK_TYPE_DISPATCH &&
+        iree_all_bits_set(task->flags, IREE_TASK_FLAG_DISPATCH_INDIRECT)) {
+      state->workgroup_count_ptr =
+          ((iree_task_dispatch_t*)task)->workgroup_count.ptr;
+    }
+  }
+
+  // If there are no leaf tasks then the root tasks are also the exits.
+  iree_task_list_t* exit_list =
+      iree_task_list_is_empty(&command_buffer->leaf_tasks)
+          ? &command_buffer->root_tasks
+          : &command_buffer->leaf_tasks;
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_copy_task_list(
+      command_buffer, exit_list, &command_buffer->reuse.exit_count,
+      &command_buffer->reuse.exit_tasks));
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_copy_task_list(
+      command_buffer, &command_buffer->root_tasks,
+      &command_buffer->reuse.root_count, &command_buffer->reuse.root_tasks));
+  iree_task_list_initialize(&command_buffer->root_tasks);
+  iree_task_list_initialize(&command_buffer->leaf_tasks);
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_task_command_buffer_end(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_task_command_buffer_t* command_buffer =
@@ -207,11 +368,77 @@ static iree_status_t iree_hal_task_command_buffer_end(
                         &command_buffer->root_tasks);
   }
 
+  if (iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_task_command_buffer_snapshot_tasks(command_buffer));
+  }
+
   iree_hal_resource_set_freeze(command_buffer->resource_set);
 
   return iree_ok_status();
 }
 
+// Tracks |task| for re-arming if the command buffer is reusable.
+static iree_status_t iree_hal_task_command_buffer_track_task(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task) {
+  if (!iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    return iree_ok_status();
+  }
+  iree_hal_task_cmd_task_state_t* state = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
+                                           sizeof(*state), (void**)&state));
+  memset(state, 0, sizeof(*state));
+  state->task = task;
+  if (command_buffer->reuse.task_tail) {
+    command_buffer->reuse.task_tail->next = state;
+  } else {
+    command_buffer->reuse.task_head = state;
+  }
+  command_buffer->reuse.task_tail = state;
+  ++command_buffer->reuse.task_count;
+  return iree_ok_status();
+}
+
+// Records a fixup for the binding table slot reference |ref| that will be
+// resolved on each submission. The caller populates the fixup targets.
+static iree_status_t iree_hal_task_command_buffer_append_fixup(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_task_cmd_fixup_type_t type, iree_hal_memory_access_t access,
+    iree_hal_buffer_ref_t ref, iree_hal_task_cmd_fixup_t** out_fixup) {
+  iree_hal_task_cmd_fixup_t* fixup = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
+                                           sizeof(*fixup), (void**)&fixup));
+  memset(fixup, 0, sizeof(*fixup));
+  fixup->type = type;
+  fixup->access = access;
+  fixup->ref = ref;
+  if (command_buffer->fixup_tail) {
+    command_buffer->fixup_tail->next = fixup;
+  } else {
+    command_buffer->fixup_head = fixup;
+  }
+  command_buffer->fixup_tail = fixup;
+  ++command_buffer->fixup_count;
+  *out_fixup = fixup;
+  return iree_ok_status();
+}
+
+// Records a fixup for |ref| into |target_ref| of a transfer command if it
+// references a binding table slot. |dispatch| is optional and will have its
+// workgroup count derived from the resolved length.
+static iree_status_t iree_hal_task_command_buffer_append_transfer_fixup(
+    iree_hal_task_command_buffer_t* command_buffer, iree_hal_buffer_ref_t ref,
+    iree_hal_buffer_ref_t* target_ref, iree_task_dispatch_t* dispatch) {
+  if (ref.buffer) return iree_ok_status();
+  iree_hal_task_cmd_fixup_t* fixup = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_append_fixup(
+      command_buffer, IREE_HAL_TASK_CMD_FIXUP_TYPE_TRANSFER_REF,
+      IREE_HAL_MEMORY_ACCESS_NONE, ref, &fixup));
+  fixup->target_ref = target_ref;
+  fixup->dispatch = dispatch;
+  return iree_ok_status();
+}
+
 // Flushes all open tasks to the previous barrier and prepares for more
 // recording. The root tasks are also populated here when required as this is
 // the one place where we can see both halves of the most recent synchronization
@@ -283,6 +510,8 @@ static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
   IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
                                            sizeof(*barrier), (void**)&barrier));
   iree_task_barrier_initialize_empty(command_buffer->scope, barrier);
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_track_task(
+      command_buffer, &barrier->header));
 
   // If there were previous tasks then join them to the barrier.
   for (iree_task_t* task = iree_task_list_front(&command_buffer->leaf_tasks);
@@ -311,6 +540,7 @@ static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
   // NOTE: all new tasks emitted will be executed after this barrier.
   command_buffer->state.open_barrier = barrier;
   command_buffer->state.open_task_count = 0;
+  command_buffer->state.open_collective = false;
 
   return iree_ok_status();
 }
@@ -319,6 +549,8 @@ static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
 // scope (after state.open_barrier and before the next barrier).
 static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
     iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task) {
+  IREE_RETURN_IF_ERROR(
+      iree_hal_task_command_buffer_track_task(command_buffer, task));
   if (command_buffer->state.open_barrier == NULL) {
     // If there is no open barrier then we are at the head and going right into
     // the task DAG.
@@ -335,20 +567,102 @@ static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
 // iree_hal_task_command_buffer_t execution
 //===----------------------------------------------------------------------===//
 
-iree_status_t iree_hal_task_command_buffer_issue(
-    iree_hal_command_buffer_t* base_command_buffer,
-    iree_hal_task_queue_state_t* queue_state, iree_task_t* retire_task,
-    iree_arena_allocator_t* arena, iree_task_submission_t* pending_submission) {
-  iree_hal_task_command_buffer_t* command_buffer =
-      iree_hal_task_command_buffer_cast(base_command_buffer);
-  IREE_ASSERT_TRUE(command_buffer);
+// Resolves all fixups of |command_buffer| against |binding_table| and returns
+// an array of values allocated from |arena| in fixup order.
+static iree_status_t iree_hal_task_command_buffer_resolve_fixups(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_buffer_binding_table_t binding_table,
+    iree_arena_allocator_t* arena,
+    iree_hal_task_cmd_fixup_value_t** out_values) {
+  *out_values = NULL;
+  if (command_buffer->fixup_count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, command_buffer->fixup_count);
+
+  iree_hal_task_cmd_fixup_value_t* values = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_arena_allocate(arena,
+                              command_buffer->fixup_count * sizeof(*values),
+                              (void**)&values));
+
+  iree_hal_task_cmd_fixup_value_t* value = values;
+  for (const iree_hal_task_cmd_fixup_t* fixup = command_buffer->fixup_head;
+       fixup != NULL; fixup = fixup->next, ++value) {
+    iree_hal_buffer_ref_t resolved_ref;
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_hal_buffer_binding_table_resolve_ref(binding_table, fixup->ref,
+                                                      &resolved_ref));
+    if (IREE_UNLIKELY(!resolved_ref.buffer)) {
+      IREE_TRACE_ZONE_END(z0);
+      return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "binding table slot %u is NULL; all referenced "
+                              "bindings must have a valid buffer",
+                              (uint32_t)fixup->ref.buffer_slot);
+    }
+    if (fixup->type == IREE_HAL_TASK_CMD_FIXUP_TYPE_TRANSFER_REF) {
+      value->ref = resolved_ref;
+      continue;
+    }
+    // The submission retains the bound buffers until it retires so the mapped
+    // host pointer remains valid for the duration of the execution.
+    iree_hal_buffer_mapping_t buffer_mapping = {{0}};
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_hal_buffer_map_range(
+                resolved_ref.buffer, IREE_HAL_MAPPING_MODE_PERSISTENT,
+                fixup->access, resolved_ref.offset, resolved_ref.length,
+                &buffer_mapping));
+    value->span = buffer_mapping.contents;
+  }
+
+  *out_values = values;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
 
+// Patches the resolved fixup |values| into the recorded commands.
+static void iree_hal_task_command_buffer_apply_fixups(
+    iree_hal_task_command_buffer_t* command_buffer,
+    const iree_hal_task_cmd_fixup_value_t* values) {
+  const iree_hal_task_cmd_fixup_value_t* value = values;
+  for (const iree_hal_task_cmd_fixup_t* fixup = command_buffer->fixup_head;
+       fixup != NULL; fixup = fixup->next, ++value) {
+    switch (fixup->type) {
+      case IREE_HAL_TASK_CMD_FIXUP_TYPE_TRANSFER_REF:
+        *fixup->target_ref = value->ref;
+        if (fixup->dispatch) {
+          fixup->dispatch->workgroup_count.value[0] =
+              (uint32_t)iree_device_size_ceil_div(
+                  value->ref.length, fixup->dispatch->workgroup_size[0]);
+        }
+        break;
+      case IREE_HAL_TASK_CMD_FIXUP_TYPE_DISPATCH_BINDING:
+        *fixup->target_ptr = value->span.data;
+        *fixup->target_length = (size_t)value->span.data_length;
+        break;
+      case IREE_HAL_TASK_CMD_FIXUP_TYPE_WORKGROUP_COUNT:
+        fixup->dispatch->workgroup_count.ptr =
+            (const uint32_t*)value->span.data;
+        break;
+    }
+  }
+}
+
+static iree_status_t iree_hal_task_command_buffer_issue_one_shot(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_buffer_binding_table_t binding_table, iree_task_t* retire_task,
+    iree_arena_allocator_t* arena, iree_task_submission_t* pending_submission) {
   // If the command buffer is empty (valid!) then we are a no-op.
   bool has_root_tasks = !iree_task_list_is_empty(&command_buffer->root_tasks);
   if (!has_root_tasks) {
     return iree_ok_status();
   }
 
+  // Patch in any binding table references.
+  iree_hal_task_cmd_fixup_value_t* fixup_values = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_resolve_fixups(
+      command_buffer, binding_table, arena, &fixup_values));
+  iree_hal_task_command_buffer_apply_fixups(command_buffer, fixup_values);
+
   bool has_leaf_tasks = !iree_task_list_is_empty(&command_buffer->leaf_tasks);
   if (has_leaf_tasks) {
     // Chain the retire task onto the leaf tasks as their completion indicates
@@ -376,6 +690,184 @@ iree_status_t iree_hal_task_command_buffer_issue(
   return iree_ok_status();
 }
 
+// Restores the recorded DAG of a reusable command buffer, patches in the
+// bindings of |execution|, and enqueues the root tasks.
+// The DAG must not be in use by any other execution.
+static void iree_hal_task_command_buffer_arm(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_task_command_buffer_execution_t* execution,
+    iree_task_submission_t* pending_submission) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, command_buffer->reuse.task_count);
+
+  for (const iree_hal_task_cmd_task_state_t* state =
+           command_buffer->reuse.task_head;
+       state != NULL; state = state->next) {
+    iree_task_t* task = state->task;
+    task->next_task = NULL;
+    task->completion_task = state->completion_task;
+    iree_atomic_store(&task->pending_dependency_count,
+                      state->pending_dependency_count,
+                      iree_memory_order_relaxed);
+    task->flags = state->flags;
+    if (task->type == IREE_TASK_TYPE_DISPATCH) {
+      iree_task_dispatch_t* dispatch_task = (iree_task_dispatch_t*)task;
+      if (iree_all_bits_set(state->flags, IREE_TASK_FLAG_DISPATCH_INDIRECT)) {
+        dispatch_task->workgroup_count.ptr = state->workgroup_count_ptr;
+      }
+      memset(&dispatch_task->statistics, 0, sizeof(dispatch_task->statistics));
+    }
+  }
+
+  iree_hal_task_command_buffer_apply_fixups(command_buffer,
+                                            execution->fixup_values);
+
+  // All exit tasks join on the execution so we know when the DAG is available.
+  for (iree_host_size_t i = 0; i < command_buffer->reuse.exit_count; ++i) {
+    iree_task_set_completion_task(command_buffer->reuse.exit_tasks[i],
+                                  &execution->task.header);
+  }
+
+  iree_task_list_t root_tasks;
+  iree_task_list_initialize(&root_tasks);
+  for (iree_host_size_t i = 0; i < command_buffer->reuse.root_count; ++i) {
+    iree_task_list_push_back(&root_tasks, command_buffer->reuse.root_tasks[i]);
+  }
+  iree_task_submission_enqueue_list(pending_submission, &root_tasks);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Runs after all tasks of the DAG have completed and hands it off to the next
+// pending execution, if any.
+static iree_status_t iree_hal_task_command_buffer_execution_retire(
+    void* user_context, iree_task_t* task,
+    iree_task_submission_t* pending_submission) {
+  iree_hal_task_command_buffer_execution_t* execution =
+      (iree_hal_task_command_buffer_execution_t*)user_context;
+  iree_hal_task_command_buffer_t* command_buffer = execution->command_buffer;
+  execution->released = true;
+
+  iree_slim_mutex_lock(&command_buffer->reuse.mutex);
+  iree_hal_task_command_buffer_execution_t* next_execution =
+      command_buffer->reuse.pending_head;
+  if (next_execution) {
+    command_buffer->reuse.pending_head = next_execution->next;
+    if (!command_buffer->reuse.pending_head) {
+      command_buffer->reuse.pending_tail = NULL;
+    }
+  }
+  command_buffer->reuse.active = next_execution;
+  iree_slim_mutex_unlock(&command_buffer->reuse.mutex);
+
+  if (next_execution) {
+    iree_hal_task_command_buffer_arm(command_buffer, next_execution,
+                                     pending_submission);
+  }
+  return iree_ok_status();
+}
+
+// Cleanup for executions that did not run (the DAG or scope failed). The DAG
+// is released and all pending executions are discarded as they would be
+// discarded by the failed scope as well.
+static void iree_hal_task_command_buffer_execution_cleanup(
+    iree_task_t* task, iree_status_code_t status_code) {
+  iree_hal_task_command_buffer_execution_t* execution =
+      (iree_hal_task_command_buffer_execution_t*)task;
+  if (execution->released) return;
+  execution->released = true;
+  iree_hal_task_command_buffer_t* command_buffer = execution->command_buffer;
+
+  iree_slim_mutex_lock(&command_buffer->reuse.mutex);
+  iree_hal_task_command_buffer_execution_t* pending_head =
+      command_buffer->reuse.pending_head;
+  command_buffer->reuse.pending_head = NULL;
+  command_buffer->reuse.pending_tail = NULL;
+  command_buffer->reuse.active = NULL;
+  iree_slim_mutex_unlock(&command_buffer->reuse.mutex);
+
+  while (pending_head) {
+    iree_hal_task_command_buffer_execution_t* pending_execution = pending_head;
+    pending_head = pending_execution->next;
+    pending_execution->released = true;
+    iree_task_list_t discard_worklist;
+    iree_task_list_initialize(&discard_worklist);
+    iree_task_discard(&pending_execution->task.header, &discard_worklist);
+    iree_task_list_discard(&discard_worklist);
+  }
+}
+
+static iree_status_t iree_hal_task_command_buffer_issue_reusable(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_buffer_binding_table_t binding_table, iree_task_t* retire_task,
+    iree_arena_allocator_t* arena, iree_task_submission_t* pending_submission) {
+  // If the command buffer is empty (valid!) then we are a no-op.
+  if (command_buffer->reuse.task_count == 0) {
+    return iree_ok_status();
+  }
+
+  // Resolve bindings now so that failures are reported by the submission. The
+  // values are patched into the DAG when the execution arms it.
+  iree_hal_task_cmd_fixup_value_t* fixup_values = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_resolve_fixups(
+      command_buffer, binding_table, arena, &fixup_values));
+
+  iree_hal_task_command_buffer_execution_t* execution = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_arena_allocate(arena, sizeof(*execution), (void**)&execution));
+  iree_task_call_initialize(
+      command_buffer->scope,
+      iree_task_make_call_closure(iree_hal_task_command_buffer_execution_retire,
+                                  execution),
+      &execution->task);
+  iree_task_set_cleanup_fn(&execution->task.header,
+                           iree_hal_task_command_buffer_execution_cleanup);
+  iree_task_set_completion_task(&execution->task.header, retire_task);
+  execution->command_buffer = command_buffer;
+  execution->fixup_values = fixup_values;
+  execution->next = NULL;
+  execution->released = false;
+
+  // Arm immediately if the DAG is available and otherwise queue behind the
+  // prior execution. The submission retire task will not run until the
+  // execution does.
+  iree_slim_mutex_lock(&command_buffer->reuse.mutex);
+  const bool is_available = command_buffer->reuse.active == NULL;
+  if (is_available) {
+    command_buffer->reuse.active = execution;
+  } else if (command_buffer->reuse.pending_tail) {
+    command_buffer->reuse.pending_tail->next = execution;
+    command_buffer->reuse.pending_tail = execution;
+  } else {
+    command_buffer->reuse.pending_head = execution;
+    command_buffer->reuse.pending_tail = execution;
+  }
+  iree_slim_mutex_unlock(&command_buffer->reuse.mutex);
+  if (is_available) {
+    iree_hal_task_command_buffer_arm(command_buffer, execution,
+                                     pending_submission);
+  }
+
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_task_command_buffer_issue(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_task_queue_state_t* queue_state,
+    iree_hal_buffer_binding_table_t binding_table, iree_task_t* retire_task,
+    iree_arena_allocator_t* arena, iree_task_submission_t* pending_submission) {
+  iree_hal_task_command_buffer_t* command_buffer =
+      iree_hal_task_command_buffer_cast(base_command_buffer);
+  IREE_ASSERT_TRUE(command_buffer);
+  if (iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    return iree_hal_task_command_buffer_issue_reusable(
+        command_buffer, binding_table, retire_task, arena, pending_submission);
+  } else {
+    return iree_hal_task_command_buffer_issue_one_shot(
+        command_buffer, binding_table, retire_task, arena, pending_submission);
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_task_command_buffer_t debug utilities
 //===----------------------------------------------------------------------===//
@@ -540,6 +1032,8 @@ static iree_status_t iree_hal_task_command_buffer_fill_buffer(
   cmd->target_ref = target_ref;
   memcpy(cmd->pattern, pattern, pattern_length);
   cmd->pattern_length = pattern_length;
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_append_transfer_fixup(
+      command_buffer, target_ref, &cmd->target_ref, &cmd->task));
 
   return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
                                                           &cmd->task.header);
@@ -592,6 +1086,8 @@ static iree_status_t iree_hal_task_command_buffer_update_buffer(
   cmd->target_ref = target_ref;
   memcpy(cmd->source_buffer, (const uint8_t*)source_buffer + source_offset,
          cmd->target_ref.length);
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_append_transfer_fixup(
+      command_buffer, target_ref, &cmd->target_ref, /*dispatch=*/NULL));
 
   return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
                                                           &cmd->task.header);
@@ -673,6 +1169,10 @@ static iree_status_t iree_hal_task_command_buffer_copy_buffer(
       workgroup_size, workgroup_count, &cmd->task);
   cmd->source_ref = source_ref;
   cmd->target_ref = target_ref;
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_append_transfer_fixup(
+      command_buffer, source_ref, &cmd->source_ref, /*dispatch=*/NULL));
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_append_transfer_fixup(
+      command_buffer, target_ref, &cmd->target_ref, &cmd->task));
 
   return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
                                                           &cmd->task.header);
@@ -682,30 +1182,66 @@ static iree_status_t iree_hal_task_command_buffer_copy_buffer(
 // iree_hal_command_buffer_collective
 //===----------------------------------------------------------------------===//
 
+// Populates |out_span| with the host memory of |ref| if it references a
+// buffer and otherwise records a fixup to populate it on each submission.
+static iree_status_t iree_hal_task_command_buffer_map_collective_ref(
+    iree_hal_task_command_buffer_t* command_buffer, iree_hal_buffer_ref_t ref,
+    iree_hal_memory_access_t access, iree_byte_span_t* out_span) {
+  *out_span = iree_make_byte_span(NULL, 0);
+  if (ref.buffer) {
+    iree_hal_buffer_mapping_t buffer_mapping = {{0}};
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
+        ref.buffer, IREE_HAL_MAPPING_MODE_PERSISTENT, access, ref.offset,
+        ref.length, &buffer_mapping));
+    *out_span = buffer_mapping.contents;
+  } else if (ref.length != 0 && command_buffer->base.binding_capacity > 0) {
+    iree_hal_task_cmd_fixup_t* fixup = NULL;
+    IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_append_fixup(
+        command_buffer, IREE_HAL_TASK_CMD_FIXUP_TYPE_DISPATCH_BINDING, access,
+        ref, &fixup));
+    fixup->target_ptr = (void**)&out_span->data;
+    fixup->target_length = &out_span->data_length;
+  }
+  return iree_ok_status();
+}
+
+// Collectives are executed by the participants directly accessing each other's
+// host memory. See iree_hal_task_collective_t for how each is scheduled.
 static iree_status_t iree_hal_task_command_buffer_collective(
     iree_hal_command_buffer_t* base_command_buffer, iree_hal_channel_t* channel,
     iree_hal_collective_op_t op, uint32_t param, iree_hal_buffer_ref_t send_ref,
     iree_hal_buffer_ref_t recv_ref, iree_device_size_t element_count) {
-  // The channel can be used as a vtable if we want to inject collective APIs -
-  // the device creation function would set up the channel once and we'll
-  // receive it here each time. When interacting with the task system we want to
-  // get wait handles we can model with iree_task_wait_t.
-  //
-  // An example basic flow:
-  //   insert iree_task_call_t:
-  //     chains with prior commands and makes the collective API call
-  //   insert iree_task_wait_t with API wait handle or our event:
-  //     chains with call
-  //
-  // What we probably want to do, though, is group the commands based on
-  // execution barriers. When a new collective command comes in we should
-  // reserve an event from the event pool, create the call to issue the
-  // collective operation, and then track the event in the command buffer state.
-  // When another collective call comes in we'll do the same and append the
-  // event. At the next execution barrier (or non-collective command) we'd
-  // flush to a multi-wait on all of the pending events.
-  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                          "collectives not yet implemented on the task system");
+  iree_hal_task_command_buffer_t* command_buffer =
+      iree_hal_task_command_buffer_cast(base_command_buffer);
+
+  const void* resources[3] = {
+      channel,
+      send_ref.buffer,
+      recv_ref.buffer,
+  };
+  IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
+      command_buffer->resource_set, IREE_ARRAYSIZE(resources), resources));
+
+  // Collectives on the same channel must not overlap as their arrival order
+  // would differ between participants.
+  if (command_buffer->state.open_collective) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_task_command_buffer_emit_global_barrier(command_buffer));
+  }
+
+  iree_hal_task_collective_t* cmd = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_arena_allocate(&command_buffer->arena, sizeof(*cmd), (void**)&cmd));
+  IREE_RETURN_IF_ERROR(iree_hal_task_collective_initialize(
+      command_buffer->scope, channel, op, param, element_count, cmd));
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_map_collective_ref(
+      command_buffer, send_ref, IREE_HAL_MEMORY_ACCESS_READ, &cmd->send));
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_map_collective_ref(
+      command_buffer, recv_ref, IREE_HAL_MEMORY_ACCESS_WRITE, &cmd->recv));
+
+  command_buffer->state.open_collective = true;
+  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
+                                                          &cmd->task.header);
 }
 
 //===----------------------------------------------------------------------===//
@@ -752,7 +1288,7 @@ static iree_status_t iree_hal_task_cmd_dispatch_tile(
       .workgroup_count_y = tile_context->workgroup_count[1],
       .workgroup_count_z = tile_context->workgroup_count[2],
       .max_concurrency =
-          iree_task_affinity_set_count_ones(cmd->task.header.affinity_set),
+          iree_task_affinity_worker_count(cmd->task.header.affinity),
       .binding_count = cmd->binding_count,
   };
   uint8_t* cmd_ptr = (uint8_t*)cmd + sizeof(*cmd);
@@ -790,8 +1326,9 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
 
-  iree_hal_local_executable_t* local_executable =
-      iree_hal_local_executable_cast(executable);
+  iree_hal_local_executable_t* local_executable = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_local_executable_resolve(executable, &local_executable));
   iree_hal_executable_dispatch_attrs_v0_t dispatch_attrs = {0};
   if (local_executable->dispatch_attrs) {
     dispatch_attrs = local_executable->dispatch_attrs[entry_point];
@@ -849,7 +1386,8 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
   //
   // Note that we are just directly setting the binding data pointers here with
   // no ownership/retaining/etc - it's part of the HAL contract that buffers are
-  // kept valid for the duration they may be in use.
+  // kept valid for the duration they may be in use. Bindings referencing
+  // binding table slots are patched in on each submission.
   if (IREE_UNLIKELY(bindings.count != dispatch_attrs.binding_count)) {
     return iree_make_status(
         IREE_STATUS_INVALID_ARGUMENT,
@@ -871,6 +1409,13 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
           binding.buffer, IREE_HAL_MAPPING_MODE_PERSISTENT,
           IREE_HAL_MEMORY_ACCESS_ANY, binding.offset, binding.length,
           &buffer_mapping));
+    } else if (command_buffer->base.binding_capacity > 0) {
+      iree_hal_task_cmd_fixup_t* fixup = NULL;
+      IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_append_fixup(
+          command_buffer, IREE_HAL_TASK_CMD_FIXUP_TYPE_DISPATCH_BINDING,
+          IREE_HAL_MEMORY_ACCESS_ANY, bindings.values[i], &fixup));
+      fixup->target_ptr = &binding_ptrs[i];
+      fixup->target_length = &binding_lengths[i];
     } else {
       return iree_make_status(
           IREE_STATUS_FAILED_PRECONDITION,
@@ -921,10 +1466,12 @@ static iree_status_t iree_hal_task_command_buffer_dispatch_indirect(
 
   // TODO(benvanik): track mapping so we can properly map/unmap/flush/etc.
   iree_hal_buffer_mapping_t buffer_mapping = {{0}};
-  IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
-      workgroups_ref.buffer, IREE_HAL_MAPPING_MODE_PERSISTENT,
-      IREE_HAL_MEMORY_ACCESS_READ, workgroups_ref.offset, 3 * sizeof(uint32_t),
-      &buffer_mapping));
+  if (workgroups_ref.buffer) {
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
+        workgroups_ref.buffer, IREE_HAL_MAPPING_MODE_PERSISTENT,
+        IREE_HAL_MEMORY_ACCESS_READ, workgroups_ref.offset,
+        3 * sizeof(uint32_t), &buffer_mapping));
+  }
 
   uint32_t workgroup_count[3] = {0};  // unused with the indirect flag
   iree_hal_task_cmd_dispatch_t* cmd = NULL;
@@ -933,6 +1480,14 @@ static iree_status_t iree_hal_task_command_buffer_dispatch_indirect(
       bindings, &cmd));
   cmd->task.workgroup_count.ptr = (const uint32_t*)buffer_mapping.contents.data;
   cmd->task.header.flags |= IREE_TASK_FLAG_DISPATCH_INDIRECT;
+  if (!workgroups_ref.buffer) {
+    workgroups_ref.length = 3 * sizeof(uint32_t);
+    iree_hal_task_cmd_fixup_t* fixup = NULL;
+    IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_append_fixup(
+        command_buffer, IREE_HAL_TASK_CMD_FIXUP_TYPE_WORKGROUP_COUNT,
+        IREE_HAL_MEMORY_ACCESS_READ, workgroups_ref, &fixup));
+    fixup->dispatch = &cmd->task;
+  }
   return iree_ok_status();
 }
 
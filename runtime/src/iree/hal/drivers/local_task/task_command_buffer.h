@@ -35,6 +35,13 @@ bool iree_hal_task_command_buffer_isa(
 // prior commands such as signaled events and will be mutated as events are
 // reset or new events are signaled.
 //
+// |binding_table| provides the buffers for any binding table slots referenced
+// by the commands and must remain valid until |retire_task| has completed.
+//
+// One-shot command buffers transfer their tasks to the submission. Reusable
+// command buffers re-arm their task DAG for each issue; if a prior issue is
+// still executing the new issue is queued and runs once it has completed.
+//
 // |retire_task| will be scheduled once all commands issued from the command
 // buffer retire and can be used as a fence point.
 //
@@ -48,7 +55,8 @@ bool iree_hal_task_command_buffer_isa(
 // submitted to the executor (or discarded on failure) by the caller.
 iree_status_t iree_hal_task_command_buffer_issue(
     iree_hal_command_buffer_t* command_buffer,
-    iree_hal_task_queue_state_t* queue_state, iree_task_t* retire_task,
+    iree_hal_task_queue_state_t* queue_state,
+    iree_hal_buffer_binding_table_t binding_table, iree_task_t* retire_task,
     iree_arena_allocator_t* arena, iree_task_submission_t* pending_submission);
 
 #ifdef __cplusplus
@@ -12,15 +12,16 @@
 
 #include "iree/base/internal/arena.h"
 #include "iree/base/internal/cpu.h"
+#include "iree/hal/drivers/local_task/task_channel.h"
 #include "iree/hal/drivers/local_task/task_command_buffer.h"
 #include "iree/hal/drivers/local_task/task_event.h"
 #include "iree/hal/drivers/local_task/task_queue.h"
 #include "iree/hal/drivers/local_task/task_semaphore.h"
 #include "iree/hal/local/executable_environment.h"
 #include "iree/hal/local/local_executable_cache.h"
-#include "iree/hal/utils/deferred_command_buffer.h"
+#include "iree/hal/utils/file_registry.h"
 #include "iree/hal/utils/file_transfer.h"
-#include "iree/hal/utils/memory_file.h"
+#include "iree/hal/utils/shm_channel.h"
 
 typedef struct iree_hal_task_device_t {
   iree_hal_resource_t resource;
@@ -42,6 +43,15 @@ typedef struct iree_hal_task_device_t {
   // Optional provider used for creating/configuring collective channels.
   iree_hal_channel_provider_t* channel_provider;
 
+  // Scope used for executable preparation tasks when executables are prepared
+  // concurrently. Tasks are tracked with iree_task_scope_begin/end so that the
+  // device can wait for them to retire before it is destroyed.
+  bool concurrent_executable_preparation;
+  iree_task_scope_t executable_scope;
+
+  // Defers loading executables until they are first dispatched.
+  bool lazy_executable_preparation;
+
   iree_host_size_t queue_count;
   iree_hal_task_queue_t queues[];
 } iree_hal_task_device_t;
@@ -58,6 +68,8 @@ void iree_hal_task_device_params_initialize(
     iree_hal_task_device_params_t* out_params) {
   out_params->arena_block_size = 32 * 1024;
   out_params->queue_scope_flags = IREE_TASK_SCOPE_FLAG_NONE;
+  out_params->concurrent_executable_preparation = false;
+  out_params->lazy_executable_preparation = false;
 }
 
 static iree_status_t iree_hal_task_device_check_params(
@@ -120,6 +132,12 @@ iree_status_t iree_hal_task_device_create(
     iree_arena_block_pool_initialize(params->arena_block_size, host_allocator,
                                      &device->large_block_pool);
 
+    device->concurrent_executable_preparation =
+        params->concurrent_executable_preparation;
+    device->lazy_executable_preparation = params->lazy_executable_preparation;
+    iree_task_scope_initialize(device->identifier, IREE_TASK_SCOPE_FLAG_NONE,
+                               &device->executable_scope);
+
     device->loader_count = loader_count;
     device->loaders =
         (iree_hal_executable_loader_t**)((uint8_t*)device + sizeof(*device) +
@@ -155,6 +173,11 @@ static void iree_hal_task_device_destroy(iree_hal_device_t* base_device) {
   iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Wait for any executable preparation still in flight.
+  iree_status_ignore(iree_task_scope_wait_idle(&device->executable_scope,
+                                               IREE_TIME_INFINITE_FUTURE));
+  iree_task_scope_deinitialize(&device->executable_scope);
+
   for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
     iree_hal_task_queue_deinitialize(&device->queues[i]);
   }
@@ -285,8 +308,55 @@ static iree_host_size_t iree_hal_task_device_select_queue(
 static iree_status_t iree_hal_task_device_create_channel(
     iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
     iree_hal_channel_params_t params, iree_hal_channel_t** out_channel) {
-  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                          "collectives not implemented");
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+
+  // Ask the channel provider (if configured) for the default rank and count
+  // if the user did not set them.
+  if (device->channel_provider &&
+      (params.rank == IREE_HAL_CHANNEL_RANK_DEFAULT ||
+       params.count == IREE_HAL_CHANNEL_COUNT_DEFAULT)) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_channel_provider_query_default_rank_and_count(
+            device->channel_provider, &params.rank, &params.count),
+        "querying default collective group rank and count");
+  }
+  if (params.rank == IREE_HAL_CHANNEL_RANK_DEFAULT ||
+      params.count == IREE_HAL_CHANNEL_COUNT_DEFAULT) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "default collective rank and count requested but no channel provider "
+        "has been set on the device to provide them");
+  }
+
+  // Participants find each other by ID so one is required. When not provided
+  // all participants must agree on one via the channel provider.
+  uint8_t default_id[IREE_HAL_TASK_CHANNEL_DEFAULT_ID_LENGTH];
+  if (iree_const_byte_span_is_empty(params.id)) {
+    if (!device->channel_provider) {
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "default collective channel ID requested but no channel provider has "
+          "been set on the device to provide it");
+    }
+    memset(default_id, 0, sizeof(default_id));
+    IREE_RETURN_IF_ERROR(
+        iree_hal_channel_provider_exchange_default_id(
+            device->channel_provider,
+            iree_make_byte_span(default_id, sizeof(default_id))),
+        "exchanging channel ID with other participants");
+    params.id = iree_make_const_byte_span(default_id, sizeof(default_id));
+  }
+
+  // Participants in other processes can only be reached through shared memory.
+  if (device->channel_provider &&
+      iree_hal_shm_channel_provider_isa(device->channel_provider)) {
+    return iree_hal_shm_channel_create(params, device->host_allocator,
+                                       out_channel);
+  }
+
+  return iree_hal_task_channel_create(params.id, params.group, params.rank,
+                                      params.count, device->host_allocator,
+                                      out_channel);
 }
 
 static iree_status_t iree_hal_task_device_create_command_buffer(
@@ -295,25 +365,13 @@ static iree_status_t iree_hal_task_device_create_command_buffer(
     iree_hal_queue_affinity_t queue_affinity, iree_host_size_t binding_capacity,
     iree_hal_command_buffer_t** out_command_buffer) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
-  if (binding_capacity > 0) {
-    // TODO(indirect-cmd): natively support reusable task command buffers. For
-    // now we emulate by recording into a deferred command buffer and
-    // recording/issuing at submission time. The task system needs some
-    // reworking to support being able to resubmit task graphs as today it is
-    // destructive.
-    return iree_hal_deferred_command_buffer_create(
-        iree_hal_device_allocator(base_device), mode, command_categories,
-        binding_capacity, &device->large_block_pool, device->host_allocator,
-        out_command_buffer);
-  } else {
-    iree_host_size_t queue_index = iree_hal_task_device_select_queue(
-        device, command_categories, queue_affinity);
-    return iree_hal_task_command_buffer_create(
-        iree_hal_device_allocator(base_device),
-        &device->queues[queue_index].scope, mode, command_categories,
-        queue_affinity, binding_capacity, &device->large_block_pool,
-        device->host_allocator, out_command_buffer);
-  }
+  iree_host_size_t queue_index = iree_hal_task_device_select_queue(
+      device, command_categories, queue_affinity);
+  return iree_hal_task_command_buffer_create(
+      iree_hal_device_allocator(base_device),
+      &device->queues[queue_index].scope, mode, command_categories,
+      queue_affinity, binding_capacity, &device->large_block_pool,
+      device->host_allocator, out_command_buffer);
 }
 
 static iree_status_t iree_hal_task_device_create_event(
@@ -324,21 +382,88 @@ static iree_status_t iree_hal_task_device_create_event(
                                     out_event);
 }
 
+// A heap-allocated task that prepares an executable on the executor.
+typedef struct iree_hal_task_device_prepare_task_t {
+  iree_task_call_t task;
+  iree_allocator_t host_allocator;
+  iree_hal_local_executable_work_fn_t fn;
+  void* user_data;
+} iree_hal_task_device_prepare_task_t;
+
+static iree_status_t iree_hal_task_device_prepare_task_call(
+    void* user_context, iree_task_t* task,
+    iree_task_submission_t* pending_submission) {
+  iree_hal_task_device_prepare_task_t* prepare_task =
+      (iree_hal_task_device_prepare_task_t*)task;
+  prepare_task->fn(prepare_task->user_data);
+  prepare_task->fn = NULL;
+  return iree_ok_status();
+}
+
+static void iree_hal_task_device_prepare_task_cleanup(
+    iree_task_t* task, iree_status_code_t status_code) {
+  iree_hal_task_device_prepare_task_t* prepare_task =
+      (iree_hal_task_device_prepare_task_t*)task;
+  // Work must always run even if the task was aborted without being issued.
+  if (prepare_task->fn) prepare_task->fn(prepare_task->user_data);
+  iree_task_scope_t* scope = task->scope;
+  iree_allocator_free(prepare_task->host_allocator, prepare_task);
+  iree_task_scope_end(scope);
+}
+
+static iree_status_t iree_hal_task_device_schedule_prepare(
+    void* self, iree_hal_local_executable_work_fn_t fn, void* user_data) {
+  iree_hal_task_device_t* device = (iree_hal_task_device_t*)self;
+
+  iree_hal_task_device_prepare_task_t* prepare_task = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      device->host_allocator, sizeof(*prepare_task), (void**)&prepare_task));
+  iree_task_call_initialize(
+      &device->executable_scope,
+      iree_task_make_call_closure(iree_hal_task_device_prepare_task_call, 0),
+      &prepare_task->task);
+  iree_task_set_cleanup_fn(&prepare_task->task.header,
+                           iree_hal_task_device_prepare_task_cleanup);
+  prepare_task->host_allocator = device->host_allocator;
+  prepare_task->fn = fn;
+  prepare_task->user_data = user_data;
+  iree_task_scope_begin(&device->executable_scope);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &prepare_task->task.header);
+  iree_task_executor_t* executor = device->queues[0].executor;
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_task_device_create_executable_cache(
     iree_hal_device_t* base_device, iree_string_view_t identifier,
     iree_loop_t loop, iree_hal_executable_cache_t** out_executable_cache) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
 
+  iree_hal_local_executable_cache_params_t params;
+  iree_hal_local_executable_cache_params_initialize(&params);
+
   // Sum up the total worker count across all queues so that the loaders can
   // preallocate worker-specific storage.
-  iree_host_size_t total_worker_count = 0;
+  params.worker_capacity = 0;
   for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
-    total_worker_count +=
+    params.worker_capacity +=
         iree_task_executor_worker_count(device->queues[i].executor);
   }
 
-  return iree_hal_local_executable_cache_create(
-      identifier, total_worker_count, device->loader_count, device->loaders,
+  // Executables are loaded on the executor workers so that startup time scales
+  // with the number of cores instead of the number of executables.
+  if (device->concurrent_executable_preparation) {
+    params.scheduler.self = device;
+    params.scheduler.schedule = iree_hal_task_device_schedule_prepare;
+  }
+  params.lazy_preparation = device->lazy_executable_preparation;
+
+  return iree_hal_local_executable_cache_create_with_params(
+      identifier, &params, device->loader_count, device->loaders,
       iree_hal_device_host_allocator(base_device), out_executable_cache);
 }
 
@@ -346,14 +471,8 @@ static iree_status_t iree_hal_task_device_import_file(
     iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
     iree_hal_memory_access_t access, iree_io_file_handle_t* handle,
     iree_hal_external_file_flags_t flags, iree_hal_file_t** out_file) {
-  if (iree_io_file_handle_type(handle) !=
-      IREE_IO_FILE_HANDLE_TYPE_HOST_ALLOCATION) {
-    return iree_make_status(
-        IREE_STATUS_UNAVAILABLE,
-        "implementation does not support the external file type");
-  }
-  return iree_hal_memory_file_wrap(
-      queue_affinity, access, handle, iree_hal_device_allocator(base_device),
+  return iree_hal_file_from_handle(
+      iree_hal_device_allocator(base_device), queue_affinity, access, handle,
       iree_hal_device_host_allocator(base_device), out_file);
 }
 
@@ -25,6 +25,16 @@ typedef struct iree_hal_task_device_params_t {
   iree_host_size_t arena_block_size;
   // Default flags for the iree_task_scope_t used for each queue.
   iree_task_scope_flags_t queue_scope_flags;
+  // Prepares executables concurrently on the first queue executor. Executable
+  // creation returns immediately and the first use of each executable waits for
+  // it to finish loading. Loading errors are reported on first use instead of
+  // from executable creation. Disabled by default.
+  bool concurrent_executable_preparation;
+  // Defers loading each executable until it is first dispatched so that
+  // executables that are never used are never loaded. Only applies to
+  // executables whose data is aliased by the caller. Takes precedence over
+  // |concurrent_executable_preparation|.
+  bool lazy_executable_preparation;
 } iree_hal_task_device_params_t;
 
 // Initializes |out_params| to default values.
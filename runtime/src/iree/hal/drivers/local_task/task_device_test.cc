@@ -0,0 +1,462 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/drivers/local_task/task_device.h"
+
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/loaders/embedded_elf_loader.h"
+#include "iree/hal/local/local_executable.h"
+#include "iree/task/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+// ELF modules for various platforms embedded in the binary:
+#include "iree/hal/local/elf/testdata/elementwise_mul.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+// Returns the ELF testdata for the current architecture or an empty span if
+// none is available.
+static iree_const_byte_span_t QueryArchTestFileData() {
+  iree_string_view_t pattern = iree_string_view_empty();
+#if defined(IREE_ARCH_ARM_32)
+  pattern = IREE_SV("*_arm_32.so");
+#elif defined(IREE_ARCH_ARM_64)
+  pattern = IREE_SV("*_arm_64.so");
+#elif defined(IREE_ARCH_RISCV_32)
+  pattern = IREE_SV("*_riscv_32.so");
+#elif defined(IREE_ARCH_RISCV_64)
+  pattern = IREE_SV("*_riscv_64.so");
+#elif defined(IREE_ARCH_X86_32)
+  pattern = IREE_SV("*_x86_32.so");
+#elif defined(IREE_ARCH_X86_64)
+  pattern = IREE_SV("*_x86_64.so");
+#endif  // IREE_ARCH_*
+  if (iree_string_view_is_empty(pattern)) {
+    return iree_make_const_byte_span(NULL, 0);
+  }
+  for (size_t i = 0; i < elementwise_mul_size(); ++i) {
+    const struct iree_file_toc_t* file_toc = &elementwise_mul_create()[i];
+    if (iree_string_view_match_pattern(iree_make_cstring_view(file_toc->name),
+                                       pattern)) {
+      return iree_make_const_byte_span(file_toc->data, file_toc->size);
+    }
+  }
+  return iree_make_const_byte_span(NULL, 0);
+}
+
+TEST(TaskDeviceParamsTest, ExecutablePreparationIsSynchronousByDefault) {
+  iree_hal_task_device_params_t params;
+  iree_hal_task_device_params_initialize(&params);
+  EXPECT_FALSE(params.concurrent_executable_preparation);
+  EXPECT_FALSE(params.lazy_executable_preparation);
+}
+
+class TaskDeviceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    executable_data_ = QueryArchTestFileData();
+    if (!executable_data_.data_length) {
+      GTEST_SKIP() << "no ELF testdata for the current architecture";
+    }
+    iree_task_executor_options_t options;
+    iree_task_executor_options_initialize(&options);
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_group_count(2, &topology);
+    IREE_ASSERT_OK(iree_task_executor_create(
+        options, &topology, iree_allocator_system(), &executor_));
+    iree_task_topology_deinitialize(&topology);
+    IREE_ASSERT_OK(iree_hal_embedded_elf_loader_create(
+        /*plugin_manager=*/NULL, /*disk_cache=*/NULL, iree_allocator_system(),
+        &loader_));
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        IREE_SV("test"), iree_allocator_system(), iree_allocator_system(),
+        &device_allocator_));
+  }
+
+  void TearDown() override {
+    iree_hal_allocator_release(device_allocator_);
+    iree_hal_executable_loader_release(loader_);
+    iree_task_executor_release(executor_);
+  }
+
+  iree_status_t CreateDevice(const iree_hal_task_device_params_t& params,
+                             iree_hal_device_t** out_device) {
+    return iree_hal_task_device_create(
+        IREE_SV("test"), &params, /*queue_count=*/1, &executor_,
+        /*loader_count=*/1, &loader_, device_allocator_,
+        iree_allocator_system(), out_device);
+  }
+
+  // Prepares |count| executables from the testdata in |executable_cache|.
+  void PrepareExecutables(iree_hal_executable_cache_t* executable_cache,
+                          size_t count,
+                          std::vector<iree_hal_executable_t*>* executables) {
+    iree_hal_executable_params_t params;
+    iree_hal_executable_params_initialize(&params);
+    params.caching_mode = IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION |
+                          IREE_HAL_EXECUTABLE_CACHING_MODE_DISABLE_VERIFICATION;
+    params.executable_format = IREE_SV("embedded-elf-" IREE_ARCH);
+    params.executable_data = executable_data_;
+    for (size_t i = 0; i < count; ++i) {
+      iree_hal_executable_t* executable = NULL;
+      IREE_ASSERT_OK(iree_hal_executable_cache_prepare_executable(
+          executable_cache, &params, &executable));
+      executables->push_back(executable);
+    }
+  }
+
+  // Allocates a host-visible buffer initialized with |contents|.
+  void AllocateBuffer(iree_hal_device_t* device, const void* contents,
+                      iree_device_size_t length,
+                      iree_hal_buffer_t** out_buffer) {
+    iree_hal_buffer_params_t params = {0};
+    params.type = IREE_HAL_MEMORY_TYPE_HOST_LOCAL |
+                  IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+    params.usage = IREE_HAL_BUFFER_USAGE_DISPATCH_STORAGE |
+                   IREE_HAL_BUFFER_USAGE_DISPATCH_INDIRECT_PARAMS |
+                   IREE_HAL_BUFFER_USAGE_TRANSFER |
+                   IREE_HAL_BUFFER_USAGE_MAPPING;
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(device), params, length, out_buffer));
+    IREE_ASSERT_OK(iree_hal_buffer_map_write(*out_buffer, 0, contents, length));
+  }
+
+  iree_const_byte_span_t executable_data_ = iree_const_byte_span_empty();
+  iree_task_executor_t* executor_ = NULL;
+  iree_hal_executable_loader_t* loader_ = NULL;
+  iree_hal_allocator_t* device_allocator_ = NULL;
+};
+
+// Destroying the device while executables are still being prepared on its
+// executor must wait for (or skip) the outstanding loads.
+TEST_F(TaskDeviceTest, DestroyWithPreparationPending) {
+  iree_hal_task_device_params_t params;
+  iree_hal_task_device_params_initialize(&params);
+  params.concurrent_executable_preparation = true;
+  iree_hal_device_t* device = NULL;
+  IREE_ASSERT_OK(CreateDevice(params, &device));
+
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_cache_create(
+      device, IREE_SV("test"), iree_loop_inline(NULL), &executable_cache));
+  std::vector<iree_hal_executable_t*> executables;
+  PrepareExecutables(executable_cache, 32, &executables);
+
+  // Release half of the executables before their loads run and keep the rest
+  // beyond the lifetime of the device.
+  for (size_t i = 0; i < executables.size(); i += 2) {
+    iree_hal_executable_release(executables[i]);
+    executables[i] = NULL;
+  }
+  iree_hal_executable_cache_release(executable_cache);
+  iree_hal_device_release(device);
+
+  for (auto* executable : executables) {
+    if (!executable) continue;
+    iree_hal_local_executable_t* local_executable = NULL;
+    IREE_EXPECT_OK(
+        iree_hal_local_executable_resolve(executable, &local_executable));
+    iree_hal_executable_release(executable);
+  }
+}
+
+// Errors from loading an executable are reported when it is resolved instead
+// of when it is created.
+TEST_F(TaskDeviceTest, ConcurrentPreparationErrorOnFirstUse) {
+  iree_hal_task_device_params_t params;
+  iree_hal_task_device_params_initialize(&params);
+  params.concurrent_executable_preparation = true;
+  iree_hal_device_t* device = NULL;
+  IREE_ASSERT_OK(CreateDevice(params, &device));
+
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_cache_create(
+      device, IREE_SV("test"), iree_loop_inline(NULL), &executable_cache));
+
+  static const uint8_t kInvalidExecutableData[64] = {0x7F, 'E', 'L', 'F'};
+  iree_hal_executable_params_t executable_params;
+  iree_hal_executable_params_initialize(&executable_params);
+  executable_params.caching_mode =
+      IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION;
+  executable_params.executable_format = IREE_SV("embedded-elf-" IREE_ARCH);
+  executable_params.executable_data = iree_make_const_byte_span(
+      kInvalidExecutableData, sizeof(kInvalidExecutableData));
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_cache_prepare_executable(
+      executable_cache, &executable_params, &executable));
+
+  iree_hal_local_executable_t* local_executable = NULL;
+  iree_status_t status =
+      iree_hal_local_executable_resolve(executable, &local_executable);
+  EXPECT_FALSE(iree_status_is_ok(status));
+  iree_status_ignore(status);
+
+  iree_hal_executable_release(executable);
+  iree_hal_executable_cache_release(executable_cache);
+  iree_hal_device_release(device);
+}
+
+// Binding slots of the elementwise_mul dispatch plus the workgroup count used
+// when recording indirect dispatches.
+enum {
+  kLhsSlot = 0,
+  kRhsSlot = 1,
+  kDstSlot = 2,
+  kWorkgroupsSlot = 3,
+  kBindingCapacity = 4,
+};
+
+// One set of elementwise_mul operands bound through a binding table.
+struct ElementwiseMulOperands {
+  float lhs[4];
+  float rhs[4];
+  iree_hal_buffer_t* lhs_buffer = NULL;
+  iree_hal_buffer_t* rhs_buffer = NULL;
+  iree_hal_buffer_t* dst_buffer = NULL;
+  iree_hal_buffer_t* workgroups_buffer = NULL;
+};
+
+class TaskDeviceReusableCommandBufferTest : public TaskDeviceTest {
+ protected:
+  void SetUp() override {
+    TaskDeviceTest::SetUp();
+    if (IsSkipped()) return;
+    iree_hal_task_device_params_t params;
+    iree_hal_task_device_params_initialize(&params);
+    IREE_ASSERT_OK(CreateDevice(params, &device_));
+    IREE_ASSERT_OK(iree_hal_executable_cache_create(
+        device_, IREE_SV("test"), iree_loop_inline(NULL), &executable_cache_));
+    std::vector<iree_hal_executable_t*> executables;
+    PrepareExecutables(executable_cache_, 1, &executables);
+    executable_ = executables.front();
+  }
+
+  void TearDown() override {
+    for (auto& operands : operands_) {
+      iree_hal_buffer_release(operands.lhs_buffer);
+      iree_hal_buffer_release(operands.rhs_buffer);
+      iree_hal_buffer_release(operands.dst_buffer);
+      iree_hal_buffer_release(operands.workgroups_buffer);
+    }
+    iree_hal_executable_release(executable_);
+    iree_hal_executable_cache_release(executable_cache_);
+    iree_hal_device_release(device_);
+    TaskDeviceTest::TearDown();
+  }
+
+  // Records a reusable command buffer dispatching elementwise_mul with all
+  // operands (and the workgroup count if |indirect|) bound by slot.
+  void RecordElementwiseMul(bool indirect,
+                            iree_hal_command_buffer_t** out_command_buffer) {
+    iree_hal_command_buffer_t* command_buffer = NULL;
+    IREE_ASSERT_OK(iree_hal_command_buffer_create(
+        device_, IREE_HAL_COMMAND_BUFFER_MODE_DEFAULT,
+        IREE_HAL_COMMAND_CATEGORY_DISPATCH, IREE_HAL_QUEUE_AFFINITY_ANY,
+        kBindingCapacity, &command_buffer));
+    const iree_device_size_t length = 4 * sizeof(float);
+    const iree_hal_buffer_ref_t binding_refs[3] = {
+        iree_hal_make_indirect_buffer_ref(kLhsSlot, 0, length),
+        iree_hal_make_indirect_buffer_ref(kRhsSlot, 0, length),
+        iree_hal_make_indirect_buffer_ref(kDstSlot, 0, length),
+    };
+    const iree_hal_buffer_ref_list_t bindings = {
+        IREE_ARRAYSIZE(binding_refs),
+        binding_refs,
+    };
+    IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+    if (indirect) {
+      IREE_ASSERT_OK(iree_hal_command_buffer_dispatch_indirect(
+          command_buffer, executable_, /*entry_point=*/0,
+          iree_hal_make_indirect_buffer_ref(kWorkgroupsSlot, 0,
+                                            3 * sizeof(uint32_t)),
+          iree_const_byte_span_empty(), bindings, IREE_HAL_DISPATCH_FLAG_NONE));
+    } else {
+      const uint32_t workgroup_count[3] = {1, 1, 1};
+      IREE_ASSERT_OK(iree_hal_command_buffer_dispatch(
+          command_buffer, executable_, /*entry_point=*/0, workgroup_count,
+          iree_const_byte_span_empty(), bindings, IREE_HAL_DISPATCH_FLAG_NONE));
+    }
+    IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+    *out_command_buffer = command_buffer;
+  }
+
+  // Allocates |count| operand sets with distinct values and zeroed outputs.
+  // |workgroup_count_x| is stored in each set's indirect workgroup count.
+  void AllocateOperands(size_t count, uint32_t workgroup_count_x = 1) {
+    const float zeros[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    const uint32_t workgroup_count[3] = {workgroup_count_x, 1, 1};
+    for (size_t i = 0; i < count; ++i) {
+      ElementwiseMulOperands operands;
+      for (int j = 0; j < 4; ++j) {
+        operands.lhs[j] = (float)(i * 4 + j + 1);
+        operands.rhs[j] = (float)(j + 2);
+      }
+      AllocateBuffer(device_, operands.lhs, sizeof(operands.lhs),
+                     &operands.lhs_buffer);
+      AllocateBuffer(device_, operands.rhs, sizeof(operands.rhs),
+                     &operands.rhs_buffer);
+      AllocateBuffer(device_, zeros, sizeof(zeros), &operands.dst_buffer);
+      AllocateBuffer(device_, workgroup_count, sizeof(workgroup_count),
+                     &operands.workgroups_buffer);
+      operands_.push_back(operands);
+    }
+  }
+
+  // Executes |command_buffer| with the binding table for |operands| after
+  // |wait_semaphore_list| and signals |signal_semaphore_list|.
+  iree_status_t Submit(iree_hal_command_buffer_t* command_buffer,
+                       const ElementwiseMulOperands& operands,
+                       iree_hal_semaphore_list_t wait_semaphore_list,
+                       iree_hal_semaphore_list_t signal_semaphore_list) {
+    const iree_hal_buffer_binding_t bindings[kBindingCapacity] = {
+        {operands.lhs_buffer, 0, IREE_WHOLE_BUFFER},
+        {operands.rhs_buffer, 0, IREE_WHOLE_BUFFER},
+        {operands.dst_buffer, 0, IREE_WHOLE_BUFFER},
+        {operands.workgroups_buffer, 0, IREE_WHOLE_BUFFER},
+    };
+    const iree_hal_buffer_binding_table_t binding_table = {
+        IREE_ARRAYSIZE(bindings),
+        bindings,
+    };
+    return iree_hal_device_queue_execute(
+        device_, IREE_HAL_QUEUE_AFFINITY_ANY, wait_semaphore_list,
+        signal_semaphore_list, command_buffer, binding_table);
+  }
+
+  // Expects the output of |operands| to be lhs * rhs or zeros if
+  // |expect_computed| is false.
+  void ExpectOutput(const ElementwiseMulOperands& operands,
+                    bool expect_computed = true) {
+    float dst[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    IREE_ASSERT_OK(
+        iree_hal_buffer_map_read(operands.dst_buffer, 0, dst, sizeof(dst)));
+    for (int j = 0; j < 4; ++j) {
+      EXPECT_EQ(dst[j],
+                expect_computed ? operands.lhs[j] * operands.rhs[j] : 0.0f);
+    }
+  }
+
+  iree_hal_device_t* device_ = NULL;
+  iree_hal_executable_cache_t* executable_cache_ = NULL;
+  iree_hal_executable_t* executable_ = NULL;
+  std::vector<ElementwiseMulOperands> operands_;
+};
+
+// Each submission of a reusable command buffer resolves the dispatch bindings
+// from its own binding table.
+TEST_F(TaskDeviceReusableCommandBufferTest, DispatchBindingTableFixups) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  RecordElementwiseMul(/*indirect=*/false, &command_buffer);
+  AllocateOperands(3);
+
+  iree_hal_semaphore_t* semaphore = NULL;
+  IREE_ASSERT_OK(iree_hal_semaphore_create(
+      device_, 0ull, IREE_HAL_SEMAPHORE_FLAG_NONE, &semaphore));
+  for (size_t i = 0; i < operands_.size(); ++i) {
+    uint64_t signal_value = i + 1;
+    iree_hal_semaphore_list_t signal_list = {1, &semaphore, &signal_value};
+    IREE_ASSERT_OK(Submit(command_buffer, operands_[i],
+                          iree_hal_semaphore_list_empty(), signal_list));
+    IREE_ASSERT_OK(iree_hal_semaphore_wait(semaphore, signal_value,
+                                           iree_infinite_timeout()));
+    ExpectOutput(operands_[i]);
+  }
+
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_command_buffer_release(command_buffer);
+}
+
+// Indirect workgroup counts are read from the buffer bound in each
+// submission's binding table: a zero count must dispatch nothing even though
+// an earlier submission of the same command buffer dispatched work.
+TEST_F(TaskDeviceReusableCommandBufferTest, IndirectWorkgroupCountFixups) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  RecordElementwiseMul(/*indirect=*/true, &command_buffer);
+  AllocateOperands(1, /*workgroup_count_x=*/1);
+  AllocateOperands(1, /*workgroup_count_x=*/0);
+  AllocateOperands(1, /*workgroup_count_x=*/2);
+
+  iree_hal_semaphore_t* semaphore = NULL;
+  IREE_ASSERT_OK(iree_hal_semaphore_create(
+      device_, 0ull, IREE_HAL_SEMAPHORE_FLAG_NONE, &semaphore));
+  for (size_t i = 0; i < operands_.size(); ++i) {
+    uint64_t signal_value = i + 1;
+    iree_hal_semaphore_list_t signal_list = {1, &semaphore, &signal_value};
+    IREE_ASSERT_OK(Submit(command_buffer, operands_[i],
+                          iree_hal_semaphore_list_empty(), signal_list));
+    IREE_ASSERT_OK(iree_hal_semaphore_wait(semaphore, signal_value,
+                                           iree_infinite_timeout()));
+  }
+  ExpectOutput(operands_[0]);
+  ExpectOutput(operands_[1], /*expect_computed=*/false);
+  ExpectOutput(operands_[2]);
+
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_command_buffer_release(command_buffer);
+}
+
+// A reusable command buffer may be resubmitted while earlier submissions are
+// still pending or executing; each submission must observe only its own
+// bindings.
+TEST_F(TaskDeviceReusableCommandBufferTest, ResubmitWhileInFlight) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  RecordElementwiseMul(/*indirect=*/true, &command_buffer);
+  AllocateOperands(17);
+
+  // The first submission is held back by |wait_semaphore| until all of the
+  // others have been issued so that it executes after (and concurrently with)
+  // later submissions of the same command buffer.
+  iree_hal_semaphore_t* wait_semaphore = NULL;
+  IREE_ASSERT_OK(iree_hal_semaphore_create(
+      device_, 0ull, IREE_HAL_SEMAPHORE_FLAG_NONE, &wait_semaphore));
+  std::vector<iree_hal_semaphore_t*> signal_semaphores(operands_.size());
+  for (auto& signal_semaphore : signal_semaphores) {
+    IREE_ASSERT_OK(iree_hal_semaphore_create(
+        device_, 0ull, IREE_HAL_SEMAPHORE_FLAG_NONE, &signal_semaphore));
+  }
+
+  uint64_t wait_value = 1;
+  uint64_t signal_value = 1;
+  iree_hal_semaphore_list_t wait_list = {1, &wait_semaphore, &wait_value};
+  iree_hal_semaphore_list_t signal_list = {1, &signal_semaphores[0],
+                                           &signal_value};
+  IREE_ASSERT_OK(Submit(command_buffer, operands_[0], wait_list, signal_list));
+  for (size_t i = 1; i < operands_.size(); ++i) {
+    signal_list.semaphores = &signal_semaphores[i];
+    IREE_ASSERT_OK(Submit(command_buffer, operands_[i],
+                          iree_hal_semaphore_list_empty(), signal_list));
+  }
+
+  // The held submission must not have run yet.
+  uint64_t value = 0;
+  IREE_ASSERT_OK(iree_hal_semaphore_query(signal_semaphores[0], &value));
+  EXPECT_EQ(value, 0ull);
+  ExpectOutput(operands_[0], /*expect_computed=*/false);
+
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(wait_semaphore, wait_value));
+  for (size_t i = 0; i < operands_.size(); ++i) {
+    IREE_ASSERT_OK(iree_hal_semaphore_wait(signal_semaphores[i], signal_value,
+                                           iree_infinite_timeout()));
+    ExpectOutput(operands_[i]);
+  }
+
+  for (auto* signal_semaphore : signal_semaphores) {
+    iree_hal_semaphore_release(signal_semaphore);
+  }
+  iree_hal_semaphore_release(wait_semaphore);
+  iree_hal_command_buffer_release(command_buffer);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
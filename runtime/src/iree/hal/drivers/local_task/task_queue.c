@@ -246,10 +246,11 @@ static iree_status_t iree_hal_task_queue_issue_cmd_deferred(
   // Issue the task command buffer as if it had been recorded directly to begin
   // with.
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_hal_task_command_buffer_issue(task_command_buffer,
-                                             &cmd->queue->state,
-                                             cmd->task.header.completion_task,
-                                             cmd->arena, pending_submission));
+      z0, iree_hal_task_command_buffer_issue(
+              task_command_buffer, &cmd->queue->state,
+              iree_hal_buffer_binding_table_empty(),
+              cmd->task.header.completion_task, cmd->arena,
+              pending_submission));
 
   // Still retained in the resource set until retirement.
   iree_hal_command_buffer_release(task_command_buffer);
@@ -270,15 +271,9 @@ static iree_status_t iree_hal_task_queue_issue_cmd(
   iree_status_t status = iree_ok_status();
   if (cmd->command_buffer != NULL) {
     if (iree_hal_task_command_buffer_isa(cmd->command_buffer)) {
-      if (cmd->binding_table.count > 0) {
-        status = iree_make_status(
-            IREE_STATUS_UNIMPLEMENTED,
-            "task command buffers do not support binding tables yet");
-      } else {
-        status = iree_hal_task_command_buffer_issue(
-            cmd->command_buffer, &cmd->queue->state,
-            cmd->task.header.completion_task, cmd->arena, pending_submission);
-      }
+      status = iree_hal_task_command_buffer_issue(
+          cmd->command_buffer, &cmd->queue->state, cmd->binding_table,
+          cmd->task.header.completion_task, cmd->arena, pending_submission);
     } else if (iree_hal_deferred_command_buffer_isa(cmd->command_buffer)) {
       status = iree_hal_task_queue_issue_cmd_deferred(
           cmd, cmd->command_buffer, cmd->binding_table, pending_submission);
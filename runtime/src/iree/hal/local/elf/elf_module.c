@@ -287,6 +287,20 @@ static iree_status_t iree_elf_module_load_segments(
   return iree_ok_status();
 }
 
+// Returns the access of a PT_LOAD |phdr| widened to the implicit allowable
+// permissions. See Table 7-37:
+// https://docs.oracle.com/cd/E19683-01/816-1386/6m7qcoblk/index.html#chapter6-34713
+static iree_memory_access_t iree_elf_module_segment_access(
+    const iree_elf_phdr_t* phdr) {
+  iree_memory_access_t access = 0;
+  if (phdr->p_flags & IREE_ELF_PF_R) access |= IREE_MEMORY_ACCESS_READ;
+  if (phdr->p_flags & IREE_ELF_PF_W) access |= IREE_MEMORY_ACCESS_WRITE;
+  if (phdr->p_flags & IREE_ELF_PF_X) access |= IREE_MEMORY_ACCESS_EXECUTE;
+  if (access & IREE_MEMORY_ACCESS_WRITE) access |= IREE_MEMORY_ACCESS_READ;
+  if (access & IREE_MEMORY_ACCESS_EXECUTE) access |= IREE_MEMORY_ACCESS_READ;
+  return access;
+}
+
 // Applies segment memory protection attributes.
 // This will make pages read-only and must only be performed after relocation
 // (which writes to pages of all types). Executable pages will be flushed from
@@ -299,14 +313,8 @@ static iree_status_t iree_elf_module_protect_segments(
     if (phdr->p_type != IREE_ELF_PT_LOAD) continue;
 
     // Interpret the access bits and widen to the implicit allowable
-    // permissions. See Table 7-37:
-    // https://docs.oracle.com/cd/E19683-01/816-1386/6m7qcoblk/index.html#chapter6-34713
-    iree_memory_access_t access = 0;
-    if (phdr->p_flags & IREE_ELF_PF_R) access |= IREE_MEMORY_ACCESS_READ;
-    if (phdr->p_flags & IREE_ELF_PF_W) access |= IREE_MEMORY_ACCESS_WRITE;
-    if (phdr->p_flags & IREE_ELF_PF_X) access |= IREE_MEMORY_ACCESS_EXECUTE;
-    if (access & IREE_MEMORY_ACCESS_WRITE) access |= IREE_MEMORY_ACCESS_READ;
-    if (access & IREE_MEMORY_ACCESS_EXECUTE) access |= IREE_MEMORY_ACCESS_READ;
+    // permissions.
+    iree_memory_access_t access = iree_elf_module_segment_access(phdr);
 
     // We only support R+X (no W).
     if ((phdr->p_flags & IREE_ELF_PF_X) && (phdr->p_flags & IREE_ELF_PF_W)) {
@@ -566,14 +574,414 @@ static const iree_elf_sym_t* iree_elf_module_lookup_global_symbol(
   return NULL;
 }
 
+//==============================================================================
+// Prelinked images
+//==============================================================================
+// A prelinked image is a snapshot of the loaded segments after relocation
+// with all bias-dependent pointers stored as if the module had been loaded at
+// a bias of 0. Loading an image only requires copying the segments into place
+// and adding the new bias to each recorded rebase site.
+//
+// Rebase sites are discovered by relocating a second copy of the module at a
+// different address and comparing the results: every pointer-sized word that
+// differs by exactly the bias delta is a rebase site. Relocations that do not
+// produce such words (truncated absolute addresses, etc) make the module
+// ineligible for prelinking. This keeps the architecture-specific relocation
+// handlers unchanged.
+//
+// Layout (host endianness, 8-byte aligned):
+//   iree_elf_image_header_t
+//   iree_elf_image_segment_t[segment_count]
+//   iree_elf_image_range_t[relro_count]
+//   uint64_t[rebase_count] (vaddrs of pointer-sized rebase sites)
+//   segment data referenced by iree_elf_image_segment_t::data_offset
+
+#define IREE_ELF_IMAGE_MAGIC 0x474D4945u  // 'EIMG'
+#define IREE_ELF_IMAGE_VERSION 1u
+
+typedef struct iree_elf_image_header_t {
+  uint32_t magic;
+  uint32_t version;
+  // Minimum vaddr and length of all segments.
+  uint64_t vaddr_offset;
+  uint64_t vaddr_length;
+  uint64_t dynstr_vaddr;
+  uint64_t dynstr_size;
+  uint64_t dynsym_vaddr;
+  uint64_t dynsym_count;
+  // DT_INIT vaddr or IREE_ELF_ADDR_MIN if not present.
+  uint64_t init_vaddr;
+  uint64_t init_array_vaddr;
+  uint64_t init_array_count;
+  uint32_t segment_count;
+  uint32_t relro_count;
+  uint64_t rebase_count;
+} iree_elf_image_header_t;
+
+typedef struct iree_elf_image_segment_t {
+  uint64_t vaddr;
+  uint64_t memsz;
+  // Offset of the segment data from the start of the image. Data past
+  // data_length up to memsz is zero.
+  uint64_t data_offset;
+  uint64_t data_length;
+  // iree_memory_access_t applied after loading.
+  uint32_t access;
+  uint32_t reserved;
+} iree_elf_image_segment_t;
+
+typedef struct iree_elf_image_range_t {
+  uint64_t vaddr;
+  uint64_t length;
+} iree_elf_image_range_t;
+
+// Copies the loaded (but not yet relocated) segments of |module| into a
+// zeroed shadow allocation spanning the entire vaddr range.
+static iree_status_t iree_elf_module_snapshot_segments(
+    iree_elf_module_load_state_t* load_state, iree_elf_module_t* module,
+    uint8_t** out_shadow) {
+  *out_shadow = NULL;
+  iree_byte_range_t vaddr_range =
+      iree_elf_module_calculate_vaddr_range(load_state);
+  uint8_t* shadow = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      module->host_allocator, iree_max(vaddr_range.length, 1),
+      (void**)&shadow));
+  uint8_t* shadow_bias = shadow - vaddr_range.offset;
+  for (iree_elf_half_t i = 0; i < load_state->ehdr->e_phnum; ++i) {
+    const iree_elf_phdr_t* phdr = &load_state->phdr_table[i];
+    if (phdr->p_type != IREE_ELF_PT_LOAD) continue;
+    memcpy(shadow_bias + phdr->p_vaddr, module->vaddr_bias + phdr->p_vaddr,
+           phdr->p_memsz);
+  }
+  *out_shadow = shadow;
+  return iree_ok_status();
+}
+
+// Invokes |callback| for each rebase site in the segment |phdr| by comparing
+// the relocated module against the |shadow_bias| relocated shadow. Returns
+// UNAVAILABLE if the segment contains relocations that are not rebases.
+typedef void(IREE_API_PTR* iree_elf_module_rebase_callback_fn_t)(
+    void* user_data, iree_elf_addr_t vaddr, uintptr_t value);
+static iree_status_t iree_elf_module_enumerate_rebases(
+    const iree_elf_phdr_t* phdr, iree_elf_module_t* module,
+    uint8_t* shadow_bias, iree_elf_module_rebase_callback_fn_t callback,
+    void* user_data) {
+  const uintptr_t delta =
+      (uintptr_t)shadow_bias - (uintptr_t)module->vaddr_bias;
+  const iree_elf_addr_t word_size = sizeof(uintptr_t);
+  const iree_elf_addr_t vaddr_end = phdr->p_vaddr + phdr->p_memsz;
+  // Segments are committed with page granularity so reading the words
+  // straddling the segment bounds is safe.
+  for (iree_elf_addr_t vaddr = phdr->p_vaddr & ~(word_size - 1);
+       vaddr < vaddr_end; vaddr += word_size) {
+    uintptr_t value = 0;
+    uintptr_t shadow_value = 0;
+    memcpy(&value, module->vaddr_bias + vaddr, sizeof(value));
+    memcpy(&shadow_value, shadow_bias + vaddr, sizeof(shadow_value));
+    if (value == shadow_value) continue;
+    if (shadow_value - value != delta || vaddr < phdr->p_vaddr ||
+        vaddr + word_size > vaddr_end) {
+      return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                              "relocation at vaddr %" PRIu64
+                              " is not a pointer rebase",
+                              (uint64_t)vaddr);
+    }
+    if (callback) callback(user_data, vaddr, value);
+  }
+  return iree_ok_status();
+}
+
+typedef struct iree_elf_module_image_builder_t {
+  uint8_t* image;
+  // Bias subtracted from rebase values so they are relative to 0.
+  uintptr_t vaddr_bias;
+  uint64_t* rebases;
+  iree_host_size_t rebase_count;
+  // Segment being written and its data within the image.
+  const iree_elf_image_segment_t* segment;
+} iree_elf_module_image_builder_t;
+
+static void iree_elf_module_count_rebase(void* user_data, iree_elf_addr_t vaddr,
+                                         uintptr_t value) {
+  ++((iree_elf_module_image_builder_t*)user_data)->rebase_count;
+}
+
+static void iree_elf_module_record_rebase(void* user_data,
+                                          iree_elf_addr_t vaddr,
+                                          uintptr_t value) {
+  iree_elf_module_image_builder_t* builder =
+      (iree_elf_module_image_builder_t*)user_data;
+  builder->rebases[builder->rebase_count++] = vaddr;
+  // Rebase values are nonzero when relocated and always within the trimmed
+  // segment data.
+  uintptr_t unbiased_value = value - builder->vaddr_bias;
+  memcpy(builder->image + builder->segment->data_offset +
+             (vaddr - builder->segment->vaddr),
+         &unbiased_value, sizeof(unbiased_value));
+}
+
+// Builds a prelinked image of |module| after it has been relocated. |shadow|
+// is a snapshot from iree_elf_module_snapshot_segments that is relocated here
+// to find rebase sites.
+static iree_status_t iree_elf_module_build_image(
+    iree_elf_module_load_state_t* load_state, iree_elf_module_t* module,
+    uint8_t* shadow, iree_byte_span_t* out_image) {
+  *out_image = iree_make_byte_span(NULL, 0);
+  iree_byte_range_t vaddr_range =
+      iree_elf_module_calculate_vaddr_range(load_state);
+
+  // Relocate the shadow at its own address. The dynamic tables are read from
+  // the shadow so that they match the bias being applied.
+  uint8_t* shadow_bias = shadow - vaddr_range.offset;
+  iree_elf_relocation_state_t reloc_state;
+  memset(&reloc_state, 0, sizeof(reloc_state));
+  reloc_state.vaddr_bias = shadow_bias;
+  reloc_state.dyn_table =
+      (const iree_elf_dyn_t*)(shadow_bias +
+                              ((const uint8_t*)load_state->dyn_table -
+                               module->vaddr_bias));
+  reloc_state.dyn_table_count = load_state->dyn_table_count;
+  reloc_state.dynsym =
+      (const iree_elf_sym_t*)(shadow_bias + ((const uint8_t*)module->dynsym -
+                                             module->vaddr_bias));
+  reloc_state.dynsym_count = module->dynsym_count;
+  IREE_RETURN_IF_ERROR(iree_elf_arch_apply_relocations(&reloc_state));
+
+  // Verify all relocations are rebases and size the image. Overlapping
+  // segments would produce duplicate rebase sites and are not supported.
+  iree_elf_module_image_builder_t builder;
+  memset(&builder, 0, sizeof(builder));
+  iree_host_size_t segment_count = 0;
+  iree_host_size_t relro_count = 0;
+  iree_host_size_t data_size = 0;
+  for (iree_elf_half_t i = 0; i < load_state->ehdr->e_phnum; ++i) {
+    const iree_elf_phdr_t* phdr = &load_state->phdr_table[i];
+    if (phdr->p_type == IREE_ELF_PT_GNU_RELRO) ++relro_count;
+    if (phdr->p_type != IREE_ELF_PT_LOAD) continue;
+    for (iree_elf_half_t j = 0; j < i; ++j) {
+      const iree_elf_phdr_t* other = &load_state->phdr_table[j];
+      if (other->p_type != IREE_ELF_PT_LOAD) continue;
+      if (phdr->p_vaddr < other->p_vaddr + other->p_memsz &&
+          other->p_vaddr < phdr->p_vaddr + phdr->p_memsz) {
+        return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                                "overlapping segments cannot be prelinked");
+      }
+    }
+    IREE_RETURN_IF_ERROR(iree_elf_module_enumerate_rebases(
+        phdr, module, shadow_bias, iree_elf_module_count_rebase, &builder));
+    ++segment_count;
+    data_size += iree_host_align(phdr->p_memsz, 8);
+  }
+  const iree_host_size_t rebase_count = builder.rebase_count;
+
+  iree_host_size_t image_size =
+      sizeof(iree_elf_image_header_t) +
+      segment_count * sizeof(iree_elf_image_segment_t) +
+      relro_count * sizeof(iree_elf_image_range_t) +
+      rebase_count * sizeof(uint64_t) + data_size;
+  uint8_t* image = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(module->host_allocator,
+                                             image_size, (void**)&image));
+  memset(image, 0, image_size);
+
+  iree_elf_image_header_t* header = (iree_elf_image_header_t*)image;
+  iree_elf_image_segment_t* segments =
+      (iree_elf_image_segment_t*)(image + sizeof(*header));
+  iree_elf_image_range_t* relros =
+      (iree_elf_image_range_t*)(segments + segment_count);
+  uint64_t* rebases = (uint64_t*)(relros + relro_count);
+  header->magic = IREE_ELF_IMAGE_MAGIC;
+  header->version = IREE_ELF_IMAGE_VERSION;
+  header->vaddr_offset = vaddr_range.offset;
+  header->vaddr_length = vaddr_range.length;
+  header->dynstr_vaddr = (const uint8_t*)module->dynstr - module->vaddr_bias;
+  header->dynstr_size = module->dynstr_size;
+  header->dynsym_vaddr = (const uint8_t*)module->dynsym - module->vaddr_bias;
+  header->dynsym_count = module->dynsym_count;
+  header->init_vaddr = load_state->init;
+  header->init_array_vaddr =
+      load_state->init_array
+          ? (const uint8_t*)load_state->init_array - module->vaddr_bias
+          : 0;
+  header->init_array_count = load_state->init_array_count;
+  header->segment_count = (uint32_t)segment_count;
+  header->relro_count = (uint32_t)relro_count;
+  header->rebase_count = rebase_count;
+
+  builder.image = image;
+  builder.vaddr_bias = (uintptr_t)module->vaddr_bias;
+  builder.rebases = rebases;
+  builder.rebase_count = 0;
+  iree_host_size_t data_offset = (uint8_t*)(rebases + rebase_count) - image;
+  iree_host_size_t segment_ordinal = 0;
+  iree_host_size_t relro_ordinal = 0;
+  for (iree_elf_half_t i = 0; i < load_state->ehdr->e_phnum; ++i) {
+    const iree_elf_phdr_t* phdr = &load_state->phdr_table[i];
+    if (phdr->p_type == IREE_ELF_PT_GNU_RELRO) {
+      relros[relro_ordinal].vaddr = phdr->p_vaddr;
+      relros[relro_ordinal].length = phdr->p_memsz;
+      ++relro_ordinal;
+      continue;
+    }
+    if (phdr->p_type != IREE_ELF_PT_LOAD) continue;
+
+    // Trailing zeros (.bss and padding) are implied by memsz. The data is kept
+    // word-aligned at the end so that rebase sites are always fully stored.
+    const uint8_t* data = module->vaddr_bias + phdr->p_vaddr;
+    iree_host_size_t data_length = phdr->p_memsz;
+    while (data_length > 0 && data[data_length - 1] == 0) --data_length;
+    if (data_length > 0) {
+      const iree_elf_addr_t data_end = iree_host_align(
+          phdr->p_vaddr + data_length, sizeof(uintptr_t));
+      data_length =
+          iree_min((iree_host_size_t)(data_end - phdr->p_vaddr), phdr->p_memsz);
+    }
+
+    iree_elf_image_segment_t* segment = &segments[segment_ordinal++];
+    segment->vaddr = phdr->p_vaddr;
+    segment->memsz = phdr->p_memsz;
+    segment->data_offset = data_offset;
+    segment->data_length = data_length;
+    segment->access = iree_elf_module_segment_access(phdr);
+    memcpy(image + data_offset, data, data_length);
+    data_offset += iree_host_align(data_length, 8);
+
+    builder.segment = segment;
+    IREE_IGNORE_ERROR(iree_elf_module_enumerate_rebases(
+        phdr, module, shadow_bias, iree_elf_module_record_rebase, &builder));
+  }
+
+  *out_image = iree_make_byte_span(image, data_offset);
+  return iree_ok_status();
+}
+
+// Verifies that |image| is a well-formed prelinked image. The image is trusted
+// so this only guards against truncated or stale files.
+static iree_status_t iree_elf_module_verify_image(
+    iree_const_byte_span_t image) {
+  const iree_elf_image_header_t* header =
+      (const iree_elf_image_header_t*)image.data;
+  if (image.data_length < sizeof(*header) ||
+      header->magic != IREE_ELF_IMAGE_MAGIC ||
+      header->version != IREE_ELF_IMAGE_VERSION) {
+    return iree_make_status(IREE_STATUS_DATA_LOSS,
+                            "prelinked ELF image header mismatch");
+  }
+  const iree_host_size_t table_size =
+      sizeof(*header) +
+      header->segment_count * sizeof(iree_elf_image_segment_t) +
+      header->relro_count * sizeof(iree_elf_image_range_t) +
+      header->rebase_count * sizeof(uint64_t);
+  if (header->rebase_count > image.data_length ||
+      table_size > image.data_length) {
+    return iree_make_status(IREE_STATUS_DATA_LOSS,
+                            "prelinked ELF image tables truncated");
+  }
+  const uint64_t vaddr_min = header->vaddr_offset;
+  const uint64_t vaddr_max = header->vaddr_offset + header->vaddr_length;
+  const iree_elf_image_segment_t* segments =
+      (const iree_elf_image_segment_t*)(image.data + sizeof(*header));
+  for (uint32_t i = 0; i < header->segment_count; ++i) {
+    const iree_elf_image_segment_t* segment = &segments[i];
+    if (segment->data_length > segment->memsz ||
+        segment->data_offset + segment->data_length > image.data_length ||
+        segment->vaddr < vaddr_min ||
+        segment->vaddr + segment->memsz > vaddr_max) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "prelinked ELF image segment %u out of bounds",
+                              i);
+    }
+  }
+  return iree_ok_status();
+}
+
+// Loads the segments of a verified prelinked |image| and rebases them.
+static iree_status_t iree_elf_module_load_image(iree_const_byte_span_t image,
+                                                iree_elf_module_t* module) {
+  const iree_elf_image_header_t* header =
+      (const iree_elf_image_header_t*)image.data;
+  const iree_elf_image_segment_t* segments =
+      (const iree_elf_image_segment_t*)(image.data + sizeof(*header));
+  const iree_elf_image_range_t* relros =
+      (const iree_elf_image_range_t*)(segments + header->segment_count);
+  const uint64_t* rebases = (const uint64_t*)(relros + header->relro_count);
+
+  iree_memory_info_t memory_info = iree_memory_query_info();
+  module->vaddr_size = iree_page_align_end(
+      (iree_host_size_t)header->vaddr_length, memory_info.normal_page_size);
+  IREE_RETURN_IF_ERROR(iree_memory_view_reserve(
+      IREE_MEMORY_VIEW_FLAG_MAY_EXECUTE, module->vaddr_size,
+      module->host_allocator, (void**)&module->vaddr_base));
+  module->vaddr_bias = module->vaddr_base - header->vaddr_offset;
+
+  for (uint32_t i = 0; i < header->segment_count; ++i) {
+    const iree_elf_image_segment_t* segment = &segments[i];
+    iree_byte_range_t byte_range = {
+        .offset = (iree_host_size_t)segment->vaddr,
+        .length = (iree_host_size_t)segment->memsz,
+    };
+    IREE_RETURN_IF_ERROR(iree_memory_view_commit_ranges(
+        module->vaddr_bias, 1, &byte_range,
+        IREE_MEMORY_ACCESS_READ | IREE_MEMORY_ACCESS_WRITE));
+    if (segment->data_length > 0) {
+      memcpy(module->vaddr_bias + segment->vaddr,
+             image.data + segment->data_offset,
+             (iree_host_size_t)segment->data_length);
+    }
+  }
+
+  const uint64_t vaddr_min = header->vaddr_offset;
+  const uint64_t vaddr_max = header->vaddr_offset + header->vaddr_length;
+  for (uint64_t i = 0; i < header->rebase_count; ++i) {
+    if (rebases[i] < vaddr_min || rebases[i] + sizeof(uintptr_t) > vaddr_max) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "prelinked ELF image rebase out of bounds");
+    }
+    uintptr_t* site = (uintptr_t*)(module->vaddr_bias + rebases[i]);
+    *site += (uintptr_t)module->vaddr_bias;
+  }
+
+  for (uint32_t i = 0; i < header->segment_count; ++i) {
+    const iree_elf_image_segment_t* segment = &segments[i];
+    iree_byte_range_t byte_range = {
+        .offset = (iree_host_size_t)segment->vaddr,
+        .length = (iree_host_size_t)segment->memsz,
+    };
+    IREE_RETURN_IF_ERROR(iree_memory_view_protect_ranges(
+        module->vaddr_bias, 1, &byte_range,
+        (iree_memory_access_t)segment->access));
+    if (segment->access & IREE_MEMORY_ACCESS_EXECUTE) {
+      iree_memory_flush_icache(module->vaddr_bias + segment->vaddr,
+                               (iree_host_size_t)segment->memsz);
+    }
+  }
+  for (uint32_t i = 0; i < header->relro_count; ++i) {
+    iree_byte_range_t byte_range = {
+        .offset = (iree_host_size_t)relros[i].vaddr,
+        .length = (iree_host_size_t)relros[i].length,
+    };
+    IREE_RETURN_IF_ERROR(iree_memory_view_protect_ranges(
+        module->vaddr_bias, 1, &byte_range, IREE_MEMORY_ACCESS_READ));
+  }
+
+  module->dynstr = (const char*)(module->vaddr_bias + header->dynstr_vaddr);
+  module->dynstr_size = (iree_host_size_t)header->dynstr_size;
+  module->dynsym =
+      (const iree_elf_sym_t*)(module->vaddr_bias + header->dynsym_vaddr);
+  module->dynsym_count = (iree_host_size_t)header->dynsym_count;
+  return iree_ok_status();
+}
+
 //==============================================================================
 // API
 //==============================================================================
 
-iree_status_t iree_elf_module_initialize_from_memory(
+static iree_status_t iree_elf_module_initialize_from_memory_impl(
     iree_const_byte_span_t raw_data,
     const iree_elf_import_table_t* import_table,
-    iree_allocator_t host_allocator, iree_elf_module_t* out_module) {
+    iree_allocator_t host_allocator, iree_elf_module_t* out_module,
+    iree_byte_span_t* out_image) {
   IREE_ASSERT_ARGUMENT(raw_data.data);
   IREE_ASSERT_ARGUMENT(out_module);
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -611,11 +1019,30 @@ iree_status_t iree_elf_module_initialize_from_memory(
     status = iree_elf_module_verify_no_imports(&load_state, out_module);
   }
 
+  // Snapshot the unrelocated segments if we are producing a prelinked image.
+  uint8_t* shadow = NULL;
+  if (iree_status_is_ok(status) && out_image) {
+    status =
+        iree_elf_module_snapshot_segments(&load_state, out_module, &shadow);
+  }
+
   // Apply relocations to the loaded pages.
   if (iree_status_is_ok(status)) {
     status = iree_elf_module_apply_relocations(&load_state, out_module);
   }
 
+  // Capture the prelinked image prior to protection and initialization.
+  // Modules that cannot be prelinked are still loaded without an image.
+  if (iree_status_is_ok(status) && out_image) {
+    iree_status_t image_status = iree_elf_module_build_image(
+        &load_state, out_module, shadow, out_image);
+    if (!iree_status_is_ok(image_status)) {
+      IREE_TRACE_ZONE_APPEND_TEXT(z0, "not prelinkable");
+      iree_status_ignore(image_status);
+    }
+  }
+  iree_allocator_free(host_allocator, shadow);
+
   // Apply final protections to the loaded pages now that relocations have been
   // performed.
   if (iree_status_is_ok(status)) {
@@ -632,6 +1059,67 @@ iree_status_t iree_elf_module_initialize_from_memory(
     // On failure gracefully clean up the module by releasing any allocated
     // memory during the partial initialization.
     iree_elf_module_deinitialize(out_module);
+    if (out_image) {
+      iree_allocator_free(host_allocator, out_image->data);
+      *out_image = iree_make_byte_span(NULL, 0);
+    }
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_elf_module_initialize_from_memory(
+    iree_const_byte_span_t raw_data,
+    const iree_elf_import_table_t* import_table,
+    iree_allocator_t host_allocator, iree_elf_module_t* out_module) {
+  return iree_elf_module_initialize_from_memory_impl(
+      raw_data, import_table, host_allocator, out_module, /*out_image=*/NULL);
+}
+
+iree_status_t iree_elf_module_initialize_and_prelink_from_memory(
+    iree_const_byte_span_t raw_data,
+    const iree_elf_import_table_t* import_table,
+    iree_allocator_t host_allocator, iree_elf_module_t* out_module,
+    iree_byte_span_t* out_image) {
+  IREE_ASSERT_ARGUMENT(out_image);
+  *out_image = iree_make_byte_span(NULL, 0);
+  return iree_elf_module_initialize_from_memory_impl(
+      raw_data, import_table, host_allocator, out_module, out_image);
+}
+
+iree_status_t iree_elf_module_initialize_from_image(
+    iree_const_byte_span_t image, iree_allocator_t host_allocator,
+    iree_elf_module_t* out_module) {
+  IREE_ASSERT_ARGUMENT(out_module);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  memset(out_module, 0, sizeof(*out_module));
+  out_module->host_allocator = host_allocator;
+
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(z0, iree_elf_module_verify_image(image));
+
+  iree_memory_jit_context_begin();
+  iree_status_t status = iree_elf_module_load_image(image, out_module);
+  iree_memory_jit_context_end();
+
+  // Initializers are run on every load as they may set up module state that
+  // was not captured in the image.
+  if (iree_status_is_ok(status)) {
+    const iree_elf_image_header_t* header =
+        (const iree_elf_image_header_t*)image.data;
+    iree_elf_module_load_state_t load_state;
+    memset(&load_state, 0, sizeof(load_state));
+    load_state.init = (iree_elf_addr_t)header->init_vaddr;
+    load_state.init_array =
+        header->init_array_count
+            ? (const iree_elf_addr_t*)(out_module->vaddr_bias +
+                                       header->init_array_vaddr)
+            : NULL;
+    load_state.init_array_count = (iree_host_size_t)header->init_array_count;
+    status = iree_elf_module_run_initializers(&load_state, out_module);
+  }
+
+  if (!iree_status_is_ok(status)) {
+    iree_elf_module_deinitialize(out_module);
   }
   IREE_TRACE_ZONE_END(z0);
   return status;
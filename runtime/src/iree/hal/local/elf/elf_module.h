@@ -77,6 +77,33 @@ iree_status_t iree_elf_module_initialize_from_memory(
     const iree_elf_import_table_t* import_table,
     iree_allocator_t host_allocator, iree_elf_module_t* out_module);
 
+// Initializes an ELF module as with iree_elf_module_initialize_from_memory and
+// additionally produces a prelinked image of the relocated module that can be
+// loaded with iree_elf_module_initialize_from_image in place of |raw_data|.
+//
+// The image is captured after relocation and before initializers run and is
+// only valid for the host it was produced on. Not all modules can be
+// prelinked: if a module has relocations that cannot be expressed as pointer
+// rebases |out_image| will be empty and the module is still initialized. If
+// non-empty the image must be freed with |host_allocator| by the caller.
+iree_status_t iree_elf_module_initialize_and_prelink_from_memory(
+    iree_const_byte_span_t raw_data,
+    const iree_elf_import_table_t* import_table,
+    iree_allocator_t host_allocator, iree_elf_module_t* out_module,
+    iree_byte_span_t* out_image);
+
+// Initializes an ELF module from a prelinked |image| produced by
+// iree_elf_module_initialize_and_prelink_from_memory on this host. The image
+// is trusted: headers, dynamic tables, and relocations are not processed and
+// the segments are copied into memory and rebased to their new address.
+// Initializers are executed as with iree_elf_module_initialize_from_memory.
+//
+// Returns IREE_STATUS_DATA_LOSS if the image is malformed or was produced by an
+// incompatible version of the runtime.
+iree_status_t iree_elf_module_initialize_from_image(
+    iree_const_byte_span_t image, iree_allocator_t host_allocator,
+    iree_elf_module_t* out_module);
+
 // Deinitializes a |module|, releasing any allocated executable or data pages.
 // Invalidates all symbol pointers previous retrieved from the module and any
 // pointer to data that may have been in the module text or rwdata.
@@ -51,23 +51,14 @@ static iree_status_t query_arch_test_file_data(
                           "the application for the current target platform");
 }
 
-static iree_status_t run_test() {
-  iree_const_byte_span_t file_data;
-  IREE_RETURN_IF_ERROR(query_arch_test_file_data(&file_data));
-
-  iree_elf_import_table_t import_table;
-  memset(&import_table, 0, sizeof(import_table));
-  iree_elf_module_t module;
-  IREE_RETURN_IF_ERROR(iree_elf_module_initialize_from_memory(
-      file_data, &import_table, iree_allocator_system(), &module));
-
+static iree_status_t run_module_test(iree_elf_module_t* module) {
   iree_hal_executable_environment_v0_t environment;
   iree_hal_executable_environment_initialize(iree_allocator_system(),
                                              &environment);
 
   void* query_fn_ptr = NULL;
   IREE_RETURN_IF_ERROR(iree_elf_module_lookup_export(
-      &module, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME, &query_fn_ptr));
+      module, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME, &query_fn_ptr));
 
   union {
     const iree_hal_executable_library_header_t** header;
@@ -140,18 +131,46 @@ static iree_status_t run_test() {
                             "dispatch function returned failure: %d", ret);
   }
 
-  iree_status_t status = iree_ok_status();
   for (int i = 0; i < IREE_ARRAYSIZE(expected); ++i) {
     if (ret0[i] != expected[i]) {
-      status =
-          iree_make_status(IREE_STATUS_INTERNAL,
-                           "output mismatch: ret[%d] = %.1f, expected %.1f", i,
-                           ret0[i], expected[i]);
-      break;
+      return iree_make_status(IREE_STATUS_INTERNAL,
+                              "output mismatch: ret[%d] = %.1f, expected %.1f",
+                              i, ret0[i], expected[i]);
     }
   }
+  return iree_ok_status();
+}
 
+static iree_status_t run_test() {
+  iree_const_byte_span_t file_data;
+  IREE_RETURN_IF_ERROR(query_arch_test_file_data(&file_data));
+
+  // Load from the ELF and capture a prelinked image.
+  iree_elf_import_table_t import_table;
+  memset(&import_table, 0, sizeof(import_table));
+  iree_elf_module_t module;
+  iree_byte_span_t image = iree_make_byte_span(NULL, 0);
+  IREE_RETURN_IF_ERROR(iree_elf_module_initialize_and_prelink_from_memory(
+      file_data, &import_table, iree_allocator_system(), &module, &image));
+  iree_status_t status = run_module_test(&module);
   iree_elf_module_deinitialize(&module);
+  if (iree_status_is_ok(status) && image.data_length == 0) {
+    status = iree_make_status(IREE_STATUS_INTERNAL,
+                              "test module could not be prelinked");
+  }
+
+  // Load again from the prelinked image.
+  if (iree_status_is_ok(status)) {
+    status = iree_elf_module_initialize_from_image(
+        iree_make_const_byte_span(image.data, image.data_length),
+        iree_allocator_system(), &module);
+    if (iree_status_is_ok(status)) {
+      status = run_module_test(&module);
+      iree_elf_module_deinitialize(&module);
+    }
+  }
+  iree_allocator_free(iree_allocator_system(), image.data);
+
   return status;
 }
 
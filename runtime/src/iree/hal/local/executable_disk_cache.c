@@ -0,0 +1,343 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/executable_disk_cache.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/cpu.h"
+#include "iree/base/internal/hash.h"
+#include "iree/hal/local/executable_environment.h"
+#include "iree/hal/local/executable_library.h"
+#include "iree/schemas/cpu_data.h"
+
+#if defined(IREE_PLATFORM_WINDOWS)
+#include <direct.h>
+#include <io.h>
+#elif !defined(IREE_PLATFORM_EMSCRIPTEN)
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif  // IREE_PLATFORM_*
+
+// Bumped whenever the key derivation changes so that stale entries are ignored.
+#define IREE_HAL_EXECUTABLE_DISK_CACHE_VERSION 2
+
+static_assert(sizeof(((iree_hal_executable_disk_cache_key_t*)NULL)->value) ==
+                  IREE_HASH_SHA256_DIGEST_SIZE,
+              "keys are SHA-256 digests");
+
+struct iree_hal_executable_disk_cache_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  // Digest identifying the host and runtime that is hashed into every key.
+  uint8_t host_seed[IREE_HASH_SHA256_DIGEST_SIZE];
+  // Counter used to produce unique temporary file names.
+  iree_atomic_int32_t temp_ordinal;
+  // Directory path without a trailing separator. Stored inline.
+  iree_string_view_t path;
+};
+
+// Computes the seed identifying the host and runtime build. Any change in
+// architecture, CPU features, or executable ABI results in new keys.
+// CPU data must have been initialized.
+static void iree_hal_executable_disk_cache_compute_host_seed(
+    uint8_t out_seed[IREE_HASH_SHA256_DIGEST_SIZE]) {
+  struct {
+    uint32_t cache_version;
+    uint32_t library_version;
+    uint32_t pointer_size;
+    uint32_t reserved;
+    uint64_t cpu_data[IREE_CPU_DATA_FIELD_COUNT];
+  } host_info;
+  memset(&host_info, 0, sizeof(host_info));
+  host_info.cache_version = IREE_HAL_EXECUTABLE_DISK_CACHE_VERSION;
+  host_info.library_version = IREE_HAL_EXECUTABLE_LIBRARY_VERSION_LATEST;
+  host_info.pointer_size = sizeof(void*);
+  iree_cpu_read_data(IREE_ARRAYSIZE(host_info.cpu_data), host_info.cpu_data);
+  iree_hash_sha256_t hasher;
+  iree_hash_sha256_initialize(&hasher);
+  iree_hash_sha256_update(&hasher, iree_make_const_byte_span(
+                                       IREE_ARCH, strlen(IREE_ARCH) + 1));
+  iree_hash_sha256_update(
+      &hasher, iree_make_const_byte_span(&host_info, sizeof(host_info)));
+  iree_hash_sha256_finalize(&hasher, out_seed);
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_executable_disk_cache_t
+//===----------------------------------------------------------------------===//
+
+// Creates the directory at |path| if it does not already exist.
+static iree_status_t iree_hal_executable_disk_cache_make_directory_single(
+    const char* path) {
+#if defined(IREE_PLATFORM_WINDOWS)
+  int ret = _mkdir(path);
+#elif defined(IREE_PLATFORM_EMSCRIPTEN)
+  int ret = -1;
+  errno = ENOTSUP;
+#else
+  int ret = mkdir(path, 0700);
+#endif  // IREE_PLATFORM_*
+  if (ret != 0 && errno != EEXIST) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "unable to create executable cache directory '%s'",
+                            path);
+  }
+  return iree_ok_status();
+}
+
+// Creates the directory at |path| and any missing parents. |path| is
+// temporarily modified to split it at each separator. Failures on parents
+// (drive roots, directories we cannot list, etc) are ignored as only the final
+// directory needs to be accessible.
+static iree_status_t iree_hal_executable_disk_cache_make_directory(
+    char* path) {
+  for (char* p = path + 1; *p; ++p) {
+    if (*p != '/' && *p != '\\') continue;
+    const char separator = *p;
+    *p = 0;
+    iree_status_ignore(
+        iree_hal_executable_disk_cache_make_directory_single(path));
+    *p = separator;
+  }
+  return iree_hal_executable_disk_cache_make_directory_single(path);
+}
+
+iree_status_t iree_hal_executable_disk_cache_create(
+    iree_string_view_t path, iree_allocator_t host_allocator,
+    iree_hal_executable_disk_cache_t** out_cache) {
+  IREE_ASSERT_ARGUMENT(out_cache);
+  *out_cache = NULL;
+  while (path.size > 1 && (path.data[path.size - 1] == '/' ||
+                           path.data[path.size - 1] == '\\')) {
+    --path.size;
+  }
+  if (iree_string_view_is_empty(path)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "executable cache directory path is empty");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, path.data, path.size);
+
+  iree_hal_executable_disk_cache_t* cache = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator,
+                                sizeof(*cache) + path.size + /*NUL=*/1,
+                                (void**)&cache));
+  iree_atomic_ref_count_init(&cache->ref_count);
+  cache->host_allocator = host_allocator;
+  iree_atomic_store(&cache->temp_ordinal, 0, iree_memory_order_relaxed);
+  char* path_storage = (char*)cache + sizeof(*cache);
+  memcpy(path_storage, path.data, path.size);
+  path_storage[path.size] = 0;
+  cache->path = iree_make_string_view(path_storage, path.size);
+
+  // The cache may be created before any executable environment so we must
+  // ensure the CPU data is populated before folding it into the seed.
+  iree_hal_executable_environment_initialize_cpu(host_allocator);
+  iree_hal_executable_disk_cache_compute_host_seed(cache->host_seed);
+
+  iree_status_t status =
+      iree_hal_executable_disk_cache_make_directory(path_storage);
+
+  if (iree_status_is_ok(status)) {
+    *out_cache = cache;
+  } else {
+    iree_hal_executable_disk_cache_release(cache);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_executable_disk_cache_destroy(
+    iree_hal_executable_disk_cache_t* cache) {
+  iree_allocator_t host_allocator = cache->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_free(host_allocator, cache);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+void iree_hal_executable_disk_cache_retain(
+    iree_hal_executable_disk_cache_t* cache) {
+  if (IREE_LIKELY(cache)) {
+    iree_atomic_ref_count_inc(&cache->ref_count);
+  }
+}
+
+void iree_hal_executable_disk_cache_release(
+    iree_hal_executable_disk_cache_t* cache) {
+  if (IREE_LIKELY(cache) &&
+      iree_atomic_ref_count_dec(&cache->ref_count) == 1) {
+    iree_hal_executable_disk_cache_destroy(cache);
+  }
+}
+
+iree_hal_executable_disk_cache_key_t iree_hal_executable_disk_cache_make_key(
+    iree_hal_executable_disk_cache_t* cache,
+    iree_string_view_t executable_format,
+    iree_const_byte_span_t executable_data) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, executable_data.data_length);
+  // Entries may be executed without further verification and must not be
+  // reachable from any other executable: this requires a collision resistant
+  // hash. The format is length-prefixed so that it cannot run into the data.
+  const uint64_t format_length = (uint64_t)executable_format.size;
+  iree_hash_sha256_t hasher;
+  iree_hash_sha256_initialize(&hasher);
+  iree_hash_sha256_update(&hasher, iree_make_const_byte_span(
+                                       cache->host_seed,
+                                       sizeof(cache->host_seed)));
+  iree_hash_sha256_update(&hasher, iree_make_const_byte_span(
+                                       &format_length, sizeof(format_length)));
+  iree_hash_sha256_update(&hasher,
+                          iree_make_const_byte_span(executable_format.data,
+                                                    executable_format.size));
+  iree_hash_sha256_update(&hasher, executable_data);
+  iree_hal_executable_disk_cache_key_t key;
+  iree_hash_sha256_finalize(&hasher, key.value);
+  IREE_TRACE_ZONE_END(z0);
+  return key;
+}
+
+iree_status_t iree_hal_executable_disk_cache_entry_path(
+    iree_hal_executable_disk_cache_t* cache,
+    iree_hal_executable_disk_cache_key_t key, iree_string_view_t extension,
+    iree_allocator_t host_allocator, char** out_path) {
+  IREE_ASSERT_ARGUMENT(out_path);
+  *out_path = NULL;
+  // <path>/<64 hex digits>.<extension>
+  const iree_host_size_t path_capacity = cache->path.size + 1 +
+                                         2 * sizeof(key.value) + 1 +
+                                         extension.size + /*NUL=*/1;
+  char* path = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(host_allocator, path_capacity, (void**)&path));
+  char key_hex[2 * sizeof(key.value) + /*NUL=*/1];
+  for (iree_host_size_t i = 0; i < sizeof(key.value); ++i) {
+    snprintf(key_hex + 2 * i, 3, "%02x", key.value[i]);
+  }
+  snprintf(path, path_capacity, "%.*s/%s.%.*s", (int)cache->path.size,
+           cache->path.data, key_hex, (int)extension.size, extension.data);
+  *out_path = path;
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_executable_disk_cache_map_entry(
+    iree_hal_executable_disk_cache_t* cache,
+    iree_hal_executable_disk_cache_key_t key, iree_string_view_t extension,
+    iree_allocator_t host_allocator, iree_file_contents_t** out_contents) {
+  IREE_ASSERT_ARGUMENT(out_contents);
+  *out_contents = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  char* path = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_executable_disk_cache_entry_path(cache, key, extension,
+                                                    host_allocator, &path));
+  iree_status_t status = iree_file_exists(path);
+  if (iree_status_is_ok(status)) {
+    status =
+        iree_file_map_contents_readonly(path, host_allocator, out_contents);
+  }
+  iree_allocator_free(host_allocator, path);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Flushes the contents of |file| to stable storage. Returns 0 on success.
+static int iree_hal_executable_disk_cache_sync_file(FILE* file) {
+#if defined(IREE_PLATFORM_WINDOWS)
+  return _commit(_fileno(file));
+#elif defined(IREE_PLATFORM_EMSCRIPTEN)
+  return 0;
+#else
+  return fsync(fileno(file));
+#endif  // IREE_PLATFORM_*
+}
+
+// Writes |contents| to a new file at |path| and flushes it to stable storage.
+// The data must be durable before the file is renamed into place as otherwise
+// a crash may leave a complete-looking entry with truncated contents.
+static iree_status_t iree_hal_executable_disk_cache_write_file(
+    const char* path, iree_const_byte_span_t contents) {
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "unable to open executable cache entry '%s'",
+                            path);
+  }
+  iree_status_t status = iree_ok_status();
+  if (contents.data_length > 0 &&
+      fwrite(contents.data, contents.data_length, 1, file) != 1) {
+    status = iree_make_status(IREE_STATUS_DATA_LOSS,
+                              "unable to write %" PRIhsz
+                              " bytes to executable cache entry '%s'",
+                              contents.data_length, path);
+  }
+  if (iree_status_is_ok(status) && fflush(file) != 0) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "unable to flush executable cache entry '%s'",
+                              path);
+  }
+  if (iree_status_is_ok(status) &&
+      iree_hal_executable_disk_cache_sync_file(file) != 0) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "unable to sync executable cache entry '%s'",
+                              path);
+  }
+  if (fclose(file) != 0 && iree_status_is_ok(status)) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "unable to close executable cache entry '%s'",
+                              path);
+  }
+  return status;
+}
+
+iree_status_t iree_hal_executable_disk_cache_store_entry(
+    iree_hal_executable_disk_cache_t* cache,
+    iree_hal_executable_disk_cache_key_t key, iree_string_view_t extension,
+    iree_const_byte_span_t contents) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, contents.data_length);
+
+  char* path = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_hal_executable_disk_cache_entry_path(
+          cache, key, extension, cache->host_allocator, &path));
+
+  // Write to a temporary file in the same directory and rename it into place
+  // so that readers never observe a partially written entry. The temporary
+  // name only needs to be unique among concurrent writers.
+  const iree_host_size_t temp_path_capacity = strlen(path) + 64;
+  char* temp_path = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      cache->host_allocator, temp_path_capacity, (void**)&temp_path);
+  if (iree_status_is_ok(status)) {
+    snprintf(temp_path, temp_path_capacity, "%s.%016" PRIx64 ".%d.tmp", path,
+             (uint64_t)iree_time_now() ^ (uint64_t)(uintptr_t)&temp_path,
+             iree_atomic_fetch_add(&cache->temp_ordinal, 1,
+                                   iree_memory_order_relaxed));
+    status = iree_hal_executable_disk_cache_write_file(temp_path, contents);
+    if (iree_status_is_ok(status) && rename(temp_path, path) != 0) {
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "unable to move executable cache entry into "
+                                "place at '%s'",
+                                path);
+    }
+    if (!iree_status_is_ok(status)) remove(temp_path);
+  }
+  iree_allocator_free(cache->host_allocator, temp_path);
+  iree_allocator_free(cache->host_allocator, path);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
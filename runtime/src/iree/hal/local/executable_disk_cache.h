@@ -0,0 +1,94 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_EXECUTABLE_DISK_CACHE_H_
+#define IREE_HAL_LOCAL_EXECUTABLE_DISK_CACHE_H_
+
+#include "iree/base/api.h"
+#include "iree/base/internal/file_io.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_executable_disk_cache_t
+//===----------------------------------------------------------------------===//
+
+// Identifies a cache entry derived from executable contents and the host.
+// The key is a SHA-256 digest so that distinct executables cannot be made to
+// share an entry.
+typedef struct iree_hal_executable_disk_cache_key_t {
+  uint8_t value[32];
+} iree_hal_executable_disk_cache_key_t;
+
+// A persistent directory of loader-specific artifacts derived from executables
+// such as prelinked images or extracted system libraries. Loaders use it to
+// skip work on warm starts when a process loads the same executables again.
+//
+// Entries are keyed by a SHA-256 of the executable format and contents combined
+// with the host architecture, CPU features, and runtime ABI version so that a
+// directory can be shared by processes on different machines. Entries are
+// written atomically and concurrent processes may populate the same directory.
+//
+// The contents of the directory are trusted: loaders may execute entries with
+// little to no verification. Only point it at directories that are writable
+// solely by the user running the process.
+//
+// Thread-safe; the cache holds no mutable state.
+typedef struct iree_hal_executable_disk_cache_t
+    iree_hal_executable_disk_cache_t;
+
+// Creates a cache storing entries in the directory at |path|. The directory and
+// any missing parents are created. Only supported on platforms with file I/O.
+iree_status_t iree_hal_executable_disk_cache_create(
+    iree_string_view_t path, iree_allocator_t host_allocator,
+    iree_hal_executable_disk_cache_t** out_cache);
+
+// Retains the given |cache| for the caller.
+void iree_hal_executable_disk_cache_retain(
+    iree_hal_executable_disk_cache_t* cache);
+
+// Releases the given |cache| from the caller.
+void iree_hal_executable_disk_cache_release(
+    iree_hal_executable_disk_cache_t* cache);
+
+// Returns the key for the entry derived from |executable_data| in
+// |executable_format|.
+iree_hal_executable_disk_cache_key_t iree_hal_executable_disk_cache_make_key(
+    iree_hal_executable_disk_cache_t* cache,
+    iree_string_view_t executable_format,
+    iree_const_byte_span_t executable_data);
+
+// Returns the path of the entry with |key| and file |extension| in a
+// NUL-terminated string allocated from |host_allocator|. The entry may not
+// exist.
+iree_status_t iree_hal_executable_disk_cache_entry_path(
+    iree_hal_executable_disk_cache_t* cache,
+    iree_hal_executable_disk_cache_key_t key, iree_string_view_t extension,
+    iree_allocator_t host_allocator, char** out_path);
+
+// Maps the contents of the entry with |key| and |extension| for reading.
+// Returns IREE_STATUS_NOT_FOUND if the entry does not exist.
+iree_status_t iree_hal_executable_disk_cache_map_entry(
+    iree_hal_executable_disk_cache_t* cache,
+    iree_hal_executable_disk_cache_key_t key, iree_string_view_t extension,
+    iree_allocator_t host_allocator, iree_file_contents_t** out_contents);
+
+// Atomically stores |contents| as the entry with |key| and |extension|.
+// Readers will either observe no entry or the complete entry. If multiple
+// processes store the same entry concurrently one of them wins.
+iree_status_t iree_hal_executable_disk_cache_store_entry(
+    iree_hal_executable_disk_cache_t* cache,
+    iree_hal_executable_disk_cache_key_t key, iree_string_view_t extension,
+    iree_const_byte_span_t contents);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_EXECUTABLE_DISK_CACHE_H_
@@ -0,0 +1,279 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/executable_disk_cache.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/cpu.h"
+#include "iree/base/internal/file_io.h"
+#include "iree/schemas/cpu_data.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+#if !defined(IREE_PLATFORM_WINDOWS)
+#include <dirent.h>
+#endif  // !IREE_PLATFORM_WINDOWS
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+// Returns a unique directory path under the test temporary directory.
+static std::string GetUniqueDirectory(const char* unique_name) {
+  const char* tmpdir = getenv("TEST_TMPDIR");
+  if (!tmpdir) tmpdir = getenv("TMPDIR");
+  if (!tmpdir) tmpdir = getenv("TEMP");
+  if (!tmpdir) tmpdir = "/tmp";
+  std::random_device device;
+  uint64_t random = (static_cast<uint64_t>(device()) << 32) | device();
+  char path[512];
+  snprintf(path, sizeof(path), "%s/iree_disk_cache_test_%016" PRIx64 "/%s",
+           tmpdir, random, unique_name);
+  return path;
+}
+
+class ExecutableDiskCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    directory_ = GetUniqueDirectory(
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    IREE_ASSERT_OK(CreateCache(&cache_));
+  }
+
+  void TearDown() override { iree_hal_executable_disk_cache_release(cache_); }
+
+  iree_status_t CreateCache(iree_hal_executable_disk_cache_t** out_cache) {
+    return iree_hal_executable_disk_cache_create(
+        iree_make_string_view(directory_.data(), directory_.size()),
+        iree_allocator_system(), out_cache);
+  }
+
+  // Returns the contents of the entry with |key| or an empty string if it
+  // could not be mapped.
+  std::string ReadEntry(iree_hal_executable_disk_cache_t* cache,
+                        iree_hal_executable_disk_cache_key_t key) {
+    iree_file_contents_t* contents = NULL;
+    iree_status_t status = iree_hal_executable_disk_cache_map_entry(
+        cache, key, IREE_SV("bin"), iree_allocator_system(), &contents);
+    if (!iree_status_is_ok(status)) {
+      iree_status_ignore(status);
+      return std::string();
+    }
+    std::string result(
+        reinterpret_cast<const char*>(contents->const_buffer.data),
+        contents->const_buffer.data_length);
+    iree_file_contents_free(contents);
+    return result;
+  }
+
+  // Returns the names of all files in the cache directory.
+  std::vector<std::string> ListDirectory() {
+    std::vector<std::string> names;
+#if !defined(IREE_PLATFORM_WINDOWS)
+    DIR* dir = opendir(directory_.c_str());
+    if (!dir) return names;
+    while (struct dirent* entry = readdir(dir)) {
+      if (entry->d_name[0] == '.') continue;
+      names.push_back(entry->d_name);
+    }
+    closedir(dir);
+#endif  // !IREE_PLATFORM_WINDOWS
+    return names;
+  }
+
+  std::string directory_;
+  iree_hal_executable_disk_cache_t* cache_ = NULL;
+};
+
+static iree_const_byte_span_t MakeSpan(const std::string& value) {
+  return iree_make_const_byte_span(value.data(), value.size());
+}
+
+TEST_F(ExecutableDiskCacheTest, StoreAndMap) {
+  std::string executable = "executable contents";
+  iree_hal_executable_disk_cache_key_t key =
+      iree_hal_executable_disk_cache_make_key(cache_, IREE_SV("format"),
+                                              MakeSpan(executable));
+
+  iree_file_contents_t* contents = NULL;
+  EXPECT_THAT(Status(iree_hal_executable_disk_cache_map_entry(
+                  cache_, key, IREE_SV("bin"), iree_allocator_system(),
+                  &contents)),
+              StatusIs(StatusCode::kNotFound));
+
+  std::string entry = "derived artifact";
+  IREE_ASSERT_OK(iree_hal_executable_disk_cache_store_entry(
+      cache_, key, IREE_SV("bin"), MakeSpan(entry)));
+  EXPECT_EQ(ReadEntry(cache_, key), entry);
+
+  // Another cache on the same directory in the same process sees the entry.
+  iree_hal_executable_disk_cache_t* other_cache = NULL;
+  IREE_ASSERT_OK(CreateCache(&other_cache));
+  iree_hal_executable_disk_cache_key_t other_key =
+      iree_hal_executable_disk_cache_make_key(other_cache, IREE_SV("format"),
+                                              MakeSpan(executable));
+  EXPECT_EQ(memcmp(&key, &other_key, sizeof(key)), 0);
+  EXPECT_EQ(ReadEntry(other_cache, other_key), entry);
+  iree_hal_executable_disk_cache_release(other_cache);
+}
+
+TEST_F(ExecutableDiskCacheTest, KeysIncludeFormatAndData) {
+  std::string executable = "executable contents";
+  iree_hal_executable_disk_cache_key_t key =
+      iree_hal_executable_disk_cache_make_key(cache_, IREE_SV("format"),
+                                              MakeSpan(executable));
+  iree_hal_executable_disk_cache_key_t format_key =
+      iree_hal_executable_disk_cache_make_key(cache_, IREE_SV("other-format"),
+                                              MakeSpan(executable));
+  std::string other_executable = "executable contentz";
+  iree_hal_executable_disk_cache_key_t data_key =
+      iree_hal_executable_disk_cache_make_key(cache_, IREE_SV("format"),
+                                              MakeSpan(other_executable));
+  EXPECT_NE(memcmp(&key, &format_key, sizeof(key)), 0);
+  EXPECT_NE(memcmp(&key, &data_key, sizeof(key)), 0);
+
+  // Moving bytes between the format and the data must change the key.
+  iree_hal_executable_disk_cache_key_t split_key =
+      iree_hal_executable_disk_cache_make_key(cache_, IREE_SV("formate"),
+                                              MakeSpan("xecutable contents"));
+  EXPECT_NE(memcmp(&key, &split_key, sizeof(key)), 0);
+}
+
+// Entries are named by the full 256-bit key.
+TEST_F(ExecutableDiskCacheTest, EntryNamesAreFullDigests) {
+  std::string executable = "executable contents";
+  iree_hal_executable_disk_cache_key_t key =
+      iree_hal_executable_disk_cache_make_key(cache_, IREE_SV("format"),
+                                              MakeSpan(executable));
+  IREE_ASSERT_OK(iree_hal_executable_disk_cache_store_entry(
+      cache_, key, IREE_SV("bin"), MakeSpan("derived artifact")));
+#if !defined(IREE_PLATFORM_WINDOWS)
+  std::vector<std::string> names = ListDirectory();
+  ASSERT_EQ(names.size(), 1);
+  std::string expected_name;
+  for (uint8_t byte : key.value) {
+    static const char kHexDigits[] = "0123456789abcdef";
+    expected_name += kHexDigits[byte >> 4];
+    expected_name += kHexDigits[byte & 0xF];
+  }
+  expected_name += ".bin";
+  EXPECT_EQ(names[0], expected_name);
+#endif  // !IREE_PLATFORM_WINDOWS
+}
+
+// Entries written by a host with different CPU features must not be visible to
+// this host. Simulated by overriding the process CPU data between caches.
+TEST_F(ExecutableDiskCacheTest, HostSeedMismatch) {
+  std::string executable = "executable contents";
+  iree_hal_executable_disk_cache_key_t key =
+      iree_hal_executable_disk_cache_make_key(cache_, IREE_SV("format"),
+                                              MakeSpan(executable));
+  std::string entry = "derived artifact";
+  IREE_ASSERT_OK(iree_hal_executable_disk_cache_store_entry(
+      cache_, key, IREE_SV("bin"), MakeSpan(entry)));
+
+  uint64_t original_fields[IREE_CPU_DATA_FIELD_COUNT];
+  iree_cpu_read_data(IREE_ARRAYSIZE(original_fields), original_fields);
+  uint64_t other_fields[IREE_CPU_DATA_FIELD_COUNT];
+  memcpy(other_fields, original_fields, sizeof(other_fields));
+  other_fields[0] ^= 1ull << 63;
+  iree_cpu_initialize_with_data(IREE_ARRAYSIZE(other_fields), other_fields);
+
+  iree_hal_executable_disk_cache_t* other_cache = NULL;
+  iree_status_t status = CreateCache(&other_cache);
+  iree_cpu_initialize_with_data(IREE_ARRAYSIZE(original_fields),
+                                original_fields);
+  IREE_ASSERT_OK(status);
+
+  iree_hal_executable_disk_cache_key_t other_key =
+      iree_hal_executable_disk_cache_make_key(other_cache, IREE_SV("format"),
+                                              MakeSpan(executable));
+  EXPECT_NE(memcmp(&key, &other_key, sizeof(key)), 0);
+  iree_file_contents_t* contents = NULL;
+  EXPECT_THAT(Status(iree_hal_executable_disk_cache_map_entry(
+                  other_cache, other_key, IREE_SV("bin"),
+                  iree_allocator_system(), &contents)),
+              StatusIs(StatusCode::kNotFound));
+  iree_hal_executable_disk_cache_release(other_cache);
+
+  // The original host still hits its entry.
+  EXPECT_EQ(ReadEntry(cache_, key), entry);
+}
+
+// Concurrent writers of the same key must leave exactly one complete entry and
+// no temporary files behind.
+TEST_F(ExecutableDiskCacheTest, ConcurrentStoresToSameKey) {
+  std::string executable = "executable contents";
+  iree_hal_executable_disk_cache_key_t key =
+      iree_hal_executable_disk_cache_make_key(cache_, IREE_SV("format"),
+                                              MakeSpan(executable));
+
+  static constexpr int kThreadCount = 8;
+  static constexpr int kStoresPerThread = 16;
+  static constexpr size_t kEntrySize = 64 * 1024;
+  std::vector<std::string> entries;
+  for (int i = 0; i < kThreadCount; ++i) {
+    entries.push_back(std::string(kEntrySize, static_cast<char>('a' + i)));
+  }
+  std::vector<iree_status_code_t> status_codes(kThreadCount, IREE_STATUS_OK);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < kStoresPerThread; ++j) {
+        iree_status_t status = iree_hal_executable_disk_cache_store_entry(
+            cache_, key, IREE_SV("bin"), MakeSpan(entries[i]));
+        if (!iree_status_is_ok(status)) {
+          status_codes[i] = iree_status_consume_code(status);
+          return;
+        }
+        // Readers racing with writers observe a complete entry.
+        std::string contents = ReadEntry(cache_, key);
+        if (contents.size() != kEntrySize ||
+            contents.find_first_not_of(contents[0]) != std::string::npos) {
+          status_codes[i] = IREE_STATUS_DATA_LOSS;
+          return;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int i = 0; i < kThreadCount; ++i) {
+    EXPECT_EQ(status_codes[i], IREE_STATUS_OK);
+  }
+
+  std::string contents = ReadEntry(cache_, key);
+  ASSERT_EQ(contents.size(), kEntrySize);
+  EXPECT_GE(contents[0], 'a');
+  EXPECT_LT(contents[0], 'a' + kThreadCount);
+  EXPECT_EQ(contents.find_first_not_of(contents[0]), std::string::npos);
+
+#if !defined(IREE_PLATFORM_WINDOWS)
+  std::vector<std::string> names = ListDirectory();
+  ASSERT_EQ(names.size(), 1);
+  EXPECT_EQ(names[0].find(".tmp"), std::string::npos);
+#endif  // !IREE_PLATFORM_WINDOWS
+}
+
+TEST(ExecutableDiskCacheCreateTest, EmptyPath) {
+  iree_hal_executable_disk_cache_t* cache = NULL;
+  EXPECT_THAT(Status(iree_hal_executable_disk_cache_create(
+                  iree_string_view_empty(), iree_allocator_system(), &cache)),
+              StatusIs(StatusCode::kInvalidArgument));
+  EXPECT_EQ(cache, nullptr);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -6,12 +6,54 @@
 
 #include "iree/hal/local/executable_environment.h"
 
+#include "iree/base/internal/call_once.h"
 #include "iree/base/internal/cpu.h"
 
 //===----------------------------------------------------------------------===//
 // iree_hal_executable_environment_*_t
 //===----------------------------------------------------------------------===//
 
+#if !IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201102L) && \
+    !__STDC_NO_THREADS__
+#define iree_thread_local _Thread_local
+#elif defined(IREE_COMPILER_MSVC)
+#define iree_thread_local __declspec(thread)
+#else
+#define iree_thread_local
+#endif  // __STDC_NO_THREADS__
+
+static iree_once_flag iree_hal_executable_environment_cpu_flag_ =
+    IREE_ONCE_FLAG_INIT;
+
+// iree_call_once takes no arguments so the allocator of the thread that wins
+// the initialization is passed through thread-local storage. Without
+// thread-local storage all threads share the slot and initialization may use
+// any of the allocators of the racing callers, all of which remain live while
+// they block on the once flag.
+static iree_thread_local iree_allocator_t
+    iree_hal_executable_environment_cpu_temp_allocator_;
+
+static void iree_hal_executable_environment_initialize_cpu_once(void) {
+  iree_cpu_initialize(iree_hal_executable_environment_cpu_temp_allocator_);
+}
+
+#endif  // !IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+
+void iree_hal_executable_environment_initialize_cpu(
+    iree_allocator_t temp_allocator) {
+  // Executables may be loaded concurrently and re-initializing would clear the
+  // CPU data while other threads read it.
+#if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+  iree_cpu_initialize(temp_allocator);
+#else
+  iree_hal_executable_environment_cpu_temp_allocator_ = temp_allocator;
+  iree_call_once(&iree_hal_executable_environment_cpu_flag_,
+                 iree_hal_executable_environment_initialize_cpu_once);
+#endif  // IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+}
+
 void iree_hal_executable_environment_initialize(
     iree_allocator_t temp_allocator,
     iree_hal_executable_environment_v0_t* out_environment) {
@@ -20,9 +62,8 @@ void iree_hal_executable_environment_initialize(
   memset(out_environment, 0, sizeof(*out_environment));
 
   // Force CPU initialization.
-  // TODO(benvanik): move this someplace better? Technically not thread-safe
-  // but should be enough for usage within the HAL.
-  iree_cpu_initialize(temp_allocator);
+  // TODO(benvanik): move this someplace better?
+  iree_hal_executable_environment_initialize_cpu(temp_allocator);
 
   // Will fill all of the required fields and zero any extras.
   iree_cpu_read_data(IREE_HAL_PROCESSOR_DATA_CAPACITY_V0,
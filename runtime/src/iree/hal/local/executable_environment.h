@@ -28,6 +28,14 @@ void iree_hal_executable_environment_initialize(
     iree_allocator_t temp_allocator,
     iree_hal_executable_environment_v0_t* out_environment);
 
+// Initializes the process-wide CPU data used by executables if it has not
+// already been initialized. Safe to call concurrently from multiple threads.
+// Components that read CPU data (such as to key caches) before any executable
+// environment has been initialized must call this first.
+// |temp_allocator| may be used for temporary allocations during initialization.
+void iree_hal_executable_environment_initialize_cpu(
+    iree_allocator_t temp_allocator);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -137,7 +137,7 @@ static iree_status_t iree_hal_executable_library_run(
   iree_hal_executable_loader_t* executable_loader = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_create_executable_loader_by_name(
       iree_make_cstring_view(FLAG_executable_format), plugin_manager,
-      host_allocator, &executable_loader));
+      /*disk_cache=*/NULL, host_allocator, &executable_loader));
 
   // Setup the specification used to perform the executable load.
   // This information is normally used to select the appropriate loader but in
@@ -12,6 +12,7 @@
 
 #include "iree/hal/api.h"
 #include "iree/hal/local/elf/elf_module.h"
+#include "iree/hal/local/executable_disk_cache.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/executable_library_util.h"
 #include "iree/hal/local/executable_plugin_manager.h"
@@ -82,9 +83,63 @@ static iree_status_t iree_hal_elf_executable_query_library(
   return iree_ok_status();
 }
 
+// Loads the ELF module from |executable_params|, using a prelinked image from
+// |disk_cache| when available and populating it otherwise.
+static iree_status_t iree_hal_elf_executable_load_module(
+    const iree_hal_executable_params_t* executable_params,
+    iree_hal_executable_disk_cache_t* disk_cache,
+    iree_allocator_t host_allocator, iree_elf_module_t* out_module) {
+  if (!disk_cache) {
+    return iree_elf_module_initialize_from_memory(
+        executable_params->executable_data, /*import_table=*/NULL,
+        host_allocator, out_module);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  const iree_string_view_t extension = IREE_SV("elfimg");
+  iree_hal_executable_disk_cache_key_t key =
+      iree_hal_executable_disk_cache_make_key(
+          disk_cache, executable_params->executable_format,
+          executable_params->executable_data);
+
+  // Warm start: the prelinked image is copied into place and rebased. Missing,
+  // stale, or unreadable entries fall back to a full load that replaces them.
+  iree_file_contents_t* contents = NULL;
+  iree_status_t status = iree_hal_executable_disk_cache_map_entry(
+      disk_cache, key, extension, host_allocator, &contents);
+  if (iree_status_is_ok(status)) {
+    status = iree_elf_module_initialize_from_image(contents->const_buffer,
+                                                   host_allocator, out_module);
+    iree_file_contents_free(contents);
+  }
+  if (iree_status_is_ok(status)) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "hit");
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, "miss");
+  iree_status_ignore(status);
+
+  // Cold start: load from the ELF and store the prelinked image if the module
+  // supports it. Failing to populate the cache does not fail the load.
+  iree_byte_span_t image = iree_make_byte_span(NULL, 0);
+  status = iree_elf_module_initialize_and_prelink_from_memory(
+      executable_params->executable_data, /*import_table=*/NULL,
+      host_allocator, out_module, &image);
+  if (iree_status_is_ok(status) && image.data_length > 0) {
+    iree_status_ignore(iree_hal_executable_disk_cache_store_entry(
+        disk_cache, key, extension,
+        iree_make_const_byte_span(image.data, image.data_length)));
+  }
+  iree_allocator_free(host_allocator, image.data);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 static iree_status_t iree_hal_elf_executable_create(
     const iree_hal_executable_params_t* executable_params,
     const iree_hal_executable_import_provider_t import_provider,
+    iree_hal_executable_disk_cache_t* disk_cache,
     iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
   IREE_ASSERT_ARGUMENT(executable_params);
   IREE_ASSERT_ARGUMENT(executable_params->executable_data.data &&
@@ -121,9 +176,8 @@ static iree_status_t iree_hal_elf_executable_create(
 
   // Attempt to load the ELF module.
   if (iree_status_is_ok(status)) {
-    status = iree_elf_module_initialize_from_memory(
-        executable_params->executable_data, /*import_table=*/NULL,
-        host_allocator, &executable->module);
+    status = iree_hal_elf_executable_load_module(
+        executable_params, disk_cache, host_allocator, &executable->module);
   }
 
   // Query metadata and get the entry point function pointers.
@@ -228,6 +282,7 @@ typedef struct iree_hal_embedded_elf_loader_t {
   iree_hal_executable_loader_t base;
   iree_allocator_t host_allocator;
   iree_hal_executable_plugin_manager_t* plugin_manager;
+  iree_hal_executable_disk_cache_t* disk_cache;  // optional
 } iree_hal_embedded_elf_loader_t;
 
 static const iree_hal_executable_loader_vtable_t
@@ -235,6 +290,7 @@ static const iree_hal_executable_loader_vtable_t
 
 iree_status_t iree_hal_embedded_elf_loader_create(
     iree_hal_executable_plugin_manager_t* plugin_manager,
+    iree_hal_executable_disk_cache_t* disk_cache,
     iree_allocator_t host_allocator,
     iree_hal_executable_loader_t** out_executable_loader) {
   IREE_ASSERT_ARGUMENT(out_executable_loader);
@@ -253,6 +309,8 @@ iree_status_t iree_hal_embedded_elf_loader_create(
     executable_loader->plugin_manager = plugin_manager;
     iree_hal_executable_plugin_manager_retain(
         executable_loader->plugin_manager);
+    executable_loader->disk_cache = disk_cache;
+    iree_hal_executable_disk_cache_retain(executable_loader->disk_cache);
     *out_executable_loader = (iree_hal_executable_loader_t*)executable_loader;
   }
 
@@ -267,6 +325,7 @@ static void iree_hal_embedded_elf_loader_destroy(
   iree_allocator_t host_allocator = executable_loader->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_executable_disk_cache_release(executable_loader->disk_cache);
   iree_hal_executable_plugin_manager_release(executable_loader->plugin_manager);
   iree_allocator_free(host_allocator, executable_loader);
 
@@ -292,7 +351,8 @@ static iree_status_t iree_hal_embedded_elf_loader_try_load(
   // Perform the load of the ELF and wrap it in an executable handle.
   iree_status_t status = iree_hal_elf_executable_create(
       executable_params, base_executable_loader->import_provider,
-      executable_loader->host_allocator, out_executable);
+      executable_loader->disk_cache, executable_loader->host_allocator,
+      out_executable);
 
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -17,6 +17,8 @@
 extern "C" {
 #endif  // __cplusplus
 
+typedef struct iree_hal_executable_disk_cache_t
+    iree_hal_executable_disk_cache_t;
 typedef struct iree_hal_executable_plugin_manager_t
     iree_hal_executable_plugin_manager_t;
 
@@ -24,8 +26,13 @@ typedef struct iree_hal_executable_plugin_manager_t
 // libraries on any platform. This allows us to use a single file format across
 // all operating systems at the cost of some missing debugging/profiling
 // features.
+//
+// If an optional |disk_cache| is provided prelinked images of loaded ELFs are
+// stored in it and subsequent loads of the same executables skip verification
+// and relocation.
 iree_status_t iree_hal_embedded_elf_loader_create(
     iree_hal_executable_plugin_manager_t* plugin_manager,
+    iree_hal_executable_disk_cache_t* disk_cache,
     iree_allocator_t host_allocator,
     iree_hal_executable_loader_t** out_executable_loader);
 
@@ -0,0 +1,245 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/loaders/embedded_elf_loader.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/file_io.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/executable_disk_cache.h"
+#include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/local_executable.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+// ELF modules for various platforms embedded in the binary:
+#include "iree/hal/local/elf/testdata/elementwise_mul.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+// Returns the ELF testdata for the current architecture or an empty span if
+// none is available.
+static iree_const_byte_span_t QueryArchTestFileData() {
+  iree_string_view_t pattern = iree_string_view_empty();
+#if defined(IREE_ARCH_ARM_32)
+  pattern = IREE_SV("*_arm_32.so");
+#elif defined(IREE_ARCH_ARM_64)
+  pattern = IREE_SV("*_arm_64.so");
+#elif defined(IREE_ARCH_RISCV_32)
+  pattern = IREE_SV("*_riscv_32.so");
+#elif defined(IREE_ARCH_RISCV_64)
+  pattern = IREE_SV("*_riscv_64.so");
+#elif defined(IREE_ARCH_X86_32)
+  pattern = IREE_SV("*_x86_32.so");
+#elif defined(IREE_ARCH_X86_64)
+  pattern = IREE_SV("*_x86_64.so");
+#endif  // IREE_ARCH_*
+  if (iree_string_view_is_empty(pattern)) {
+    return iree_make_const_byte_span(NULL, 0);
+  }
+  for (size_t i = 0; i < elementwise_mul_size(); ++i) {
+    const struct iree_file_toc_t* file_toc = &elementwise_mul_create()[i];
+    if (iree_string_view_match_pattern(iree_make_cstring_view(file_toc->name),
+                                       pattern)) {
+      return iree_make_const_byte_span(file_toc->data, file_toc->size);
+    }
+  }
+  return iree_make_const_byte_span(NULL, 0);
+}
+
+// Returns a unique directory path under the test temporary directory.
+static std::string GetUniqueDirectory(const char* unique_name) {
+  const char* tmpdir = getenv("TEST_TMPDIR");
+  if (!tmpdir) tmpdir = getenv("TMPDIR");
+  if (!tmpdir) tmpdir = getenv("TEMP");
+  if (!tmpdir) tmpdir = "/tmp";
+  std::random_device device;
+  uint64_t random = (static_cast<uint64_t>(device()) << 32) | device();
+  char path[512];
+  snprintf(path, sizeof(path), "%s/iree_elf_loader_test_%016" PRIx64 "/%s",
+           tmpdir, random, unique_name);
+  return path;
+}
+
+// Tests loading through a disk cache of prelinked images. Entries that are
+// missing, truncated, or corrupted must fall back to a full load from the ELF
+// and be replaced with a valid image.
+class EmbeddedElfLoaderDiskCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    executable_data_ = QueryArchTestFileData();
+    if (!executable_data_.data_length) {
+      GTEST_SKIP() << "no ELF testdata for the current architecture";
+    }
+    std::string directory = GetUniqueDirectory(
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    IREE_ASSERT_OK(iree_hal_executable_disk_cache_create(
+        iree_make_string_view(directory.data(), directory.size()),
+        iree_allocator_system(), &disk_cache_));
+    IREE_ASSERT_OK(iree_hal_embedded_elf_loader_create(
+        /*plugin_manager=*/NULL, disk_cache_, iree_allocator_system(),
+        &loader_));
+
+    iree_hal_executable_params_initialize(&executable_params_);
+    executable_params_.caching_mode =
+        IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION |
+        IREE_HAL_EXECUTABLE_CACHING_MODE_DISABLE_VERIFICATION;
+    executable_params_.executable_format = IREE_SV("embedded-elf-" IREE_ARCH);
+    executable_params_.executable_data = executable_data_;
+
+    key_ = iree_hal_executable_disk_cache_make_key(
+        disk_cache_, executable_params_.executable_format, executable_data_);
+    char* path = NULL;
+    IREE_ASSERT_OK(iree_hal_executable_disk_cache_entry_path(
+        disk_cache_, key_, IREE_SV("elfimg"), iree_allocator_system(), &path));
+    entry_path_ = path;
+    iree_allocator_free(iree_allocator_system(), path);
+  }
+
+  void TearDown() override {
+    iree_hal_executable_loader_release(loader_);
+    iree_hal_executable_disk_cache_release(disk_cache_);
+  }
+
+  // Loads the executable and checks that its dispatch produces the expected
+  // results: ret0 = arg0 * arg1.
+  void LoadExecutable() {
+    iree_hal_executable_t* executable = NULL;
+    IREE_ASSERT_OK(iree_hal_executable_loader_try_load(
+        loader_, &executable_params_, /*worker_capacity=*/1, &executable));
+
+    float arg0[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float arg1[4] = {100.0f, 200.0f, 300.0f, 400.0f};
+    float ret0[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    size_t binding_lengths[3] = {sizeof(arg0), sizeof(arg1), sizeof(ret0)};
+    void* binding_ptrs[3] = {arg0, arg1, ret0};
+    iree_hal_executable_dispatch_state_v0_t dispatch_state;
+    memset(&dispatch_state, 0, sizeof(dispatch_state));
+    dispatch_state.workgroup_size_x = 1;
+    dispatch_state.workgroup_size_y = 1;
+    dispatch_state.workgroup_size_z = 1;
+    dispatch_state.workgroup_count_x = 1;
+    dispatch_state.workgroup_count_y = 1;
+    dispatch_state.workgroup_count_z = 1;
+    dispatch_state.max_concurrency = 1;
+    dispatch_state.binding_count = 1;
+    dispatch_state.binding_lengths = binding_lengths;
+    dispatch_state.binding_ptrs = binding_ptrs;
+    iree_hal_executable_workgroup_state_v0_t workgroup_state;
+    memset(&workgroup_state, 0, sizeof(workgroup_state));
+    IREE_EXPECT_OK(iree_hal_local_executable_issue_call(
+        iree_hal_local_executable_cast(executable), /*ordinal=*/0,
+        &dispatch_state, &workgroup_state, /*worker_id=*/0));
+    EXPECT_EQ(ret0[0], 100.0f);
+    EXPECT_EQ(ret0[1], 400.0f);
+    EXPECT_EQ(ret0[2], 900.0f);
+    EXPECT_EQ(ret0[3], 1600.0f);
+
+    iree_hal_executable_release(executable);
+  }
+
+  // Returns the current contents of the prelinked image entry or an empty
+  // string if there is none.
+  std::string ReadEntry() {
+    iree_file_contents_t* contents = NULL;
+    iree_status_t status = iree_hal_executable_disk_cache_map_entry(
+        disk_cache_, key_, IREE_SV("elfimg"), iree_allocator_system(),
+        &contents);
+    if (!iree_status_is_ok(status)) {
+      iree_status_ignore(status);
+      return std::string();
+    }
+    std::string result(
+        reinterpret_cast<const char*>(contents->const_buffer.data),
+        contents->const_buffer.data_length);
+    iree_file_contents_free(contents);
+    return result;
+  }
+
+  // Overwrites the prelinked image entry with |contents|.
+  void WriteEntry(const std::string& contents) {
+    IREE_ASSERT_OK(iree_file_write_contents(
+        entry_path_.c_str(),
+        iree_make_const_byte_span(contents.data(), contents.size())));
+  }
+
+  iree_const_byte_span_t executable_data_ = iree_const_byte_span_empty();
+  iree_hal_executable_disk_cache_t* disk_cache_ = NULL;
+  iree_hal_executable_loader_t* loader_ = NULL;
+  iree_hal_executable_params_t executable_params_;
+  iree_hal_executable_disk_cache_key_t key_;
+  std::string entry_path_;
+};
+
+TEST_F(EmbeddedElfLoaderDiskCacheTest, ColdThenWarm) {
+  EXPECT_TRUE(ReadEntry().empty());
+  LoadExecutable();
+  std::string image = ReadEntry();
+  ASSERT_FALSE(image.empty());
+
+  // Warm load uses the stored image and leaves it untouched.
+  LoadExecutable();
+  EXPECT_EQ(ReadEntry(), image);
+}
+
+TEST_F(EmbeddedElfLoaderDiskCacheTest, TruncatedEntryFallsBack) {
+  LoadExecutable();
+  std::string image = ReadEntry();
+  ASSERT_FALSE(image.empty());
+
+  // Truncated in the middle of the segment data.
+  WriteEntry(image.substr(0, image.size() / 2));
+  LoadExecutable();
+  EXPECT_EQ(ReadEntry(), image);
+
+  // Truncated within the header.
+  WriteEntry(image.substr(0, 8));
+  LoadExecutable();
+  EXPECT_EQ(ReadEntry(), image);
+
+  // Empty.
+  WriteEntry(std::string());
+  LoadExecutable();
+  EXPECT_EQ(ReadEntry(), image);
+}
+
+TEST_F(EmbeddedElfLoaderDiskCacheTest, CorruptedEntryFallsBack) {
+  LoadExecutable();
+  std::string image = ReadEntry();
+  ASSERT_FALSE(image.size() < 16);
+
+  // Bad magic.
+  std::string corrupted = image;
+  corrupted[0] ^= 0xFF;
+  WriteEntry(corrupted);
+  LoadExecutable();
+  EXPECT_EQ(ReadEntry(), image);
+
+  // Bad version.
+  corrupted = image;
+  corrupted[4] ^= 0xFF;
+  WriteEntry(corrupted);
+  LoadExecutable();
+  EXPECT_EQ(ReadEntry(), image);
+
+  // Garbage of the same size.
+  corrupted.assign(image.size(), '\xCD');
+  WriteEntry(corrupted);
+  LoadExecutable();
+  EXPECT_EQ(ReadEntry(), image);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -6,6 +6,9 @@
 
 #include "iree/hal/local/loaders/registration/init.h"
 
+#include "iree/base/internal/flags.h"
+#include "iree/hal/local/executable_disk_cache.h"
+
 // NOTE: we register in a specific order to allow for prioritization:
 // - system-library: used when embedded is not desired (TSAN/debugging/etc).
 // - embedded-elf: default codegen portable ELF output format.
@@ -23,8 +26,32 @@
 #include "iree/hal/local/loaders/vmvx_module_loader.h"
 #endif  // IREE_HAVE_HAL_EXECUTABLE_LOADER_VMVX_MODULE
 
+IREE_FLAG(
+    string, executable_cache_dir, "",
+    "Directory used to persist loaded local HAL executables across runs.\n"
+    "Embedded ELF executables are stored prelinked so that subsequent loads\n"
+    "skip verification and relocation and system libraries are extracted\n"
+    "once instead of on every load. Tools also record bytecode modules that\n"
+    "passed verification so that they are not verified again. The directory\n"
+    "is created if needed.\n"
+    "\n"
+    "Entries are trusted and executed as-is: only use directories that are\n"
+    "not writable by other users.");
+
+iree_status_t iree_hal_executable_disk_cache_create_from_flags(
+    iree_allocator_t host_allocator,
+    iree_hal_executable_disk_cache_t** out_disk_cache) {
+  IREE_ASSERT_ARGUMENT(out_disk_cache);
+  *out_disk_cache = NULL;
+  iree_string_view_t path = iree_make_cstring_view(FLAG_executable_cache_dir);
+  if (iree_string_view_is_empty(path)) return iree_ok_status();
+  return iree_hal_executable_disk_cache_create(path, host_allocator,
+                                               out_disk_cache);
+}
+
 IREE_API_EXPORT iree_status_t iree_hal_create_all_available_executable_loaders(
     iree_hal_executable_plugin_manager_t* plugin_manager,
+    iree_hal_executable_disk_cache_t* disk_cache,
     iree_host_size_t capacity, iree_host_size_t* out_count,
     iree_hal_executable_loader_t** loaders, iree_allocator_t host_allocator) {
   IREE_ASSERT_ARGUMENT(out_count);
@@ -53,14 +80,14 @@ IREE_API_EXPORT iree_status_t iree_hal_create_all_available_executable_loaders(
 #if defined(IREE_HAVE_HAL_EXECUTABLE_LOADER_SYSTEM_LIBRARY)
   if (iree_status_is_ok(status)) {
     status = iree_hal_system_library_loader_create(
-        plugin_manager, host_allocator, &loaders[count++]);
+        plugin_manager, disk_cache, host_allocator, &loaders[count++]);
   }
 #endif  // IREE_HAVE_HAL_EXECUTABLE_LOADER_SYSTEM_LIBRARY
 
 #if defined(IREE_HAVE_HAL_EXECUTABLE_LOADER_EMBEDDED_ELF)
   if (iree_status_is_ok(status)) {
-    status = iree_hal_embedded_elf_loader_create(plugin_manager, host_allocator,
-                                                 &loaders[count++]);
+    status = iree_hal_embedded_elf_loader_create(
+        plugin_manager, disk_cache, host_allocator, &loaders[count++]);
   }
 #endif  // IREE_HAVE_HAL_EXECUTABLE_LOADER_EMBEDDED_ELF
 
@@ -85,19 +112,20 @@ IREE_API_EXPORT iree_status_t iree_hal_create_all_available_executable_loaders(
 IREE_API_EXPORT iree_status_t iree_hal_create_executable_loader_by_name(
     iree_string_view_t name,
     iree_hal_executable_plugin_manager_t* plugin_manager,
+    iree_hal_executable_disk_cache_t* disk_cache,
     iree_allocator_t host_allocator,
     iree_hal_executable_loader_t** out_executable_loader) {
 #if defined(IREE_HAVE_HAL_EXECUTABLE_LOADER_EMBEDDED_ELF)
   if (iree_string_view_starts_with(name, IREE_SV("embedded-elf"))) {
-    return iree_hal_embedded_elf_loader_create(plugin_manager, host_allocator,
-                                               out_executable_loader);
+    return iree_hal_embedded_elf_loader_create(
+        plugin_manager, disk_cache, host_allocator, out_executable_loader);
   }
 #endif  // IREE_HAVE_HAL_EXECUTABLE_LOADER_EMBEDDED_ELF
 
 #if defined(IREE_HAVE_HAL_EXECUTABLE_LOADER_SYSTEM_LIBRARY)
   if (iree_string_view_starts_with(name, IREE_SV("system-library"))) {
-    return iree_hal_system_library_loader_create(plugin_manager, host_allocator,
-                                                 out_executable_loader);
+    return iree_hal_system_library_loader_create(
+        plugin_manager, disk_cache, host_allocator, out_executable_loader);
   }
 #endif  // IREE_HAVE_HAL_EXECUTABLE_LOADER_SYSTEM_LIBRARY
 
@@ -15,9 +15,19 @@
 extern "C" {
 #endif  // __cplusplus
 
+typedef struct iree_hal_executable_disk_cache_t
+    iree_hal_executable_disk_cache_t;
 typedef struct iree_hal_executable_plugin_manager_t
     iree_hal_executable_plugin_manager_t;
 
+// Creates an executable disk cache in the --executable_cache_dir= directory.
+// |out_disk_cache| is set to NULL if the flag is not specified. The cache can
+// be passed to any loader creation function and must be released by the
+// caller.
+iree_status_t iree_hal_executable_disk_cache_create_from_flags(
+    iree_allocator_t host_allocator,
+    iree_hal_executable_disk_cache_t** out_disk_cache);
+
 // Queries and creates all linked in executable library loaders and retains them
 // in the |out_loaders| list. |out_count| contains the total number of loaders.
 // If there is not enough |capacity| to store all of the loaders
@@ -25,14 +35,16 @@ typedef struct iree_hal_executable_plugin_manager_t
 // capacity. Loaders are retained upon return and must be released by the
 // caller.
 //
-// Default options are used to create the loaders. If customization is required
+// An optional |disk_cache| is used by loaders that support persisting
+// executables across processes. Default options are used to create the
+// loaders. If customization is required
 // then callers should create the loaders themselves.
 //
 // Usage:
 //  iree_host_size_t count = 0;
 //  iree_hal_executable_loader_t* loaders[8] = {NULL};
 //  IREE_RETURN_IF_ERROR(iree_hal_create_all_available_executable_loaders(
-//      plugin_manager,
+//      plugin_manager, disk_cache,
 //      IREE_ARRAYSIZE(loaders), &count, loaders,
 //      host_allocator));
 //  ...
@@ -43,6 +55,7 @@ typedef struct iree_hal_executable_plugin_manager_t
 //  }
 IREE_API_EXPORT iree_status_t iree_hal_create_all_available_executable_loaders(
     iree_hal_executable_plugin_manager_t* plugin_manager,
+    iree_hal_executable_disk_cache_t* disk_cache,
     iree_host_size_t capacity, iree_host_size_t* out_count,
     iree_hal_executable_loader_t** loaders, iree_allocator_t host_allocator);
 
@@ -51,6 +64,7 @@ IREE_API_EXPORT iree_status_t iree_hal_create_all_available_executable_loaders(
 IREE_API_EXPORT iree_status_t iree_hal_create_executable_loader_by_name(
     iree_string_view_t name,
     iree_hal_executable_plugin_manager_t* plugin_manager,
+    iree_hal_executable_disk_cache_t* disk_cache,
     iree_allocator_t host_allocator,
     iree_hal_executable_loader_t** out_executable_loader);
 
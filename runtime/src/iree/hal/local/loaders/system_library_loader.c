@@ -12,6 +12,7 @@
 
 #include "iree/base/internal/dynamic_library.h"
 #include "iree/hal/api.h"
+#include "iree/hal/local/executable_disk_cache.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/executable_library_util.h"
 #include "iree/hal/local/executable_plugin_manager.h"
@@ -93,12 +94,58 @@ typedef struct iree_hal_system_executable_t {
 static const iree_hal_local_executable_vtable_t
     iree_hal_system_executable_vtable;
 
+#if defined(IREE_PLATFORM_WINDOWS)
+#define IREE_HAL_SYSTEM_LIBRARY_EXTENSION "dll"
+#elif defined(IREE_PLATFORM_APPLE)
+#define IREE_HAL_SYSTEM_LIBRARY_EXTENSION "dylib"
+#else
+#define IREE_HAL_SYSTEM_LIBRARY_EXTENSION "so"
+#endif  // IREE_PLATFORM_*
+
+// Loads the |library_data| from a file in |disk_cache|, extracting it first if
+// this is the first time it has been loaded. Unlike loading from memory this
+// avoids writing and deleting a temporary file on every load and allows the
+// system loader to share the mapped pages across processes.
+static iree_status_t iree_hal_system_executable_load_cached(
+    iree_hal_executable_disk_cache_t* disk_cache,
+    iree_string_view_t executable_format, iree_const_byte_span_t library_data,
+    iree_allocator_t host_allocator, iree_dynamic_library_t** out_handle) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  const iree_string_view_t extension =
+      IREE_SV(IREE_HAL_SYSTEM_LIBRARY_EXTENSION);
+  iree_hal_executable_disk_cache_key_t key =
+      iree_hal_executable_disk_cache_make_key(disk_cache, executable_format,
+                                              library_data);
+  char* path = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_executable_disk_cache_entry_path(
+              disk_cache, key, extension, host_allocator, &path));
+  iree_status_t status = iree_file_exists(path);
+  if (iree_status_is_not_found(status)) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "miss");
+    iree_status_ignore(status);
+    status = iree_hal_executable_disk_cache_store_entry(
+        disk_cache, key, extension, library_data);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_dynamic_library_load_from_file(
+        path, IREE_DYNAMIC_LIBRARY_FLAG_NONE, host_allocator, out_handle);
+  }
+  iree_allocator_free(host_allocator, path);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 // Loads the executable and optional debug database from the given
 // |executable_data| in memory. The memory must remain live for the lifetime
-// of the executable.
+// of the executable. If a |disk_cache| is provided the library is loaded from
+// a persistent file within it.
 static iree_status_t iree_hal_system_executable_load(
     iree_hal_system_executable_t* executable,
-    iree_const_byte_span_t executable_data, iree_allocator_t host_allocator) {
+    iree_string_view_t executable_format,
+    iree_const_byte_span_t executable_data,
+    iree_hal_executable_disk_cache_t* disk_cache,
+    iree_allocator_t host_allocator) {
   // Check to see if the library has a footer indicating embedded debug data.
   iree_const_byte_span_t library_data = iree_make_const_byte_span(NULL, 0);
   iree_const_byte_span_t debug_data = iree_make_const_byte_span(NULL, 0);
@@ -123,9 +170,19 @@ static iree_status_t iree_hal_system_executable_load(
     library_data = executable_data;
   }
 
-  IREE_RETURN_IF_ERROR(iree_dynamic_library_load_from_memory(
-      iree_make_cstring_view("aot"), library_data,
-      IREE_DYNAMIC_LIBRARY_FLAG_NONE, host_allocator, &executable->handle));
+  // Failures to use the cache fall back to loading from memory.
+  iree_status_t status = iree_status_from_code(IREE_STATUS_UNAVAILABLE);
+  if (disk_cache) {
+    status = iree_hal_system_executable_load_cached(
+        disk_cache, executable_format, library_data, host_allocator,
+        &executable->handle);
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_status_ignore(status);
+    IREE_RETURN_IF_ERROR(iree_dynamic_library_load_from_memory(
+        iree_make_cstring_view("aot"), library_data,
+        IREE_DYNAMIC_LIBRARY_FLAG_NONE, host_allocator, &executable->handle));
+  }
 
   if (debug_data.data_length > 0) {
     IREE_RETURN_IF_ERROR(iree_dynamic_library_attach_symbols_from_memory(
@@ -211,6 +268,7 @@ static int iree_hal_system_executable_import_thunk_v0(
 static iree_status_t iree_hal_system_executable_create(
     const iree_hal_executable_params_t* executable_params,
     const iree_hal_executable_import_provider_t import_provider,
+    iree_hal_executable_disk_cache_t* disk_cache,
     iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
   IREE_ASSERT_ARGUMENT(executable_params);
   IREE_ASSERT_ARGUMENT(executable_params->executable_data.data &&
@@ -245,7 +303,8 @@ static iree_status_t iree_hal_system_executable_create(
   // Attempt to extract the embedded library and load it.
   if (iree_status_is_ok(status)) {
     status = iree_hal_system_executable_load(
-        executable, executable_params->executable_data, host_allocator);
+        executable, executable_params->executable_format,
+        executable_params->executable_data, disk_cache, host_allocator);
   }
 
   // Query metadata and get the entry point function pointers.
@@ -348,6 +407,7 @@ typedef struct iree_hal_system_library_loader_t {
   iree_hal_executable_loader_t base;
   iree_allocator_t host_allocator;
   iree_hal_executable_plugin_manager_t* plugin_manager;
+  iree_hal_executable_disk_cache_t* disk_cache;  // optional
 } iree_hal_system_library_loader_t;
 
 static const iree_hal_executable_loader_vtable_t
@@ -355,6 +415,7 @@ static const iree_hal_executable_loader_vtable_t
 
 iree_status_t iree_hal_system_library_loader_create(
     iree_hal_executable_plugin_manager_t* plugin_manager,
+    iree_hal_executable_disk_cache_t* disk_cache,
     iree_allocator_t host_allocator,
     iree_hal_executable_loader_t** out_executable_loader) {
   IREE_ASSERT_ARGUMENT(out_executable_loader);
@@ -373,6 +434,8 @@ iree_status_t iree_hal_system_library_loader_create(
     executable_loader->plugin_manager = plugin_manager;
     iree_hal_executable_plugin_manager_retain(
         executable_loader->plugin_manager);
+    executable_loader->disk_cache = disk_cache;
+    iree_hal_executable_disk_cache_retain(executable_loader->disk_cache);
     *out_executable_loader = (iree_hal_executable_loader_t*)executable_loader;
   }
 
@@ -387,6 +450,7 @@ static void iree_hal_system_library_loader_destroy(
   iree_allocator_t host_allocator = executable_loader->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_executable_disk_cache_release(executable_loader->disk_cache);
   iree_hal_executable_plugin_manager_release(executable_loader->plugin_manager);
   iree_allocator_free(host_allocator, executable_loader);
 
@@ -424,7 +488,8 @@ static iree_status_t iree_hal_system_library_loader_try_load(
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_hal_system_executable_create(
               executable_params, base_executable_loader->import_provider,
-              executable_loader->host_allocator, out_executable));
+              executable_loader->disk_cache, executable_loader->host_allocator,
+              out_executable));
 
   IREE_TRACE_ZONE_END(z0);
   return iree_ok_status();
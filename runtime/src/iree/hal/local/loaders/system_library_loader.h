@@ -17,6 +17,8 @@
 extern "C" {
 #endif  // __cplusplus
 
+typedef struct iree_hal_executable_disk_cache_t
+    iree_hal_executable_disk_cache_t;
 typedef struct iree_hal_executable_plugin_manager_t
     iree_hal_executable_plugin_manager_t;
 
@@ -26,8 +28,12 @@ typedef struct iree_hal_executable_plugin_manager_t
 // This uses the legacy "dylib"-style format that will be deleted soon and is
 // only a placeholder until the compiler can be switched to output
 // iree_hal_executable_library_t-compatible files.
+//
+// If an optional |disk_cache| is provided libraries are extracted into it once
+// and loaded directly from there on subsequent loads.
 iree_status_t iree_hal_system_library_loader_create(
     iree_hal_executable_plugin_manager_t* plugin_manager,
+    iree_hal_executable_disk_cache_t* disk_cache,
     iree_allocator_t host_allocator,
     iree_hal_executable_loader_t** out_executable_loader);
 
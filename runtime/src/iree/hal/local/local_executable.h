@@ -37,6 +37,13 @@ typedef struct iree_hal_local_executable_vtable_t {
       const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
       const iree_hal_executable_workgroup_state_v0_t* workgroup_state,
       uint32_t worker_id);
+
+  // Optional; resolves the executable that issues calls for this one.
+  // Executables that are prepared asynchronously wait for preparation to
+  // complete and return the prepared executable or the preparation error.
+  iree_status_t(IREE_API_PTR* resolve)(
+      iree_hal_local_executable_t* executable,
+      iree_hal_local_executable_t** out_executable);
 } iree_hal_local_executable_vtable_t;
 
 // Initializes the local executable base type.
@@ -51,6 +58,14 @@ void iree_hal_local_executable_deinitialize(
 iree_hal_local_executable_t* iree_hal_local_executable_cast(
     iree_hal_executable_t* base_value);
 
+// Resolves |executable| to the local executable that issues its calls, waiting
+// if it is still being prepared. The returned executable is valid for as long
+// as |executable| is retained and must be used in place of it when reading
+// dispatch attributes or issuing calls.
+iree_status_t iree_hal_local_executable_resolve(
+    iree_hal_executable_t* executable,
+    iree_hal_local_executable_t** out_executable);
+
 iree_status_t iree_hal_local_executable_issue_call(
     iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
     const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
@@ -8,12 +8,23 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/hal/local/local_executable.h"
+
+//===----------------------------------------------------------------------===//
+// iree_hal_local_executable_cache_t
+//===----------------------------------------------------------------------===//
 
 typedef struct iree_hal_local_executable_cache_t {
   iree_hal_resource_t resource;
   iree_allocator_t host_allocator;
   iree_string_view_t identifier;
   iree_host_size_t worker_capacity;
+  iree_hal_local_executable_scheduler_t scheduler;
+  bool lazy_preparation;
   iree_host_size_t loader_count;
   iree_hal_executable_loader_t* loaders[];
 } iree_hal_local_executable_cache_t;
@@ -27,11 +38,19 @@ static iree_hal_local_executable_cache_t* iree_hal_local_executable_cache_cast(
   return (iree_hal_local_executable_cache_t*)base_value;
 }
 
-iree_status_t iree_hal_local_executable_cache_create(
-    iree_string_view_t identifier, iree_host_size_t worker_capacity,
+void iree_hal_local_executable_cache_params_initialize(
+    iree_hal_local_executable_cache_params_t* out_params) {
+  memset(out_params, 0, sizeof(*out_params));
+  out_params->worker_capacity = 1;
+}
+
+iree_status_t iree_hal_local_executable_cache_create_with_params(
+    iree_string_view_t identifier,
+    const iree_hal_local_executable_cache_params_t* params,
     iree_host_size_t loader_count, iree_hal_executable_loader_t** loaders,
     iree_allocator_t host_allocator,
     iree_hal_executable_cache_t** out_executable_cache) {
+  IREE_ASSERT_ARGUMENT(params);
   IREE_ASSERT_ARGUMENT(!loader_count || loaders);
   IREE_ASSERT_ARGUMENT(out_executable_cache);
   *out_executable_cache = NULL;
@@ -51,7 +70,9 @@ iree_status_t iree_hal_local_executable_cache_create(
     iree_string_view_append_to_buffer(
         identifier, &executable_cache->identifier,
         (char*)executable_cache + total_size - identifier.size);
-    executable_cache->worker_capacity = worker_capacity;
+    executable_cache->worker_capacity = params->worker_capacity;
+    executable_cache->scheduler = params->scheduler;
+    executable_cache->lazy_preparation = params->lazy_preparation;
 
     executable_cache->loader_count = loader_count;
     for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
@@ -66,6 +87,19 @@ iree_status_t iree_hal_local_executable_cache_create(
   return status;
 }
 
+iree_status_t iree_hal_local_executable_cache_create(
+    iree_string_view_t identifier, iree_host_size_t worker_capacity,
+    iree_host_size_t loader_count, iree_hal_executable_loader_t** loaders,
+    iree_allocator_t host_allocator,
+    iree_hal_executable_cache_t** out_executable_cache) {
+  iree_hal_local_executable_cache_params_t params;
+  iree_hal_local_executable_cache_params_initialize(&params);
+  params.worker_capacity = worker_capacity;
+  return iree_hal_local_executable_cache_create_with_params(
+      identifier, &params, loader_count, loaders, host_allocator,
+      out_executable_cache);
+}
+
 static void iree_hal_local_executable_cache_destroy(
     iree_hal_executable_cache_t* base_executable_cache) {
   iree_hal_local_executable_cache_t* executable_cache =
@@ -96,12 +130,11 @@ static bool iree_hal_local_executable_cache_can_prepare_format(
   return false;
 }
 
-static iree_status_t iree_hal_local_executable_cache_prepare_executable(
-    iree_hal_executable_cache_t* base_executable_cache,
+// Loads |executable_params| with the first loader that supports it.
+static iree_status_t iree_hal_local_executable_cache_load(
+    iree_hal_local_executable_cache_t* executable_cache,
     const iree_hal_executable_params_t* executable_params,
     iree_hal_executable_t** out_executable) {
-  iree_hal_local_executable_cache_t* executable_cache =
-      iree_hal_local_executable_cache_cast(base_executable_cache);
   for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
     if (!iree_hal_executable_loader_query_support(
             executable_cache->loaders[i], executable_params->caching_mode,
@@ -131,6 +164,297 @@ static iree_status_t iree_hal_local_executable_cache_prepare_executable(
       executable_params->executable_format.data);
 }
 
+//===----------------------------------------------------------------------===//
+// iree_hal_local_deferred_executable_t
+//===----------------------------------------------------------------------===//
+
+// Loading state of an iree_hal_local_deferred_executable_t.
+typedef enum iree_hal_local_deferred_executable_state_e {
+  // Loading has not started.
+  IREE_HAL_LOCAL_DEFERRED_EXECUTABLE_STATE_PENDING = 0,
+  // A thread has claimed the executable and is loading it.
+  IREE_HAL_LOCAL_DEFERRED_EXECUTABLE_STATE_LOADING = 1,
+  // Loading has completed and the status/executable are immutable.
+  IREE_HAL_LOCAL_DEFERRED_EXECUTABLE_STATE_READY = 2,
+} iree_hal_local_deferred_executable_state_t;
+
+// An executable that is loaded after it has been prepared, either
+// asynchronously on the cache scheduler or lazily when first resolved.
+// Users resolve it to the loaded executable with
+// iree_hal_local_executable_resolve, which loads it if no other thread has
+// started to and otherwise waits for loading to complete.
+//
+// Exactly one thread claims the load by moving the state from PENDING to
+// LOADING. A scheduled load holds a reference to the executable until it
+// runs; if a resolve claims the load first the scheduled load does nothing.
+typedef struct iree_hal_local_deferred_executable_t {
+  iree_hal_local_executable_t base;
+
+  // Cache used to load the executable; released once loaded.
+  iree_hal_local_executable_cache_t* executable_cache;
+  // Parameters used to load the executable. Any storage that was not aliased
+  // from the caller is owned by |params_storage| and freed once loaded.
+  iree_hal_executable_params_t params;
+  void* params_storage;
+
+  // iree_hal_local_deferred_executable_state_t.
+  iree_atomic_int32_t state;
+  // Posted when |state| becomes READY.
+  iree_notification_t notification;
+  // Loading status; if OK then |executable| is valid.
+  iree_status_t status;
+  // Loaded executable.
+  iree_hal_local_executable_t* executable;
+} iree_hal_local_deferred_executable_t;
+
+static const iree_hal_local_executable_vtable_t
+    iree_hal_local_deferred_executable_vtable;
+
+static iree_hal_local_deferred_executable_t*
+iree_hal_local_deferred_executable_cast(
+    iree_hal_local_executable_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_local_deferred_executable_vtable);
+  return (iree_hal_local_deferred_executable_t*)base_value;
+}
+
+static void iree_hal_local_deferred_executable_load_async(void* user_data);
+
+// Creates a deferred executable that is loaded on the cache scheduler if
+// |schedule| is true and otherwise when first resolved.
+static iree_status_t iree_hal_local_deferred_executable_create(
+    iree_hal_local_executable_cache_t* executable_cache,
+    const iree_hal_executable_params_t* executable_params, bool schedule,
+    iree_hal_executable_t** out_executable) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t host_allocator = executable_cache->host_allocator;
+
+  // Copy everything the caller does not guarantee outlives this call.
+  const bool alias_data = iree_all_bits_set(
+      executable_params->caching_mode,
+      IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA);
+  const iree_host_size_t data_size =
+      alias_data ? 0 : executable_params->executable_data.data_length;
+  const iree_host_size_t constants_size =
+      executable_params->constant_count * sizeof(uint32_t);
+  const iree_host_size_t storage_size =
+      constants_size + data_size + executable_params->executable_format.size;
+
+  iree_hal_local_deferred_executable_t* executable = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*executable),
+                                (void**)&executable));
+  memset(executable, 0, sizeof(*executable));
+  iree_hal_local_executable_initialize(
+      &iree_hal_local_deferred_executable_vtable, host_allocator,
+      &executable->base);
+  executable->executable_cache = executable_cache;
+  iree_hal_executable_cache_retain(
+      (iree_hal_executable_cache_t*)executable_cache);
+  iree_atomic_store(&executable->state,
+                    IREE_HAL_LOCAL_DEFERRED_EXECUTABLE_STATE_PENDING,
+                    iree_memory_order_relaxed);
+  iree_notification_initialize(&executable->notification);
+  executable->status = iree_ok_status();
+
+  iree_status_t status = iree_ok_status();
+  if (storage_size > 0) {
+    status = iree_allocator_malloc(host_allocator, storage_size,
+                                   &executable->params_storage);
+  }
+  if (iree_status_is_ok(status)) {
+    executable->params = *executable_params;
+    uint8_t* storage_ptr = (uint8_t*)executable->params_storage;
+    if (constants_size > 0) {
+      memcpy(storage_ptr, executable_params->constants, constants_size);
+      executable->params.constants = (const uint32_t*)storage_ptr;
+      storage_ptr += constants_size;
+    }
+    if (data_size > 0) {
+      memcpy(storage_ptr, executable_params->executable_data.data, data_size);
+      executable->params.executable_data =
+          iree_make_const_byte_span(storage_ptr, data_size);
+      storage_ptr += data_size;
+    }
+    iree_string_view_append_to_buffer(executable_params->executable_format,
+                                      &executable->params.executable_format,
+                                      (char*)storage_ptr);
+  }
+
+  // The scheduled load holds a reference until it completes.
+  if (iree_status_is_ok(status) && schedule) {
+    iree_hal_executable_retain((iree_hal_executable_t*)executable);
+    status = executable_cache->scheduler.schedule(
+        executable_cache->scheduler.self,
+        iree_hal_local_deferred_executable_load_async, executable);
+    if (!iree_status_is_ok(status)) {
+      iree_hal_executable_release((iree_hal_executable_t*)executable);
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_executable = (iree_hal_executable_t*)executable;
+  } else {
+    iree_hal_executable_release((iree_hal_executable_t*)executable);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_local_deferred_executable_destroy(
+    iree_hal_executable_t* base_executable) {
+  iree_hal_local_deferred_executable_t* executable =
+      iree_hal_local_deferred_executable_cast(
+          (iree_hal_local_executable_t*)base_executable);
+  iree_allocator_t host_allocator = executable->base.host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_ignore(executable->status);
+  iree_hal_executable_release((iree_hal_executable_t*)executable->executable);
+  iree_allocator_free(host_allocator, executable->params_storage);
+  iree_hal_executable_cache_release(
+      (iree_hal_executable_cache_t*)executable->executable_cache);
+  iree_notification_deinitialize(&executable->notification);
+  iree_hal_local_executable_deinitialize(
+      (iree_hal_local_executable_t*)base_executable);
+  iree_allocator_free(host_allocator, executable);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Loads the executable if no other thread has claimed it.
+static void iree_hal_local_deferred_executable_try_load(
+    iree_hal_local_deferred_executable_t* executable) {
+  int32_t expected = IREE_HAL_LOCAL_DEFERRED_EXECUTABLE_STATE_PENDING;
+  if (!iree_atomic_compare_exchange_strong(
+          &executable->state, &expected,
+          IREE_HAL_LOCAL_DEFERRED_EXECUTABLE_STATE_LOADING,
+          iree_memory_order_acq_rel, iree_memory_order_acquire)) {
+    return;  // already loading or loaded
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_executable_t* loaded_executable = NULL;
+  executable->status = iree_hal_local_executable_cache_load(
+      executable->executable_cache, &executable->params, &loaded_executable);
+  executable->executable = (iree_hal_local_executable_t*)loaded_executable;
+
+  // Drop the references needed only for loading.
+  iree_allocator_free(executable->base.host_allocator,
+                      executable->params_storage);
+  executable->params_storage = NULL;
+  iree_hal_executable_cache_release(
+      (iree_hal_executable_cache_t*)executable->executable_cache);
+  executable->executable_cache = NULL;
+
+  iree_atomic_store(&executable->state,
+                    IREE_HAL_LOCAL_DEFERRED_EXECUTABLE_STATE_READY,
+                    iree_memory_order_release);
+  iree_notification_post(&executable->notification, IREE_ALL_WAITERS);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Loads the executable from the cache scheduler.
+static void iree_hal_local_deferred_executable_load_async(void* user_data) {
+  iree_hal_local_deferred_executable_t* executable =
+      (iree_hal_local_deferred_executable_t*)user_data;
+  // If the scheduled load holds the last reference the executable was released
+  // before it was used and can never be resolved so loading is skipped. This
+  // keeps device teardown from waiting on loads no one will use.
+  if (iree_atomic_ref_count_load(&executable->base.resource.ref_count) > 1) {
+    iree_hal_local_deferred_executable_try_load(executable);
+  }
+  iree_hal_executable_release((iree_hal_executable_t*)executable);
+}
+
+static bool iree_hal_local_deferred_executable_is_ready(void* arg) {
+  iree_hal_local_deferred_executable_t* executable =
+      (iree_hal_local_deferred_executable_t*)arg;
+  return iree_atomic_load(&executable->state, iree_memory_order_acquire) ==
+         IREE_HAL_LOCAL_DEFERRED_EXECUTABLE_STATE_READY;
+}
+
+static iree_status_t iree_hal_local_deferred_executable_resolve(
+    iree_hal_local_executable_t* base_executable,
+    iree_hal_local_executable_t** out_executable) {
+  iree_hal_local_deferred_executable_t* executable =
+      iree_hal_local_deferred_executable_cast(base_executable);
+  if (!iree_hal_local_deferred_executable_is_ready(executable)) {
+    // Load on this thread if nothing has started loading yet (lazy or not yet
+    // picked up by the scheduler) and otherwise wait for the loading thread.
+    iree_hal_local_deferred_executable_try_load(executable);
+    IREE_TRACE_ZONE_BEGIN(z0);
+    iree_notification_await(&executable->notification,
+                            iree_hal_local_deferred_executable_is_ready,
+                            executable, iree_infinite_timeout());
+    IREE_TRACE_ZONE_END(z0);
+  }
+  if (!iree_status_is_ok(executable->status)) {
+    return iree_status_clone(executable->status);
+  }
+  *out_executable = executable->executable;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_local_deferred_executable_issue_call(
+    iree_hal_local_executable_t* base_executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_executable_workgroup_state_v0_t* workgroup_state,
+    uint32_t worker_id) {
+  iree_hal_local_executable_t* executable = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_local_deferred_executable_resolve(base_executable, &executable));
+  return iree_hal_local_executable_issue_call(
+      executable, ordinal, dispatch_state, workgroup_state, worker_id);
+}
+
+static const iree_hal_local_executable_vtable_t
+    iree_hal_local_deferred_executable_vtable = {
+        .base =
+            {
+                .destroy = iree_hal_local_deferred_executable_destroy,
+            },
+        .issue_call = iree_hal_local_deferred_executable_issue_call,
+        .resolve = iree_hal_local_deferred_executable_resolve,
+};
+
+//===----------------------------------------------------------------------===//
+// iree_hal_executable_cache_t implementation
+//===----------------------------------------------------------------------===//
+
+static iree_status_t iree_hal_local_executable_cache_prepare_executable(
+    iree_hal_executable_cache_t* base_executable_cache,
+    const iree_hal_executable_params_t* executable_params,
+    iree_hal_executable_t** out_executable) {
+  iree_hal_local_executable_cache_t* executable_cache =
+      iree_hal_local_executable_cache_cast(base_executable_cache);
+  const bool schedule = executable_cache->scheduler.schedule != NULL;
+  // Only executables with aliased data are loaded lazily as otherwise a copy
+  // of the data would be retained for executables that are never used.
+  const bool lazy = executable_cache->lazy_preparation &&
+                    iree_all_bits_set(
+                        executable_params->caching_mode,
+                        IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA);
+  if (!schedule && !lazy) {
+    return iree_hal_local_executable_cache_load(
+        executable_cache, executable_params, out_executable);
+  }
+
+  // Report unsupported formats immediately as callers may try other caches.
+  // Errors in the executable itself are reported when it is resolved.
+  if (!iree_hal_local_executable_cache_can_prepare_format(
+          base_executable_cache, executable_params->caching_mode,
+          executable_params->executable_format)) {
+    return iree_make_status(IREE_STATUS_NOT_FOUND,
+                            "no executable loader registered for the given "
+                            "executable format '%.*s'",
+                            (int)executable_params->executable_format.size,
+                            executable_params->executable_format.data);
+  }
+  return iree_hal_local_deferred_executable_create(
+      executable_cache, executable_params, schedule && !lazy, out_executable);
+}
+
 static const iree_hal_executable_cache_vtable_t
     iree_hal_local_executable_cache_vtable = {
         .destroy = iree_hal_local_executable_cache_destroy,
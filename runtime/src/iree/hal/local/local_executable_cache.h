@@ -23,6 +23,63 @@ extern "C" {
 // one device is the same JIT'ed executable in another, and in multi-tenant
 // situations we're likely to want that isolation _and_ sharing.
 
+// Work function run by an iree_hal_local_executable_scheduler_t.
+typedef void(IREE_API_PTR* iree_hal_local_executable_work_fn_t)(
+    void* user_data);
+
+// Schedules executable preparation work to run asynchronously.
+// Implementations must run each scheduled |fn| exactly once (even if the
+// scheduler is shutting down) and the scheduler must remain valid for the
+// lifetime of the executable cache it is provided to.
+typedef struct iree_hal_local_executable_scheduler_t {
+  // User-defined pointer passed to all functions.
+  void* self;
+  // Schedules |fn| to be called with |user_data| on some thread. Returning a
+  // failure indicates that |fn| was not scheduled and will not be called.
+  iree_status_t(IREE_API_PTR* schedule)(void* self,
+                                        iree_hal_local_executable_work_fn_t fn,
+                                        void* user_data);
+} iree_hal_local_executable_scheduler_t;
+
+// Parameters configuring an iree_hal_local_executable_cache_t.
+// Must be initialized with iree_hal_local_executable_cache_params_initialize
+// prior to use.
+typedef struct iree_hal_local_executable_cache_params_t {
+  // Total number of workers that may concurrently issue calls.
+  iree_host_size_t worker_capacity;
+
+  // Optional scheduler used to prepare executables concurrently. When set
+  // iree_hal_executable_cache_prepare_executable returns immediately after
+  // validating the executable format and loading happens on the scheduler.
+  // Users of the executable wait on loading with
+  // iree_hal_local_executable_resolve and receive any loading errors from it.
+  iree_hal_local_executable_scheduler_t scheduler;
+
+  // Defers loading each executable until it is first resolved with
+  // iree_hal_local_executable_resolve (usually when first recorded in a
+  // command buffer). Executables that are never dispatched are never loaded,
+  // relocated, or initialized. Takes precedence over |scheduler|. Only applies
+  // to executables prepared with
+  // IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA; others are loaded
+  // when prepared (or on |scheduler|) so that no copy of their data is kept.
+  bool lazy_preparation;
+} iree_hal_local_executable_cache_params_t;
+
+// Initializes |out_params| to default values.
+void iree_hal_local_executable_cache_params_initialize(
+    iree_hal_local_executable_cache_params_t* out_params);
+
+// Creates an executable cache that loads executables with the first of
+// |loaders| that supports them.
+iree_status_t iree_hal_local_executable_cache_create_with_params(
+    iree_string_view_t identifier,
+    const iree_hal_local_executable_cache_params_t* params,
+    iree_host_size_t loader_count, iree_hal_executable_loader_t** loaders,
+    iree_allocator_t host_allocator,
+    iree_hal_executable_cache_t** out_executable_cache);
+
+// Creates an executable cache that synchronously loads executables for use by
+// up to |worker_capacity| workers.
 iree_status_t iree_hal_local_executable_cache_create(
     iree_string_view_t identifier, iree_host_size_t worker_capacity,
     iree_host_size_t loader_count, iree_hal_executable_loader_t** loaders,
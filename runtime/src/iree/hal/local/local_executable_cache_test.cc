@@ -0,0 +1,709 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/local_executable_cache.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/flags.h"
+#include "iree/hal/api.h"
+#include "iree/hal/drivers/init.h"
+#include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/loaders/embedded_elf_loader.h"
+#include "iree/hal/local/local_executable.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+// ELF modules for various platforms embedded in the binary:
+#include "iree/hal/local/elf/testdata/elementwise_mul.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+// Returns the ELF testdata for the current architecture or an empty span if
+// none is available.
+static iree_const_byte_span_t QueryArchTestFileData() {
+  iree_string_view_t pattern = iree_string_view_empty();
+#if defined(IREE_ARCH_ARM_32)
+  pattern = IREE_SV("*_arm_32.so");
+#elif defined(IREE_ARCH_ARM_64)
+  pattern = IREE_SV("*_arm_64.so");
+#elif defined(IREE_ARCH_RISCV_32)
+  pattern = IREE_SV("*_riscv_32.so");
+#elif defined(IREE_ARCH_RISCV_64)
+  pattern = IREE_SV("*_riscv_64.so");
+#elif defined(IREE_ARCH_X86_32)
+  pattern = IREE_SV("*_x86_32.so");
+#elif defined(IREE_ARCH_X86_64)
+  pattern = IREE_SV("*_x86_64.so");
+#endif  // IREE_ARCH_*
+  if (iree_string_view_is_empty(pattern)) {
+    return iree_make_const_byte_span(NULL, 0);
+  }
+  for (size_t i = 0; i < elementwise_mul_size(); ++i) {
+    const struct iree_file_toc_t* file_toc = &elementwise_mul_create()[i];
+    if (iree_string_view_match_pattern(iree_make_cstring_view(file_toc->name),
+                                       pattern)) {
+      return iree_make_const_byte_span(file_toc->data, file_toc->size);
+    }
+  }
+  return iree_make_const_byte_span(NULL, 0);
+}
+
+// Scheduler that queues work until the test runs it. Any work still queued
+// when the scheduler is destroyed is run then as schedulers must run all work.
+class ManualScheduler {
+ public:
+  ~ManualScheduler() { RunAll(); }
+
+  iree_hal_local_executable_scheduler_t Get() {
+    iree_hal_local_executable_scheduler_t scheduler;
+    scheduler.self = this;
+    scheduler.schedule = Schedule;
+    return scheduler;
+  }
+
+  size_t pending_count() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return work_.size();
+  }
+
+  void RunAll() {
+    std::vector<std::pair<iree_hal_local_executable_work_fn_t, void*>> work;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      work.swap(work_);
+    }
+    for (auto& item : work) item.first(item.second);
+  }
+
+ private:
+  static iree_status_t Schedule(void* self,
+                                iree_hal_local_executable_work_fn_t fn,
+                                void* user_data) {
+    auto* scheduler = reinterpret_cast<ManualScheduler*>(self);
+    std::lock_guard<std::mutex> lock(scheduler->mutex_);
+    scheduler->work_.push_back({fn, user_data});
+    return iree_ok_status();
+  }
+
+  std::mutex mutex_;
+  std::vector<std::pair<iree_hal_local_executable_work_fn_t, void*>> work_;
+};
+
+// Scheduler that runs each piece of work on its own thread.
+class ThreadScheduler {
+ public:
+  ~ThreadScheduler() { Join(); }
+
+  iree_hal_local_executable_scheduler_t Get() {
+    iree_hal_local_executable_scheduler_t scheduler;
+    scheduler.self = this;
+    scheduler.schedule = Schedule;
+    return scheduler;
+  }
+
+  void Join() {
+    std::vector<std::thread> threads;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      threads.swap(threads_);
+    }
+    for (auto& thread : threads) thread.join();
+  }
+
+ private:
+  static iree_status_t Schedule(void* self,
+                                iree_hal_local_executable_work_fn_t fn,
+                                void* user_data) {
+    auto* scheduler = reinterpret_cast<ThreadScheduler*>(self);
+    std::lock_guard<std::mutex> lock(scheduler->mutex_);
+    scheduler->threads_.emplace_back([fn, user_data]() { fn(user_data); });
+    return iree_ok_status();
+  }
+
+  std::mutex mutex_;
+  std::vector<std::thread> threads_;
+};
+
+static iree_status_t FailingSchedule(void* self,
+                                     iree_hal_local_executable_work_fn_t fn,
+                                     void* user_data) {
+  return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED, "scheduler full");
+}
+
+class LocalExecutableCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    executable_data_ = QueryArchTestFileData();
+    if (!executable_data_.data_length) {
+      GTEST_SKIP() << "no ELF testdata for the current architecture";
+    }
+    IREE_ASSERT_OK(iree_hal_embedded_elf_loader_create(
+        /*plugin_manager=*/NULL, /*disk_cache=*/NULL, iree_allocator_system(),
+        &loader_));
+  }
+
+  void TearDown() override { iree_hal_executable_loader_release(loader_); }
+
+  iree_status_t CreateCache(
+      const iree_hal_local_executable_cache_params_t& params,
+      iree_hal_executable_cache_t** out_executable_cache) {
+    return iree_hal_local_executable_cache_create_with_params(
+        IREE_SV("test"), &params, /*loader_count=*/1, &loader_,
+        iree_allocator_system(), out_executable_cache);
+  }
+
+  iree_hal_executable_params_t MakeParams(iree_const_byte_span_t data) {
+    iree_hal_executable_params_t params;
+    iree_hal_executable_params_initialize(&params);
+    params.caching_mode = IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION |
+                          IREE_HAL_EXECUTABLE_CACHING_MODE_DISABLE_VERIFICATION;
+    params.executable_format = IREE_SV("embedded-elf-" IREE_ARCH);
+    params.executable_data = data;
+    return params;
+  }
+
+  iree_status_t Prepare(iree_hal_executable_cache_t* executable_cache,
+                        iree_const_byte_span_t data,
+                        iree_hal_executable_t** out_executable) {
+    iree_hal_executable_params_t params = MakeParams(data);
+    return iree_hal_executable_cache_prepare_executable(
+        executable_cache, &params, out_executable);
+  }
+
+  // Resolves |executable| and dispatches it, returning the first failure.
+  // Computes ret0 = arg0 * arg1 and checks the results.
+  static iree_status_t Dispatch(iree_hal_executable_t* executable) {
+    iree_hal_local_executable_t* local_executable = NULL;
+    IREE_RETURN_IF_ERROR(
+        iree_hal_local_executable_resolve(executable, &local_executable));
+    float arg0[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float arg1[4] = {100.0f, 200.0f, 300.0f, 400.0f};
+    float ret0[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    size_t binding_lengths[3] = {sizeof(arg0), sizeof(arg1), sizeof(ret0)};
+    void* binding_ptrs[3] = {arg0, arg1, ret0};
+    iree_hal_executable_dispatch_state_v0_t dispatch_state;
+    memset(&dispatch_state, 0, sizeof(dispatch_state));
+    dispatch_state.workgroup_size_x = 1;
+    dispatch_state.workgroup_size_y = 1;
+    dispatch_state.workgroup_size_z = 1;
+    dispatch_state.workgroup_count_x = 1;
+    dispatch_state.workgroup_count_y = 1;
+    dispatch_state.workgroup_count_z = 1;
+    dispatch_state.max_concurrency = 1;
+    dispatch_state.binding_count = 1;
+    dispatch_state.binding_lengths = binding_lengths;
+    dispatch_state.binding_ptrs = binding_ptrs;
+    iree_hal_executable_workgroup_state_v0_t workgroup_state;
+    memset(&workgroup_state, 0, sizeof(workgroup_state));
+    IREE_RETURN_IF_ERROR(iree_hal_local_executable_issue_call(
+        local_executable, /*ordinal=*/0, &dispatch_state, &workgroup_state,
+        /*worker_id=*/0));
+    const float expected[4] = {100.0f, 400.0f, 900.0f, 1600.0f};
+    for (int i = 0; i < 4; ++i) {
+      if (ret0[i] != expected[i]) {
+        return iree_make_status(IREE_STATUS_DATA_LOSS,
+                                "output mismatch: ret[%d] = %.1f, expected "
+                                "%.1f",
+                                i, ret0[i], expected[i]);
+      }
+    }
+    return iree_ok_status();
+  }
+
+  iree_const_byte_span_t executable_data_ = iree_const_byte_span_empty();
+  iree_hal_executable_loader_t* loader_ = NULL;
+};
+
+// Invalid ELF data that is still claimed by the embedded ELF loader.
+static const uint8_t kInvalidExecutableData[64] = {0x7F, 'E', 'L', 'F'};
+
+TEST_F(LocalExecutableCacheTest, SynchronousErrorOnCreate) {
+  iree_hal_local_executable_cache_params_t params;
+  iree_hal_local_executable_cache_params_initialize(&params);
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(CreateCache(params, &executable_cache));
+
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(Prepare(executable_cache, executable_data_, &executable));
+  IREE_EXPECT_OK(Dispatch(executable));
+  iree_hal_executable_release(executable);
+
+  // Without a scheduler errors in the executable fail creation.
+  executable = NULL;
+  iree_status_t status = Prepare(
+      executable_cache,
+      iree_make_const_byte_span(kInvalidExecutableData,
+                                sizeof(kInvalidExecutableData)),
+      &executable);
+  EXPECT_FALSE(iree_status_is_ok(status));
+  iree_status_ignore(status);
+  EXPECT_EQ(executable, nullptr);
+
+  iree_hal_executable_cache_release(executable_cache);
+}
+
+TEST_F(LocalExecutableCacheTest, UnsupportedFormatFailsOnCreate) {
+  ManualScheduler scheduler;
+  iree_hal_local_executable_cache_params_t params;
+  iree_hal_local_executable_cache_params_initialize(&params);
+  params.scheduler = scheduler.Get();
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(CreateCache(params, &executable_cache));
+
+  iree_hal_executable_params_t executable_params = MakeParams(executable_data_);
+  executable_params.executable_format = IREE_SV("unknown-format");
+  iree_hal_executable_t* executable = NULL;
+  EXPECT_THAT(Status(iree_hal_executable_cache_prepare_executable(
+                  executable_cache, &executable_params, &executable)),
+              StatusIs(StatusCode::kNotFound));
+  EXPECT_EQ(executable, nullptr);
+  EXPECT_EQ(scheduler.pending_count(), 0);
+
+  iree_hal_executable_cache_release(executable_cache);
+}
+
+// Errors in the executable are reported each time it is used instead of when
+// it is created.
+TEST_F(LocalExecutableCacheTest, ErrorReportedOnFirstUse) {
+  ManualScheduler scheduler;
+  iree_hal_local_executable_cache_params_t params;
+  iree_hal_local_executable_cache_params_initialize(&params);
+  params.scheduler = scheduler.Get();
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(CreateCache(params, &executable_cache));
+
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(Prepare(executable_cache,
+                         iree_make_const_byte_span(
+                             kInvalidExecutableData,
+                             sizeof(kInvalidExecutableData)),
+                         &executable));
+  EXPECT_EQ(scheduler.pending_count(), 1);
+  scheduler.RunAll();
+
+  iree_status_code_t first_code =
+      iree_status_consume_code(Dispatch(executable));
+  EXPECT_NE(first_code, IREE_STATUS_OK);
+  iree_status_code_t second_code =
+      iree_status_consume_code(Dispatch(executable));
+  EXPECT_EQ(second_code, first_code);
+
+  iree_hal_executable_release(executable);
+  iree_hal_executable_cache_release(executable_cache);
+}
+
+// Resolving before the scheduler runs the load claims it on the resolving
+// thread and the scheduled load does nothing.
+TEST_F(LocalExecutableCacheTest, ResolveBeforeScheduledLoad) {
+  ManualScheduler scheduler;
+  iree_hal_local_executable_cache_params_t params;
+  iree_hal_local_executable_cache_params_initialize(&params);
+  params.scheduler = scheduler.Get();
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(CreateCache(params, &executable_cache));
+
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(Prepare(executable_cache, executable_data_, &executable));
+  EXPECT_EQ(scheduler.pending_count(), 1);
+  IREE_EXPECT_OK(Dispatch(executable));
+  scheduler.RunAll();
+  IREE_EXPECT_OK(Dispatch(executable));
+
+  iree_hal_executable_release(executable);
+  iree_hal_executable_cache_release(executable_cache);
+}
+
+// Executables and their cache may be released while their load is still
+// scheduled. The scheduled load keeps what it needs alive.
+TEST_F(LocalExecutableCacheTest, ReleaseWithLoadPending) {
+  ManualScheduler scheduler;
+  iree_hal_local_executable_cache_params_t params;
+  iree_hal_local_executable_cache_params_initialize(&params);
+  params.scheduler = scheduler.Get();
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(CreateCache(params, &executable_cache));
+
+  for (int i = 0; i < 4; ++i) {
+    iree_hal_executable_t* executable = NULL;
+    IREE_ASSERT_OK(Prepare(executable_cache, executable_data_, &executable));
+    iree_hal_executable_release(executable);
+  }
+  iree_hal_executable_cache_release(executable_cache);
+  EXPECT_EQ(scheduler.pending_count(), 4);
+  scheduler.RunAll();
+}
+
+TEST_F(LocalExecutableCacheTest, ScheduleFailure) {
+  iree_hal_local_executable_cache_params_t params;
+  iree_hal_local_executable_cache_params_initialize(&params);
+  params.scheduler.schedule = FailingSchedule;
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(CreateCache(params, &executable_cache));
+
+  iree_hal_executable_t* executable = NULL;
+  EXPECT_THAT(
+      Status(Prepare(executable_cache, executable_data_, &executable)),
+      StatusIs(StatusCode::kResourceExhausted));
+  EXPECT_EQ(executable, nullptr);
+
+  iree_hal_executable_cache_release(executable_cache);
+}
+
+// Many threads preparing and immediately resolving executables while the
+// scheduler loads them race to claim each load.
+TEST_F(LocalExecutableCacheTest, ConcurrentPrepareAndResolve) {
+  ThreadScheduler scheduler;
+  iree_hal_local_executable_cache_params_t params;
+  iree_hal_local_executable_cache_params_initialize(&params);
+  params.scheduler = scheduler.Get();
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(CreateCache(params, &executable_cache));
+
+  static constexpr int kThreadCount = 4;
+  static constexpr int kExecutablesPerThread = 8;
+  std::vector<iree_status_code_t> status_codes(kThreadCount, IREE_STATUS_OK);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&, i]() {
+      std::vector<iree_hal_executable_t*> executables;
+      iree_status_t status = iree_ok_status();
+      for (int j = 0; j < kExecutablesPerThread && iree_status_is_ok(status);
+           ++j) {
+        iree_hal_executable_t* executable = NULL;
+        status = Prepare(executable_cache, executable_data_, &executable);
+        if (!iree_status_is_ok(status)) break;
+        executables.push_back(executable);
+        // Resolve every other executable immediately to race the scheduler.
+        if (j % 2 == 0) status = Dispatch(executable);
+      }
+      // Resolve the rest from multiple threads as they finish loading.
+      for (auto* executable : executables) {
+        if (iree_status_is_ok(status)) status = Dispatch(executable);
+        iree_hal_executable_release(executable);
+      }
+      status_codes[i] = iree_status_consume_code(status);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int i = 0; i < kThreadCount; ++i) {
+    EXPECT_EQ(status_codes[i], IREE_STATUS_OK);
+  }
+
+  iree_hal_executable_cache_release(executable_cache);
+  scheduler.Join();
+}
+
+// Loader that forwards to another loader and counts the loads it performs.
+// Loads can be blocked so that tests can observe executables while loading.
+struct CountingLoader {
+  iree_hal_executable_loader_t base;
+  iree_hal_executable_loader_t* target;
+  std::mutex mutex;
+  std::condition_variable cond;
+  int load_count = 0;
+  bool blocked = false;
+
+  static iree_hal_executable_loader_t* Create(
+      iree_hal_executable_loader_t* target) {
+    static const iree_hal_executable_loader_vtable_t vtable = {
+        Destroy,
+        QuerySupport,
+        TryLoad,
+    };
+    auto* loader = new CountingLoader();
+    iree_hal_executable_loader_initialize(
+        &vtable, iree_hal_executable_import_provider_null(), &loader->base);
+    loader->target = target;
+    iree_hal_executable_loader_retain(target);
+    return &loader->base;
+  }
+
+  static CountingLoader* Cast(iree_hal_executable_loader_t* base_loader) {
+    return reinterpret_cast<CountingLoader*>(base_loader);
+  }
+
+  int WaitForLoadCount(int count) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [&]() { return load_count >= count; });
+    return load_count;
+  }
+
+  void SetBlocked(bool value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    blocked = value;
+    cond.notify_all();
+  }
+
+ private:
+  static void Destroy(iree_hal_executable_loader_t* base_loader) {
+    CountingLoader* loader = Cast(base_loader);
+    iree_hal_executable_loader_release(loader->target);
+    delete loader;
+  }
+
+  static bool QuerySupport(iree_hal_executable_loader_t* base_loader,
+                           iree_hal_executable_caching_mode_t caching_mode,
+                           iree_string_view_t executable_format) {
+    return iree_hal_executable_loader_query_support(
+        Cast(base_loader)->target, caching_mode, executable_format);
+  }
+
+  static iree_status_t TryLoad(
+      iree_hal_executable_loader_t* base_loader,
+      const iree_hal_executable_params_t* executable_params,
+      iree_host_size_t worker_capacity,
+      iree_hal_executable_t** out_executable) {
+    CountingLoader* loader = Cast(base_loader);
+    {
+      std::unique_lock<std::mutex> lock(loader->mutex);
+      ++loader->load_count;
+      loader->cond.notify_all();
+      loader->cond.wait(lock, [&]() { return !loader->blocked; });
+    }
+    return iree_hal_executable_loader_try_load(
+        loader->target, executable_params, worker_capacity, out_executable);
+  }
+};
+
+class LocalExecutableCacheLazyTest : public LocalExecutableCacheTest {
+ protected:
+  void SetUp() override {
+    LocalExecutableCacheTest::SetUp();
+    if (IsSkipped()) return;
+    counting_loader_ = CountingLoader::Create(loader_);
+  }
+
+  void TearDown() override {
+    if (counting_loader_) iree_hal_executable_loader_release(counting_loader_);
+    LocalExecutableCacheTest::TearDown();
+  }
+
+  CountingLoader* counting_loader() {
+    return CountingLoader::Cast(counting_loader_);
+  }
+
+  iree_status_t CreateLazyCache(
+      iree_hal_local_executable_scheduler_t scheduler,
+      iree_hal_executable_cache_t** out_executable_cache) {
+    iree_hal_local_executable_cache_params_t params;
+    iree_hal_local_executable_cache_params_initialize(&params);
+    params.scheduler = scheduler;
+    params.lazy_preparation = true;
+    return iree_hal_local_executable_cache_create_with_params(
+        IREE_SV("test"), &params, /*loader_count=*/1, &counting_loader_,
+        iree_allocator_system(), out_executable_cache);
+  }
+
+  // Prepares |executable_data_| either aliased or copied by the cache.
+  iree_status_t PrepareLazy(iree_hal_executable_cache_t* executable_cache,
+                            bool alias_data,
+                            iree_hal_executable_t** out_executable) {
+    iree_hal_executable_params_t params = MakeParams(executable_data_);
+    if (alias_data) {
+      params.caching_mode |=
+          IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA;
+    }
+    return iree_hal_executable_cache_prepare_executable(
+        executable_cache, &params, out_executable);
+  }
+
+  iree_hal_executable_loader_t* counting_loader_ = NULL;
+};
+
+// Executables with aliased data are not loaded until first used and are only
+// loaded once.
+TEST_F(LocalExecutableCacheLazyTest, LoadsOnFirstUse) {
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(CreateLazyCache({}, &executable_cache));
+
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(
+      PrepareLazy(executable_cache, /*alias_data=*/true, &executable));
+  EXPECT_EQ(counting_loader()->load_count, 0);
+  IREE_EXPECT_OK(Dispatch(executable));
+  EXPECT_EQ(counting_loader()->load_count, 1);
+  IREE_EXPECT_OK(Dispatch(executable));
+  EXPECT_EQ(counting_loader()->load_count, 1);
+
+  iree_hal_executable_release(executable);
+  iree_hal_executable_cache_release(executable_cache);
+}
+
+// Executables whose data would have to be copied are loaded when prepared (or
+// scheduled when there is a scheduler) instead of retaining the copy.
+TEST_F(LocalExecutableCacheLazyTest, CopiedDataIsNotDeferred) {
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(CreateLazyCache({}, &executable_cache));
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(
+      PrepareLazy(executable_cache, /*alias_data=*/false, &executable));
+  EXPECT_EQ(counting_loader()->load_count, 1);
+  IREE_EXPECT_OK(Dispatch(executable));
+  iree_hal_executable_release(executable);
+  iree_hal_executable_cache_release(executable_cache);
+
+  ManualScheduler scheduler;
+  IREE_ASSERT_OK(CreateLazyCache(scheduler.Get(), &executable_cache));
+  IREE_ASSERT_OK(
+      PrepareLazy(executable_cache, /*alias_data=*/false, &executable));
+  EXPECT_EQ(scheduler.pending_count(), 1);
+  scheduler.RunAll();
+  EXPECT_EQ(counting_loader()->load_count, 2);
+  IREE_EXPECT_OK(Dispatch(executable));
+  iree_hal_executable_release(executable);
+  iree_hal_executable_cache_release(executable_cache);
+}
+
+// Lazy preparation takes precedence over the scheduler for aliased data.
+TEST_F(LocalExecutableCacheLazyTest, TakesPrecedenceOverScheduler) {
+  ManualScheduler scheduler;
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(CreateLazyCache(scheduler.Get(), &executable_cache));
+
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(
+      PrepareLazy(executable_cache, /*alias_data=*/true, &executable));
+  EXPECT_EQ(scheduler.pending_count(), 0);
+  EXPECT_EQ(counting_loader()->load_count, 0);
+  IREE_EXPECT_OK(Dispatch(executable));
+  EXPECT_EQ(counting_loader()->load_count, 1);
+
+  iree_hal_executable_release(executable);
+  iree_hal_executable_cache_release(executable_cache);
+}
+
+// Many threads using a lazy executable for the first time at once: exactly one
+// moves it from PENDING to LOADING and loads it while the others wait for it
+// to become READY and then share the loaded executable.
+TEST_F(LocalExecutableCacheLazyTest, ConcurrentFirstUse) {
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(CreateLazyCache({}, &executable_cache));
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(
+      PrepareLazy(executable_cache, /*alias_data=*/true, &executable));
+
+  // Hold the first load until every thread has started resolving.
+  counting_loader()->SetBlocked(true);
+  static constexpr int kThreadCount = 8;
+  std::vector<iree_status_code_t> status_codes(kThreadCount, IREE_STATUS_OK);
+  std::vector<iree_hal_local_executable_t*> resolved(kThreadCount, nullptr);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&, i]() {
+      status_codes[i] = iree_status_consume_code(
+          iree_hal_local_executable_resolve(executable, &resolved[i]));
+    });
+  }
+  EXPECT_EQ(counting_loader()->WaitForLoadCount(1), 1);
+  counting_loader()->SetBlocked(false);
+  for (auto& thread : threads) thread.join();
+
+  EXPECT_EQ(counting_loader()->load_count, 1);
+  for (int i = 0; i < kThreadCount; ++i) {
+    EXPECT_EQ(status_codes[i], IREE_STATUS_OK);
+    EXPECT_NE(resolved[i], nullptr);
+    EXPECT_EQ(resolved[i], resolved[0]);
+  }
+  IREE_EXPECT_OK(Dispatch(executable));
+
+  iree_hal_executable_release(executable);
+  iree_hal_executable_cache_release(executable_cache);
+}
+
+#if IREE_FLAGS_ENABLE_CLI == 1
+
+// Sets a flag by parsing |flag| as if it were passed on the command line.
+static iree_status_t ParseFlag(const char* flag) {
+  // Parsing modifies the arguments in place.
+  std::string program = "test";
+  std::string arg = flag;
+  char* argv_storage[] = {&program[0], &arg[0]};
+  char** argv = argv_storage;
+  int argc = IREE_ARRAYSIZE(argv_storage);
+  return iree_flags_parse(IREE_FLAGS_PARSE_MODE_DEFAULT, &argc, &argv);
+}
+
+// Expects preparing an invalid executable on the default device of
+// |driver_name| to succeed and defer the error to first use iff
+// |expect_deferred|.
+static void ExpectPreparationDeferred(iree_string_view_t driver_name,
+                                      bool expect_deferred) {
+  iree_hal_driver_registry_t* registry = NULL;
+  IREE_ASSERT_OK(
+      iree_hal_driver_registry_allocate(iree_allocator_system(), &registry));
+  IREE_ASSERT_OK(iree_hal_register_all_available_drivers(registry));
+  iree_hal_driver_t* driver = NULL;
+  IREE_ASSERT_OK(iree_hal_driver_registry_try_create(
+      registry, driver_name, iree_allocator_system(), &driver));
+  iree_hal_device_t* device = NULL;
+  IREE_ASSERT_OK(iree_hal_driver_create_default_device(
+      driver, iree_allocator_system(), &device));
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_cache_create(
+      device, IREE_SV("test"), iree_loop_inline(NULL), &executable_cache));
+
+  iree_hal_executable_params_t params;
+  iree_hal_executable_params_initialize(&params);
+  params.caching_mode = IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA |
+                        IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION;
+  params.executable_format = IREE_SV("embedded-elf-" IREE_ARCH);
+  params.executable_data = iree_make_const_byte_span(
+      kInvalidExecutableData, sizeof(kInvalidExecutableData));
+  iree_hal_executable_t* executable = NULL;
+  iree_status_t status = iree_hal_executable_cache_prepare_executable(
+      executable_cache, &params, &executable);
+  EXPECT_EQ(iree_status_is_ok(status), expect_deferred);
+  iree_status_ignore(status);
+  if (executable) {
+    iree_hal_local_executable_t* local_executable = NULL;
+    EXPECT_NE(iree_status_consume_code(
+                  iree_hal_local_executable_resolve(executable,
+                                                    &local_executable)),
+              IREE_STATUS_OK);
+    iree_hal_executable_release(executable);
+  }
+
+  iree_hal_executable_cache_release(executable_cache);
+  iree_hal_device_release(device);
+  iree_hal_driver_release(driver);
+  iree_hal_driver_registry_free(registry);
+}
+
+#if defined(IREE_HAVE_HAL_LOCAL_TASK_DRIVER_MODULE)
+TEST_F(LocalExecutableCacheTest, TaskLazyExecutablePreparationFlag) {
+  ExpectPreparationDeferred(IREE_SV("local-task"), /*expect_deferred=*/false);
+  IREE_ASSERT_OK(ParseFlag("--task_lazy_executable_preparation=true"));
+  ExpectPreparationDeferred(IREE_SV("local-task"), /*expect_deferred=*/true);
+  IREE_ASSERT_OK(ParseFlag("--task_lazy_executable_preparation=false"));
+}
+#endif  // IREE_HAVE_HAL_LOCAL_TASK_DRIVER_MODULE
+
+#if defined(IREE_HAVE_HAL_LOCAL_SYNC_DRIVER_MODULE)
+TEST_F(LocalExecutableCacheTest, SyncLazyExecutablePreparationFlag) {
+  ExpectPreparationDeferred(IREE_SV("local-sync"), /*expect_deferred=*/false);
+  IREE_ASSERT_OK(ParseFlag("--sync_lazy_executable_preparation=true"));
+  ExpectPreparationDeferred(IREE_SV("local-sync"), /*expect_deferred=*/true);
+  IREE_ASSERT_OK(ParseFlag("--sync_lazy_executable_preparation=false"));
+}
+#endif  // IREE_HAVE_HAL_LOCAL_SYNC_DRIVER_MODULE
+
+#endif  // IREE_FLAGS_ENABLE_CLI == 1
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -0,0 +1,820 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// NOTE: must be first before _any_ system includes.
+#define _GNU_SOURCE
+
+#include "iree/hal/utils/async_file_reader.h"
+
+#include "iree/base/internal/call_once.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
+
+// Whether io_uring support is compiled in. It's always used opportunistically:
+// if setup fails at runtime (old kernels, seccomp filters, etc) the reader falls
+// back to the thread pool.
+#if !defined(IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING)
+#if defined(IREE_PLATFORM_LINUX) && !defined(IREE_PLATFORM_ANDROID) && \
+    defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING 1
+#endif  // __has_include(<linux/io_uring.h>)
+#endif  // IREE_PLATFORM_LINUX
+#endif  // !IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+#if !defined(IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING)
+#define IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING 0
+#endif  // !IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+
+#if IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Reads are handed to the completion thread through the kernel and thread
+// sanitizer can't observe the ordering that establishes.
+#if defined(IREE_SANITIZER_THREAD)
+#include <sanitizer/tsan_interface.h>
+#define IREE_HAL_ASYNC_FILE_READER_TSAN_RELEASE(addr) __tsan_release(addr)
+#define IREE_HAL_ASYNC_FILE_READER_TSAN_ACQUIRE(addr) __tsan_acquire(addr)
+#else
+#define IREE_HAL_ASYNC_FILE_READER_TSAN_RELEASE(addr) ((void)(addr))
+#define IREE_HAL_ASYNC_FILE_READER_TSAN_ACQUIRE(addr) ((void)(addr))
+#endif  // IREE_SANITIZER_THREAD
+#endif  // IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+
+IREE_API_EXPORT void iree_hal_async_file_reader_options_initialize(
+    iree_hal_async_file_reader_options_t* out_options) {
+  IREE_ASSERT_ARGUMENT(out_options);
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->flags = IREE_HAL_ASYNC_FILE_READER_FLAG_NONE;
+  out_options->queue_depth = IREE_HAL_ASYNC_FILE_READER_DEFAULT_QUEUE_DEPTH;
+  out_options->thread_count = IREE_HAL_ASYNC_FILE_READER_DEFAULT_THREAD_COUNT;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_async_file_read_t
+//===----------------------------------------------------------------------===//
+
+// A single read request tracked from submission through completion.
+// Allocated with the signal semaphore list storage trailing the struct.
+typedef struct iree_hal_async_file_read_t {
+  // Intrusive pointer used by the thread pool pending queue.
+  struct iree_hal_async_file_read_t* next;
+  // Retained file handle being read from.
+  iree_io_file_handle_t* handle;
+  // Offset into the file of the start of the read.
+  uint64_t file_offset;
+  // Retained target buffer and the scoped mapping of the target range.
+  iree_hal_buffer_t* buffer;
+  iree_hal_buffer_mapping_t mapping;
+  // Total bytes read so far; reads may complete partially and be resubmitted.
+  iree_host_size_t completed_length;
+  // True if the read was cancelled because a signal semaphore had already
+  // failed. The semaphores are left with their original failure status.
+  bool cancelled;
+#if IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+  // Scatter list for the current io_uring readv operation.
+  struct iovec iov;
+#endif  // IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+  // Retained semaphores signaled when the read completes.
+  iree_hal_semaphore_list_t signal_semaphore_list;
+} iree_hal_async_file_read_t;
+
+//===----------------------------------------------------------------------===//
+// iree_hal_async_file_reader_t
+//===----------------------------------------------------------------------===//
+
+struct iree_hal_async_file_reader_t {
+  iree_allocator_t host_allocator;
+
+  // Guards submission state (pending queue, ring submission queue, etc).
+  iree_slim_mutex_t mutex;
+  // Posted whenever a read completes or new work is available.
+  iree_notification_t notification;
+  // Total number of reads that have been submitted and not yet completed.
+  iree_atomic_int32_t in_flight_count;
+  // Maximum value of in_flight_count before submissions block.
+  int32_t max_in_flight_count;
+  // Set when the reader is being destroyed and threads should exit.
+  iree_atomic_int32_t shutdown;
+
+  // FIFO of reads pending in the thread pool. Guarded by mutex.
+  iree_hal_async_file_read_t* pending_head;
+  iree_hal_async_file_read_t* pending_tail;
+
+#if IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+  // io_uring instance file descriptor or -1 if not in use.
+  int ring_fd;
+  // Mapped ring memory.
+  void* sq_ring_ptr;
+  iree_host_size_t sq_ring_size;
+  void* cq_ring_ptr;
+  iree_host_size_t cq_ring_size;
+  struct io_uring_sqe* sqes;
+  iree_host_size_t sqes_size;
+  // Pointers into the mapped submission queue ring.
+  uint32_t* sq_head;
+  uint32_t* sq_tail;
+  uint32_t sq_mask;
+  uint32_t* sq_array;
+  // Pointers into the mapped completion queue ring.
+  uint32_t* cq_head;
+  uint32_t* cq_tail;
+  uint32_t cq_mask;
+  struct io_uring_cqe* cqes;
+#endif  // IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+
+  // Threads servicing the reader: a single completion thread when using
+  // io_uring or thread_count pool threads otherwise.
+  iree_host_size_t thread_count;
+  iree_thread_t* threads[];
+};
+
+// Returns true if |read| should be cancelled because one of its signal
+// semaphores has already failed. Nothing waiting on the semaphores can observe
+// the read contents in that case and the I/O would be wasted.
+static bool iree_hal_async_file_read_should_cancel(
+    iree_hal_async_file_read_t* read) {
+  for (iree_host_size_t i = 0; i < read->signal_semaphore_list.count; ++i) {
+    uint64_t value = 0;
+    iree_status_t status =
+        iree_hal_semaphore_query(read->signal_semaphore_list.semaphores[i],
+                                 &value);
+    const bool failed = !iree_status_is_ok(status) ||
+                        value >= IREE_HAL_SEMAPHORE_FAILURE_VALUE;
+    iree_status_ignore(status);
+    if (failed) return true;
+  }
+  return false;
+}
+
+// Completes |read| with |status|, signaling or failing its semaphores and
+// releasing all resources. Cancelled reads leave their semaphores untouched.
+// Thread-safe.
+static void iree_hal_async_file_reader_complete(
+    iree_hal_async_file_reader_t* reader, iree_hal_async_file_read_t* read,
+    iree_status_t status) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (int64_t)read->completed_length);
+
+  // Make the contents visible to the device and end the scoped mapping.
+  if (iree_status_is_ok(status) && !read->cancelled &&
+      !iree_all_bits_set(iree_hal_buffer_memory_type(read->buffer),
+                         IREE_HAL_MEMORY_TYPE_HOST_COHERENT)) {
+    status =
+        iree_hal_buffer_mapping_flush_range(&read->mapping, 0, IREE_WHOLE_BUFFER);
+  }
+  status = iree_status_join(status, iree_hal_buffer_unmap_range(&read->mapping));
+
+  if (read->cancelled) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "cancelled");
+    iree_status_ignore(status);
+  } else if (iree_status_is_ok(status)) {
+    status = iree_hal_semaphore_list_signal(read->signal_semaphore_list);
+    if (!iree_status_is_ok(status)) {
+      iree_hal_semaphore_list_fail(read->signal_semaphore_list, status);
+    }
+  } else {
+    iree_hal_semaphore_list_fail(read->signal_semaphore_list, status);
+  }
+
+  for (iree_host_size_t i = 0; i < read->signal_semaphore_list.count; ++i) {
+    iree_hal_semaphore_release(read->signal_semaphore_list.semaphores[i]);
+  }
+  iree_hal_buffer_release(read->buffer);
+  iree_io_file_handle_release(read->handle);
+  iree_allocator_free(reader->host_allocator, read);
+
+  // Wake any submitters blocked on the queue depth and the destroyer waiting
+  // for all reads to drain.
+  iree_atomic_fetch_sub(&reader->in_flight_count, 1, iree_memory_order_acq_rel);
+  iree_notification_post(&reader->notification, IREE_ALL_WAITERS);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Synchronously services |read| on the calling thread.
+static iree_status_t iree_hal_async_file_reader_read_sync(
+    iree_hal_async_file_read_t* read) {
+  if (iree_hal_async_file_read_should_cancel(read)) {
+    read->cancelled = true;
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (int64_t)read->mapping.contents.data_length);
+  iree_status_t status = iree_io_file_handle_read(
+      read->handle, read->file_offset, read->mapping.contents.data,
+      read->mapping.contents.data_length);
+  if (iree_status_is_ok(status)) {
+    read->completed_length = read->mapping.contents.data_length;
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// Thread pool backend
+//===----------------------------------------------------------------------===//
+
+static bool iree_hal_async_file_reader_has_pool_work(
+    iree_hal_async_file_reader_t* reader) {
+  iree_slim_mutex_lock(&reader->mutex);
+  bool has_work = reader->pending_head != NULL;
+  iree_slim_mutex_unlock(&reader->mutex);
+  return has_work ||
+         iree_atomic_load(&reader->shutdown, iree_memory_order_acquire);
+}
+
+static int iree_hal_async_file_reader_pool_main(void* entry_arg) {
+  iree_hal_async_file_reader_t* reader =
+      (iree_hal_async_file_reader_t*)entry_arg;
+  for (;;) {
+    iree_notification_await(
+        &reader->notification,
+        (iree_condition_fn_t)iree_hal_async_file_reader_has_pool_work, reader,
+        iree_infinite_timeout());
+
+    // Pop the next pending read, if any. Pending reads are always drained
+    // before exiting so that no work is dropped.
+    iree_slim_mutex_lock(&reader->mutex);
+    iree_hal_async_file_read_t* read = reader->pending_head;
+    if (read) {
+      reader->pending_head = read->next;
+      if (!reader->pending_head) reader->pending_tail = NULL;
+      read->next = NULL;
+    }
+    iree_slim_mutex_unlock(&reader->mutex);
+    if (!read) {
+      if (iree_atomic_load(&reader->shutdown, iree_memory_order_acquire)) {
+        break;
+      }
+      continue;
+    }
+
+    iree_status_t status = iree_hal_async_file_reader_read_sync(read);
+    iree_hal_async_file_reader_complete(reader, read, status);
+  }
+  return 0;
+}
+
+static void iree_hal_async_file_reader_pool_enqueue(
+    iree_hal_async_file_reader_t* reader, iree_hal_async_file_read_t* read) {
+  iree_slim_mutex_lock(&reader->mutex);
+  if (reader->pending_tail) {
+    reader->pending_tail->next = read;
+  } else {
+    reader->pending_head = read;
+  }
+  reader->pending_tail = read;
+  iree_slim_mutex_unlock(&reader->mutex);
+  iree_notification_post(&reader->notification, IREE_ALL_WAITERS);
+}
+
+//===----------------------------------------------------------------------===//
+// io_uring backend
+//===----------------------------------------------------------------------===//
+
+#if IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+
+// Sentinel user_data used to wake the completion thread during shutdown.
+#define IREE_HAL_ASYNC_FILE_READER_SHUTDOWN_USER_DATA 0ull
+
+static int iree_io_uring_setup(unsigned entries, struct io_uring_params* p) {
+  return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int iree_io_uring_enter(int ring_fd, unsigned to_submit,
+                               unsigned min_complete, unsigned flags) {
+  return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+                      flags, NULL, 0);
+}
+
+static void iree_hal_async_file_reader_ring_deinitialize(
+    iree_hal_async_file_reader_t* reader) {
+  if (reader->sqes) munmap(reader->sqes, reader->sqes_size);
+  if (reader->cq_ring_ptr && reader->cq_ring_ptr != reader->sq_ring_ptr) {
+    munmap(reader->cq_ring_ptr, reader->cq_ring_size);
+  }
+  if (reader->sq_ring_ptr) munmap(reader->sq_ring_ptr, reader->sq_ring_size);
+  if (reader->ring_fd != -1) close(reader->ring_fd);
+  reader->ring_fd = -1;
+  reader->sqes = NULL;
+  reader->sq_ring_ptr = NULL;
+  reader->cq_ring_ptr = NULL;
+}
+
+// Tries to create an io_uring instance. Returns false if io_uring is not
+// usable in which case the caller should fall back to the thread pool.
+static bool iree_hal_async_file_reader_ring_initialize(
+    iree_hal_async_file_reader_t* reader, iree_host_size_t queue_depth) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  reader->ring_fd = iree_io_uring_setup((unsigned)queue_depth, &params);
+  if (reader->ring_fd < 0) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "io_uring_setup failed");
+    reader->ring_fd = -1;
+    IREE_TRACE_ZONE_END(z0);
+    return false;
+  }
+
+  reader->sq_ring_size =
+      params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  reader->cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  const bool single_mmap = iree_all_bits_set(params.features,
+                                             IORING_FEAT_SINGLE_MMAP);
+  if (single_mmap) {
+    reader->sq_ring_size = reader->cq_ring_size =
+        iree_max(reader->sq_ring_size, reader->cq_ring_size);
+  }
+  reader->sq_ring_ptr =
+      mmap(NULL, reader->sq_ring_size, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, reader->ring_fd, IORING_OFF_SQ_RING);
+  if (reader->sq_ring_ptr == MAP_FAILED) {
+    reader->sq_ring_ptr = NULL;
+    iree_hal_async_file_reader_ring_deinitialize(reader);
+    IREE_TRACE_ZONE_END(z0);
+    return false;
+  }
+  if (single_mmap) {
+    reader->cq_ring_ptr = reader->sq_ring_ptr;
+  } else {
+    reader->cq_ring_ptr =
+        mmap(NULL, reader->cq_ring_size, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, reader->ring_fd, IORING_OFF_CQ_RING);
+    if (reader->cq_ring_ptr == MAP_FAILED) {
+      reader->cq_ring_ptr = NULL;
+      iree_hal_async_file_reader_ring_deinitialize(reader);
+      IREE_TRACE_ZONE_END(z0);
+      return false;
+    }
+  }
+  reader->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  reader->sqes =
+      (struct io_uring_sqe*)mmap(NULL, reader->sqes_size, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, reader->ring_fd,
+                                 IORING_OFF_SQES);
+  if (reader->sqes == MAP_FAILED) {
+    reader->sqes = NULL;
+    iree_hal_async_file_reader_ring_deinitialize(reader);
+    IREE_TRACE_ZONE_END(z0);
+    return false;
+  }
+
+  uint8_t* sq_ptr = (uint8_t*)reader->sq_ring_ptr;
+  reader->sq_head = (uint32_t*)(sq_ptr + params.sq_off.head);
+  reader->sq_tail = (uint32_t*)(sq_ptr + params.sq_off.tail);
+  reader->sq_mask = *(uint32_t*)(sq_ptr + params.sq_off.ring_mask);
+  reader->sq_array = (uint32_t*)(sq_ptr + params.sq_off.array);
+  uint8_t* cq_ptr = (uint8_t*)reader->cq_ring_ptr;
+  reader->cq_head = (uint32_t*)(cq_ptr + params.cq_off.head);
+  reader->cq_tail = (uint32_t*)(cq_ptr + params.cq_off.tail);
+  reader->cq_mask = *(uint32_t*)(cq_ptr + params.cq_off.ring_mask);
+  reader->cqes = (struct io_uring_cqe*)(cq_ptr + params.cq_off.cqes);
+
+  // Each in-flight read has at most one SQE outstanding and we reserve one
+  // slot for the shutdown wake.
+  reader->max_in_flight_count =
+      (int32_t)iree_min(queue_depth, (iree_host_size_t)params.sq_entries - 1);
+
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, params.sq_entries);
+  IREE_TRACE_ZONE_END(z0);
+  return true;
+}
+
+// Pushes an SQE to the ring and submits it to the kernel.
+// The caller must ensure there is space in the submission queue.
+static iree_status_t iree_hal_async_file_reader_ring_push(
+    iree_hal_async_file_reader_t* reader, uint8_t opcode, int fd,
+    const struct iovec* iov, uint64_t offset, uint64_t user_data) {
+  iree_slim_mutex_lock(&reader->mutex);
+
+  const uint32_t tail = *reader->sq_tail;
+  const uint32_t index = tail & reader->sq_mask;
+  struct io_uring_sqe* sqe = &reader->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->addr = (uint64_t)(uintptr_t)iov;
+  sqe->len = iov ? 1 : 0;
+  sqe->off = offset;
+  sqe->user_data = user_data;
+  reader->sq_array[index] = index;
+  IREE_HAL_ASYNC_FILE_READER_TSAN_RELEASE((void*)(uintptr_t)user_data);
+  __atomic_store_n(reader->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  int ret = 0;
+  do {
+    ret = iree_io_uring_enter(reader->ring_fd, 1, 0, 0);
+  } while (ret < 0 && errno == EINTR);
+  iree_status_t status = iree_ok_status();
+  if (ret < 0) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "io_uring_enter submission failed");
+  }
+
+  iree_slim_mutex_unlock(&reader->mutex);
+  return status;
+}
+
+// Submits the remaining portion of |read| to the ring.
+static iree_status_t iree_hal_async_file_reader_ring_submit_read(
+    iree_hal_async_file_reader_t* reader, iree_hal_async_file_read_t* read) {
+  read->iov.iov_base = read->mapping.contents.data + read->completed_length;
+  read->iov.iov_len = read->mapping.contents.data_length - read->completed_length;
+  return iree_hal_async_file_reader_ring_push(
+      reader, IORING_OP_READV,
+      iree_io_file_handle_primitive(read->handle).value.fd, &read->iov,
+      read->file_offset + read->completed_length, (uint64_t)(uintptr_t)read);
+}
+
+// Handles a completion queue entry for |read| with result |res|.
+static void iree_hal_async_file_reader_ring_process_completion(
+    iree_hal_async_file_reader_t* reader, iree_hal_async_file_read_t* read,
+    int32_t res) {
+  iree_status_t status = iree_ok_status();
+  if (res < 0) {
+    status = iree_make_status(iree_status_code_from_errno(-res),
+                              "async file read failed at offset %" PRIu64,
+                              read->file_offset + read->completed_length);
+  } else if (res == 0) {
+    status = iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                              "async file read hit end of file at offset "
+                              "%" PRIu64 " with %" PRIhsz " bytes remaining",
+                              read->file_offset + read->completed_length,
+                              read->mapping.contents.data_length -
+                                  read->completed_length);
+  } else {
+    read->completed_length += (iree_host_size_t)res;
+    if (read->completed_length < read->mapping.contents.data_length) {
+      // Short read; resubmit the remainder unless the read was cancelled in
+      // the meantime. The read still owns its slot in the ring so this cannot
+      // overflow the submission queue.
+      if (iree_hal_async_file_read_should_cancel(read)) {
+        read->cancelled = true;
+      } else {
+        status = iree_hal_async_file_reader_ring_submit_read(reader, read);
+        if (iree_status_is_ok(status)) return;
+      }
+    }
+  }
+  iree_hal_async_file_reader_complete(reader, read, status);
+}
+
+static int iree_hal_async_file_reader_ring_main(void* entry_arg) {
+  iree_hal_async_file_reader_t* reader =
+      (iree_hal_async_file_reader_t*)entry_arg;
+  bool exit_requested = false;
+  while (!exit_requested) {
+    // Block until at least one completion is available.
+    int ret = iree_io_uring_enter(reader->ring_fd, 0, 1,
+                                  IORING_ENTER_GETEVENTS);
+    if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      // Unrecoverable; this should never happen with a valid ring.
+      IREE_ASSERT(false, "io_uring_enter wait failed");
+      break;
+    }
+
+    // Drain all available completions.
+    uint32_t head = *reader->cq_head;
+    const uint32_t tail = __atomic_load_n(reader->cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+      const struct io_uring_cqe* cqe = &reader->cqes[head & reader->cq_mask];
+      const uint64_t user_data = cqe->user_data;
+      const int32_t res = cqe->res;
+      ++head;
+      if (user_data == IREE_HAL_ASYNC_FILE_READER_SHUTDOWN_USER_DATA) {
+        exit_requested = true;
+        continue;
+      }
+      iree_hal_async_file_read_t* read =
+          (iree_hal_async_file_read_t*)(uintptr_t)user_data;
+      IREE_HAL_ASYNC_FILE_READER_TSAN_ACQUIRE(read);
+      iree_hal_async_file_reader_ring_process_completion(reader, read, res);
+    }
+    __atomic_store_n(reader->cq_head, head, __ATOMIC_RELEASE);
+  }
+  return 0;
+}
+
+#endif  // IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+
+//===----------------------------------------------------------------------===//
+// iree_hal_async_file_reader_t
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT iree_status_t iree_hal_async_file_reader_create(
+    const iree_hal_async_file_reader_options_t* options,
+    iree_allocator_t host_allocator,
+    iree_hal_async_file_reader_t** out_reader) {
+  IREE_ASSERT_ARGUMENT(options);
+  IREE_ASSERT_ARGUMENT(out_reader);
+  *out_reader = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  const iree_host_size_t queue_depth = iree_max(1, options->queue_depth);
+  const iree_host_size_t pool_thread_count = iree_max(1, options->thread_count);
+
+  iree_hal_async_file_reader_t* reader = NULL;
+  const iree_host_size_t total_size =
+      sizeof(*reader) + pool_thread_count * sizeof(reader->threads[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&reader));
+  memset(reader, 0, total_size);
+  reader->host_allocator = host_allocator;
+  iree_slim_mutex_initialize(&reader->mutex);
+  iree_notification_initialize(&reader->notification);
+  reader->max_in_flight_count = (int32_t)queue_depth;
+
+  // Try to use io_uring first and otherwise fall back to the thread pool.
+  bool use_io_uring = false;
+#if IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+  reader->ring_fd = -1;
+  if (!iree_all_bits_set(options->flags,
+                         IREE_HAL_ASYNC_FILE_READER_FLAG_DISABLE_IO_URING)) {
+    use_io_uring =
+        iree_hal_async_file_reader_ring_initialize(reader, queue_depth + 1);
+  }
+#endif  // IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, use_io_uring ? "io_uring" : "thread pool");
+
+  iree_thread_entry_t thread_main = iree_hal_async_file_reader_pool_main;
+  iree_host_size_t thread_count = pool_thread_count;
+#if IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+  if (use_io_uring) {
+    thread_main = iree_hal_async_file_reader_ring_main;
+    thread_count = 1;
+  }
+#endif  // IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+
+  iree_thread_create_params_t thread_params;
+  memset(&thread_params, 0, sizeof(thread_params));
+  thread_params.name = iree_make_cstring_view("iree-file-io");
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < thread_count; ++i) {
+    status = iree_thread_create(thread_main, reader, thread_params,
+                                host_allocator, &reader->threads[i]);
+    if (!iree_status_is_ok(status)) break;
+    ++reader->thread_count;
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_reader = reader;
+  } else {
+    iree_hal_async_file_reader_destroy(reader);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static bool iree_hal_async_file_reader_is_idle(
+    iree_hal_async_file_reader_t* reader) {
+  return iree_atomic_load(&reader->in_flight_count,
+                          iree_memory_order_acquire) == 0;
+}
+
+IREE_API_EXPORT void iree_hal_async_file_reader_destroy(
+    iree_hal_async_file_reader_t* reader) {
+  if (!reader) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t host_allocator = reader->host_allocator;
+
+  // Wait for all in-flight reads to complete; they reference our state.
+  iree_notification_await(
+      &reader->notification,
+      (iree_condition_fn_t)iree_hal_async_file_reader_is_idle, reader,
+      iree_infinite_timeout());
+
+  // Request all threads exit and join them (releasing joins).
+  iree_atomic_store(&reader->shutdown, 1, iree_memory_order_release);
+  iree_notification_post(&reader->notification, IREE_ALL_WAITERS);
+#if IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+  if (reader->ring_fd != -1 && reader->thread_count > 0) {
+    // Wake the completion thread with a no-op it recognizes as shutdown.
+    iree_status_ignore(iree_hal_async_file_reader_ring_push(
+        reader, IORING_OP_NOP, -1, NULL, 0,
+        IREE_HAL_ASYNC_FILE_READER_SHUTDOWN_USER_DATA));
+  }
+#endif  // IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+  for (iree_host_size_t i = 0; i < reader->thread_count; ++i) {
+    iree_thread_release(reader->threads[i]);
+  }
+
+#if IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+  iree_hal_async_file_reader_ring_deinitialize(reader);
+#endif  // IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+  iree_notification_deinitialize(&reader->notification);
+  iree_slim_mutex_deinitialize(&reader->mutex);
+  iree_allocator_free(host_allocator, reader);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+//===----------------------------------------------------------------------===//
+// Process-wide shared reader
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_async_file_reader_shared_t {
+  iree_slim_mutex_t mutex;
+  // Shared reader or NULL if there are no users.
+  iree_hal_async_file_reader_t* reader;
+  // Number of outstanding acquires of |reader|.
+  iree_host_size_t user_count;
+} iree_hal_async_file_reader_shared_t;
+
+static iree_hal_async_file_reader_shared_t iree_hal_async_file_reader_shared_;
+static iree_once_flag iree_hal_async_file_reader_shared_flag_ =
+    IREE_ONCE_FLAG_INIT;
+static void iree_hal_async_file_reader_shared_initialize(void) {
+  memset(&iree_hal_async_file_reader_shared_, 0,
+         sizeof(iree_hal_async_file_reader_shared_));
+  iree_slim_mutex_initialize(&iree_hal_async_file_reader_shared_.mutex);
+}
+
+static iree_hal_async_file_reader_shared_t* iree_hal_async_file_reader_shared(
+    void) {
+  iree_call_once(&iree_hal_async_file_reader_shared_flag_,
+                 iree_hal_async_file_reader_shared_initialize);
+  return &iree_hal_async_file_reader_shared_;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_async_file_reader_acquire_shared(
+    iree_hal_async_file_reader_t** out_reader) {
+  IREE_ASSERT_ARGUMENT(out_reader);
+  *out_reader = NULL;
+  iree_hal_async_file_reader_shared_t* shared =
+      iree_hal_async_file_reader_shared();
+  iree_slim_mutex_lock(&shared->mutex);
+  iree_status_t status = iree_ok_status();
+  if (!shared->reader) {
+    // The shared reader may outlive any particular user and must not use their
+    // allocators.
+    iree_hal_async_file_reader_options_t options;
+    iree_hal_async_file_reader_options_initialize(&options);
+    status = iree_hal_async_file_reader_create(
+        &options, iree_allocator_system(), &shared->reader);
+  }
+  if (iree_status_is_ok(status)) {
+    ++shared->user_count;
+    *out_reader = shared->reader;
+  }
+  iree_slim_mutex_unlock(&shared->mutex);
+  return status;
+}
+
+IREE_API_EXPORT void iree_hal_async_file_reader_release_shared(
+    iree_hal_async_file_reader_t* reader) {
+  if (!reader) return;
+  iree_hal_async_file_reader_shared_t* shared =
+      iree_hal_async_file_reader_shared();
+  iree_slim_mutex_lock(&shared->mutex);
+  IREE_ASSERT_EQ(shared->reader, reader);
+  IREE_ASSERT_GT(shared->user_count, 0);
+  if (--shared->user_count == 0) {
+    shared->reader = NULL;
+  } else {
+    reader = NULL;
+  }
+  iree_slim_mutex_unlock(&shared->mutex);
+
+  // Destroyed outside of the lock as it waits for in-flight reads; new users
+  // will get a new reader in the meantime.
+  iree_hal_async_file_reader_destroy(reader);
+}
+
+IREE_API_EXPORT bool iree_hal_async_file_reader_is_io_uring(
+    const iree_hal_async_file_reader_t* reader) {
+  IREE_ASSERT_ARGUMENT(reader);
+#if IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+  return reader->ring_fd != -1;
+#else
+  return false;
+#endif  // IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+}
+
+// Reserves a slot for a new in-flight read, blocking if the reader is at its
+// maximum queue depth.
+static bool iree_hal_async_file_reader_try_reserve(
+    iree_hal_async_file_reader_t* reader) {
+  int32_t count =
+      iree_atomic_load(&reader->in_flight_count, iree_memory_order_acquire);
+  while (count < reader->max_in_flight_count) {
+    if (iree_atomic_compare_exchange_weak(
+            &reader->in_flight_count, &count, count + 1,
+            iree_memory_order_acq_rel, iree_memory_order_acquire)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_async_file_reader_submit(
+    iree_hal_async_file_reader_t* reader, iree_io_file_handle_t* handle,
+    uint64_t file_offset, iree_hal_buffer_t* buffer,
+    iree_device_size_t buffer_offset, iree_device_size_t length,
+    iree_hal_semaphore_list_t signal_semaphore_list) {
+  IREE_ASSERT_ARGUMENT(reader);
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(buffer);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, file_offset);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (int64_t)length);
+
+  if (length == 0) {
+    iree_status_t status = iree_hal_semaphore_list_signal(signal_semaphore_list);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  // Allocate the read with the semaphore list stored inline.
+  iree_hal_async_file_read_t* read = NULL;
+  iree_host_size_t total_size =
+      sizeof(*read) +
+      signal_semaphore_list.count *
+          (sizeof(iree_hal_semaphore_t*) + sizeof(uint64_t));
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(reader->host_allocator, total_size,
+                                (void**)&read));
+  memset(read, 0, sizeof(*read));
+  read->file_offset = file_offset;
+  read->signal_semaphore_list.count = signal_semaphore_list.count;
+  read->signal_semaphore_list.semaphores =
+      (iree_hal_semaphore_t**)((uint8_t*)read + sizeof(*read));
+  read->signal_semaphore_list.payload_values =
+      (uint64_t*)(read->signal_semaphore_list.semaphores +
+                  signal_semaphore_list.count);
+  for (iree_host_size_t i = 0; i < signal_semaphore_list.count; ++i) {
+    read->signal_semaphore_list.semaphores[i] =
+        signal_semaphore_list.semaphores[i];
+    iree_hal_semaphore_retain(signal_semaphore_list.semaphores[i]);
+    read->signal_semaphore_list.payload_values[i] =
+        signal_semaphore_list.payload_values[i];
+  }
+
+  // Map the target range for the lifetime of the read. The mapping is ended on
+  // whichever thread completes the read.
+  iree_status_t status = iree_hal_buffer_map_range(
+      buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+      IREE_HAL_MEMORY_ACCESS_DISCARD_WRITE, buffer_offset, length,
+      &read->mapping);
+  if (!iree_status_is_ok(status)) {
+    for (iree_host_size_t i = 0; i < read->signal_semaphore_list.count; ++i) {
+      iree_hal_semaphore_release(read->signal_semaphore_list.semaphores[i]);
+    }
+    iree_allocator_free(reader->host_allocator, read);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+  read->buffer = buffer;
+  iree_hal_buffer_retain(buffer);
+  read->handle = handle;
+  iree_io_file_handle_retain(handle);
+
+  // Apply backpressure if too many reads are in flight.
+  if (!iree_hal_async_file_reader_try_reserve(reader)) {
+    IREE_TRACE_ZONE_BEGIN_NAMED(z1, "iree_hal_async_file_reader_wait_slot");
+    iree_notification_await(
+        &reader->notification,
+        (iree_condition_fn_t)iree_hal_async_file_reader_try_reserve, reader,
+        iree_infinite_timeout());
+    IREE_TRACE_ZONE_END(z1);
+  }
+
+  // NOTE: after this point the read owns the resources and any failure is
+  // reported asynchronously via the semaphores.
+#if IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+  if (reader->ring_fd != -1) {
+    if (iree_hal_async_file_read_should_cancel(read)) {
+      read->cancelled = true;
+      iree_hal_async_file_reader_complete(reader, read, iree_ok_status());
+    } else if (iree_io_file_handle_type(handle) ==
+               IREE_IO_FILE_HANDLE_TYPE_FD) {
+      status = iree_hal_async_file_reader_ring_submit_read(reader, read);
+    } else {
+      // Only file descriptors can be read via io_uring; other handles (such as
+      // host allocations) are just copies and cheap enough to do inline.
+      status = iree_hal_async_file_reader_read_sync(read);
+      iree_hal_async_file_reader_complete(reader, read, status);
+      status = iree_ok_status();
+    }
+    if (!iree_status_is_ok(status)) {
+      iree_hal_async_file_reader_complete(reader, read, status);
+      status = iree_ok_status();
+    }
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+#endif  // IREE_HAL_ASYNC_FILE_READER_HAVE_IO_URING
+  iree_hal_async_file_reader_pool_enqueue(reader, read);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,115 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_ASYNC_FILE_READER_H_
+#define IREE_HAL_UTILS_ASYNC_FILE_READER_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/io/file_handle.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_async_file_reader_t
+//===----------------------------------------------------------------------===//
+
+// Default maximum number of reads that may be in flight at a time.
+#define IREE_HAL_ASYNC_FILE_READER_DEFAULT_QUEUE_DEPTH 64
+
+// Default number of threads used when io_uring is not available.
+#define IREE_HAL_ASYNC_FILE_READER_DEFAULT_THREAD_COUNT 4
+
+// Flags controlling async file reader behavior.
+enum iree_hal_async_file_reader_flag_bits_t {
+  IREE_HAL_ASYNC_FILE_READER_FLAG_NONE = 0u,
+  // Never uses io_uring even if it is available and always uses the thread
+  // pool. Useful for testing or when running under sandboxes that restrict
+  // io_uring (where setup may succeed but operations fail).
+  IREE_HAL_ASYNC_FILE_READER_FLAG_DISABLE_IO_URING = 1u << 0,
+};
+typedef uint32_t iree_hal_async_file_reader_flags_t;
+
+// Options for configuring an async file reader.
+typedef struct iree_hal_async_file_reader_options_t {
+  iree_hal_async_file_reader_flags_t flags;
+  // Maximum number of reads in flight. Submissions beyond this will block
+  // until prior reads complete.
+  iree_host_size_t queue_depth;
+  // Number of threads issuing blocking positioned reads when io_uring is
+  // unavailable.
+  iree_host_size_t thread_count;
+} iree_hal_async_file_reader_options_t;
+
+// Initializes |out_options| to their default values.
+IREE_API_EXPORT void iree_hal_async_file_reader_options_initialize(
+    iree_hal_async_file_reader_options_t* out_options);
+
+// Services asynchronous file reads into mappable HAL buffers and signals HAL
+// semaphores as they complete. This allows many reads to be in flight at once
+// such that disk I/O can overlap with device uploads from staging buffers.
+//
+// On Linux io_uring is used when available and otherwise a small pool of
+// threads issues blocking positioned reads. Reads may be submitted from any
+// thread.
+typedef struct iree_hal_async_file_reader_t iree_hal_async_file_reader_t;
+
+// Creates a new async file reader with the given |options|.
+// Threads are created immediately and live until the reader is destroyed.
+IREE_API_EXPORT iree_status_t iree_hal_async_file_reader_create(
+    const iree_hal_async_file_reader_options_t* options,
+    iree_allocator_t host_allocator,
+    iree_hal_async_file_reader_t** out_reader);
+
+// Destroys |reader| after waiting for all in-flight reads to complete.
+IREE_API_EXPORT void iree_hal_async_file_reader_destroy(
+    iree_hal_async_file_reader_t* reader);
+
+// Returns a process-wide reader with default options in |out_reader|.
+// The reader is created on first use and shared by all users such that the
+// number of I/O threads and rings does not scale with the number of open files.
+// Each acquire must be balanced with a call to
+// iree_hal_async_file_reader_release_shared and the reader is destroyed after
+// the last user releases it.
+IREE_API_EXPORT iree_status_t iree_hal_async_file_reader_acquire_shared(
+    iree_hal_async_file_reader_t** out_reader);
+
+// Releases a |reader| returned by iree_hal_async_file_reader_acquire_shared.
+// If this was the last user the reader is destroyed after waiting for all
+// in-flight reads to complete.
+IREE_API_EXPORT void iree_hal_async_file_reader_release_shared(
+    iree_hal_async_file_reader_t* reader);
+
+// Returns true if the reader is using io_uring to service reads.
+IREE_API_EXPORT bool iree_hal_async_file_reader_is_io_uring(
+    const iree_hal_async_file_reader_t* reader);
+
+// Submits an asynchronous read of |length| bytes from |handle| starting at
+// |file_offset| into |buffer| at |buffer_offset|. The buffer must be host
+// mappable. When the read completes |signal_semaphore_list| will be signaled
+// and if it fails the semaphores will be marked as failed with the read error.
+//
+// Reads are cancelled without issuing (or continuing) any I/O if any signal
+// semaphore has failed before the read is serviced, such as when the transfer
+// the read belongs to has been aborted. The semaphores retain their original
+// failure status and the buffer contents are undefined.
+//
+// The file handle, buffer, and semaphores are retained until the read
+// completes. May block if the reader already has its maximum number of reads in
+// flight.
+IREE_API_EXPORT iree_status_t iree_hal_async_file_reader_submit(
+    iree_hal_async_file_reader_t* reader, iree_io_file_handle_t* handle,
+    uint64_t file_offset, iree_hal_buffer_t* buffer,
+    iree_device_size_t buffer_offset, iree_device_size_t length,
+    iree_hal_semaphore_list_t signal_semaphore_list);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_ASYNC_FILE_READER_H_
@@ -0,0 +1,367 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/async_file_reader.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/hal/api.h"
+#include "iree/hal/utils/semaphore_base.h"
+#include "iree/io/file_handle.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+#include <unistd.h>
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+
+namespace {
+extern const iree_hal_semaphore_vtable_t test_semaphore_vtable;
+}  // namespace
+
+// Minimal host semaphore tracking a payload value and failure status.
+struct TestSemaphore {
+  iree_hal_semaphore_t base;
+  iree_slim_mutex_t mutex;
+  uint64_t current_value;
+  iree_status_t failure_status;
+  iree_notification_t notification;
+
+  static iree_hal_semaphore_t* Create() {
+    TestSemaphore* semaphore = new TestSemaphore();
+    iree_hal_semaphore_initialize(&test_semaphore_vtable, &semaphore->base);
+    iree_slim_mutex_initialize(&semaphore->mutex);
+    iree_notification_initialize(&semaphore->notification);
+    return &semaphore->base;
+  }
+
+  static TestSemaphore* Cast(iree_hal_semaphore_t* base_semaphore) {
+    return reinterpret_cast<TestSemaphore*>(base_semaphore);
+  }
+
+  static void Destroy(iree_hal_semaphore_t* base_semaphore) {
+    auto* semaphore = Cast(base_semaphore);
+    iree_status_ignore(semaphore->failure_status);
+    iree_notification_deinitialize(&semaphore->notification);
+    iree_slim_mutex_deinitialize(&semaphore->mutex);
+    iree_hal_semaphore_deinitialize(&semaphore->base);
+    delete semaphore;
+  }
+
+  static iree_status_t Query(iree_hal_semaphore_t* base_semaphore,
+                             uint64_t* out_value) {
+    auto* semaphore = Cast(base_semaphore);
+    iree_slim_mutex_lock(&semaphore->mutex);
+    *out_value = semaphore->current_value;
+    iree_status_t status = iree_status_clone(semaphore->failure_status);
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return status;
+  }
+
+  static iree_status_t Signal(iree_hal_semaphore_t* base_semaphore,
+                              uint64_t new_value) {
+    auto* semaphore = Cast(base_semaphore);
+    iree_slim_mutex_lock(&semaphore->mutex);
+    semaphore->current_value = new_value;
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
+    return iree_ok_status();
+  }
+
+  static void Fail(iree_hal_semaphore_t* base_semaphore, iree_status_t status) {
+    auto* semaphore = Cast(base_semaphore);
+    iree_slim_mutex_lock(&semaphore->mutex);
+    iree_status_ignore(semaphore->failure_status);
+    semaphore->failure_status = status;
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
+  }
+
+  static iree_status_t Wait(iree_hal_semaphore_t* base_semaphore,
+                            uint64_t value, iree_timeout_t timeout) {
+    auto* semaphore = Cast(base_semaphore);
+    struct notify_state_t {
+      TestSemaphore* semaphore;
+      uint64_t value;
+    } notify_state = {semaphore, value};
+    if (!iree_notification_await(
+            &semaphore->notification,
+            [](void* user_data) -> bool {
+              auto* state = reinterpret_cast<notify_state_t*>(user_data);
+              iree_slim_mutex_lock(&state->semaphore->mutex);
+              bool is_resolved =
+                  state->semaphore->current_value >= state->value ||
+                  !iree_status_is_ok(state->semaphore->failure_status);
+              iree_slim_mutex_unlock(&state->semaphore->mutex);
+              return is_resolved;
+            },
+            (void*)&notify_state, timeout)) {
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+    iree_slim_mutex_lock(&semaphore->mutex);
+    iree_status_t status = iree_status_clone(semaphore->failure_status);
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return status;
+  }
+};
+
+namespace {
+const iree_hal_semaphore_vtable_t test_semaphore_vtable = {
+    /*.destroy=*/TestSemaphore::Destroy,
+    /*.query=*/TestSemaphore::Query,
+    /*.signal=*/TestSemaphore::Signal,
+    /*.fail=*/TestSemaphore::Fail,
+    /*.wait=*/TestSemaphore::Wait,
+};
+}  // namespace
+
+// Returns the byte at |offset| in the test file contents.
+static uint8_t PatternByte(uint64_t offset) {
+  return (uint8_t)((offset * 31) ^ (offset >> 8));
+}
+
+// Fill value for buffer contents that have not been read into.
+static const uint8_t kFillByte = 0xCD;
+
+// Runs each test with io_uring enabled (where available) and disabled.
+class AsyncFileReaderTest : public ::testing::TestWithParam<bool> {
+ protected:
+  static constexpr iree_host_size_t kFileSize = 256 * 1024 + 123;
+
+  void SetUp() override {
+    // Writes the test pattern to a new temporary file.
+    const char* tmpdir = getenv("TEST_TMPDIR");
+    if (!tmpdir) tmpdir = getenv("TMPDIR");
+    if (!tmpdir) tmpdir = "/tmp";
+    path_ = std::string(tmpdir) + "/iree_async_file_reader_test_XXXXXX";
+    int fd = mkstemp(&path_[0]);
+    ASSERT_NE(fd, -1);
+    std::vector<uint8_t> contents(kFileSize);
+    for (iree_host_size_t i = 0; i < kFileSize; ++i) {
+      contents[i] = PatternByte(i);
+    }
+    ASSERT_EQ(write(fd, contents.data(), contents.size()),
+              (ssize_t)contents.size());
+    close(fd);
+    IREE_ASSERT_OK(iree_io_file_handle_open(
+        IREE_IO_FILE_ACCESS_READ,
+        iree_make_string_view(path_.data(), path_.size()),
+        iree_allocator_system(), &handle_));
+
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        IREE_SV("test"), iree_allocator_system(), iree_allocator_system(),
+        &device_allocator_));
+
+    iree_hal_async_file_reader_options_t options;
+    iree_hal_async_file_reader_options_initialize(&options);
+    if (GetParam()) {
+      options.flags |= IREE_HAL_ASYNC_FILE_READER_FLAG_DISABLE_IO_URING;
+    }
+    options.queue_depth = 4;
+    options.thread_count = 2;
+    IREE_ASSERT_OK(iree_hal_async_file_reader_create(
+        &options, iree_allocator_system(), &reader_));
+  }
+
+  void TearDown() override {
+    iree_hal_async_file_reader_destroy(reader_);
+    iree_hal_allocator_release(device_allocator_);
+    iree_io_file_handle_release(handle_);
+    if (!path_.empty()) unlink(path_.c_str());
+  }
+
+  // Allocates a host buffer of |length| bytes filled with kFillByte.
+  iree_hal_buffer_t* AllocateBuffer(iree_device_size_t length) {
+    iree_hal_buffer_params_t params = {0};
+    params.type =
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+    params.usage =
+        IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING;
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(device_allocator_, params,
+                                                     length, &buffer));
+    IREE_CHECK_OK(iree_hal_buffer_map_fill(buffer, 0, IREE_WHOLE_BUFFER,
+                                           &kFillByte, sizeof(kFillByte)));
+    return buffer;
+  }
+
+  // Returns the contents of |buffer| in the given range.
+  std::vector<uint8_t> ReadBuffer(iree_hal_buffer_t* buffer,
+                                  iree_device_size_t offset,
+                                  iree_device_size_t length) {
+    std::vector<uint8_t> contents(length);
+    IREE_CHECK_OK(
+        iree_hal_buffer_map_read(buffer, offset, contents.data(), length));
+    return contents;
+  }
+
+  // Submits a read signaling |semaphore| to |value| on completion.
+  iree_status_t Submit(uint64_t file_offset, iree_hal_buffer_t* buffer,
+                       iree_device_size_t buffer_offset,
+                       iree_device_size_t length,
+                       iree_hal_semaphore_t* semaphore, uint64_t value) {
+    iree_hal_semaphore_list_t signal_semaphore_list = {
+        /*.count=*/1,
+        /*.semaphores=*/&semaphore,
+        /*.payload_values=*/&value,
+    };
+    return iree_hal_async_file_reader_submit(reader_, handle_, file_offset,
+                                             buffer, buffer_offset, length,
+                                             signal_semaphore_list);
+  }
+
+  std::string path_;
+  iree_io_file_handle_t* handle_ = NULL;
+  iree_hal_allocator_t* device_allocator_ = NULL;
+  iree_hal_async_file_reader_t* reader_ = NULL;
+};
+
+TEST_P(AsyncFileReaderTest, Backend) {
+  // When io_uring is disabled the thread pool must be used. Otherwise io_uring
+  // is only used opportunistically and either backend is valid.
+  if (GetParam()) {
+    EXPECT_FALSE(iree_hal_async_file_reader_is_io_uring(reader_));
+  }
+}
+
+// Issues more reads than the queue depth such that submissions block until
+// prior reads complete.
+TEST_P(AsyncFileReaderTest, ManyReads) {
+  static const iree_host_size_t kChunkSize = 4096 + 7;
+  static const iree_host_size_t kChunkCount = kFileSize / kChunkSize;
+  iree_hal_buffer_t* buffer = AllocateBuffer(kChunkCount * kChunkSize);
+  std::vector<iree_hal_semaphore_t*> semaphores(kChunkCount);
+  for (iree_host_size_t i = 0; i < kChunkCount; ++i) {
+    // Reads the file chunks in reverse order into the buffer.
+    semaphores[i] = TestSemaphore::Create();
+    IREE_ASSERT_OK(Submit((kChunkCount - i - 1) * kChunkSize, buffer,
+                          i * kChunkSize, kChunkSize, semaphores[i], 1ull));
+  }
+  for (iree_host_size_t i = 0; i < kChunkCount; ++i) {
+    IREE_ASSERT_OK(
+        iree_hal_semaphore_wait(semaphores[i], 1ull, iree_infinite_timeout()));
+    iree_hal_semaphore_release(semaphores[i]);
+  }
+  for (iree_host_size_t i = 0; i < kChunkCount; ++i) {
+    std::vector<uint8_t> contents =
+        ReadBuffer(buffer, i * kChunkSize, kChunkSize);
+    const uint64_t file_offset = (kChunkCount - i - 1) * kChunkSize;
+    for (iree_host_size_t j = 0; j < kChunkSize; ++j) {
+      ASSERT_EQ(contents[j], PatternByte(file_offset + j))
+          << "chunk " << i << " byte " << j;
+    }
+  }
+  iree_hal_buffer_release(buffer);
+}
+
+// Zero-length reads signal without issuing any I/O.
+TEST_P(AsyncFileReaderTest, ZeroLength) {
+  iree_hal_buffer_t* buffer = AllocateBuffer(16);
+  iree_hal_semaphore_t* semaphore = TestSemaphore::Create();
+  IREE_ASSERT_OK(Submit(kFileSize, buffer, 0, 0, semaphore, 1ull));
+  IREE_EXPECT_OK(
+      iree_hal_semaphore_wait(semaphore, 1ull, iree_immediate_timeout()));
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_buffer_release(buffer);
+}
+
+// A read straddling the end of the file returns short and must fail instead
+// of signaling with a partially populated buffer.
+TEST_P(AsyncFileReaderTest, ShortReadFails) {
+  iree_hal_buffer_t* buffer = AllocateBuffer(1024);
+  iree_hal_semaphore_t* semaphore = TestSemaphore::Create();
+  IREE_ASSERT_OK(Submit(kFileSize - 100, buffer, 0, 1024, semaphore, 1ull));
+  EXPECT_THAT(Status(iree_hal_semaphore_wait(semaphore, 1ull,
+                                             iree_infinite_timeout())),
+              StatusIs(StatusCode::kOutOfRange));
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_buffer_release(buffer);
+}
+
+// Reads starting at the end of the file fail.
+TEST_P(AsyncFileReaderTest, EndOfFileFails) {
+  iree_hal_buffer_t* buffer = AllocateBuffer(16);
+  iree_hal_semaphore_t* semaphore = TestSemaphore::Create();
+  IREE_ASSERT_OK(Submit(kFileSize, buffer, 0, 16, semaphore, 1ull));
+  EXPECT_THAT(Status(iree_hal_semaphore_wait(semaphore, 1ull,
+                                             iree_infinite_timeout())),
+              StatusIs(StatusCode::kOutOfRange));
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_buffer_release(buffer);
+}
+
+// Reads whose semaphores have already failed are cancelled without touching
+// the buffer and the original failure is preserved.
+TEST_P(AsyncFileReaderTest, Cancellation) {
+  iree_hal_buffer_t* buffer = AllocateBuffer(4096);
+  iree_hal_semaphore_t* cancelled_semaphore = TestSemaphore::Create();
+  iree_hal_semaphore_fail(cancelled_semaphore,
+                          iree_make_status(IREE_STATUS_ABORTED, "aborted"));
+  iree_hal_semaphore_t* semaphore = TestSemaphore::Create();
+  IREE_ASSERT_OK(Submit(0, buffer, 0, 2048, cancelled_semaphore, 1ull));
+  IREE_ASSERT_OK(Submit(2048, buffer, 2048, 2048, semaphore, 1ull));
+
+  // Destroying the reader waits for all reads to complete.
+  iree_hal_async_file_reader_destroy(reader_);
+  reader_ = NULL;
+
+  IREE_EXPECT_OK(
+      iree_hal_semaphore_wait(semaphore, 1ull, iree_immediate_timeout()));
+  EXPECT_THAT(Status(iree_hal_semaphore_wait(cancelled_semaphore, 1ull,
+                                             iree_immediate_timeout())),
+              StatusIs(StatusCode::kAborted));
+  std::vector<uint8_t> contents = ReadBuffer(buffer, 0, 4096);
+  for (iree_host_size_t i = 0; i < 2048; ++i) {
+    ASSERT_EQ(contents[i], kFillByte) << "byte " << i;
+  }
+  for (iree_host_size_t i = 2048; i < 4096; ++i) {
+    ASSERT_EQ(contents[i], PatternByte(i)) << "byte " << i;
+  }
+
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_semaphore_release(cancelled_semaphore);
+  iree_hal_buffer_release(buffer);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllBackends, AsyncFileReaderTest, ::testing::Bool(),
+                         [](const ::testing::TestParamInfo<bool>& info) {
+                           return info.param ? "ThreadPool" : "Default";
+                         });
+
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
+
+// All users share a single reader that is recreated after the last release.
+TEST(AsyncFileReaderSharedTest, AcquireRelease) {
+  iree_hal_async_file_reader_t* reader_a = NULL;
+  IREE_ASSERT_OK(iree_hal_async_file_reader_acquire_shared(&reader_a));
+  iree_hal_async_file_reader_t* reader_b = NULL;
+  IREE_ASSERT_OK(iree_hal_async_file_reader_acquire_shared(&reader_b));
+  EXPECT_EQ(reader_a, reader_b);
+  iree_hal_async_file_reader_release_shared(reader_a);
+  iree_hal_async_file_reader_release_shared(reader_b);
+
+  iree_hal_async_file_reader_t* reader_c = NULL;
+  IREE_ASSERT_OK(iree_hal_async_file_reader_acquire_shared(&reader_c));
+  EXPECT_NE(reader_c, nullptr);
+  iree_hal_async_file_reader_release_shared(reader_c);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
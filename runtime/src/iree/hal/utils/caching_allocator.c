@@ -6,11 +6,112 @@
 
 #include "iree/hal/utils/caching_allocator.h"
 
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/math.h"
 #include "iree/base/internal/synchronization.h"
 
 // Default capacity of a pool free list when not specified by the user.
 #define IREE_HAL_CACHING_ALLOCATOR_DEFAULT_FREE_LIST_CAPACITY 64
 
+// Maximum number of size classes per power-of-two range of sizes.
+#define IREE_HAL_CACHING_ALLOCATOR_MAX_SIZE_CLASSES_PER_DOUBLING 16
+
+// Maximum number of thread caches per pool.
+#define IREE_HAL_CACHING_ALLOCATOR_MAX_THREAD_CACHE_COUNT 64
+
+// log2 of the smallest size class; smaller allocations are rounded up to it.
+// Must be >= log2(IREE_HAL_CACHING_ALLOCATOR_MAX_SIZE_CLASSES_PER_DOUBLING).
+#define IREE_HAL_CACHING_ALLOCATOR_MIN_SIZE_CLASS_SHIFT 8
+
+// log2 of the largest size class; larger allocations bypass the pools.
+#define IREE_HAL_CACHING_ALLOCATOR_MAX_SIZE_CLASS_SHIFT 48
+
+#if !defined(iree_thread_local)
+#if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+#define iree_thread_local
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201102L) && \
+    !__STDC_NO_THREADS__
+#define iree_thread_local _Thread_local
+#elif defined(IREE_COMPILER_MSVC)
+#define iree_thread_local __declspec(thread)
+#else
+#define iree_thread_local
+#endif  // __STDC_NO_THREADS__
+#endif  // !iree_thread_local
+
+// Returns a process-unique ordinal for the calling thread used to select its
+// thread cache. Threads are assigned ordinals in the order they first
+// allocate. If thread-local storage is unavailable all threads share one.
+static uint32_t iree_hal_caching_allocator_thread_ordinal(void) {
+  static iree_atomic_int32_t next_ordinal = IREE_ATOMIC_VAR_INIT(0);
+  static iree_thread_local int32_t thread_ordinal = -1;
+  if (IREE_UNLIKELY(thread_ordinal < 0)) {
+    thread_ordinal = iree_atomic_fetch_add(&next_ordinal, 1,
+                                           iree_memory_order_relaxed) &
+                     INT32_MAX;
+  }
+  return (uint32_t)thread_ordinal;
+}
+
+//===----------------------------------------------------------------------===//
+// Size classes
+//===----------------------------------------------------------------------===//
+
+// Size classes divide each power-of-two range (2^e, 2^(e+1)] into
+// |classes_per_doubling| equal steps with class 0 holding everything up to the
+// minimum size. For example with 4 classes per doubling the classes above 256B
+// are 320, 384, 448, 512, 640, 768, 896, 1024, 1280, ...
+
+// Returns the size class index for |size| rounded up to the nearest class.
+static uint32_t iree_hal_caching_allocator_size_class_ceil(
+    uint32_t classes_per_doubling, iree_device_size_t size) {
+  if (size <= (1ull << IREE_HAL_CACHING_ALLOCATOR_MIN_SIZE_CLASS_SHIFT)) {
+    return 0;
+  }
+  const uint32_t shift_per_doubling =
+      iree_math_count_trailing_zeros_u32(classes_per_doubling);
+  // size is in (2^e, 2^(e+1)].
+  const int e = 63 - iree_math_count_leading_zeros_u64(size - 1);
+  const uint64_t step_shift = e - shift_per_doubling;
+  const uint64_t sub =
+      ((size - (1ull << e)) + (1ull << step_shift) - 1) >> step_shift;
+  return (uint32_t)(e - IREE_HAL_CACHING_ALLOCATOR_MIN_SIZE_CLASS_SHIFT) *
+             classes_per_doubling +
+         (uint32_t)sub;
+}
+
+// Returns the size class index for |size| rounded down to the nearest class.
+// Buffers of |size| can service any request in the returned class.
+static uint32_t iree_hal_caching_allocator_size_class_floor(
+    uint32_t classes_per_doubling, iree_device_size_t size) {
+  if (size <= (1ull << IREE_HAL_CACHING_ALLOCATOR_MIN_SIZE_CLASS_SHIFT)) {
+    return 0;
+  }
+  const uint32_t shift_per_doubling =
+      iree_math_count_trailing_zeros_u32(classes_per_doubling);
+  // size is in [2^e, 2^(e+1)).
+  const int e = 63 - iree_math_count_leading_zeros_u64(size);
+  const uint64_t step_shift = e - shift_per_doubling;
+  const uint64_t sub = (size - (1ull << e)) >> step_shift;
+  return (uint32_t)(e - IREE_HAL_CACHING_ALLOCATOR_MIN_SIZE_CLASS_SHIFT) *
+             classes_per_doubling +
+         (uint32_t)sub;
+}
+
+// Returns the allocation size of the size class at |index|.
+static iree_device_size_t iree_hal_caching_allocator_size_class_size(
+    uint32_t classes_per_doubling, uint32_t index) {
+  if (index == 0) {
+    return 1ull << IREE_HAL_CACHING_ALLOCATOR_MIN_SIZE_CLASS_SHIFT;
+  }
+  const uint32_t shift_per_doubling =
+      iree_math_count_trailing_zeros_u32(classes_per_doubling);
+  const uint32_t e = IREE_HAL_CACHING_ALLOCATOR_MIN_SIZE_CLASS_SHIFT +
+                     (index - 1) / classes_per_doubling;
+  const uint64_t sub = (index - 1) % classes_per_doubling + 1;
+  return (1ull << e) + (sub << (e - shift_per_doubling));
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_caching_allocator_pool_t
 //===----------------------------------------------------------------------===//
@@ -28,16 +129,91 @@ void iree_hal_caching_allocator_pool_params_initialize(
   out_params->max_allocation_capacity = IREE_DEVICE_SIZE_MAX;
   out_params->max_free_allocation_count =
       IREE_HAL_CACHING_ALLOCATOR_DEFAULT_FREE_LIST_CAPACITY;
+  out_params->size_classes_per_doubling = 0;
+  out_params->max_free_capacity = IREE_DEVICE_SIZE_MAX;
+  out_params->thread_cache_count = 1;
+}
+
+static iree_status_t iree_hal_caching_allocator_pool_params_verify(
+    const iree_hal_caching_allocator_pool_params_t* params) {
+  const uint32_t classes_per_doubling = params->size_classes_per_doubling;
+  if (classes_per_doubling >
+          IREE_HAL_CACHING_ALLOCATOR_MAX_SIZE_CLASSES_PER_DOUBLING ||
+      (classes_per_doubling & (classes_per_doubling - 1)) != 0) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "size classes per doubling must be 0 or a power of two <= %d (got %u)",
+        IREE_HAL_CACHING_ALLOCATOR_MAX_SIZE_CLASSES_PER_DOUBLING,
+        classes_per_doubling);
+  }
+  if (params->thread_cache_count >
+      IREE_HAL_CACHING_ALLOCATOR_MAX_THREAD_CACHE_COUNT) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "thread cache count must be <= %d (got %" PRIhsz
+                            ")",
+                            IREE_HAL_CACHING_ALLOCATOR_MAX_THREAD_CACHE_COUNT,
+                            params->thread_cache_count);
+  }
+  if (params->max_free_allocation_count >= UINT32_MAX) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "max free allocation count out of range");
+  }
+  return iree_ok_status();
 }
 
+// Sentinel entry index used to terminate lists.
+#define IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE UINT32_MAX
+
+// A free buffer tracked by a thread cache.
+// Entries are linked into both the list of their size class and the LRU list
+// of the cache so that they can be taken from either in O(1).
+typedef struct iree_hal_caching_allocator_entry_t {
+  // Retained free buffer or NULL if the entry is unused.
+  iree_hal_buffer_t* buffer;
+  // Size class the entry is linked into.
+  uint32_t size_class;
+  // Size class list with the most recently released buffers first.
+  uint32_t class_prev;
+  uint32_t class_next;
+  // LRU list of all entries with the least recently released buffers first.
+  // Unused entries are chained through lru_next.
+  uint32_t lru_prev;
+  uint32_t lru_next;
+} iree_hal_caching_allocator_entry_t;
+
+// A free list of buffers preferred by a subset of threads.
+//
+// Thread-safe. Each cache has its own mutex so threads using different caches
+// do not contend. The mutex will not be held during underlying allocator
+// operations.
+typedef struct iree_hal_caching_allocator_cache_t {
+  iree_slim_mutex_t mutex;
+
+  // Number of entries in use and the total capacity of |entries|.
+  iree_host_size_t count;
+  iree_host_size_t capacity;
+
+  // Oldest and newest used entries.
+  uint32_t lru_head;
+  uint32_t lru_tail;
+  // First unused entry.
+  uint32_t unused_head;
+
+  // Most recently released entry in each size class.
+  uint32_t* class_heads;
+  // Storage for up to |capacity| entries.
+  iree_hal_caching_allocator_entry_t* entries;
+} iree_hal_caching_allocator_cache_t;
+
 // Pool of arbitrarily-sized device allocations for a particular heap.
-// This maintains a free list of blocks available for use but does not track
+// This maintains free lists of blocks available for use but does not track
 // outstanding allocations.
 //
 // Thread-safe. Pools can service requests from multiple threads concurrently by
-// way of a pool-specific mutex. The mutex will not be held during underlying
-// allocator operations such as when acquiring a new allocation as these can be
-// extremely slow and the underlying allocator is also assumed thread-safe.
+// way of per-cache mutexes. No mutex is held during underlying allocator
+// operations such as when acquiring a new allocation as these can be extremely
+// slow and the underlying allocator is also assumed thread-safe. Size limits
+// are tracked with atomics and may be briefly exceeded when threads race.
 typedef iree_alignas(
     iree_max_align_t) struct iree_hal_caching_allocator_pool_t {
   // Defines which heap this pool allocates from and the pool limits.
@@ -47,35 +223,76 @@ typedef iree_alignas(
   // Unretained as the parent allocator retains it for us.
   iree_hal_allocator_t* device_allocator;
 
-  // Guards access to the pool data structures as buffers can be
-  // acquired/released from multiple threads if shared across user-visible
-  // devices.
-  //
-  // Note that we keep the mutex per-pool so that if we do need to allocate or
-  // free we can do so without holding the lock.
-  iree_slim_mutex_t mutex;
-
   // Total size, in bytes, of all outstanding allocations made from this pool.
   // This only includes allocations we are able to pool as we otherwise cannot
   // observe imported/exported buffers.
-  iree_device_size_t total_allocated_size;
+  iree_atomic_int64_t total_allocated_size;
 
   // Total size, in bytes, of all free buffers currently in this pool.
-  iree_device_size_t free_allocated_size;
-
-  // Flat MRU list of available buffers with max_free_allocation_count slots.
-  // Sorted by ascending recency (the higher the index the more recent).
-  // If we really cared about optimizing the interior removal then we'd want
-  // a linked/skip list or some bucketing but that's really for the higher
-  // level allocators to do.
-  iree_host_size_t free_count;
-  iree_hal_buffer_t* free_buffers[];
+  iree_atomic_int64_t free_allocated_size;
+
+  // Size classes used to bucket free buffers. When sizes are not rounded
+  // (size_classes_per_doubling == 0) power-of-two buckets are scanned for
+  // exact matches.
+  uint32_t classes_per_doubling;
+  uint32_t class_count;
+
+  // Thread caches with trailing storage for their lists.
+  iree_host_size_t cache_count;
+  iree_hal_caching_allocator_cache_t caches[];
 } iree_hal_caching_allocator_pool_t;
 
+// Returns the number of size classes needed to cover all allocations up to
+// the pool |params| max_allocation_size.
+static uint32_t iree_hal_caching_allocator_pool_class_count(
+    const iree_hal_caching_allocator_pool_params_t* params) {
+  const uint32_t classes_per_doubling =
+      iree_max(1u, params->size_classes_per_doubling);
+  const iree_device_size_t max_size =
+      iree_min(params->max_allocation_size,
+               1ull << IREE_HAL_CACHING_ALLOCATOR_MAX_SIZE_CLASS_SHIFT);
+  return iree_hal_caching_allocator_size_class_ceil(classes_per_doubling,
+                                                    max_size) +
+         1;
+}
+
+// Returns the number of thread caches used by a pool with |params|.
+static iree_host_size_t iree_hal_caching_allocator_pool_cache_count(
+    const iree_hal_caching_allocator_pool_params_t* params) {
+  return iree_max(1, params->thread_cache_count);
+}
+
+// Returns the number of entries in each thread cache of a pool with |params|.
+static iree_host_size_t iree_hal_caching_allocator_pool_cache_capacity(
+    const iree_hal_caching_allocator_pool_params_t* params) {
+  const iree_host_size_t cache_count =
+      iree_hal_caching_allocator_pool_cache_count(params);
+  return (params->max_free_allocation_count + cache_count - 1) / cache_count;
+}
+
+// Returns the total size of a pool with |params| including trailing storage.
+static iree_host_size_t iree_hal_caching_allocator_pool_storage_size(
+    const iree_hal_caching_allocator_pool_params_t* params) {
+  const iree_host_size_t cache_count =
+      iree_hal_caching_allocator_pool_cache_count(params);
+  const iree_host_size_t class_heads_size =
+      iree_hal_caching_allocator_pool_class_count(params) * sizeof(uint32_t);
+  const iree_host_size_t cache_size =
+      iree_host_align(class_heads_size, iree_max_align_t) +
+      iree_hal_caching_allocator_pool_cache_capacity(params) *
+          sizeof(iree_hal_caching_allocator_entry_t);
+  return iree_host_align(
+             sizeof(iree_hal_caching_allocator_pool_t) +
+                 cache_count * sizeof(iree_hal_caching_allocator_cache_t),
+             iree_max_align_t) +
+         cache_count * iree_host_align(cache_size, iree_max_align_t);
+}
+
 static void iree_hal_caching_allocator_pool_trim(
     iree_hal_caching_allocator_pool_t* pool);
 
-// Initializes a buffer pool in |out_pool|.
+// Initializes a buffer pool in |out_pool| with storage for the lists sized by
+// iree_hal_caching_allocator_pool_storage_size.
 // Buffer device storage will be allocated from |device_allocator|.
 static void iree_hal_caching_allocator_pool_initialize(
     iree_hal_caching_allocator_pool_params_t params,
@@ -85,16 +302,49 @@ static void iree_hal_caching_allocator_pool_initialize(
 
   out_pool->params = params;
   out_pool->device_allocator = device_allocator;
-  iree_slim_mutex_initialize(&out_pool->mutex);
-  out_pool->total_allocated_size = 0;
-  out_pool->free_allocated_size = 0;
-  out_pool->free_count = 0;
+  iree_atomic_store(&out_pool->total_allocated_size, 0,
+                    iree_memory_order_relaxed);
+  iree_atomic_store(&out_pool->free_allocated_size, 0,
+                    iree_memory_order_relaxed);
+  out_pool->classes_per_doubling =
+      iree_max(1u, params.size_classes_per_doubling);
+  out_pool->class_count = iree_hal_caching_allocator_pool_class_count(&params);
+  out_pool->cache_count = iree_hal_caching_allocator_pool_cache_count(&params);
+
+  const iree_host_size_t cache_capacity =
+      iree_hal_caching_allocator_pool_cache_capacity(&params);
+  uint8_t* storage_ptr = (uint8_t*)&out_pool->caches[out_pool->cache_count];
+  for (iree_host_size_t i = 0; i < out_pool->cache_count; ++i) {
+    iree_hal_caching_allocator_cache_t* cache = &out_pool->caches[i];
+    iree_slim_mutex_initialize(&cache->mutex);
+    cache->count = 0;
+    cache->capacity = cache_capacity;
+    cache->lru_head = IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE;
+    cache->lru_tail = IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE;
+    storage_ptr = (uint8_t*)iree_host_align((uintptr_t)storage_ptr,
+                                            iree_max_align_t);
+    cache->class_heads = (uint32_t*)storage_ptr;
+    storage_ptr += iree_host_align(out_pool->class_count * sizeof(uint32_t),
+                                   iree_max_align_t);
+    cache->entries = (iree_hal_caching_allocator_entry_t*)storage_ptr;
+    storage_ptr += cache_capacity * sizeof(cache->entries[0]);
+    for (uint32_t j = 0; j < out_pool->class_count; ++j) {
+      cache->class_heads[j] = IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE;
+    }
+    for (iree_host_size_t j = 0; j < cache_capacity; ++j) {
+      memset(&cache->entries[j], 0, sizeof(cache->entries[j]));
+      cache->entries[j].lru_next = j + 1 < cache_capacity
+                                       ? (uint32_t)(j + 1)
+                                       : IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE;
+    }
+    cache->unused_head =
+        cache_capacity ? 0 : IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE;
+  }
 
   IREE_TRACE_SET_PLOT_TYPE(IREE_HAL_CACHING_ALLOCATOR_ID,
                            IREE_TRACING_PLOT_TYPE_MEMORY, /*step=*/true,
                            /*fill=*/true, /*color=*/0);
-  IREE_TRACE_PLOT_VALUE_I64(IREE_HAL_CACHING_ALLOCATOR_ID,
-                            out_pool->free_allocated_size);
+  IREE_TRACE_PLOT_VALUE_I64(IREE_HAL_CACHING_ALLOCATOR_ID, 0);
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -107,132 +357,213 @@ static void iree_hal_caching_allocator_pool_deinitialize(
   // Trim first to release all the buffers. There shouldn't be any live
   // allocations by the time we are deinitializing.
   iree_hal_caching_allocator_pool_trim(pool);
-  IREE_ASSERT_EQ(pool->total_allocated_size, 0,
-                 "must have released all allocations prior to deinit");
-  IREE_ASSERT_EQ(pool->free_allocated_size, 0,
-                 "must have released all allocations prior to deinit");
-  IREE_ASSERT_EQ(pool->free_count, 0,
-                 "must have released all allocations prior to deinit");
-
-  iree_slim_mutex_deinitialize(&pool->mutex);
+  IREE_ASSERT_EQ(iree_atomic_load(&pool->total_allocated_size,
+                                  iree_memory_order_relaxed),
+                 0, "must have released all allocations prior to deinit");
+  IREE_ASSERT_EQ(
+      iree_atomic_load(&pool->free_allocated_size, iree_memory_order_relaxed),
+      0, "must have released all allocations prior to deinit");
+
+  for (iree_host_size_t i = 0; i < pool->cache_count; ++i) {
+    IREE_ASSERT_EQ(pool->caches[i].count, 0,
+                   "must have released all allocations prior to deinit");
+    iree_slim_mutex_deinitialize(&pool->caches[i].mutex);
+  }
 
   IREE_TRACE_ZONE_END(z0);
 }
 
-// Pushes |buffer| on to the pool free list as the most recently used.
+// Adjusts the pool free size by |delta| bytes and returns the new size.
+static int64_t iree_hal_caching_allocator_pool_adjust_free_size(
+    iree_hal_caching_allocator_pool_t* pool, int64_t delta) {
+  const int64_t free_size =
+      iree_atomic_fetch_add(&pool->free_allocated_size, delta,
+                            iree_memory_order_relaxed) +
+      delta;
+  IREE_TRACE_PLOT_VALUE_I64(IREE_HAL_CACHING_ALLOCATOR_ID, free_size);
+  return free_size;
+}
+
+// Pushes |buffer| on to the |cache| free list as the most recently used.
 // The buffer will be retained in the list.
 //
-// Must be called with the pool mutex held.
-static void iree_hal_caching_allocator_pool_push_buffer(
-    iree_hal_caching_allocator_pool_t* pool, iree_hal_buffer_t* buffer) {
+// Must be called with the cache mutex held and an unused entry available.
+static void iree_hal_caching_allocator_cache_push_buffer(
+    iree_hal_caching_allocator_pool_t* pool,
+    iree_hal_caching_allocator_cache_t* cache, uint32_t size_class,
+    iree_hal_buffer_t* buffer) {
   // Retain the buffer; the caller must release it to complete the ownership
   // transfer.
   iree_hal_buffer_retain(buffer);
 
-  IREE_ASSERT_LT(pool->free_count, pool->params.max_free_allocation_count);
+  IREE_ASSERT_LT(cache->count, cache->capacity);
+  const uint32_t i = cache->unused_head;
+  iree_hal_caching_allocator_entry_t* entry = &cache->entries[i];
+  cache->unused_head = entry->lru_next;
+  ++cache->count;
 
-  // Add to the end of the list (the most recent).
-  iree_host_size_t i = pool->free_count++;
-  pool->free_buffers[i] = buffer;
+  entry->buffer = buffer;
+  entry->size_class = size_class;
+
+  // Add to the front of the size class list (the most recent).
+  entry->class_prev = IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE;
+  entry->class_next = cache->class_heads[size_class];
+  if (entry->class_next != IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE) {
+    cache->entries[entry->class_next].class_prev = i;
+  }
+  cache->class_heads[size_class] = i;
+
+  // Add to the end of the LRU list (the most recent).
+  entry->lru_prev = cache->lru_tail;
+  entry->lru_next = IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE;
+  if (cache->lru_tail != IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE) {
+    cache->entries[cache->lru_tail].lru_next = i;
+  } else {
+    cache->lru_head = i;
+  }
+  cache->lru_tail = i;
 
   // Track that we're now retaining unused memory.
-  pool->free_allocated_size += buffer->allocation_size;
-  IREE_TRACE_PLOT_VALUE_I64(IREE_HAL_CACHING_ALLOCATOR_ID,
-                            pool->free_allocated_size);
+  iree_hal_caching_allocator_pool_adjust_free_size(
+      pool, (int64_t)iree_hal_buffer_allocation_size(buffer));
 }
 
-// Takes the buffer in the |pool| free list at index |i| and returns ownership.
-// If the list is large this is bad but in most cases it's just a few dozen
-// elements.
+// Takes the buffer in the |cache| free list at entry |i| and returns ownership.
 //
-// Must be called with the pool mutex held.
-static iree_hal_buffer_t* iree_hal_caching_allocator_pool_take_buffer_at(
-    iree_hal_caching_allocator_pool_t* pool, iree_host_size_t i) {
-  iree_hal_buffer_t* buffer = pool->free_buffers[i];
-  if (i < pool->free_count - 1) {
-    // Shift the list down to keep it dense and in ascending recency order.
-    memmove(&pool->free_buffers[i], &pool->free_buffers[i + 1],
-            (pool->free_count - i - 1) * sizeof(pool->free_buffers[0]));
-  }
-  --pool->free_count;
-  pool->free_allocated_size -= buffer->allocation_size;
-  IREE_TRACE_PLOT_VALUE_I64(IREE_HAL_CACHING_ALLOCATOR_ID,
-                            pool->free_allocated_size);
+// Must be called with the cache mutex held.
+static iree_hal_buffer_t* iree_hal_caching_allocator_cache_take_buffer_at(
+    iree_hal_caching_allocator_pool_t* pool,
+    iree_hal_caching_allocator_cache_t* cache, uint32_t i) {
+  iree_hal_caching_allocator_entry_t* entry = &cache->entries[i];
+  iree_hal_buffer_t* buffer = entry->buffer;
+
+  // Unlink from the size class list.
+  if (entry->class_prev != IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE) {
+    cache->entries[entry->class_prev].class_next = entry->class_next;
+  } else {
+    cache->class_heads[entry->size_class] = entry->class_next;
+  }
+  if (entry->class_next != IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE) {
+    cache->entries[entry->class_next].class_prev = entry->class_prev;
+  }
+
+  // Unlink from the LRU list.
+  if (entry->lru_prev != IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE) {
+    cache->entries[entry->lru_prev].lru_next = entry->lru_next;
+  } else {
+    cache->lru_head = entry->lru_next;
+  }
+  if (entry->lru_next != IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE) {
+    cache->entries[entry->lru_next].lru_prev = entry->lru_prev;
+  } else {
+    cache->lru_tail = entry->lru_prev;
+  }
+
+  // Return the entry to the unused list.
+  entry->buffer = NULL;
+  entry->lru_next = cache->unused_head;
+  cache->unused_head = i;
+  --cache->count;
+
+  iree_hal_caching_allocator_pool_adjust_free_size(
+      pool, -(int64_t)iree_hal_buffer_allocation_size(buffer));
   return buffer;
 }
 
-// Scans the |pool| free list for a buffer matching the given requirements and
-// returns ownership.
+// Scans the |cache| size class list for a buffer matching the given
+// requirements and returns ownership. When the pool rounds to size classes the
+// first buffer with compatible memory types and usage is used; otherwise the
+// buffer must have exactly |allocation_size| bytes.
 //
-// Must be called with the pool mutex held.
-static iree_hal_buffer_t* iree_hal_caching_allocator_pool_find_and_take_buffer(
+// Must be called with the cache mutex held.
+static iree_hal_buffer_t* iree_hal_caching_allocator_cache_find_and_take_buffer(
     iree_hal_caching_allocator_pool_t* pool,
-    const iree_hal_buffer_params_t* params,
+    iree_hal_caching_allocator_cache_t* cache,
+    const iree_hal_buffer_params_t* params, uint32_t size_class,
     iree_device_size_t allocation_size) {
-  // Walk backwards so that we check the most recently released buffers first.
-  for (int i = (int)pool->free_count - 1; i >= 0; --i) {
+  const bool exact_size = pool->params.size_classes_per_doubling == 0;
+  // Walk the class list so that we check the most recently released buffers
+  // first.
+  for (uint32_t i = cache->class_heads[size_class];
+       i != IREE_HAL_CACHING_ALLOCATOR_ENTRY_NONE;
+       i = cache->entries[i].class_next) {
     // NOTE: we are not currently checking alignment as we don't really have it.
     // We assume programs will use consistent alignments for a particular heap
     // (as the heap has a min alignment).
-    iree_hal_buffer_t* buffer = pool->free_buffers[i];
+    iree_hal_buffer_t* buffer = cache->entries[i].buffer;
     if (iree_all_bits_set(iree_hal_buffer_memory_type(buffer), params->type) &&
         iree_all_bits_set(iree_hal_buffer_allowed_usage(buffer),
                           params->usage) &&
-        iree_hal_buffer_allocation_size(buffer) == allocation_size) {
-      return iree_hal_caching_allocator_pool_take_buffer_at(pool, i);
+        (!exact_size ||
+         iree_hal_buffer_allocation_size(buffer) == allocation_size)) {
+      return iree_hal_caching_allocator_cache_take_buffer_at(pool, cache, i);
     }
   }
   return NULL;  // nothing found
 }
 
-// Trims |pool| down to at most |target_size| of available allocations.
-// The oldest allocations will be trimmed first.
+// Trims |pool| until its total allocated size is at most |total_target_size|
+// and its free size is at most |free_target_size| or no free buffers remain.
+// The least recently released buffers of each cache will be trimmed first
+// starting with the cache at |first_cache_index|.
 //
 // Thread-safe; multiple threads may concurrently access the |pool|.
 static void iree_hal_caching_allocator_pool_trim_to_size(
-    iree_hal_caching_allocator_pool_t* pool, iree_device_size_t target_size) {
+    iree_hal_caching_allocator_pool_t* pool, iree_host_size_t first_cache_index,
+    iree_device_size_t total_target_size, iree_device_size_t free_target_size) {
   IREE_TRACE_ZONE_BEGIN(z0);
-  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (int64_t)target_size);
-
-  iree_slim_mutex_lock(&pool->mutex);
-
-  while (pool->free_count > 0 && pool->total_allocated_size > target_size) {
-    // Take the oldest buffer in the list.
-    iree_hal_buffer_t* dead_buffer =
-        iree_hal_caching_allocator_pool_take_buffer_at(pool,
-                                                       pool->free_count - 1);
-
-    // NOTE: we've removed the buffer but have not subtracted the size from
-    // the total yet - we want to do that only after releasing the buffer.
-    // If we didn't it's possible for another thread to start an allocation
-    // thinking that we've already released the buffer.
-    iree_device_size_t allocation_size =
-        iree_hal_buffer_allocation_size(dead_buffer);
-
-    // Release the buffer without holding the lock as deallocation can be slow.
-    iree_slim_mutex_unlock(&pool->mutex);
-    iree_hal_allocator_deallocate_buffer(pool->device_allocator, dead_buffer);
-    iree_slim_mutex_lock(&pool->mutex);
-
-    // Update accounting to represent that we've released the buffer.
-    IREE_ASSERT_GE(pool->total_allocated_size, allocation_size);
-    pool->total_allocated_size -= allocation_size;
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (int64_t)total_target_size);
+
+  for (iree_host_size_t i = 0; i < pool->cache_count; ++i) {
+    iree_hal_caching_allocator_cache_t* cache =
+        &pool->caches[(first_cache_index + i) % pool->cache_count];
+    iree_slim_mutex_lock(&cache->mutex);
+    while (cache->count > 0 &&
+           ((iree_device_size_t)iree_atomic_load(&pool->total_allocated_size,
+                                                 iree_memory_order_relaxed) >
+                total_target_size ||
+            (iree_device_size_t)iree_atomic_load(&pool->free_allocated_size,
+                                                 iree_memory_order_relaxed) >
+                free_target_size)) {
+      // Take the oldest buffer in the list.
+      iree_hal_buffer_t* dead_buffer =
+          iree_hal_caching_allocator_cache_take_buffer_at(pool, cache,
+                                                          cache->lru_head);
+
+      // NOTE: we've removed the buffer but have not subtracted the size from
+      // the total yet - we want to do that only after releasing the buffer.
+      // If we didn't it's possible for another thread to start an allocation
+      // thinking that we've already released the buffer.
+      iree_device_size_t allocation_size =
+          iree_hal_buffer_allocation_size(dead_buffer);
+
+      // Release the buffer without holding the lock as deallocation can be
+      // slow.
+      iree_slim_mutex_unlock(&cache->mutex);
+      iree_hal_allocator_deallocate_buffer(pool->device_allocator, dead_buffer);
+      iree_slim_mutex_lock(&cache->mutex);
+
+      // Update accounting to represent that we've released the buffer.
+      iree_atomic_fetch_sub(&pool->total_allocated_size,
+                            (int64_t)allocation_size,
+                            iree_memory_order_relaxed);
+    }
+    iree_slim_mutex_unlock(&cache->mutex);
   }
 
-  iree_slim_mutex_unlock(&pool->mutex);
-
   IREE_TRACE_ZONE_END(z0);
 }
 
 // Releases all unused buffers in |pool| to the underlying device allocator.
 //
-// The pool mutex must not be held by the caller.
+// No cache mutex may be held by the caller.
 static void iree_hal_caching_allocator_pool_trim(
     iree_hal_caching_allocator_pool_t* pool) {
-  iree_hal_caching_allocator_pool_trim_to_size(pool, 0);
+  iree_hal_caching_allocator_pool_trim_to_size(pool, 0, 0, 0);
 }
 
-// Acquires a buffer of |allocation_size| from the |pool|.
+// Acquires a buffer of at least |allocation_size| from the |pool|. When the
+// pool rounds to size classes the buffer has the full size of the class.
 // The buffer will have a memory type and usage compatible with the given types.
 // Fails if the pool is empty and the underlying device fails the allocation.
 //
@@ -244,18 +575,34 @@ static iree_status_t iree_hal_caching_allocator_pool_acquire(
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (int64_t)allocation_size);
 
-  // Scan the free list to find an appropriate block.
-  // If found we pop it off the list and return it without needing to allocate.
-  iree_slim_mutex_lock(&pool->mutex);
-  iree_hal_buffer_t* existing_buffer =
-      iree_hal_caching_allocator_pool_find_and_take_buffer(pool, params,
-                                                           allocation_size);
-  if (!existing_buffer) {
-    // We'll need to allocate so we add the size such that it'll be accounted
-    // for by other threads allocating at the same time.
-    pool->total_allocated_size += allocation_size;
-  }
-  iree_slim_mutex_unlock(&pool->mutex);
+  // Select the size class; in exact mode buffers are bucketed by the
+  // power-of-two class containing their size.
+  const bool round_size = pool->params.size_classes_per_doubling != 0;
+  const uint32_t size_class =
+      round_size ? iree_hal_caching_allocator_size_class_ceil(
+                       pool->classes_per_doubling, allocation_size)
+                 : iree_hal_caching_allocator_size_class_floor(
+                       pool->classes_per_doubling, allocation_size);
+  const iree_device_size_t class_size =
+      round_size ? iree_hal_caching_allocator_size_class_size(
+                       pool->classes_per_doubling, size_class)
+                 : allocation_size;
+
+  // Scan the free lists to find an appropriate block starting with the cache
+  // of the calling thread. If found we pop it off the list and return it
+  // without needing to allocate.
+  const iree_host_size_t home_cache_index =
+      iree_hal_caching_allocator_thread_ordinal() % pool->cache_count;
+  iree_hal_buffer_t* existing_buffer = NULL;
+  for (iree_host_size_t i = 0; i < pool->cache_count && !existing_buffer;
+       ++i) {
+    iree_hal_caching_allocator_cache_t* cache =
+        &pool->caches[(home_cache_index + i) % pool->cache_count];
+    iree_slim_mutex_lock(&cache->mutex);
+    existing_buffer = iree_hal_caching_allocator_cache_find_and_take_buffer(
+        pool, cache, params, size_class, allocation_size);
+    iree_slim_mutex_unlock(&cache->mutex);
+  }
   if (existing_buffer) {
     // Found a buffer! Return it uninitialized.
     *out_buffer = existing_buffer;
@@ -263,9 +610,15 @@ static iree_status_t iree_hal_caching_allocator_pool_acquire(
     return iree_ok_status();
   }
 
+  // We'll need to allocate so we add the size such that it'll be accounted
+  // for by other threads allocating at the same time.
+  iree_atomic_fetch_add(&pool->total_allocated_size, (int64_t)class_size,
+                        iree_memory_order_relaxed);
+
   // Trim first before allocating so that we don't go over peak.
   iree_hal_caching_allocator_pool_trim_to_size(
-      pool, pool->params.max_allocation_capacity);
+      pool, home_cache_index, pool->params.max_allocation_capacity,
+      IREE_DEVICE_SIZE_MAX);
 
   // No existing buffer was found that could be used and we'll need to allocate
   // one. Note that we do this without holding the lock as the underlying
@@ -273,16 +626,21 @@ static iree_status_t iree_hal_caching_allocator_pool_acquire(
   // to the pool by another thread while we're allocating here but that's OK.
   iree_hal_buffer_t* buffer = NULL;
   iree_status_t status = iree_hal_allocator_allocate_buffer(
-      pool->device_allocator, *params, allocation_size, &buffer);
+      pool->device_allocator, *params, class_size, &buffer);
 
-  // If the allocation failed then remove the size from the total.
   if (iree_status_is_ok(status)) {
+    // The underlying allocator may have padded the allocation; account for
+    // what it actually allocated as that is what will be released.
+    iree_atomic_fetch_add(
+        &pool->total_allocated_size,
+        (int64_t)iree_hal_buffer_allocation_size(buffer) - (int64_t)class_size,
+        iree_memory_order_relaxed);
     *out_buffer = buffer;
   } else {
+    // If the allocation failed then remove the size from the total.
     if (buffer) iree_hal_buffer_release(buffer);
-    iree_slim_mutex_lock(&pool->mutex);
-    pool->total_allocated_size -= allocation_size;
-    iree_slim_mutex_unlock(&pool->mutex);
+    iree_atomic_fetch_sub(&pool->total_allocated_size, (int64_t)class_size,
+                          iree_memory_order_relaxed);
   }
 
   IREE_TRACE_ZONE_END(z0);
@@ -290,6 +648,8 @@ static iree_status_t iree_hal_caching_allocator_pool_acquire(
 }
 
 // Releases a |buffer| to the |pool| if there is capacity remaining.
+// If the pool free size exceeds the high-water mark afterward the least
+// recently released buffers are trimmed.
 //
 // Thread-safe; multiple threads may concurrently access the |pool|.
 static void iree_hal_caching_allocator_pool_release(
@@ -298,31 +658,60 @@ static void iree_hal_caching_allocator_pool_release(
   IREE_TRACE_ZONE_APPEND_VALUE_I64(
       z0, (int64_t)iree_hal_buffer_allocation_size(buffer));
 
-  // Try to add the buffer to the pool. If the pool is at capacity we'll just
-  // release it back to the allocator.
-  iree_slim_mutex_lock(&pool->mutex);
-
   const iree_device_size_t allocation_size =
       iree_hal_buffer_allocation_size(buffer);
-  const bool under_capacity = pool->total_allocated_size - allocation_size <=
-                              pool->params.max_allocation_capacity;
-  const bool under_count =
-      pool->free_count + 1 <= pool->params.max_free_allocation_count;
-  if (under_capacity && under_count) {
-    iree_hal_caching_allocator_pool_push_buffer(pool, buffer);
-    buffer = NULL;
+  const iree_host_size_t home_cache_index =
+      iree_hal_caching_allocator_thread_ordinal() % pool->cache_count;
+  iree_hal_caching_allocator_cache_t* cache = &pool->caches[home_cache_index];
+
+  // Try to add the buffer to the cache. If the pool is at capacity we'll just
+  // release it back to the allocator. If the cache is full the least recently
+  // released buffer is evicted to make room.
+  iree_slim_mutex_lock(&cache->mutex);
+  const bool under_capacity =
+      (iree_device_size_t)iree_atomic_load(&pool->total_allocated_size,
+                                           iree_memory_order_relaxed) -
+          allocation_size <=
+      pool->params.max_allocation_capacity;
+  const bool under_free_capacity =
+      allocation_size <= pool->params.max_free_capacity;
+  iree_hal_buffer_t* dead_buffer = NULL;
+  if (under_capacity && under_free_capacity && cache->capacity > 0) {
+    if (cache->count == cache->capacity) {
+      dead_buffer = iree_hal_caching_allocator_cache_take_buffer_at(
+          pool, cache, cache->lru_head);
+    }
+    const uint32_t size_class = iree_min(
+        iree_hal_caching_allocator_size_class_floor(pool->classes_per_doubling,
+                                                    allocation_size),
+        pool->class_count - 1);
+    iree_hal_caching_allocator_cache_push_buffer(pool, cache, size_class,
+                                                 buffer);
+  } else {
+    dead_buffer = buffer;
   }
+  buffer = NULL;
+  iree_slim_mutex_unlock(&cache->mutex);
 
-  // If the buffer didn't fit in the pool we drop it here while we don't hold
+  // If a buffer didn't fit in the pool we drop it here while we don't hold
   // the lock as deallocations can be very expensive.
-  if (buffer) {
-    iree_slim_mutex_unlock(&pool->mutex);
-    iree_hal_allocator_deallocate_buffer(pool->device_allocator, buffer);
-    iree_slim_mutex_lock(&pool->mutex);
-    pool->total_allocated_size -= allocation_size;
+  if (dead_buffer) {
+    const iree_device_size_t dead_allocation_size =
+        iree_hal_buffer_allocation_size(dead_buffer);
+    iree_hal_allocator_deallocate_buffer(pool->device_allocator, dead_buffer);
+    iree_atomic_fetch_sub(&pool->total_allocated_size,
+                          (int64_t)dead_allocation_size,
+                          iree_memory_order_relaxed);
   }
 
-  iree_slim_mutex_unlock(&pool->mutex);
+  // Keep the free size under the high-water mark.
+  if ((iree_device_size_t)iree_atomic_load(&pool->free_allocated_size,
+                                           iree_memory_order_relaxed) >
+      pool->params.max_free_capacity) {
+    iree_hal_caching_allocator_pool_trim_to_size(
+        pool, home_cache_index, IREE_DEVICE_SIZE_MAX,
+        pool->params.max_free_capacity);
+  }
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -404,11 +793,10 @@ iree_status_t iree_hal_caching_allocator_create_with_pools(
       iree_sizeof_struct(*allocator) + pool_list_size, iree_max_align_t);
   iree_host_size_t pool_offset = total_size;
   for (iree_host_size_t i = 0; i < pool_count; ++i) {
-    iree_hal_caching_allocator_pool_t* pool = NULL;
-    total_size += iree_host_align(
-        sizeof(*pool) + sizeof(pool->free_buffers[0]) *
-                            pool_params[i].max_free_allocation_count,
-        iree_max_align_t);
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_hal_caching_allocator_pool_params_verify(&pool_params[i]));
+    total_size +=
+        iree_hal_caching_allocator_pool_storage_size(&pool_params[i]);
   }
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0,
@@ -427,10 +815,7 @@ iree_status_t iree_hal_caching_allocator_create_with_pools(
   for (iree_host_size_t i = 0; i < pool_count; ++i) {
     iree_hal_caching_allocator_pool_t* pool =
         (iree_hal_caching_allocator_pool_t*)pool_ptr;
-    pool_ptr += iree_host_align(
-        sizeof(*pool) + sizeof(pool->free_buffers[0]) *
-                            pool_params[i].max_free_allocation_count,
-        iree_max_align_t);
+    pool_ptr += iree_hal_caching_allocator_pool_storage_size(&pool_params[i]);
     allocator->pools[i] = pool;
     iree_hal_caching_allocator_pool_initialize(pool_params[i], device_allocator,
                                                pool);
@@ -547,12 +932,21 @@ iree_status_t iree_hal_caching_allocator_create_from_spec(
     iree_string_view_t max_allocation_size_str = iree_string_view_empty();
     iree_string_view_t max_allocation_capacity_str = iree_string_view_empty();
     iree_string_view_t max_free_allocation_count_str = iree_string_view_empty();
+    iree_string_view_t size_classes_per_doubling_str = iree_string_view_empty();
+    iree_string_view_t max_free_capacity_str = iree_string_view_empty();
+    iree_string_view_t thread_cache_count_str = iree_string_view_empty();
     iree_string_view_split(pool_config, ';', &max_allocation_size_str,
                            &pool_config);
     iree_string_view_split(pool_config, ';', &max_allocation_capacity_str,
                            &pool_config);
     iree_string_view_split(pool_config, ';', &max_free_allocation_count_str,
                            &pool_config);
+    iree_string_view_split(pool_config, ';', &size_classes_per_doubling_str,
+                           &pool_config);
+    iree_string_view_split(pool_config, ';', &max_free_capacity_str,
+                           &pool_config);
+    iree_string_view_split(pool_config, ';', &thread_cache_count_str,
+                           &pool_config);
     max_allocation_size_str = iree_string_view_trim(max_allocation_size_str);
     if (!iree_string_view_is_empty(max_allocation_size_str) &&
         !iree_string_view_equal(max_allocation_size_str, IREE_SV("*"))) {
@@ -584,6 +978,40 @@ iree_status_t iree_hal_caching_allocator_create_from_spec(
       }
       pool_params->max_free_allocation_count = max_free_allocation_count;
     }
+    size_classes_per_doubling_str =
+        iree_string_view_trim(size_classes_per_doubling_str);
+    if (!iree_string_view_is_empty(size_classes_per_doubling_str) &&
+        !iree_string_view_equal(size_classes_per_doubling_str, IREE_SV("*"))) {
+      if (!iree_string_view_atoi_uint32(
+              size_classes_per_doubling_str,
+              &pool_params->size_classes_per_doubling)) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "invalid size class count '%.*s'",
+                                (int)size_classes_per_doubling_str.size,
+                                size_classes_per_doubling_str.data);
+      }
+    }
+    max_free_capacity_str = iree_string_view_trim(max_free_capacity_str);
+    if (!iree_string_view_is_empty(max_free_capacity_str) &&
+        !iree_string_view_equal(max_free_capacity_str, IREE_SV("*"))) {
+      IREE_RETURN_IF_ERROR(
+          iree_string_view_parse_device_size(max_free_capacity_str,
+                                             &pool_params->max_free_capacity),
+          "parsing max_free_capacity");
+    }
+    thread_cache_count_str = iree_string_view_trim(thread_cache_count_str);
+    if (!iree_string_view_is_empty(thread_cache_count_str) &&
+        !iree_string_view_equal(thread_cache_count_str, IREE_SV("*"))) {
+      uint32_t thread_cache_count = 0;
+      if (!iree_string_view_atoi_uint32(thread_cache_count_str,
+                                        &thread_cache_count)) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "invalid thread cache count '%.*s'",
+                                (int)thread_cache_count_str.size,
+                                thread_cache_count_str.data);
+      }
+      pool_params->thread_cache_count = thread_cache_count;
+    }
   } while (!iree_string_view_is_empty(config_pairs));
   return iree_hal_caching_allocator_create_with_pools(
       pool_count, pool_params_storage, device_allocator, host_allocator,
@@ -718,7 +1146,9 @@ static iree_status_t iree_hal_caching_allocator_allocate_buffer(
   iree_hal_caching_allocator_pool_t* pool =
       iree_hal_caching_allocator_find_pool(allocator, compat_params.type,
                                            compat_params.usage);
-  if (!pool) {
+  if (!pool || allocation_size > pool->params.max_allocation_size ||
+      allocation_size >
+          (1ull << IREE_HAL_CACHING_ALLOCATOR_MAX_SIZE_CLASS_SHIFT)) {
     // Fallback to the underlying allocator.
     return iree_hal_allocator_allocate_buffer(allocator->device_allocator,
                                               compat_params, allocation_size,
@@ -726,13 +1156,22 @@ static iree_status_t iree_hal_caching_allocator_allocate_buffer(
   }
 
   // Acquire the buffer from the pool.
+  iree_hal_buffer_t* pooled_buffer = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_caching_allocator_pool_acquire(
-      pool, &compat_params, allocation_size, out_buffer));
+      pool, &compat_params, allocation_size, &pooled_buffer));
 
   // Point the buffer back to us for deallocation.
-  (*out_buffer)->device_allocator = base_allocator;
-
-  return iree_ok_status();
+  pooled_buffer->device_allocator = base_allocator;
+
+  // Buffers rounded up to their size class are returned as a subspan of the
+  // requested length so that the buffer owned by the underlying allocator
+  // keeps its original length. The pooled buffer is returned to the pool when
+  // the subspan is released. Buffers of exactly the requested length are
+  // returned directly.
+  iree_status_t status =
+      iree_hal_buffer_subspan(pooled_buffer, 0, allocation_size, out_buffer);
+  iree_hal_buffer_release(pooled_buffer);
+  return status;
 }
 
 static void iree_hal_caching_allocator_deallocate_buffer(
@@ -22,6 +22,14 @@ extern "C" {
 // device-local and host-visible buffers on devices with discrete memory.
 // Pools are scanned in-order to allow for prioritization.
 //
+// Free buffers are bucketed by size class so that acquiring and releasing a
+// buffer is O(1) regardless of how many buffers are cached. By default only
+// buffers of exactly the requested size are reused. Pools can instead round
+// allocations up to geometric size classes so that workloads with dynamic
+// shapes (such as LLMs where transient sizes change with sequence length) can
+// reuse buffers of nearby sizes at the cost of some internal fragmentation.
+// Rounded allocations are returned as subspans of the requested length.
+//
 // Thread-safe: the allocator can be shared across multiple user-level devices
 // manipulated from multiple threads.
 typedef struct iree_hal_caching_allocator_t iree_hal_caching_allocator_t;
@@ -47,8 +55,29 @@ typedef struct iree_hal_caching_allocator_pool_params_t {
 
   // Maximum number of free allocations that will be tracked.
   // This is used to allocate storage for the free list and should be reasonably
-  // bounded (~64-1024).
+  // bounded (~64-1024). When shared by multiple thread caches each cache
+  // tracks an equal share of the free allocations.
   iree_host_size_t max_free_allocation_count;
+
+  // Number of size classes each power-of-two range of allocation sizes is
+  // divided into. Allocations are rounded up to their size class so that
+  // buffers can be reused by any request in the same class. Must be 0 or a
+  // power of two no larger than 16. 0 disables rounding and only reuses
+  // buffers of exactly the requested size; 1 uses power-of-two classes with up
+  // to 50% waste, 4 classes bound waste to 20%, and so on.
+  uint32_t size_classes_per_doubling;
+
+  // Maximum total size of free allocations retained by the pool. When released
+  // buffers would exceed this high-water mark the least recently used free
+  // buffers are released to the underlying allocator until the pool is back
+  // under the limit.
+  iree_device_size_t max_free_capacity;
+
+  // Number of independent free lists used to reduce contention when multiple
+  // threads allocate and free concurrently. Each thread prefers the free list
+  // assigned to it and falls back to the others before allocating new
+  // buffers. 0 or 1 uses a single shared free list.
+  iree_host_size_t thread_cache_count;
 } iree_hal_caching_allocator_pool_params_t;
 
 // Initializes |out_params| to the default values using |heap| for storage.
@@ -102,9 +131,12 @@ iree_status_t iree_hal_caching_allocator_create_with_pools(
 //
 // Expected form:
 //   heap_key=max_allocation_size;max_allocation_capacity;max_free_allocation_count
+// Optionally followed by any of:
+//   ;size_classes_per_doubling;max_free_capacity;thread_cache_count
 // Example:
 //   device_local=1gib;1gib;8
 //   host_local=*;*;32
+//   device_local=*;8gib;1024;4;2gib;8
 iree_status_t iree_hal_caching_allocator_create_from_spec(
     iree_string_view_t config_pairs, iree_hal_allocator_t* device_allocator,
     iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator);
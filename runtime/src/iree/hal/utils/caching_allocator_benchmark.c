@@ -0,0 +1,360 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Replays buffer allocation traces against the caching allocator.
+//
+// Built-in traces are modeled on the allocation patterns of real programs:
+//   llm_decode: transformer decode where transient sizes grow with the context
+//               length each token (dynamic shapes).
+//   cnn_static: a fixed sequence of convolution activations (static shapes).
+//
+// Traces recorded from other programs can be replayed with --trace_file. Each
+// line of the file is one event and lines starting with `#` are ignored:
+//   alloc <id> <size>  allocates a buffer of <size> bytes into slot <id>
+//   free <id>          releases the buffer in slot <id>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/file_io.h"
+#include "iree/base/internal/flags.h"
+#include "iree/hal/api.h"
+#include "iree/hal/utils/caching_allocator.h"
+#include "iree/testing/benchmark.h"
+
+IREE_FLAG(string, trace_file, "",
+          "Allocation trace file to replay along with the built-in traces.");
+
+//===----------------------------------------------------------------------===//
+// Allocation traces
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_trace_event_t {
+  // Slot the buffer is stored in between allocation and free.
+  uint32_t slot;
+  // Allocation size in bytes or 0 to free the buffer in the slot.
+  iree_device_size_t size;
+} iree_trace_event_t;
+
+typedef struct iree_trace_t {
+  iree_host_size_t event_count;
+  iree_host_size_t event_capacity;
+  iree_trace_event_t* events;
+  // One more than the largest slot referenced.
+  uint32_t slot_count;
+} iree_trace_t;
+
+static void iree_trace_deinitialize(iree_trace_t* trace) {
+  iree_allocator_free(iree_allocator_system(), trace->events);
+  memset(trace, 0, sizeof(*trace));
+}
+
+static void iree_trace_append(iree_trace_t* trace, uint32_t slot,
+                              iree_device_size_t size) {
+  if (trace->event_count == trace->event_capacity) {
+    trace->event_capacity = iree_max(1024, trace->event_capacity * 2);
+    IREE_CHECK_OK(iree_allocator_realloc(
+        iree_allocator_system(),
+        trace->event_capacity * sizeof(trace->events[0]),
+        (void**)&trace->events));
+  }
+  trace->events[trace->event_count++] = (iree_trace_event_t){
+      .slot = slot,
+      .size = size,
+  };
+  trace->slot_count = iree_max(trace->slot_count, slot + 1);
+}
+
+// Simple slot assignment for generated traces: slots are reused LIFO.
+typedef struct iree_trace_builder_t {
+  iree_trace_t* trace;
+  uint32_t free_slot_count;
+  uint32_t free_slots[256];
+} iree_trace_builder_t;
+
+static uint32_t iree_trace_builder_alloc(iree_trace_builder_t* builder,
+                                         iree_device_size_t size) {
+  uint32_t slot = builder->free_slot_count
+                      ? builder->free_slots[--builder->free_slot_count]
+                      : builder->trace->slot_count;
+  iree_trace_append(builder->trace, slot, size);
+  return slot;
+}
+
+static void iree_trace_builder_free(iree_trace_builder_t* builder,
+                                    uint32_t slot) {
+  iree_trace_append(builder->trace, slot, 0);
+  IREE_ASSERT_LT(builder->free_slot_count,
+                 IREE_ARRAYSIZE(builder->free_slots));
+  builder->free_slots[builder->free_slot_count++] = slot;
+}
+
+// Models the transients of a 7B-class transformer decoding 256 tokens with f16
+// activations. Attention score sizes grow with the context length so exact-size
+// reuse only hits for the fixed-size activations.
+static void iree_trace_generate_llm_decode(iree_trace_t* trace) {
+  const iree_device_size_t hidden = 4096;
+  const iree_device_size_t intermediate = 11008;
+  const iree_device_size_t heads = 32;
+  const iree_device_size_t vocab = 32000;
+  const int layer_count = 8;
+  const int token_count = 256;
+  iree_trace_builder_t builder = {.trace = trace};
+  for (int token = 0; token < token_count; ++token) {
+    const iree_device_size_t context = 128 + token;
+    uint32_t residual = iree_trace_builder_alloc(&builder, hidden * 2);
+    for (int layer = 0; layer < layer_count; ++layer) {
+      uint32_t norm = iree_trace_builder_alloc(&builder, hidden * 2);
+      uint32_t qkv = iree_trace_builder_alloc(&builder, 3 * hidden * 2);
+      uint32_t scores = iree_trace_builder_alloc(&builder, heads * context * 4);
+      uint32_t probs = iree_trace_builder_alloc(&builder, heads * context * 2);
+      iree_trace_builder_free(&builder, scores);
+      uint32_t attn = iree_trace_builder_alloc(&builder, hidden * 2);
+      iree_trace_builder_free(&builder, probs);
+      iree_trace_builder_free(&builder, qkv);
+      uint32_t proj = iree_trace_builder_alloc(&builder, hidden * 2);
+      iree_trace_builder_free(&builder, attn);
+      iree_trace_builder_free(&builder, norm);
+      uint32_t up = iree_trace_builder_alloc(&builder, 2 * intermediate * 2);
+      uint32_t act = iree_trace_builder_alloc(&builder, intermediate * 2);
+      iree_trace_builder_free(&builder, up);
+      uint32_t down = iree_trace_builder_alloc(&builder, hidden * 2);
+      iree_trace_builder_free(&builder, act);
+      iree_trace_builder_free(&builder, proj);
+      iree_trace_builder_free(&builder, residual);
+      residual = down;
+    }
+    uint32_t logits = iree_trace_builder_alloc(&builder, vocab * 4);
+    iree_trace_builder_free(&builder, residual);
+    iree_trace_builder_free(&builder, logits);
+  }
+}
+
+// Models a ResNet-style CNN with static shapes: each stage halves the spatial
+// size and doubles the channels of the f32 activations.
+static void iree_trace_generate_cnn_static(iree_trace_t* trace) {
+  iree_trace_builder_t builder = {.trace = trace};
+  iree_device_size_t spatial = 112 * 112;
+  iree_device_size_t channels = 64;
+  uint32_t input = iree_trace_builder_alloc(&builder, 224 * 224 * 3 * 4);
+  for (int stage = 0; stage < 4; ++stage) {
+    for (int block = 0; block < 3; ++block) {
+      uint32_t conv0 =
+          iree_trace_builder_alloc(&builder, spatial * channels * 4);
+      uint32_t conv1 =
+          iree_trace_builder_alloc(&builder, spatial * channels * 4);
+      iree_trace_builder_free(&builder, conv0);
+      uint32_t output =
+          iree_trace_builder_alloc(&builder, spatial * channels * 4);
+      iree_trace_builder_free(&builder, conv1);
+      iree_trace_builder_free(&builder, input);
+      input = output;
+    }
+    spatial /= 4;
+    channels *= 2;
+  }
+  iree_trace_builder_free(&builder, input);
+}
+
+// Parses a trace file in the format described at the top of this file.
+static iree_status_t iree_trace_load_file(const char* path,
+                                          iree_trace_t* trace) {
+  iree_file_contents_t* contents = NULL;
+  IREE_RETURN_IF_ERROR(iree_file_read_contents(
+      path, IREE_FILE_READ_FLAG_DEFAULT, iree_allocator_system(), &contents));
+  iree_string_view_t remaining =
+      iree_make_string_view((const char*)contents->const_buffer.data,
+                            contents->const_buffer.data_length);
+  iree_status_t status = iree_ok_status();
+  while (iree_status_is_ok(status) && !iree_string_view_is_empty(remaining)) {
+    iree_string_view_t line = iree_string_view_empty();
+    iree_string_view_split(remaining, '\n', &line, &remaining);
+    line = iree_string_view_trim(line);
+    if (iree_string_view_is_empty(line) ||
+        iree_string_view_starts_with(line, IREE_SV("#"))) {
+      continue;
+    }
+    iree_string_view_t op = iree_string_view_empty();
+    iree_string_view_t args = iree_string_view_empty();
+    iree_string_view_split(line, ' ', &op, &args);
+    iree_string_view_t slot_str = iree_string_view_empty();
+    iree_string_view_t size_str = iree_string_view_empty();
+    iree_string_view_split(iree_string_view_trim(args), ' ', &slot_str,
+                           &size_str);
+    uint32_t slot = 0;
+    uint64_t size = 0;
+    if (!iree_string_view_atoi_uint32(slot_str, &slot)) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "invalid trace slot in '%.*s'", (int)line.size,
+                                line.data);
+    } else if (iree_string_view_equal(op, IREE_SV("alloc")) &&
+               iree_string_view_atoi_uint64(iree_string_view_trim(size_str),
+                                            &size) &&
+               size > 0) {
+      iree_trace_append(trace, slot, (iree_device_size_t)size);
+    } else if (iree_string_view_equal(op, IREE_SV("free"))) {
+      iree_trace_append(trace, slot, 0);
+    } else {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "invalid trace event '%.*s'", (int)line.size,
+                                line.data);
+    }
+  }
+  iree_file_contents_free(contents);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// Trace replay
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_trace_benchmark_t {
+  const iree_trace_t* trace;
+  // Caching allocator pool config or NULL to use the heap allocator directly.
+  const char* pool_config;
+} iree_trace_benchmark_t;
+
+static iree_status_t iree_hal_caching_allocator_benchmark_replay(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_trace_benchmark_t* benchmark =
+      (const iree_trace_benchmark_t*)benchmark_def->user_data;
+  const iree_trace_t* trace = benchmark->trace;
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+
+  iree_hal_allocator_t* heap_allocator = NULL;
+  IREE_CHECK_OK(iree_hal_allocator_create_heap(IREE_SV("heap"), host_allocator,
+                                               host_allocator,
+                                               &heap_allocator));
+  iree_hal_allocator_t* allocator = heap_allocator;
+  iree_hal_allocator_retain(allocator);
+  if (benchmark->pool_config) {
+    iree_hal_allocator_release(allocator);
+    IREE_CHECK_OK(iree_hal_caching_allocator_create_from_spec(
+        iree_make_cstring_view(benchmark->pool_config), heap_allocator,
+        host_allocator, &allocator));
+  }
+
+  iree_hal_buffer_t** slots = NULL;
+  IREE_CHECK_OK(iree_allocator_malloc(host_allocator,
+                                      trace->slot_count * sizeof(slots[0]),
+                                      (void**)&slots));
+
+  iree_hal_buffer_params_t params = {
+      .type = IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+      .usage = IREE_HAL_BUFFER_USAGE_DEFAULT,
+  };
+  int64_t replay_count = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    for (iree_host_size_t i = 0; i < trace->event_count; ++i) {
+      const iree_trace_event_t* event = &trace->events[i];
+      if (event->size) {
+        IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+            allocator, params, event->size, &slots[event->slot]));
+      } else {
+        iree_hal_buffer_release(slots[event->slot]);
+        slots[event->slot] = NULL;
+      }
+    }
+    ++replay_count;
+  }
+  iree_benchmark_set_items_processed(
+      benchmark_state, replay_count * (int64_t)trace->event_count);
+
+  // Release any buffers the trace left live.
+  for (uint32_t i = 0; i < trace->slot_count; ++i) {
+    iree_hal_buffer_release(slots[i]);
+  }
+  iree_allocator_free(host_allocator, slots);
+
+#if IREE_STATISTICS_ENABLE
+  // Report the peak memory allocated from the underlying allocator to show
+  // the cost of caching and size class rounding.
+  iree_hal_allocator_statistics_t statistics;
+  iree_hal_allocator_query_statistics(heap_allocator, &statistics);
+  char label[64];
+  snprintf(label, sizeof(label), "peak=%.1fMiB",
+           statistics.device_bytes_peak / (1024.0 * 1024.0));
+  iree_benchmark_set_label(benchmark_state, label);
+#endif  // IREE_STATISTICS_ENABLE
+
+  iree_hal_allocator_release(allocator);
+  iree_hal_allocator_release(heap_allocator);
+  return iree_ok_status();
+}
+
+static void iree_hal_caching_allocator_benchmark_register_trace(
+    const char* trace_name, const iree_trace_t* trace,
+    iree_trace_benchmark_t benchmarks[4]) {
+  static const struct {
+    const char* name;
+    const char* pool_config;
+  } configs[4] = {
+      // No caching; every allocation goes to the heap allocator.
+      {"heap", NULL},
+      // Exact-size reuse only.
+      {"exact", "*=*;*;1024"},
+      // Power-of-two size classes.
+      {"pow2", "*=*;*;1024;1"},
+      // Geometric size classes with 4 classes per doubling.
+      {"geometric4", "*=*;*;1024;4"},
+  };
+  for (int i = 0; i < IREE_ARRAYSIZE(configs); ++i) {
+    benchmarks[i] = (iree_trace_benchmark_t){
+        .trace = trace,
+        .pool_config = configs[i].pool_config,
+    };
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_hal_caching_allocator_benchmark_replay,
+        .user_data = &benchmarks[i],
+    };
+    char name[128];
+    snprintf(name, sizeof(name), "replay_%s/%s", trace_name, configs[i].name);
+    iree_benchmark_register(iree_make_cstring_view(name), &benchmark_def);
+  }
+}
+
+int main(int argc, char** argv) {
+  iree_flags_parse_checked(IREE_FLAGS_PARSE_MODE_UNDEFINED_OK |
+                               IREE_FLAGS_PARSE_MODE_CONTINUE_AFTER_HELP,
+                           &argc, &argv);
+  iree_benchmark_initialize(&argc, argv);
+
+  iree_trace_t llm_decode_trace = {0};
+  iree_trace_generate_llm_decode(&llm_decode_trace);
+  iree_trace_benchmark_t llm_decode_benchmarks[4];
+  iree_hal_caching_allocator_benchmark_register_trace(
+      "llm_decode", &llm_decode_trace, llm_decode_benchmarks);
+
+  iree_trace_t cnn_static_trace = {0};
+  iree_trace_generate_cnn_static(&cnn_static_trace);
+  iree_trace_benchmark_t cnn_static_benchmarks[4];
+  iree_hal_caching_allocator_benchmark_register_trace(
+      "cnn_static", &cnn_static_trace, cnn_static_benchmarks);
+
+  iree_trace_t file_trace = {0};
+  iree_trace_benchmark_t file_benchmarks[4];
+  if (strlen(FLAG_trace_file) > 0) {
+    IREE_CHECK_OK(iree_trace_load_file(FLAG_trace_file, &file_trace));
+    iree_hal_caching_allocator_benchmark_register_trace("file", &file_trace,
+                                                        file_benchmarks);
+  }
+
+  iree_benchmark_run_specified();
+
+  iree_trace_deinitialize(&file_trace);
+  iree_trace_deinitialize(&cnn_static_trace);
+  iree_trace_deinitialize(&llm_decode_trace);
+  return 0;
+}
@@ -0,0 +1,401 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/caching_allocator.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+// Tracks the number of live allocations made from the system allocator.
+// Used as the data allocator of the underlying heap allocator such that each
+// live allocation is one buffer owned by the underlying allocator.
+struct CountingAllocator {
+  iree_host_size_t live_count = 0;
+
+  static iree_status_t Ctl(void* self, iree_allocator_command_t command,
+                           const void* params, void** inout_ptr) {
+    auto* allocator = reinterpret_cast<CountingAllocator*>(self);
+    const bool is_new = command == IREE_ALLOCATOR_COMMAND_MALLOC ||
+                        command == IREE_ALLOCATOR_COMMAND_CALLOC ||
+                        (command == IREE_ALLOCATOR_COMMAND_REALLOC &&
+                         *inout_ptr == NULL);
+    iree_allocator_t system_allocator = iree_allocator_system();
+    IREE_RETURN_IF_ERROR(
+        system_allocator.ctl(system_allocator.self, command, params, inout_ptr));
+    if (is_new) {
+      ++allocator->live_count;
+    } else if (command == IREE_ALLOCATOR_COMMAND_FREE) {
+      --allocator->live_count;
+    }
+    return iree_ok_status();
+  }
+
+  iree_allocator_t allocator() { return {this, Ctl}; }
+};
+
+class CachingAllocatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        IREE_SV("heap"), data_allocator_.allocator(), iree_allocator_system(),
+        &device_allocator_));
+    iree_host_size_t heap_count = 0;
+    IREE_ASSERT_OK(iree_hal_allocator_query_memory_heaps(
+        device_allocator_, 1, &heap_, &heap_count));
+    ASSERT_EQ(heap_count, 1u);
+  }
+
+  void TearDown() override {
+    iree_hal_allocator_release(allocator_);
+    iree_hal_allocator_release(device_allocator_);
+    EXPECT_EQ(data_allocator_.live_count, 0u);
+  }
+
+  // Returns pool params for the heap with a single thread cache.
+  iree_hal_caching_allocator_pool_params_t PoolParams() {
+    iree_hal_caching_allocator_pool_params_t params;
+    iree_hal_caching_allocator_pool_params_initialize(heap_, &params);
+    params.thread_cache_count = 1;
+    return params;
+  }
+
+  void CreateAllocator(iree_hal_caching_allocator_pool_params_t params) {
+    IREE_ASSERT_OK(iree_hal_caching_allocator_create_with_pools(
+        1, &params, device_allocator_, iree_allocator_system(), &allocator_));
+  }
+
+  iree_hal_buffer_t* Allocate(iree_device_size_t size) {
+    iree_hal_buffer_params_t params = {0};
+    params.type =
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+    params.access = IREE_HAL_MEMORY_ACCESS_ALL;
+    params.usage =
+        IREE_HAL_BUFFER_USAGE_DEFAULT | IREE_HAL_BUFFER_USAGE_MAPPING;
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(
+        iree_hal_allocator_allocate_buffer(allocator_, params, size, &buffer));
+    return buffer;
+  }
+
+  // Returns the buffer owned by the underlying allocator backing |buffer|.
+  static iree_hal_buffer_t* Pooled(iree_hal_buffer_t* buffer) {
+    return iree_hal_buffer_allocated_buffer(buffer);
+  }
+
+  // Number of buffers currently owned by the underlying allocator.
+  iree_host_size_t live_count() const { return data_allocator_.live_count; }
+
+  CountingAllocator data_allocator_;
+  iree_hal_allocator_t* device_allocator_ = NULL;
+  iree_hal_allocator_memory_heap_t heap_;
+  iree_hal_allocator_t* allocator_ = NULL;
+};
+
+// Tests that rounded sizes bound waste and that a buffer of each class size
+// is reused by requests for the class size itself: the class a buffer is
+// released into must match the class its own size is requested from.
+TEST_F(CachingAllocatorTest, SizeClassRoundTrip) {
+  for (uint32_t classes_per_doubling : {1u, 2u, 4u, 16u}) {
+    auto params = PoolParams();
+    params.size_classes_per_doubling = classes_per_doubling;
+    CreateAllocator(params);
+    for (iree_device_size_t size = 1; size < 4 * 1024 * 1024;
+         size += size / 7 + 1) {
+      iree_hal_buffer_t* buffer = Allocate(size);
+      const iree_device_size_t class_size =
+          iree_hal_buffer_allocation_size(buffer);
+      EXPECT_EQ(iree_hal_buffer_byte_length(buffer), size);
+      EXPECT_GE(class_size, size);
+      EXPECT_LE(class_size,
+                std::max<iree_device_size_t>(
+                    256, size + size / classes_per_doubling))
+          << "classes " << classes_per_doubling << " size " << size;
+      // The buffer owned by the underlying allocator keeps its full length.
+      EXPECT_EQ(iree_hal_buffer_byte_length(Pooled(buffer)), class_size);
+      iree_hal_buffer_t* pooled_buffer = Pooled(buffer);
+      iree_hal_buffer_release(buffer);
+
+      // Requesting the class size is serviced by the same buffer.
+      buffer = Allocate(class_size);
+      EXPECT_EQ(Pooled(buffer), pooled_buffer)
+          << "classes " << classes_per_doubling << " size " << size;
+      EXPECT_EQ(iree_hal_buffer_allocation_size(buffer), class_size);
+      EXPECT_EQ(iree_hal_buffer_byte_length(buffer), class_size);
+      iree_hal_buffer_release(buffer);
+    }
+    iree_hal_allocator_release(allocator_);
+    allocator_ = NULL;
+    EXPECT_EQ(live_count(), 0u);
+  }
+}
+
+TEST_F(CachingAllocatorTest, ReuseWithinClass) {
+  auto params = PoolParams();
+  params.size_classes_per_doubling = 4;
+  CreateAllocator(params);
+
+  // (896, 1024] is one class and (768, 896] the one below it.
+  iree_hal_buffer_t* buffer = Allocate(1000);
+  EXPECT_EQ(iree_hal_buffer_allocation_size(buffer), 1024u);
+  iree_hal_buffer_t* pooled_buffer = Pooled(buffer);
+  iree_hal_buffer_release(buffer);
+  EXPECT_EQ(live_count(), 1u);
+
+  iree_hal_buffer_t* same_class = Allocate(900);
+  EXPECT_EQ(Pooled(same_class), pooled_buffer);
+  EXPECT_EQ(iree_hal_buffer_byte_length(same_class), 900u);
+  EXPECT_EQ(live_count(), 1u);
+
+  // Contents written through the subspan land at the start of the buffer.
+  const uint32_t pattern = 0xCAFEF00Du;
+  IREE_ASSERT_OK(iree_hal_buffer_map_write(same_class, 896, &pattern,
+                                           sizeof(pattern)));
+  uint32_t readback = 0;
+  IREE_ASSERT_OK(iree_hal_buffer_map_read(pooled_buffer, 896, &readback,
+                                          sizeof(readback)));
+  EXPECT_EQ(readback, pattern);
+  // Access beyond the requested length is rejected.
+  EXPECT_THAT(Status(iree_hal_buffer_map_write(same_class, 900, &pattern,
+                                               sizeof(pattern))),
+              StatusIs(StatusCode::kOutOfRange));
+
+  iree_hal_buffer_t* lower_class = Allocate(890);
+  EXPECT_NE(Pooled(lower_class), pooled_buffer);
+  EXPECT_EQ(iree_hal_buffer_allocation_size(lower_class), 896u);
+  EXPECT_EQ(live_count(), 2u);
+
+  iree_hal_buffer_release(lower_class);
+  iree_hal_buffer_release(same_class);
+  EXPECT_EQ(live_count(), 2u);
+  IREE_ASSERT_OK(iree_hal_allocator_trim(allocator_));
+  EXPECT_EQ(live_count(), 0u);
+}
+
+TEST_F(CachingAllocatorTest, ExactMode) {
+  auto params = PoolParams();
+  params.size_classes_per_doubling = 0;
+  CreateAllocator(params);
+
+  // Buffers are returned as-is without subspans.
+  iree_hal_buffer_t* buffer = Allocate(1000);
+  EXPECT_EQ(Pooled(buffer), buffer);
+  EXPECT_EQ(iree_hal_buffer_allocation_size(buffer), 1000u);
+  EXPECT_EQ(iree_hal_buffer_byte_length(buffer), 1000u);
+  iree_hal_buffer_t* pooled_buffer = buffer;
+  iree_hal_buffer_release(buffer);
+
+  // Nearby sizes in the same power-of-two bucket are not reused.
+  iree_hal_buffer_t* smaller = Allocate(999);
+  EXPECT_NE(smaller, pooled_buffer);
+  EXPECT_EQ(iree_hal_buffer_allocation_size(smaller), 999u);
+  EXPECT_EQ(live_count(), 2u);
+
+  iree_hal_buffer_t* same = Allocate(1000);
+  EXPECT_EQ(same, pooled_buffer);
+  EXPECT_EQ(live_count(), 2u);
+
+  iree_hal_buffer_release(same);
+  iree_hal_buffer_release(smaller);
+}
+
+TEST_F(CachingAllocatorTest, LruEvictionWhenFull) {
+  auto params = PoolParams();
+  params.max_free_allocation_count = 2;
+  CreateAllocator(params);
+
+  iree_hal_buffer_t* a = Allocate(1000);
+  iree_hal_buffer_t* b = Allocate(2000);
+  iree_hal_buffer_t* c = Allocate(3000);
+  iree_hal_buffer_t* b_pooled = b;
+  iree_hal_buffer_t* c_pooled = c;
+  EXPECT_EQ(live_count(), 3u);
+
+  // Releasing the third buffer evicts the least recently released.
+  iree_hal_buffer_release(a);
+  iree_hal_buffer_release(b);
+  iree_hal_buffer_release(c);
+  EXPECT_EQ(live_count(), 2u);
+
+  // |a| was evicted and must be reallocated while |b| and |c| are reused.
+  a = Allocate(1000);
+  EXPECT_EQ(live_count(), 3u);
+  b = Allocate(2000);
+  c = Allocate(3000);
+  EXPECT_EQ(b, b_pooled);
+  EXPECT_EQ(c, c_pooled);
+  EXPECT_EQ(live_count(), 3u);
+
+  iree_hal_buffer_release(a);
+  iree_hal_buffer_release(b);
+  iree_hal_buffer_release(c);
+}
+
+TEST_F(CachingAllocatorTest, TrimToHighWater) {
+  auto params = PoolParams();
+  params.max_free_capacity = 2500;
+  CreateAllocator(params);
+
+  iree_hal_buffer_t* a = Allocate(1000);
+  iree_hal_buffer_t* b = Allocate(1000);
+  iree_hal_buffer_t* c = Allocate(1000);
+  iree_hal_buffer_t* b_pooled = b;
+  iree_hal_buffer_t* c_pooled = c;
+
+  // The third release exceeds the high-water mark and trims the oldest.
+  iree_hal_buffer_release(a);
+  iree_hal_buffer_release(b);
+  EXPECT_EQ(live_count(), 3u);
+  iree_hal_buffer_release(c);
+  EXPECT_EQ(live_count(), 2u);
+
+  // The most recently released buffers are retained and reused first.
+  a = Allocate(1000);
+  b = Allocate(1000);
+  EXPECT_EQ(a, c_pooled);
+  EXPECT_EQ(b, b_pooled);
+  EXPECT_EQ(live_count(), 2u);
+  iree_hal_buffer_release(a);
+  iree_hal_buffer_release(b);
+
+  // Buffers larger than the high-water mark are never retained.
+  iree_hal_buffer_t* large = Allocate(4000);
+  EXPECT_EQ(live_count(), 3u);
+  iree_hal_buffer_release(large);
+  EXPECT_EQ(live_count(), 2u);
+
+  IREE_ASSERT_OK(iree_hal_allocator_trim(allocator_));
+  EXPECT_EQ(live_count(), 0u);
+}
+
+TEST_F(CachingAllocatorTest, OversizedBypassesPool) {
+  auto params = PoolParams();
+  params.max_allocation_size = 4096;
+  params.size_classes_per_doubling = 4;
+  CreateAllocator(params);
+
+  // Not rounded and not retained.
+  iree_hal_buffer_t* buffer = Allocate(5000);
+  EXPECT_EQ(Pooled(buffer), buffer);
+  EXPECT_EQ(iree_hal_buffer_allocation_size(buffer), 5000u);
+  iree_hal_buffer_release(buffer);
+  EXPECT_EQ(live_count(), 0u);
+
+  buffer = Allocate(4096);
+  iree_hal_buffer_release(buffer);
+  EXPECT_EQ(live_count(), 1u);
+}
+
+TEST_F(CachingAllocatorTest, CapacityLimit) {
+  auto params = PoolParams();
+  params.max_allocation_capacity = 1500;
+  CreateAllocator(params);
+
+  // Buffers released while the pool is over capacity are dropped.
+  iree_hal_buffer_t* a = Allocate(1000);
+  iree_hal_buffer_t* b = Allocate(1000);
+  iree_hal_buffer_t* c = Allocate(1000);
+  iree_hal_buffer_release(a);
+  EXPECT_EQ(live_count(), 2u);
+  iree_hal_buffer_release(b);
+  iree_hal_buffer_release(c);
+  EXPECT_EQ(live_count(), 2u);
+
+  IREE_ASSERT_OK(iree_hal_allocator_trim(allocator_));
+  EXPECT_EQ(live_count(), 0u);
+}
+
+TEST_F(CachingAllocatorTest, InvalidParams) {
+  auto params = PoolParams();
+  params.size_classes_per_doubling = 3;
+  EXPECT_THAT(Status(iree_hal_caching_allocator_create_with_pools(
+                  1, &params, device_allocator_, iree_allocator_system(),
+                  &allocator_)),
+              StatusIs(StatusCode::kInvalidArgument));
+  params = PoolParams();
+  params.size_classes_per_doubling = 32;
+  EXPECT_THAT(Status(iree_hal_caching_allocator_create_with_pools(
+                  1, &params, device_allocator_, iree_allocator_system(),
+                  &allocator_)),
+              StatusIs(StatusCode::kInvalidArgument));
+  params = PoolParams();
+  params.thread_cache_count = 65;
+  EXPECT_THAT(Status(iree_hal_caching_allocator_create_with_pools(
+                  1, &params, device_allocator_, iree_allocator_system(),
+                  &allocator_)),
+              StatusIs(StatusCode::kInvalidArgument));
+}
+
+TEST_F(CachingAllocatorTest, ParseSpec) {
+  // Empty specs create an unbounded allocator.
+  IREE_ASSERT_OK(iree_hal_caching_allocator_create_from_spec(
+      iree_string_view_empty(), device_allocator_, iree_allocator_system(),
+      &allocator_));
+  iree_hal_allocator_release(allocator_);
+  allocator_ = NULL;
+
+  // All fields with wildcards and whitespace.
+  IREE_ASSERT_OK(iree_hal_caching_allocator_create_from_spec(
+      IREE_SV("* = * ; 1mib ; * ; 4 ; * ; 2"), device_allocator_,
+      iree_allocator_system(), &allocator_));
+  iree_hal_allocator_release(allocator_);
+  allocator_ = NULL;
+
+  // Parsed values are applied: 4 classes per doubling round 1000 to 1024 and
+  // allocations over 4KiB bypass the pool.
+  IREE_ASSERT_OK(iree_hal_caching_allocator_create_from_spec(
+      IREE_SV("device_local=4kib;1mib;8;4;512kib;2"), device_allocator_,
+      iree_allocator_system(), &allocator_));
+  iree_hal_buffer_t* buffer = Allocate(1000);
+  EXPECT_EQ(iree_hal_buffer_allocation_size(buffer), 1024u);
+  iree_hal_buffer_release(buffer);
+  buffer = Allocate(5000);
+  EXPECT_EQ(iree_hal_buffer_allocation_size(buffer), 5000u);
+  iree_hal_buffer_release(buffer);
+  EXPECT_EQ(live_count(), 1u);
+  iree_hal_allocator_release(allocator_);
+  allocator_ = NULL;
+  EXPECT_EQ(live_count(), 0u);
+
+  // Multiple pools.
+  IREE_ASSERT_OK(iree_hal_caching_allocator_create_from_spec(
+      IREE_SV("*=1gib;1gib;8,host_visible=*;*;32"), device_allocator_,
+      iree_allocator_system(), &allocator_));
+  iree_hal_allocator_release(allocator_);
+  allocator_ = NULL;
+
+  const char* invalid_specs[] = {
+      "=1mib",            // missing heap key
+      "device_foo=1mib",  // unknown memory type
+      "*=large",          // invalid size
+      "*=*;*;x",          // invalid count
+      "*=*;*;*;3",        // classes not a power of two
+      "*=*;*;*;1;x",      // invalid free capacity
+      "*=*;*;*;1;*;65",   // too many thread caches
+  };
+  for (const char* spec : invalid_specs) {
+    EXPECT_THAT(Status(iree_hal_caching_allocator_create_from_spec(
+                    iree_make_cstring_view(spec), device_allocator_,
+                    iree_allocator_system(), &allocator_)),
+                StatusIs(StatusCode::kInvalidArgument))
+        << spec;
+    EXPECT_EQ(allocator_, nullptr);
+  }
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
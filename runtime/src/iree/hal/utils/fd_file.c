@@ -0,0 +1,200 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/fd_file.h"
+
+#include "iree/base/internal/synchronization.h"
+#include "iree/hal/utils/async_file_reader.h"
+
+//===----------------------------------------------------------------------===//
+// iree_hal_fd_file_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_fd_file_t {
+  iree_hal_resource_t resource;
+  // Used to allocate this structure.
+  iree_allocator_t host_allocator;
+  // Allowed access bits.
+  iree_hal_memory_access_t access;
+  // Base file handle, retained.
+  iree_io_file_handle_t* handle;
+  // Total length of the file in bytes when it was opened.
+  uint64_t length;
+  // Guards lazy initialization of |async_reader|.
+  iree_slim_mutex_t mutex;
+  // Process-wide shared reader used for asynchronous reads; acquired on first
+  // use so that files only accessed synchronously do not pay for the reader
+  // threads.
+  iree_hal_async_file_reader_t* async_reader;
+} iree_hal_fd_file_t;
+
+static const iree_hal_file_vtable_t iree_hal_fd_file_vtable;
+
+static iree_hal_fd_file_t* iree_hal_fd_file_cast(
+    iree_hal_file_t* IREE_RESTRICT base_value) {
+  return (iree_hal_fd_file_t*)base_value;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_fd_file_from_handle(
+    iree_hal_memory_access_t access, iree_io_file_handle_t* handle,
+    iree_allocator_t host_allocator, iree_hal_file_t** out_file) {
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(out_file);
+  *out_file = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  if (iree_io_file_handle_type(handle) != IREE_IO_FILE_HANDLE_TYPE_FD) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "fd files require file descriptor handles");
+  }
+
+  // Query the file length once; we don't support files changing size while
+  // they are in use.
+  uint64_t length = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_io_file_handle_query_length(handle, &length));
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, length);
+
+  iree_hal_fd_file_t* file = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*file), (void**)&file));
+  iree_hal_resource_initialize(&iree_hal_fd_file_vtable, &file->resource);
+  file->host_allocator = host_allocator;
+  file->access = access;
+  file->handle = handle;
+  iree_io_file_handle_retain(handle);
+  file->length = length;
+  iree_slim_mutex_initialize(&file->mutex);
+  file->async_reader = NULL;
+
+  *out_file = (iree_hal_file_t*)file;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_hal_fd_file_destroy(iree_hal_file_t* IREE_RESTRICT base_file) {
+  iree_hal_fd_file_t* file = iree_hal_fd_file_cast(base_file);
+  iree_allocator_t host_allocator = file->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // In-flight reads retain the file handle and continue on the shared reader.
+  iree_hal_async_file_reader_release_shared(file->async_reader);
+  iree_slim_mutex_deinitialize(&file->mutex);
+
+  iree_io_file_handle_release(file->handle);
+
+  iree_allocator_free(host_allocator, file);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_hal_memory_access_t iree_hal_fd_file_allowed_access(
+    iree_hal_file_t* base_file) {
+  iree_hal_fd_file_t* file = iree_hal_fd_file_cast(base_file);
+  return file->access;
+}
+
+static uint64_t iree_hal_fd_file_length(iree_hal_file_t* base_file) {
+  iree_hal_fd_file_t* file = iree_hal_fd_file_cast(base_file);
+  return file->length;
+}
+
+static iree_hal_buffer_t* iree_hal_fd_file_storage_buffer(
+    iree_hal_file_t* base_file) {
+  // Not mapped so there's no buffer that can be used for device transfers.
+  return NULL;
+}
+
+static iree_status_t iree_hal_fd_file_read(iree_hal_file_t* base_file,
+                                           uint64_t file_offset,
+                                           iree_hal_buffer_t* buffer,
+                                           iree_device_size_t buffer_offset,
+                                           iree_device_size_t length) {
+  iree_hal_fd_file_t* file = iree_hal_fd_file_cast(base_file);
+  if (length == 0) return iree_ok_status();
+
+  // Map the target range of the buffer and read directly into it; this avoids
+  // any intermediate copies when reading into staging buffers.
+  iree_hal_buffer_mapping_t mapping;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
+      buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+      IREE_HAL_MEMORY_ACCESS_DISCARD_WRITE, buffer_offset, length, &mapping));
+
+  iree_status_t status = iree_io_file_handle_read(
+      file->handle, file_offset, mapping.contents.data,
+      (iree_host_size_t)length);
+
+  if (iree_status_is_ok(status) &&
+      !iree_all_bits_set(iree_hal_buffer_memory_type(buffer),
+                         IREE_HAL_MEMORY_TYPE_HOST_COHERENT)) {
+    status = iree_hal_buffer_mapping_flush_range(&mapping, 0, IREE_WHOLE_BUFFER);
+  }
+
+  return iree_status_join(status, iree_hal_buffer_unmap_range(&mapping));
+}
+
+static iree_status_t iree_hal_fd_file_write(iree_hal_file_t* base_file,
+                                            uint64_t file_offset,
+                                            iree_hal_buffer_t* buffer,
+                                            iree_device_size_t buffer_offset,
+                                            iree_device_size_t length) {
+  iree_hal_fd_file_t* file = iree_hal_fd_file_cast(base_file);
+  if (length == 0) return iree_ok_status();
+
+  // Map the source range of the buffer and write directly from it.
+  iree_hal_buffer_mapping_t mapping;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_buffer_map_range(buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+                                IREE_HAL_MEMORY_ACCESS_READ, buffer_offset,
+                                length, &mapping));
+
+  iree_status_t status = iree_ok_status();
+  if (!iree_all_bits_set(iree_hal_buffer_memory_type(buffer),
+                         IREE_HAL_MEMORY_TYPE_HOST_COHERENT)) {
+    status = iree_hal_buffer_mapping_invalidate_range(&mapping, 0,
+                                                      IREE_WHOLE_BUFFER);
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_io_file_handle_write(file->handle, file_offset,
+                                       mapping.contents.data,
+                                       (iree_host_size_t)length);
+  }
+
+  return iree_status_join(status, iree_hal_buffer_unmap_range(&mapping));
+}
+
+static iree_status_t iree_hal_fd_file_submit_read(
+    iree_hal_file_t* base_file, uint64_t file_offset,
+    iree_hal_buffer_t* buffer, iree_device_size_t buffer_offset,
+    iree_device_size_t length,
+    iree_hal_semaphore_list_t signal_semaphore_list) {
+  iree_hal_fd_file_t* file = iree_hal_fd_file_cast(base_file);
+
+  iree_slim_mutex_lock(&file->mutex);
+  iree_status_t status = iree_ok_status();
+  if (!file->async_reader) {
+    status = iree_hal_async_file_reader_acquire_shared(&file->async_reader);
+  }
+  iree_hal_async_file_reader_t* async_reader = file->async_reader;
+  iree_slim_mutex_unlock(&file->mutex);
+  IREE_RETURN_IF_ERROR(status);
+
+  return iree_hal_async_file_reader_submit(async_reader, file->handle,
+                                           file_offset, buffer, buffer_offset,
+                                           length, signal_semaphore_list);
+}
+
+static const iree_hal_file_vtable_t iree_hal_fd_file_vtable = {
+    .destroy = iree_hal_fd_file_destroy,
+    .allowed_access = iree_hal_fd_file_allowed_access,
+    .length = iree_hal_fd_file_length,
+    .storage_buffer = iree_hal_fd_file_storage_buffer,
+    .read = iree_hal_fd_file_read,
+    .write = iree_hal_fd_file_write,
+    .submit_read = iree_hal_fd_file_submit_read,
+};
@@ -0,0 +1,43 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_FD_FILE_H_
+#define IREE_HAL_UTILS_FD_FILE_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/io/file_handle.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_fd_file_t
+//===----------------------------------------------------------------------===//
+
+// Creates a HAL file backed by the file descriptor in |handle|.
+// The handle must be of type IREE_IO_FILE_HANDLE_TYPE_FD and will be retained
+// for the lifetime of the file.
+//
+// File contents are never mapped: synchronous reads and writes use positioned
+// I/O (pread/pwrite) directly into/out of mapped HAL buffers such as the
+// staging buffers used by iree_hal_device_queue_read_streaming. This allows
+// files much larger than the host address space or available memory to be used
+// as parameter sources.
+//
+// Asynchronous reads (iree_hal_file_submit_read) are serviced by the
+// process-wide shared iree_hal_async_file_reader_t, allowing many reads to be
+// in flight at once via io_uring (or a thread pool where unavailable).
+IREE_API_EXPORT iree_status_t iree_hal_fd_file_from_handle(
+    iree_hal_memory_access_t access, iree_io_file_handle_t* handle,
+    iree_allocator_t host_allocator, iree_hal_file_t** out_file);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_FD_FILE_H_
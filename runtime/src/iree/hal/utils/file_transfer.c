@@ -7,7 +7,6 @@
 #include "iree/hal/utils/file_transfer.h"
 
 #include "iree/base/internal/math.h"
-#include "iree/hal/utils/memory_file.h"
 
 //===----------------------------------------------------------------------===//
 // Configuration
@@ -40,8 +39,6 @@
 // iree_hal_transfer_operation_t
 //===----------------------------------------------------------------------===//
 
-// TODO(benvanik): move to utils/ without relying on iree_hal_memory_file_t.
-
 // Maximum number of transfer workers that can be used; common usage should be
 // 1-4 but on very large systems with lots of bandwidth we may be able to
 // use more.
@@ -398,10 +395,18 @@ static void iree_hal_transfer_operation_notify_completion(
       operation->device, operation->queue_affinity, wait_semaphore_list,
       signal_semaphore_list, operation->staging_buffer);
 
-  // If the dealloca failed we don't have a great way of letting anyone know.
-  // We'll just drop it on the floor for now and let the buffer be freed by
-  // reference counting.
-  iree_status_ignore(status);
+  // If the dealloca failed (such as when a failed asynchronous file read
+  // propagated to the worker semaphores) the user semaphores will never be
+  // signaled by it and we need to fail them so waiters are woken. The staging
+  // buffer will be freed by reference counting.
+  if (!iree_status_is_ok(status)) {
+    iree_hal_semaphore_list_fail(
+        operation->signal_semaphore_list,
+        iree_status_is_ok(operation->error_status)
+            ? status
+            : iree_status_join(iree_status_clone(operation->error_status),
+                               status));
+  }
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -493,32 +498,53 @@ static iree_status_t iree_hal_transfer_worker_copy_file_to_buffer(
   IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (int64_t)transfer_offset);
   IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (int64_t)transfer_length);
 
-  // Timeline increments by one.
+  // Track the pending copy operation so we know where to place it in the
+  // buffer.
+  worker->pending_transfer_offset = transfer_offset;
+  worker->pending_transfer_length = transfer_length;
+
+  // Timeline increments by one for the file read and one for the copy.
+  // If the file supports asynchronous reads we submit the read and have the
+  // copy wait on its completion so that this worker doesn't block the loop on
+  // disk I/O and many reads can be in flight while copies are executing.
   uint64_t wait_timepoint = worker->pending_timepoint;
   iree_hal_semaphore_list_t wait_semaphore_list = {
       .count = 1,
       .semaphores = &worker->semaphore,
       .payload_values = &wait_timepoint,
   };
-  uint64_t signal_timepoint = ++worker->pending_timepoint;
-  iree_hal_semaphore_list_t signal_semaphore_list = {
+  uint64_t read_timepoint = wait_timepoint + 1;
+  iree_hal_semaphore_list_t read_semaphore_list = {
       .count = 1,
       .semaphores = &worker->semaphore,
-      .payload_values = &signal_timepoint,
+      .payload_values = &read_timepoint,
   };
-
-  // Track the pending copy operation so we know where to place it in the
-  // buffer.
-  worker->pending_transfer_offset = transfer_offset;
-  worker->pending_transfer_length = transfer_length;
-
-  // Synchronously copy the contents from the file to the staging buffer.
-  status = iree_hal_file_read(
+  status = iree_hal_file_submit_read(
       operation->file, operation->file_offset + worker->pending_transfer_offset,
       operation->staging_buffer, worker->staging_buffer_offset,
-      worker->pending_transfer_length);
+      worker->pending_transfer_length, read_semaphore_list);
+  if (iree_status_is_ok(status)) {
+    wait_timepoint = ++worker->pending_timepoint;
+  } else if (iree_status_is_unimplemented(status)) {
+    // Synchronously copy the contents from the file to the staging buffer.
+    iree_status_ignore(status);
+    status = iree_hal_file_read(
+        operation->file,
+        operation->file_offset + worker->pending_transfer_offset,
+        operation->staging_buffer, worker->staging_buffer_offset,
+        worker->pending_transfer_length);
+  }
+  uint64_t signal_timepoint = worker->pending_timepoint + 1;
+  iree_hal_semaphore_list_t signal_semaphore_list = {
+      .count = 1,
+      .semaphores = &worker->semaphore,
+      .payload_values = &signal_timepoint,
+  };
 
   // Issue asynchronous copy from the staging buffer into the target buffer.
+  // The worker timeline only advances if the copy was issued as otherwise the
+  // timepoint would never be reached and the staging buffer dealloca that waits
+  // on it would hang.
   if (iree_status_is_ok(status)) {
     status = iree_hal_device_queue_copy(
         operation->device, operation->queue_affinity, wait_semaphore_list,
@@ -527,6 +553,9 @@ static iree_status_t iree_hal_transfer_worker_copy_file_to_buffer(
         operation->buffer_offset + transfer_offset, transfer_length,
         IREE_HAL_COPY_FLAG_NONE);
   }
+  if (iree_status_is_ok(status)) {
+    worker->pending_timepoint = signal_timepoint;
+  }
 
   // Wait for the copy to complete and tick again if we expect there to be more
   // work. If there are no more chunks to copy (or they are spoken for by other
@@ -903,7 +932,6 @@ IREE_API_EXPORT iree_status_t iree_hal_device_queue_write_streaming(
     iree_hal_file_t* target_file, uint64_t target_offset,
     iree_device_size_t length, iree_hal_write_flags_t flags,
     iree_hal_file_transfer_options_t options) {
-  // EXPERIMENTAL: assume memory files only today (as that's all we have).
   IREE_RETURN_IF_ERROR(
       iree_hal_file_validate_access(target_file, IREE_HAL_MEMORY_ACCESS_WRITE));
 
@@ -0,0 +1,295 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/host_collectives.h"
+
+#include <string.h>
+
+#include "iree/base/internal/math.h"
+
+//===----------------------------------------------------------------------===//
+// Host collective operations
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT void iree_hal_collective_send_recv_ranks(uint32_t param,
+                                                         int32_t* out_target,
+                                                         int32_t* out_source) {
+  *out_target = (int16_t)(param & 0xFFFFu);
+  *out_source = (int16_t)(param >> 16);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_collective_verify_buffer_lengths(
+    iree_hal_collective_op_t op, uint32_t param, int32_t rank, int32_t count,
+    iree_host_size_t element_count, iree_host_size_t send_length,
+    iree_host_size_t recv_length) {
+  const iree_host_size_t length =
+      element_count * iree_hal_collective_element_byte_count(op.element_type);
+  iree_host_size_t required_send_length = 0;
+  iree_host_size_t required_recv_length = 0;
+  switch (op.kind) {
+    case IREE_HAL_COLLECTIVE_KIND_ALL_GATHER:
+      required_send_length = length;
+      required_recv_length = length * count;
+      break;
+    case IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE:
+    case IREE_HAL_COLLECTIVE_KIND_ALL_TO_ALL:
+      required_send_length = length;
+      required_recv_length = length;
+      break;
+    case IREE_HAL_COLLECTIVE_KIND_BROADCAST:
+      if (rank == (int32_t)param) {
+        required_send_length = length;
+      } else {
+        required_recv_length = length;
+      }
+      break;
+    case IREE_HAL_COLLECTIVE_KIND_REDUCE:
+      required_send_length = length;
+      if (rank == (int32_t)param) required_recv_length = length;
+      break;
+    case IREE_HAL_COLLECTIVE_KIND_REDUCE_SCATTER:
+      required_send_length = length * count;
+      required_recv_length = length;
+      break;
+    case IREE_HAL_COLLECTIVE_KIND_SEND:
+      required_send_length = length;
+      break;
+    case IREE_HAL_COLLECTIVE_KIND_RECV:
+      required_recv_length = length;
+      break;
+    case IREE_HAL_COLLECTIVE_KIND_SEND_RECV: {
+      int32_t target = -1;
+      int32_t source = -1;
+      iree_hal_collective_send_recv_ranks(param, &target, &source);
+      if (target >= 0) required_send_length = length;
+      required_recv_length = length;
+      break;
+    }
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unhandled collective kind %u", op.kind);
+  }
+  if (send_length < required_send_length) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "collective send buffer of %" PRIhsz
+                            " bytes is smaller than the required %" PRIhsz
+                            " bytes",
+                            send_length, required_send_length);
+  }
+  if (recv_length < required_recv_length) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "collective recv buffer of %" PRIhsz
+                            " bytes is smaller than the required %" PRIhsz
+                            " bytes",
+                            recv_length, required_recv_length);
+  }
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Host collective reductions
+//===----------------------------------------------------------------------===//
+
+static bool iree_hal_collective_is_half(
+    iree_hal_collective_element_type_t element_type) {
+  return element_type == IREE_HAL_COLLECTIVE_ELEMENT_TYPE_FLOAT_16 ||
+         element_type == IREE_HAL_COLLECTIVE_ELEMENT_TYPE_BFLOAT_16;
+}
+
+IREE_API_EXPORT iree_host_size_t iree_hal_collective_accumulator_element_size(
+    iree_hal_collective_element_type_t element_type) {
+  return iree_hal_collective_is_half(element_type)
+             ? sizeof(float)
+             : (iree_host_size_t)iree_hal_collective_element_byte_count(
+                   element_type);
+}
+
+IREE_API_EXPORT void iree_hal_collective_accumulator_load(
+    iree_hal_collective_element_type_t element_type, void* IREE_RESTRICT acc,
+    const void* IREE_RESTRICT source, iree_host_size_t count) {
+  if (element_type == IREE_HAL_COLLECTIVE_ELEMENT_TYPE_FLOAT_16) {
+    float* IREE_RESTRICT a = (float*)acc;
+    const uint16_t* IREE_RESTRICT s = (const uint16_t*)source;
+    for (iree_host_size_t i = 0; i < count; ++i) {
+      a[i] = iree_math_f16_to_f32(s[i]);
+    }
+  } else if (element_type == IREE_HAL_COLLECTIVE_ELEMENT_TYPE_BFLOAT_16) {
+    float* IREE_RESTRICT a = (float*)acc;
+    const uint16_t* IREE_RESTRICT s = (const uint16_t*)source;
+    for (iree_host_size_t i = 0; i < count; ++i) {
+      a[i] = iree_math_bf16_to_f32(s[i]);
+    }
+  } else {
+    memcpy(acc, source,
+           count * iree_hal_collective_element_byte_count(element_type));
+  }
+}
+
+IREE_API_EXPORT void iree_hal_collective_accumulator_store(
+    iree_hal_collective_element_type_t element_type,
+    const void* IREE_RESTRICT acc, void* IREE_RESTRICT target,
+    iree_host_size_t count) {
+  if (element_type == IREE_HAL_COLLECTIVE_ELEMENT_TYPE_FLOAT_16) {
+    const float* IREE_RESTRICT a = (const float*)acc;
+    uint16_t* IREE_RESTRICT t = (uint16_t*)target;
+    for (iree_host_size_t i = 0; i < count; ++i) {
+      t[i] = iree_math_f32_to_f16(a[i]);
+    }
+  } else if (element_type == IREE_HAL_COLLECTIVE_ELEMENT_TYPE_BFLOAT_16) {
+    const float* IREE_RESTRICT a = (const float*)acc;
+    uint16_t* IREE_RESTRICT t = (uint16_t*)target;
+    for (iree_host_size_t i = 0; i < count; ++i) {
+      t[i] = iree_math_f32_to_bf16(a[i]);
+    }
+  } else {
+    memcpy(target, acc,
+           count * iree_hal_collective_element_byte_count(element_type));
+  }
+}
+
+// Combines |count| elements of |source| into |acc| with |reduction|.
+// |T| is the accumulator type and |W| the type arithmetic is performed in such
+// that integer overflow wraps instead of being undefined.
+#define IREE_HAL_COLLECTIVE_REDUCE(T, W, reduction, acc, source, count) \
+  do {                                                                  \
+    T* IREE_RESTRICT a = (T*)(acc);                                     \
+    const T* IREE_RESTRICT s = (const T*)(source);                      \
+    switch (reduction) {                                                \
+      case IREE_HAL_COLLECTIVE_REDUCTION_SUM:                           \
+      case IREE_HAL_COLLECTIVE_REDUCTION_AVERAGE:                       \
+        for (iree_host_size_t i = 0; i < (count); ++i) {                \
+          a[i] = (T)((W)a[i] + (W)s[i]);                                \
+        }                                                               \
+        break;                                                          \
+      case IREE_HAL_COLLECTIVE_REDUCTION_PRODUCT:                       \
+        for (iree_host_size_t i = 0; i < (count); ++i) {                \
+          a[i] = (T)((W)a[i] * (W)s[i]);                                \
+        }                                                               \
+        break;                                                          \
+      case IREE_HAL_COLLECTIVE_REDUCTION_MINIMUM:                       \
+        for (iree_host_size_t i = 0; i < (count); ++i) {                \
+          a[i] = s[i] < a[i] ? s[i] : a[i];                             \
+        }                                                               \
+        break;                                                          \
+      case IREE_HAL_COLLECTIVE_REDUCTION_MAXIMUM:                       \
+        for (iree_host_size_t i = 0; i < (count); ++i) {                \
+          a[i] = s[i] > a[i] ? s[i] : a[i];                             \
+        }                                                               \
+        break;                                                          \
+      default:                                                          \
+        break;                                                          \
+    }                                                                   \
+  } while (0)
+
+// Divides |count| accumulated elements by |divisor|.
+#define IREE_HAL_COLLECTIVE_DIVIDE(T, acc, divisor, count)    \
+  do {                                                        \
+    T* IREE_RESTRICT a = (T*)(acc);                           \
+    const T d = (T)(divisor);                                 \
+    for (iree_host_size_t i = 0; i < (count); ++i) a[i] /= d; \
+  } while (0)
+
+IREE_API_EXPORT void iree_hal_collective_accumulator_reduce(
+    iree_hal_collective_element_type_t element_type,
+    iree_hal_collective_reduction_t reduction, void* IREE_RESTRICT acc,
+    const void* IREE_RESTRICT source, iree_host_size_t count) {
+  IREE_ASSERT_LE(count, IREE_HAL_COLLECTIVE_ACCUMULATOR_CHUNK_LENGTH);
+  // Half-precision sources are widened so that they can be combined with the
+  // f32 accumulator.
+  float scratch[IREE_HAL_COLLECTIVE_ACCUMULATOR_CHUNK_LENGTH];
+  if (iree_hal_collective_is_half(element_type)) {
+    iree_hal_collective_accumulator_load(element_type, scratch, source, count);
+    source = scratch;
+  }
+  switch (element_type) {
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_SINT_8:
+      IREE_HAL_COLLECTIVE_REDUCE(int8_t, uint32_t, reduction, acc, source,
+                                 count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_UINT_8:
+      IREE_HAL_COLLECTIVE_REDUCE(uint8_t, uint32_t, reduction, acc, source,
+                                 count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_SINT_16:
+      IREE_HAL_COLLECTIVE_REDUCE(int16_t, uint32_t, reduction, acc, source,
+                                 count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_UINT_16:
+      IREE_HAL_COLLECTIVE_REDUCE(uint16_t, uint32_t, reduction, acc, source,
+                                 count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_SINT_32:
+      IREE_HAL_COLLECTIVE_REDUCE(int32_t, uint32_t, reduction, acc, source,
+                                 count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_UINT_32:
+      IREE_HAL_COLLECTIVE_REDUCE(uint32_t, uint32_t, reduction, acc, source,
+                                 count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_SINT_64:
+      IREE_HAL_COLLECTIVE_REDUCE(int64_t, uint64_t, reduction, acc, source,
+                                 count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_UINT_64:
+      IREE_HAL_COLLECTIVE_REDUCE(uint64_t, uint64_t, reduction, acc, source,
+                                 count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_FLOAT_16:
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_BFLOAT_16:
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_FLOAT_32:
+      IREE_HAL_COLLECTIVE_REDUCE(float, float, reduction, acc, source, count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_FLOAT_64:
+      IREE_HAL_COLLECTIVE_REDUCE(double, double, reduction, acc, source,
+                                 count);
+      break;
+    default:
+      break;
+  }
+}
+
+IREE_API_EXPORT void iree_hal_collective_accumulator_finalize(
+    iree_hal_collective_element_type_t element_type,
+    iree_hal_collective_reduction_t reduction, int32_t participant_count,
+    void* IREE_RESTRICT acc, iree_host_size_t count) {
+  if (reduction != IREE_HAL_COLLECTIVE_REDUCTION_AVERAGE) return;
+  switch (element_type) {
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_SINT_8:
+      IREE_HAL_COLLECTIVE_DIVIDE(int8_t, acc, participant_count, count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_UINT_8:
+      IREE_HAL_COLLECTIVE_DIVIDE(uint8_t, acc, participant_count, count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_SINT_16:
+      IREE_HAL_COLLECTIVE_DIVIDE(int16_t, acc, participant_count, count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_UINT_16:
+      IREE_HAL_COLLECTIVE_DIVIDE(uint16_t, acc, participant_count, count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_SINT_32:
+      IREE_HAL_COLLECTIVE_DIVIDE(int32_t, acc, participant_count, count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_UINT_32:
+      IREE_HAL_COLLECTIVE_DIVIDE(uint32_t, acc, participant_count, count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_SINT_64:
+      IREE_HAL_COLLECTIVE_DIVIDE(int64_t, acc, participant_count, count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_UINT_64:
+      IREE_HAL_COLLECTIVE_DIVIDE(uint64_t, acc, participant_count, count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_FLOAT_16:
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_BFLOAT_16:
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_FLOAT_32:
+      IREE_HAL_COLLECTIVE_DIVIDE(float, acc, participant_count, count);
+      break;
+    case IREE_HAL_COLLECTIVE_ELEMENT_TYPE_FLOAT_64:
+      IREE_HAL_COLLECTIVE_DIVIDE(double, acc, participant_count, count);
+      break;
+    default:
+      break;
+  }
+}
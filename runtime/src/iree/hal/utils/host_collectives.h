@@ -0,0 +1,86 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_HOST_COLLECTIVES_H_
+#define IREE_HAL_UTILS_HOST_COLLECTIVES_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// Host collective operations
+//===----------------------------------------------------------------------===//
+
+// Decodes the target (low 16 bits) and source (high 16 bits) ranks of a
+// IREE_HAL_COLLECTIVE_KIND_SEND_RECV |param|. Either may be -1 if not used.
+IREE_API_EXPORT void iree_hal_collective_send_recv_ranks(uint32_t param,
+                                                         int32_t* out_target,
+                                                         int32_t* out_source);
+
+// Verifies that send and recv buffers of |send_length| and |recv_length| bytes
+// are large enough for |rank| of |count| participants to perform |op| with
+// |param| on |element_count| elements.
+IREE_API_EXPORT iree_status_t iree_hal_collective_verify_buffer_lengths(
+    iree_hal_collective_op_t op, uint32_t param, int32_t rank, int32_t count,
+    iree_host_size_t element_count, iree_host_size_t send_length,
+    iree_host_size_t recv_length);
+
+//===----------------------------------------------------------------------===//
+// Host collective reductions
+//===----------------------------------------------------------------------===//
+// Reductions are performed on chunks of elements held in an accumulator.
+// Accumulators use the element type except for half-precision types which are
+// accumulated in f32 and converted on load and store. The loops are written to
+// be vectorized by the compiler.
+
+// Maximum number of elements that should be processed by a single call.
+// Callers can size stack accumulators with this.
+#define IREE_HAL_COLLECTIVE_ACCUMULATOR_CHUNK_LENGTH 256
+
+// Maximum size in bytes of an accumulator element of any type.
+#define IREE_HAL_COLLECTIVE_ACCUMULATOR_MAX_ELEMENT_SIZE 8
+
+// Returns the size in bytes of an accumulator element for |element_type|.
+IREE_API_EXPORT iree_host_size_t iree_hal_collective_accumulator_element_size(
+    iree_hal_collective_element_type_t element_type);
+
+// Loads |count| elements from |source| into the accumulator |acc|.
+IREE_API_EXPORT void iree_hal_collective_accumulator_load(
+    iree_hal_collective_element_type_t element_type, void* IREE_RESTRICT acc,
+    const void* IREE_RESTRICT source, iree_host_size_t count);
+
+// Stores |count| elements from the accumulator |acc| into |target|.
+IREE_API_EXPORT void iree_hal_collective_accumulator_store(
+    iree_hal_collective_element_type_t element_type,
+    const void* IREE_RESTRICT acc, void* IREE_RESTRICT target,
+    iree_host_size_t count);
+
+// Combines |count| elements of |source| into the accumulator |acc| with
+// |reduction|. |source| contains elements of |element_type| and not
+// accumulator elements. Integer arithmetic wraps on overflow.
+// |count| must be at most IREE_HAL_COLLECTIVE_ACCUMULATOR_CHUNK_LENGTH.
+IREE_API_EXPORT void iree_hal_collective_accumulator_reduce(
+    iree_hal_collective_element_type_t element_type,
+    iree_hal_collective_reduction_t reduction, void* IREE_RESTRICT acc,
+    const void* IREE_RESTRICT source, iree_host_size_t count);
+
+// Finalizes |count| accumulated elements of a reduction over
+// |participant_count| participants. Only required for reductions like
+// IREE_HAL_COLLECTIVE_REDUCTION_AVERAGE and otherwise a no-op.
+IREE_API_EXPORT void iree_hal_collective_accumulator_finalize(
+    iree_hal_collective_element_type_t element_type,
+    iree_hal_collective_reduction_t reduction, int32_t participant_count,
+    void* IREE_RESTRICT acc, iree_host_size_t count);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_HOST_COLLECTIVES_H_
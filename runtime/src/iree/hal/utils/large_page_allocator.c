@@ -0,0 +1,387 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/large_page_allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Large pages are mapped with mmap/madvise and placed with mbind.
+#if (defined(IREE_PLATFORM_LINUX) || defined(IREE_PLATFORM_ANDROID)) && \
+    !defined(IREE_PLATFORM_EMSCRIPTEN)
+#define IREE_HAL_LARGE_PAGE_ALLOCATOR_SUPPORTED 1
+#endif  // IREE_PLATFORM_LINUX
+
+#if defined(IREE_HAL_LARGE_PAGE_ALLOCATOR_SUPPORTED)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif  // MAP_HUGE_SHIFT
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif  // MAP_HUGE_2MB
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif  // MAP_HUGE_1GB
+// From linux/mempolicy.h; numaif.h is part of libnuma and may be missing.
+#define IREE_HAL_MPOL_PREFERRED 1
+#endif  // IREE_HAL_LARGE_PAGE_ALLOCATOR_SUPPORTED
+
+#define IREE_HAL_LARGE_PAGE_SIZE_2MB (2ull * 1024 * 1024)
+#define IREE_HAL_LARGE_PAGE_SIZE_1GB (1024ull * 1024 * 1024)
+
+// Explicit huge pages are only used when rounding the allocation up to a whole
+// number of pages wastes no more than 1/N of the allocation. Otherwise the
+// allocation uses transparent huge pages which can back the aligned bulk of the
+// allocation with huge pages and the remainder with normal pages.
+#define IREE_HAL_LARGE_PAGE_MAX_WASTE_DIVISOR 8
+
+//===----------------------------------------------------------------------===//
+// Options
+//===----------------------------------------------------------------------===//
+
+iree_status_t iree_hal_large_page_mode_parse(
+    iree_string_view_t value, iree_hal_large_page_mode_t* out_mode) {
+  IREE_ASSERT_ARGUMENT(out_mode);
+  if (iree_string_view_is_empty(value) ||
+      iree_string_view_equal_case(value, IREE_SV("none"))) {
+    *out_mode = IREE_HAL_LARGE_PAGE_MODE_NONE;
+  } else if (iree_string_view_equal_case(value, IREE_SV("transparent"))) {
+    *out_mode = IREE_HAL_LARGE_PAGE_MODE_TRANSPARENT;
+  } else if (iree_string_view_equal_case(value, IREE_SV("2mb"))) {
+    *out_mode = IREE_HAL_LARGE_PAGE_MODE_EXPLICIT_2MB;
+  } else if (iree_string_view_equal_case(value, IREE_SV("1gb"))) {
+    *out_mode = IREE_HAL_LARGE_PAGE_MODE_EXPLICIT_1GB;
+  } else {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "unknown large page mode '%.*s'; expected one of "
+                            "none, transparent, 2mb, or 1gb",
+                            (int)value.size, value.data);
+  }
+  return iree_ok_status();
+}
+
+void iree_hal_large_page_allocator_options_initialize(
+    iree_hal_large_page_allocator_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->mode = IREE_HAL_LARGE_PAGE_MODE_NONE;
+  out_options->numa_node = -1;
+}
+
+// The options are packed into the allocator self pointer so that the allocator
+// has no state that must outlive the buffers allocated from it:
+//   [7:0] iree_hal_large_page_mode_t
+//   [..:8] NUMA node + 1 or 0 for the default placement
+#define IREE_HAL_LARGE_PAGE_SELF_MODE_MASK 0xFFu
+#define IREE_HAL_LARGE_PAGE_SELF_NODE_SHIFT 8
+
+iree_allocator_t iree_hal_large_page_allocator(
+    const iree_hal_large_page_allocator_options_t* options) {
+  IREE_ASSERT_ARGUMENT(options);
+  uintptr_t self =
+      (uintptr_t)options->mode & IREE_HAL_LARGE_PAGE_SELF_MODE_MASK;
+  if (options->numa_node >= 0) {
+    self |= ((uintptr_t)options->numa_node + 1)
+            << IREE_HAL_LARGE_PAGE_SELF_NODE_SHIFT;
+  }
+  iree_allocator_t allocator = {
+      .self = (void*)self,
+      .ctl = iree_hal_large_page_allocator_ctl,
+  };
+  return allocator;
+}
+
+static iree_hal_large_page_mode_t iree_hal_large_page_self_mode(void* self) {
+  return (iree_hal_large_page_mode_t)((uintptr_t)self &
+                                      IREE_HAL_LARGE_PAGE_SELF_MODE_MASK);
+}
+
+static int32_t iree_hal_large_page_self_numa_node(void* self) {
+  return (int32_t)((uintptr_t)self >> IREE_HAL_LARGE_PAGE_SELF_NODE_SHIFT) - 1;
+}
+
+//===----------------------------------------------------------------------===//
+// Allocation headers
+//===----------------------------------------------------------------------===//
+
+// Identifies how an allocation was made so that it can be freed.
+typedef enum iree_hal_large_page_kind_e {
+  // Allocated from the system heap with malloc.
+  IREE_HAL_LARGE_PAGE_KIND_HEAP = 0x48454150u,  // 'HEAP'
+  // Mapped directly from the system with mmap.
+  IREE_HAL_LARGE_PAGE_KIND_MAP = 0x4D415050u,  // 'MAPP'
+} iree_hal_large_page_kind_t;
+
+// Header immediately preceding each returned pointer. Heap allocations place
+// the header at the start of the malloc block. Mapped allocations are padded
+// by IREE_HAL_LARGE_PAGE_MAP_PREFIX so that the returned pointer retains a
+// large alignment from the mapping base.
+typedef struct iree_alignas(iree_max_align_t) iree_hal_large_page_header_t {
+  uint32_t kind;
+  uint32_t reserved;
+  // Total bytes in the allocation (including the prefix/header).
+  uint64_t length;
+} iree_hal_large_page_header_t;
+static_assert(sizeof(iree_hal_large_page_header_t) == iree_max_align_t,
+              "header must preserve the natural alignment");
+
+#define IREE_HAL_LARGE_PAGE_MAP_PREFIX 64
+
+static iree_hal_large_page_header_t* iree_hal_large_page_header(void* ptr) {
+  return (iree_hal_large_page_header_t*)ptr - 1;
+}
+
+// Returns the usable byte length of the allocation at |ptr|.
+static iree_host_size_t iree_hal_large_page_usable_length(void* ptr) {
+  iree_hal_large_page_header_t* header = iree_hal_large_page_header(ptr);
+  return (iree_host_size_t)header->length -
+         (header->kind == IREE_HAL_LARGE_PAGE_KIND_MAP
+              ? IREE_HAL_LARGE_PAGE_MAP_PREFIX
+              : sizeof(*header));
+}
+
+//===----------------------------------------------------------------------===//
+// Heap allocations
+//===----------------------------------------------------------------------===//
+
+static iree_status_t iree_hal_large_page_allocate_heap(
+    iree_host_size_t byte_length, bool zero, void** out_ptr) {
+  if (byte_length > IREE_HOST_SIZE_MAX - sizeof(iree_hal_large_page_header_t)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "allocation size overflow");
+  }
+  const iree_host_size_t total_length =
+      sizeof(iree_hal_large_page_header_t) + byte_length;
+  iree_hal_large_page_header_t* header =
+      zero ? calloc(1, total_length) : malloc(total_length);
+  if (!header) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "system allocator failed the request");
+  }
+  header->kind = IREE_HAL_LARGE_PAGE_KIND_HEAP;
+  header->reserved = 0;
+  header->length = total_length;
+  *out_ptr = header + 1;
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Mapped allocations
+//===----------------------------------------------------------------------===//
+
+#if defined(IREE_HAL_LARGE_PAGE_ALLOCATOR_SUPPORTED)
+
+// Prefers placing the pages of [base, base+length) on |numa_node|. Must be
+// called before the pages are first touched. Failures are ignored as the
+// kernel may not support NUMA or the process may not be allowed to use it.
+static void iree_hal_large_page_bind(void* base, iree_host_size_t length,
+                                     int32_t numa_node) {
+#if defined(SYS_mbind)
+  if (numa_node < 0) return;
+  unsigned long node_mask[16] = {0};
+  const iree_host_size_t bits_per_word = sizeof(node_mask[0]) * 8;
+  const iree_host_size_t max_node = IREE_ARRAYSIZE(node_mask) * bits_per_word;
+  if ((iree_host_size_t)numa_node >= max_node) return;
+  node_mask[numa_node / bits_per_word] |= 1ul << (numa_node % bits_per_word);
+  // NOTE: the kernel reads maxnode - 1 bits from the mask.
+  syscall(SYS_mbind, base, length, IREE_HAL_MPOL_PREFERRED, node_mask,
+          max_node + 1, 0);
+#endif  // SYS_mbind
+}
+
+// Maps |length| bytes from the explicit huge page pool with |page_size| pages.
+static void* iree_hal_large_page_map_explicit(iree_host_size_t length,
+                                              iree_host_size_t page_size) {
+  const int page_flag =
+      page_size == IREE_HAL_LARGE_PAGE_SIZE_1GB ? MAP_HUGE_1GB : MAP_HUGE_2MB;
+  void* base =
+      mmap(NULL, length, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | page_flag, -1, 0);
+  return base == MAP_FAILED ? NULL : base;
+}
+
+// Maps |length| bytes aligned to 2MB and advises the kernel to back the range
+// with transparent huge pages.
+static void* iree_hal_large_page_map_transparent(iree_host_size_t length) {
+  // Over-reserve so that the start can be aligned and trim the excess.
+  const iree_host_size_t alignment = IREE_HAL_LARGE_PAGE_SIZE_2MB;
+  const iree_host_size_t reserve_length = length + alignment;
+  uint8_t* reserve_base =
+      (uint8_t*)mmap(NULL, reserve_length, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (reserve_base == MAP_FAILED) return NULL;
+  uint8_t* base = (uint8_t*)iree_host_align((uintptr_t)reserve_base, alignment);
+  const iree_host_size_t head_length = (iree_host_size_t)(base - reserve_base);
+  const iree_host_size_t tail_length = reserve_length - head_length - length;
+  if (head_length) munmap(reserve_base, head_length);
+  if (tail_length) munmap(base + length, tail_length);
+#if defined(MADV_HUGEPAGE)
+  // Advisory only: fails if THP is disabled and the mapping remains usable.
+  madvise(base, length, MADV_HUGEPAGE);
+#endif  // MADV_HUGEPAGE
+  return base;
+}
+
+// Returns the explicit huge page size to use for an allocation of |length|
+// bytes or 0 if explicit huge pages should not be used.
+static iree_host_size_t iree_hal_large_page_select_explicit_size(
+    iree_hal_large_page_mode_t mode, iree_host_size_t length) {
+  if (mode == IREE_HAL_LARGE_PAGE_MODE_EXPLICIT_1GB) {
+    const iree_host_size_t rounded_length =
+        iree_host_align(length, IREE_HAL_LARGE_PAGE_SIZE_1GB);
+    if (rounded_length - length <=
+        length / IREE_HAL_LARGE_PAGE_MAX_WASTE_DIVISOR) {
+      return IREE_HAL_LARGE_PAGE_SIZE_1GB;
+    }
+    mode = IREE_HAL_LARGE_PAGE_MODE_EXPLICIT_2MB;
+  }
+  if (mode == IREE_HAL_LARGE_PAGE_MODE_EXPLICIT_2MB) {
+    const iree_host_size_t rounded_length =
+        iree_host_align(length, IREE_HAL_LARGE_PAGE_SIZE_2MB);
+    if (rounded_length - length <=
+        length / IREE_HAL_LARGE_PAGE_MAX_WASTE_DIVISOR) {
+      return IREE_HAL_LARGE_PAGE_SIZE_2MB;
+    }
+  }
+  return 0;
+}
+
+// Tries to map an allocation of |byte_length| bytes with large pages.
+// Returns NULL if the system could not provide the mapping.
+static void* iree_hal_large_page_allocate_map(void* self,
+                                              iree_host_size_t byte_length) {
+  const iree_hal_large_page_mode_t mode = iree_hal_large_page_self_mode(self);
+  const iree_host_size_t normal_page_size = (iree_host_size_t)getpagesize();
+  const iree_host_size_t length = iree_host_align(
+      IREE_HAL_LARGE_PAGE_MAP_PREFIX + byte_length, normal_page_size);
+
+  // Try explicit huge pages first, falling back to smaller pages and then to
+  // transparent huge pages if the pool is exhausted.
+  iree_host_size_t page_size =
+      iree_hal_large_page_select_explicit_size(mode, length);
+  uint8_t* base = NULL;
+  iree_host_size_t mapped_length = 0;
+  while (page_size && !base) {
+    mapped_length = iree_host_align(length, page_size);
+    base = (uint8_t*)iree_hal_large_page_map_explicit(mapped_length, page_size);
+    page_size = page_size == IREE_HAL_LARGE_PAGE_SIZE_1GB
+                    ? iree_hal_large_page_select_explicit_size(
+                          IREE_HAL_LARGE_PAGE_MODE_EXPLICIT_2MB, length)
+                    : 0;
+  }
+  if (!base && mode != IREE_HAL_LARGE_PAGE_MODE_NONE) {
+    mapped_length = length;
+    base = (uint8_t*)iree_hal_large_page_map_transparent(mapped_length);
+  } else if (!base) {
+    // Only NUMA placement was requested: use normal pages.
+    mapped_length = length;
+    base = (uint8_t*)mmap(NULL, mapped_length, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == (uint8_t*)MAP_FAILED) base = NULL;
+  }
+  if (!base) return NULL;
+
+  iree_hal_large_page_bind(base, mapped_length,
+                           iree_hal_large_page_self_numa_node(self));
+
+  void* ptr = base + IREE_HAL_LARGE_PAGE_MAP_PREFIX;
+  iree_hal_large_page_header_t* header = iree_hal_large_page_header(ptr);
+  header->kind = IREE_HAL_LARGE_PAGE_KIND_MAP;
+  header->reserved = 0;
+  header->length = mapped_length;
+  return ptr;
+}
+
+static void iree_hal_large_page_free_map(void* ptr) {
+  iree_hal_large_page_header_t* header = iree_hal_large_page_header(ptr);
+  munmap((uint8_t*)ptr - IREE_HAL_LARGE_PAGE_MAP_PREFIX,
+         (iree_host_size_t)header->length);
+}
+
+#else
+
+static void* iree_hal_large_page_allocate_map(void* self,
+                                              iree_host_size_t byte_length) {
+  return NULL;
+}
+
+static void iree_hal_large_page_free_map(void* ptr) {}
+
+#endif  // IREE_HAL_LARGE_PAGE_ALLOCATOR_SUPPORTED
+
+//===----------------------------------------------------------------------===//
+// iree_allocator_ctl_fn_t
+//===----------------------------------------------------------------------===//
+
+static iree_status_t iree_hal_large_page_allocate(void* self,
+                                                  iree_host_size_t byte_length,
+                                                  bool zero, void** out_ptr) {
+  const bool map_directly =
+      iree_hal_large_page_self_mode(self) != IREE_HAL_LARGE_PAGE_MODE_NONE ||
+      iree_hal_large_page_self_numa_node(self) >= 0;
+  if (map_directly && byte_length >= IREE_HAL_LARGE_PAGE_SIZE_2MB) {
+    // Fresh mappings are always zeroed by the system.
+    void* ptr = iree_hal_large_page_allocate_map(self, byte_length);
+    if (ptr) {
+      *out_ptr = ptr;
+      return iree_ok_status();
+    }
+  }
+  return iree_hal_large_page_allocate_heap(byte_length, zero, out_ptr);
+}
+
+static void iree_hal_large_page_free(void* ptr) {
+  if (!ptr) return;
+  iree_hal_large_page_header_t* header = iree_hal_large_page_header(ptr);
+  if (header->kind == IREE_HAL_LARGE_PAGE_KIND_MAP) {
+    iree_hal_large_page_free_map(ptr);
+  } else {
+    free(header);
+  }
+}
+
+static iree_status_t iree_hal_large_page_reallocate(
+    void* self, iree_host_size_t byte_length, void** inout_ptr) {
+  void* old_ptr = *inout_ptr;
+  void* new_ptr = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_large_page_allocate(self, byte_length,
+                                                    /*zero=*/false, &new_ptr));
+  if (old_ptr) {
+    memcpy(new_ptr, old_ptr,
+           iree_min(byte_length, iree_hal_large_page_usable_length(old_ptr)));
+    iree_hal_large_page_free(old_ptr);
+  }
+  *inout_ptr = new_ptr;
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_large_page_allocator_ctl(
+    void* self, iree_allocator_command_t command, const void* params,
+    void** inout_ptr) {
+  switch (command) {
+    case IREE_ALLOCATOR_COMMAND_MALLOC:
+    case IREE_ALLOCATOR_COMMAND_CALLOC: {
+      const iree_host_size_t byte_length =
+          ((const iree_allocator_alloc_params_t*)params)->byte_length;
+      return iree_hal_large_page_allocate(
+          self, byte_length, command == IREE_ALLOCATOR_COMMAND_CALLOC,
+          inout_ptr);
+    }
+    case IREE_ALLOCATOR_COMMAND_REALLOC: {
+      const iree_host_size_t byte_length =
+          ((const iree_allocator_alloc_params_t*)params)->byte_length;
+      return iree_hal_large_page_reallocate(self, byte_length, inout_ptr);
+    }
+    case IREE_ALLOCATOR_COMMAND_FREE:
+      iree_hal_large_page_free(*inout_ptr);
+      return iree_ok_status();
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unsupported large page allocator command");
+  }
+}
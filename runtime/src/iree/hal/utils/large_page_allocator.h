@@ -0,0 +1,76 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_LARGE_PAGE_ALLOCATOR_H_
+#define IREE_HAL_UTILS_LARGE_PAGE_ALLOCATOR_H_
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_large_page_allocator_t
+//===----------------------------------------------------------------------===//
+
+// Controls whether and which large pages back large host allocations.
+typedef enum iree_hal_large_page_mode_e {
+  // Large pages are not used and all allocations come from the system heap.
+  IREE_HAL_LARGE_PAGE_MODE_NONE = 0,
+  // Transparent huge pages: allocations are mapped aligned to 2MB and advised
+  // with MADV_HUGEPAGE so the kernel can back them with huge pages.
+  IREE_HAL_LARGE_PAGE_MODE_TRANSPARENT = 1,
+  // Explicit 2MB huge pages from the reserved hugetlb pool. Falls back to
+  // transparent huge pages when the pool is exhausted or when rounding up to
+  // the page size would waste too much memory.
+  IREE_HAL_LARGE_PAGE_MODE_EXPLICIT_2MB = 2,
+  // Explicit 1GB huge pages from the reserved hugetlb pool. Falls back to
+  // explicit 2MB pages and then to transparent huge pages.
+  IREE_HAL_LARGE_PAGE_MODE_EXPLICIT_1GB = 3,
+} iree_hal_large_page_mode_t;
+
+// Parses a large page mode from one of `none`, `transparent`, `2mb`, or `1gb`.
+iree_status_t iree_hal_large_page_mode_parse(
+    iree_string_view_t value, iree_hal_large_page_mode_t* out_mode);
+
+// Options controlling large page host allocations.
+typedef struct iree_hal_large_page_allocator_options_t {
+  // Large page mode used for allocations of at least 2MB.
+  iree_hal_large_page_mode_t mode;
+  // NUMA node that allocations of at least 2MB are preferentially placed on
+  // or -1 to use the default policy of the allocating thread. Placement is a
+  // preference and allocations fall back to other nodes when the node is full.
+  // May be used with IREE_HAL_LARGE_PAGE_MODE_NONE to place normal pages.
+  int32_t numa_node;
+} iree_hal_large_page_allocator_options_t;
+
+// Initializes |out_options| to default values (no large pages).
+void iree_hal_large_page_allocator_options_initialize(
+    iree_hal_large_page_allocator_options_t* out_options);
+
+// Returns a host allocator intended for HAL heap buffer storage (as the
+// data allocator of iree_hal_allocator_create_heap) that maps allocations of
+// 2MB or more directly from the system with large pages and NUMA placement
+// based on |options|. Smaller allocations and all allocations on platforms
+// without large page support use the system heap.
+//
+// The allocator holds no state: the returned value may be copied and used
+// without lifetime restrictions. Any failure to use large pages or bind to a
+// NUMA node falls back to normal pages and the default placement.
+iree_allocator_t iree_hal_large_page_allocator(
+    const iree_hal_large_page_allocator_options_t* options);
+
+// iree_allocator_ctl_fn_t implementation of iree_hal_large_page_allocator.
+iree_status_t iree_hal_large_page_allocator_ctl(
+    void* self, iree_allocator_command_t command, const void* params,
+    void** inout_ptr);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_LARGE_PAGE_ALLOCATOR_H_
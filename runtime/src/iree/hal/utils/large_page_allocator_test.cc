@@ -0,0 +1,139 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/large_page_allocator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+static iree_allocator_t MakeAllocator(iree_hal_large_page_mode_t mode,
+                                      int32_t numa_node = -1) {
+  iree_hal_large_page_allocator_options_t options;
+  iree_hal_large_page_allocator_options_initialize(&options);
+  options.mode = mode;
+  options.numa_node = numa_node;
+  return iree_hal_large_page_allocator(&options);
+}
+
+// Fills |length| bytes at |ptr| with a pattern derived from |seed|.
+static void FillPattern(void* ptr, iree_host_size_t length, uint8_t seed) {
+  uint8_t* bytes = (uint8_t*)ptr;
+  for (iree_host_size_t i = 0; i < length; i += 4096) bytes[i] = seed + i;
+  if (length) bytes[length - 1] = seed;
+}
+
+static bool CheckPattern(void* ptr, iree_host_size_t length, uint8_t seed) {
+  uint8_t* bytes = (uint8_t*)ptr;
+  for (iree_host_size_t i = 0; i < length - 1; i += 4096) {
+    if (bytes[i] != (uint8_t)(seed + i)) return false;
+  }
+  return bytes[length - 1] == seed;
+}
+
+TEST(LargePageAllocatorTest, ParseMode) {
+  iree_hal_large_page_mode_t mode = IREE_HAL_LARGE_PAGE_MODE_EXPLICIT_1GB;
+  IREE_ASSERT_OK(iree_hal_large_page_mode_parse(IREE_SV(""), &mode));
+  EXPECT_EQ(mode, IREE_HAL_LARGE_PAGE_MODE_NONE);
+  IREE_ASSERT_OK(iree_hal_large_page_mode_parse(IREE_SV("transparent"), &mode));
+  EXPECT_EQ(mode, IREE_HAL_LARGE_PAGE_MODE_TRANSPARENT);
+  IREE_ASSERT_OK(iree_hal_large_page_mode_parse(IREE_SV("2MB"), &mode));
+  EXPECT_EQ(mode, IREE_HAL_LARGE_PAGE_MODE_EXPLICIT_2MB);
+  IREE_ASSERT_OK(iree_hal_large_page_mode_parse(IREE_SV("1gb"), &mode));
+  EXPECT_EQ(mode, IREE_HAL_LARGE_PAGE_MODE_EXPLICIT_1GB);
+  EXPECT_THAT(Status(iree_hal_large_page_mode_parse(IREE_SV("4kb"), &mode)),
+              StatusIs(StatusCode::kInvalidArgument));
+}
+
+class LargePageAllocatorModeTest
+    : public ::testing::TestWithParam<iree_hal_large_page_mode_t> {};
+
+// Allocations of every size class succeed regardless of whether the system
+// has huge pages available and are aligned and zeroed as requested.
+TEST_P(LargePageAllocatorModeTest, AllocateFree) {
+  iree_allocator_t allocator = MakeAllocator(GetParam(), /*numa_node=*/0);
+  const iree_host_size_t sizes[] = {
+      1, 4096, 2 * 1024 * 1024 - 1, 2 * 1024 * 1024, 3 * 1024 * 1024 + 7,
+      16 * 1024 * 1024,
+  };
+  for (iree_host_size_t size : sizes) {
+    void* ptr = NULL;
+    IREE_ASSERT_OK(iree_allocator_malloc(allocator, size, &ptr));
+    EXPECT_EQ((uintptr_t)ptr % iree_max_align_t, 0u);
+    uint8_t* bytes = (uint8_t*)ptr;
+    for (iree_host_size_t i = 0; i < size; i += 4096) {
+      ASSERT_EQ(bytes[i], 0) << "size " << size;
+    }
+    ASSERT_EQ(bytes[size - 1], 0);
+    FillPattern(ptr, size, (uint8_t)size);
+    EXPECT_TRUE(CheckPattern(ptr, size, (uint8_t)size));
+    iree_allocator_free(allocator, ptr);
+  }
+}
+
+// Reallocation moves data between heap and mapped allocations.
+TEST_P(LargePageAllocatorModeTest, Reallocate) {
+  iree_allocator_t allocator = MakeAllocator(GetParam());
+  void* ptr = NULL;
+  IREE_ASSERT_OK(iree_allocator_malloc(allocator, 1024, &ptr));
+  FillPattern(ptr, 1024, 1);
+  IREE_ASSERT_OK(iree_allocator_realloc(allocator, 4 * 1024 * 1024, &ptr));
+  EXPECT_TRUE(CheckPattern(ptr, 1024, 1));
+  FillPattern(ptr, 4 * 1024 * 1024, 2);
+  IREE_ASSERT_OK(iree_allocator_realloc(allocator, 8 * 1024 * 1024, &ptr));
+  EXPECT_TRUE(CheckPattern(ptr, 4 * 1024 * 1024, 2));
+  IREE_ASSERT_OK(iree_allocator_realloc(allocator, 512, &ptr));
+  EXPECT_EQ(((uint8_t*)ptr)[0], 2);
+  iree_allocator_free(allocator, ptr);
+}
+
+// Heap buffers allocated with the large page allocator as their data allocator
+// are usable through the HAL buffer APIs.
+TEST_P(LargePageAllocatorModeTest, HeapBuffers) {
+  iree_hal_allocator_t* device_allocator = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+      IREE_SV("large_pages"), MakeAllocator(GetParam()),
+      iree_allocator_system(), &device_allocator));
+  const iree_device_size_t sizes[] = {256, 8 * 1024 * 1024};
+  for (iree_device_size_t size : sizes) {
+    iree_hal_buffer_params_t params = {};
+    params.type =
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+    params.usage = IREE_HAL_BUFFER_USAGE_DEFAULT |
+                   IREE_HAL_BUFFER_USAGE_MAPPING_SCOPED;
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(device_allocator, params,
+                                                      size, &buffer));
+    IREE_ASSERT_OK(iree_hal_buffer_map_fill(buffer, 0, size, "\x5A", 1));
+    uint8_t value = 0;
+    IREE_ASSERT_OK(iree_hal_buffer_map_read(buffer, size - 1, &value, 1));
+    EXPECT_EQ(value, 0x5A);
+    iree_hal_buffer_release(buffer);
+  }
+  iree_hal_allocator_release(device_allocator);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    AllModes, LargePageAllocatorModeTest,
+    ::testing::Values(IREE_HAL_LARGE_PAGE_MODE_NONE,
+                      IREE_HAL_LARGE_PAGE_MODE_TRANSPARENT,
+                      IREE_HAL_LARGE_PAGE_MODE_EXPLICIT_2MB,
+                      IREE_HAL_LARGE_PAGE_MODE_EXPLICIT_1GB));
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
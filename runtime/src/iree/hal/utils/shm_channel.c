@@ -0,0 +1,1284 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/shm_channel.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/hal/utils/host_collectives.h"
+
+// Shared memory segments are backed by POSIX shm objects and synchronized with
+// process-shared futexes. Android lacks shm_open.
+#if defined(IREE_PLATFORM_LINUX) && !defined(IREE_PLATFORM_ANDROID) && \
+    !defined(IREE_PLATFORM_EMSCRIPTEN)
+#define IREE_HAL_SHM_CHANNEL_SUPPORTED 1
+#endif  // IREE_PLATFORM_LINUX
+
+#if defined(IREE_HAL_SHM_CHANNEL_SUPPORTED)
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif  // IREE_HAL_SHM_CHANNEL_SUPPORTED
+
+// Returns true if |var_name| is set to a non-empty value in the environment.
+static bool iree_hal_shm_env_is_set(const char* var_name) {
+  const char* var_value = getenv(var_name);
+  return var_value && strlen(var_value) > 0;
+}
+
+IREE_API_EXPORT bool iree_hal_shm_is_configured(void) {
+  return iree_hal_shm_env_is_set("IREE_SHM_CHANNEL_ID") &&
+         iree_hal_shm_env_is_set("IREE_SHM_CHANNEL_RANK") &&
+         iree_hal_shm_env_is_set("IREE_SHM_CHANNEL_COUNT");
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_shm_channel_provider_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_shm_channel_provider_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  int32_t rank;
+  int32_t count;
+  iree_host_size_t id_length;
+  uint8_t id[IREE_HAL_SHM_CHANNEL_MAX_ID_LENGTH];
+} iree_hal_shm_channel_provider_t;
+
+static const iree_hal_channel_provider_vtable_t
+    iree_hal_shm_channel_provider_vtable;
+
+static iree_hal_shm_channel_provider_t* iree_hal_shm_channel_provider_cast(
+    iree_hal_channel_provider_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_shm_channel_provider_vtable);
+  return (iree_hal_shm_channel_provider_t*)base_value;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_shm_channel_provider_create(
+    iree_string_view_t id, int32_t rank, int32_t count,
+    iree_allocator_t host_allocator,
+    iree_hal_channel_provider_t** out_channel_provider) {
+  IREE_ASSERT_ARGUMENT(out_channel_provider);
+  *out_channel_provider = NULL;
+#if !defined(IREE_HAL_SHM_CHANNEL_SUPPORTED)
+  return iree_make_status(
+      IREE_STATUS_UNAVAILABLE,
+      "shared memory channels are not supported on this platform");
+#else
+  if (iree_string_view_is_empty(id) ||
+      id.size > IREE_HAL_SHM_CHANNEL_MAX_ID_LENGTH) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "shared memory channel ID must be 1 to %d bytes",
+                            IREE_HAL_SHM_CHANNEL_MAX_ID_LENGTH);
+  }
+  if (count <= 0 || rank < 0 || rank >= count) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid channel rank %d of %d participants", rank,
+                            count);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_shm_channel_provider_t* provider = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*provider),
+                                (void**)&provider));
+  memset(provider, 0, sizeof(*provider));
+  iree_hal_resource_initialize(&iree_hal_shm_channel_provider_vtable,
+                               &provider->resource);
+  provider->host_allocator = host_allocator;
+  provider->rank = rank;
+  provider->count = count;
+  provider->id_length = id.size;
+  memcpy(provider->id, id.data, id.size);
+  *out_channel_provider = (iree_hal_channel_provider_t*)provider;
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+#endif  // IREE_HAL_SHM_CHANNEL_SUPPORTED
+}
+
+IREE_API_EXPORT iree_status_t
+iree_hal_shm_channel_provider_create_from_environment(
+    iree_allocator_t host_allocator,
+    iree_hal_channel_provider_t** out_channel_provider) {
+  IREE_ASSERT_ARGUMENT(out_channel_provider);
+  *out_channel_provider = NULL;
+  if (!iree_hal_shm_is_configured()) {
+    return iree_make_status(
+        IREE_STATUS_FAILED_PRECONDITION,
+        "IREE_SHM_CHANNEL_ID, IREE_SHM_CHANNEL_RANK, and "
+        "IREE_SHM_CHANNEL_COUNT must be set to use shared memory channels");
+  }
+  int32_t rank = 0;
+  int32_t count = 0;
+  if (!iree_string_view_atoi_int32(
+          iree_make_cstring_view(getenv("IREE_SHM_CHANNEL_RANK")), &rank) ||
+      !iree_string_view_atoi_int32(
+          iree_make_cstring_view(getenv("IREE_SHM_CHANNEL_COUNT")), &count)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "IREE_SHM_CHANNEL_RANK and IREE_SHM_CHANNEL_COUNT must be integers");
+  }
+  return iree_hal_shm_channel_provider_create(
+      iree_make_cstring_view(getenv("IREE_SHM_CHANNEL_ID")), rank, count,
+      host_allocator, out_channel_provider);
+}
+
+IREE_API_EXPORT bool iree_hal_shm_channel_provider_isa(
+    iree_hal_channel_provider_t* channel_provider) {
+  return iree_hal_resource_is(channel_provider,
+                              &iree_hal_shm_channel_provider_vtable);
+}
+
+static void iree_hal_shm_channel_provider_destroy(
+    iree_hal_channel_provider_t* base_channel_provider) {
+  iree_hal_shm_channel_provider_t* provider =
+      iree_hal_shm_channel_provider_cast(base_channel_provider);
+  iree_allocator_free(provider->host_allocator, provider);
+}
+
+static iree_status_t iree_hal_shm_channel_provider_query_default_rank_and_count(
+    iree_hal_channel_provider_t* base_channel_provider, int32_t* out_rank,
+    int32_t* out_count) {
+  iree_hal_shm_channel_provider_t* provider =
+      iree_hal_shm_channel_provider_cast(base_channel_provider);
+  *out_rank = provider->rank;
+  *out_count = provider->count;
+  return iree_ok_status();
+}
+
+// All participants are configured with the same ID so there is nothing to
+// exchange.
+static iree_status_t iree_hal_shm_channel_provider_exchange_default_id(
+    iree_hal_channel_provider_t* base_channel_provider, iree_byte_span_t id) {
+  iree_hal_shm_channel_provider_t* provider =
+      iree_hal_shm_channel_provider_cast(base_channel_provider);
+  if (id.data_length < provider->id_length) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "channel ID storage too small");
+  }
+  memset(id.data, 0, id.data_length);
+  memcpy(id.data, provider->id, provider->id_length);
+  return iree_ok_status();
+}
+
+static const iree_hal_channel_provider_vtable_t
+    iree_hal_shm_channel_provider_vtable = {
+        .destroy = iree_hal_shm_channel_provider_destroy,
+        .query_default_rank_and_count =
+            iree_hal_shm_channel_provider_query_default_rank_and_count,
+        .exchange_default_id =
+            iree_hal_shm_channel_provider_exchange_default_id,
+};
+
+//===----------------------------------------------------------------------===//
+// iree_hal_shm_channel_t
+//===----------------------------------------------------------------------===//
+
+#if !defined(IREE_HAL_SHM_CHANNEL_SUPPORTED)
+
+IREE_API_EXPORT iree_status_t iree_hal_shm_channel_create(
+    iree_hal_channel_params_t params, iree_allocator_t host_allocator,
+    iree_hal_channel_t** out_channel) {
+  IREE_ASSERT_ARGUMENT(out_channel);
+  *out_channel = NULL;
+  return iree_make_status(
+      IREE_STATUS_UNAVAILABLE,
+      "shared memory channels are not supported on this platform");
+}
+
+IREE_API_EXPORT bool iree_hal_shm_channel_isa(iree_hal_channel_t* channel) {
+  return false;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_shm_channel_collective(
+    iree_hal_channel_t* channel, iree_hal_collective_op_t op, uint32_t param,
+    iree_const_byte_span_t send, iree_byte_span_t recv,
+    iree_host_size_t element_count) {
+  return iree_make_status(
+      IREE_STATUS_UNAVAILABLE,
+      "shared memory channels are not supported on this platform");
+}
+
+#else
+
+// Identifies an initialized segment. Changed whenever the layout changes.
+#define IREE_HAL_SHM_CHANNEL_MAGIC 0x324D4853u  // 'SHM2'
+
+// Size in bytes of each staging buffer. Collectives are performed in chunks of
+// at most this many bytes per participant and step.
+#define IREE_HAL_SHM_CHANNEL_CHUNK_SIZE (256 * 1024)
+
+// Number of times a participant polls for a peer before parking on the futex.
+#define IREE_HAL_SHM_CHANNEL_SPIN_COUNT 4096
+
+// Default maximum duration a participant waits for its peers when joining and
+// within each step of a collective. Generous as participants may load large
+// parameters before their first collective. Overridden with the
+// IREE_SHM_CHANNEL_TIMEOUT_MS environment variable.
+#define IREE_HAL_SHM_CHANNEL_DEFAULT_TIMEOUT_MS (10 * 60 * 1000)
+
+// Maximum duration a participant parks on a futex before checking whether a
+// peer has aborted the channel.
+#define IREE_HAL_SHM_CHANNEL_POLL_INTERVAL_NS (10 * 1000000)
+
+// Header at the start of the shared memory segment.
+typedef struct iree_hal_shm_channel_header_t {
+  // IREE_HAL_SHM_CHANNEL_MAGIC once rank 0 has initialized the segment.
+  iree_atomic_int32_t magic;
+  int32_t count;
+  int32_t chunk_size;
+  // Nonce chosen by rank 0 identifying the run that created the segment.
+  // Participants verify that the segment linked under the name still has the
+  // session they joined such that segments left behind by prior runs are
+  // never used.
+  uint64_t session;
+  // Number of participants that have joined the segment. Futex word.
+  iree_atomic_int32_t joined_count;
+  // Set by rank 0 once all participants have joined. Futex word.
+  iree_atomic_int32_t ready;
+  // Set by any participant that failed a collective midway; all subsequent
+  // collectives on the segment fail.
+  iree_atomic_int32_t aborted;
+  // Barrier among all participants. |barrier_generation| is the futex word.
+  iree_alignas(iree_hardware_destructive_interference_size)
+      iree_atomic_int32_t barrier_arrived;
+  iree_alignas(iree_hardware_destructive_interference_size)
+      iree_atomic_int32_t barrier_generation;
+} iree_hal_shm_channel_header_t;
+
+// Sequence counters for point-to-point transfers from one participant to
+// another. |ready| is incremented by the sender when its mailbox holds a new
+// chunk and |ack| by the receiver once it has consumed it.
+typedef struct iree_hal_shm_channel_pair_t {
+  iree_alignas(iree_hardware_destructive_interference_size)
+      iree_atomic_int32_t ready;
+  iree_alignas(iree_hardware_destructive_interference_size)
+      iree_atomic_int32_t ack;
+} iree_hal_shm_channel_pair_t;
+
+// Each participant owns two staging buffers used by alternating collective
+// steps and one mailbox used by point-to-point transfers. Participants only
+// write their own buffers such that with one process per NUMA node the pages
+// are first touched on (and local to) the writer.
+#define IREE_HAL_SHM_CHANNEL_RANK_STRIDE (3 * IREE_HAL_SHM_CHANNEL_CHUNK_SIZE)
+
+typedef struct iree_hal_shm_channel_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  int32_t rank;
+  int32_t count;
+  // Maximum duration to wait for peers when joining and in each wait of a
+  // collective.
+  iree_duration_t timeout_ns;
+
+  void* mapping;
+  iree_host_size_t mapping_size;
+  iree_hal_shm_channel_header_t* header;
+  // [source * count + target] transfer counters.
+  iree_hal_shm_channel_pair_t* pairs;
+  // Per-rank buffers with a stride of IREE_HAL_SHM_CHANNEL_RANK_STRIDE.
+  uint8_t* ranks;
+
+  // Serializes collectives issued from multiple threads of this process.
+  iree_slim_mutex_t mutex;
+  // Total number of staged steps performed. All participants perform the same
+  // sequence of steps such that the parity selects the same staging buffer.
+  uint64_t step;
+  // Partial results of tree reductions.
+  uint8_t* scratch;
+} iree_hal_shm_channel_t;
+
+static const iree_hal_channel_vtable_t iree_hal_shm_channel_vtable;
+
+static iree_hal_shm_channel_t* iree_hal_shm_channel_cast(
+    iree_hal_channel_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_shm_channel_vtable);
+  return (iree_hal_shm_channel_t*)base_value;
+}
+
+static const iree_hal_shm_channel_t* iree_hal_shm_channel_const_cast(
+    const iree_hal_channel_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_shm_channel_vtable);
+  return (const iree_hal_shm_channel_t*)base_value;
+}
+
+IREE_API_EXPORT bool iree_hal_shm_channel_isa(iree_hal_channel_t* channel) {
+  return iree_hal_resource_is(channel, &iree_hal_shm_channel_vtable);
+}
+
+// Returns the timeout configured with IREE_SHM_CHANNEL_TIMEOUT_MS, if any.
+static iree_duration_t iree_hal_shm_channel_timeout_ns(void) {
+  int32_t timeout_ms = IREE_HAL_SHM_CHANNEL_DEFAULT_TIMEOUT_MS;
+  const char* timeout_str = getenv("IREE_SHM_CHANNEL_TIMEOUT_MS");
+  if (timeout_str && strlen(timeout_str) > 0) {
+    int32_t value = 0;
+    if (iree_string_view_atoi_int32(iree_make_cstring_view(timeout_str),
+                                    &value) &&
+        value > 0) {
+      timeout_ms = value;
+    }
+  }
+  return (iree_duration_t)timeout_ms * 1000000;
+}
+
+// Formats the POSIX shm object name for the segment of |id| and |group|.
+// IDs are arbitrary bytes so they are hashed (FNV-1a) into a valid name.
+static void iree_hal_shm_channel_format_name(iree_const_byte_span_t id,
+                                             iree_string_view_t group,
+                                             char* out_name,
+                                             iree_host_size_t name_capacity) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (iree_host_size_t i = 0; i < id.data_length; ++i) {
+    hash = (hash ^ id.data[i]) * 0x100000001B3ull;
+  }
+  hash *= 0x100000001B3ull;  // separator
+  for (iree_host_size_t i = 0; i < group.size; ++i) {
+    hash = (hash ^ (uint8_t)group.data[i]) * 0x100000001B3ull;
+  }
+  snprintf(out_name, name_capacity, "/iree_shm_%016" PRIx64, hash);
+}
+
+// Parks on the futex |address| for at most |timeout_ns| if it contains |value|.
+static void iree_hal_shm_futex_wait(iree_atomic_int32_t* address, int32_t value,
+                                    iree_duration_t timeout_ns) {
+  struct timespec timeout = {
+      .tv_sec = (time_t)(timeout_ns / 1000000000),
+      .tv_nsec = (long)(timeout_ns % 1000000000),
+  };
+  // NOTE: not FUTEX_PRIVATE_FLAG as waiters live in other processes.
+  syscall(SYS_futex, address, FUTEX_WAIT, value, &timeout, NULL, 0);
+}
+
+// Stores |value| to |address| and wakes all waiters.
+static void iree_hal_shm_store_and_wake(iree_atomic_int32_t* address,
+                                        int32_t value) {
+  iree_atomic_store(address, value, iree_memory_order_release);
+  syscall(SYS_futex, address, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+// Maps |mapping_size| bytes of the segment |fd| and closes |fd|.
+static iree_status_t iree_hal_shm_channel_map_fd(
+    iree_hal_shm_channel_t* channel, int fd, const char* name,
+    iree_host_size_t mapping_size) {
+  void* mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0);
+  const int mmap_errno = errno;
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return iree_make_status(iree_status_code_from_errno(mmap_errno),
+                            "failed to map shared memory segment %s", name);
+  }
+  channel->mapping = mapping;
+  channel->mapping_size = mapping_size;
+  channel->header = (iree_hal_shm_channel_header_t*)mapping;
+  return iree_ok_status();
+}
+
+static void iree_hal_shm_channel_unmap(iree_hal_shm_channel_t* channel) {
+  if (channel->mapping) munmap(channel->mapping, channel->mapping_size);
+  channel->mapping = NULL;
+  channel->mapping_size = 0;
+  channel->header = NULL;
+}
+
+// Returns a nonce identifying this run of rank 0. The process ID disambiguates
+// concurrent runs and the time disambiguates runs reusing the same ID.
+static uint64_t iree_hal_shm_channel_make_session(void) {
+  uint64_t session =
+      ((uint64_t)getpid() << 32) ^ (uint64_t)iree_time_now() ^
+      (uint64_t)(uintptr_t)&session;
+  return session ? session : 1;
+}
+
+// Returns the session of the initialized segment currently linked under |name|
+// or 0 if there is none.
+static uint64_t iree_hal_shm_channel_query_linked_session(const char* name) {
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0) return 0;
+  int32_t magic = 0;
+  uint64_t session = 0;
+  if (pread(fd, &magic, sizeof(magic),
+            offsetof(iree_hal_shm_channel_header_t, magic)) != sizeof(magic) ||
+      magic != (int32_t)IREE_HAL_SHM_CHANNEL_MAGIC ||
+      pread(fd, &session, sizeof(session),
+            offsetof(iree_hal_shm_channel_header_t, session)) !=
+          sizeof(session)) {
+    session = 0;
+  }
+  close(fd);
+  return session;
+}
+
+// Creates, maps, and initializes a new segment |name| as rank 0 and waits for
+// all other participants to join it. Any segment left behind under the same
+// name by a prior run that failed before all participants joined is replaced;
+// participants that joined it observe the new session and move over.
+static iree_status_t iree_hal_shm_channel_create_segment(
+    iree_hal_shm_channel_t* channel, const char* name,
+    iree_host_size_t mapping_size) {
+  shm_unlink(name);
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to create shared memory segment %s", name);
+  }
+  if (ftruncate(fd, (off_t)mapping_size) != 0) {
+    iree_status_t status = iree_make_status(
+        iree_status_code_from_errno(errno),
+        "failed to size shared memory segment %s to %" PRIhsz " bytes", name,
+        mapping_size);
+    close(fd);
+    shm_unlink(name);
+    return status;
+  }
+  iree_status_t status =
+      iree_hal_shm_channel_map_fd(channel, fd, name, mapping_size);
+  if (!iree_status_is_ok(status)) {
+    shm_unlink(name);
+    return status;
+  }
+
+  iree_hal_shm_channel_header_t* header = channel->header;
+  header->count = channel->count;
+  header->chunk_size = IREE_HAL_SHM_CHANNEL_CHUNK_SIZE;
+  header->session = iree_hal_shm_channel_make_session();
+  iree_atomic_store(&header->joined_count, 1, iree_memory_order_relaxed);
+  iree_atomic_store(&header->magic, (int32_t)IREE_HAL_SHM_CHANNEL_MAGIC,
+                    iree_memory_order_release);
+
+  const iree_time_t deadline_ns = iree_time_now() + channel->timeout_ns;
+  int32_t joined_count = 1;
+  while ((joined_count = iree_atomic_load(&header->joined_count,
+                                          iree_memory_order_acquire)) !=
+         channel->count) {
+    const iree_time_t now_ns = iree_time_now();
+    if (now_ns >= deadline_ns) {
+      shm_unlink(name);
+      return iree_make_status(IREE_STATUS_DEADLINE_EXCEEDED,
+                              "timed out waiting for participants to join "
+                              "shared memory segment %s; %d of %d joined",
+                              name, joined_count, channel->count);
+    }
+    iree_hal_shm_futex_wait(
+        &header->joined_count, joined_count,
+        iree_min(deadline_ns - now_ns, IREE_HAL_SHM_CHANNEL_POLL_INTERVAL_NS));
+  }
+
+  // All participants have mapped the segment so the name is no longer needed.
+  shm_unlink(name);
+  iree_hal_shm_store_and_wake(&header->ready, 1);
+  return iree_ok_status();
+}
+
+// Maps the segment |name| once rank 0 has created, sized, and initialized it
+// with a configuration matching |channel|.
+static iree_status_t iree_hal_shm_channel_map_initialized_segment(
+    iree_hal_shm_channel_t* channel, const char* name,
+    iree_host_size_t mapping_size, iree_time_t deadline_ns) {
+  iree_status_t mismatch_status = iree_ok_status();
+  for (;;) {
+    int fd = shm_open(name, O_RDWR, 0600);
+    if (fd < 0 && errno != ENOENT) {
+      iree_status_ignore(mismatch_status);
+      return iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to open shared memory segment %s", name);
+    }
+    struct stat fd_stat;
+    if (fd >= 0 && fstat(fd, &fd_stat) == 0 &&
+        (iree_host_size_t)fd_stat.st_size >= mapping_size) {
+      iree_status_t status =
+          iree_hal_shm_channel_map_fd(channel, fd, name, mapping_size);
+      if (!iree_status_is_ok(status)) {
+        iree_status_ignore(mismatch_status);
+        return status;
+      }
+    } else if (fd >= 0) {
+      // Rank 0 may not yet have sized the segment.
+      close(fd);
+    }
+    iree_hal_shm_channel_header_t* header = channel->header;
+    if (header && iree_atomic_load(&header->magic, iree_memory_order_acquire) ==
+                      (int32_t)IREE_HAL_SHM_CHANNEL_MAGIC) {
+      if (header->count == channel->count &&
+          header->chunk_size == IREE_HAL_SHM_CHANNEL_CHUNK_SIZE) {
+        iree_status_ignore(mismatch_status);
+        return iree_ok_status();
+      }
+      // May be a segment left behind by a prior run; only report the mismatch
+      // if rank 0 never replaces it.
+      iree_status_ignore(mismatch_status);
+      mismatch_status = iree_make_status(
+          IREE_STATUS_FAILED_PRECONDITION,
+          "shared memory segment %s was created for %d participants with "
+          "%d byte chunks but %d participants with %d byte chunks were "
+          "requested; all participants must use the same configuration",
+          name, header->count, header->chunk_size, channel->count,
+          IREE_HAL_SHM_CHANNEL_CHUNK_SIZE);
+    }
+    iree_hal_shm_channel_unmap(channel);
+    if (iree_time_now() >= deadline_ns) {
+      if (!iree_status_is_ok(mismatch_status)) return mismatch_status;
+      return iree_make_status(IREE_STATUS_DEADLINE_EXCEEDED,
+                              "timed out waiting for rank 0 to create "
+                              "shared memory segment %s",
+                              name);
+    }
+    iree_wait_until(iree_time_now() + 1000000);
+  }
+}
+
+// Maps and joins the segment |name| created by rank 0 and waits for rank 0 to
+// acknowledge that all participants have joined. Segments left behind by prior
+// runs are detected by the session linked under |name| changing once rank 0
+// replaces them, in which case the new segment is joined instead.
+static iree_status_t iree_hal_shm_channel_join_segment(
+    iree_hal_shm_channel_t* channel, const char* name,
+    iree_host_size_t mapping_size) {
+  const iree_time_t deadline_ns = iree_time_now() + channel->timeout_ns;
+  for (;;) {
+    IREE_RETURN_IF_ERROR(iree_hal_shm_channel_map_initialized_segment(
+        channel, name, mapping_size, deadline_ns));
+    iree_hal_shm_channel_header_t* header = channel->header;
+    const uint64_t session = header->session;
+    iree_atomic_fetch_add(&header->joined_count, 1, iree_memory_order_acq_rel);
+    syscall(SYS_futex, &header->joined_count, FUTEX_WAKE, INT_MAX, NULL, NULL,
+            0);
+
+    bool is_stale = false;
+    while (!iree_atomic_load(&header->ready, iree_memory_order_acquire)) {
+      // Rank 0 unlinks the name before acknowledging so if the name links to
+      // a different session the mapped segment will never be acknowledged.
+      const uint64_t linked_session =
+          iree_hal_shm_channel_query_linked_session(name);
+      if (linked_session != 0 && linked_session != session) {
+        is_stale = true;
+        break;
+      }
+      const iree_time_t now_ns = iree_time_now();
+      if (now_ns >= deadline_ns) {
+        return iree_make_status(IREE_STATUS_DEADLINE_EXCEEDED,
+                                "timed out waiting for all participants to "
+                                "join shared memory segment %s",
+                                name);
+      }
+      iree_hal_shm_futex_wait(&header->ready, 0,
+                              iree_min(deadline_ns - now_ns,
+                                       IREE_HAL_SHM_CHANNEL_POLL_INTERVAL_NS));
+    }
+    if (!is_stale) return iree_ok_status();
+    iree_hal_shm_channel_unmap(channel);
+  }
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_shm_channel_create(
+    iree_hal_channel_params_t params, iree_allocator_t host_allocator,
+    iree_hal_channel_t** out_channel) {
+  IREE_ASSERT_ARGUMENT(out_channel);
+  *out_channel = NULL;
+  if (params.count <= 0 || params.rank < 0 || params.rank >= params.count) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid channel rank %d of %d participants",
+                            params.rank, params.count);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, params.rank);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, params.count);
+
+  iree_hal_shm_channel_t* channel = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(
+              host_allocator,
+              sizeof(*channel) + IREE_HAL_SHM_CHANNEL_CHUNK_SIZE,
+              (void**)&channel));
+  memset(channel, 0, sizeof(*channel));
+  iree_hal_resource_initialize(&iree_hal_shm_channel_vtable,
+                               &channel->resource);
+  channel->host_allocator = host_allocator;
+  channel->rank = params.rank;
+  channel->count = params.count;
+  channel->timeout_ns = iree_hal_shm_channel_timeout_ns();
+  iree_slim_mutex_initialize(&channel->mutex);
+  channel->scratch = (uint8_t*)channel + sizeof(*channel);
+
+  // Layout: header, pair counters, then page-aligned per-rank buffers.
+  const iree_host_size_t count = (iree_host_size_t)params.count;
+  const iree_host_size_t pairs_offset =
+      iree_host_align(sizeof(iree_hal_shm_channel_header_t),
+                      iree_hardware_destructive_interference_size);
+  const iree_host_size_t ranks_offset = iree_host_align(
+      pairs_offset + count * count * sizeof(iree_hal_shm_channel_pair_t),
+      4096);
+  const iree_host_size_t mapping_size =
+      ranks_offset + count * IREE_HAL_SHM_CHANNEL_RANK_STRIDE;
+
+  char name[32];
+  iree_hal_shm_channel_format_name(params.id, params.group, name,
+                                   sizeof(name));
+  iree_status_t status =
+      channel->rank == 0
+          ? iree_hal_shm_channel_create_segment(channel, name, mapping_size)
+          : iree_hal_shm_channel_join_segment(channel, name, mapping_size);
+  if (iree_status_is_ok(status)) {
+    uint8_t* base = (uint8_t*)channel->mapping;
+    channel->pairs = (iree_hal_shm_channel_pair_t*)(base + pairs_offset);
+    channel->ranks = base + ranks_offset;
+    *out_channel = (iree_hal_channel_t*)channel;
+  } else {
+    iree_hal_channel_release((iree_hal_channel_t*)channel);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_shm_channel_destroy(iree_hal_channel_t* base_channel) {
+  iree_hal_shm_channel_t* channel = iree_hal_shm_channel_cast(base_channel);
+  iree_allocator_t host_allocator = channel->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_shm_channel_unmap(channel);
+  iree_slim_mutex_deinitialize(&channel->mutex);
+  iree_allocator_free(host_allocator, channel);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_status_t iree_hal_shm_channel_split(
+    iree_hal_channel_t* base_channel, int32_t color, int32_t key,
+    iree_hal_channel_flags_t flags, iree_hal_channel_t** out_split_channel) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "shared memory channels cannot be split; create "
+                          "channels with distinct groups instead");
+}
+
+static void iree_hal_shm_channel_query_rank_and_count(
+    const iree_hal_channel_t* base_channel, int32_t* out_rank,
+    int32_t* out_count) {
+  const iree_hal_shm_channel_t* channel =
+      iree_hal_shm_channel_const_cast(base_channel);
+  *out_rank = channel->rank;
+  *out_count = channel->count;
+}
+
+//===----------------------------------------------------------------------===//
+// Synchronization
+//===----------------------------------------------------------------------===//
+
+// Marks the segment as aborted such that all participants fail their current
+// and subsequent collectives instead of waiting for a peer that will never
+// arrive.
+static void iree_hal_shm_channel_abort(iree_hal_shm_channel_t* channel) {
+  iree_hal_shm_store_and_wake(&channel->header->aborted, 1);
+  syscall(SYS_futex, &channel->header->barrier_generation, FUTEX_WAKE, INT_MAX,
+          NULL, NULL, 0);
+}
+
+static iree_status_t iree_hal_shm_channel_check_aborted(
+    const iree_hal_shm_channel_t* channel) {
+  if (IREE_LIKELY(!iree_atomic_load(&channel->header->aborted,
+                                    iree_memory_order_acquire))) {
+    return iree_ok_status();
+  }
+  return iree_make_status(IREE_STATUS_ABORTED,
+                          "shared memory channel was aborted after a "
+                          "participant failed a collective");
+}
+
+// Blocks until |*address| no longer contains |value|. Fails if a peer aborts
+// the channel or if the peer does not arrive within the channel timeout in
+// which case the channel is aborted for all participants.
+static iree_status_t iree_hal_shm_channel_wait_while_equal(
+    iree_hal_shm_channel_t* channel, iree_atomic_int32_t* address,
+    int32_t value) {
+  for (int i = 0; i < IREE_HAL_SHM_CHANNEL_SPIN_COUNT; ++i) {
+    if (iree_atomic_load(address, iree_memory_order_acquire) != value) {
+      return iree_ok_status();
+    }
+  }
+  const iree_time_t deadline_ns = iree_time_now() + channel->timeout_ns;
+  while (iree_atomic_load(address, iree_memory_order_acquire) == value) {
+    IREE_RETURN_IF_ERROR(iree_hal_shm_channel_check_aborted(channel));
+    const iree_time_t now_ns = iree_time_now();
+    if (now_ns >= deadline_ns) {
+      iree_hal_shm_channel_abort(channel);
+      return iree_make_status(
+          IREE_STATUS_DEADLINE_EXCEEDED,
+          "timed out waiting for a peer participant after %" PRId64
+          "ms; the shared memory channel has been aborted",
+          (int64_t)(channel->timeout_ns / 1000000));
+    }
+    iree_hal_shm_futex_wait(
+        address, value,
+        iree_min(deadline_ns - now_ns, IREE_HAL_SHM_CHANNEL_POLL_INTERVAL_NS));
+  }
+  return iree_ok_status();
+}
+
+// Blocks until all participants have arrived at the barrier.
+static iree_status_t iree_hal_shm_channel_barrier(
+    iree_hal_shm_channel_t* channel) {
+  iree_hal_shm_channel_header_t* header = channel->header;
+  const int32_t generation =
+      iree_atomic_load(&header->barrier_generation, iree_memory_order_acquire);
+  if (iree_atomic_fetch_add(&header->barrier_arrived, 1,
+                            iree_memory_order_acq_rel) +
+          1 ==
+      channel->count) {
+    iree_atomic_store(&header->barrier_arrived, 0, iree_memory_order_relaxed);
+    iree_hal_shm_store_and_wake(&header->barrier_generation, generation + 1);
+    return iree_ok_status();
+  }
+  return iree_hal_shm_channel_wait_while_equal(
+      channel, &header->barrier_generation, generation);
+}
+
+// Returns the staging buffer of |rank| for the current step.
+// A step consists of each participant writing to its own staging buffer, a
+// barrier, and then participants reading from the staging buffers of peers.
+// Consecutive steps alternate buffers such that a participant can write the
+// next step while peers are still reading the current one; a buffer is only
+// rewritten after the barrier of the following step.
+static uint8_t* iree_hal_shm_channel_staging(
+    const iree_hal_shm_channel_t* channel, int32_t rank) {
+  return channel->ranks + rank * IREE_HAL_SHM_CHANNEL_RANK_STRIDE +
+         (channel->step & 1) * IREE_HAL_SHM_CHANNEL_CHUNK_SIZE;
+}
+
+// Returns the point-to-point mailbox of |rank|.
+static uint8_t* iree_hal_shm_channel_mailbox(
+    const iree_hal_shm_channel_t* channel, int32_t rank) {
+  return channel->ranks + rank * IREE_HAL_SHM_CHANNEL_RANK_STRIDE +
+         2 * IREE_HAL_SHM_CHANNEL_CHUNK_SIZE;
+}
+
+static int32_t iree_hal_shm_channel_wrap_rank(
+    const iree_hal_shm_channel_t* channel, int32_t rank) {
+  rank %= channel->count;
+  return rank < 0 ? rank + channel->count : rank;
+}
+
+//===----------------------------------------------------------------------===//
+// Collectives
+//===----------------------------------------------------------------------===//
+
+// Combines |count| elements of |source| into |target| and finalizes the
+// result if |finalize| is set.
+static void iree_hal_shm_channel_reduce(const iree_hal_shm_channel_t* channel,
+                                        iree_hal_collective_op_t op,
+                                        bool finalize, uint8_t* target,
+                                        const uint8_t* source,
+                                        iree_host_size_t count) {
+  const iree_host_size_t element_size =
+      iree_hal_collective_element_byte_count(op.element_type);
+  uint64_t acc[IREE_HAL_COLLECTIVE_ACCUMULATOR_CHUNK_LENGTH];
+  for (iree_host_size_t i = 0; i < count;
+       i += IREE_HAL_COLLECTIVE_ACCUMULATOR_CHUNK_LENGTH) {
+    const iree_host_size_t chunk_count =
+        iree_min(count - i, IREE_HAL_COLLECTIVE_ACCUMULATOR_CHUNK_LENGTH);
+    uint8_t* chunk_target = target + i * element_size;
+    iree_hal_collective_accumulator_load(op.element_type, acc, chunk_target,
+                                         chunk_count);
+    if (source) {
+      iree_hal_collective_accumulator_reduce(op.element_type, op.reduction,
+                                             acc, source + i * element_size,
+                                             chunk_count);
+    }
+    if (finalize) {
+      iree_hal_collective_accumulator_finalize(
+          op.element_type, op.reduction, channel->count, acc, chunk_count);
+    }
+    iree_hal_collective_accumulator_store(op.element_type, acc, chunk_target,
+                                          chunk_count);
+  }
+}
+
+// Ring reduce-scatter followed by a ring all-gather performed in place in
+// |recv|. Each segment of up to count chunks is split into one block per
+// participant and each step only exchanges one block with the neighbors.
+static iree_status_t iree_hal_shm_channel_all_reduce(
+    iree_hal_shm_channel_t* channel, iree_hal_collective_op_t op,
+    const uint8_t* send, uint8_t* recv, iree_host_size_t element_count) {
+  const int32_t rank = channel->rank;
+  const int32_t count = channel->count;
+  const int32_t left = iree_hal_shm_channel_wrap_rank(channel, rank - 1);
+  const iree_host_size_t element_size =
+      iree_hal_collective_element_byte_count(op.element_type);
+  const iree_host_size_t chunk_length =
+      IREE_HAL_SHM_CHANNEL_CHUNK_SIZE / element_size;
+  if (send != recv) memcpy(recv, send, element_count * element_size);
+  if (count == 1) {
+    iree_hal_shm_channel_reduce(channel, op, /*finalize=*/true, recv, NULL,
+                                element_count);
+    return iree_ok_status();
+  }
+  for (iree_host_size_t base = 0; base < element_count;
+       base += count * chunk_length) {
+    const iree_host_size_t length =
+        iree_min(element_count - base, count * chunk_length);
+    uint8_t* data = recv + base * element_size;
+#define BLOCK_BEGIN(b) (length * (iree_host_size_t)(b) / count)
+#define BLOCK_LENGTH(b) (BLOCK_BEGIN((b) + 1) - BLOCK_BEGIN(b))
+    // After count - 1 steps this participant holds the fully reduced block
+    // (rank + 1) % count.
+    for (int32_t k = 0; k < count - 1; ++k) {
+      const int32_t send_block = iree_hal_shm_channel_wrap_rank(channel, rank - k);
+      memcpy(iree_hal_shm_channel_staging(channel, rank),
+             data + BLOCK_BEGIN(send_block) * element_size,
+             BLOCK_LENGTH(send_block) * element_size);
+      IREE_RETURN_IF_ERROR(iree_hal_shm_channel_barrier(channel));
+      const int32_t recv_block =
+          iree_hal_shm_channel_wrap_rank(channel, rank - k - 1);
+      iree_hal_shm_channel_reduce(
+          channel, op, /*finalize=*/k == count - 2,
+          data + BLOCK_BEGIN(recv_block) * element_size,
+          iree_hal_shm_channel_staging(channel, left),
+          BLOCK_LENGTH(recv_block));
+      ++channel->step;
+    }
+    // Pass the reduced blocks around the ring.
+    for (int32_t k = 0; k < count - 1; ++k) {
+      const int32_t send_block =
+          iree_hal_shm_channel_wrap_rank(channel, rank + 1 - k);
+      memcpy(iree_hal_shm_channel_staging(channel, rank),
+             data + BLOCK_BEGIN(send_block) * element_size,
+             BLOCK_LENGTH(send_block) * element_size);
+      IREE_RETURN_IF_ERROR(iree_hal_shm_channel_barrier(channel));
+      const int32_t recv_block = iree_hal_shm_channel_wrap_rank(channel, rank - k);
+      memcpy(data + BLOCK_BEGIN(recv_block) * element_size,
+             iree_hal_shm_channel_staging(channel, left),
+             BLOCK_LENGTH(recv_block) * element_size);
+      ++channel->step;
+    }
+#undef BLOCK_LENGTH
+#undef BLOCK_BEGIN
+  }
+  return iree_ok_status();
+}
+
+// Ring reduce-scatter where each participant receives the block matching its
+// rank. The partial result passed around the ring is kept in |recv|.
+static iree_status_t iree_hal_shm_channel_reduce_scatter(
+    iree_hal_shm_channel_t* channel, iree_hal_collective_op_t op,
+    const uint8_t* send, uint8_t* recv, iree_host_size_t element_count) {
+  const int32_t rank = channel->rank;
+  const int32_t count = channel->count;
+  const int32_t left = iree_hal_shm_channel_wrap_rank(channel, rank - 1);
+  const iree_host_size_t element_size =
+      iree_hal_collective_element_byte_count(op.element_type);
+  const iree_host_size_t chunk_length =
+      IREE_HAL_SHM_CHANNEL_CHUNK_SIZE / element_size;
+  for (iree_host_size_t offset = 0; offset < element_count;
+       offset += chunk_length) {
+    const iree_host_size_t length =
+        iree_min(element_count - offset, chunk_length);
+    const iree_host_size_t byte_length = length * element_size;
+    uint8_t* partial = recv + offset * element_size;
+#define SEND_BLOCK(b) \
+  (send + ((iree_host_size_t)(b) * element_count + offset) * element_size)
+    if (count == 1) {
+      memcpy(partial, SEND_BLOCK(0), byte_length);
+      iree_hal_shm_channel_reduce(channel, op, /*finalize=*/true, partial,
+                                  NULL, length);
+      continue;
+    }
+    // Step k receives the partial of block (rank - k - 2) from the left,
+    // combines it with the local contribution, and passes it on in step k + 1.
+    for (int32_t k = 0; k < count - 1; ++k) {
+      const int32_t send_block =
+          iree_hal_shm_channel_wrap_rank(channel, rank - k - 1);
+      memcpy(iree_hal_shm_channel_staging(channel, rank),
+             k == 0 ? SEND_BLOCK(send_block) : partial, byte_length);
+      IREE_RETURN_IF_ERROR(iree_hal_shm_channel_barrier(channel));
+      const int32_t recv_block =
+          iree_hal_shm_channel_wrap_rank(channel, rank - k - 2);
+      memcpy(partial, SEND_BLOCK(recv_block), byte_length);
+      iree_hal_shm_channel_reduce(channel, op, /*finalize=*/k == count - 2,
+                                  partial,
+                                  iree_hal_shm_channel_staging(channel, left),
+                                  length);
+      ++channel->step;
+    }
+#undef SEND_BLOCK
+  }
+  return iree_ok_status();
+}
+
+// Ring all-gather where each step forwards the block received in the prior
+// step to the right.
+static iree_status_t iree_hal_shm_channel_all_gather(
+    iree_hal_shm_channel_t* channel, iree_hal_collective_op_t op,
+    const uint8_t* send, uint8_t* recv, iree_host_size_t element_count) {
+  const int32_t rank = channel->rank;
+  const int32_t count = channel->count;
+  const int32_t left = iree_hal_shm_channel_wrap_rank(channel, rank - 1);
+  const iree_host_size_t element_size =
+      iree_hal_collective_element_byte_count(op.element_type);
+  const iree_host_size_t chunk_length =
+      IREE_HAL_SHM_CHANNEL_CHUNK_SIZE / element_size;
+  for (iree_host_size_t offset = 0; offset < element_count;
+       offset += chunk_length) {
+    const iree_host_size_t byte_length =
+        iree_min(element_count - offset, chunk_length) * element_size;
+#define RECV_BLOCK(b) \
+  (recv + ((iree_host_size_t)(b) * element_count + offset) * element_size)
+    if (RECV_BLOCK(rank) != send + offset * element_size) {
+      memcpy(RECV_BLOCK(rank), send + offset * element_size, byte_length);
+    }
+    for (int32_t k = 0; k < count - 1; ++k) {
+      const int32_t send_block = iree_hal_shm_channel_wrap_rank(channel, rank - k);
+      memcpy(iree_hal_shm_channel_staging(channel, rank),
+             RECV_BLOCK(send_block), byte_length);
+      IREE_RETURN_IF_ERROR(iree_hal_shm_channel_barrier(channel));
+      const int32_t recv_block =
+          iree_hal_shm_channel_wrap_rank(channel, rank - k - 1);
+      memcpy(RECV_BLOCK(recv_block),
+             iree_hal_shm_channel_staging(channel, left), byte_length);
+      ++channel->step;
+    }
+#undef RECV_BLOCK
+  }
+  return iree_ok_status();
+}
+
+// Pairwise exchange where in step k each participant sends to rank + k and
+// receives from rank - k.
+static iree_status_t iree_hal_shm_channel_all_to_all(
+    iree_hal_shm_channel_t* channel, iree_hal_collective_op_t op,
+    const uint8_t* send, uint8_t* recv, iree_host_size_t element_count) {
+  const int32_t rank = channel->rank;
+  const int32_t count = channel->count;
+  const iree_host_size_t element_size =
+      iree_hal_collective_element_byte_count(op.element_type);
+  const iree_host_size_t chunk_length =
+      IREE_HAL_SHM_CHANNEL_CHUNK_SIZE / element_size;
+  const iree_host_size_t block_length = element_count / count;
+  for (iree_host_size_t offset = 0; offset < block_length;
+       offset += chunk_length) {
+    const iree_host_size_t byte_length =
+        iree_min(block_length - offset, chunk_length) * element_size;
+#define BLOCK_OFFSET(b) \
+  (((iree_host_size_t)(b) * block_length + offset) * element_size)
+    memcpy(recv + BLOCK_OFFSET(rank), send + BLOCK_OFFSET(rank), byte_length);
+    for (int32_t k = 1; k < count; ++k) {
+      const int32_t target = iree_hal_shm_channel_wrap_rank(channel, rank + k);
+      memcpy(iree_hal_shm_channel_staging(channel, rank),
+             send + BLOCK_OFFSET(target), byte_length);
+      IREE_RETURN_IF_ERROR(iree_hal_shm_channel_barrier(channel));
+      const int32_t source = iree_hal_shm_channel_wrap_rank(channel, rank - k);
+      memcpy(recv + BLOCK_OFFSET(source),
+             iree_hal_shm_channel_staging(channel, source), byte_length);
+      ++channel->step;
+    }
+#undef BLOCK_OFFSET
+  }
+  return iree_ok_status();
+}
+
+// Binomial tree broadcast from |root|. In the round with |mask| participants
+// with a virtual rank below |mask| forward the data to virtual rank + |mask|.
+static iree_status_t iree_hal_shm_channel_broadcast(
+    iree_hal_shm_channel_t* channel, iree_hal_collective_op_t op, int32_t root,
+    const uint8_t* send, uint8_t* recv, iree_host_size_t element_count) {
+  const int32_t rank = channel->rank;
+  const int32_t count = channel->count;
+  const int32_t virtual_rank = iree_hal_shm_channel_wrap_rank(channel, rank - root);
+  const iree_host_size_t element_size =
+      iree_hal_collective_element_byte_count(op.element_type);
+  const iree_host_size_t chunk_length =
+      IREE_HAL_SHM_CHANNEL_CHUNK_SIZE / element_size;
+  for (iree_host_size_t offset = 0; offset < element_count;
+       offset += chunk_length) {
+    const iree_host_size_t byte_length =
+        iree_min(element_count - offset, chunk_length) * element_size;
+    const uint8_t* data = rank == root ? send + offset * element_size
+                                       : recv + offset * element_size;
+    for (int32_t mask = 1; mask < count; mask <<= 1) {
+      if (virtual_rank < mask && virtual_rank + mask < count) {
+        memcpy(iree_hal_shm_channel_staging(channel, rank), data,
+               byte_length);
+      }
+      IREE_RETURN_IF_ERROR(iree_hal_shm_channel_barrier(channel));
+      if (virtual_rank >= mask && virtual_rank < 2 * mask) {
+        const int32_t source =
+            iree_hal_shm_channel_wrap_rank(channel, virtual_rank - mask + root);
+        memcpy(recv + offset * element_size,
+               iree_hal_shm_channel_staging(channel, source), byte_length);
+      }
+      ++channel->step;
+    }
+  }
+  return iree_ok_status();
+}
+
+// Binomial tree reduction to |root|. In the round with |mask| participants
+// with a virtual rank that is an odd multiple of |mask| send their partial
+// result to virtual rank - |mask|.
+static iree_status_t iree_hal_shm_channel_reduce_to_root(
+    iree_hal_shm_channel_t* channel, iree_hal_collective_op_t op, int32_t root,
+    const uint8_t* send, uint8_t* recv, iree_host_size_t element_count) {
+  const int32_t rank = channel->rank;
+  const int32_t count = channel->count;
+  const int32_t virtual_rank = iree_hal_shm_channel_wrap_rank(channel, rank - root);
+  const iree_host_size_t element_size =
+      iree_hal_collective_element_byte_count(op.element_type);
+  const iree_host_size_t chunk_length =
+      IREE_HAL_SHM_CHANNEL_CHUNK_SIZE / element_size;
+  uint8_t* partial = channel->scratch;
+  for (iree_host_size_t offset = 0; offset < element_count;
+       offset += chunk_length) {
+    const iree_host_size_t length =
+        iree_min(element_count - offset, chunk_length);
+    const iree_host_size_t byte_length = length * element_size;
+    memcpy(partial, send + offset * element_size, byte_length);
+    for (int32_t mask = 1; mask < count; mask <<= 1) {
+      const int32_t position = virtual_rank & (2 * mask - 1);
+      if (position == mask) {
+        memcpy(iree_hal_shm_channel_staging(channel, rank), partial,
+               byte_length);
+      }
+      IREE_RETURN_IF_ERROR(iree_hal_shm_channel_barrier(channel));
+      if (position == 0 && virtual_rank + mask < count) {
+        const int32_t source =
+            iree_hal_shm_channel_wrap_rank(channel, virtual_rank + mask + root);
+        iree_hal_shm_channel_reduce(
+            channel, op, /*finalize=*/false, partial,
+            iree_hal_shm_channel_staging(channel, source), length);
+      }
+      ++channel->step;
+    }
+    if (rank == root) {
+      iree_hal_shm_channel_reduce(channel, op, /*finalize=*/true, partial,
+                                  NULL, length);
+      memcpy(recv + offset * element_size, partial, byte_length);
+    }
+  }
+  return iree_ok_status();
+}
+
+// Begins sending one chunk of |byte_length| bytes from |data| to |target| and
+// returns the sequence number to pass to
+// iree_hal_shm_channel_send_chunk_end.
+static int32_t iree_hal_shm_channel_send_chunk_begin(
+    iree_hal_shm_channel_t* channel, int32_t target, const uint8_t* data,
+    iree_host_size_t byte_length) {
+  iree_hal_shm_channel_pair_t* pair =
+      &channel->pairs[channel->rank * channel->count + target];
+  const int32_t sequence =
+      iree_atomic_load(&pair->ready, iree_memory_order_relaxed) + 1;
+  memcpy(iree_hal_shm_channel_mailbox(channel, channel->rank), data,
+         byte_length);
+  iree_hal_shm_store_and_wake(&pair->ready, sequence);
+  return sequence;
+}
+
+// Waits for |target| to have consumed the chunk sent with |sequence| such that
+// the mailbox can be reused.
+static iree_status_t iree_hal_shm_channel_send_chunk_end(
+    iree_hal_shm_channel_t* channel, int32_t target, int32_t sequence) {
+  iree_hal_shm_channel_pair_t* pair =
+      &channel->pairs[channel->rank * channel->count + target];
+  return iree_hal_shm_channel_wait_while_equal(channel, &pair->ack,
+                                               sequence - 1);
+}
+
+// Receives one chunk of |byte_length| bytes from |source| into |data|.
+static iree_status_t iree_hal_shm_channel_recv_chunk(
+    iree_hal_shm_channel_t* channel, int32_t source, uint8_t* data,
+    iree_host_size_t byte_length) {
+  iree_hal_shm_channel_pair_t* pair =
+      &channel->pairs[source * channel->count + channel->rank];
+  const int32_t sequence =
+      iree_atomic_load(&pair->ack, iree_memory_order_relaxed);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_shm_channel_wait_while_equal(channel, &pair->ready, sequence));
+  memcpy(data, iree_hal_shm_channel_mailbox(channel, source), byte_length);
+  iree_hal_shm_store_and_wake(&pair->ack, sequence + 1);
+  return iree_ok_status();
+}
+
+// Point-to-point transfer to |target| and from |source|, either of which may
+// be -1. Receiving without a source zero-fills |recv|.
+static iree_status_t iree_hal_shm_channel_send_recv(
+    iree_hal_shm_channel_t* channel, int32_t target, int32_t source,
+    const uint8_t* send, uint8_t* recv, iree_host_size_t byte_length) {
+  if (recv && source < 0) {
+    memset(recv, 0, byte_length);
+    recv = NULL;
+  }
+  for (iree_host_size_t offset = 0; offset < byte_length;
+       offset += IREE_HAL_SHM_CHANNEL_CHUNK_SIZE) {
+    const iree_host_size_t chunk_length =
+        iree_min(byte_length - offset, IREE_HAL_SHM_CHANNEL_CHUNK_SIZE);
+    // Publish before receiving so that rings of transfers make progress.
+    int32_t sequence = 0;
+    if (target >= 0) {
+      sequence = iree_hal_shm_channel_send_chunk_begin(channel, target,
+                                                       send + offset,
+                                                       chunk_length);
+    }
+    if (recv) {
+      IREE_RETURN_IF_ERROR(iree_hal_shm_channel_recv_chunk(
+          channel, source, recv + offset, chunk_length));
+    }
+    if (target >= 0) {
+      IREE_RETURN_IF_ERROR(
+          iree_hal_shm_channel_send_chunk_end(channel, target, sequence));
+    }
+  }
+  return iree_ok_status();
+}
+
+// Verifies that |op| is supported and its ranks are in range.
+static iree_status_t iree_hal_shm_channel_verify_op(
+    const iree_hal_shm_channel_t* channel, iree_hal_collective_op_t op,
+    uint32_t param, iree_host_size_t element_count) {
+  switch (op.kind) {
+    case IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE:
+    case IREE_HAL_COLLECTIVE_KIND_REDUCE:
+    case IREE_HAL_COLLECTIVE_KIND_REDUCE_SCATTER:
+      if (op.reduction == IREE_HAL_COLLECTIVE_REDUCTION_NONE ||
+          op.reduction > IREE_HAL_COLLECTIVE_REDUCTION_MAX_VALUE) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "unsupported collective reduction %u",
+                                op.reduction);
+      }
+      break;
+    default:
+      break;
+  }
+  if (op.element_type > IREE_HAL_COLLECTIVE_ELEMENT_TYPE_MAX_VALUE) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "unsupported collective element type %u",
+                            op.element_type);
+  }
+  switch (op.kind) {
+    case IREE_HAL_COLLECTIVE_KIND_BROADCAST:
+    case IREE_HAL_COLLECTIVE_KIND_REDUCE:
+    case IREE_HAL_COLLECTIVE_KIND_SEND:
+    case IREE_HAL_COLLECTIVE_KIND_RECV:
+      if (param >= (uint32_t)channel->count) {
+        return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                "rank %u out of range of %d participants",
+                                param, channel->count);
+      }
+      break;
+    case IREE_HAL_COLLECTIVE_KIND_SEND_RECV: {
+      int32_t target = -1;
+      int32_t source = -1;
+      iree_hal_collective_send_recv_ranks(param, &target, &source);
+      if (target >= channel->count || source >= channel->count) {
+        return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                "peer rank out of range of %d participants",
+                                channel->count);
+      }
+      break;
+    }
+    case IREE_HAL_COLLECTIVE_KIND_ALL_TO_ALL:
+      if (element_count % channel->count != 0) {
+        return iree_make_status(
+            IREE_STATUS_INVALID_ARGUMENT,
+            "all-to-all element count %" PRIhsz
+            " must be divisible by the participant count %d",
+            element_count, channel->count);
+      }
+      break;
+    default:
+      break;
+  }
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_shm_channel_collective(
+    iree_hal_channel_t* base_channel, iree_hal_collective_op_t op,
+    uint32_t param, iree_const_byte_span_t send, iree_byte_span_t recv,
+    iree_host_size_t element_count) {
+  iree_hal_shm_channel_t* channel = iree_hal_shm_channel_cast(base_channel);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, element_count);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_shm_channel_verify_op(channel, op, param, element_count));
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_collective_verify_buffer_lengths(
+              op, param, channel->rank, channel->count, element_count,
+              send.data_length, recv.data_length));
+
+  const iree_host_size_t byte_length =
+      element_count * iree_hal_collective_element_byte_count(op.element_type);
+  iree_slim_mutex_lock(&channel->mutex);
+  // Participants that failed midway leave the shared state inconsistent so
+  // the channel cannot be used again.
+  iree_status_t status = iree_hal_shm_channel_check_aborted(channel);
+  if (iree_status_is_ok(status)) {
+    switch (op.kind) {
+      case IREE_HAL_COLLECTIVE_KIND_ALL_GATHER:
+        status = iree_hal_shm_channel_all_gather(channel, op, send.data,
+                                                 recv.data, element_count);
+        break;
+      case IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE:
+        status = iree_hal_shm_channel_all_reduce(channel, op, send.data,
+                                                 recv.data, element_count);
+        break;
+      case IREE_HAL_COLLECTIVE_KIND_ALL_TO_ALL:
+        status = iree_hal_shm_channel_all_to_all(channel, op, send.data,
+                                                 recv.data, element_count);
+        break;
+      case IREE_HAL_COLLECTIVE_KIND_BROADCAST:
+        status = iree_hal_shm_channel_broadcast(
+            channel, op, (int32_t)param, send.data, recv.data, element_count);
+        break;
+      case IREE_HAL_COLLECTIVE_KIND_REDUCE:
+        status = iree_hal_shm_channel_reduce_to_root(
+            channel, op, (int32_t)param, send.data, recv.data, element_count);
+        break;
+      case IREE_HAL_COLLECTIVE_KIND_REDUCE_SCATTER:
+        status = iree_hal_shm_channel_reduce_scatter(channel, op, send.data,
+                                                     recv.data, element_count);
+        break;
+      case IREE_HAL_COLLECTIVE_KIND_SEND:
+        status = iree_hal_shm_channel_send_recv(channel, (int32_t)param, -1,
+                                                send.data, NULL, byte_length);
+        break;
+      case IREE_HAL_COLLECTIVE_KIND_RECV:
+        status = iree_hal_shm_channel_send_recv(channel, -1, (int32_t)param,
+                                                NULL, recv.data, byte_length);
+        break;
+      case IREE_HAL_COLLECTIVE_KIND_SEND_RECV: {
+        int32_t target = -1;
+        int32_t source = -1;
+        iree_hal_collective_send_recv_ranks(param, &target, &source);
+        status = iree_hal_shm_channel_send_recv(channel, target, source,
+                                                send.data, recv.data,
+                                                byte_length);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+  iree_slim_mutex_unlock(&channel->mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static const iree_hal_channel_vtable_t iree_hal_shm_channel_vtable = {
+    .destroy = iree_hal_shm_channel_destroy,
+    .split = iree_hal_shm_channel_split,
+    .query_rank_and_count = iree_hal_shm_channel_query_rank_and_count,
+};
+
+#endif  // IREE_HAL_SHM_CHANNEL_SUPPORTED
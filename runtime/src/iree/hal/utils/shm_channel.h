@@ -0,0 +1,97 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_SHM_CHANNEL_H_
+#define IREE_HAL_UTILS_SHM_CHANNEL_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_shm_channel_provider_t
+//===----------------------------------------------------------------------===//
+
+// Maximum length in bytes of a shared memory channel provider ID.
+#define IREE_HAL_SHM_CHANNEL_MAX_ID_LENGTH 128
+
+// Returns true if shared memory collectives have been configured by the user
+// and should be used. This checks for the IREE_SHM_CHANNEL_ID,
+// IREE_SHM_CHANNEL_RANK, and IREE_SHM_CHANNEL_COUNT environment variables.
+IREE_API_EXPORT bool iree_hal_shm_is_configured(void);
+
+// Creates a channel provider for processes on the same host that communicate
+// through POSIX shared memory. Each process should assign a unique |rank| in
+// `[0, count)` and all processes in the group must use the same |id|. Default
+// channels created by devices using the provider will join the group.
+//
+// Only supported on Linux; other platforms will return
+// IREE_STATUS_UNAVAILABLE.
+IREE_API_EXPORT iree_status_t iree_hal_shm_channel_provider_create(
+    iree_string_view_t id, int32_t rank, int32_t count,
+    iree_allocator_t host_allocator,
+    iree_hal_channel_provider_t** out_channel_provider);
+
+// Creates a shared memory channel provider configured from the environment
+// variables checked by iree_hal_shm_is_configured.
+IREE_API_EXPORT iree_status_t
+iree_hal_shm_channel_provider_create_from_environment(
+    iree_allocator_t host_allocator,
+    iree_hal_channel_provider_t** out_channel_provider);
+
+// Returns true if |channel_provider| is a shared memory channel provider.
+IREE_API_EXPORT bool iree_hal_shm_channel_provider_isa(
+    iree_hal_channel_provider_t* channel_provider);
+
+//===----------------------------------------------------------------------===//
+// iree_hal_shm_channel_t
+//===----------------------------------------------------------------------===//
+
+// Creates a channel for |params.rank| of |params.count| participants that
+// communicates through a shared memory segment identified by |params.id| and
+// |params.group|. The rank and count must be resolved by the caller.
+//
+// Participants may live in different processes. Rank 0 creates the segment
+// and all participants block until every participant has joined it. Rank 0
+// stamps the segment with a per-run session nonce and participants verify it
+// on join such that segments left behind under the same name by a prior run
+// are never used. The segment name is removed once all participants have
+// joined such that no state is left behind after the channels are released.
+//
+// Joining and each wait on a peer within a collective fail with
+// IREE_STATUS_DEADLINE_EXCEEDED after a timeout that defaults to 10 minutes and
+// can be overridden with the IREE_SHM_CHANNEL_TIMEOUT_MS environment variable.
+// A participant that times out aborts the channel and all subsequent
+// collectives on it by any participant fail with IREE_STATUS_ABORTED.
+IREE_API_EXPORT iree_status_t iree_hal_shm_channel_create(
+    iree_hal_channel_params_t params, iree_allocator_t host_allocator,
+    iree_hal_channel_t** out_channel);
+
+// Returns true if |channel| is a shared memory channel.
+IREE_API_EXPORT bool iree_hal_shm_channel_isa(iree_hal_channel_t* channel);
+
+// Synchronously performs the collective |op| with |param| on |element_count|
+// elements in |send| and |recv| as defined by iree_hal_collective_kind_t.
+// Blocks the calling thread until this participant has completed its portion
+// of the operation and all peers are done reading |send|.
+//
+// Reductions use ring algorithms and broadcasts/reductions to a root use
+// binomial trees such that each participant only exchanges data with a few
+// peers per step. Collectives on a channel must be performed in the same order
+// by all participants.
+IREE_API_EXPORT iree_status_t iree_hal_shm_channel_collective(
+    iree_hal_channel_t* channel, iree_hal_collective_op_t op, uint32_t param,
+    iree_const_byte_span_t send, iree_byte_span_t recv,
+    iree_host_size_t element_count);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_SHM_CHANNEL_H_
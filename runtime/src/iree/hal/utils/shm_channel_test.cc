@@ -0,0 +1,602 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/shm_channel.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+#if defined(IREE_PLATFORM_LINUX)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif  // IREE_PLATFORM_LINUX
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+// Participants are threads in this process unless noted otherwise; the
+// channel does not distinguish them from participants in other processes.
+class ShmChannelTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+#if defined(IREE_PLATFORM_LINUX)
+    unsetenv("IREE_SHM_CHANNEL_TIMEOUT_MS");
+#endif  // IREE_PLATFORM_LINUX
+  }
+
+  iree_hal_channel_params_t MakeParams(int32_t rank, int32_t count,
+                                       const std::string& group) {
+    iree_hal_channel_params_t params = {};
+    params.rank = rank;
+    params.count = count;
+    params.id = iree_make_const_byte_span(id_.data(), id_.size());
+    params.group = iree_make_string_view(group.data(), group.size());
+    return params;
+  }
+
+  // Creates |count| channels in |group| concurrently. Rank 0 is created after
+  // |rank0_delay_ms| to exercise participants joining before it.
+  iree_status_t CreateChannels(int32_t count, const std::string& group,
+                               std::vector<iree_hal_channel_t*>* out_channels,
+                               int rank0_delay_ms = 0) {
+    std::vector<iree_hal_channel_t*> channels(count, nullptr);
+    std::vector<iree_status_t> statuses(count, iree_ok_status());
+    std::vector<std::thread> threads;
+    for (int32_t rank = count - 1; rank >= 0; --rank) {
+      threads.emplace_back([&, rank]() {
+        if (rank == 0 && rank0_delay_ms) {
+          std::this_thread::sleep_for(
+              std::chrono::milliseconds(rank0_delay_ms));
+        }
+        statuses[rank] = iree_hal_shm_channel_create(
+            MakeParams(rank, count, group), iree_allocator_system(),
+            &channels[rank]);
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    iree_status_t status = iree_ok_status();
+    for (auto& rank_status : statuses) {
+      if (iree_status_is_ok(status)) {
+        status = rank_status;
+      } else {
+        iree_status_ignore(rank_status);
+      }
+    }
+    if (iree_status_is_ok(status)) {
+      *out_channels = std::move(channels);
+    } else {
+      for (auto* channel : channels) iree_hal_channel_release(channel);
+    }
+    return status;
+  }
+
+  // Creates |count| channels in |group| and runs |fn| on each concurrently.
+  void RunParticipants(
+      int32_t count, const std::string& group,
+      std::function<void(int32_t rank, iree_hal_channel_t* channel)> fn,
+      int rank0_delay_ms = 0) {
+    std::vector<iree_hal_channel_t*> channels;
+    iree_status_t status =
+        CreateChannels(count, group, &channels, rank0_delay_ms);
+    if (iree_status_is_unavailable(status)) {
+      iree_status_ignore(status);
+      GTEST_SKIP() << "shared memory channels unavailable";
+    }
+    IREE_ASSERT_OK(status);
+    std::vector<std::thread> threads;
+    for (int32_t rank = 0; rank < count; ++rank) {
+      threads.emplace_back([&, rank]() { fn(rank, channels[rank]); });
+    }
+    for (auto& thread : threads) thread.join();
+    for (auto* channel : channels) iree_hal_channel_release(channel);
+  }
+
+  // Runs |fn| on |count| participants in a new group.
+  void RunParticipants(
+      int32_t count,
+      std::function<void(int32_t rank, iree_hal_channel_t* channel)> fn) {
+    RunParticipants(count, std::to_string(++group_ordinal_), fn);
+  }
+
+  static iree_hal_collective_op_t MakeOp(
+      iree_hal_collective_kind_t kind,
+      iree_hal_collective_reduction_t reduction =
+          IREE_HAL_COLLECTIVE_REDUCTION_NONE) {
+    iree_hal_collective_op_t op = {};
+    op.kind = kind;
+    op.reduction = reduction;
+    op.element_type = IREE_HAL_COLLECTIVE_ELEMENT_TYPE_FLOAT_32;
+    return op;
+  }
+
+  static float Value(int32_t rank, size_t i) {
+    return static_cast<float>(rank * 7 + static_cast<int32_t>(i % 13));
+  }
+
+  std::string id_ = "shm_channel_test_" + std::to_string(
+                                              reinterpret_cast<uintptr_t>(this));
+  int group_ordinal_ = 0;
+};
+
+TEST_F(ShmChannelTest, AllReduce) {
+  // Large enough to span multiple staging chunks.
+  constexpr size_t kElementCount = 300007;
+  for (int32_t count : {1, 2, 3, 4}) {
+    RunParticipants(count, [&](int32_t rank, iree_hal_channel_t* channel) {
+      std::vector<float> send(kElementCount);
+      std::vector<float> recv(kElementCount);
+      for (size_t i = 0; i < kElementCount; ++i) send[i] = Value(rank, i);
+      IREE_ASSERT_OK(iree_hal_shm_channel_collective(
+          channel,
+          MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE,
+                 IREE_HAL_COLLECTIVE_REDUCTION_SUM),
+          0, iree_make_const_byte_span(send.data(), send.size() * 4),
+          iree_make_byte_span(recv.data(), recv.size() * 4), kElementCount));
+      for (size_t i = 0; i < kElementCount; ++i) {
+        float expected = 0.0f;
+        for (int32_t r = 0; r < count; ++r) expected += Value(r, i);
+        ASSERT_EQ(recv[i], expected) << "element " << i;
+      }
+    });
+  }
+}
+
+TEST_F(ShmChannelTest, AllGather) {
+  constexpr int32_t kCount = 3;
+  constexpr size_t kElementCount = 1001;
+  RunParticipants(kCount, [&](int32_t rank, iree_hal_channel_t* channel) {
+    std::vector<float> send(kElementCount);
+    std::vector<float> recv(kElementCount * kCount);
+    for (size_t i = 0; i < kElementCount; ++i) send[i] = Value(rank, i);
+    IREE_ASSERT_OK(iree_hal_shm_channel_collective(
+        channel, MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_GATHER), 0,
+        iree_make_const_byte_span(send.data(), send.size() * 4),
+        iree_make_byte_span(recv.data(), recv.size() * 4), kElementCount));
+    for (int32_t r = 0; r < kCount; ++r) {
+      for (size_t i = 0; i < kElementCount; ++i) {
+        ASSERT_EQ(recv[r * kElementCount + i], Value(r, i));
+      }
+    }
+  });
+}
+
+TEST_F(ShmChannelTest, ReduceScatter) {
+  constexpr int32_t kCount = 4;
+  constexpr size_t kElementCount = 513;
+  RunParticipants(kCount, [&](int32_t rank, iree_hal_channel_t* channel) {
+    std::vector<float> send(kElementCount * kCount);
+    std::vector<float> recv(kElementCount);
+    for (int32_t block = 0; block < kCount; ++block) {
+      for (size_t i = 0; i < kElementCount; ++i) {
+        send[block * kElementCount + i] = Value(rank, i) * (block + 1);
+      }
+    }
+    IREE_ASSERT_OK(iree_hal_shm_channel_collective(
+        channel,
+        MakeOp(IREE_HAL_COLLECTIVE_KIND_REDUCE_SCATTER,
+               IREE_HAL_COLLECTIVE_REDUCTION_SUM),
+        0, iree_make_const_byte_span(send.data(), send.size() * 4),
+        iree_make_byte_span(recv.data(), recv.size() * 4), kElementCount));
+    for (size_t i = 0; i < kElementCount; ++i) {
+      float expected = 0.0f;
+      for (int32_t r = 0; r < kCount; ++r) expected += Value(r, i) * (rank + 1);
+      ASSERT_EQ(recv[i], expected);
+    }
+  });
+}
+
+TEST_F(ShmChannelTest, BroadcastAndReduce) {
+  constexpr int32_t kCount = 5;
+  constexpr size_t kElementCount = 77;
+  RunParticipants(kCount, [&](int32_t rank, iree_hal_channel_t* channel) {
+    for (int32_t root = 0; root < kCount; ++root) {
+      std::vector<float> send(kElementCount);
+      std::vector<float> recv(kElementCount, -1.0f);
+      for (size_t i = 0; i < kElementCount; ++i) send[i] = Value(rank, i);
+      IREE_ASSERT_OK(iree_hal_shm_channel_collective(
+          channel, MakeOp(IREE_HAL_COLLECTIVE_KIND_BROADCAST), root,
+          iree_make_const_byte_span(send.data(), send.size() * 4),
+          iree_make_byte_span(recv.data(), recv.size() * 4), kElementCount));
+      if (rank != root) {
+        for (size_t i = 0; i < kElementCount; ++i) {
+          ASSERT_EQ(recv[i], Value(root, i));
+        }
+      }
+      IREE_ASSERT_OK(iree_hal_shm_channel_collective(
+          channel,
+          MakeOp(IREE_HAL_COLLECTIVE_KIND_REDUCE,
+                 IREE_HAL_COLLECTIVE_REDUCTION_MAXIMUM),
+          root, iree_make_const_byte_span(send.data(), send.size() * 4),
+          iree_make_byte_span(recv.data(), recv.size() * 4), kElementCount));
+      if (rank == root) {
+        for (size_t i = 0; i < kElementCount; ++i) {
+          ASSERT_EQ(recv[i], Value(kCount - 1, i));
+        }
+      }
+    }
+  });
+}
+
+TEST_F(ShmChannelTest, SendRecvRing) {
+  constexpr int32_t kCount = 3;
+  constexpr size_t kElementCount = 100003;
+  RunParticipants(kCount, [&](int32_t rank, iree_hal_channel_t* channel) {
+    const int32_t target = (rank + 1) % kCount;
+    const int32_t source = (rank + kCount - 1) % kCount;
+    const uint32_t param = static_cast<uint16_t>(target) |
+                           (static_cast<uint32_t>(source) << 16);
+    std::vector<float> send(kElementCount);
+    std::vector<float> recv(kElementCount);
+    for (size_t i = 0; i < kElementCount; ++i) send[i] = Value(rank, i);
+    IREE_ASSERT_OK(iree_hal_shm_channel_collective(
+        channel, MakeOp(IREE_HAL_COLLECTIVE_KIND_SEND_RECV), param,
+        iree_make_const_byte_span(send.data(), send.size() * 4),
+        iree_make_byte_span(recv.data(), recv.size() * 4), kElementCount));
+    for (size_t i = 0; i < kElementCount; ++i) {
+      ASSERT_EQ(recv[i], Value(source, i));
+    }
+  });
+}
+
+TEST_F(ShmChannelTest, InvalidRoot) {
+  RunParticipants(2, [&](int32_t rank, iree_hal_channel_t* channel) {
+    float data[4] = {0};
+    EXPECT_THAT(Status(iree_hal_shm_channel_collective(
+                    channel, MakeOp(IREE_HAL_COLLECTIVE_KIND_BROADCAST), 2,
+                    iree_make_const_byte_span(data, sizeof(data)),
+                    iree_make_byte_span(data, sizeof(data)), 4)),
+                StatusIs(StatusCode::kOutOfRange));
+  });
+}
+
+TEST_F(ShmChannelTest, AllToAll) {
+  // Blocks large enough to span multiple staging chunks.
+  constexpr size_t kBlockLength = 70001;
+  for (int32_t count : {1, 2, 3, 4}) {
+    RunParticipants(count, [&](int32_t rank, iree_hal_channel_t* channel) {
+      const size_t element_count = kBlockLength * count;
+      std::vector<float> send(element_count);
+      std::vector<float> recv(element_count, -1.0f);
+      // Block b of the send buffer of rank r is destined for rank b.
+      for (int32_t block = 0; block < count; ++block) {
+        for (size_t i = 0; i < kBlockLength; ++i) {
+          send[block * kBlockLength + i] = Value(rank, i) * 100 + block;
+        }
+      }
+      IREE_ASSERT_OK(iree_hal_shm_channel_collective(
+          channel, MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_TO_ALL), 0,
+          iree_make_const_byte_span(send.data(), send.size() * 4),
+          iree_make_byte_span(recv.data(), recv.size() * 4), element_count));
+      // Block s of the receive buffer is the block of rank s for this rank.
+      for (int32_t source = 0; source < count; ++source) {
+        for (size_t i = 0; i < kBlockLength; ++i) {
+          ASSERT_EQ(recv[source * kBlockLength + i],
+                    Value(source, i) * 100 + rank)
+              << "count " << count << " source " << source << " element "
+              << i;
+        }
+      }
+    });
+  }
+}
+
+TEST_F(ShmChannelTest, AllToAllIndivisible) {
+  RunParticipants(3, [&](int32_t rank, iree_hal_channel_t* channel) {
+    float data[4] = {0};
+    EXPECT_THAT(Status(iree_hal_shm_channel_collective(
+                    channel, MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_TO_ALL), 0,
+                    iree_make_const_byte_span(data, sizeof(data)),
+                    iree_make_byte_span(data, sizeof(data)), 4)),
+                StatusIs(StatusCode::kInvalidArgument));
+  });
+}
+
+#if defined(IREE_PLATFORM_LINUX)
+
+// Returns true if the all-reduce, all-to-all, and broadcast performed by |rank|
+// on |channel| of |count| participants produce the expected results.
+static bool RunCollectiveSequence(iree_hal_channel_t* channel, int32_t rank,
+                                  int32_t count) {
+  auto value = [](int32_t r, size_t i) {
+    return static_cast<float>(r * 7 + static_cast<int32_t>(i % 13));
+  };
+  iree_hal_collective_op_t op = {};
+  op.element_type = IREE_HAL_COLLECTIVE_ELEMENT_TYPE_FLOAT_32;
+
+  constexpr size_t kElementCount = 100003;
+  std::vector<float> send(kElementCount);
+  std::vector<float> recv(kElementCount);
+  for (size_t i = 0; i < kElementCount; ++i) send[i] = value(rank, i);
+  op.kind = IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE;
+  op.reduction = IREE_HAL_COLLECTIVE_REDUCTION_SUM;
+  if (iree_status_consume_code(iree_hal_shm_channel_collective(
+          channel, op, 0,
+          iree_make_const_byte_span(send.data(), send.size() * 4),
+          iree_make_byte_span(recv.data(), recv.size() * 4),
+          kElementCount)) != IREE_STATUS_OK) {
+    return false;
+  }
+  for (size_t i = 0; i < kElementCount; ++i) {
+    float expected = 0.0f;
+    for (int32_t r = 0; r < count; ++r) expected += value(r, i);
+    if (recv[i] != expected) return false;
+  }
+
+  constexpr size_t kBlockLength = 70001;
+  send.resize(kBlockLength * count);
+  recv.assign(kBlockLength * count, -1.0f);
+  for (int32_t block = 0; block < count; ++block) {
+    for (size_t i = 0; i < kBlockLength; ++i) {
+      send[block * kBlockLength + i] = value(rank, i) * 100 + block;
+    }
+  }
+  op.kind = IREE_HAL_COLLECTIVE_KIND_ALL_TO_ALL;
+  op.reduction = IREE_HAL_COLLECTIVE_REDUCTION_NONE;
+  if (iree_status_consume_code(iree_hal_shm_channel_collective(
+          channel, op, 0,
+          iree_make_const_byte_span(send.data(), send.size() * 4),
+          iree_make_byte_span(recv.data(), recv.size() * 4),
+          send.size())) != IREE_STATUS_OK) {
+    return false;
+  }
+  for (int32_t source = 0; source < count; ++source) {
+    for (size_t i = 0; i < kBlockLength; ++i) {
+      if (recv[source * kBlockLength + i] != value(source, i) * 100 + rank) {
+        return false;
+      }
+    }
+  }
+
+  const int32_t root = count - 1;
+  send.assign(kElementCount, 0.0f);
+  recv.assign(kElementCount, -1.0f);
+  for (size_t i = 0; i < kElementCount; ++i) send[i] = value(rank, i);
+  op.kind = IREE_HAL_COLLECTIVE_KIND_BROADCAST;
+  if (iree_status_consume_code(iree_hal_shm_channel_collective(
+          channel, op, root,
+          iree_make_const_byte_span(send.data(), send.size() * 4),
+          iree_make_byte_span(recv.data(), recv.size() * 4),
+          kElementCount)) != IREE_STATUS_OK) {
+    return false;
+  }
+  if (rank != root) {
+    for (size_t i = 0; i < kElementCount; ++i) {
+      if (recv[i] != value(root, i)) return false;
+    }
+  }
+  return true;
+}
+
+// Forks a child process that creates the channel for |params| and runs |fn| on
+// it. The child exits with 0 if |fn| returns true.
+template <typename Fn>
+static pid_t ForkParticipant(iree_hal_channel_params_t params, Fn fn) {
+  pid_t pid = fork();
+  if (pid != 0) return pid;
+  iree_hal_channel_t* channel = NULL;
+  iree_status_t status = iree_hal_shm_channel_create(
+      params, iree_allocator_system(), &channel);
+  bool succeeded = iree_status_is_ok(status) && fn(channel);
+  iree_status_ignore(status);
+  iree_hal_channel_release(channel);
+  _exit(succeeded ? 0 : 1);
+}
+
+static int WaitForExitCode(pid_t pid) {
+  int wait_status = 0;
+  if (waitpid(pid, &wait_status, 0) != pid) return -1;
+  return WIFEXITED(wait_status) ? WEXITSTATUS(wait_status) : -1;
+}
+
+// Tests participants in separate processes as used when each process drives
+// one device (or NUMA node) of the host.
+TEST_F(ShmChannelTest, MultiProcess) {
+  constexpr int32_t kCount = 3;
+  const std::string group = "multi_process";
+  std::vector<pid_t> pids;
+  for (int32_t rank = 1; rank < kCount; ++rank) {
+    pids.push_back(ForkParticipant(
+        MakeParams(rank, kCount, group), [&](iree_hal_channel_t* channel) {
+          return RunCollectiveSequence(channel, rank, kCount);
+        }));
+    ASSERT_GT(pids.back(), 0);
+  }
+  iree_hal_channel_t* channel = NULL;
+  iree_status_t status = iree_hal_shm_channel_create(
+      MakeParams(0, kCount, group), iree_allocator_system(), &channel);
+  bool succeeded = false;
+  if (iree_status_is_ok(status)) {
+    succeeded = RunCollectiveSequence(channel, 0, kCount);
+    iree_hal_channel_release(channel);
+  }
+  for (pid_t pid : pids) EXPECT_EQ(WaitForExitCode(pid), 0);
+  if (iree_status_is_unavailable(status)) {
+    iree_status_ignore(status);
+    GTEST_SKIP() << "shared memory channels unavailable";
+  }
+  IREE_ASSERT_OK(status);
+  EXPECT_TRUE(succeeded);
+}
+
+// Mirrors iree_hal_shm_channel_format_name such that the test can observe the
+// segment.
+static std::string SegmentName(const std::string& id,
+                               const std::string& group) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (char c : id) hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001B3ull;
+  hash *= 0x100000001B3ull;
+  for (char c : group) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001B3ull;
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "/iree_shm_%016" PRIx64, hash);
+  return name;
+}
+
+// Tests that a segment left behind by a rank 0 that died before all
+// participants joined is not used by participants of a later run even when
+// they find it before the new rank 0 replaces it.
+TEST_F(ShmChannelTest, StaleSegmentIsReplaced) {
+  constexpr int32_t kCount = 2;
+  const std::string group = "stale";
+  const std::string name = SegmentName(id_, group);
+
+  // Rank 0 of the prior run creates the segment and waits for rank 1 forever.
+  pid_t pid = ForkParticipant(MakeParams(0, kCount, group),
+                              [](iree_hal_channel_t*) { return true; });
+  ASSERT_GT(pid, 0);
+  bool initialized = false;
+  for (int i = 0; i < 10000 && !initialized; ++i) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd >= 0) {
+      uint32_t magic = 0;
+      initialized = pread(fd, &magic, sizeof(magic), 0) == sizeof(magic) &&
+                    magic == 0x324D4853u;
+      close(fd);
+    }
+    if (!initialized) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  kill(pid, SIGKILL);
+  WaitForExitCode(pid);
+  if (!initialized) GTEST_SKIP() << "shared memory channels unavailable";
+
+  // Rank 1 finds the stale segment first; rank 0 replaces it shortly after.
+  RunParticipants(
+      kCount, group,
+      [&](int32_t rank, iree_hal_channel_t* channel) {
+        EXPECT_TRUE(RunCollectiveSequence(channel, rank, kCount));
+      },
+      /*rank0_delay_ms=*/100);
+
+  // The name is removed once all participants have joined.
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  EXPECT_LT(fd, 0);
+  if (fd >= 0) close(fd);
+}
+
+TEST_F(ShmChannelTest, JoinTimeout) {
+  setenv("IREE_SHM_CHANNEL_TIMEOUT_MS", "100", 1);
+  // Rank 0 without peers.
+  iree_hal_channel_t* channel = NULL;
+  iree_status_t status = iree_hal_shm_channel_create(
+      MakeParams(0, 2, "join_timeout_0"), iree_allocator_system(), &channel);
+  if (iree_status_is_unavailable(status)) {
+    iree_status_ignore(status);
+    GTEST_SKIP() << "shared memory channels unavailable";
+  }
+  EXPECT_THAT(Status(std::move(status)),
+              StatusIs(StatusCode::kDeadlineExceeded));
+  EXPECT_EQ(channel, nullptr);
+  int fd = shm_open(SegmentName(id_, "join_timeout_0").c_str(), O_RDONLY, 0);
+  EXPECT_LT(fd, 0);
+  if (fd >= 0) close(fd);
+
+  // Rank 1 without rank 0.
+  EXPECT_THAT(Status(iree_hal_shm_channel_create(
+                  MakeParams(1, 2, "join_timeout_1"), iree_allocator_system(),
+                  &channel)),
+              StatusIs(StatusCode::kDeadlineExceeded));
+  EXPECT_EQ(channel, nullptr);
+}
+
+// Tests that a participant that never arrives at a collective fails its peers
+// after the timeout and that the channel remains failed afterward.
+TEST_F(ShmChannelTest, MissingPeerTimesOut) {
+  setenv("IREE_SHM_CHANNEL_TIMEOUT_MS", "200", 1);
+  constexpr int32_t kCount = 3;
+  std::vector<iree_hal_channel_t*> channels;
+  iree_status_t status = CreateChannels(kCount, "missing_peer", &channels);
+  if (iree_status_is_unavailable(status)) {
+    iree_status_ignore(status);
+    GTEST_SKIP() << "shared memory channels unavailable";
+  }
+  IREE_ASSERT_OK(status);
+
+  std::vector<std::vector<float>> data(kCount, std::vector<float>(16));
+  auto all_reduce = [&](int32_t rank) {
+    return iree_hal_shm_channel_collective(
+        channels[rank],
+        MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE,
+               IREE_HAL_COLLECTIVE_REDUCTION_SUM),
+        0, iree_make_const_byte_span(data[rank].data(), 16 * 4),
+        iree_make_byte_span(data[rank].data(), 16 * 4), 16);
+  };
+  // Ranks 0 and 1 perform the collective while rank 2 never arrives. Either
+  // may time out first; the other observes the abort.
+  std::vector<iree_status_code_t> codes(2, IREE_STATUS_OK);
+  std::vector<std::thread> threads;
+  for (int32_t rank = 0; rank < 2; ++rank) {
+    threads.emplace_back([&, rank]() {
+      codes[rank] = iree_status_consume_code(all_reduce(rank));
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int32_t rank = 0; rank < 2; ++rank) {
+    EXPECT_TRUE(codes[rank] == IREE_STATUS_DEADLINE_EXCEEDED ||
+                codes[rank] == IREE_STATUS_ABORTED)
+        << iree_status_code_string(codes[rank]);
+  }
+  EXPECT_TRUE(codes[0] == IREE_STATUS_DEADLINE_EXCEEDED ||
+              codes[1] == IREE_STATUS_DEADLINE_EXCEEDED);
+
+  // The late participant and any further collectives fail immediately.
+  for (int32_t rank = 0; rank < kCount; ++rank) {
+    EXPECT_THAT(Status(all_reduce(rank)), StatusIs(StatusCode::kAborted));
+  }
+  for (auto* channel : channels) iree_hal_channel_release(channel);
+}
+
+// Tests that a participant process exiting without performing the collective
+// fails the remaining participants instead of blocking them forever.
+TEST_F(ShmChannelTest, MultiProcessPeerExit) {
+  setenv("IREE_SHM_CHANNEL_TIMEOUT_MS", "200", 1);
+  constexpr int32_t kCount = 2;
+  const std::string group = "peer_exit";
+  pid_t pid = ForkParticipant(MakeParams(1, kCount, group),
+                              [](iree_hal_channel_t*) { return true; });
+  ASSERT_GT(pid, 0);
+  iree_hal_channel_t* channel = NULL;
+  iree_status_t status = iree_hal_shm_channel_create(
+      MakeParams(0, kCount, group), iree_allocator_system(), &channel);
+  EXPECT_EQ(WaitForExitCode(pid), 0);
+  if (iree_status_is_unavailable(status)) {
+    iree_status_ignore(status);
+    GTEST_SKIP() << "shared memory channels unavailable";
+  }
+  IREE_ASSERT_OK(status);
+  float data[16] = {0};
+  EXPECT_THAT(Status(iree_hal_shm_channel_collective(
+                  channel,
+                  MakeOp(IREE_HAL_COLLECTIVE_KIND_ALL_REDUCE,
+                         IREE_HAL_COLLECTIVE_REDUCTION_SUM),
+                  0, iree_make_const_byte_span(data, sizeof(data)),
+                  iree_make_byte_span(data, sizeof(data)), 16)),
+              StatusIs(StatusCode::kDeadlineExceeded));
+  iree_hal_channel_release(channel);
+}
+
+#endif  // IREE_PLATFORM_LINUX
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -4,11 +4,22 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+// NOTE: must be first before _any_ system includes.
+#define _GNU_SOURCE
+
 #include "iree/io/file_handle.h"
 
 #include "iree/base/internal/atomics.h"
 #include "iree/io/memory_stream.h"
 
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
+
 //===----------------------------------------------------------------------===//
 // iree_io_file_handle_t
 //===----------------------------------------------------------------------===//
@@ -60,6 +71,76 @@ IREE_API_EXPORT iree_status_t iree_io_file_handle_wrap_host_allocation(
                                   release_callback, host_allocator, out_handle);
 }
 
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+
+static void iree_io_file_handle_fd_release(
+    void* user_data, iree_io_file_handle_primitive_t handle_primitive) {
+  close(handle_primitive.value.fd);
+}
+
+IREE_API_EXPORT iree_status_t iree_io_file_handle_open(
+    iree_io_file_access_t allowed_access, iree_string_view_t path,
+    iree_allocator_t host_allocator, iree_io_file_handle_t** out_handle) {
+  IREE_ASSERT_ARGUMENT(out_handle);
+  *out_handle = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, path.data, path.size);
+
+  int open_flags = O_CLOEXEC;
+  if (iree_all_bits_set(allowed_access,
+                        IREE_IO_FILE_ACCESS_READ | IREE_IO_FILE_ACCESS_WRITE)) {
+    open_flags |= O_RDWR;
+  } else if (iree_all_bits_set(allowed_access, IREE_IO_FILE_ACCESS_WRITE)) {
+    open_flags |= O_WRONLY;
+  } else {
+    open_flags |= O_RDONLY;
+  }
+
+  char* path_str = (char*)iree_alloca(path.size + 1);
+  iree_string_view_to_cstring(path, path_str, path.size + 1);
+  int fd = -1;
+  do {
+    fd = open(path_str, open_flags);
+  } while (fd == -1 && errno == EINTR);
+  if (fd == -1) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "failed to open file '%s'", path_str);
+  }
+
+  iree_io_file_handle_primitive_t handle_primitive = {
+      .type = IREE_IO_FILE_HANDLE_TYPE_FD,
+      .value =
+          {
+              .fd = fd,
+          },
+  };
+  iree_io_file_handle_release_callback_t release_callback = {
+      .fn = iree_io_file_handle_fd_release,
+      .user_data = NULL,
+  };
+  iree_status_t status =
+      iree_io_file_handle_wrap(allowed_access, handle_primitive,
+                               release_callback, host_allocator, out_handle);
+  if (!iree_status_is_ok(status)) close(fd);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+#else
+
+IREE_API_EXPORT iree_status_t iree_io_file_handle_open(
+    iree_io_file_access_t allowed_access, iree_string_view_t path,
+    iree_allocator_t host_allocator, iree_io_file_handle_t** out_handle) {
+  IREE_ASSERT_ARGUMENT(out_handle);
+  *out_handle = NULL;
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "file descriptors are not supported on this platform");
+}
+
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
+
 static void iree_io_file_handle_destroy(iree_io_file_handle_t* handle) {
   IREE_ASSERT_ARGUMENT(handle);
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -101,6 +182,35 @@ iree_io_file_handle_primitive(const iree_io_file_handle_t* handle) {
   return handle->primitive;
 }
 
+IREE_API_EXPORT iree_status_t iree_io_file_handle_query_length(
+    iree_io_file_handle_t* handle, uint64_t* out_length) {
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(out_length);
+  *out_length = 0;
+  switch (handle->primitive.type) {
+    case IREE_IO_FILE_HANDLE_TYPE_HOST_ALLOCATION: {
+      *out_length = handle->primitive.value.host_allocation.data_length;
+      return iree_ok_status();
+    }
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+    case IREE_IO_FILE_HANDLE_TYPE_FD: {
+      struct stat stat_buf;
+      if (fstat(handle->primitive.value.fd, &stat_buf) == -1) {
+        return iree_make_status(iree_status_code_from_errno(errno),
+                                "unable to query file length");
+      }
+      *out_length = (uint64_t)stat_buf.st_size;
+      return iree_ok_status();
+    }
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
+    default: {
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "length query not supported on handle type %d",
+                              (int)handle->primitive.type);
+    }
+  }
+}
+
 IREE_API_EXPORT iree_status_t
 iree_io_file_handle_flush(iree_io_file_handle_t* handle) {
   IREE_ASSERT_ARGUMENT(handle);
@@ -111,6 +221,15 @@ iree_io_file_handle_flush(iree_io_file_handle_t* handle) {
       // No-op (though we could flush when known mapped).
       break;
     }
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+    case IREE_IO_FILE_HANDLE_TYPE_FD: {
+      if (fsync(handle->primitive.value.fd) == -1) {
+        status = iree_make_status(iree_status_code_from_errno(errno),
+                                  "unable to flush file");
+      }
+      break;
+    }
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
     default: {
       status = iree_make_status(IREE_STATUS_UNIMPLEMENTED,
                                 "flush not supported on handle type %d",
@@ -122,6 +241,278 @@ iree_io_file_handle_flush(iree_io_file_handle_t* handle) {
   return status;
 }
 
+// Verifies that [offset, offset+length) is within the host allocation.
+static iree_status_t iree_io_file_handle_validate_host_range(
+    iree_byte_span_t host_allocation, uint64_t file_offset,
+    iree_host_size_t length) {
+  if (file_offset > host_allocation.data_length ||
+      length > host_allocation.data_length - file_offset) {
+    return iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "file range %" PRIu64 " (%" PRIhsz
+        " bytes) out of range of host allocation with %" PRIhsz
+        " bytes available",
+        file_offset, length, host_allocation.data_length);
+  }
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_io_file_handle_read(
+    iree_io_file_handle_t* handle, uint64_t file_offset, void* buffer,
+    iree_host_size_t length) {
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(!length || buffer);
+  if (!iree_all_bits_set(handle->access, IREE_IO_FILE_ACCESS_READ)) {
+    return iree_make_status(IREE_STATUS_PERMISSION_DENIED,
+                            "file handle does not allow reads");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, file_offset);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (int64_t)length);
+
+  iree_status_t status = iree_ok_status();
+  switch (handle->primitive.type) {
+    case IREE_IO_FILE_HANDLE_TYPE_HOST_ALLOCATION: {
+      iree_byte_span_t host_allocation =
+          handle->primitive.value.host_allocation;
+      status = iree_io_file_handle_validate_host_range(host_allocation,
+                                                       file_offset, length);
+      if (iree_status_is_ok(status)) {
+        memcpy(buffer, host_allocation.data + file_offset, length);
+      }
+      break;
+    }
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+    case IREE_IO_FILE_HANDLE_TYPE_FD: {
+      // pread may return fewer bytes than requested (signals, large requests,
+      // etc) so we loop until all bytes have been read.
+      uint8_t* buffer_ptr = (uint8_t*)buffer;
+      while (length > 0) {
+        ssize_t read_length = pread(handle->primitive.value.fd, buffer_ptr,
+                                    length, (off_t)file_offset);
+        if (read_length < 0) {
+          if (errno == EINTR) continue;
+          status = iree_make_status(iree_status_code_from_errno(errno),
+                                    "file read of %" PRIhsz
+                                    " bytes at offset %" PRIu64 " failed",
+                                    length, file_offset);
+          break;
+        } else if (read_length == 0) {
+          status = iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                    "end of file reached with %" PRIhsz
+                                    " bytes remaining at offset %" PRIu64,
+                                    length, file_offset);
+          break;
+        }
+        buffer_ptr += read_length;
+        file_offset += (uint64_t)read_length;
+        length -= (iree_host_size_t)read_length;
+      }
+      break;
+    }
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
+    default: {
+      status = iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                                "read not supported on handle type %d",
+                                (int)handle->primitive.type);
+      break;
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_io_file_handle_write(
+    iree_io_file_handle_t* handle, uint64_t file_offset, const void* buffer,
+    iree_host_size_t length) {
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(!length || buffer);
+  if (!iree_all_bits_set(handle->access, IREE_IO_FILE_ACCESS_WRITE)) {
+    return iree_make_status(IREE_STATUS_PERMISSION_DENIED,
+                            "file handle does not allow writes");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, file_offset);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (int64_t)length);
+
+  iree_status_t status = iree_ok_status();
+  switch (handle->primitive.type) {
+    case IREE_IO_FILE_HANDLE_TYPE_HOST_ALLOCATION: {
+      iree_byte_span_t host_allocation =
+          handle->primitive.value.host_allocation;
+      status = iree_io_file_handle_validate_host_range(host_allocation,
+                                                       file_offset, length);
+      if (iree_status_is_ok(status)) {
+        memcpy(host_allocation.data + file_offset, buffer, length);
+      }
+      break;
+    }
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+    case IREE_IO_FILE_HANDLE_TYPE_FD: {
+      const uint8_t* buffer_ptr = (const uint8_t*)buffer;
+      while (length > 0) {
+        ssize_t write_length = pwrite(handle->primitive.value.fd, buffer_ptr,
+                                      length, (off_t)file_offset);
+        if (write_length < 0) {
+          if (errno == EINTR) continue;
+          status = iree_make_status(iree_status_code_from_errno(errno),
+                                    "file write of %" PRIhsz
+                                    " bytes at offset %" PRIu64 " failed",
+                                    length, file_offset);
+          break;
+        }
+        buffer_ptr += write_length;
+        file_offset += (uint64_t)write_length;
+        length -= (iree_host_size_t)write_length;
+      }
+      break;
+    }
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
+    default: {
+      status = iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                                "write not supported on handle type %d",
+                                (int)handle->primitive.type);
+      break;
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_io_file_mapping_t
+//===----------------------------------------------------------------------===//
+
+struct iree_io_file_mapping_t {
+  iree_allocator_t host_allocator;
+  // File handle the mapping references, retained.
+  iree_io_file_handle_t* handle;
+  // Base pointer and length of the platform mapping, if any. May start before
+  // the contents due to page alignment requirements.
+  void* mapping_base;
+  iree_host_size_t mapping_length;
+  // Requested contents within the mapping.
+  iree_const_byte_span_t contents;
+};
+
+IREE_API_EXPORT iree_status_t iree_io_file_map_view(
+    iree_io_file_handle_t* handle, uint64_t offset, iree_host_size_t length,
+    iree_allocator_t host_allocator, iree_io_file_mapping_t** out_mapping) {
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(out_mapping);
+  *out_mapping = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, offset);
+
+  // Clamp the requested range to the file.
+  uint64_t file_length = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_io_file_handle_query_length(handle, &file_length));
+  if (offset > file_length) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "mapping offset %" PRIu64
+                            " out of range of file with %" PRIu64 " bytes",
+                            offset, file_length);
+  }
+  if (length == IREE_HOST_SIZE_MAX) {
+    if (file_length - offset > (uint64_t)IREE_HOST_SIZE_MAX) {
+      IREE_TRACE_ZONE_END(z0);
+      return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                              "file range exceeds host address space");
+    }
+    length = (iree_host_size_t)(file_length - offset);
+  } else if (length > file_length - offset) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "mapping range %" PRIu64 " (%" PRIhsz
+                            " bytes) out of range of file with %" PRIu64
+                            " bytes",
+                            offset, length, file_length);
+  }
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (int64_t)length);
+
+  iree_io_file_mapping_t* mapping = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*mapping),
+                                (void**)&mapping));
+  memset(mapping, 0, sizeof(*mapping));
+  mapping->host_allocator = host_allocator;
+  mapping->handle = handle;
+  iree_io_file_handle_retain(handle);
+
+  iree_status_t status = iree_ok_status();
+  switch (handle->primitive.type) {
+    case IREE_IO_FILE_HANDLE_TYPE_HOST_ALLOCATION: {
+      mapping->contents = iree_make_const_byte_span(
+          handle->primitive.value.host_allocation.data + offset, length);
+      break;
+    }
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+    case IREE_IO_FILE_HANDLE_TYPE_FD: {
+      if (length == 0) break;  // mmap disallows empty ranges
+      // Offsets must be page aligned so we map a bit extra and then offset.
+      const uint64_t page_size = (uint64_t)sysconf(_SC_PAGESIZE);
+      const uint64_t aligned_offset = offset & ~(page_size - 1);
+      const iree_host_size_t alignment_padding =
+          (iree_host_size_t)(offset - aligned_offset);
+      const iree_host_size_t mapping_length = length + alignment_padding;
+      void* mapping_base =
+          mmap(NULL, mapping_length, PROT_READ, MAP_SHARED,
+               handle->primitive.value.fd, (off_t)aligned_offset);
+      if (mapping_base == MAP_FAILED) {
+        status = iree_make_status(iree_status_code_from_errno(errno),
+                                  "failed to map file range %" PRIu64
+                                  " (%" PRIhsz " bytes)",
+                                  offset, length);
+        break;
+      }
+      mapping->mapping_base = mapping_base;
+      mapping->mapping_length = mapping_length;
+      mapping->contents = iree_make_const_byte_span(
+          (const uint8_t*)mapping_base + alignment_padding, length);
+      break;
+    }
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
+    default: {
+      status = iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                                "mapping not supported on handle type %d",
+                                (int)handle->primitive.type);
+      break;
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_mapping = mapping;
+  } else {
+    iree_io_file_mapping_release(mapping);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT void iree_io_file_mapping_release(
+    iree_io_file_mapping_t* mapping) {
+  if (!mapping) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+  if (mapping->mapping_base) {
+    munmap(mapping->mapping_base, mapping->mapping_length);
+  }
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
+  iree_io_file_handle_release(mapping->handle);
+  iree_allocator_free(mapping->host_allocator, mapping);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT iree_const_byte_span_t
+iree_io_file_mapping_contents(const iree_io_file_mapping_t* mapping) {
+  IREE_ASSERT_ARGUMENT(mapping);
+  return mapping->contents;
+}
+
 //===----------------------------------------------------------------------===//
 // iree_io_stream_t utilities
 //===----------------------------------------------------------------------===//
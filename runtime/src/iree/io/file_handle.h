@@ -46,15 +46,33 @@ typedef enum iree_io_file_handle_type_e {
   // as long as the file handle referencing it.
   IREE_IO_FILE_HANDLE_TYPE_HOST_ALLOCATION = 0u,
 
-  // TODO(benvanik): file descriptor, FILE*, HANDLE, etc.
+  // A POSIX file descriptor supporting positioned I/O (pread/pwrite).
+  // The file contents are not resident in memory and are accessed on-demand.
+  // Only available on platforms with POSIX file descriptors (see
+  // IREE_IO_FILE_HANDLE_HAVE_FD).
+  IREE_IO_FILE_HANDLE_TYPE_FD = 1u,
+
+  // TODO(benvanik): FILE*, HANDLE, etc.
 } iree_io_file_handle_type_t;
 
+// Whether IREE_IO_FILE_HANDLE_TYPE_FD handles are supported on this platform.
+#if !defined(IREE_IO_FILE_HANDLE_HAVE_FD)
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_APPLE) || \
+    defined(IREE_PLATFORM_LINUX)
+#define IREE_IO_FILE_HANDLE_HAVE_FD 1
+#else
+#define IREE_IO_FILE_HANDLE_HAVE_FD 0
+#endif  // IREE_PLATFORM_*
+#endif  // !IREE_IO_FILE_HANDLE_HAVE_FD
+
 // A platform handle to a file primitive.
 // Unowned/unreferenced on its own but may be embedded in instances that manage
 // lifetime such as iree_io_file_handle_t.
 typedef union iree_io_file_handle_primitive_value_t {
   // IREE_IO_FILE_HANDLE_TYPE_HOST_ALLOCATION
   iree_byte_span_t host_allocation;
+  // IREE_IO_FILE_HANDLE_TYPE_FD
+  int fd;
 } iree_io_file_handle_primitive_value_t;
 
 // A (type, value) pair describing a system file primitive handle.
@@ -112,6 +130,21 @@ IREE_API_EXPORT iree_status_t iree_io_file_handle_wrap_host_allocation(
     iree_io_file_handle_release_callback_t release_callback,
     iree_allocator_t host_allocator, iree_io_file_handle_t** out_handle);
 
+// Opens the file at |path| as a file descriptor-backed file handle.
+// The file must exist. |allowed_access| declares which operations are allowed
+// on the handle and determines the mode the file is opened with. The file
+// descriptor will be closed when the last reference to the handle is released.
+//
+// Unlike mapping or preloading the file no file contents are read and the file
+// can be larger than the available host address space. Reads and writes are
+// performed with positioned I/O directly into the target memory.
+//
+// Fails with IREE_STATUS_UNAVAILABLE if file descriptors are not supported on
+// the platform.
+IREE_API_EXPORT iree_status_t iree_io_file_handle_open(
+    iree_io_file_access_t allowed_access, iree_string_view_t path,
+    iree_allocator_t host_allocator, iree_io_file_handle_t** out_handle);
+
 // Retains the file |handle| for the caller.
 IREE_API_EXPORT void iree_io_file_handle_retain(iree_io_file_handle_t* handle);
 
@@ -147,10 +180,58 @@ static inline iree_io_file_handle_primitive_value_t iree_io_file_handle_value(
   return iree_io_file_handle_primitive(handle).value;
 }
 
+// Queries the total length of the file |handle| in bytes.
+IREE_API_EXPORT iree_status_t iree_io_file_handle_query_length(
+    iree_io_file_handle_t* handle, uint64_t* out_length);
+
 // Flushes pending writes of |handle| to its backing storage.
 IREE_API_EXPORT iree_status_t
 iree_io_file_handle_flush(iree_io_file_handle_t* handle);
 
+// Synchronously reads |length| bytes from |handle| starting at |file_offset|
+// into |buffer|. The handle must allow IREE_IO_FILE_ACCESS_READ. Fails with
+// IREE_STATUS_OUT_OF_RANGE if the file ends before all bytes have been read.
+// Thread-safe: positioned reads do not modify any shared file cursor.
+IREE_API_EXPORT iree_status_t iree_io_file_handle_read(
+    iree_io_file_handle_t* handle, uint64_t file_offset, void* buffer,
+    iree_host_size_t length);
+
+// Synchronously writes |length| bytes from |buffer| into |handle| starting at
+// |file_offset|. The handle must allow IREE_IO_FILE_ACCESS_WRITE.
+// Thread-safe: positioned writes do not modify any shared file cursor.
+IREE_API_EXPORT iree_status_t iree_io_file_handle_write(
+    iree_io_file_handle_t* handle, uint64_t file_offset, const void* buffer,
+    iree_host_size_t length);
+
+//===----------------------------------------------------------------------===//
+// iree_io_file_mapping_t
+//===----------------------------------------------------------------------===//
+
+// A read-only view of a range of a file mapped into host memory.
+// Host allocation handles are viewed directly while file descriptors are mapped
+// with the platform virtual memory APIs. Mappings retain the file handle they
+// reference.
+//
+// Mappings are intended for parsing file headers and other small accesses;
+// bulk data transfer should use iree_io_file_handle_read or the HAL file APIs
+// so that pages do not need to be faulted in.
+typedef struct iree_io_file_mapping_t iree_io_file_mapping_t;
+
+// Maps |length| bytes of |handle| starting at |offset| into host memory.
+// If |length| is IREE_HOST_SIZE_MAX the remaining file contents after |offset|
+// are mapped.
+IREE_API_EXPORT iree_status_t iree_io_file_map_view(
+    iree_io_file_handle_t* handle, uint64_t offset, iree_host_size_t length,
+    iree_allocator_t host_allocator, iree_io_file_mapping_t** out_mapping);
+
+// Releases the |mapping| and unmaps the view.
+IREE_API_EXPORT void iree_io_file_mapping_release(
+    iree_io_file_mapping_t* mapping);
+
+// Returns the mapped contents of |mapping|.
+IREE_API_EXPORT iree_const_byte_span_t
+iree_io_file_mapping_contents(const iree_io_file_mapping_t* mapping);
+
 //===----------------------------------------------------------------------===//
 // iree_io_stream_t utilities
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,190 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/io/file_handle.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+#include <unistd.h>
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
+
+namespace {
+
+using iree::Status;
+using iree::StatusCode;
+using iree::testing::status::StatusIs;
+using testing::ElementsAre;
+
+TEST(FileHandleTest, HostAllocationReadWrite) {
+  uint8_t data[5] = {0, 1, 2, 3, 4};
+  iree_io_file_handle_t* handle = NULL;
+  IREE_ASSERT_OK(iree_io_file_handle_wrap_host_allocation(
+      IREE_IO_FILE_ACCESS_READ | IREE_IO_FILE_ACCESS_WRITE,
+      iree_make_byte_span(data, sizeof(data)),
+      iree_io_file_handle_release_callback_null(), iree_allocator_system(),
+      &handle));
+
+  uint64_t length = 0;
+  IREE_ASSERT_OK(iree_io_file_handle_query_length(handle, &length));
+  EXPECT_EQ(length, sizeof(data));
+
+  uint8_t read_data[3] = {0};
+  IREE_ASSERT_OK(
+      iree_io_file_handle_read(handle, 1, read_data, sizeof(read_data)));
+  EXPECT_THAT(read_data, ElementsAre(1, 2, 3));
+
+  uint8_t write_data[2] = {9, 8};
+  IREE_ASSERT_OK(
+      iree_io_file_handle_write(handle, 3, write_data, sizeof(write_data)));
+  EXPECT_THAT(data, ElementsAre(0, 1, 2, 9, 8));
+
+  EXPECT_THAT(Status(iree_io_file_handle_read(handle, 4, read_data,
+                                              sizeof(read_data))),
+              StatusIs(StatusCode::kOutOfRange));
+
+  iree_io_file_handle_release(handle);
+}
+
+TEST(FileHandleTest, HostAllocationAccess) {
+  uint8_t data[5] = {0, 1, 2, 3, 4};
+  iree_io_file_handle_t* handle = NULL;
+  IREE_ASSERT_OK(iree_io_file_handle_wrap_host_allocation(
+      IREE_IO_FILE_ACCESS_READ, iree_make_byte_span(data, sizeof(data)),
+      iree_io_file_handle_release_callback_null(), iree_allocator_system(),
+      &handle));
+
+  uint8_t write_data[2] = {9, 8};
+  EXPECT_THAT(Status(iree_io_file_handle_write(handle, 0, write_data,
+                                               sizeof(write_data))),
+              StatusIs(StatusCode::kPermissionDenied));
+
+  iree_io_file_handle_release(handle);
+}
+
+TEST(FileHandleTest, HostAllocationMapView) {
+  uint8_t data[5] = {0, 1, 2, 3, 4};
+  iree_io_file_handle_t* handle = NULL;
+  IREE_ASSERT_OK(iree_io_file_handle_wrap_host_allocation(
+      IREE_IO_FILE_ACCESS_READ, iree_make_byte_span(data, sizeof(data)),
+      iree_io_file_handle_release_callback_null(), iree_allocator_system(),
+      &handle));
+
+  iree_io_file_mapping_t* mapping = NULL;
+  IREE_ASSERT_OK(iree_io_file_map_view(handle, 2, IREE_HOST_SIZE_MAX,
+                                       iree_allocator_system(), &mapping));
+  iree_const_byte_span_t contents = iree_io_file_mapping_contents(mapping);
+  EXPECT_EQ(contents.data, data + 2);
+  EXPECT_EQ(contents.data_length, 3);
+  iree_io_file_mapping_release(mapping);
+
+  iree_io_file_handle_release(handle);
+}
+
+#if IREE_IO_FILE_HANDLE_HAVE_FD
+
+// Writes |contents| to a new temporary file and returns its path.
+static std::string CreateTempFile(const std::string& contents) {
+  const char* tmpdir = getenv("TEST_TMPDIR");
+  if (!tmpdir) tmpdir = getenv("TMPDIR");
+  if (!tmpdir) tmpdir = "/tmp";
+  std::string path = std::string(tmpdir) + "/iree_file_handle_test_XXXXXX";
+  int fd = mkstemp(&path[0]);
+  EXPECT_NE(fd, -1);
+  EXPECT_EQ(write(fd, contents.data(), contents.size()),
+            (ssize_t)contents.size());
+  close(fd);
+  return path;
+}
+
+TEST(FileHandleTest, FdRead) {
+  std::string path = CreateTempFile("0123456789");
+  iree_io_file_handle_t* handle = NULL;
+  IREE_ASSERT_OK(iree_io_file_handle_open(
+      IREE_IO_FILE_ACCESS_READ,
+      iree_make_string_view(path.data(), path.size()), iree_allocator_system(),
+      &handle));
+  EXPECT_EQ(iree_io_file_handle_type(handle), IREE_IO_FILE_HANDLE_TYPE_FD);
+
+  uint64_t length = 0;
+  IREE_ASSERT_OK(iree_io_file_handle_query_length(handle, &length));
+  EXPECT_EQ(length, 10);
+
+  char read_data[4] = {0};
+  IREE_ASSERT_OK(
+      iree_io_file_handle_read(handle, 3, read_data, sizeof(read_data)));
+  EXPECT_EQ(std::string(read_data, sizeof(read_data)), "3456");
+
+  // Reads past the end of the file fail instead of returning short data.
+  EXPECT_THAT(Status(iree_io_file_handle_read(handle, 8, read_data,
+                                              sizeof(read_data))),
+              StatusIs(StatusCode::kOutOfRange));
+
+  // Writes are not allowed on read-only handles.
+  EXPECT_THAT(Status(iree_io_file_handle_write(handle, 0, read_data,
+                                               sizeof(read_data))),
+              StatusIs(StatusCode::kPermissionDenied));
+
+  iree_io_file_handle_release(handle);
+  unlink(path.c_str());
+}
+
+TEST(FileHandleTest, FdWrite) {
+  std::string path = CreateTempFile("0123456789");
+  iree_io_file_handle_t* handle = NULL;
+  IREE_ASSERT_OK(iree_io_file_handle_open(
+      IREE_IO_FILE_ACCESS_READ | IREE_IO_FILE_ACCESS_WRITE,
+      iree_make_string_view(path.data(), path.size()), iree_allocator_system(),
+      &handle));
+
+  const char write_data[3] = {'a', 'b', 'c'};
+  IREE_ASSERT_OK(
+      iree_io_file_handle_write(handle, 2, write_data, sizeof(write_data)));
+  IREE_ASSERT_OK(iree_io_file_handle_flush(handle));
+
+  char read_data[10] = {0};
+  IREE_ASSERT_OK(
+      iree_io_file_handle_read(handle, 0, read_data, sizeof(read_data)));
+  EXPECT_EQ(std::string(read_data, sizeof(read_data)), "01abc56789");
+
+  iree_io_file_handle_release(handle);
+  unlink(path.c_str());
+}
+
+TEST(FileHandleTest, FdMapView) {
+  std::string path = CreateTempFile("0123456789");
+  iree_io_file_handle_t* handle = NULL;
+  IREE_ASSERT_OK(iree_io_file_handle_open(
+      IREE_IO_FILE_ACCESS_READ,
+      iree_make_string_view(path.data(), path.size()), iree_allocator_system(),
+      &handle));
+
+  // Unaligned offsets are handled by mapping the containing page.
+  iree_io_file_mapping_t* mapping = NULL;
+  IREE_ASSERT_OK(iree_io_file_map_view(handle, 5, 3, iree_allocator_system(),
+                                       &mapping));
+  iree_const_byte_span_t contents = iree_io_file_mapping_contents(mapping);
+  EXPECT_EQ(std::string((const char*)contents.data, contents.data_length),
+            "567");
+  iree_io_file_mapping_release(mapping);
+
+  EXPECT_THAT(Status(iree_io_file_map_view(handle, 5, 10,
+                                           iree_allocator_system(), &mapping)),
+              StatusIs(StatusCode::kOutOfRange));
+
+  iree_io_file_handle_release(handle);
+  unlink(path.c_str());
+}
+
+#endif  // IREE_IO_FILE_HANDLE_HAVE_FD
+
+}  // namespace
@@ -50,6 +50,11 @@
 #define GGUF_MAX_VERSION 3
 #define GGUF_DEFAULT_ALIGNMENT 32
 
+// Initial number of bytes mapped when parsing the header. The mapping is
+// doubled until the whole header fits (large tokenizer vocabularies can make
+// headers several megabytes).
+#define IREE_IO_GGUF_HEADER_MAP_SIZE (256 * 1024)
+
 enum ggml_type_e {
   GGML_TYPE_F32 = 0,
   GGML_TYPE_F16 = 1,
@@ -653,15 +658,20 @@ static iree_status_t iree_io_gguf_append_tensor_info(
   return iree_io_parameter_index_add(parser->index, &entry);
 }
 
+// Parses the GGUF header from |header_contents|, a prefix of the file of
+// |file_length| total bytes. Returns IREE_STATUS_OUT_OF_RANGE if the header
+// extends beyond |header_contents|. Entries are only added to |index| once the
+// entire header has been scanned and as such a failed parse leaves it
+// unmodified.
 static iree_status_t iree_io_parse_gguf_index_from_memory(
-    iree_io_file_handle_t* file_handle, iree_const_byte_span_t file_contents,
-    iree_io_parameter_index_t* index) {
+    iree_io_file_handle_t* file_handle, iree_const_byte_span_t header_contents,
+    uint64_t file_length, iree_io_parameter_index_t* index) {
   // Read the header enough to check for file validity and version.
   // Unfortunately the format has a variable-length header (vs being
   // table-based) and that means we have to actually parse the header fully
   // (including all nested variable-length elements) in order to even know if
   // the whole header is present or where data lives. Yuck.
-  iree_const_byte_span_t contents = file_contents;
+  iree_const_byte_span_t contents = header_contents;
   uint32_t magic = 0;
   IREE_RETURN_IF_ERROR(iree_io_gguf_parse_uint32(&contents, &magic));
   if (magic != GGUF_MAGIC) {
@@ -713,10 +723,11 @@ static iree_status_t iree_io_parse_gguf_index_from_memory(
   // Calculate where the tensor data begins in the file. This respects the
   // default alignment or the general.alignment specified by the file.
   parser.tensor_data_offset = iree_align_uint64(
-      (uint64_t)(tensor_info_contents.data - file_contents.data),
+      (uint64_t)(tensor_info_contents.data - header_contents.data),
       parser.alignment);
-  parser.tensor_data_size =
-      file_contents.data_length - parser.tensor_data_offset;
+  parser.tensor_data_size = parser.tensor_data_offset <= file_length
+                                ? file_length - parser.tensor_data_offset
+                                : 0;
 
   // Scan forward through the tensor info now that we know the tensor data
   // offset and add the tensor entries.
@@ -731,22 +742,40 @@ IREE_API_EXPORT iree_status_t iree_io_parse_gguf_index(
   IREE_ASSERT_ARGUMENT(index);
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // Today we only support memory files.
-  // TODO(benvanik): support iree_io_stream_t wrapping for parsing the index.
-  if (iree_io_file_handle_type(file_handle) !=
-      IREE_IO_FILE_HANDLE_TYPE_HOST_ALLOCATION) {
-    IREE_TRACE_ZONE_END(z0);
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "non-memory gguf files not yet supported");
+  uint64_t file_length = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_io_file_handle_query_length(file_handle, &file_length));
+
+  // Map only a prefix of the file for parsing and grow it if the header turns
+  // out to be larger. The header size is not known until it has been fully
+  // parsed but it is usually much smaller than the tensor data which is
+  // referenced by the index entries through the original file handle and never
+  // touched while parsing. Host allocations are viewed directly while file
+  // descriptors are mapped.
+  uint64_t mapping_length = iree_min(file_length, IREE_IO_GGUF_HEADER_MAP_SIZE);
+  iree_status_t status = iree_ok_status();
+  while (true) {
+    if (mapping_length > (uint64_t)IREE_HOST_SIZE_MAX) {
+      status = iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                                "GGUF header exceeds host address space");
+      break;
+    }
+    iree_io_file_mapping_t* file_mapping = NULL;
+    status = iree_io_file_map_view(file_handle, /*offset=*/0,
+                                   (iree_host_size_t)mapping_length,
+                                   iree_allocator_system(), &file_mapping);
+    if (!iree_status_is_ok(status)) break;
+    status = iree_io_parse_gguf_index_from_memory(
+        file_handle, iree_io_file_mapping_contents(file_mapping), file_length,
+        index);
+    iree_io_file_mapping_release(file_mapping);
+    if (iree_status_is_out_of_range(status) && mapping_length < file_length) {
+      status = iree_status_ignore(status);
+      mapping_length = iree_min(file_length, mapping_length * 2);
+      continue;
+    }
+    break;
   }
-  iree_byte_span_t host_allocation =
-      iree_io_file_handle_primitive(file_handle).value.host_allocation;
-
-  iree_status_t status = iree_io_parse_gguf_index_from_memory(
-      file_handle,
-      iree_make_const_byte_span(host_allocation.data,
-                                host_allocation.data_length),
-      index);
 
   IREE_TRACE_ZONE_END(z0);
   return status;
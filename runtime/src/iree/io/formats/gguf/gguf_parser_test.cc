@@ -6,10 +6,20 @@
 
 #include "iree/io/formats/gguf/gguf_parser.h"
 
+#include <string>
+#include <vector>
+
 #include "iree/io/formats/gguf/testdata/gguf_files.h"
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
 
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_APPLE) || \
+    defined(IREE_PLATFORM_LINUX)
+#include <sys/mman.h>
+#include <unistd.h>
+#define IREE_HAVE_MPROTECT 1
+#endif  // IREE_PLATFORM_*
+
 namespace iree {
 namespace {
 
@@ -32,6 +42,71 @@ static iree_io_file_handle_t* OpenTestFile(const char* name) {
   return NULL;
 }
 
+#if defined(IREE_HAVE_MPROTECT)
+
+// Pages holding a copy of a test file.
+struct GuardedAllocation {
+  void* base = NULL;
+  size_t length = 0;
+};
+
+static void ReleaseGuardedAllocation(
+    void* user_data, iree_io_file_handle_primitive_t handle_primitive) {
+  auto* allocation = static_cast<GuardedAllocation*>(user_data);
+  munmap(allocation->base, allocation->length);
+  delete allocation;
+}
+
+// Wraps a copy of |contents| where every byte at or after |data_offset| is in
+// pages that cannot be accessed. Parsing faults if it touches the tensor data.
+static void WrapGuardedContents(iree_const_byte_span_t contents,
+                                size_t data_offset,
+                                iree_io_file_handle_t** out_file_handle) {
+  *out_file_handle = NULL;
+  ASSERT_GT(contents.data_length, data_offset);
+
+  const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  const size_t header_length = iree_host_align(data_offset, page_size);
+  const size_t data_length =
+      iree_host_align(contents.data_length - data_offset, page_size);
+  auto* allocation = new GuardedAllocation();
+  allocation->length = header_length + data_length;
+  allocation->base = mmap(NULL, allocation->length, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(allocation->base, MAP_FAILED);
+  uint8_t* data_base = (uint8_t*)allocation->base + header_length;
+  uint8_t* file_base = data_base - data_offset;
+  memcpy(file_base, contents.data, contents.data_length);
+  ASSERT_EQ(mprotect(data_base, data_length, PROT_NONE), 0);
+
+  iree_io_file_handle_release_callback_t release_callback = {
+      ReleaseGuardedAllocation,
+      allocation,
+  };
+  IREE_ASSERT_OK(iree_io_file_handle_wrap_host_allocation(
+      IREE_IO_FILE_ACCESS_READ,
+      iree_make_byte_span(file_base, contents.data_length), release_callback,
+      iree_allocator_system(), out_file_handle));
+}
+
+// Opens a guarded copy of the test file |name|. See WrapGuardedContents.
+static void OpenGuardedTestFile(const char* name, size_t data_offset,
+                                iree_io_file_handle_t** out_file_handle) {
+  *out_file_handle = NULL;
+  const struct iree_file_toc_t* file_toc = iree_io_gguf_files_create();
+  for (size_t i = 0; i < iree_io_gguf_files_size(); ++i) {
+    if (strcmp(file_toc[i].name, name) == 0) {
+      WrapGuardedContents(
+          iree_make_const_byte_span(file_toc[i].data, file_toc[i].size),
+          data_offset, out_file_handle);
+      return;
+    }
+  }
+  FAIL() << "test file `" << name << "` not found embedded into test binary";
+}
+
+#endif  // IREE_HAVE_MPROTECT
+
 TEST(GgufFormatTest, Empty) {
   iree_io_parameter_index_t* index = NULL;
   IREE_ASSERT_OK(
@@ -121,5 +196,84 @@ TEST(GgufFormatTest, MultipleTensors) {
   iree_io_parameter_index_release(index);
 }
 
+#if defined(IREE_HAVE_MPROTECT)
+// Parsing must only read the header and never the tensor data as files may be
+// much larger than available memory.
+TEST(GgufFormatTest, DoesNotTouchTensorData) {
+  iree_io_parameter_index_t* index = NULL;
+  IREE_ASSERT_OK(
+      iree_io_parameter_index_create(iree_allocator_system(), &index));
+
+  iree_io_file_handle_t* file_handle = NULL;
+  OpenGuardedTestFile("multiple.gguf", /*data_offset=*/448, &file_handle);
+  ASSERT_NE(file_handle, nullptr);
+  IREE_ASSERT_OK(iree_io_parse_gguf_index(file_handle, index));
+  EXPECT_EQ(3, iree_io_parameter_index_count(index));
+  iree_io_file_handle_release(file_handle);
+
+  iree_io_parameter_index_release(index);
+}
+#endif  // IREE_HAVE_MPROTECT
+
+// Headers larger than the initially mapped prefix (here due to a large string
+// metadata value) must be parsed by growing the mapping.
+TEST(GgufFormatTest, LargeHeader) {
+  std::vector<uint8_t> contents;
+  auto append = [&](const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    contents.insert(contents.end(), bytes, bytes + length);
+  };
+  auto append_u32 = [&](uint32_t value) { append(&value, sizeof(value)); };
+  auto append_u64 = [&](uint64_t value) { append(&value, sizeof(value)); };
+  auto append_string = [&](const std::string& value) {
+    append_u64(value.size());
+    append(value.data(), value.size());
+  };
+  append_u32(0x46554747);  // GGUF_MAGIC
+  append_u32(3);           // version
+  append_u64(1);           // tensor_count
+  append_u64(1);           // metadata_kv_count
+  append_string("general.name");
+  append_u32(8);  // GGUF_METADATA_VALUE_TYPE_STRING
+  append_string(std::string(3 * 1024 * 1024, 'x'));
+  append_string("tensor0");
+  append_u32(1);  // n_dimensions
+  append_u64(4);  // dimensions[0]
+  append_u32(0);  // GGML_TYPE_F32
+  append_u64(0);  // offset
+  contents.resize(iree_host_align(contents.size(), 32));  // alignment
+  const size_t data_offset = contents.size();
+  contents.resize(data_offset + 4 * sizeof(float));
+
+  iree_io_parameter_index_t* index = NULL;
+  IREE_ASSERT_OK(
+      iree_io_parameter_index_create(iree_allocator_system(), &index));
+
+  iree_io_file_handle_t* file_handle = NULL;
+#if defined(IREE_HAVE_MPROTECT)
+  WrapGuardedContents(
+      iree_make_const_byte_span(contents.data(), contents.size()), data_offset,
+      &file_handle);
+#else
+  IREE_ASSERT_OK(iree_io_file_handle_wrap_host_allocation(
+      IREE_IO_FILE_ACCESS_READ,
+      iree_make_byte_span(contents.data(), contents.size()),
+      iree_io_file_handle_release_callback_null(), iree_allocator_system(),
+      &file_handle));
+#endif  // IREE_HAVE_MPROTECT
+  ASSERT_NE(file_handle, nullptr);
+  IREE_ASSERT_OK(iree_io_parse_gguf_index(file_handle, index));
+  iree_io_file_handle_release(file_handle);
+
+  EXPECT_EQ(1, iree_io_parameter_index_count(index));
+  const iree_io_parameter_index_entry_t* entry0 = NULL;
+  IREE_ASSERT_OK(
+      iree_io_parameter_index_lookup(index, IREE_SV("tensor0"), &entry0));
+  EXPECT_EQ(entry0->storage.file.offset, data_offset);
+  EXPECT_EQ(entry0->length, 4 * sizeof(float));
+
+  iree_io_parameter_index_release(index);
+}
+
 }  // namespace
 }  // namespace iree
@@ -9,22 +9,48 @@
 #include "iree/schemas/parameter_archive.h"
 
 static iree_status_t iree_io_verify_irpa_v0_file_range(
-    iree_const_byte_span_t file_contents, iree_io_physical_offset_t base_offset,
+    uint64_t file_length, iree_io_physical_offset_t base_offset,
     iree_io_parameter_archive_range_t range) {
   if (range.length == 0) return iree_ok_status();
-  if (base_offset + range.offset + range.length > file_contents.data_length) {
+  if (range.offset > file_length - base_offset ||
+      range.length > file_length - base_offset - range.offset) {
     return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
                             "file segment out of range (%" PRIu64 " to %" PRIu64
-                            " for %" PRIu64 ", file_size=%" PRIhsz ")",
+                            " for %" PRIu64 ", file_size=%" PRIu64 ")",
                             base_offset + range.offset,
                             base_offset + range.offset + range.length - 1,
-                            range.length, file_contents.data_length);
+                            range.length, file_length);
   }
   return iree_ok_status();
 }
 
+// Maps the |range| of the archive relative to |base_offset| for reading.
+// Returns NULL in |out_mapping| if the range is empty.
+static iree_status_t iree_io_map_irpa_v0_file_range(
+    iree_io_file_handle_t* file_handle, iree_io_physical_offset_t base_offset,
+    iree_io_parameter_archive_range_t range,
+    iree_io_file_mapping_t** out_mapping) {
+  *out_mapping = NULL;
+  if (range.length == 0) return iree_ok_status();
+  if (range.length > (uint64_t)IREE_HOST_SIZE_MAX) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "file segment of %" PRIu64
+                            " bytes exceeds host address space",
+                            range.length);
+  }
+  return iree_io_file_map_view(file_handle, base_offset + range.offset,
+                               (iree_host_size_t)range.length,
+                               iree_allocator_system(), out_mapping);
+}
+
+static iree_const_byte_span_t iree_io_irpa_v0_mapping_contents(
+    iree_io_file_mapping_t* mapping) {
+  return mapping ? iree_io_file_mapping_contents(mapping)
+                 : iree_const_byte_span_empty();
+}
+
 static iree_status_t iree_io_resolve_irpa_v0_string(
-    iree_const_byte_span_t file_contents, iree_io_physical_offset_t base_offset,
+    iree_const_byte_span_t metadata_contents,
     const iree_io_parameter_archive_header_v0_t* header,
     iree_io_parameter_archive_metadata_ref_t range,
     iree_string_view_t* out_view) {
@@ -38,15 +64,13 @@ static iree_status_t iree_io_resolve_irpa_v0_string(
                             range.offset, range.offset + range.length - 1,
                             range.length, header->metadata_segment.length);
   }
-  iree_io_physical_offset_t view_offset =
-      base_offset + header->metadata_segment.offset + range.offset;
   *out_view = iree_make_string_view(
-      (const char*)file_contents.data + view_offset, range.length);
+      (const char*)metadata_contents.data + range.offset, range.length);
   return iree_ok_status();
 }
 
 static iree_status_t iree_io_resolve_irpa_v0_metadata(
-    iree_const_byte_span_t file_contents, iree_io_physical_offset_t base_offset,
+    iree_const_byte_span_t metadata_contents,
     const iree_io_parameter_archive_header_v0_t* header,
     iree_io_parameter_archive_metadata_ref_t range,
     iree_const_byte_span_t* out_span) {
@@ -60,15 +84,13 @@ static iree_status_t iree_io_resolve_irpa_v0_metadata(
                             range.offset, range.offset + range.length - 1,
                             range.length, header->metadata_segment.length);
   }
-  iree_io_physical_offset_t span_offset =
-      base_offset + header->metadata_segment.offset + range.offset;
-  *out_span =
-      iree_make_const_byte_span(file_contents.data + span_offset, range.length);
+  *out_span = iree_make_const_byte_span(metadata_contents.data + range.offset,
+                                        range.length);
   return iree_ok_status();
 }
 
 static iree_status_t iree_io_resolve_irpa_v0_storage(
-    iree_const_byte_span_t file_contents, iree_io_physical_offset_t base_offset,
+    iree_io_physical_offset_t base_offset,
     const iree_io_parameter_archive_header_v0_t* header,
     iree_io_parameter_archive_storage_ref_t range,
     iree_io_physical_offset_t* out_offset) {
@@ -123,8 +145,7 @@ static iree_status_t iree_io_parse_irpa_v0_splat_entry(
 }
 
 static iree_status_t iree_io_parse_irpa_v0_data_entry(
-    iree_io_file_handle_t* file_handle, iree_const_byte_span_t file_contents,
-    iree_io_physical_offset_t base_offset,
+    iree_io_file_handle_t* file_handle, iree_io_physical_offset_t base_offset,
     const iree_io_parameter_archive_header_v0_t* header,
     const iree_io_parameter_archive_data_entry_t* data_entry,
     iree_string_view_t name, iree_const_byte_span_t metadata,
@@ -135,8 +156,8 @@ static iree_status_t iree_io_parse_irpa_v0_data_entry(
   }
   iree_io_physical_offset_t storage_offset = 0;
   IREE_RETURN_IF_ERROR(
-      iree_io_resolve_irpa_v0_storage(file_contents, base_offset, header,
-                                      data_entry->storage, &storage_offset));
+      iree_io_resolve_irpa_v0_storage(base_offset, header, data_entry->storage,
+                                      &storage_offset));
   iree_io_parameter_index_entry_t entry = {
       .key = name,
       .metadata = metadata,
@@ -154,47 +175,18 @@ static iree_status_t iree_io_parse_irpa_v0_data_entry(
   return iree_io_parameter_index_add(index, &entry);
 }
 
-static iree_status_t iree_io_parse_irpa_v0_index_from_memory(
-    iree_io_file_handle_t* file_handle, iree_const_byte_span_t file_contents,
-    iree_io_physical_offset_t base_offset,
-    const iree_io_parameter_archive_header_prefix_t* header_prefix,
+// Walks the |entry_contents| table of the archive and adds each entry to
+// |index|. Names and metadata are resolved from |metadata_contents| and storage
+// is only referenced by offset relative to |base_offset|.
+static iree_status_t iree_io_parse_irpa_v0_entries(
+    iree_io_file_handle_t* file_handle, iree_io_physical_offset_t base_offset,
+    const iree_io_parameter_archive_header_v0_t* header,
+    iree_const_byte_span_t entry_contents,
+    iree_const_byte_span_t metadata_contents,
     iree_io_parameter_index_t* index) {
-  // Get the full header struct.
-  if (header_prefix->version_minor > 0) {
-    return iree_make_status(
-        IREE_STATUS_UNIMPLEMENTED,
-        "IRPA version %u.%u not supported (major supported "
-        "but minor is newer than the runtime trying to parse it)",
-        header_prefix->version_major, header_prefix->version_minor);
-  }
-  if (header_prefix->header_size !=
-      sizeof(iree_io_parameter_archive_header_v0_t)) {
-    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
-                            "IRPA v0 header expected to be exactly %" PRIhsz
-                            " bytes but was reported as %" PRIu64,
-                            sizeof(iree_io_parameter_archive_header_v0_t),
-                            header_prefix->header_size);
-  }
-  const iree_io_parameter_archive_header_v0_t* header =
-      (const iree_io_parameter_archive_header_v0_t*)file_contents.data;
-
-  // Verify the base data ranges; this lets all subsequent checks be against the
-  // header instead of needing to know about the view into the file.
-  IREE_RETURN_IF_ERROR(iree_io_verify_irpa_v0_file_range(
-                           file_contents, base_offset, header->entry_segment),
-                       "verifying entry table");
-  IREE_RETURN_IF_ERROR(
-      iree_io_verify_irpa_v0_file_range(file_contents, base_offset,
-                                        header->metadata_segment),
-      "verifying metadata segment");
-  IREE_RETURN_IF_ERROR(iree_io_verify_irpa_v0_file_range(
-                           file_contents, base_offset, header->storage_segment),
-                       "verifying storage segment");
-
   // Walk the entry table, which has variable-length entries.
-  iree_io_physical_offset_t entry_offset =
-      base_offset + header->entry_segment.offset;
-  iree_io_physical_size_t entry_size_remaining = header->entry_segment.length;
+  iree_io_physical_offset_t entry_offset = 0;
+  iree_io_physical_size_t entry_size_remaining = entry_contents.data_length;
   for (iree_io_physical_size_t i = 0; i < header->entry_count; ++i) {
     // Ensure there's enough space in the table for the base entry header.
     if (entry_size_remaining <
@@ -206,7 +198,7 @@ static iree_status_t iree_io_parse_irpa_v0_index_from_memory(
 
     // Ensure there's enough space for the declared entry size (if any larger).
     const iree_io_parameter_archive_entry_header_t* entry_header =
-        (const iree_io_parameter_archive_entry_header_t*)(file_contents.data +
+        (const iree_io_parameter_archive_entry_header_t*)(entry_contents.data +
                                                           entry_offset);
     if (entry_header->entry_size < sizeof(*entry_header) ||
         entry_size_remaining < entry_header->entry_size) {
@@ -218,17 +210,17 @@ static iree_status_t iree_io_parse_irpa_v0_index_from_memory(
     iree_io_physical_offset_t aligned_entry_size = iree_align_uint64(
         entry_header->entry_size, IREE_IO_PARAMETER_ARCHIVE_ENTRY_ALIGNMENT);
     entry_offset += aligned_entry_size;
-    entry_size_remaining -= aligned_entry_size;
+    entry_size_remaining -= iree_min(aligned_entry_size, entry_size_remaining);
 
     // Resolve entry metadata from the archive metadata segment.
     iree_string_view_t name = iree_string_view_empty();
     IREE_RETURN_IF_ERROR(
-        iree_io_resolve_irpa_v0_string(file_contents, base_offset, header,
+        iree_io_resolve_irpa_v0_string(metadata_contents, header,
                                        entry_header->name, &name),
         "resolving entry name");
     iree_const_byte_span_t metadata = iree_const_byte_span_empty();
     IREE_RETURN_IF_ERROR(
-        iree_io_resolve_irpa_v0_metadata(file_contents, base_offset, header,
+        iree_io_resolve_irpa_v0_metadata(metadata_contents, header,
                                          entry_header->metadata, &metadata),
         "resolving entry metadata");
 
@@ -245,7 +237,7 @@ static iree_status_t iree_io_parse_irpa_v0_index_from_memory(
       }
       case IREE_IO_PARAMETER_ARCHIVE_ENTRY_TYPE_DATA: {
         IREE_RETURN_IF_ERROR(iree_io_parse_irpa_v0_data_entry(
-            file_handle, file_contents, base_offset, header,
+            file_handle, base_offset, header,
             (const iree_io_parameter_archive_data_entry_t*)entry_header, name,
             metadata, index));
         break;
@@ -260,65 +252,126 @@ static iree_status_t iree_io_parse_irpa_v0_index_from_memory(
   return iree_ok_status();
 }
 
-static iree_status_t iree_io_parse_irpa_index_from_memory(
-    iree_io_file_handle_t* file_handle, iree_const_byte_span_t file_contents,
+static iree_status_t iree_io_parse_irpa_v0_index_from_file(
+    iree_io_file_handle_t* file_handle, uint64_t file_length,
+    iree_io_physical_offset_t base_offset,
+    const iree_io_parameter_archive_header_prefix_t* header_prefix,
+    iree_io_parameter_index_t* index) {
+  // Get the full header struct.
+  if (header_prefix->version_minor > 0) {
+    return iree_make_status(
+        IREE_STATUS_UNIMPLEMENTED,
+        "IRPA version %u.%u not supported (major supported "
+        "but minor is newer than the runtime trying to parse it)",
+        header_prefix->version_major, header_prefix->version_minor);
+  }
+  if (header_prefix->header_size !=
+      sizeof(iree_io_parameter_archive_header_v0_t)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "IRPA v0 header expected to be exactly %" PRIhsz
+                            " bytes but was reported as %" PRIu64,
+                            sizeof(iree_io_parameter_archive_header_v0_t),
+                            header_prefix->header_size);
+  }
+  iree_io_parameter_archive_header_v0_t header;
+  IREE_RETURN_IF_ERROR(
+      iree_io_file_handle_read(file_handle, base_offset, &header,
+                               sizeof(header)),
+      "reading IRPA v0 header");
+
+  // Verify the base data ranges; this lets all subsequent checks be against the
+  // header instead of needing to know about the view into the file.
+  IREE_RETURN_IF_ERROR(iree_io_verify_irpa_v0_file_range(
+                           file_length, base_offset, header.entry_segment),
+                       "verifying entry table");
+  IREE_RETURN_IF_ERROR(iree_io_verify_irpa_v0_file_range(
+                           file_length, base_offset, header.metadata_segment),
+                       "verifying metadata segment");
+  IREE_RETURN_IF_ERROR(iree_io_verify_irpa_v0_file_range(
+                           file_length, base_offset, header.storage_segment),
+                       "verifying storage segment");
+
+  // Map only the entry table and metadata segment. The storage segment holding
+  // the parameter data is referenced by the index entries through the file
+  // handle and is never touched while parsing.
+  iree_io_file_mapping_t* entry_mapping = NULL;
+  IREE_RETURN_IF_ERROR(iree_io_map_irpa_v0_file_range(
+      file_handle, base_offset, header.entry_segment, &entry_mapping));
+  iree_io_file_mapping_t* metadata_mapping = NULL;
+  iree_status_t status = iree_io_map_irpa_v0_file_range(
+      file_handle, base_offset, header.metadata_segment, &metadata_mapping);
+  if (iree_status_is_ok(status)) {
+    status = iree_io_parse_irpa_v0_entries(
+        file_handle, base_offset, &header,
+        iree_io_irpa_v0_mapping_contents(entry_mapping),
+        iree_io_irpa_v0_mapping_contents(metadata_mapping), index);
+  }
+  iree_io_file_mapping_release(metadata_mapping);
+  iree_io_file_mapping_release(entry_mapping);
+  return status;
+}
+
+static iree_status_t iree_io_parse_irpa_index_from_file(
+    iree_io_file_handle_t* file_handle, uint64_t file_length,
     iree_io_physical_offset_t base_offset, iree_io_parameter_index_t* index) {
   // Check the basic header information is something we can process.
-  if (file_contents.data_length <
-      base_offset + sizeof(iree_io_parameter_archive_header_prefix_t)) {
+  if (base_offset > file_length ||
+      file_length - base_offset <
+          sizeof(iree_io_parameter_archive_header_prefix_t)) {
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "not enough bytes for a valid IRPA header; file "
                             "may be empty or truncated");
   }
-  const iree_io_parameter_archive_header_prefix_t* header_prefix =
-      (const iree_io_parameter_archive_header_prefix_t*)(file_contents.data +
-                                                         base_offset);
-  if (header_prefix->magic != IREE_IO_PARAMETER_ARCHIVE_MAGIC) {
+  iree_io_parameter_archive_header_prefix_t header_prefix;
+  IREE_RETURN_IF_ERROR(
+      iree_io_file_handle_read(file_handle, base_offset, &header_prefix,
+                               sizeof(header_prefix)),
+      "reading IRPA header prefix");
+  if (header_prefix.magic != IREE_IO_PARAMETER_ARCHIVE_MAGIC) {
     return iree_make_status(
         IREE_STATUS_INVALID_ARGUMENT,
         "IRPA file magic missing or invalid %08X; expected %08X",
-        header_prefix->magic, IREE_IO_PARAMETER_ARCHIVE_MAGIC);
+        header_prefix.magic, IREE_IO_PARAMETER_ARCHIVE_MAGIC);
   }
-  if (header_prefix->header_size > file_contents.data_length) {
+  if (header_prefix.header_size > file_length - base_offset) {
     return iree_make_status(
         IREE_STATUS_OUT_OF_RANGE,
         "file buffer underrun parsing header of reported size %" PRIu64
-        " (only %" PRIhsz " bytes available)",
-        header_prefix->header_size, file_contents.data_length);
+        " (only %" PRIu64 " bytes available)",
+        header_prefix.header_size, file_length - base_offset);
   }
-  if (header_prefix->next_header_offset != 0 &&
-      file_contents.data_length <
-          base_offset + header_prefix->next_header_offset +
-              sizeof(iree_io_parameter_archive_header_prefix_t)) {
+  if (header_prefix.next_header_offset != 0 &&
+      (header_prefix.next_header_offset > file_length - base_offset ||
+       file_length - base_offset - header_prefix.next_header_offset <
+           sizeof(iree_io_parameter_archive_header_prefix_t))) {
     return iree_make_status(
         IREE_STATUS_OUT_OF_RANGE,
         "file buffer underrun verifying linked header at offset %" PRIu64
-        " (only %" PRIhsz " bytes available)",
-        base_offset + header_prefix->next_header_offset,
-        file_contents.data_length);
+        " (only %" PRIu64 " bytes available)",
+        base_offset + header_prefix.next_header_offset, file_length);
   }
 
   // Route major versions to their parsers, allowing us to change everything but
   // the prefix without breaking compatibility.
-  switch (header_prefix->version_major) {
+  switch (header_prefix.version_major) {
     case 0: {
-      IREE_RETURN_IF_ERROR(iree_io_parse_irpa_v0_index_from_memory(
-          file_handle, file_contents, base_offset, header_prefix, index));
+      IREE_RETURN_IF_ERROR(iree_io_parse_irpa_v0_index_from_file(
+          file_handle, file_length, base_offset, &header_prefix, index));
       break;
     }
     default: {
       return iree_make_status(
           IREE_STATUS_UNIMPLEMENTED,
           "IRPA major version %u.%u not supported by this runtime",
-          header_prefix->version_major, header_prefix->version_minor);
+          header_prefix.version_major, header_prefix.version_minor);
     }
   }
 
   // If there's a linked header then tail-call process it.
-  if (header_prefix->next_header_offset == 0) return iree_ok_status();
-  return iree_io_parse_irpa_index_from_memory(
-      file_handle, file_contents,
-      base_offset + header_prefix->next_header_offset, index);
+  if (header_prefix.next_header_offset == 0) return iree_ok_status();
+  return iree_io_parse_irpa_index_from_file(
+      file_handle, file_length, base_offset + header_prefix.next_header_offset,
+      index);
 }
 
 IREE_API_EXPORT iree_status_t iree_io_parse_irpa_index(
@@ -326,22 +379,14 @@ IREE_API_EXPORT iree_status_t iree_io_parse_irpa_index(
   IREE_ASSERT_ARGUMENT(index);
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // Today we only support memory files.
-  // TODO(benvanik): support iree_io_stream_t wrapping for parsing the index.
-  if (iree_io_file_handle_type(file_handle) !=
-      IREE_IO_FILE_HANDLE_TYPE_HOST_ALLOCATION) {
-    IREE_TRACE_ZONE_END(z0);
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "non-memory irpa files not yet supported");
-  }
-  iree_byte_span_t host_allocation =
-      iree_io_file_handle_primitive(file_handle).value.host_allocation;
-
-  iree_status_t status = iree_io_parse_irpa_index_from_memory(
-      file_handle,
-      iree_make_const_byte_span(host_allocation.data,
-                                host_allocation.data_length),
-      /*base_offset=*/0, index);
+  // Headers are read and only the entry table and metadata segments of each are
+  // mapped; parameter storage is never read while parsing. Host allocations
+  // are viewed directly while file descriptors are mapped.
+  uint64_t file_length = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_io_file_handle_query_length(file_handle, &file_length));
+  iree_status_t status = iree_io_parse_irpa_index_from_file(
+      file_handle, file_length, /*base_offset=*/0, index);
 
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -10,6 +10,13 @@
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
 
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_APPLE) || \
+    defined(IREE_PLATFORM_LINUX)
+#include <sys/mman.h>
+#include <unistd.h>
+#define IREE_HAVE_MPROTECT 1
+#endif  // IREE_PLATFORM_*
+
 namespace iree {
 namespace {
 
@@ -32,6 +39,63 @@ static iree_io_file_handle_t* OpenTestFile(const char* name) {
   return NULL;
 }
 
+#if defined(IREE_HAVE_MPROTECT)
+
+// Pages holding a copy of a test file.
+struct GuardedAllocation {
+  void* base = NULL;
+  size_t length = 0;
+};
+
+static void ReleaseGuardedAllocation(
+    void* user_data, iree_io_file_handle_primitive_t handle_primitive) {
+  auto* allocation = static_cast<GuardedAllocation*>(user_data);
+  munmap(allocation->base, allocation->length);
+  delete allocation;
+}
+
+// Opens a copy of the test file |name| where every byte at or after
+// |data_offset| is in pages that cannot be accessed. Parsing faults if it
+// touches the tensor data.
+static void OpenGuardedTestFile(const char* name, size_t data_offset,
+                                iree_io_file_handle_t** out_file_handle) {
+  *out_file_handle = NULL;
+  iree_const_byte_span_t contents = iree_const_byte_span_empty();
+  const struct iree_file_toc_t* file_toc = iree_io_irpa_files_create();
+  for (size_t i = 0; i < iree_io_irpa_files_size(); ++i) {
+    if (strcmp(file_toc[i].name, name) == 0) {
+      contents = iree_make_const_byte_span(file_toc[i].data, file_toc[i].size);
+      break;
+    }
+  }
+  ASSERT_GT(contents.data_length, data_offset) << name;
+
+  const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  const size_t header_length = iree_host_align(data_offset, page_size);
+  const size_t data_length =
+      iree_host_align(contents.data_length - data_offset, page_size);
+  auto* allocation = new GuardedAllocation();
+  allocation->length = header_length + data_length;
+  allocation->base = mmap(NULL, allocation->length, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(allocation->base, MAP_FAILED);
+  uint8_t* data_base = (uint8_t*)allocation->base + header_length;
+  uint8_t* file_base = data_base - data_offset;
+  memcpy(file_base, contents.data, contents.data_length);
+  ASSERT_EQ(mprotect(data_base, data_length, PROT_NONE), 0);
+
+  iree_io_file_handle_release_callback_t release_callback = {
+      ReleaseGuardedAllocation,
+      allocation,
+  };
+  IREE_ASSERT_OK(iree_io_file_handle_wrap_host_allocation(
+      IREE_IO_FILE_ACCESS_READ,
+      iree_make_byte_span(file_base, contents.data_length), release_callback,
+      iree_allocator_system(), out_file_handle));
+}
+
+#endif  // IREE_HAVE_MPROTECT
+
 TEST(IrpaFormatTest, Empty) {
   iree_io_parameter_index_t* index = NULL;
   IREE_ASSERT_OK(
@@ -153,5 +217,24 @@ TEST(IrpaFormatTest, MixedDataAndSplats) {
   iree_io_parameter_index_release(index);
 }
 
+#if defined(IREE_HAVE_MPROTECT)
+// Parsing must only read the header and never the tensor data as files may be
+// much larger than available memory.
+TEST(IrpaFormatTest, DoesNotTouchTensorData) {
+  iree_io_parameter_index_t* index = NULL;
+  IREE_ASSERT_OK(
+      iree_io_parameter_index_create(iree_allocator_system(), &index));
+
+  iree_io_file_handle_t* file_handle = NULL;
+  OpenGuardedTestFile("mixed.irpa", /*data_offset=*/512, &file_handle);
+  ASSERT_NE(file_handle, nullptr);
+  IREE_ASSERT_OK(iree_io_parse_irpa_index(file_handle, index));
+  EXPECT_EQ(4, iree_io_parameter_index_count(index));
+  iree_io_file_handle_release(file_handle);
+
+  iree_io_parameter_index_release(index);
+}
+#endif  // IREE_HAVE_MPROTECT
+
 }  // namespace
 }  // namespace iree
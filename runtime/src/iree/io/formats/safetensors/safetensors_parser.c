@@ -456,13 +456,14 @@ static iree_status_t iree_io_enumerate_safetensors_entries(
 }
 
 static iree_status_t iree_io_parse_safetensors_index_from_memory(
-    iree_io_file_handle_t* file_handle, iree_const_byte_span_t file_contents,
-    iree_io_parameter_index_t* index) {
-  // Reads the header JSON blob out of the file contents and calculates the base
-  // offset that all data ranges are relative to. Verifies that the header and
-  // base offset is in range but each entry data range still needs to be
-  // verified.
-  uint64_t remaining_bytes = file_contents.data_length;
+    iree_io_file_handle_t* file_handle, iree_const_byte_span_t header_contents,
+    uint64_t file_length, iree_io_parameter_index_t* index) {
+  // Reads the header JSON blob out of the header contents (a prefix of the
+  // file) and calculates the base offset that all data ranges are relative to.
+  // Verifies that the header and base offset is in range but each entry data
+  // range still needs to be verified against the total |file_length|, which is
+  // at least as large as |header_contents|.
+  uint64_t remaining_bytes = header_contents.data_length;
   uint64_t header_length = 0;
   if (remaining_bytes < sizeof(header_length)) {
     return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
@@ -472,7 +473,7 @@ static iree_status_t iree_io_parse_safetensors_index_from_memory(
                             sizeof(header_length), remaining_bytes);
   }
   header_length =
-      iree_unaligned_load_le_u64((const uint64_t*)file_contents.data);
+      iree_unaligned_load_le_u64((const uint64_t*)header_contents.data);
   remaining_bytes -= sizeof(header_length);
   if (remaining_bytes < header_length) {
     return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
@@ -482,10 +483,9 @@ static iree_status_t iree_io_parse_safetensors_index_from_memory(
                             header_length, remaining_bytes);
   }
   const iree_string_view_t header_json = iree_make_string_view(
-      (const char*)file_contents.data + sizeof(header_length),
+      (const char*)header_contents.data + sizeof(header_length),
       (iree_host_size_t)header_length);
   const uint64_t base_offset = sizeof(header_length) + header_length;
-  remaining_bytes -= header_length;
 
   // Parses a safetensors |header_json| blob and emits entries to |index|.
   // Each entry is bounds checked against the |data_size| of the file (bytes
@@ -493,7 +493,7 @@ static iree_status_t iree_io_parse_safetensors_index_from_memory(
   iree_io_enumerate_safetensors_entry_state_t enumerate_state = {
       .file_handle = file_handle,
       .base_offset = base_offset,
-      .data_size = remaining_bytes,
+      .data_size = file_length - base_offset,
       .index = index,
   };
   return iree_json_enumerate_object(
@@ -505,23 +505,44 @@ IREE_API_EXPORT iree_status_t iree_io_parse_safetensors_index(
   IREE_ASSERT_ARGUMENT(index);
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // Today we only support memory files.
-  // TODO(benvanik): support iree_io_stream_t wrapping for parsing the index.
-  if (iree_io_file_handle_type(file_handle) !=
-      IREE_IO_FILE_HANDLE_TYPE_HOST_ALLOCATION) {
+  // Read the header length from the start of the file. Files too small to
+  // contain it are passed through so that parsing reports the error.
+  uint64_t file_length = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_io_file_handle_query_length(file_handle, &file_length));
+  uint64_t header_length = 0;
+  if (file_length >= sizeof(header_length)) {
+    uint8_t header_length_bytes[sizeof(header_length)];
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_io_file_handle_read(file_handle, /*file_offset=*/0,
+                                     header_length_bytes,
+                                     sizeof(header_length_bytes)));
+    header_length =
+        iree_unaligned_load_le_u64((const uint64_t*)header_length_bytes);
+  }
+
+  // Map only the header; tensor data is referenced by the index entries through
+  // the original file handle and is never touched while parsing. Host
+  // allocations are viewed directly while file descriptors are mapped.
+  uint64_t mapping_length =
+      iree_min(file_length,
+               sizeof(header_length) + iree_min(header_length, file_length));
+  if (mapping_length > (uint64_t)IREE_HOST_SIZE_MAX) {
     IREE_TRACE_ZONE_END(z0);
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "non-memory safetensors files not yet supported");
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "safetensors header exceeds host address space");
   }
-  iree_byte_span_t host_allocation =
-      iree_io_file_handle_primitive(file_handle).value.host_allocation;
+  iree_io_file_mapping_t* file_mapping = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_io_file_map_view(file_handle, /*offset=*/0,
+                                (iree_host_size_t)mapping_length,
+                                iree_allocator_system(), &file_mapping));
 
   iree_status_t status = iree_io_parse_safetensors_index_from_memory(
-      file_handle,
-      iree_make_const_byte_span(host_allocation.data,
-                                host_allocation.data_length),
+      file_handle, iree_io_file_mapping_contents(file_mapping), file_length,
       index);
 
+  iree_io_file_mapping_release(file_mapping);
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -7,25 +7,66 @@
 #include "iree/io/parameter_index.h"
 
 #include "iree/base/internal/atomics.h"
+#include "iree/base/internal/math.h"
 #include "iree/base/internal/synchronization.h"
 
+// A slot in the open-addressed key lookup table.
+// The full hash is stored alongside the entry so that probing rarely needs to
+// touch the (cold) entry memory for keys that do not match.
+typedef struct iree_io_parameter_index_slot_t {
+  // Hash of the entry key; only valid if |entry| is non-NULL.
+  uint64_t hash;
+  // Entry with the given key or NULL if the slot is empty.
+  const iree_io_parameter_index_entry_t* entry;
+} iree_io_parameter_index_slot_t;
+
 struct iree_io_parameter_index_t {
   iree_atomic_ref_count_t ref_count;
   iree_allocator_t host_allocator;
 
-  // Guards mutation of the entries list.
+  // Guards mutation of the entries list and key table.
   // NOTE: this does not guard the entries themselves as we assume they are
   // immutable (today).
   iree_slim_mutex_t mutex;
 
+  // Non-zero once the index has been frozen and no more entries can be added.
+  // Once set all fields below are immutable and reads can skip the mutex.
+  iree_atomic_int32_t frozen;
+
   // Total capacity of the entries list in elements.
   iree_host_size_t entry_capacity;
   // Currently used entry count in elements.
   iree_host_size_t entry_count;
   // Dense list of entries in the index. Grows as needed.
   iree_io_parameter_index_entry_t** entries;
+
+  // Total capacity of the key table in slots. Always a power of two (or 0).
+  iree_host_size_t slot_capacity;
+  // Number of used slots in the key table. This may be less than the entry
+  // count if there are entries with duplicate keys as only the first is
+  // indexed.
+  iree_host_size_t slot_count;
+  // Open-addressed (linear probing) table mapping keys to entries.
+  iree_io_parameter_index_slot_t* slots;
 };
 
+// Returns true if the |index| has been frozen and reads can skip locking.
+static inline bool iree_io_parameter_index_is_frozen(
+    iree_io_parameter_index_t* index) {
+  return iree_atomic_load(&index->frozen, iree_memory_order_acquire) != 0;
+}
+
+// 64-bit FNV-1a hash of |key|. Parameter keys are short human-readable names
+// and this is cheap enough to compute per lookup.
+static uint64_t iree_io_parameter_index_hash_key(iree_string_view_t key) {
+  uint64_t hash = UINT64_C(0xCBF29CE484222325);
+  for (iree_host_size_t i = 0; i < key.size; ++i) {
+    hash ^= (uint8_t)key.data[i];
+    hash *= UINT64_C(0x00000100000001B3);
+  }
+  return hash;
+}
+
 IREE_API_EXPORT iree_status_t iree_io_parameter_index_create(
     iree_allocator_t host_allocator, iree_io_parameter_index_t** out_index) {
   IREE_ASSERT_ARGUMENT(out_index);
@@ -40,12 +81,16 @@ IREE_API_EXPORT iree_status_t iree_io_parameter_index_create(
   index->host_allocator = host_allocator;
 
   iree_slim_mutex_initialize(&index->mutex);
+  iree_atomic_store(&index->frozen, 0, iree_memory_order_relaxed);
 
   // Grown on first use. We could allocate a bit of inline storage or take an
   // optional initial capacity for callers that know.
   index->entry_capacity = 0;
   index->entry_count = 0;
   index->entries = NULL;
+  index->slot_capacity = 0;
+  index->slot_count = 0;
+  index->slots = NULL;
 
   *out_index = index;
   IREE_TRACE_ZONE_END(z0);
@@ -71,6 +116,9 @@ static void iree_io_parameter_index_destroy(iree_io_parameter_index_t* index) {
   if (index->entries) {
     iree_allocator_free(host_allocator, index->entries);
   }
+  if (index->slots) {
+    iree_allocator_free(host_allocator, index->slots);
+  }
 
   iree_slim_mutex_deinitialize(&index->mutex);
 
@@ -96,26 +144,94 @@ IREE_API_EXPORT void iree_io_parameter_index_release(
 IREE_API_EXPORT iree_host_size_t
 iree_io_parameter_index_count(iree_io_parameter_index_t* index) {
   IREE_ASSERT_ARGUMENT(index);
+  if (iree_io_parameter_index_is_frozen(index)) return index->entry_count;
   iree_slim_mutex_lock(&index->mutex);
   iree_host_size_t count = index->entry_count;
   iree_slim_mutex_unlock(&index->mutex);
   return count;
 }
 
+// Inserts |entry| into the key table if no entry with the same key exists.
+// The table must have at least one free slot.
+static void iree_io_parameter_index_insert_slot_unsafe(
+    iree_io_parameter_index_t* index, uint64_t hash,
+    const iree_io_parameter_index_entry_t* entry) {
+  const iree_host_size_t mask = index->slot_capacity - 1;
+  for (iree_host_size_t i = (iree_host_size_t)hash & mask;; i = (i + 1) & mask) {
+    iree_io_parameter_index_slot_t* slot = &index->slots[i];
+    if (!slot->entry) {
+      slot->hash = hash;
+      slot->entry = entry;
+      ++index->slot_count;
+      return;
+    } else if (slot->hash == hash &&
+               iree_string_view_equal(slot->entry->key, entry->key)) {
+      // Duplicate key: the first entry added wins to match the behavior of
+      // enumerating the entries in order.
+      return;
+    }
+  }
+}
+
+// Grows the key table such that |new_entry_capacity| unique keys can be
+// inserted while keeping the load factor at or below 50%.
+static iree_status_t iree_io_parameter_index_reserve_slots_unsafe(
+    iree_io_parameter_index_t* index, iree_host_size_t new_entry_capacity) {
+  iree_host_size_t new_slot_capacity =
+      iree_math_round_up_to_pow2_u64(iree_max(32, new_entry_capacity * 2));
+  if (new_slot_capacity <= index->slot_capacity) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, new_slot_capacity);
+
+  iree_io_parameter_index_slot_t* new_slots = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(index->host_allocator,
+                                new_slot_capacity * sizeof(new_slots[0]),
+                                (void**)&new_slots));
+
+  // Rehash all existing slots into the new table.
+  iree_io_parameter_index_slot_t* old_slots = index->slots;
+  iree_host_size_t old_slot_capacity = index->slot_capacity;
+  index->slots = new_slots;
+  index->slot_capacity = new_slot_capacity;
+  index->slot_count = 0;
+  for (iree_host_size_t i = 0; i < old_slot_capacity; ++i) {
+    if (!old_slots[i].entry) continue;
+    iree_io_parameter_index_insert_slot_unsafe(index, old_slots[i].hash,
+                                               old_slots[i].entry);
+  }
+  iree_allocator_free(index->host_allocator, old_slots);
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
 static iree_status_t iree_io_parameter_index_reserve_unsafe(
     iree_io_parameter_index_t* index, iree_host_size_t new_capacity) {
   IREE_ASSERT_ARGUMENT(index);
-  if (new_capacity < index->entry_capacity) return iree_ok_status();
+  if (new_capacity <= index->entry_capacity) return iree_ok_status();
+  if (iree_io_parameter_index_is_frozen(index)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "parameter index is frozen and cannot grow");
+  }
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, new_capacity);
 
-  iree_io_parameter_index_entry_t** new_entries = index->entries;
-  iree_status_t status = iree_allocator_realloc(
-      index->host_allocator, new_capacity * sizeof(index->entries[0]),
-      (void**)&new_entries);
+  // Grow the key table first: a larger table is valid for the existing entries
+  // and the entry capacity must never exceed what the table can hold or
+  // lookups of missing keys will never find an empty slot to terminate on.
+  iree_status_t status =
+      iree_io_parameter_index_reserve_slots_unsafe(index, new_capacity);
+
   if (iree_status_is_ok(status)) {
-    index->entry_capacity = new_capacity;
-    index->entries = new_entries;
+    iree_io_parameter_index_entry_t** new_entries = index->entries;
+    status = iree_allocator_realloc(index->host_allocator,
+                                    new_capacity * sizeof(index->entries[0]),
+                                    (void**)&new_entries);
+    if (iree_status_is_ok(status)) {
+      index->entry_capacity = new_capacity;
+      index->entries = new_entries;
+    }
   }
 
   IREE_TRACE_ZONE_END(z0);
@@ -132,6 +248,16 @@ IREE_API_EXPORT iree_status_t iree_io_parameter_index_reserve(
   return status;
 }
 
+IREE_API_EXPORT void iree_io_parameter_index_freeze(
+    iree_io_parameter_index_t* index) {
+  IREE_ASSERT_ARGUMENT(index);
+  // Taking the lock ensures any in-flight additions complete before readers
+  // start scanning without it.
+  iree_slim_mutex_lock(&index->mutex);
+  iree_atomic_store(&index->frozen, 1, iree_memory_order_release);
+  iree_slim_mutex_unlock(&index->mutex);
+}
+
 IREE_API_EXPORT iree_status_t
 iree_io_parameter_index_add(iree_io_parameter_index_t* index,
                             const iree_io_parameter_index_entry_t* entry) {
@@ -141,9 +267,17 @@ iree_io_parameter_index_add(iree_io_parameter_index_t* index,
   IREE_TRACE_ZONE_APPEND_TEXT(z0, entry->key.data, entry->key.size);
   iree_slim_mutex_lock(&index->mutex);
 
-  // Grow the index if needed (double each time after some initial minimum).
+  // Reject additions once frozen as readers may be scanning without the lock.
   iree_status_t status = iree_ok_status();
-  if (index->entry_count == index->entry_capacity) {
+  if (iree_io_parameter_index_is_frozen(index)) {
+    status = iree_make_status(
+        IREE_STATUS_FAILED_PRECONDITION,
+        "parameter index is frozen and cannot have entries added");
+  }
+
+  // Grow the index if needed (double each time after some initial minimum).
+  if (iree_status_is_ok(status) &&
+      index->entry_count == index->entry_capacity) {
     status = iree_io_parameter_index_reserve_unsafe(
         index, iree_max(16, index->entry_capacity * 2));
   }
@@ -184,8 +318,11 @@ iree_io_parameter_index_add(iree_io_parameter_index_t* index,
     memcpy((void*)cloned_entry->metadata.data, entry->metadata.data,
            entry->metadata.data_length);
 
-    // Append the entry to the file index.
+    // Append the entry to the file index and make it available for lookup.
     index->entries[index->entry_count++] = cloned_entry;
+    iree_io_parameter_index_insert_slot_unsafe(
+        index, iree_io_parameter_index_hash_key(cloned_entry->key),
+        cloned_entry);
   }
 
   iree_slim_mutex_unlock(&index->mutex);
@@ -199,7 +336,8 @@ IREE_API_EXPORT iree_status_t iree_io_parameter_index_get(
   IREE_ASSERT_ARGUMENT(index);
   IREE_ASSERT_ARGUMENT(out_entry);
   *out_entry = NULL;
-  iree_slim_mutex_lock(&index->mutex);
+  const bool frozen = iree_io_parameter_index_is_frozen(index);
+  if (!frozen) iree_slim_mutex_lock(&index->mutex);
 
   iree_status_t status = iree_ok_status();
   if (i < index->entry_count) {
@@ -211,7 +349,7 @@ IREE_API_EXPORT iree_status_t iree_io_parameter_index_get(
                               i, index->entry_count);
   }
 
-  iree_slim_mutex_unlock(&index->mutex);
+  if (!frozen) iree_slim_mutex_unlock(&index->mutex);
   return status;
 }
 
@@ -223,14 +361,21 @@ IREE_API_EXPORT iree_status_t iree_io_parameter_index_lookup(
   *out_entry = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_APPEND_TEXT(z0, key.data, key.size);
-  iree_slim_mutex_lock(&index->mutex);
+  const bool frozen = iree_io_parameter_index_is_frozen(index);
+  if (!frozen) iree_slim_mutex_lock(&index->mutex);
 
   iree_status_t status = iree_ok_status();
-  for (iree_host_size_t i = 0; i < index->entry_count; ++i) {
-    const iree_io_parameter_index_entry_t* entry = index->entries[i];
-    if (iree_string_view_equal(key, entry->key)) {
-      *out_entry = entry;
-      break;
+  if (index->slot_capacity > 0) {
+    const uint64_t hash = iree_io_parameter_index_hash_key(key);
+    const iree_host_size_t mask = index->slot_capacity - 1;
+    for (iree_host_size_t i = (iree_host_size_t)hash & mask;;
+         i = (i + 1) & mask) {
+      const iree_io_parameter_index_slot_t* slot = &index->slots[i];
+      if (!slot->entry) break;
+      if (slot->hash == hash && iree_string_view_equal(key, slot->entry->key)) {
+        *out_entry = slot->entry;
+        break;
+      }
     }
   }
   if (*out_entry == NULL) {
@@ -239,7 +384,7 @@ IREE_API_EXPORT iree_status_t iree_io_parameter_index_lookup(
                               (int)key.size, key.data);
   }
 
-  iree_slim_mutex_unlock(&index->mutex);
+  if (!frozen) iree_slim_mutex_unlock(&index->mutex);
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -75,6 +75,11 @@ typedef struct iree_io_parameter_index_entry_t {
 // from the index we would need to change callers to hold a mutex or design
 // a callback-based API to ensure that entries were live for as long as the
 // callers were using them.
+//
+// Keys are indexed in a hash table as entries are added so lookups are O(1)
+// regardless of the number of entries. Once all entries have been added the
+// index can be frozen with iree_io_parameter_index_freeze to make all reads
+// lock-free.
 typedef struct iree_io_parameter_index_t iree_io_parameter_index_t;
 
 // Creates an empty file index.
@@ -100,7 +105,15 @@ iree_io_parameter_index_count(iree_io_parameter_index_t* index);
 IREE_API_EXPORT iree_status_t iree_io_parameter_index_reserve(
     iree_io_parameter_index_t* index, iree_host_size_t new_capacity);
 
+// Freezes the index such that no more entries may be added.
+// After freezing all queries (count/get/lookup) are lock-free. Subsequent
+// attempts to add entries or reserve capacity will fail. Freezing an already
+// frozen index is a no-op.
+IREE_API_EXPORT void iree_io_parameter_index_freeze(
+    iree_io_parameter_index_t* index);
+
 // Adds a new entry to the file index.
+// Fails with IREE_STATUS_FAILED_PRECONDITION if the index has been frozen.
 // The string key and optional metadata will be copied into the index and
 // need not remain valid after the call returns. Referenced file handles will
 // be retained for the lifetime of the index.
@@ -115,6 +128,7 @@ IREE_API_EXPORT iree_status_t iree_io_parameter_index_get(
     const iree_io_parameter_index_entry_t** out_entry);
 
 // Performs a file entry lookup of |key| in the index and returns it.
+// If multiple entries share the same key the first one added is returned.
 // The returned |out_entry| is valid for the lifetime of the index.
 IREE_API_EXPORT iree_status_t iree_io_parameter_index_lookup(
     iree_io_parameter_index_t* index, iree_string_view_t key,
@@ -0,0 +1,202 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/prng.h"
+#include "iree/io/parameter_index.h"
+#include "iree/testing/benchmark.h"
+
+// Maximum length of the synthetic keys we generate.
+#define IREE_IO_PARAMETER_INDEX_BENCHMARK_MAX_KEY_LENGTH 64
+
+// Formats a key for parameter |i| that looks like those in LLM checkpoints.
+static iree_string_view_t iree_io_parameter_index_benchmark_key(
+    uint32_t i, char* buffer) {
+  int length = snprintf(buffer, IREE_IO_PARAMETER_INDEX_BENCHMARK_MAX_KEY_LENGTH,
+                        "model.layers.%u.self_attn.q_proj.weight", i);
+  return iree_make_string_view(buffer, (iree_host_size_t)length);
+}
+
+// Creates an index with |count| splat entries with unique keys.
+static iree_io_parameter_index_t* iree_io_parameter_index_benchmark_create(
+    uint32_t count, iree_allocator_t host_allocator) {
+  iree_io_parameter_index_t* index = NULL;
+  IREE_CHECK_OK(iree_io_parameter_index_create(host_allocator, &index));
+  IREE_CHECK_OK(iree_io_parameter_index_reserve(index, count));
+  char key_buffer[IREE_IO_PARAMETER_INDEX_BENCHMARK_MAX_KEY_LENGTH];
+  for (uint32_t i = 0; i < count; ++i) {
+    iree_io_parameter_index_entry_t entry = {
+        .key = iree_io_parameter_index_benchmark_key(i, key_buffer),
+        .metadata = iree_const_byte_span_empty(),
+        .length = 1024,
+        .type = IREE_IO_PARAMETER_INDEX_ENTRY_STORAGE_TYPE_SPLAT,
+        .storage =
+            {
+                .splat =
+                    {
+                        .pattern_length = 1,
+                        .pattern = {0},
+                    },
+            },
+    };
+    IREE_CHECK_OK(iree_io_parameter_index_add(index, &entry));
+  }
+  return index;
+}
+
+// Tests the cost of building an index with N entries.
+//
+// user_data is a count of entries to add to the index.
+static iree_status_t iree_io_parameter_index_benchmark_build_n(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+  uint32_t count = (uint32_t)(uintptr_t)benchmark_def->user_data;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/count)) {
+    iree_io_parameter_index_t* index =
+        iree_io_parameter_index_benchmark_create(count, host_allocator);
+    iree_io_parameter_index_release(index);
+  }
+  return iree_ok_status();
+}
+
+// Tests random lookups into an index with N entries. Lookups are performed
+// against the index both before and after freezing based on |frozen|.
+static iree_status_t iree_io_parameter_index_benchmark_lookup(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state, bool frozen) {
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+  uint32_t count = (uint32_t)(uintptr_t)benchmark_def->user_data;
+
+  iree_io_parameter_index_t* index =
+      iree_io_parameter_index_benchmark_create(count, host_allocator);
+  if (frozen) iree_io_parameter_index_freeze(index);
+
+  // Pregenerate the keys so that we only measure the lookup.
+  char* key_storage = NULL;
+  iree_string_view_t* keys = NULL;
+  IREE_CHECK_OK(iree_allocator_malloc(
+      host_allocator, count * IREE_IO_PARAMETER_INDEX_BENCHMARK_MAX_KEY_LENGTH,
+      (void**)&key_storage));
+  IREE_CHECK_OK(iree_allocator_malloc(host_allocator, count * sizeof(keys[0]),
+                                      (void**)&keys));
+  for (uint32_t i = 0; i < count; ++i) {
+    keys[i] = iree_io_parameter_index_benchmark_key(
+        i, key_storage + i * IREE_IO_PARAMETER_INDEX_BENCHMARK_MAX_KEY_LENGTH);
+  }
+
+  // The PRNG we use to select the keys.
+  iree_prng_xoroshiro128_state_t prng = {0};
+  iree_prng_xoroshiro128_initialize(123ull, &prng);
+
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/256)) {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t key_idx = iree_prng_xoroshiro128plus_next_uint32(&prng) % count;
+      const iree_io_parameter_index_entry_t* entry = NULL;
+      IREE_CHECK_OK(
+          iree_io_parameter_index_lookup(index, keys[key_idx], &entry));
+      iree_optimization_barrier(entry);
+    }
+  }
+
+  iree_allocator_free(host_allocator, keys);
+  iree_allocator_free(host_allocator, key_storage);
+  iree_io_parameter_index_release(index);
+  return iree_ok_status();
+}
+
+// user_data is a count of entries in the index.
+static iree_status_t iree_io_parameter_index_benchmark_lookup_n(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  return iree_io_parameter_index_benchmark_lookup(benchmark_def,
+                                                  benchmark_state,
+                                                  /*frozen=*/false);
+}
+
+// user_data is a count of entries in the index.
+static iree_status_t iree_io_parameter_index_benchmark_lookup_frozen_n(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  return iree_io_parameter_index_benchmark_lookup(benchmark_def,
+                                                  benchmark_state,
+                                                  /*frozen=*/true);
+}
+
+int main(int argc, char** argv) {
+  iree_benchmark_initialize(&argc, argv);
+
+  // iree_io_parameter_index_benchmark_build_n
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_io_parameter_index_benchmark_build_n,
+    };
+    benchmark_def.user_data = (void*)1000u;
+    iree_benchmark_register(iree_make_cstring_view("build_1k"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)10000u;
+    iree_benchmark_register(iree_make_cstring_view("build_10k"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)100000u;
+    iree_benchmark_register(iree_make_cstring_view("build_100k"),
+                            &benchmark_def);
+  }
+
+  // iree_io_parameter_index_benchmark_lookup_n
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_io_parameter_index_benchmark_lookup_n,
+    };
+    benchmark_def.user_data = (void*)1000u;
+    iree_benchmark_register(iree_make_cstring_view("lookup_1k"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)10000u;
+    iree_benchmark_register(iree_make_cstring_view("lookup_10k"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)100000u;
+    iree_benchmark_register(iree_make_cstring_view("lookup_100k"),
+                            &benchmark_def);
+  }
+
+  // iree_io_parameter_index_benchmark_lookup_frozen_n
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_io_parameter_index_benchmark_lookup_frozen_n,
+    };
+    benchmark_def.user_data = (void*)1000u;
+    iree_benchmark_register(iree_make_cstring_view("lookup_frozen_1k"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)10000u;
+    iree_benchmark_register(iree_make_cstring_view("lookup_frozen_10k"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)100000u;
+    iree_benchmark_register(iree_make_cstring_view("lookup_frozen_100k"),
+                            &benchmark_def);
+  }
+
+  iree_benchmark_run_specified();
+  return 0;
+}
@@ -0,0 +1,183 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/io/parameter_index.h"
+
+#include <memory>
+#include <string>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+using iree::Status;
+using iree::StatusCode;
+using iree::testing::status::StatusIs;
+
+using IndexPtr = std::unique_ptr<iree_io_parameter_index_t,
+                                 void (*)(iree_io_parameter_index_t*)>;
+
+static IndexPtr CreateIndex() {
+  iree_io_parameter_index_t* index = NULL;
+  IREE_CHECK_OK(
+      iree_io_parameter_index_create(iree_allocator_system(), &index));
+  return IndexPtr(index, iree_io_parameter_index_release);
+}
+
+// Allocator that fails new allocations (but not reallocations) while
+// |fail_mallocs| is set and otherwise forwards to the system allocator.
+struct FailingAllocator {
+  bool fail_mallocs = false;
+
+  static iree_status_t Ctl(void* self, iree_allocator_command_t command,
+                           const void* params, void** inout_ptr) {
+    auto* allocator = reinterpret_cast<FailingAllocator*>(self);
+    if (command == IREE_ALLOCATOR_COMMAND_MALLOC ||
+        command == IREE_ALLOCATOR_COMMAND_CALLOC) {
+      if (allocator->fail_mallocs) {
+        return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                                "injected allocation failure");
+      }
+    }
+    iree_allocator_t system_allocator = iree_allocator_system();
+    return system_allocator.ctl(system_allocator.self, command, params,
+                                inout_ptr);
+  }
+
+  iree_allocator_t allocator() { return {this, Ctl}; }
+};
+
+static iree_status_t AddSplatEntry(iree_io_parameter_index_t* index,
+                                   const std::string& key, uint64_t length,
+                                   uint8_t pattern) {
+  iree_io_parameter_index_entry_t entry = {};
+  entry.key = iree_make_string_view(key.data(), key.size());
+  entry.metadata = iree_const_byte_span_empty();
+  entry.length = length;
+  entry.type = IREE_IO_PARAMETER_INDEX_ENTRY_STORAGE_TYPE_SPLAT;
+  entry.storage.splat.pattern_length = 1;
+  entry.storage.splat.pattern[0] = pattern;
+  return iree_io_parameter_index_add(index, &entry);
+}
+
+TEST(ParameterIndexTest, Empty) {
+  auto index = CreateIndex();
+  EXPECT_EQ(iree_io_parameter_index_count(index.get()), 0u);
+  const iree_io_parameter_index_entry_t* entry = NULL;
+  EXPECT_THAT(Status(iree_io_parameter_index_lookup(index.get(),
+                                                    IREE_SV("key"), &entry)),
+              StatusIs(StatusCode::kNotFound));
+  EXPECT_EQ(entry, nullptr);
+}
+
+TEST(ParameterIndexTest, LookupMany) {
+  auto index = CreateIndex();
+  static const iree_host_size_t kCount = 10000;
+  for (iree_host_size_t i = 0; i < kCount; ++i) {
+    IREE_ASSERT_OK(AddSplatEntry(index.get(), "key" + std::to_string(i),
+                                 /*length=*/i, /*pattern=*/(uint8_t)i));
+  }
+  EXPECT_EQ(iree_io_parameter_index_count(index.get()), kCount);
+  for (iree_host_size_t i = 0; i < kCount; ++i) {
+    std::string key = "key" + std::to_string(i);
+    const iree_io_parameter_index_entry_t* entry = NULL;
+    IREE_ASSERT_OK(iree_io_parameter_index_lookup(
+        index.get(), iree_make_string_view(key.data(), key.size()), &entry));
+    ASSERT_NE(entry, nullptr);
+    EXPECT_TRUE(iree_string_view_equal(
+        entry->key, iree_make_string_view(key.data(), key.size())));
+    EXPECT_EQ(entry->length, (uint64_t)i);
+  }
+  const iree_io_parameter_index_entry_t* entry = NULL;
+  EXPECT_THAT(Status(iree_io_parameter_index_lookup(
+                  index.get(), IREE_SV("missing"), &entry)),
+              StatusIs(StatusCode::kNotFound));
+}
+
+TEST(ParameterIndexTest, DuplicateKeysReturnFirst) {
+  auto index = CreateIndex();
+  IREE_ASSERT_OK(AddSplatEntry(index.get(), "key", /*length=*/1,
+                               /*pattern=*/0xAA));
+  IREE_ASSERT_OK(AddSplatEntry(index.get(), "key", /*length=*/2,
+                               /*pattern=*/0xBB));
+  EXPECT_EQ(iree_io_parameter_index_count(index.get()), 2u);
+  const iree_io_parameter_index_entry_t* entry = NULL;
+  IREE_ASSERT_OK(
+      iree_io_parameter_index_lookup(index.get(), IREE_SV("key"), &entry));
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->length, 1u);
+  EXPECT_EQ(entry->storage.splat.pattern[0], 0xAA);
+}
+
+TEST(ParameterIndexTest, Frozen) {
+  auto index = CreateIndex();
+  IREE_ASSERT_OK(AddSplatEntry(index.get(), "key0", /*length=*/1,
+                               /*pattern=*/0xAA));
+  iree_io_parameter_index_freeze(index.get());
+
+  // Reads still work.
+  EXPECT_EQ(iree_io_parameter_index_count(index.get()), 1u);
+  const iree_io_parameter_index_entry_t* entry = NULL;
+  IREE_ASSERT_OK(
+      iree_io_parameter_index_lookup(index.get(), IREE_SV("key0"), &entry));
+  ASSERT_NE(entry, nullptr);
+  IREE_ASSERT_OK(iree_io_parameter_index_get(index.get(), 0, &entry));
+  ASSERT_NE(entry, nullptr);
+
+  // Writes fail.
+  EXPECT_THAT(Status(AddSplatEntry(index.get(), "key1", /*length=*/1,
+                                   /*pattern=*/0xBB)),
+              StatusIs(StatusCode::kFailedPrecondition));
+  EXPECT_THAT(Status(iree_io_parameter_index_reserve(index.get(), 1024)),
+              StatusIs(StatusCode::kFailedPrecondition));
+  EXPECT_EQ(iree_io_parameter_index_count(index.get()), 1u);
+}
+
+// Tests that a failed reserve leaves the index in a state where later growth
+// keeps the key table from filling up.
+TEST(ParameterIndexTest, FailedReserveLookupMissing) {
+  FailingAllocator failing_allocator;
+  iree_io_parameter_index_t* index_ptr = NULL;
+  IREE_ASSERT_OK(iree_io_parameter_index_create(failing_allocator.allocator(),
+                                                &index_ptr));
+  IndexPtr index(index_ptr, iree_io_parameter_index_release);
+
+  // Fill the initial capacity.
+  static const iree_host_size_t kInitialCount = 16;
+  for (iree_host_size_t i = 0; i < kInitialCount; ++i) {
+    IREE_ASSERT_OK(AddSplatEntry(index.get(), "key" + std::to_string(i),
+                                 /*length=*/i, /*pattern=*/(uint8_t)i));
+  }
+
+  // Growing the key table fails (while the entry list could be reallocated).
+  failing_allocator.fail_mallocs = true;
+  EXPECT_THAT(Status(iree_io_parameter_index_reserve(index.get(), 64)),
+              StatusIs(StatusCode::kResourceExhausted));
+  EXPECT_THAT(Status(AddSplatEntry(index.get(), "key_failed", /*length=*/1,
+                                   /*pattern=*/0)),
+              StatusIs(StatusCode::kResourceExhausted));
+  failing_allocator.fail_mallocs = false;
+
+  // Keep adding entries; the key table must grow along with the entries.
+  static const iree_host_size_t kTotalCount = 64;
+  for (iree_host_size_t i = kInitialCount; i < kTotalCount; ++i) {
+    IREE_ASSERT_OK(AddSplatEntry(index.get(), "key" + std::to_string(i),
+                                 /*length=*/i, /*pattern=*/(uint8_t)i));
+  }
+  EXPECT_EQ(iree_io_parameter_index_count(index.get()), kTotalCount);
+
+  const iree_io_parameter_index_entry_t* entry = NULL;
+  EXPECT_THAT(Status(iree_io_parameter_index_lookup(
+                  index.get(), IREE_SV("missing"), &entry)),
+              StatusIs(StatusCode::kNotFound));
+  IREE_ASSERT_OK(iree_io_parameter_index_lookup(
+      index.get(), IREE_SV("key63"), &entry));
+  EXPECT_EQ(entry->length, 63u);
+}
+
+}  // namespace
@@ -10,6 +10,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "iree/base/internal/atomics.h"
 #include "iree/modules/hal/utils/buffer_diagnostics.h"
 
 //===----------------------------------------------------------------------===//
@@ -53,6 +54,104 @@ static void IREE_API_PTR iree_hal_module_destroy(void* base_module) {
   }
 }
 
+// Executable caches shared by a module state and all states forked from it.
+// Executables are immutable once prepared and caches are safe to use from
+// multiple threads so forked contexts share the caches and everything loaded
+// through them by reference.
+typedef struct iree_hal_module_executable_caches_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+
+  // Shared executable cache for each device used to cache all executables
+  // created in the context. We could have multiple to allow for modules to
+  // create distinct sets of executables like ones for training vs inference in
+  // the same model or allow these to be injected so that multiple loaded
+  // contexts share the caches.
+  iree_host_size_t count;
+  iree_hal_executable_cache_t* caches[];
+} iree_hal_module_executable_caches_t;
+
+static void iree_hal_module_executable_caches_release(
+    iree_hal_module_executable_caches_t* executable_caches);
+
+// TODO(benvanik): add iree_loop_t to module constructor.
+// Runs executable cache work inline on the calling thread. We should instead be
+// taking a loop upon creation and scheduling work against that. Unlike
+// iree_loop_inline the status is scoped to each operation and returned to its
+// caller so that states sharing the caches across threads never share (or
+// observe each other's) sticky failures.
+static iree_status_t iree_hal_module_executable_cache_loop_ctl(
+    void* self, iree_loop_command_t command, const void* params,
+    void** inout_ptr) {
+  iree_status_t loop_status = iree_ok_status();
+  iree_status_t status =
+      iree_loop_inline_ctl(&loop_status, command, params, inout_ptr);
+  if (!iree_status_is_ok(status)) {
+    iree_status_ignore(loop_status);
+    return status;
+  }
+  return loop_status;
+}
+
+static iree_status_t iree_hal_module_executable_caches_create(
+    iree_host_size_t device_count, iree_hal_device_t** devices,
+    iree_allocator_t host_allocator,
+    iree_hal_module_executable_caches_t** out_executable_caches) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  *out_executable_caches = NULL;
+
+  iree_hal_module_executable_caches_t* executable_caches = NULL;
+  iree_host_size_t total_size =
+      sizeof(*executable_caches) +
+      device_count * sizeof(executable_caches->caches[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size,
+                                (void**)&executable_caches));
+  memset(executable_caches, 0, total_size);
+  iree_atomic_ref_count_init(&executable_caches->ref_count);
+  executable_caches->host_allocator = host_allocator;
+  executable_caches->count = device_count;
+
+  const iree_loop_t loop = {
+      .self = NULL,
+      .ctl = iree_hal_module_executable_cache_loop_ctl,
+  };
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < device_count; ++i) {
+    status = iree_hal_executable_cache_create(
+        devices[i], iree_string_view_empty(), loop,
+        &executable_caches->caches[i]);
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_executable_caches = executable_caches;
+  } else {
+    iree_hal_module_executable_caches_release(executable_caches);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_module_executable_caches_retain(
+    iree_hal_module_executable_caches_t* executable_caches) {
+  iree_atomic_ref_count_inc(&executable_caches->ref_count);
+}
+
+static void iree_hal_module_executable_caches_release(
+    iree_hal_module_executable_caches_t* executable_caches) {
+  if (!executable_caches ||
+      iree_atomic_ref_count_dec(&executable_caches->ref_count) != 1) {
+    return;
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  for (iree_host_size_t i = 0; i < executable_caches->count; ++i) {
+    iree_hal_executable_cache_release(executable_caches->caches[i]);
+  }
+  iree_allocator_free(executable_caches->host_allocator, executable_caches);
+  IREE_TRACE_ZONE_END(z0);
+}
+
 typedef struct iree_hal_module_state_t {
   iree_allocator_t host_allocator;
 
@@ -70,54 +169,50 @@ typedef struct iree_hal_module_state_t {
   // state allocated from it and we can rely on it to keep the devices retained.
   iree_hal_device_t** devices;
 
-  // TODO(benvanik): add iree_loop_t to module constructor.
-  // Status of the nested loop we run for executable creation today. We should
-  // instead be taking a loop upon creation and scheduling work against that.
-  iree_status_t loop_status;
-
-  // Shared executable cache for each device used to cache all executables
-  // created in the context. We could have multiple to allow for modules to
-  // create distinct sets of executables like ones for training vs inference in
-  // the same model or allow these to be injected so that multiple loaded
-  // contexts share the caches.
-  iree_hal_executable_cache_t* executable_caches[];
+  // Executable caches for each device. Retained and shared with any states
+  // forked from this one.
+  iree_hal_module_executable_caches_t* executable_caches;
 } iree_hal_module_state_t;
 
-static iree_status_t IREE_API_PTR
-iree_hal_module_alloc_state(void* self, iree_allocator_t host_allocator,
-                            iree_vm_module_state_t** out_module_state) {
-  IREE_TRACE_ZONE_BEGIN(z0);
-
-  iree_hal_module_t* module = IREE_HAL_MODULE_CAST(self);
+// Allocates a module state using |executable_caches| (retained).
+// All other state is derived from the shared |module|.
+static iree_status_t iree_hal_module_state_create(
+    iree_hal_module_t* module,
+    iree_hal_module_executable_caches_t* executable_caches,
+    iree_allocator_t host_allocator, iree_hal_module_state_t** out_state) {
   iree_hal_module_state_t* state = NULL;
-  iree_host_size_t total_size =
-      sizeof(*state) +
-      module->device_count * sizeof(state->executable_caches[0]);
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&state));
-  memset(state, 0, total_size);
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(host_allocator, sizeof(*state), (void**)&state));
+  memset(state, 0, sizeof(*state));
   state->host_allocator = host_allocator;
   state->flags = module->flags;
   state->debug_sink = module->debug_sink;
   state->device_count = module->device_count;
   state->devices = module->devices;
-  state->loop_status = iree_ok_status();
+  state->executable_caches = executable_caches;
+  iree_hal_module_executable_caches_retain(executable_caches);
+  *out_state = state;
+  return iree_ok_status();
+}
 
-  iree_status_t status = iree_ok_status();
-  for (iree_host_size_t i = 0; i < state->device_count; ++i) {
-    status = iree_hal_executable_cache_create(
-        state->devices[i], iree_string_view_empty(),
-        iree_loop_inline(&state->loop_status), &state->executable_caches[i]);
-    if (!iree_status_is_ok(status)) break;
-  }
+static iree_status_t IREE_API_PTR
+iree_hal_module_alloc_state(void* self, iree_allocator_t host_allocator,
+                            iree_vm_module_state_t** out_module_state) {
+  IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_module_t* module = IREE_HAL_MODULE_CAST(self);
+  iree_hal_module_executable_caches_t* executable_caches = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_module_executable_caches_create(
+              module->device_count, module->devices, host_allocator,
+              &executable_caches));
+
+  iree_hal_module_state_t* state = NULL;
+  iree_status_t status = iree_hal_module_state_create(module, executable_caches,
+                                                      host_allocator, &state);
+  iree_hal_module_executable_caches_release(executable_caches);
   if (iree_status_is_ok(status)) {
     *out_module_state = (iree_vm_module_state_t*)state;
-  } else {
-    for (iree_host_size_t i = 0; i < state->device_count; ++i) {
-      iree_hal_executable_cache_release(state->executable_caches[i]);
-    }
-    iree_allocator_free(host_allocator, state);
   }
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -128,15 +223,17 @@ iree_hal_module_free_state(void* self, iree_vm_module_state_t* module_state) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
-  for (iree_host_size_t i = 0; i < state->device_count; ++i) {
-    iree_hal_executable_cache_release(state->executable_caches[i]);
-  }
-  iree_status_ignore(state->loop_status);
+  iree_hal_module_executable_caches_release(state->executable_caches);
   iree_allocator_free(state->host_allocator, state);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Forks a state by sharing everything immutable with the parent: devices are
+// owned by the module and executable caches (and the executables they have
+// loaded) are retained. Resources the program stores in globals such as
+// executables and constant buffers are shared by the forking of the bytecode
+// module state. The parent may be freed before the child.
 static iree_status_t IREE_API_PTR iree_hal_module_fork_state(
     void* self, iree_vm_module_state_t* base_parent_state,
     iree_allocator_t host_allocator, iree_vm_module_state_t** out_child_state) {
@@ -145,34 +242,15 @@ static iree_status_t IREE_API_PTR iree_hal_module_fork_state(
 
   iree_hal_module_state_t* parent_state =
       (iree_hal_module_state_t*)base_parent_state;
-
-  // The base module state is derived entirely from the shared module.
   iree_hal_module_t* module = IREE_HAL_MODULE_CAST(self);
   iree_hal_module_state_t* child_state = NULL;
-  iree_host_size_t total_size =
-      sizeof(*child_state) +
-      module->device_count * sizeof(child_state->executable_caches[0]);
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0,
-      iree_allocator_malloc(host_allocator, total_size, (void**)&child_state));
-  memset(child_state, 0, total_size);
-  child_state->host_allocator = host_allocator;
-  child_state->flags = module->flags;
-  child_state->device_count = module->device_count;
-  child_state->devices = module->devices;
-  child_state->loop_status = iree_ok_status();
-
-  // Reference the parent executable caches.
-  for (iree_host_size_t i = 0; i < child_state->device_count; ++i) {
-    iree_hal_executable_cache_t* executable_cache =
-        parent_state->executable_caches[i];
-    child_state->executable_caches[i] = executable_cache;
-    iree_hal_executable_cache_retain(executable_cache);
+  iree_status_t status = iree_hal_module_state_create(
+      module, parent_state->executable_caches, host_allocator, &child_state);
+  if (iree_status_is_ok(status)) {
+    *out_child_state = (iree_vm_module_state_t*)child_state;
   }
-
-  *out_child_state = (iree_vm_module_state_t*)child_state;
   IREE_TRACE_ZONE_END(z0);
-  return iree_ok_status();
+  return status;
 }
 
 // Returns an unretained reference to the executable cache for the given device.
@@ -186,7 +264,7 @@ static iree_status_t iree_hal_module_state_lookup_executable_cache(
   *out_executable_cache = NULL;
   for (iree_host_size_t i = 0; i < state->device_count; ++i) {
     if (state->devices[i] == device) {
-      *out_executable_cache = state->executable_caches[i];
+      *out_executable_cache = state->executable_caches->caches[i];
       return iree_ok_status();
     }
   }
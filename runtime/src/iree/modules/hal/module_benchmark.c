@@ -0,0 +1,202 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Compares creating a new context for each request against forking one from
+// an initialized parent context. Creation runs the program initializer that
+// loads executables and uploads constants while forking shares them.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/drivers/local_sync/sync_device.h"
+#include "iree/hal/local/loaders/vmvx_module_loader.h"
+#include "iree/modules/hal/module.h"
+#include "iree/modules/hal/module_benchmark_module_c.h"
+#include "iree/testing/benchmark.h"
+#include "iree/vm/api.h"
+#include "iree/vm/bytecode/module.h"
+
+typedef struct iree_hal_module_benchmark_t {
+  iree_vm_instance_t* instance;
+  iree_hal_device_t* device;
+  // HAL module and program module in dependency order.
+  iree_vm_module_t* modules[2];
+  // Context initialized once that requests are forked from.
+  iree_vm_context_t* parent_context;
+  // Input passed to each request.
+  iree_hal_buffer_view_t* input;
+} iree_hal_module_benchmark_t;
+
+static iree_hal_module_benchmark_t iree_hal_module_benchmark;
+
+static iree_status_t iree_hal_module_benchmark_initialize(
+    iree_allocator_t host_allocator, iree_hal_module_benchmark_t* benchmark) {
+  IREE_RETURN_IF_ERROR(iree_vm_instance_create(
+      IREE_VM_TYPE_CAPACITY_DEFAULT, host_allocator, &benchmark->instance));
+  IREE_RETURN_IF_ERROR(iree_hal_module_register_all_types(benchmark->instance));
+
+  iree_hal_executable_loader_t* loader = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_vmvx_module_loader_create(
+      benchmark->instance, /*user_module_count=*/0, /*user_modules=*/NULL,
+      host_allocator, &loader));
+  iree_hal_allocator_t* device_allocator = NULL;
+  iree_status_t status = iree_hal_allocator_create_heap(
+      IREE_SV("local"), host_allocator, host_allocator, &device_allocator);
+  if (iree_status_is_ok(status)) {
+    iree_hal_sync_device_params_t params;
+    iree_hal_sync_device_params_initialize(&params);
+    status = iree_hal_sync_device_create(
+        IREE_SV("local-sync"), &params, /*loader_count=*/1, &loader,
+        device_allocator, host_allocator, &benchmark->device);
+  }
+  iree_hal_allocator_release(device_allocator);
+  iree_hal_executable_loader_release(loader);
+  IREE_RETURN_IF_ERROR(status);
+
+  IREE_RETURN_IF_ERROR(iree_hal_module_create(
+      benchmark->instance, /*device_count=*/1, &benchmark->device,
+      IREE_HAL_MODULE_FLAG_NONE, iree_hal_module_debug_sink_null(),
+      host_allocator, &benchmark->modules[0]));
+  const iree_file_toc_t* module_file =
+      iree_hal_module_benchmark_module_create();
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_module_create(
+      benchmark->instance,
+      iree_make_const_byte_span(module_file->data, module_file->size),
+      iree_allocator_null(), host_allocator, &benchmark->modules[1]));
+
+  IREE_RETURN_IF_ERROR(iree_vm_context_create_with_modules(
+      benchmark->instance, IREE_VM_CONTEXT_FLAG_NONE,
+      IREE_ARRAYSIZE(benchmark->modules), benchmark->modules, host_allocator,
+      &benchmark->parent_context));
+
+  const float input_data[4 * 4] = {1.0f};
+  const iree_hal_dim_t shape[2] = {4, 4};
+  iree_hal_buffer_params_t buffer_params = {
+      .type = IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+      .usage = IREE_HAL_BUFFER_USAGE_DEFAULT,
+  };
+  return iree_hal_buffer_view_allocate_buffer_copy(
+      benchmark->device, iree_hal_device_allocator(benchmark->device),
+      IREE_ARRAYSIZE(shape), shape, IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, buffer_params,
+      iree_make_const_byte_span(input_data, sizeof(input_data)),
+      &benchmark->input);
+}
+
+static void iree_hal_module_benchmark_deinitialize(
+    iree_hal_module_benchmark_t* benchmark) {
+  iree_hal_buffer_view_release(benchmark->input);
+  iree_vm_context_release(benchmark->parent_context);
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(benchmark->modules); ++i) {
+    iree_vm_module_release(benchmark->modules[i]);
+  }
+  iree_hal_device_release(benchmark->device);
+  iree_vm_instance_release(benchmark->instance);
+}
+
+// Runs the program once in |context| as a request would.
+static iree_status_t iree_hal_module_benchmark_invoke(
+    iree_hal_module_benchmark_t* benchmark, iree_vm_context_t* context,
+    iree_allocator_t host_allocator) {
+  iree_vm_function_t function;
+  IREE_RETURN_IF_ERROR(iree_vm_context_resolve_function(
+      context, IREE_SV("module.predict"), &function));
+  iree_vm_list_t* inputs = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_list_create(iree_vm_make_undefined_type_def(),
+                                           1, host_allocator, &inputs));
+  iree_vm_list_t* outputs = NULL;
+  iree_status_t status = iree_vm_list_create(iree_vm_make_undefined_type_def(),
+                                             1, host_allocator, &outputs);
+  if (iree_status_is_ok(status)) {
+    iree_vm_ref_t input_ref = iree_hal_buffer_view_retain_ref(benchmark->input);
+    status = iree_vm_list_push_ref_move(inputs, &input_ref);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_invoke(context, function, IREE_VM_INVOCATION_FLAG_NONE,
+                            /*policy=*/NULL, inputs, outputs, host_allocator);
+  }
+  iree_vm_list_release(outputs);
+  iree_vm_list_release(inputs);
+  return status;
+}
+
+// Creates and initializes a new context per request.
+// user_data is true if the program should be invoked in each context.
+static iree_status_t iree_hal_module_benchmark_create(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_hal_module_benchmark_t* benchmark = &iree_hal_module_benchmark;
+  const bool invoke = (bool)(uintptr_t)benchmark_def->user_data;
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_vm_context_t* context = NULL;
+    IREE_RETURN_IF_ERROR(iree_vm_context_create_with_modules(
+        benchmark->instance, IREE_VM_CONTEXT_FLAG_NONE,
+        IREE_ARRAYSIZE(benchmark->modules), benchmark->modules, host_allocator,
+        &context));
+    iree_status_t status = iree_ok_status();
+    if (invoke) {
+      status = iree_hal_module_benchmark_invoke(benchmark, context,
+                                                host_allocator);
+    }
+    iree_vm_context_release(context);
+    IREE_RETURN_IF_ERROR(status);
+  }
+  return iree_ok_status();
+}
+
+// Forks a new context from the initialized parent context per request.
+// user_data is true if the program should be invoked in each context.
+static iree_status_t iree_hal_module_benchmark_fork(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_hal_module_benchmark_t* benchmark = &iree_hal_module_benchmark;
+  const bool invoke = (bool)(uintptr_t)benchmark_def->user_data;
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_vm_context_t* context = NULL;
+    IREE_RETURN_IF_ERROR(iree_vm_context_fork(benchmark->parent_context,
+                                              host_allocator, &context));
+    iree_status_t status = iree_ok_status();
+    if (invoke) {
+      status = iree_hal_module_benchmark_invoke(benchmark, context,
+                                                host_allocator);
+    }
+    iree_vm_context_release(context);
+    IREE_RETURN_IF_ERROR(status);
+  }
+  return iree_ok_status();
+}
+
+int main(int argc, char** argv) {
+  iree_benchmark_initialize(&argc, argv);
+  IREE_CHECK_OK(iree_hal_module_benchmark_initialize(
+      iree_allocator_system(), &iree_hal_module_benchmark));
+
+  iree_benchmark_def_t benchmark_def = {
+      .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+               IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+  };
+  benchmark_def.run = iree_hal_module_benchmark_create;
+  benchmark_def.user_data = (void*)(uintptr_t)false;
+  iree_benchmark_register(IREE_SV("context_create"), &benchmark_def);
+  benchmark_def.user_data = (void*)(uintptr_t)true;
+  iree_benchmark_register(IREE_SV("context_create_invoke"), &benchmark_def);
+  benchmark_def.run = iree_hal_module_benchmark_fork;
+  benchmark_def.user_data = (void*)(uintptr_t)false;
+  iree_benchmark_register(IREE_SV("context_fork"), &benchmark_def);
+  benchmark_def.user_data = (void*)(uintptr_t)true;
+  iree_benchmark_register(IREE_SV("context_fork_invoke"), &benchmark_def);
+
+  iree_benchmark_run_specified();
+  iree_hal_module_benchmark_deinitialize(&iree_hal_module_benchmark);
+  return 0;
+}
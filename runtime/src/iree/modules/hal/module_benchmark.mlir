@@ -0,0 +1,14 @@
+// Program with executables and a constant buffer that are created when a
+// context is initialized and shared by reference when the context is forked.
+
+util.global private @weights = dense<[
+  [0.0, 1.0, 2.0, 3.0], [4.0, 5.0, 6.0, 7.0],
+  [8.0, 9.0, 10.0, 11.0], [12.0, 13.0, 14.0, 15.0]
+]> : tensor<4x4xf32>
+
+func.func @predict(%input: tensor<4x4xf32>) -> tensor<4x4xf32> {
+  %weights = util.global.load @weights : tensor<4x4xf32>
+  %0 = arith.mulf %input, %weights : tensor<4x4xf32>
+  %1 = arith.addf %0, %input : tensor<4x4xf32>
+  return %1 : tensor<4x4xf32>
+}
@@ -0,0 +1,225 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/modules/hal/module.h"
+
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/drivers/local_sync/sync_device.h"
+#include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/loaders/embedded_elf_loader.h"
+#include "iree/modules/hal/types.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+#include "iree/vm/ref_cc.h"
+
+// ELF modules for various platforms embedded in the binary:
+#include "iree/hal/local/elf/testdata/elementwise_mul.h"
+
+namespace iree {
+namespace {
+
+// Returns the ELF testdata for the current architecture or an empty span if
+// none is available.
+static iree_const_byte_span_t QueryArchTestFileData() {
+  iree_string_view_t pattern = iree_string_view_empty();
+#if defined(IREE_ARCH_ARM_32)
+  pattern = IREE_SV("*_arm_32.so");
+#elif defined(IREE_ARCH_ARM_64)
+  pattern = IREE_SV("*_arm_64.so");
+#elif defined(IREE_ARCH_RISCV_32)
+  pattern = IREE_SV("*_riscv_32.so");
+#elif defined(IREE_ARCH_RISCV_64)
+  pattern = IREE_SV("*_riscv_64.so");
+#elif defined(IREE_ARCH_X86_32)
+  pattern = IREE_SV("*_x86_32.so");
+#elif defined(IREE_ARCH_X86_64)
+  pattern = IREE_SV("*_x86_64.so");
+#endif  // IREE_ARCH_*
+  if (iree_string_view_is_empty(pattern)) {
+    return iree_make_const_byte_span(NULL, 0);
+  }
+  for (size_t i = 0; i < elementwise_mul_size(); ++i) {
+    const struct iree_file_toc_t* file_toc = &elementwise_mul_create()[i];
+    if (iree_string_view_match_pattern(iree_make_cstring_view(file_toc->name),
+                                       pattern)) {
+      return iree_make_const_byte_span(file_toc->data, file_toc->size);
+    }
+  }
+  return iree_make_const_byte_span(NULL, 0);
+}
+
+// Invalid ELF data that is still claimed by the embedded ELF loader.
+static const uint8_t kInvalidExecutableData[64] = {0x7F, 'E', 'L', 'F'};
+
+class HALModuleTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    executable_data_ = QueryArchTestFileData();
+    if (!executable_data_.data_length) {
+      GTEST_SKIP() << "no ELF testdata for the current architecture";
+    }
+    IREE_ASSERT_OK(iree_vm_instance_create(
+        IREE_VM_TYPE_CAPACITY_DEFAULT, iree_allocator_system(), &instance_));
+    IREE_ASSERT_OK(iree_hal_module_register_all_types(instance_));
+
+    iree_hal_executable_loader_t* loader = NULL;
+    IREE_ASSERT_OK(iree_hal_embedded_elf_loader_create(
+        /*plugin_manager=*/NULL, /*disk_cache=*/NULL, iree_allocator_system(),
+        &loader));
+    iree_hal_allocator_t* device_allocator = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        IREE_SV("test"), iree_allocator_system(), iree_allocator_system(),
+        &device_allocator));
+    iree_hal_sync_device_params_t params;
+    iree_hal_sync_device_params_initialize(&params);
+    IREE_ASSERT_OK(iree_hal_sync_device_create(
+        IREE_SV("test"), &params, /*loader_count=*/1, &loader,
+        device_allocator, iree_allocator_system(), &device_));
+    iree_hal_allocator_release(device_allocator);
+    iree_hal_executable_loader_release(loader);
+
+    IREE_ASSERT_OK(iree_hal_module_create(
+        instance_, /*device_count=*/1, &device_, IREE_HAL_MODULE_FLAG_NONE,
+        iree_hal_module_debug_sink_null(), iree_allocator_system(),
+        &module_));
+  }
+
+  void TearDown() override {
+    iree_vm_module_release(module_);
+    iree_hal_device_release(device_);
+    iree_vm_instance_release(instance_);
+  }
+
+  iree_vm_context_t* CreateContext() {
+    iree_vm_context_t* context = NULL;
+    IREE_CHECK_OK(iree_vm_context_create_with_modules(
+        instance_, IREE_VM_CONTEXT_FLAG_NONE, /*module_count=*/1, &module_,
+        iree_allocator_system(), &context));
+    return context;
+  }
+
+  // Wraps |data| in a new buffer.
+  static vm::ref<iree_vm_buffer_t> MakeBuffer(iree_const_byte_span_t data) {
+    vm::ref<iree_vm_buffer_t> buffer;
+    IREE_CHECK_OK(iree_vm_buffer_create(
+        IREE_VM_BUFFER_ACCESS_MUTABLE | IREE_VM_BUFFER_ACCESS_ORIGIN_HOST,
+        data.data_length, /*alignment=*/16, iree_allocator_system(), &buffer));
+    IREE_CHECK_OK(iree_vm_buffer_write_elements(data.data, buffer.get(), 0,
+                                                data.data_length, 1));
+    return buffer;
+  }
+
+  // Creates an executable from |data| with hal.executable.create in |context|.
+  iree_status_t CreateExecutable(iree_vm_context_t* context,
+                                 iree_const_byte_span_t data) {
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(iree_vm_context_resolve_function(
+        context, IREE_SV("hal.executable.create"), &function));
+
+    iree_string_view_t format = IREE_SV("embedded-elf-" IREE_ARCH);
+    vm::ref<iree_vm_buffer_t> format_buffer = MakeBuffer(
+        iree_make_const_byte_span(format.data, format.size));
+    vm::ref<iree_vm_buffer_t> data_buffer = MakeBuffer(data);
+
+    vm::ref<iree_vm_list_t> inputs;
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(iree_vm_make_undefined_type_def(),
+                                             4, iree_allocator_system(),
+                                             &inputs));
+    iree_vm_ref_t device_ref = iree_hal_device_retain_ref(device_);
+    IREE_RETURN_IF_ERROR(iree_vm_list_push_ref_move(inputs.get(), &device_ref));
+    iree_vm_ref_t format_ref = iree_vm_buffer_retain_ref(format_buffer.get());
+    IREE_RETURN_IF_ERROR(iree_vm_list_push_ref_move(inputs.get(), &format_ref));
+    iree_vm_ref_t data_ref = iree_vm_buffer_retain_ref(data_buffer.get());
+    IREE_RETURN_IF_ERROR(iree_vm_list_push_ref_move(inputs.get(), &data_ref));
+    iree_vm_ref_t constants_ref = iree_vm_ref_null();
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_push_ref_move(inputs.get(), &constants_ref));
+    vm::ref<iree_vm_list_t> outputs;
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(iree_vm_make_undefined_type_def(),
+                                             1, iree_allocator_system(),
+                                             &outputs));
+
+    IREE_RETURN_IF_ERROR(iree_vm_invoke(
+        context, function, IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/nullptr,
+        inputs.get(), outputs.get(), iree_allocator_system()));
+
+    iree_vm_ref_t executable_ref = iree_vm_ref_null();
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_get_ref_assign(outputs.get(), 0, &executable_ref));
+    iree_hal_executable_t* executable = NULL;
+    return iree_hal_executable_check_deref(executable_ref, &executable);
+  }
+
+  iree_const_byte_span_t executable_data_ = iree_const_byte_span_empty();
+  iree_vm_instance_t* instance_ = NULL;
+  iree_hal_device_t* device_ = NULL;
+  iree_vm_module_t* module_ = NULL;
+};
+
+// Forked states share the executable caches of their parent and keep them
+// alive when the parent is freed first.
+TEST_F(HALModuleTest, ForkFreeParentThenUseChild) {
+  iree_vm_context_t* parent_context = CreateContext();
+  IREE_ASSERT_OK(CreateExecutable(parent_context, executable_data_));
+
+  iree_vm_context_t* child_context = NULL;
+  IREE_ASSERT_OK(iree_vm_context_fork(parent_context, iree_allocator_system(),
+                                      &child_context));
+  iree_vm_context_release(parent_context);
+
+  IREE_EXPECT_OK(CreateExecutable(child_context, executable_data_));
+  iree_vm_context_release(child_context);
+}
+
+// States forked from the same parent create executables concurrently and
+// failures in one do not affect the others.
+TEST_F(HALModuleTest, ConcurrentForks) {
+  iree_vm_context_t* parent_context = CreateContext();
+
+  static constexpr int kThreadCount = 4;
+  static constexpr int kExecutablesPerThread = 8;
+  std::vector<iree_vm_context_t*> child_contexts(kThreadCount, nullptr);
+  for (auto& child_context : child_contexts) {
+    IREE_ASSERT_OK(iree_vm_context_fork(
+        parent_context, iree_allocator_system(), &child_context));
+  }
+  iree_vm_context_release(parent_context);
+
+  std::vector<int> failure_counts(kThreadCount, 0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < kExecutablesPerThread; ++j) {
+        // Every other executable in odd threads is invalid and must fail
+        // without failing any of the valid ones.
+        const bool invalid = (i % 2) && (j % 2);
+        iree_status_t status = CreateExecutable(
+            child_contexts[i],
+            invalid ? iree_make_const_byte_span(kInvalidExecutableData,
+                                                sizeof(kInvalidExecutableData))
+                    : executable_data_);
+        if (iree_status_is_ok(status) == invalid) ++failure_counts[i];
+        iree_status_ignore(status);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int i = 0; i < kThreadCount; ++i) {
+    EXPECT_EQ(failure_counts[i], 0);
+  }
+
+  for (auto* child_context : child_contexts) {
+    iree_vm_context_release(child_context);
+  }
+}
+
+}  // namespace
+}  // namespace iree
@@ -21,65 +21,345 @@ extern "C" {
 // be doing expensive 64-bit atomics on a 32-bit bus all for just 2 bits of
 // data :)
 
+#if IREE_TASK_EXECUTOR_MAX_WORKER_COUNT > UINT16_MAX
+#error "iree_task_affinity_t stores worker indices in 16 bits"
+#endif  // IREE_TASK_EXECUTOR_MAX_WORKER_COUNT > UINT16_MAX
+
 //===----------------------------------------------------------------------===//
-// iree_task_affinity_set_t
+// iree_task_affinity_t
 //===----------------------------------------------------------------------===//
 
-typedef uint64_t iree_task_affinity_set_t;
+// Compact affinity stored on each task as a contiguous range of workers.
+// Tasks are kept small (see iree_task_t) and can't carry a full worker bitset;
+// the range is expanded into an iree_task_affinity_set_t only when a worker
+// needs to be selected.
+typedef struct iree_task_affinity_t {
+  // First executor-local worker index in the range.
+  uint16_t worker_start;
+  // Total number of workers in the range starting at worker_start.
+  uint16_t worker_count;
+} iree_task_affinity_t;
 
 // Allows for only a specific worker to be selected.
-static inline iree_task_affinity_set_t iree_task_affinity_for_worker(
-    uint8_t worker_index) {
-  return 1ull << worker_index;
+static inline iree_task_affinity_t iree_task_affinity_for_worker(
+    iree_host_size_t worker_index) {
+  iree_task_affinity_t affinity = {(uint16_t)worker_index, 1};
+  return affinity;
 }
 
-// Allows for a range of workers to be selected.
-static inline iree_task_affinity_set_t iree_task_affinity_for_worker_range(
-    uint8_t worker_start, uint8_t worker_end) {
-  return ((1ull << (worker_start - 1)) - 1) ^ ((1ull << worker_end) - 1);
+// Allows for a range of workers [worker_start, worker_end) to be selected.
+static inline iree_task_affinity_t iree_task_affinity_for_worker_range(
+    iree_host_size_t worker_start, iree_host_size_t worker_end) {
+  iree_task_affinity_t affinity = {(uint16_t)worker_start,
+                                   (uint16_t)(worker_end - worker_start)};
+  return affinity;
 }
 
 // Allows for any worker to be selected.
-static inline iree_task_affinity_set_t iree_task_affinity_for_any_worker(void) {
-  return UINT64_MAX;
+// The range covers all workers an executor may have and is clamped to the
+// workers of the executor the task is scheduled on with
+// iree_task_affinity_clamp.
+static inline iree_task_affinity_t iree_task_affinity_for_any_worker(void) {
+  iree_task_affinity_t affinity = {0, IREE_TASK_EXECUTOR_MAX_WORKER_COUNT};
+  return affinity;
+}
+
+// Returns |affinity| limited to the workers [0, worker_count). Affinities that
+// contain none of the workers are returned unchanged.
+static inline iree_task_affinity_t iree_task_affinity_clamp(
+    iree_task_affinity_t affinity, iree_host_size_t worker_count) {
+  if (affinity.worker_start < worker_count &&
+      affinity.worker_count > worker_count - affinity.worker_start) {
+    affinity.worker_count = (uint16_t)(worker_count - affinity.worker_start);
+  }
+  return affinity;
+}
+
+// Returns true if |worker_index| is allowed by |affinity|.
+static inline bool iree_task_affinity_contains(iree_task_affinity_t affinity,
+                                               iree_host_size_t worker_index) {
+  return worker_index - affinity.worker_start < affinity.worker_count;
+}
+
+// Returns the total number of workers allowed by |affinity|.
+static inline iree_host_size_t iree_task_affinity_worker_count(
+    iree_task_affinity_t affinity) {
+  return affinity.worker_count;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_task_affinity_set_t
+//===----------------------------------------------------------------------===//
+
+#define IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT 64
+#define IREE_TASK_AFFINITY_SET_WORD_COUNT        \
+  ((IREE_TASK_EXECUTOR_MAX_WORKER_COUNT + 63) / \
+   IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT)
+#define IREE_TASK_AFFINITY_SET_BIT_COUNT \
+  (IREE_TASK_AFFINITY_SET_WORD_COUNT * IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT)
+
+// Returned by iree_task_affinity_set_find_* when no bit is found.
+#define IREE_TASK_AFFINITY_SET_NPOS IREE_HOST_SIZE_MAX
+
+// The summary word of iree_atomic_task_affinity_set_t has one bit per word.
+static_assert(IREE_TASK_AFFINITY_SET_WORD_COUNT <=
+                  IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT,
+              "affinity set summary word overflow");
+
+// A bitset with one bit per executor-local worker index.
+// Stored as an array of 64-bit words with bit N of the set in bit (N % 64) of
+// word (N / 64). When IREE_TASK_EXECUTOR_MAX_WORKER_COUNT <= 64 this is a
+// single word and all operations compile down to the scalar equivalents.
+typedef struct iree_task_affinity_set_t {
+  uint64_t words[IREE_TASK_AFFINITY_SET_WORD_COUNT];
+} iree_task_affinity_set_t;
+
+// Returns a set with no bits set.
+static inline iree_task_affinity_set_t iree_task_affinity_set_empty(void) {
+  iree_task_affinity_set_t set;
+  for (iree_host_size_t i = 0; i < IREE_TASK_AFFINITY_SET_WORD_COUNT; ++i) {
+    set.words[i] = 0;
+  }
+  return set;
+}
+
+// Returns a set with the first |count| bits set.
+static inline iree_task_affinity_set_t iree_task_affinity_set_ones(
+    iree_host_size_t count) {
+  iree_task_affinity_set_t set;
+  for (iree_host_size_t i = 0; i < IREE_TASK_AFFINITY_SET_WORD_COUNT; ++i) {
+    iree_host_size_t word_start = i * IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT;
+    if (count <= word_start) {
+      set.words[i] = 0;
+    } else if (count - word_start >= IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT) {
+      set.words[i] = UINT64_MAX;
+    } else {
+      set.words[i] = UINT64_MAX >> (64 - (count - word_start));
+    }
+  }
+  return set;
+}
+
+// Returns a set containing only |index|.
+static inline iree_task_affinity_set_t iree_task_affinity_set_for_worker(
+    iree_host_size_t index) {
+  iree_task_affinity_set_t set = iree_task_affinity_set_empty();
+  set.words[index / IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT] =
+      1ull << (index % IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT);
+  return set;
 }
 
-#define iree_task_affinity_set_ones(count) \
-  (0xFFFFFFFFFFFFFFFFull >> (64 - (count)))
-#define iree_task_affinity_set_count_leading_zeros(set) \
-  iree_math_count_leading_zeros_u64(set)
-#define iree_task_affinity_set_count_trailing_zeros(set) \
-  iree_math_count_trailing_zeros_u64(set)
-#define iree_task_affinity_set_count_ones(set) iree_math_count_ones_u64(set)
-#define iree_task_affinity_set_rotr(set, count) iree_math_rotr_u64(set, count)
+// Returns a set containing all workers in the |affinity| range.
+static inline iree_task_affinity_set_t iree_task_affinity_set_from_affinity(
+    iree_task_affinity_t affinity) {
+  iree_host_size_t worker_start = affinity.worker_start;
+  iree_host_size_t worker_end =
+      iree_min((iree_host_size_t)affinity.worker_start + affinity.worker_count,
+               (iree_host_size_t)IREE_TASK_AFFINITY_SET_BIT_COUNT);
+  iree_task_affinity_set_t set = iree_task_affinity_set_ones(worker_end);
+  iree_task_affinity_set_t skip = iree_task_affinity_set_ones(worker_start);
+  for (iree_host_size_t i = 0; i < IREE_TASK_AFFINITY_SET_WORD_COUNT; ++i) {
+    set.words[i] &= ~skip.words[i];
+  }
+  return set;
+}
+
+// Returns true if |index| is set in |set|.
+static inline bool iree_task_affinity_set_contains(
+    const iree_task_affinity_set_t* set, iree_host_size_t index) {
+  return (set->words[index / IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT] >>
+          (index % IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT)) &
+         1;
+}
+
+// Sets |index| in |set|.
+static inline void iree_task_affinity_set_insert(iree_task_affinity_set_t* set,
+                                                 iree_host_size_t index) {
+  set->words[index / IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT] |=
+      1ull << (index % IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT);
+}
+
+// Clears |index| in |set|.
+static inline void iree_task_affinity_set_erase(iree_task_affinity_set_t* set,
+                                                iree_host_size_t index) {
+  set->words[index / IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT] &=
+      ~(1ull << (index % IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT));
+}
+
+// Returns true if no bits are set in |set|.
+static inline bool iree_task_affinity_set_is_empty(
+    const iree_task_affinity_set_t* set) {
+  uint64_t any = 0;
+  for (iree_host_size_t i = 0; i < IREE_TASK_AFFINITY_SET_WORD_COUNT; ++i) {
+    any |= set->words[i];
+  }
+  return any == 0;
+}
+
+// Returns the total number of bits set in |set|.
+static inline iree_host_size_t iree_task_affinity_set_count_ones(
+    const iree_task_affinity_set_t* set) {
+  iree_host_size_t count = 0;
+  for (iree_host_size_t i = 0; i < IREE_TASK_AFFINITY_SET_WORD_COUNT; ++i) {
+    count += iree_math_count_ones_u64(set->words[i]);
+  }
+  return count;
+}
+
+// Returns |lhs| & |rhs|.
+static inline iree_task_affinity_set_t iree_task_affinity_set_and(
+    const iree_task_affinity_set_t* lhs, const iree_task_affinity_set_t* rhs) {
+  iree_task_affinity_set_t set;
+  for (iree_host_size_t i = 0; i < IREE_TASK_AFFINITY_SET_WORD_COUNT; ++i) {
+    set.words[i] = lhs->words[i] & rhs->words[i];
+  }
+  return set;
+}
+
+// Returns |lhs| & ~|rhs|.
+static inline iree_task_affinity_set_t iree_task_affinity_set_and_not(
+    const iree_task_affinity_set_t* lhs, const iree_task_affinity_set_t* rhs) {
+  iree_task_affinity_set_t set;
+  for (iree_host_size_t i = 0; i < IREE_TASK_AFFINITY_SET_WORD_COUNT; ++i) {
+    set.words[i] = lhs->words[i] & ~rhs->words[i];
+  }
+  return set;
+}
+
+// Returns |lhs| | |rhs|.
+static inline iree_task_affinity_set_t iree_task_affinity_set_or(
+    const iree_task_affinity_set_t* lhs, const iree_task_affinity_set_t* rhs) {
+  iree_task_affinity_set_t set;
+  for (iree_host_size_t i = 0; i < IREE_TASK_AFFINITY_SET_WORD_COUNT; ++i) {
+    set.words[i] = lhs->words[i] | rhs->words[i];
+  }
+  return set;
+}
+
+// Returns the index of the first bit set in |set| at or after |start_index| or
+// IREE_TASK_AFFINITY_SET_NPOS if there are none. Empty words are skipped
+// without a per-bit scan so iterating over a sparse set is O(words + popcnt).
+static inline iree_host_size_t iree_task_affinity_set_find_next(
+    const iree_task_affinity_set_t* set, iree_host_size_t start_index) {
+  iree_host_size_t word_index =
+      start_index / IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT;
+  if (word_index >= IREE_TASK_AFFINITY_SET_WORD_COUNT) {
+    return IREE_TASK_AFFINITY_SET_NPOS;
+  }
+  uint64_t word = set->words[word_index] &
+                  (UINT64_MAX << (start_index %
+                                  IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT));
+  while (!word) {
+    if (++word_index >= IREE_TASK_AFFINITY_SET_WORD_COUNT) {
+      return IREE_TASK_AFFINITY_SET_NPOS;
+    }
+    word = set->words[word_index];
+  }
+  return word_index * IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT +
+         iree_math_count_trailing_zeros_u64(word);
+}
+
+// Returns the index of the first bit set in |set| or
+// IREE_TASK_AFFINITY_SET_NPOS if the set is empty.
+static inline iree_host_size_t iree_task_affinity_set_find_first(
+    const iree_task_affinity_set_t* set) {
+  return iree_task_affinity_set_find_next(set, 0);
+}
 
 //===----------------------------------------------------------------------===//
 // iree_atomic_task_affinity_set_t
 //===----------------------------------------------------------------------===//
 
-typedef iree_atomic_int64_t iree_atomic_task_affinity_set_t;
+// An atomic iree_task_affinity_set_t with a summary word used to skip empty
+// words when loading. Bit N of the summary is set when word N (likely) has any
+// bits set. Updates only touch the summary when a word transitions between
+// empty and non-empty so workers flipping their bits in a busy set contend only
+// on the word covering them instead of on one word shared by all workers.
+//
+// Loads are not a single atomic snapshot of the whole set: each word is loaded
+// independently and a word whose summary bit is observed clear is treated as
+// empty. All users treat the sets as hints and must be OK with getting
+// slightly out-of-date information.
+typedef struct iree_atomic_task_affinity_set_t {
+  iree_atomic_int64_t summary;
+  iree_atomic_int64_t words[IREE_TASK_AFFINITY_SET_WORD_COUNT];
+} iree_atomic_task_affinity_set_t;
 
 static inline iree_task_affinity_set_t iree_atomic_task_affinity_set_load(
     iree_atomic_task_affinity_set_t* set, iree_memory_order_t order) {
-  return iree_atomic_load(set, order);
+  iree_task_affinity_set_t value = iree_task_affinity_set_empty();
+#if IREE_TASK_AFFINITY_SET_WORD_COUNT == 1
+  value.words[0] = (uint64_t)iree_atomic_load(&set->words[0], order);
+#else
+  uint64_t summary = (uint64_t)iree_atomic_load(&set->summary, order);
+  while (summary) {
+    int word_index = iree_math_count_trailing_zeros_u64(summary);
+    summary &= summary - 1;
+    value.words[word_index] =
+        (uint64_t)iree_atomic_load(&set->words[word_index], order);
+  }
+#endif  // IREE_TASK_AFFINITY_SET_WORD_COUNT == 1
+  return value;
 }
 
+// Stores |value| into |set|. Not safe to race with concurrent updates and only
+// intended for initialization.
 static inline void iree_atomic_task_affinity_set_store(
-    iree_atomic_task_affinity_set_t* set, iree_task_affinity_set_t value,
+    iree_atomic_task_affinity_set_t* set, const iree_task_affinity_set_t* value,
     iree_memory_order_t order) {
-  iree_atomic_store(set, value, order);
+  uint64_t summary = 0;
+  for (iree_host_size_t i = 0; i < IREE_TASK_AFFINITY_SET_WORD_COUNT; ++i) {
+    iree_atomic_store(&set->words[i], (int64_t)value->words[i], order);
+    if (value->words[i]) summary |= 1ull << i;
+  }
+  iree_atomic_store(&set->summary, (int64_t)summary, order);
 }
 
-static inline iree_task_affinity_set_t iree_atomic_task_affinity_set_fetch_and(
-    iree_atomic_task_affinity_set_t* set, iree_task_affinity_set_t value,
+// Atomically sets |index| in |set|.
+static inline void iree_atomic_task_affinity_set_insert(
+    iree_atomic_task_affinity_set_t* set, iree_host_size_t index,
     iree_memory_order_t order) {
-  return iree_atomic_fetch_and(set, value, order);
+  iree_host_size_t word_index = index / IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT;
+  uint64_t old_word = (uint64_t)iree_atomic_fetch_or(
+      &set->words[word_index],
+      (int64_t)(1ull << (index % IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT)),
+      order);
+#if IREE_TASK_AFFINITY_SET_WORD_COUNT > 1
+  // Publish the word in the summary if it was empty. Release ordering pairs
+  // with the summary update in erase so that a concurrent erase that races
+  // with us observes our bit when it re-checks the word.
+  if (!old_word) {
+    iree_atomic_fetch_or(&set->summary, (int64_t)(1ull << word_index),
+                         iree_memory_order_acq_rel);
+  }
+#else
+  (void)old_word;
+#endif  // IREE_TASK_AFFINITY_SET_WORD_COUNT > 1
 }
 
-static inline iree_task_affinity_set_t iree_atomic_task_affinity_set_fetch_or(
-    iree_atomic_task_affinity_set_t* set, iree_task_affinity_set_t value,
+// Atomically clears |index| in |set|.
+static inline void iree_atomic_task_affinity_set_erase(
+    iree_atomic_task_affinity_set_t* set, iree_host_size_t index,
     iree_memory_order_t order) {
-  return iree_atomic_fetch_or(set, value, order);
+  iree_host_size_t word_index = index / IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT;
+  uint64_t word_bit = 1ull << (index % IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT);
+  uint64_t old_word = (uint64_t)iree_atomic_fetch_and(
+      &set->words[word_index], (int64_t)~word_bit, order);
+#if IREE_TASK_AFFINITY_SET_WORD_COUNT > 1
+  // Retract the word from the summary if we emptied it. Another thread may
+  // insert into the word between our update and the summary update so we
+  // re-check the word afterward and restore the summary bit if needed.
+  if (old_word == word_bit) {
+    iree_atomic_fetch_and(&set->summary, (int64_t)~(1ull << word_index),
+                          iree_memory_order_acq_rel);
+    if (iree_atomic_load(&set->words[word_index], iree_memory_order_relaxed)) {
+      iree_atomic_fetch_or(&set->summary, (int64_t)(1ull << word_index),
+                           iree_memory_order_acq_rel);
+    }
+  }
+#else
+  (void)old_word;
+#endif  // IREE_TASK_AFFINITY_SET_WORD_COUNT > 1
 }
 
 #ifdef __cplusplus
@@ -0,0 +1,257 @@
+// Copyright 2020 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/task/affinity_set.h"
+
+#include <string>
+#include <vector>
+
+#include "iree/testing/gtest.h"
+
+namespace {
+
+// Returns all indices set in |set| in ascending order using find_next.
+static std::vector<iree_host_size_t> CollectIndices(
+    const iree_task_affinity_set_t& set) {
+  std::vector<iree_host_size_t> indices;
+  for (iree_host_size_t i = iree_task_affinity_set_find_first(&set);
+       i != IREE_TASK_AFFINITY_SET_NPOS;
+       i = iree_task_affinity_set_find_next(&set, i + 1)) {
+    indices.push_back(i);
+  }
+  return indices;
+}
+
+static iree_task_affinity_set_t LoadSet(iree_atomic_task_affinity_set_t* set) {
+  return iree_atomic_task_affinity_set_load(set, iree_memory_order_relaxed);
+}
+
+static uint64_t LoadSummary(iree_atomic_task_affinity_set_t* set) {
+  return (uint64_t)iree_atomic_load(&set->summary, iree_memory_order_relaxed);
+}
+
+// Parameterized on the number of workers (bits) in use.
+class AffinitySetTest : public ::testing::TestWithParam<iree_host_size_t> {
+ protected:
+  void SetUp() override {
+    if (GetParam() > IREE_TASK_AFFINITY_SET_BIT_COUNT) {
+      GTEST_SKIP() << "IREE_TASK_EXECUTOR_MAX_WORKER_COUNT too small";
+    }
+  }
+};
+
+TEST_P(AffinitySetTest, Empty) {
+  iree_task_affinity_set_t set = iree_task_affinity_set_empty();
+  EXPECT_TRUE(iree_task_affinity_set_is_empty(&set));
+  EXPECT_EQ(0u, iree_task_affinity_set_count_ones(&set));
+  EXPECT_EQ(IREE_TASK_AFFINITY_SET_NPOS,
+            iree_task_affinity_set_find_first(&set));
+  EXPECT_EQ(IREE_TASK_AFFINITY_SET_NPOS,
+            iree_task_affinity_set_find_next(&set, GetParam() - 1));
+}
+
+// Tests that the last partial word only has the bits below the count set.
+TEST_P(AffinitySetTest, Ones) {
+  const iree_host_size_t bit_count = GetParam();
+  iree_task_affinity_set_t set = iree_task_affinity_set_ones(bit_count);
+  EXPECT_EQ(bit_count, iree_task_affinity_set_count_ones(&set));
+  EXPECT_TRUE(iree_task_affinity_set_contains(&set, 0));
+  EXPECT_TRUE(iree_task_affinity_set_contains(&set, bit_count - 1));
+  if (bit_count < IREE_TASK_AFFINITY_SET_BIT_COUNT) {
+    EXPECT_FALSE(iree_task_affinity_set_contains(&set, bit_count));
+  }
+  EXPECT_EQ(IREE_TASK_AFFINITY_SET_NPOS,
+            iree_task_affinity_set_find_next(&set, bit_count));
+  std::vector<iree_host_size_t> indices = CollectIndices(set);
+  ASSERT_EQ(bit_count, indices.size());
+  for (iree_host_size_t i = 0; i < bit_count; ++i) {
+    EXPECT_EQ(i, indices[i]);
+  }
+}
+
+// Tests find_next skipping the empty words between the first and last bits.
+TEST_P(AffinitySetTest, FindNextSkipsEmptyWords) {
+  const iree_host_size_t bit_count = GetParam();
+  iree_task_affinity_set_t set = iree_task_affinity_set_empty();
+  iree_task_affinity_set_insert(&set, 0);
+  iree_task_affinity_set_insert(&set, bit_count - 1);
+  EXPECT_EQ(0u, iree_task_affinity_set_find_first(&set));
+  if (bit_count > 1) {
+    EXPECT_EQ(bit_count - 1, iree_task_affinity_set_find_next(&set, 1));
+  }
+  EXPECT_EQ(IREE_TASK_AFFINITY_SET_NPOS,
+            iree_task_affinity_set_find_next(&set, bit_count));
+
+  iree_task_affinity_set_erase(&set, 0);
+  if (bit_count > 1) {
+    EXPECT_EQ(bit_count - 1, iree_task_affinity_set_find_first(&set));
+    iree_task_affinity_set_erase(&set, bit_count - 1);
+  }
+  EXPECT_TRUE(iree_task_affinity_set_is_empty(&set));
+}
+
+// Tests find_next starting on each side of every word boundary in range.
+TEST_P(AffinitySetTest, FindNextAcrossWordBoundaries) {
+  const iree_host_size_t bit_count = GetParam();
+  for (iree_host_size_t boundary = IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT;
+       boundary < bit_count;
+       boundary += IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT) {
+    iree_task_affinity_set_t set = iree_task_affinity_set_empty();
+    iree_task_affinity_set_insert(&set, boundary - 1);
+    iree_task_affinity_set_insert(&set, boundary);
+    EXPECT_EQ(boundary - 1, iree_task_affinity_set_find_next(&set, 0));
+    EXPECT_EQ(boundary - 1,
+              iree_task_affinity_set_find_next(&set, boundary - 1));
+    EXPECT_EQ(boundary, iree_task_affinity_set_find_next(&set, boundary));
+    EXPECT_EQ(IREE_TASK_AFFINITY_SET_NPOS,
+              iree_task_affinity_set_find_next(&set, boundary + 1));
+    std::vector<iree_host_size_t> indices = CollectIndices(set);
+    EXPECT_EQ(std::vector<iree_host_size_t>({boundary - 1, boundary}),
+              indices);
+  }
+}
+
+TEST_P(AffinitySetTest, BitwiseOps) {
+  const iree_host_size_t bit_count = GetParam();
+  iree_task_affinity_set_t all = iree_task_affinity_set_ones(bit_count);
+  iree_task_affinity_set_t last =
+      iree_task_affinity_set_for_worker(bit_count - 1);
+  iree_task_affinity_set_t both = iree_task_affinity_set_and(&all, &last);
+  EXPECT_EQ(std::vector<iree_host_size_t>({bit_count - 1}),
+            CollectIndices(both));
+  iree_task_affinity_set_t rest = iree_task_affinity_set_and_not(&all, &last);
+  EXPECT_EQ(bit_count - 1, iree_task_affinity_set_count_ones(&rest));
+  EXPECT_FALSE(iree_task_affinity_set_contains(&rest, bit_count - 1));
+  iree_task_affinity_set_t merged = iree_task_affinity_set_or(&rest, &last);
+  EXPECT_EQ(CollectIndices(all), CollectIndices(merged));
+}
+
+// Tests that the any-worker affinity is clamped to exactly the workers in use.
+TEST_P(AffinitySetTest, ClampAnyWorker) {
+  const iree_host_size_t bit_count = GetParam();
+  iree_task_affinity_t affinity =
+      iree_task_affinity_clamp(iree_task_affinity_for_any_worker(), bit_count);
+  EXPECT_EQ(bit_count, iree_task_affinity_worker_count(affinity));
+  EXPECT_TRUE(iree_task_affinity_contains(affinity, bit_count - 1));
+  EXPECT_FALSE(iree_task_affinity_contains(affinity, bit_count));
+  iree_task_affinity_set_t set = iree_task_affinity_set_from_affinity(affinity);
+  iree_task_affinity_set_t ones = iree_task_affinity_set_ones(bit_count);
+  EXPECT_EQ(CollectIndices(ones), CollectIndices(set));
+
+  // A range starting past the workers in use is left as-is.
+  iree_task_affinity_t outside =
+      iree_task_affinity_clamp(iree_task_affinity_for_worker(bit_count), 1);
+  EXPECT_EQ(bit_count, outside.worker_start);
+  EXPECT_EQ(1u, iree_task_affinity_worker_count(outside));
+
+  // A range that straddles the end is cut at the end.
+  iree_task_affinity_t straddle = iree_task_affinity_clamp(
+      iree_task_affinity_for_worker_range(bit_count - 1, bit_count + 2),
+      bit_count);
+  EXPECT_EQ(1u, iree_task_affinity_worker_count(straddle));
+}
+
+// Tests range->set expansion for ranges ending on and around word edges.
+TEST_P(AffinitySetTest, FromAffinityAtWordEdges) {
+  const iree_host_size_t bit_count = GetParam();
+  for (iree_host_size_t start = 0; start < bit_count; ++start) {
+    iree_host_size_t in_word = start % IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT;
+    if (start + 1 != bit_count && in_word != 0 && in_word != 1 &&
+        in_word != IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT - 1) {
+      continue;
+    }
+    for (iree_host_size_t end : {start + 1, start + 2,
+                                 start + IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT,
+                                 bit_count}) {
+      if (end <= start || end > bit_count) continue;
+      iree_task_affinity_t affinity =
+          iree_task_affinity_for_worker_range(start, end);
+      iree_task_affinity_set_t set =
+          iree_task_affinity_set_from_affinity(affinity);
+      std::vector<iree_host_size_t> expected;
+      for (iree_host_size_t i = start; i < end; ++i) expected.push_back(i);
+      EXPECT_EQ(expected, CollectIndices(set))
+          << "range [" << start << ", " << end << ")";
+      for (iree_host_size_t i = 0; i < bit_count; ++i) {
+        EXPECT_EQ(iree_task_affinity_contains(affinity, i),
+                  iree_task_affinity_set_contains(&set, i));
+      }
+    }
+  }
+}
+
+// Tests that the summary word tracks words transitioning between empty and
+// non-empty and that loads see every set bit.
+TEST_P(AffinitySetTest, AtomicInsertErase) {
+  const iree_host_size_t bit_count = GetParam();
+  iree_atomic_task_affinity_set_t atomic_set;
+  iree_task_affinity_set_t empty = iree_task_affinity_set_empty();
+  iree_atomic_task_affinity_set_store(&atomic_set, &empty,
+                                      iree_memory_order_relaxed);
+  EXPECT_EQ(0u, LoadSummary(&atomic_set));
+
+  const iree_host_size_t last = bit_count - 1;
+  const uint64_t last_word_bit =
+      1ull << (last / IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT);
+  iree_atomic_task_affinity_set_insert(&atomic_set, last,
+                                       iree_memory_order_relaxed);
+  iree_atomic_task_affinity_set_insert(&atomic_set, 0,
+                                       iree_memory_order_relaxed);
+  iree_task_affinity_set_t set = LoadSet(&atomic_set);
+  if (last) {
+    EXPECT_EQ(std::vector<iree_host_size_t>({0, last}), CollectIndices(set));
+  } else {
+    EXPECT_EQ(std::vector<iree_host_size_t>({0}), CollectIndices(set));
+  }
+  if (IREE_TASK_AFFINITY_SET_WORD_COUNT > 1) {
+    EXPECT_EQ(1ull | last_word_bit, LoadSummary(&atomic_set));
+  }
+
+  // Erasing the only bit of a word retracts it from the summary.
+  iree_atomic_task_affinity_set_erase(&atomic_set, 0,
+                                      iree_memory_order_relaxed);
+  set = LoadSet(&atomic_set);
+  if (last) {
+    EXPECT_EQ(std::vector<iree_host_size_t>({last}), CollectIndices(set));
+    if (IREE_TASK_AFFINITY_SET_WORD_COUNT > 1) {
+      EXPECT_EQ(last_word_bit, LoadSummary(&atomic_set));
+    }
+  } else {
+    EXPECT_TRUE(iree_task_affinity_set_is_empty(&set));
+  }
+
+  // Moving the bit down by one (possibly into the previous word) leaves only
+  // the word now holding it in the summary.
+  if (last >= 1) {
+    iree_atomic_task_affinity_set_insert(&atomic_set, last - 1,
+                                         iree_memory_order_relaxed);
+    iree_atomic_task_affinity_set_erase(&atomic_set, last,
+                                        iree_memory_order_relaxed);
+    set = LoadSet(&atomic_set);
+    EXPECT_EQ(std::vector<iree_host_size_t>({last - 1}), CollectIndices(set));
+    if (IREE_TASK_AFFINITY_SET_WORD_COUNT > 1) {
+      EXPECT_EQ(1ull << ((last - 1) / IREE_TASK_AFFINITY_SET_WORD_BIT_COUNT),
+                LoadSummary(&atomic_set));
+    }
+    iree_atomic_task_affinity_set_erase(&atomic_set, last - 1,
+                                        iree_memory_order_relaxed);
+  } else {
+    iree_atomic_task_affinity_set_erase(&atomic_set, last,
+                                        iree_memory_order_relaxed);
+  }
+  set = LoadSet(&atomic_set);
+  EXPECT_TRUE(iree_task_affinity_set_is_empty(&set));
+  EXPECT_EQ(0u, LoadSummary(&atomic_set));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    BitCounts, AffinitySetTest,
+    ::testing::Values(1, 63, 64, 65, 128, 256),
+    [](const ::testing::TestParamInfo<iree_host_size_t>& info) {
+      return "Bits" + std::to_string(info.param);
+    });
+
+}  // namespace
@@ -24,6 +24,20 @@ IREE_FLAG(
     "when latency is the #1 priority (vs. thermals, system-wide scheduling,\n"
     "etc).");
 
+IREE_FLAG(
+    bool, task_worker_spin_adaptive, false,
+    "Adapts the duration each worker spins to how long it has recently\n"
+    "waited for work, bounded by --task_worker_spin_us. Workers that are\n"
+    "regularly woken soon after going idle keep spinning while workers that\n"
+    "are idle for longer periods stop spinning and park immediately.");
+
+IREE_FLAG(
+    bool, task_persistent_dispatch, false,
+    "Executes dispatches by having workers claim ranges of tiles directly\n"
+    "instead of forking each dispatch into shard tasks. Reduces the per-\n"
+    "dispatch overhead of workloads issuing many small dispatches and is\n"
+    "best combined with a non-zero --task_worker_spin_us.");
+
 IREE_FLAG(
     int32_t, task_worker_stack_size, 128 * 1024,
     "Minimum size in bytes of each worker thread stack.\n"
@@ -48,8 +62,13 @@ iree_status_t iree_task_executor_options_initialize_from_flags(
     iree_task_executor_options_t* out_options) {
   IREE_ASSERT_ARGUMENT(out_options);
   iree_task_executor_options_initialize(out_options);
+  if (FLAG_task_persistent_dispatch) {
+    out_options->scheduling_mode |=
+        IREE_TASK_SCHEDULING_MODE_PERSISTENT_DISPATCH;
+  }
   out_options->worker_spin_ns =
       (iree_duration_t)FLAG_task_worker_spin_us * 1000;
+  out_options->worker_spin_adaptive = FLAG_task_worker_spin_adaptive;
   out_options->worker_stack_size =
       (iree_host_size_t)FLAG_task_worker_stack_size;
   out_options->worker_local_memory_size =
@@ -95,7 +114,9 @@ IREE_FLAG(
     "Comma-separated list of NUMA nodes that topologies will be defined for.\n"
     "Each node specified will be configured based on the other topology\n"
     "flags. 'all' can be used to indicate all available NUMA nodes and\n"
-    "'current' will inherit the node of the calling thread.");
+    "'current' will inherit the node of the calling thread. 'any' defines a\n"
+    "single topology spanning all nodes with workers preferring to steal\n"
+    "from others on their own node before crossing to remote nodes.");
 
 IREE_FLAG(
     int32_t, task_topology_max_group_count, 64,
@@ -107,7 +128,14 @@ IREE_FLAG(string, task_topology_performance_level, "any",
           "Selects only cores that match the specified performance level from\n"
           "[`any`, `low` (or `efficiency`), `high` (or `performance`)].");
 
+// Returns true if a single topology spanning all NUMA nodes was requested.
+static bool iree_task_topologies_span_nodes_from_flags(void) {
+  return strcmp(FLAG_task_topology_nodes, "any") == 0;
+}
+
 // Builds a bitmask of NUMA nodes that topologies should be created for.
+// When spanning nodes a single bit is set and the topology should be created
+// with IREE_TASK_TOPOLOGY_NODE_ID_ANY.
 //
 // NOTE: because of the mask being 64-bits we have a 64-node limit.
 // We could change this mask to be variable-sized (ala cpu_set) if we wanted to
@@ -132,6 +160,9 @@ static iree_status_t iree_task_topologies_select_nodes_from_flags(
       iree_string_view_equal(nodes_flag, IREE_SV("current"))) {
     // Use a single default node.
     node_mask = 1ull << iree_task_topology_query_current_node();
+  } else if (iree_string_view_equal(nodes_flag, IREE_SV("any"))) {
+    // Use a single topology spanning all nodes.
+    node_mask = 1ull;
   } else if (iree_string_view_equal(nodes_flag, IREE_SV("all"))) {
     // Use all nodes in the system (set bits starting at 0 for each node).
     node_mask = UINT64_MAX >> (64 - available_node_count);
@@ -233,6 +264,7 @@ static void iree_task_flags_dump_task_topology(
     const iree_task_topology_group_t* group = &topology->groups[j];
     fprintf(stdout, "# group[%d]: '%s'\n", group->group_index, group->name);
     fprintf(stdout, "#      processor: %u\n", group->processor_index);
+    fprintf(stdout, "#      numa node: %u\n", group->node_id);
     fprintf(stdout, "#       affinity: ");
     if (group->ideal_thread_affinity.specified) {
       fprintf(
@@ -247,17 +279,18 @@ static void iree_task_flags_dump_task_topology(
             group->caches.l2_data);
 
     fprintf(stdout, "#  last level cache sharing: ");
-    if (group->constructive_sharing_mask == 0) {
+    iree_host_size_t sharing_count =
+        iree_task_affinity_set_count_ones(&group->constructive_sharing_mask);
+    if (sharing_count == 0) {
       fprintf(stdout, "(none)\n");
-    } else if (group->constructive_sharing_mask ==
-               IREE_TASK_TOPOLOGY_GROUP_MASK_ALL) {
+    } else if (sharing_count >= IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT) {
       fprintf(stdout, "(all/undefined)\n");
     } else {
-      fprintf(stdout, "%d group(s): ",
-              iree_math_count_ones_u64(group->constructive_sharing_mask));
+      fprintf(stdout, "%" PRIhsz " group(s): ", sharing_count);
       for (iree_host_size_t ic = 0, jc = 0;
            ic < IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT; ++ic) {
-        if ((group->constructive_sharing_mask >> ic) & 1) {
+        if (iree_task_affinity_set_contains(&group->constructive_sharing_mask,
+                                            ic)) {
           if (jc > 0) fprintf(stdout, ", ");
           fprintf(stdout, "%" PRIhsz, ic);
           ++jc;
@@ -286,11 +319,13 @@ static iree_status_t iree_task_flags_dump_task_topologies(
     uint64_t node_mask_bits = node_mask;
     iree_task_topology_node_id_t node_base_id = 0;
     for (iree_host_size_t i = 0; i < topology_count; ++i) {
-      int node_offset =
-          iree_task_affinity_set_count_trailing_zeros(node_mask_bits);
+      int node_offset = iree_math_count_trailing_zeros_u64(node_mask_bits);
       iree_task_topology_node_id_t node_id = node_base_id + node_offset;
       node_base_id += node_offset + 1;
       node_mask_bits = iree_shr(node_mask_bits, node_offset + 1);
+      if (iree_task_topologies_span_nodes_from_flags()) {
+        node_id = IREE_TASK_TOPOLOGY_NODE_ID_ANY;
+      }
       iree_task_topology_t topology;
       IREE_RETURN_IF_ERROR(
           iree_task_topology_initialize_from_flags(node_id, &topology));
@@ -385,11 +420,13 @@ iree_status_t iree_task_executors_create_from_flags(
     uint64_t node_mask_bits = node_mask;
     iree_task_topology_node_id_t node_base_id = 0;
     for (iree_host_size_t i = 0; i < topology_count; ++i) {
-      int node_offset =
-          iree_task_affinity_set_count_trailing_zeros(node_mask_bits);
+      int node_offset = iree_math_count_trailing_zeros_u64(node_mask_bits);
       iree_task_topology_node_id_t node_id = node_base_id + node_offset;
       node_base_id += node_offset + 1;
       node_mask_bits = iree_shr(node_mask_bits, node_offset + 1);
+      if (iree_task_topologies_span_nodes_from_flags()) {
+        node_id = IREE_TASK_TOPOLOGY_NODE_ID_ANY;
+      }
 
       // Query topology for the node this executor is pinned to.
       iree_task_topology_t topology;
@@ -12,6 +12,7 @@
 
 #include "iree/base/internal/debugging.h"
 #include "iree/base/internal/math.h"
+#include "iree/base/internal/memory.h"
 #include "iree/task/affinity_set.h"
 #include "iree/task/executor_impl.h"
 #include "iree/task/list.h"
@@ -31,11 +32,11 @@ void iree_task_executor_options_initialize(
 
 // Returns the size of the worker local memory required by |group| in bytes.
 // We don't want destructive sharing between workers so ensure we are aligned to
-// at least the destructive interference size, even if a bit larger than what
-// the user asked for or the device supports.
+// at least the destructive interference size (or |alignment| if larger), even
+// if a bit larger than what the user asked for or the device supports.
 static iree_host_size_t iree_task_topology_group_local_memory_size(
     iree_task_executor_options_t options,
-    const iree_task_topology_group_t* group) {
+    const iree_task_topology_group_t* group, iree_host_size_t alignment) {
   iree_host_size_t worker_local_memory_size = options.worker_local_memory_size;
   if (!worker_local_memory_size) {
     worker_local_memory_size = group->caches.l2_data;
@@ -43,8 +44,31 @@ static iree_host_size_t iree_task_topology_group_local_memory_size(
   if (!worker_local_memory_size) {
     worker_local_memory_size = group->caches.l1_data;
   }
-  return iree_host_align(worker_local_memory_size,
-                         iree_hardware_destructive_interference_size);
+  return iree_host_align(worker_local_memory_size, alignment);
+}
+
+// Returns true if the groups in |topology| reside on more than one NUMA node.
+static bool iree_task_topology_spans_nodes(
+    const iree_task_topology_t* topology) {
+  for (iree_host_size_t i = 1; i < topology->group_count; ++i) {
+    if (topology->groups[i].node_id != topology->groups[0].node_id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns a mask of all workers whose topology groups reside on |node_id|.
+static iree_task_affinity_set_t iree_task_topology_node_worker_mask(
+    const iree_task_topology_t* topology,
+    iree_task_topology_node_id_t node_id) {
+  iree_task_affinity_set_t node_mask = iree_task_affinity_set_empty();
+  for (iree_host_size_t i = 0; i < topology->group_count; ++i) {
+    if (topology->groups[i].node_id == node_id) {
+      iree_task_affinity_set_insert(&node_mask, i);
+    }
+  }
+  return node_mask;
 }
 
 iree_status_t iree_task_executor_create(iree_task_executor_options_t options,
@@ -71,12 +95,24 @@ iree_status_t iree_task_executor_create(iree_task_executor_options_t options,
   IREE_ASSERT_ARGUMENT(out_executor);
   *out_executor = NULL;
 
+  // When workers span multiple NUMA nodes their local memory is page aligned so
+  // that each worker can have its pages placed on its own node (first-touch
+  // placement) without sharing any page with a worker on another node.
+  iree_host_size_t local_memory_alignment =
+      iree_hardware_destructive_interference_size;
+  if (iree_task_topology_spans_nodes(topology)) {
+    const iree_memory_info_t memory_info = iree_memory_query_info();
+    local_memory_alignment =
+        iree_max(local_memory_alignment, memory_info.normal_page_size);
+  }
+
   // The executor is followed in memory by worker[] + worker_local_memory[].
   iree_host_size_t total_worker_local_memory_size = 0;
   for (iree_host_size_t i = 0; i < worker_count; ++i) {
     total_worker_local_memory_size +=
         iree_task_topology_group_local_memory_size(
-            options, iree_task_topology_get_group(topology, i));
+            options, iree_task_topology_get_group(topology, i),
+            local_memory_alignment);
   }
   IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (int64_t)total_worker_local_memory_size);
 
@@ -86,17 +122,28 @@ iree_status_t iree_task_executor_create(iree_task_executor_options_t options,
   iree_host_size_t worker_list_size =
       iree_host_align(worker_count * sizeof(iree_task_worker_t),
                       iree_hardware_destructive_interference_size);
-  iree_host_size_t executor_size =
-      executor_base_size + worker_list_size + total_worker_local_memory_size;
+  iree_host_size_t local_memory_padding =
+      local_memory_alignment > iree_hardware_destructive_interference_size
+          ? local_memory_alignment
+          : 0;
+  iree_host_size_t executor_size = executor_base_size + worker_list_size +
+                                   local_memory_padding +
+                                   total_worker_local_memory_size;
 
   iree_task_executor_t* executor = NULL;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_allocator_malloc(allocator, executor_size, (void**)&executor));
-  memset(executor, 0, executor_size);
+  // NOTE: worker local memory is zeroed by each worker thread so that it is
+  // first touched on the worker's NUMA node.
+  memset(executor, 0, executor_base_size + worker_list_size);
   iree_atomic_ref_count_init(&executor->ref_count);
   executor->allocator = allocator;
   executor->scheduling_mode = options.scheduling_mode;
   executor->worker_spin_ns = options.worker_spin_ns;
+  executor->worker_spin_adaptive = options.worker_spin_adaptive;
+  executor->max_theft_task_count =
+      iree_min(IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT,
+               iree_max(1, IREE_TASK_QUEUE_CAPACITY / worker_count));
   iree_atomic_task_slist_initialize(&executor->incoming_ready_slist);
   iree_slim_mutex_initialize(&executor->coordinator_mutex);
 
@@ -169,6 +216,10 @@ iree_status_t iree_task_executor_create(iree_task_executor_options_t options,
         (iree_task_worker_t*)((uint8_t*)executor + executor_base_size);
     uint8_t* worker_local_memory =
         (uint8_t*)executor->workers + worker_list_size;
+    if (local_memory_padding > 0) {
+      worker_local_memory = (uint8_t*)iree_host_align(
+          (uintptr_t)worker_local_memory, local_memory_alignment);
+    }
 
     iree_task_affinity_set_t worker_mask =
         iree_task_affinity_set_ones(worker_count);
@@ -177,10 +228,13 @@ iree_status_t iree_task_executor_create(iree_task_executor_options_t options,
       const iree_task_topology_group_t* group =
           iree_task_topology_get_group(topology, i);
       iree_host_size_t worker_local_memory_size =
-          iree_task_topology_group_local_memory_size(options, group);
+          iree_task_topology_group_local_memory_size(options, group,
+                                                     local_memory_alignment);
+      iree_task_affinity_set_t node_mask =
+          iree_task_topology_node_worker_mask(topology, group->node_id);
       iree_task_worker_t* worker = &executor->workers[i];
       status = iree_task_worker_initialize(
-          executor, i, group, options.worker_stack_size,
+          executor, i, group, &node_mask, options.worker_stack_size,
           iree_make_byte_span(worker_local_memory, worker_local_memory_size),
           &seed_prng, worker);
       worker_local_memory += worker_local_memory_size;
@@ -188,9 +242,11 @@ iree_status_t iree_task_executor_create(iree_task_executor_options_t options,
     }
 
     iree_atomic_task_affinity_set_store(&executor->worker_idle_mask,
-                                        worker_mask, iree_memory_order_release);
+                                        &worker_mask,
+                                        iree_memory_order_release);
     iree_atomic_task_affinity_set_store(&executor->worker_live_mask,
-                                        worker_mask, iree_memory_order_release);
+                                        &worker_mask,
+                                        iree_memory_order_release);
   }
 
   if (!iree_status_is_ok(status)) {
@@ -274,6 +330,27 @@ iree_host_size_t iree_task_executor_worker_count(
   return executor->worker_count;
 }
 
+void iree_task_executor_query_statistics(
+    iree_task_executor_t* executor,
+    iree_task_executor_statistics_t* out_statistics) {
+  memset(out_statistics, 0, sizeof(*out_statistics));
+  for (iree_host_size_t i = 0; i < executor->worker_count; ++i) {
+    iree_task_worker_t* worker = &executor->workers[i];
+    out_statistics->theft_count += (uint64_t)iree_atomic_load(
+        &worker->theft_count, iree_memory_order_relaxed);
+    out_statistics->idle_count += (uint64_t)iree_atomic_load(
+        &worker->idle_count, iree_memory_order_relaxed);
+    out_statistics->wake_count += (uint64_t)iree_atomic_load(
+        &worker->wake_count, iree_memory_order_relaxed);
+    out_statistics->spin_wake_count += (uint64_t)iree_atomic_load(
+        &worker->spin_wake_count, iree_memory_order_relaxed);
+    out_statistics->park_count += (uint64_t)iree_atomic_load(
+        &worker->park_count, iree_memory_order_relaxed);
+    out_statistics->spin_ns += (uint64_t)iree_atomic_load(
+        &worker->spin_ns, iree_memory_order_relaxed);
+  }
+}
+
 iree_event_pool_t* iree_task_executor_event_pool(
     iree_task_executor_t* executor) {
   return executor->event_pool;
@@ -303,10 +380,172 @@ static void iree_task_executor_relay_to_worker(
     iree_task_executor_t* executor, iree_task_post_batch_t* post_batch,
     iree_task_t* task) {
   iree_host_size_t worker_index =
-      iree_task_post_batch_select_worker(post_batch, task->affinity_set);
+      iree_task_post_batch_select_worker(post_batch, task->affinity);
   iree_task_post_batch_enqueue(post_batch, worker_index, task);
 }
 
+// Tries to issue |dispatch_task| for persistent execution by publishing it to a
+// free slot that workers will claim tiles from. Returns false if the executor
+// is not using persistent dispatches or all slots are in use, in which case the
+// dispatch must be sharded as normal.
+//
+// Only called during coordination and expects the coordinator lock to be held.
+static bool iree_task_executor_try_issue_persistent_dispatch(
+    iree_task_executor_t* executor, iree_task_dispatch_t* dispatch_task,
+    iree_task_submission_t* pending_submission,
+    iree_task_post_batch_t* post_batch) {
+  if (!iree_all_bits_set(executor->scheduling_mode,
+                         IREE_TASK_SCHEDULING_MODE_PERSISTENT_DISPATCH)) {
+    return false;
+  }
+
+  // Find a free slot. Only the coordinator publishes dispatches so a slot that
+  // has no references cannot be taken by anyone else while we fill it.
+  iree_task_executor_persistent_slot_t* slot = NULL;
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(executor->persistent_slots);
+       ++i) {
+    if (iree_atomic_load(&executor->persistent_slots[i].reference_count,
+                         iree_memory_order_acquire) == 0) {
+      slot = &executor->persistent_slots[i];
+      break;
+    }
+  }
+  if (!slot) return false;
+
+  // Dispatches with no tiles are retired immediately and never published.
+  if (!iree_task_dispatch_issue_persistent(dispatch_task, pending_submission)) {
+    return true;
+  }
+
+  // Publish the dispatch. The reference here is owned by the dispatch and is
+  // released by the worker completing its final tile.
+  slot->dispatch = dispatch_task;
+  iree_atomic_store(
+      &slot->affinity,
+      (int32_t)(((uint32_t)dispatch_task->header.affinity.worker_count << 16) |
+                dispatch_task->header.affinity.worker_start),
+      iree_memory_order_relaxed);
+  iree_atomic_store(&slot->reference_count, 1, iree_memory_order_release);
+  iree_atomic_store(&slot->claimable, 1, iree_memory_order_release);
+
+  // Pairs with the fence in iree_task_executor_has_persistent_dispatch: either
+  // we see the worker as idle and wake it or the worker sees the dispatch
+  // before it goes to sleep.
+  iree_atomic_thread_fence(iree_memory_order_seq_cst);
+
+  // Wake enough idle workers to cover the grid; workers that are already
+  // active will find the dispatch when they run out of their own work.
+  iree_task_post_batch_wake_idle_workers(
+      post_batch, dispatch_task->header.affinity,
+      iree_min(dispatch_task->tile_count, executor->worker_count));
+  return true;
+}
+
+// Releases a reference to |slot| held by a worker or the published dispatch.
+// If this was the last reference the dispatch is readied for retirement in
+// |pending_submission| and the slot becomes available for reuse.
+static void iree_task_executor_release_persistent_slot(
+    iree_task_executor_persistent_slot_t* slot,
+    iree_task_submission_t* pending_submission) {
+  // The dispatch must be read before releasing as the slot may be reused by
+  // the coordinator as soon as the reference count reaches zero.
+  iree_task_dispatch_t* dispatch_task = slot->dispatch;
+  if (iree_atomic_fetch_sub(&slot->reference_count, 1,
+                            iree_memory_order_acq_rel) == 1) {
+    // The dispatch was issued with IREE_TASK_FLAG_DISPATCH_RETIRE and will be
+    // retired by the coordinator just as when its last shard completes.
+    iree_task_submission_enqueue(pending_submission, &dispatch_task->header);
+  }
+}
+
+// Returns true if |slot| has a published dispatch with tiles that may still be
+// reserved by |worker|. This is only a hint: the dispatch may complete or be
+// replaced at any time unless a reference is held.
+static bool iree_task_executor_persistent_slot_is_claimable(
+    iree_task_executor_persistent_slot_t* slot, iree_task_worker_t* worker) {
+  if (!iree_atomic_load(&slot->claimable, iree_memory_order_acquire)) {
+    return false;
+  }
+  uint32_t packed_affinity =
+      (uint32_t)iree_atomic_load(&slot->affinity, iree_memory_order_relaxed);
+  iree_task_affinity_t affinity = {(uint16_t)(packed_affinity & 0xFFFFu),
+                                   (uint16_t)(packed_affinity >> 16)};
+  return iree_task_affinity_contains(affinity, worker->local_worker_index);
+}
+
+bool iree_task_executor_has_persistent_dispatch(iree_task_executor_t* executor,
+                                                iree_task_worker_t* worker) {
+  if (!iree_all_bits_set(executor->scheduling_mode,
+                         IREE_TASK_SCHEDULING_MODE_PERSISTENT_DISPATCH)) {
+    return false;
+  }
+  // Pairs with the fence in iree_task_executor_try_issue_persistent_dispatch.
+  iree_atomic_thread_fence(iree_memory_order_seq_cst);
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(executor->persistent_slots);
+       ++i) {
+    if (iree_task_executor_persistent_slot_is_claimable(
+            &executor->persistent_slots[i], worker)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool iree_task_executor_execute_persistent_dispatch(
+    iree_task_executor_t* executor, iree_task_worker_t* worker,
+    iree_task_submission_t* pending_submission) {
+  if (!iree_all_bits_set(executor->scheduling_mode,
+                         IREE_TASK_SCHEDULING_MODE_PERSISTENT_DISPATCH)) {
+    return false;
+  }
+
+  bool did_execute = false;
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(executor->persistent_slots);
+       ++i) {
+    iree_task_executor_persistent_slot_t* slot = &executor->persistent_slots[i];
+    if (!iree_task_executor_persistent_slot_is_claimable(slot, worker)) {
+      continue;
+    }
+
+    // Acquire a reference to keep the dispatch live while we execute it. If
+    // the count has already dropped to zero the dispatch has completed and the
+    // slot is waiting to be reused.
+    int32_t reference_count =
+        iree_atomic_load(&slot->reference_count, iree_memory_order_relaxed);
+    do {
+      if (reference_count <= 0) break;
+    } while (!iree_atomic_compare_exchange_weak(
+        &slot->reference_count, &reference_count, reference_count + 1,
+        iree_memory_order_acquire, iree_memory_order_relaxed));
+    if (reference_count <= 0) continue;
+
+    // The slot may have been reused since we checked it; the dispatch we now
+    // hold a reference to is whatever is currently published.
+    iree_task_dispatch_t* dispatch_task = slot->dispatch;
+    if (iree_atomic_load(&slot->claimable, iree_memory_order_acquire) &&
+        iree_task_affinity_contains(dispatch_task->header.affinity,
+                                    worker->local_worker_index)) {
+      bool completed = false;
+      did_execute |= iree_task_dispatch_execute_persistent(
+          dispatch_task, executor->worker_count, worker->processor_id,
+          worker->worker_index, worker->local_memory, pending_submission,
+          &completed);
+
+      // All tiles have been reserved so there's no sense in other workers
+      // continuing to look at the dispatch.
+      iree_atomic_store(&slot->claimable, 0, iree_memory_order_relaxed);
+
+      // Drop the reference owned by the dispatch once its tiles are done; the
+      // dispatch retires when the last worker still executing it leaves.
+      if (completed) {
+        iree_task_executor_release_persistent_slot(slot, pending_submission);
+      }
+    }
+    iree_task_executor_release_persistent_slot(slot, pending_submission);
+  }
+  return did_execute;
+}
+
 // Schedules all ready tasks in the |pending_submission| list.
 // Task may enqueue zero or more new tasks (or newly-ready/waiting tasks) to
 // |pending_submission| or queue work for posting to workers via the
@@ -336,6 +575,11 @@ void iree_task_executor_schedule_ready_tasks(
       continue;
     }
 
+    // Tasks default to any worker and are limited to the workers we have so
+    // that dispatches see the actual concurrency available to them.
+    task->affinity = iree_task_affinity_clamp(task->affinity,
+                                              executor->worker_count);
+
     switch (task->type) {
       case IREE_TASK_TYPE_NOP:
         // Doesn't do anything; just retire and continue on to any dependents.
@@ -377,7 +621,9 @@ void iree_task_executor_schedule_ready_tasks(
         if (task->flags & IREE_TASK_FLAG_DISPATCH_RETIRE) {
           iree_task_dispatch_retire((iree_task_dispatch_t*)task,
                                     pending_submission);
-        } else {
+        } else if (!iree_task_executor_try_issue_persistent_dispatch(
+                       executor, (iree_task_dispatch_t*)task,
+                       pending_submission, post_batch)) {
           iree_task_dispatch_issue((iree_task_dispatch_t*)task,
                                    &executor->transient_task_pool,
                                    pending_submission, post_batch);
@@ -512,32 +758,28 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
 
 static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
     iree_task_executor_t* executor, iree_task_affinity_set_t victim_mask,
-    uint32_t max_theft_attempts, int rotation_offset,
+    uint32_t max_theft_attempts, iree_host_size_t start_index,
     iree_task_queue_t* local_task_queue) {
-  if (!victim_mask) return NULL;
-  max_theft_attempts = iree_min(max_theft_attempts,
-                                iree_task_affinity_set_count_ones(victim_mask));
-  victim_mask = iree_task_affinity_set_rotr(victim_mask, rotation_offset);
-
-  int worker_index = rotation_offset;
-  iree_task_affinity_set_t mask =
-      iree_task_affinity_set_rotr(victim_mask, worker_index);
+  iree_host_size_t victim_index = start_index;
   for (uint32_t i = 0; i < max_theft_attempts; ++i) {
-    // Find the last set bit and skip to it. This avoids the need for doing
-    // a full O(n) scan and instead gets us at O(popcnt) * O(ctz).
+    // Find the next set bit at or after the last victim and skip to it,
+    // wrapping around to the start of the set once we run off the end. Each
+    // victim is cleared from the local mask once visited so we try each at
+    // most once. Empty words in the set are skipped without a per-bit scan so
+    // this is O(words + popcnt) instead of O(worker_count).
     //
-    // Example: sharing mask = 0b01010101
-    //          mask_rotation = 3 (randomly selected)
-    //          mask = 0b01010101 rotr 3 = 0b10101010
-    //          for (i = 0; i < 4; ++i)
-    //            offset = ctz(0b10101010) = 1
-    //            mask_rotation += 1 = 4
-    //            mask >>= 1 = 0b01010101
-    //            victim_index = 4 % 64 = 4
-    int offset = iree_task_affinity_set_count_trailing_zeros(mask);
-    int victim_index = (worker_index + offset) % executor->worker_count;
-    worker_index += offset + 1;
-    mask = iree_shr(mask, offset + 1);
+    // Example: victim_mask = 0b01010101
+    //          start_index = 3 (randomly selected)
+    //          i = 0: find_next(3) = 4
+    //          i = 1: find_next(4) = 6
+    //          i = 2: find_next(6) = NPOS -> find_first = 0
+    //          i = 3: find_next(0) = 2
+    victim_index = iree_task_affinity_set_find_next(&victim_mask, victim_index);
+    if (victim_index == IREE_TASK_AFFINITY_SET_NPOS) {
+      victim_index = iree_task_affinity_set_find_first(&victim_mask);
+      if (victim_index == IREE_TASK_AFFINITY_SET_NPOS) break;
+    }
+    iree_task_affinity_set_erase(&victim_mask, victim_index);
     iree_task_worker_t* victim_worker = &executor->workers[victim_index];
     if (iree_atomic_load(&victim_worker->state, iree_memory_order_acquire) !=
         IREE_TASK_WORKER_STATE_RUNNING) {
@@ -552,7 +794,7 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
     // lead to a relatively even distribution.
     iree_task_t* task = iree_task_worker_try_steal_task(
         victim_worker, local_task_queue,
-        /*max_tasks=*/IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT);
+        /*max_tasks=*/executor->max_theft_task_count);
     if (task) return task;
   }
 
@@ -560,6 +802,22 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
   return NULL;
 }
 
+void iree_task_executor_partition_theft_victims(
+    const iree_task_affinity_set_t* victim_mask,
+    const iree_task_affinity_set_t* constructive_sharing_mask,
+    const iree_task_affinity_set_t* node_mask,
+    iree_task_affinity_set_t
+        out_tier_masks[IREE_TASK_EXECUTOR_THEFT_TIER_COUNT]) {
+  out_tier_masks[IREE_TASK_EXECUTOR_THEFT_TIER_SHARED_CACHE] =
+      iree_task_affinity_set_and(victim_mask, constructive_sharing_mask);
+  iree_task_affinity_set_t remaining_mask =
+      iree_task_affinity_set_and_not(victim_mask, constructive_sharing_mask);
+  out_tier_masks[IREE_TASK_EXECUTOR_THEFT_TIER_NODE] =
+      iree_task_affinity_set_and(&remaining_mask, node_mask);
+  out_tier_masks[IREE_TASK_EXECUTOR_THEFT_TIER_REMOTE] =
+      iree_task_affinity_set_and_not(&remaining_mask, node_mask);
+}
+
 // Tries to steal an entire task from a sibling worker (based on topology).
 // Returns a task that is available (has not yet begun processing at all).
 // May steal multiple tasks and add them to the |local_task_queue|.
@@ -567,7 +825,11 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
 // We do a scan through ideal victims indicated by the
 // |constructive_sharing_mask|; these are the workers most likely to have some
 // cache benefits to taking their work as they share some level of the cache
-// hierarchy and should be better to steal from than any random worker.
+// hierarchy and should be better to steal from than any random worker. After
+// that we exhaust the other workers on the same NUMA node in |node_mask| before
+// crossing the interconnect to steal from workers on remote nodes: the tasks
+// stolen from a remote worker likely reference memory local to that worker's
+// node and running them here will pay remote access costs for their duration.
 //
 // To prevent biasing any particular victim we use a fast prng function to
 // select where in the set of potential victims defined by the topology
@@ -576,12 +838,12 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
 // our search and then go in-order.
 iree_task_t* iree_task_executor_try_steal_task(
     iree_task_executor_t* executor,
-    iree_task_affinity_set_t constructive_sharing_mask,
-    uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
+    const iree_task_affinity_set_t* constructive_sharing_mask,
+    const iree_task_affinity_set_t* node_mask, uint32_t max_theft_attempts,
+    iree_prng_minilcg128_state_t* theft_prng,
     iree_task_queue_t* local_task_queue) {
-  IREE_TRACE_ZONE_BEGIN(z0);
-
   // The masks are accessed with 'relaxed' order because they are just hints.
+  // Only words of the sets that have any bits set are loaded.
   iree_task_affinity_set_t worker_live_mask =
       iree_atomic_task_affinity_set_load(&executor->worker_live_mask,
                                          iree_memory_order_relaxed);
@@ -590,31 +852,44 @@ iree_task_t* iree_task_executor_try_steal_task(
                                          iree_memory_order_relaxed);
   // Limit the workers we will steal from to the ones that are currently live
   // and not idle.
-  iree_task_affinity_set_t victim_mask = worker_live_mask & ~worker_idle_mask;
+  iree_task_affinity_set_t victim_mask =
+      iree_task_affinity_set_and_not(&worker_live_mask, &worker_idle_mask);
+  if (iree_task_affinity_set_is_empty(&victim_mask)) return NULL;
+
+  IREE_TRACE_ZONE_BEGIN(z0);
 
   // TODO(benvanik): it may be possible to rework this such that we better
   // use the prng; for example, instead of all this rotating stuff we could just
   // generate an 8-bit number (or even split it into two 4-bit numbers) per
   // theft attempt. The current rotation strategy is biased toward the same try
   // ordering vs. what we may really want with an unbiased random selection.
-  int rotation_offset = iree_prng_minilcg128_next_uint8(theft_prng) &
-                        (8 * sizeof(iree_task_affinity_set_t) - 1);
+  iree_host_size_t start_index =
+      (((iree_host_size_t)iree_prng_minilcg128_next_uint8(theft_prng) << 8) |
+       iree_prng_minilcg128_next_uint8(theft_prng)) %
+      executor->worker_count;
 
   // Try first with the workers we may have some caches shared with. This
   // helps to prevent cache invalidations/availability updates as it's likely
   // that we won't need to go back to main memory (or higher cache tiers) in the
   // event that the thief and victim are running close to each other in time.
-  iree_task_t* task = iree_task_executor_try_steal_task_from_affinity_set(
-      executor, victim_mask & constructive_sharing_mask, max_theft_attempts,
-      rotation_offset, local_task_queue);
-  if (task) {
-    IREE_TRACE_ZONE_APPEND_TEXT(z0, "local");
-  } else {
+  // Then try the remaining workers on the same NUMA node and only once the
+  // node has been exhausted do we cross to remote nodes. When all workers
+  // reside on the same node the remote set is empty.
+  iree_task_affinity_set_t tier_masks[IREE_TASK_EXECUTOR_THEFT_TIER_COUNT];
+  iree_task_executor_partition_theft_victims(
+      &victim_mask, constructive_sharing_mask, node_mask, tier_masks);
+  iree_task_t* task = NULL;
+  for (int tier = 0; tier < IREE_TASK_EXECUTOR_THEFT_TIER_COUNT; ++tier) {
+    if (iree_task_affinity_set_is_empty(&tier_masks[tier])) continue;
     task = iree_task_executor_try_steal_task_from_affinity_set(
-        executor, victim_mask & ~constructive_sharing_mask, max_theft_attempts,
-        rotation_offset, local_task_queue);
+        executor, tier_masks[tier], max_theft_attempts, start_index,
+        local_task_queue);
     if (task) {
-      IREE_TRACE_ZONE_APPEND_TEXT(z0, "non-local");
+      IREE_TRACE_ZONE_APPEND_TEXT(
+          z0, tier == IREE_TASK_EXECUTOR_THEFT_TIER_SHARED_CACHE ? "local"
+              : tier == IREE_TASK_EXECUTOR_THEFT_TIER_NODE       ? "node"
+                                                                 : "remote");
+      break;
     }
   }
 
@@ -265,6 +265,16 @@ enum iree_task_scheduling_mode_bits_t {
   // reach peak utilization or artificially limiting which tasks we allow
   // through to keep certain CPU cores asleep unless absolutely required.
   IREE_TASK_SCHEDULING_MODE_RESERVED = 0u,
+
+  // Executes dispatches without forking them into shard tasks. Issued
+  // dispatches are published to the executor and workers that run out of
+  // other work claim ranges of tiles directly from them, sizing each range
+  // based on the observed per-tile cost. This avoids the shard allocation,
+  // enqueue, and wake overheads that dominate short dispatches at the cost of
+  // workers polling the published dispatches when looking for work. Most
+  // effective when combined with a non-zero worker_spin_ns so that workers are
+  // still awake when the next dispatch is issued.
+  IREE_TASK_SCHEDULING_MODE_PERSISTENT_DISPATCH = 1u << 0,
 };
 typedef uint32_t iree_task_scheduling_mode_t;
 
@@ -286,8 +296,21 @@ typedef struct iree_task_executor_options_t {
   // spinning is often extremely harmful to system health. Only set to non-zero
   // values when latency is the #1 priority (over thermals, system-wide
   // scheduling, and the environment).
+  //
+  // Spinning happens between a worker running out of work and parking itself
+  // in the kernel. Work posted to a spinning worker is picked up without a
+  // syscall on either side while work posted to a parked worker requires a
+  // futex wake and a scheduler hop before the worker can run.
   iree_duration_t worker_spin_ns;
 
+  // Adapts the duration each worker spins to how long it usually waits for
+  // work, bounded by worker_spin_ns. Workers that are woken quickly spin for
+  // about twice as long as their recent waits while workers that would have
+  // had to spin longer than worker_spin_ns stop spinning and park immediately
+  // until their waits shorten again. This avoids burning CPU during long idle
+  // periods without giving up the low wake latency of back-to-back work.
+  bool worker_spin_adaptive;
+
   // Minimum size in bytes of each worker thread stack.
   // The underlying platform may allocate more stack space but _should_
   // guarantee that the available stack space is near this amount. Note that the
@@ -336,6 +359,30 @@ void iree_task_executor_trim(iree_task_executor_t* executor);
 iree_host_size_t iree_task_executor_worker_count(
     iree_task_executor_t* executor);
 
+// Cumulative scheduling statistics of an executor.
+// Counters are maintained by each worker and only ever increase. They are
+// intended for comparing scheduling behavior across configurations and are
+// read without synchronization so a snapshot may be slightly stale.
+typedef struct iree_task_executor_statistics_t {
+  // Number of times a worker successfully stole tasks from another worker.
+  uint64_t theft_count;
+  // Number of times a worker ran out of work and marked itself idle.
+  uint64_t idle_count;
+  // Number of times a worker went to sleep waiting for work and was woken.
+  uint64_t wake_count;
+  // Number of waits satisfied while the worker was spinning.
+  uint64_t spin_wake_count;
+  // Number of waits where the worker parked itself in the kernel.
+  uint64_t park_count;
+  // Total time in nanoseconds workers spent spinning waiting for work.
+  uint64_t spin_ns;
+} iree_task_executor_statistics_t;
+
+// Queries the cumulative scheduling statistics of all workers in |executor|.
+void iree_task_executor_query_statistics(
+    iree_task_executor_t* executor,
+    iree_task_executor_statistics_t* out_statistics);
+
 // Returns an iree_event_t pool managed by the executor.
 // Users of the task system should acquire their transient events from this.
 // Long-lived events should be allocated on their own in order to avoid
@@ -0,0 +1,464 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/task/executor.h"
+#include "iree/task/scope.h"
+#include "iree/task/submission.h"
+#include "iree/task/task.h"
+#include "iree/task/topology.h"
+#include "iree/testing/benchmark.h"
+
+// Number of tiles each worker is given per dispatch. Enough that shards have to
+// go back to the grid a few times and idle workers have something to steal.
+#define IREE_TASK_EXECUTOR_BENCHMARK_TILES_PER_WORKER 32
+
+// Number of independent dispatches submitted together by the dispatch-heavy
+// benchmarks.
+#define IREE_TASK_EXECUTOR_BENCHMARK_DISPATCH_COUNT 64
+
+// Number of workers and tiles used by the tiny dispatch benchmarks.
+#define IREE_TASK_EXECUTOR_BENCHMARK_TINY_WORKER_COUNT 8
+#define IREE_TASK_EXECUTOR_BENCHMARK_TINY_TILE_COUNT 16
+
+typedef struct iree_task_executor_benchmark_t {
+  iree_task_executor_t* executor;
+  iree_task_scope_t scope;
+  iree_atomic_int64_t tile_counter;
+} iree_task_executor_benchmark_t;
+
+// Spin configuration used by the wake latency benchmarks.
+typedef struct iree_task_executor_benchmark_spin_config_t {
+  // Maximum duration workers spin before parking.
+  iree_duration_t worker_spin_ns;
+  // Whether workers adapt their spin duration to their recent waits.
+  bool worker_spin_adaptive;
+  // Duration the submitting thread is busy between dispatches.
+  iree_duration_t gap_ns;
+} iree_task_executor_benchmark_spin_config_t;
+
+// Creates an executor with |worker_count| unpinned workers using |options|.
+static void iree_task_executor_benchmark_initialize_with_options(
+    iree_host_size_t worker_count, iree_task_executor_options_t options,
+    iree_allocator_t host_allocator,
+    iree_task_executor_benchmark_t* out_benchmark) {
+  memset(out_benchmark, 0, sizeof(*out_benchmark));
+  options.worker_local_memory_size = 4 * 1024;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(worker_count, &topology);
+  IREE_CHECK_OK(iree_task_executor_create(options, &topology, host_allocator,
+                                          &out_benchmark->executor));
+  iree_task_topology_deinitialize(&topology);
+  iree_task_scope_initialize(iree_make_cstring_view("benchmark"),
+                             IREE_TASK_SCOPE_FLAG_NONE, &out_benchmark->scope);
+}
+
+// Creates an executor with |worker_count| unpinned workers using the given
+// |scheduling_mode|.
+static void iree_task_executor_benchmark_initialize(
+    iree_host_size_t worker_count, iree_task_scheduling_mode_t scheduling_mode,
+    iree_allocator_t host_allocator,
+    iree_task_executor_benchmark_t* out_benchmark) {
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.scheduling_mode = scheduling_mode;
+  iree_task_executor_benchmark_initialize_with_options(
+      worker_count, options, host_allocator, out_benchmark);
+}
+
+static void iree_task_executor_benchmark_deinitialize(
+    iree_task_executor_benchmark_t* benchmark) {
+  iree_task_scope_deinitialize(&benchmark->scope);
+  iree_task_executor_release(benchmark->executor);
+}
+
+static iree_status_t iree_task_executor_benchmark_tile(
+    void* user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  iree_task_executor_benchmark_t* benchmark =
+      (iree_task_executor_benchmark_t*)user_context;
+  iree_atomic_fetch_add(&benchmark->tile_counter, 1, iree_memory_order_relaxed);
+  return iree_ok_status();
+}
+
+// Tile with uneven cost: every 8th tile does 16x the work of the others so that
+// workers finish their shards at different times and have to steal.
+static iree_status_t iree_task_executor_benchmark_imbalanced_tile(
+    void* user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  iree_task_executor_benchmark_t* benchmark =
+      (iree_task_executor_benchmark_t*)user_context;
+  uint32_t iteration_count =
+      (tile_context->workgroup_xyz[0] % 8) == 0 ? 16 * 256 : 256;
+  uint64_t value = tile_context->workgroup_xyz[0];
+  for (uint32_t i = 0; i < iteration_count; ++i) {
+    value = value * 6364136223846793005ull + 1442695040888963407ull;
+  }
+  iree_benchmark_use_ptr((char const volatile*)&value);
+  iree_atomic_fetch_add(&benchmark->tile_counter, 1, iree_memory_order_relaxed);
+  return iree_ok_status();
+}
+
+// Submits IREE_TASK_EXECUTOR_BENCHMARK_DISPATCH_COUNT independent dispatches of
+// |tile_count| imbalanced tiles each and waits for them all to retire.
+static void iree_task_executor_benchmark_dispatch_many(
+    iree_task_executor_benchmark_t* benchmark, uint32_t tile_count) {
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {tile_count, 1, 1};
+  iree_task_fence_t* fence = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(benchmark->executor,
+                                                 &benchmark->scope, &fence));
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_dispatch_t
+      dispatch_tasks[IREE_TASK_EXECUTOR_BENCHMARK_DISPATCH_COUNT];
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(dispatch_tasks); ++i) {
+    iree_task_dispatch_initialize(
+        &benchmark->scope,
+        iree_task_make_dispatch_closure(
+            iree_task_executor_benchmark_imbalanced_tile, benchmark),
+        workgroup_size, workgroup_count, &dispatch_tasks[i]);
+    iree_task_set_completion_task(&dispatch_tasks[i].header, &fence->header);
+    iree_task_submission_enqueue(&submission, &dispatch_tasks[i].header);
+  }
+  iree_task_executor_submit(benchmark->executor, &submission);
+  iree_task_executor_flush(benchmark->executor);
+  IREE_CHECK_OK(
+      iree_task_scope_wait_idle(&benchmark->scope, IREE_TIME_INFINITE_FUTURE));
+}
+
+// Labels |benchmark_state| with the per-iteration scheduling statistics
+// accumulated between |begin| and |end|.
+static void iree_task_executor_benchmark_set_statistics_label(
+    iree_benchmark_state_t* benchmark_state, int64_t iteration_count,
+    const iree_task_executor_statistics_t* begin,
+    const iree_task_executor_statistics_t* end) {
+  if (iteration_count <= 0) return;
+  char label[128];
+  snprintf(label, sizeof(label),
+           "thefts/iter=%.1f idles/iter=%.1f wakes/iter=%.1f",
+           (double)(end->theft_count - begin->theft_count) / iteration_count,
+           (double)(end->idle_count - begin->idle_count) / iteration_count,
+           (double)(end->wake_count - begin->wake_count) / iteration_count);
+  iree_benchmark_set_label(benchmark_state, label);
+}
+
+// Submits a single dispatch of |tile_count| tiles and waits for it to retire.
+static void iree_task_executor_benchmark_dispatch(
+    iree_task_executor_benchmark_t* benchmark, uint32_t tile_count) {
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {tile_count, 1, 1};
+  iree_task_dispatch_t dispatch_task;
+  iree_task_dispatch_initialize(
+      &benchmark->scope,
+      iree_task_make_dispatch_closure(iree_task_executor_benchmark_tile,
+                                      benchmark),
+      workgroup_size, workgroup_count, &dispatch_task);
+
+  iree_task_fence_t* fence = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(benchmark->executor,
+                                                 &benchmark->scope, &fence));
+  iree_task_set_completion_task(&dispatch_task.header, &fence->header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &dispatch_task.header);
+  iree_task_executor_submit(benchmark->executor, &submission);
+  iree_task_executor_flush(benchmark->executor);
+  IREE_CHECK_OK(
+      iree_task_scope_wait_idle(&benchmark->scope, IREE_TIME_INFINITE_FUTURE));
+}
+
+// Measures the round-trip time of a dispatch fanned out across all workers.
+// This covers waking workers from the idle mask, posting shards to each worker,
+// and workers stealing from each other as they drain the grid.
+//
+// user_data is the number of workers in the executor.
+static iree_status_t iree_task_executor_benchmark_dispatch_n(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_host_size_t worker_count =
+      (iree_host_size_t)(uintptr_t)benchmark_def->user_data;
+  if (worker_count > IREE_TASK_EXECUTOR_MAX_WORKER_COUNT) {
+    iree_benchmark_skip(benchmark_state,
+                        "worker count exceeds "
+                        "IREE_TASK_EXECUTOR_MAX_WORKER_COUNT");
+    return iree_ok_status();
+  }
+
+  iree_task_executor_benchmark_t benchmark;
+  iree_task_executor_benchmark_initialize(
+      worker_count, IREE_TASK_SCHEDULING_MODE_RESERVED,
+      benchmark_state->host_allocator, &benchmark);
+
+  // Warm up so that thread creation isn't measured.
+  uint32_t tile_count =
+      (uint32_t)worker_count * IREE_TASK_EXECUTOR_BENCHMARK_TILES_PER_WORKER;
+  iree_task_executor_benchmark_dispatch(&benchmark, tile_count);
+
+  iree_task_executor_statistics_t begin_statistics;
+  iree_task_executor_query_statistics(benchmark.executor, &begin_statistics);
+  int64_t iteration_count = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_task_executor_benchmark_dispatch(&benchmark, tile_count);
+    ++iteration_count;
+  }
+  iree_task_executor_statistics_t end_statistics;
+  iree_task_executor_query_statistics(benchmark.executor, &end_statistics);
+  iree_task_executor_benchmark_set_statistics_label(
+      benchmark_state, iteration_count, &begin_statistics, &end_statistics);
+  iree_benchmark_set_items_processed(
+      benchmark_state, iree_atomic_load(&benchmark.tile_counter,
+                                        iree_memory_order_relaxed));
+
+  iree_task_executor_benchmark_deinitialize(&benchmark);
+  return iree_ok_status();
+}
+
+// Measures the round-trip time of a tiny dispatch with only a few tiles per
+// worker. Per-dispatch overheads (shard allocation, posting, waking) dominate
+// and this is the case persistent dispatches are intended to improve.
+//
+// user_data is the iree_task_scheduling_mode_t of the executor.
+static iree_status_t iree_task_executor_benchmark_dispatch_tiny(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_task_scheduling_mode_t scheduling_mode =
+      (iree_task_scheduling_mode_t)(uintptr_t)benchmark_def->user_data;
+
+  iree_task_executor_benchmark_t benchmark;
+  iree_task_executor_benchmark_initialize(
+      IREE_TASK_EXECUTOR_BENCHMARK_TINY_WORKER_COUNT, scheduling_mode,
+      benchmark_state->host_allocator, &benchmark);
+
+  // Warm up so that thread creation isn't measured.
+  iree_task_executor_benchmark_dispatch(
+      &benchmark, IREE_TASK_EXECUTOR_BENCHMARK_TINY_TILE_COUNT);
+
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_task_executor_benchmark_dispatch(
+        &benchmark, IREE_TASK_EXECUTOR_BENCHMARK_TINY_TILE_COUNT);
+  }
+  iree_benchmark_set_items_processed(
+      benchmark_state, iree_atomic_load(&benchmark.tile_counter,
+                                        iree_memory_order_relaxed));
+
+  iree_task_executor_benchmark_deinitialize(&benchmark);
+  return iree_ok_status();
+}
+
+// Measures many independent dispatches with imbalanced tiles in flight at once.
+// This stresses the worker queues and theft far more than a single dispatch:
+// workers are flooded with shards from all dispatches and the uneven tile cost
+// leaves some idle while others still have a backlog.
+//
+// user_data is the number of workers in the executor.
+static iree_status_t iree_task_executor_benchmark_dispatch_heavy_n(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_host_size_t worker_count =
+      (iree_host_size_t)(uintptr_t)benchmark_def->user_data;
+  if (worker_count > IREE_TASK_EXECUTOR_MAX_WORKER_COUNT) {
+    iree_benchmark_skip(benchmark_state,
+                        "worker count exceeds "
+                        "IREE_TASK_EXECUTOR_MAX_WORKER_COUNT");
+    return iree_ok_status();
+  }
+
+  iree_task_executor_benchmark_t benchmark;
+  iree_task_executor_benchmark_initialize(
+      worker_count, IREE_TASK_SCHEDULING_MODE_RESERVED,
+      benchmark_state->host_allocator, &benchmark);
+
+  // Warm up so that thread creation isn't measured.
+  uint32_t tile_count = (uint32_t)worker_count * 4;
+  iree_task_executor_benchmark_dispatch_many(&benchmark, tile_count);
+
+  iree_task_executor_statistics_t begin_statistics;
+  iree_task_executor_query_statistics(benchmark.executor, &begin_statistics);
+  int64_t iteration_count = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_task_executor_benchmark_dispatch_many(&benchmark, tile_count);
+    ++iteration_count;
+  }
+  iree_task_executor_statistics_t end_statistics;
+  iree_task_executor_query_statistics(benchmark.executor, &end_statistics);
+  iree_task_executor_benchmark_set_statistics_label(
+      benchmark_state, iteration_count, &begin_statistics, &end_statistics);
+  iree_benchmark_set_items_processed(
+      benchmark_state, iree_atomic_load(&benchmark.tile_counter,
+                                        iree_memory_order_relaxed));
+
+  iree_task_executor_benchmark_deinitialize(&benchmark);
+  return iree_ok_status();
+}
+
+// Measures tiny dispatches issued with a gap between each so that workers go
+// idle between dispatches, as with a host thread doing some work between
+// kernels. Compares wall time (wake latency) against process CPU time (cost of
+// spinning) for different worker spin configurations.
+//
+// user_data is an iree_task_executor_benchmark_spin_config_t.
+static iree_status_t iree_task_executor_benchmark_dispatch_spin(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_task_executor_benchmark_spin_config_t* config =
+      (const iree_task_executor_benchmark_spin_config_t*)
+          benchmark_def->user_data;
+
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.worker_spin_ns = config->worker_spin_ns;
+  options.worker_spin_adaptive = config->worker_spin_adaptive;
+  iree_task_executor_benchmark_t benchmark;
+  iree_task_executor_benchmark_initialize_with_options(
+      IREE_TASK_EXECUTOR_BENCHMARK_TINY_WORKER_COUNT, options,
+      benchmark_state->host_allocator, &benchmark);
+
+  // Warm up so that thread creation isn't measured.
+  iree_task_executor_benchmark_dispatch(
+      &benchmark, IREE_TASK_EXECUTOR_BENCHMARK_TINY_TILE_COUNT);
+
+  iree_task_executor_statistics_t begin_statistics;
+  iree_task_executor_query_statistics(benchmark.executor, &begin_statistics);
+  int64_t iteration_count = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    // Busy the submitting thread instead of sleeping so that the gap is
+    // precise and the thread isn't itself paying a wake latency.
+    iree_time_t gap_end_ns = iree_time_now() + config->gap_ns;
+    while (iree_time_now() < gap_end_ns) {
+    }
+    iree_task_executor_benchmark_dispatch(
+        &benchmark, IREE_TASK_EXECUTOR_BENCHMARK_TINY_TILE_COUNT);
+    ++iteration_count;
+  }
+  iree_task_executor_statistics_t end_statistics;
+  iree_task_executor_query_statistics(benchmark.executor, &end_statistics);
+  if (iteration_count > 0) {
+    char label[128];
+    snprintf(label, sizeof(label),
+             "spins/iter=%.1f parks/iter=%.1f spin_us/iter=%.1f",
+             (double)(end_statistics.spin_wake_count -
+                      begin_statistics.spin_wake_count) /
+                 iteration_count,
+             (double)(end_statistics.park_count - begin_statistics.park_count) /
+                 iteration_count,
+             (double)(end_statistics.spin_ns - begin_statistics.spin_ns) /
+                 1000.0 / iteration_count);
+    iree_benchmark_set_label(benchmark_state, label);
+  }
+  iree_benchmark_set_items_processed(
+      benchmark_state, iree_atomic_load(&benchmark.tile_counter,
+                                        iree_memory_order_relaxed));
+
+  iree_task_executor_benchmark_deinitialize(&benchmark);
+  return iree_ok_status();
+}
+
+int main(int argc, char** argv) {
+  iree_benchmark_initialize(&argc, argv);
+
+  // iree_task_executor_benchmark_dispatch_n
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_task_executor_benchmark_dispatch_n,
+    };
+    benchmark_def.user_data = (void*)64u;
+    iree_benchmark_register(iree_make_cstring_view("dispatch_64_workers"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)128u;
+    iree_benchmark_register(iree_make_cstring_view("dispatch_128_workers"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)256u;
+    iree_benchmark_register(iree_make_cstring_view("dispatch_256_workers"),
+                            &benchmark_def);
+  }
+
+  // iree_task_executor_benchmark_dispatch_heavy_n
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_task_executor_benchmark_dispatch_heavy_n,
+    };
+    benchmark_def.user_data = (void*)8u;
+    iree_benchmark_register(iree_make_cstring_view("dispatch_heavy_8_workers"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)64u;
+    iree_benchmark_register(iree_make_cstring_view("dispatch_heavy_64_workers"),
+                            &benchmark_def);
+  }
+
+  // iree_task_executor_benchmark_dispatch_tiny
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_task_executor_benchmark_dispatch_tiny,
+    };
+    benchmark_def.user_data =
+        (void*)(uintptr_t)IREE_TASK_SCHEDULING_MODE_RESERVED;
+    iree_benchmark_register(iree_make_cstring_view("dispatch_tiny_sharded"),
+                            &benchmark_def);
+    benchmark_def.user_data =
+        (void*)(uintptr_t)IREE_TASK_SCHEDULING_MODE_PERSISTENT_DISPATCH;
+    iree_benchmark_register(iree_make_cstring_view("dispatch_tiny_persistent"),
+                            &benchmark_def);
+  }
+
+  // iree_task_executor_benchmark_dispatch_spin
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_task_executor_benchmark_dispatch_spin,
+    };
+    static const iree_task_executor_benchmark_spin_config_t configs[] = {
+        {0, false, 20 * 1000},
+        {5 * 1000, false, 20 * 1000},
+        {50 * 1000, false, 20 * 1000},
+        {50 * 1000, true, 20 * 1000},
+        {50 * 1000, false, 200 * 1000},
+        {50 * 1000, true, 200 * 1000},
+    };
+    static const char* names[] = {
+        "dispatch_spin_0us_gap_20us",
+        "dispatch_spin_5us_gap_20us",
+        "dispatch_spin_50us_gap_20us",
+        "dispatch_spin_adaptive_50us_gap_20us",
+        "dispatch_spin_50us_gap_200us",
+        "dispatch_spin_adaptive_50us_gap_200us",
+    };
+    for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(configs); ++i) {
+      benchmark_def.user_data = (void*)&configs[i];
+      iree_benchmark_register(iree_make_cstring_view(names[i]),
+                              &benchmark_def);
+    }
+  }
+
+  iree_benchmark_run_specified();
+  return 0;
+}
@@ -4,7 +4,9 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <cinttypes>
 #include <cstddef>
+#include <cstdio>
 
 #include "iree/base/internal/prng.h"
 #include "iree/task/executor.h"
@@ -163,6 +165,15 @@ extern "C" int main(int argc, char* argv[]) {
 
   IREE_CHECK_OK(iree_task_scope_wait_idle(&scope_a, IREE_TIME_INFINITE_FUTURE));
 
+  // Dump scheduling statistics so that scheduler changes can be compared.
+  iree_task_executor_statistics_t statistics;
+  iree_task_executor_query_statistics(executor, &statistics);
+  fprintf(stdout, "thefts: %" PRIu64 "\n", statistics.theft_count);
+  fprintf(stdout, "idles:  %" PRIu64 "\n", statistics.idle_count);
+  fprintf(stdout, "wakes:  %" PRIu64 "\n", statistics.wake_count);
+  fprintf(stdout, "spins:  %" PRIu64 "\n", statistics.spin_wake_count);
+  fprintf(stdout, "parks:  %" PRIu64 "\n", statistics.park_count);
+
   iree_task_scope_deinitialize(&scope_a);
   iree_task_executor_release(executor);
   IREE_TRACE_APP_EXIT(0);
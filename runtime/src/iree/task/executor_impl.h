@@ -25,6 +25,27 @@
 extern "C" {
 #endif  // __cplusplus
 
+// A dispatch published by the coordinator for persistent execution.
+// See IREE_TASK_SCHEDULING_MODE_PERSISTENT_DISPATCH.
+//
+// The dispatch holds one reference on the slot until its final tile completes
+// and each worker executing tiles holds one while doing so. The worker that
+// releases the last reference readies the dispatch for retirement and the slot
+// can then be reused by the coordinator.
+typedef struct iree_task_executor_persistent_slot_t {
+  // Nonzero while the published dispatch may still have tiles to reserve.
+  // Workers looking for work poll this without holding a reference.
+  iree_atomic_int32_t claimable;
+  // Worker range of the published dispatch affinity packed as
+  // (worker_count << 16) | worker_start so that workers can skip dispatches
+  // they are not allowed to execute without holding a reference.
+  iree_atomic_int32_t affinity;
+  // Number of outstanding references on the slot; 0 when the slot is free.
+  iree_atomic_int32_t reference_count;
+  // Dispatch published in the slot. Only valid while holding a reference.
+  iree_task_dispatch_t* dispatch;
+} iree_task_executor_persistent_slot_t;
+
 struct iree_task_executor_t {
   iree_atomic_ref_count_t ref_count;
   iree_allocator_t allocator;
@@ -42,6 +63,14 @@ struct iree_task_executor_t {
   // IREE_DURATION_ZERO is used to disable spinning.
   iree_duration_t worker_spin_ns;
 
+  // Whether workers adapt their spin duration (up to worker_spin_ns) based on
+  // how long they have recently waited for work.
+  bool worker_spin_adaptive;
+
+  // Maximum number of tasks stolen from a victim worker at a time. Derived
+  // from the worker count and IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT.
+  iree_host_size_t max_theft_task_count;
+
   // State used by the work-stealing operations performed by donated threads.
   // This is **NOT SYNCHRONIZED** and relies on the fact that we actually don't
   // much care about the precise selection of workers enough to mind any tears
@@ -50,6 +79,11 @@ struct iree_task_executor_t {
   // extra layer of PRNG anyway ;)
   iree_prng_minilcg128_state_t donation_theft_prng;
 
+  // Dispatches published for workers to execute without sharding.
+  // Only used with IREE_TASK_SCHEDULING_MODE_PERSISTENT_DISPATCH.
+  iree_task_executor_persistent_slot_t
+      persistent_slots[IREE_TASK_EXECUTOR_PERSISTENT_DISPATCH_SLOT_COUNT];
+
   // Pools of transient dispatch tasks shared across all workers.
   // Depending on configuration the task pool may allocate after creation using
   // the allocator provided upon executor creation.
@@ -104,7 +138,9 @@ struct iree_task_executor_t {
   // an authoritative answer to the question "is this worker live" is to
   // atomically query worker->state. This mask is for usage patterns where one
   // needs a cheap (single relaxed atomic op) approximation of all N workers'
-  // live state without having to perform N expensive atomic ops.
+  // live state without having to perform N expensive atomic ops. With more
+  // than 64 workers the summary word of the set lets readers skip over words
+  // that have no workers live.
   iree_atomic_task_affinity_set_t worker_live_mask;
 
   // A bitset indicating which workers are currently idle. Used to bias incoming
@@ -154,13 +190,52 @@ void iree_task_executor_schedule_ready_tasks(
 void iree_task_executor_coordinate(iree_task_executor_t* executor,
                                    iree_task_worker_t* current_worker);
 
+// Returns true if any persistent dispatch may still have tiles that |worker|
+// could execute. Used by workers before going to sleep to avoid missing
+// dispatches published while they were preparing to wait.
+bool iree_task_executor_has_persistent_dispatch(iree_task_executor_t* executor,
+                                                iree_task_worker_t* worker);
+
+// Executes tiles from any published persistent dispatch on |worker|.
+// Returns true if any tiles were executed. Dispatches completed by the worker
+// are added to |pending_submission| to be retired.
+bool iree_task_executor_execute_persistent_dispatch(
+    iree_task_executor_t* executor, iree_task_worker_t* worker,
+    iree_task_submission_t* pending_submission);
+
+// Sets of theft victims in the order a thief tries them.
+typedef enum iree_task_executor_theft_tier_e {
+  // Workers sharing some level of the cache hierarchy with the thief.
+  IREE_TASK_EXECUTOR_THEFT_TIER_SHARED_CACHE = 0,
+  // Remaining workers on the same NUMA node as the thief.
+  IREE_TASK_EXECUTOR_THEFT_TIER_NODE,
+  // Workers on remote NUMA nodes.
+  IREE_TASK_EXECUTOR_THEFT_TIER_REMOTE,
+  IREE_TASK_EXECUTOR_THEFT_TIER_COUNT,
+} iree_task_executor_theft_tier_t;
+
+// Partitions |victim_mask| into disjoint per-tier sets of workers: those in
+// |constructive_sharing_mask|, the others in |node_mask|, and all the rest.
+void iree_task_executor_partition_theft_victims(
+    const iree_task_affinity_set_t* victim_mask,
+    const iree_task_affinity_set_t* constructive_sharing_mask,
+    const iree_task_affinity_set_t* node_mask,
+    iree_task_affinity_set_t
+        out_tier_masks[IREE_TASK_EXECUTOR_THEFT_TIER_COUNT]);
+
 // Tries to steal an entire task from a sibling worker (based on topology).
 // Returns a task that is available (has not yet begun processing at all).
 // May steal multiple tasks and add them to the |local_task_queue|.
+//
+// Victims are tried in order of distance from the thief: first those in
+// |constructive_sharing_mask|, then others on the same NUMA node as indicated
+// by |node_mask|, and only then workers on remote nodes. See
+// iree_task_executor_partition_theft_victims.
 iree_task_t* iree_task_executor_try_steal_task(
     iree_task_executor_t* executor,
-    iree_task_affinity_set_t constructive_sharing_mask,
-    uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
+    const iree_task_affinity_set_t* constructive_sharing_mask,
+    const iree_task_affinity_set_t* node_mask, uint32_t max_theft_attempts,
+    iree_prng_minilcg128_state_t* theft_prng,
     iree_task_queue_t* local_task_queue);
 
 #ifdef __cplusplus
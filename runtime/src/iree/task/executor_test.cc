@@ -7,7 +7,9 @@
 #include "iree/task/executor.h"
 
 #include <cstddef>
+#include <vector>
 
+#include "iree/task/executor_impl.h"
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
 
@@ -86,11 +88,112 @@ TEST(ExecutorTest, LifetimeStress) {
   iree_task_topology_deinitialize(&topology);
 }
 
-// Tests heavily serialized submission to an executor.
-// This puts pressure on the overheads involved in spilling up threads.
-TEST(ExecutorTest, SubmissionStress) {
+static std::vector<iree_host_size_t> AffinitySetIndices(
+    const iree_task_affinity_set_t& set) {
+  std::vector<iree_host_size_t> indices;
+  for (iree_host_size_t i = iree_task_affinity_set_find_first(&set);
+       i != IREE_TASK_AFFINITY_SET_NPOS;
+       i = iree_task_affinity_set_find_next(&set, i + 1)) {
+    indices.push_back(i);
+  }
+  return indices;
+}
+
+// Tests that thieves try victims sharing caches first, then the remaining
+// workers on their NUMA node, and only then workers on remote nodes.
+TEST(ExecutorTest, TheftVictimsOnSameNodeBeforeRemote) {
+  // 8 workers on two nodes: 0-3 on node 0 and 4-7 on node 1 with the thief
+  // (worker 0) sharing caches with worker 1 and worker 2 idle. The node
+  // boundary is placed across an affinity set word boundary when possible.
+  const iree_host_size_t base =
+      IREE_TASK_EXECUTOR_MAX_WORKER_COUNT > 64 ? 60 : 0;
+  iree_task_affinity_set_t victim_mask = iree_task_affinity_set_empty();
+  for (iree_host_size_t i = 1; i < 8; ++i) {
+    if (i == 2) continue;  // idle
+    iree_task_affinity_set_insert(&victim_mask, base + i);
+  }
+  iree_task_affinity_set_t constructive_sharing_mask =
+      iree_task_affinity_set_empty();
+  iree_task_affinity_set_insert(&constructive_sharing_mask, base + 0);
+  iree_task_affinity_set_insert(&constructive_sharing_mask, base + 1);
+  iree_task_affinity_set_t node_mask = iree_task_affinity_set_empty();
+  for (iree_host_size_t i = 0; i < 4; ++i) {
+    iree_task_affinity_set_insert(&node_mask, base + i);
+  }
+
+  iree_task_affinity_set_t tier_masks[IREE_TASK_EXECUTOR_THEFT_TIER_COUNT];
+  iree_task_executor_partition_theft_victims(
+      &victim_mask, &constructive_sharing_mask, &node_mask, tier_masks);
+  EXPECT_EQ(std::vector<iree_host_size_t>({base + 1}),
+            AffinitySetIndices(
+                tier_masks[IREE_TASK_EXECUTOR_THEFT_TIER_SHARED_CACHE]));
+  EXPECT_EQ(std::vector<iree_host_size_t>({base + 3}),
+            AffinitySetIndices(tier_masks[IREE_TASK_EXECUTOR_THEFT_TIER_NODE]));
+  EXPECT_EQ(
+      std::vector<iree_host_size_t>({base + 4, base + 5, base + 6, base + 7}),
+      AffinitySetIndices(tier_masks[IREE_TASK_EXECUTOR_THEFT_TIER_REMOTE]));
+
+  // With everything on one node there are no remote victims.
+  iree_task_affinity_set_t all_mask = iree_task_affinity_set_ones(base + 8);
+  iree_task_executor_partition_theft_victims(
+      &victim_mask, &constructive_sharing_mask, &all_mask, tier_masks);
+  EXPECT_EQ(std::vector<iree_host_size_t>(
+                {base + 3, base + 4, base + 5, base + 6, base + 7}),
+            AffinitySetIndices(tier_masks[IREE_TASK_EXECUTOR_THEFT_TIER_NODE]));
+  EXPECT_TRUE(iree_task_affinity_set_is_empty(
+      &tier_masks[IREE_TASK_EXECUTOR_THEFT_TIER_REMOTE]));
+}
+
+// Tests that tasks allowed to run on any worker are limited to the workers the
+// executor actually has when scheduled.
+TEST(ExecutorTest, AnyWorkerAffinityClampedToWorkerCount) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/4, &topology);
   iree_task_executor_options_t options;
   iree_task_executor_options_initialize(&options);
+  iree_task_executor_t* executor = NULL;
+  IREE_ASSERT_OK(iree_task_executor_create(options, &topology,
+                                           iree_allocator_system(), &executor));
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"),
+                             IREE_TASK_SCOPE_FLAG_NONE, &scope);
+
+  static std::atomic<int> worker_count = {0};
+  iree_task_call_t call;
+  iree_task_call_initialize(
+      &scope,
+      iree_task_make_call_closure(
+          [](void* user_context, iree_task_t* task,
+             iree_task_submission_t* pending_submission) {
+            worker_count =
+                (int)iree_task_affinity_worker_count(task->affinity);
+            return iree_ok_status();
+          },
+          NULL),
+      &call);
+  EXPECT_EQ(iree_task_affinity_worker_count(call.header.affinity),
+            IREE_TASK_EXECUTOR_MAX_WORKER_COUNT);
+
+  iree_task_fence_t* fence = NULL;
+  IREE_ASSERT_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+  iree_task_set_completion_task(&call.header, &fence->header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &call.header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+  IREE_ASSERT_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(worker_count, 4);
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+  iree_task_topology_deinitialize(&topology);
+}
+
+// Issues heavily serialized submissions to an executor created with |options|.
+// This puts pressure on the overheads involved in spilling up threads.
+static void RunSubmissionStress(iree_task_executor_options_t options) {
   options.worker_local_memory_size = 64 * 1024;
   iree_task_topology_t topology;
   iree_task_topology_initialize_from_group_count(/*group_count=*/4, &topology);
@@ -130,9 +233,41 @@ TEST(ExecutorTest, SubmissionStress) {
     EXPECT_EQ(received_value, i) << "call did not correlate to loop";
   }
 
+  // Workers that never spin must always park.
+  iree_task_executor_statistics_t statistics;
+  iree_task_executor_query_statistics(executor, &statistics);
+  if (options.worker_spin_ns == IREE_DURATION_ZERO) {
+    EXPECT_EQ(statistics.spin_wake_count, 0u);
+    EXPECT_EQ(statistics.spin_ns, 0u);
+  }
+
   iree_task_scope_deinitialize(&scope);
   iree_task_executor_release(executor);
   iree_task_topology_deinitialize(&topology);
 }
 
+TEST(ExecutorTest, SubmissionStress) {
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  RunSubmissionStress(options);
+}
+
+// Tests serialized submission with workers spinning before they park so that
+// wakes race with workers transitioning from spinning to parked.
+TEST(ExecutorTest, SubmissionStressSpinning) {
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.worker_spin_ns = 50 * 1000;
+  RunSubmissionStress(options);
+}
+
+// Tests serialized submission with workers adapting their spin duration.
+TEST(ExecutorTest, SubmissionStressSpinningAdaptive) {
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.worker_spin_ns = 50 * 1000;
+  options.worker_spin_adaptive = true;
+  RunSubmissionStress(options);
+}
+
 }  // namespace
@@ -21,7 +21,8 @@ void iree_task_post_batch_initialize(iree_task_executor_t* executor,
                                      iree_task_post_batch_t* out_post_batch) {
   out_post_batch->executor = executor;
   out_post_batch->current_worker = current_worker;
-  out_post_batch->worker_pending_mask = 0;
+  out_post_batch->worker_pending_mask = iree_task_affinity_set_empty();
+  out_post_batch->worker_wake_mask = iree_task_affinity_set_empty();
   memset(&out_post_batch->worker_pending_lifos, 0,
          executor->worker_count * sizeof(iree_task_list_t));
 }
@@ -32,13 +33,17 @@ iree_host_size_t iree_task_post_batch_worker_count(
 }
 
 static iree_host_size_t iree_task_post_batch_select_random_worker(
-    iree_task_post_batch_t* post_batch, iree_task_affinity_set_t affinity_set) {
+    iree_task_post_batch_t* post_batch,
+    const iree_task_affinity_set_t* affinity_set) {
   // The masks are accessed with 'relaxed' order because they are just hints.
   iree_task_affinity_set_t worker_live_mask =
       iree_atomic_task_affinity_set_load(
           &post_batch->executor->worker_live_mask, iree_memory_order_relaxed);
-  iree_task_affinity_set_t valid_worker_mask = affinity_set & worker_live_mask;
-  if (!valid_worker_mask) {
+  iree_task_affinity_set_t valid_worker_mask =
+      iree_task_affinity_set_and(affinity_set, &worker_live_mask);
+  iree_host_size_t worker_index =
+      iree_task_affinity_set_find_first(&valid_worker_mask);
+  if (worker_index == IREE_TASK_AFFINITY_SET_NPOS) {
     // No valid workers as desired; for now just bail to worker 0.
     return 0;
   }
@@ -46,19 +51,20 @@ static iree_host_size_t iree_task_post_batch_select_random_worker(
   // TODO(benvanik): rotate through workers here. Instead, if the affinity set
   // has the current_worker allowed we just use that to avoid needing a
   // cross-thread hop.
-  return iree_task_affinity_set_count_trailing_zeros(valid_worker_mask);
+  return worker_index;
 }
 
 iree_host_size_t iree_task_post_batch_select_worker(
-    iree_task_post_batch_t* post_batch, iree_task_affinity_set_t affinity_set) {
+    iree_task_post_batch_t* post_batch, iree_task_affinity_t affinity) {
   if (post_batch->current_worker) {
     // Posting from a worker - prefer sending right back to this worker if we
     // haven't already scheduled for it.
-    if ((affinity_set & post_batch->current_worker->worker_bit) &&
-        !(post_batch->worker_pending_mask &
-          post_batch->current_worker->worker_bit)) {
-      return iree_task_affinity_set_count_trailing_zeros(
-          post_batch->current_worker->worker_bit);
+    iree_host_size_t current_index =
+        post_batch->current_worker->local_worker_index;
+    if (iree_task_affinity_contains(affinity, current_index) &&
+        !iree_task_affinity_set_contains(&post_batch->worker_pending_mask,
+                                         current_index)) {
+      return current_index;
     }
   }
 
@@ -69,19 +75,23 @@ iree_host_size_t iree_task_post_batch_select_worker(
   // ourselves in this batch haven't already queued work for them (as then they
   // aren't going to be idle).
   // The masks are accessed with 'relaxed' order because they are just hints.
+  iree_task_affinity_set_t affinity_set =
+      iree_task_affinity_set_from_affinity(affinity);
   iree_task_affinity_set_t worker_idle_mask =
       iree_atomic_task_affinity_set_load(
           &post_batch->executor->worker_idle_mask, iree_memory_order_relaxed);
-  worker_idle_mask &= ~post_batch->worker_pending_mask;
-  iree_task_affinity_set_t idle_affinity_set = affinity_set & worker_idle_mask;
-  if (idle_affinity_set) {
+  worker_idle_mask = iree_task_affinity_set_and_not(
+      &worker_idle_mask, &post_batch->worker_pending_mask);
+  iree_task_affinity_set_t idle_affinity_set =
+      iree_task_affinity_set_and(&affinity_set, &worker_idle_mask);
+  if (!iree_task_affinity_set_is_empty(&idle_affinity_set)) {
     return iree_task_post_batch_select_random_worker(post_batch,
-                                                     idle_affinity_set);
+                                                     &idle_affinity_set);
   }
 
   // No more workers are idle; farm out at random. In the worst case work
   // stealing will help balance things out on the backend.
-  return iree_task_post_batch_select_random_worker(post_batch, affinity_set);
+  return iree_task_post_batch_select_random_worker(post_batch, &affinity_set);
 }
 
 void iree_task_post_batch_enqueue(iree_task_post_batch_t* post_batch,
@@ -89,15 +99,54 @@ void iree_task_post_batch_enqueue(iree_task_post_batch_t* post_batch,
                                   iree_task_t* task) {
   iree_task_list_push_front(&post_batch->worker_pending_lifos[worker_index],
                             task);
-  post_batch->worker_pending_mask |=
-      iree_task_affinity_for_worker(worker_index);
+  iree_task_affinity_set_insert(&post_batch->worker_pending_mask,
+                                worker_index);
+}
+
+void iree_task_post_batch_wake_idle_workers(iree_task_post_batch_t* post_batch,
+                                            iree_task_affinity_t affinity,
+                                            iree_host_size_t count) {
+  iree_host_size_t current_index = IREE_TASK_AFFINITY_SET_NPOS;
+  if (post_batch->current_worker) {
+    current_index = post_batch->current_worker->local_worker_index;
+    if (iree_task_affinity_contains(affinity, current_index)) {
+      if (count <= 1) return;
+      --count;
+    }
+  }
+
+  // The idle mask is accessed with 'relaxed' order because it is just a hint.
+  // Workers that are not idle will find the work on their own before they go
+  // to sleep.
+  iree_task_affinity_set_t affinity_set =
+      iree_task_affinity_set_from_affinity(affinity);
+  iree_task_affinity_set_t worker_idle_mask =
+      iree_atomic_task_affinity_set_load(
+          &post_batch->executor->worker_idle_mask, iree_memory_order_relaxed);
+  iree_task_affinity_set_t idle_affinity_set =
+      iree_task_affinity_set_and(&affinity_set, &worker_idle_mask);
+  for (iree_host_size_t worker_index =
+           iree_task_affinity_set_find_first(&idle_affinity_set);
+       worker_index != IREE_TASK_AFFINITY_SET_NPOS && count > 0;
+       worker_index = iree_task_affinity_set_find_next(&idle_affinity_set,
+                                                       worker_index + 1)) {
+    if (worker_index == current_index ||
+        iree_task_affinity_set_contains(&post_batch->worker_wake_mask,
+                                        worker_index)) {
+      continue;
+    }
+    iree_task_affinity_set_insert(&post_batch->worker_wake_mask, worker_index);
+    --count;
+  }
 }
 
 // Wakes each worker indicated in the |wake_mask|, if needed.
 static void iree_task_post_batch_wake_workers(
-    iree_task_post_batch_t* post_batch, iree_task_affinity_set_t wake_mask) {
+    iree_task_post_batch_t* post_batch,
+    const iree_task_affinity_set_t* wake_mask) {
   IREE_TRACE_ZONE_BEGIN(z0);
-  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, iree_math_count_ones_u64(wake_mask));
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(
+      z0, (int64_t)iree_task_affinity_set_count_ones(wake_mask));
 
   // TODO(#4016): use a FUTEX_WAKE_BITSET here to wake all of the workers that
   // have pending work in a single syscall (vs. popcnt(worker_pending_mask)
@@ -108,14 +157,10 @@ static void iree_task_post_batch_wake_workers(
   // threads will be needed simultaneously and can hopefully perform any needed
   // migrations prior to beginning execution.
   iree_task_executor_t* executor = post_batch->executor;
-  int wake_count = iree_task_affinity_set_count_ones(wake_mask);
-  int worker_index = 0;
-  for (int i = 0; i < wake_count; ++i) {
-    int offset = iree_task_affinity_set_count_trailing_zeros(wake_mask);
-    int wake_index = worker_index + offset;
-    worker_index += offset + 1;
-    wake_mask = iree_shr(wake_mask, offset + 1);
-
+  for (iree_host_size_t wake_index =
+           iree_task_affinity_set_find_first(wake_mask);
+       wake_index != IREE_TASK_AFFINITY_SET_NPOS;
+       wake_index = iree_task_affinity_set_find_next(wake_mask, wake_index + 1)) {
     // Wake workers if they are waiting - workers are the only thing that can
     // wait on this notification so this should almost always be either free (an
     // atomic load) if a particular worker isn't waiting or it's required to
@@ -128,23 +173,26 @@ static void iree_task_post_batch_wake_workers(
 }
 
 bool iree_task_post_batch_submit(iree_task_post_batch_t* post_batch) {
-  if (!post_batch->worker_pending_mask) return false;
+  if (iree_task_affinity_set_is_empty(&post_batch->worker_pending_mask) &&
+      iree_task_affinity_set_is_empty(&post_batch->worker_wake_mask)) {
+    return false;
+  }
 
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // Run through each worker that has a bit set in the pending mask and post
   // the pending tasks.
   iree_task_affinity_set_t worker_mask = post_batch->worker_pending_mask;
-  post_batch->worker_pending_mask = 0;
-  int worker_index = 0;
-  int post_count = iree_task_affinity_set_count_ones(worker_mask);
-  iree_task_affinity_set_t worker_wake_mask = 0;
-  for (int i = 0; i < post_count; ++i) {
-    int offset = iree_task_affinity_set_count_trailing_zeros(worker_mask);
-    int target_index = worker_index + offset;
-    worker_index += offset + 1;
-    worker_mask = iree_shr(worker_mask, offset + 1);
-
+  post_batch->worker_pending_mask = iree_task_affinity_set_empty();
+  iree_task_affinity_set_t worker_wake_mask = post_batch->worker_wake_mask;
+  post_batch->worker_wake_mask = iree_task_affinity_set_empty();
+  bool any_posted = !iree_task_affinity_set_is_empty(&worker_mask);
+  bool any_woken = !iree_task_affinity_set_is_empty(&worker_wake_mask);
+  for (iree_host_size_t target_index =
+           iree_task_affinity_set_find_first(&worker_mask);
+       target_index != IREE_TASK_AFFINITY_SET_NPOS;
+       target_index =
+           iree_task_affinity_set_find_next(&worker_mask, target_index + 1)) {
     iree_task_worker_t* worker = &post_batch->executor->workers[target_index];
     iree_task_list_t* target_pending_lifo =
         &post_batch->worker_pending_lifos[target_index];
@@ -157,16 +205,17 @@ bool iree_task_post_batch_submit(iree_task_post_batch_t* post_batch) {
                                                    target_pending_lifo);
     } else {
       iree_task_worker_post_tasks(worker, target_pending_lifo);
-      worker_wake_mask |= iree_task_affinity_for_worker(target_index);
+      iree_task_affinity_set_insert(&worker_wake_mask, target_index);
+      any_woken = true;
     }
   }
 
   // Wake all workers that now have pending work. If a worker is not already
   // waiting this will be cheap (no syscall).
-  if (worker_wake_mask != 0) {
-    iree_task_post_batch_wake_workers(post_batch, worker_wake_mask);
+  if (any_woken) {
+    iree_task_post_batch_wake_workers(post_batch, &worker_wake_mask);
   }
 
   IREE_TRACE_ZONE_END(z0);
-  return post_count != 0;
+  return any_posted;
 }
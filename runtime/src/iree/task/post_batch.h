@@ -39,6 +39,11 @@ typedef struct iree_task_post_batch_t {
   // Used to quickly scan the lists and perform the posts only when required.
   iree_task_affinity_set_t worker_pending_mask;
 
+  // A bitmask of workers that should be woken upon submission even though no
+  // tasks are being posted to them. Used when work is made available to workers
+  // through means other than their mailboxes (such as persistent dispatches).
+  iree_task_affinity_set_t worker_wake_mask;
+
   // A per-worker LIFO task list waiting to be posted.
   iree_task_list_t worker_pending_lifos[0];
 } iree_task_post_batch_t;
@@ -51,9 +56,9 @@ void iree_task_post_batch_initialize(iree_task_executor_t* executor,
 iree_host_size_t iree_task_post_batch_worker_count(
     const iree_task_post_batch_t* post_batch);
 
-// Selects a random worker from the given affinity set.
+// Selects a random worker from the given |affinity|.
 iree_host_size_t iree_task_post_batch_select_worker(
-    iree_task_post_batch_t* post_batch, iree_task_affinity_set_t affinity_set);
+    iree_task_post_batch_t* post_batch, iree_task_affinity_t affinity);
 
 // Enqueues a task to the given worker. Note that the pending work lists for
 // each work is kept in LIFO order so that we can easily concatenate it with the
@@ -62,7 +67,15 @@ void iree_task_post_batch_enqueue(iree_task_post_batch_t* post_batch,
                                   iree_host_size_t worker_index,
                                   iree_task_t* task);
 
-// Submits all pending tasks to their worker mailboxes and resets state.
+// Requests that up to |count| idle workers within |affinity| be woken when the
+// batch is submitted. The current worker (if any) counts towards |count| but is
+// never woken as it is by definition already awake.
+void iree_task_post_batch_wake_idle_workers(iree_task_post_batch_t* post_batch,
+                                            iree_task_affinity_t affinity,
+                                            iree_host_size_t count);
+
+// Submits all pending tasks to their worker mailboxes, wakes any workers
+// requested, and resets state.
 // Returns true if any tasks were posted to workers.
 bool iree_task_post_batch_submit(iree_task_post_batch_t* post_batch);
 
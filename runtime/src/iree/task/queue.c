@@ -9,43 +9,143 @@
 #include <stddef.h>
 #include <string.h>
 
+static_assert((IREE_TASK_QUEUE_CAPACITY & (IREE_TASK_QUEUE_CAPACITY - 1)) == 0,
+              "IREE_TASK_QUEUE_CAPACITY must be a power of two");
+
+#define IREE_TASK_QUEUE_INDEX_MASK (IREE_TASK_QUEUE_CAPACITY - 1)
+
 void iree_task_queue_initialize(iree_task_queue_t* out_queue) {
   memset(out_queue, 0, sizeof(*out_queue));
-  iree_slim_mutex_initialize(&out_queue->mutex);
-  iree_task_list_initialize(&out_queue->list);
+  iree_atomic_store(&out_queue->top, 0, iree_memory_order_relaxed);
+  iree_atomic_store(&out_queue->bottom, 0, iree_memory_order_relaxed);
+  iree_task_list_initialize(&out_queue->overflow);
+}
+
+// Pops a task from the bottom of the ring.
+// Returns NULL if the ring is empty or a thief won the race for the last task.
+//
+// Must only be called from the owning worker's thread.
+static iree_task_t* iree_task_queue_pop_bottom(iree_task_queue_t* queue) {
+  int64_t bottom =
+      iree_atomic_load(&queue->bottom, iree_memory_order_relaxed) - 1;
+  iree_atomic_store(&queue->bottom, bottom, iree_memory_order_relaxed);
+  // The store to bottom must be visible before we observe top so that a thief
+  // racing for the same task sees that we've claimed it (or we see that it
+  // has).
+  iree_atomic_thread_fence(iree_memory_order_seq_cst);
+  int64_t top = iree_atomic_load(&queue->top, iree_memory_order_relaxed);
+  if (top > bottom) {
+    // Empty; restore bottom.
+    iree_atomic_store(&queue->bottom, bottom + 1, iree_memory_order_relaxed);
+    return NULL;
+  }
+  iree_task_t* task = (iree_task_t*)iree_atomic_load(
+      &queue->tasks[bottom & IREE_TASK_QUEUE_INDEX_MASK],
+      iree_memory_order_relaxed);
+  if (top == bottom) {
+    // Last task in the ring; race any thieves for it.
+    if (!iree_atomic_compare_exchange_strong(
+            &queue->top, &top, top + 1, iree_memory_order_seq_cst,
+            iree_memory_order_relaxed)) {
+      task = NULL;  // thief won
+    }
+    iree_atomic_store(&queue->bottom, bottom + 1, iree_memory_order_relaxed);
+  }
+  return task;
+}
+
+// Pushes a task to the bottom of the ring.
+// Returns false if the ring is full.
+//
+// Must only be called from the owning worker's thread.
+static bool iree_task_queue_push_bottom(iree_task_queue_t* queue,
+                                        iree_task_t* task) {
+  int64_t bottom = iree_atomic_load(&queue->bottom, iree_memory_order_relaxed);
+  int64_t top = iree_atomic_load(&queue->top, iree_memory_order_acquire);
+  if (bottom - top >= IREE_TASK_QUEUE_CAPACITY) return false;
+  iree_atomic_store(&queue->tasks[bottom & IREE_TASK_QUEUE_INDEX_MASK],
+                    (intptr_t)task, iree_memory_order_relaxed);
+  // Publishes the task to thieves.
+  iree_atomic_store(&queue->bottom, bottom + 1, iree_memory_order_release);
+  return true;
+}
+
+// Returns true if the ring (excluding the overflow list) is empty.
+static bool iree_task_queue_ring_is_empty(iree_task_queue_t* queue) {
+  int64_t bottom = iree_atomic_load(&queue->bottom, iree_memory_order_relaxed);
+  int64_t top = iree_atomic_load(&queue->top, iree_memory_order_acquire);
+  return top >= bottom;
+}
+
+// Moves tasks from the front of the overflow list into the ring until either
+// the overflow is empty or the ring is full. The ring must be empty as the
+// overflow tasks run after any already in the ring.
+//
+// Must only be called from the owning worker's thread.
+static void iree_task_queue_refill_from_overflow(iree_task_queue_t* queue) {
+  if (iree_task_list_is_empty(&queue->overflow)) return;
+
+  // Take up to a ring's worth of tasks off the front of the overflow list. They
+  // are pushed onto a LIFO list such that the first task in FIFO order is
+  // pushed last and ends up at the bottom where the owner pops.
+  iree_task_list_t lifo;
+  iree_task_list_initialize(&lifo);
+  for (iree_host_size_t i = 0; i < IREE_TASK_QUEUE_CAPACITY; ++i) {
+    iree_task_t* task = iree_task_list_pop_front(&queue->overflow);
+    if (!task) break;
+    iree_task_list_push_front(&lifo, task);
+  }
+  iree_task_t* task = NULL;
+  while ((task = iree_task_list_pop_front(&lifo)) != NULL) {
+    iree_task_queue_push_bottom(queue, task);
+  }
 }
 
 void iree_task_queue_deinitialize(iree_task_queue_t* queue) {
-  iree_task_list_discard(&queue->list);
-  iree_slim_mutex_deinitialize(&queue->mutex);
+  iree_task_list_t list;
+  iree_task_list_initialize(&list);
+  iree_task_t* task = NULL;
+  while ((task = iree_task_queue_pop_bottom(queue)) != NULL) {
+    iree_task_list_push_back(&list, task);
+  }
+  iree_task_list_append(&list, &queue->overflow);
+  iree_task_list_discard(&list);
 }
 
 bool iree_task_queue_is_empty(iree_task_queue_t* queue) {
-  iree_slim_mutex_lock(&queue->mutex);
-  bool is_empty = iree_task_list_is_empty(&queue->list);
-  iree_slim_mutex_unlock(&queue->mutex);
-  return is_empty;
+  return iree_task_queue_ring_is_empty(queue) &&
+         iree_task_list_is_empty(&queue->overflow);
 }
 
 void iree_task_queue_push_front(iree_task_queue_t* queue, iree_task_t* task) {
-  iree_slim_mutex_lock(&queue->mutex);
-  iree_task_list_push_front(&queue->list, task);
-  iree_slim_mutex_unlock(&queue->mutex);
+  if (!iree_task_queue_push_bottom(queue, task)) {
+    iree_task_list_push_back(&queue->overflow, task);
+  }
+}
+
+// Appends a FIFO |list| of tasks to the queue.
+static void iree_task_queue_append_fifo_list(iree_task_queue_t* queue,
+                                             iree_task_list_t* list) {
+  // New tasks run after all existing ones. Since the owner only consumes from
+  // the bottom of the ring we can't insert them above the tasks already there
+  // and instead place them in the overflow list; if the ring is empty we can
+  // immediately move them into it where thieves can see them.
+  iree_task_list_append(&queue->overflow, list);
+  if (iree_task_queue_ring_is_empty(queue)) {
+    iree_task_queue_refill_from_overflow(queue);
+  }
 }
 
 void iree_task_queue_append_from_lifo_list_unsafe(iree_task_queue_t* queue,
                                                   iree_task_list_t* list) {
-  // NOTE: reversing the list outside of the lock.
   iree_task_list_reverse(list);
-  iree_slim_mutex_lock(&queue->mutex);
-  iree_task_list_append(&queue->list, list);
-  iree_slim_mutex_unlock(&queue->mutex);
+  iree_task_queue_append_fifo_list(queue, list);
 }
 
 iree_task_t* iree_task_queue_flush_from_lifo_slist(
     iree_task_queue_t* queue, iree_atomic_task_slist_t* source_slist) {
-  // Perform the flush and swap outside of the lock; acquiring the list is
-  // atomic and then we own it exclusively.
+  // Perform the flush and swap; acquiring the list is atomic and then we own it
+  // exclusively.
   iree_task_list_t suffix;
   iree_task_list_initialize(&suffix);
   const bool did_flush = iree_atomic_task_slist_flush(
@@ -53,39 +153,79 @@ iree_task_t* iree_task_queue_flush_from_lifo_slist(
       &suffix.head, &suffix.tail);
 
   // Append the tasks and pop off the front for return.
-  iree_slim_mutex_lock(&queue->mutex);
-  if (did_flush) iree_task_list_append(&queue->list, &suffix);
-  iree_task_t* next_task = iree_task_list_pop_front(&queue->list);
-  iree_slim_mutex_unlock(&queue->mutex);
-
-  return next_task;
+  if (did_flush) iree_task_queue_append_fifo_list(queue, &suffix);
+  return iree_task_queue_pop_front(queue);
 }
 
 iree_task_t* iree_task_queue_pop_front(iree_task_queue_t* queue) {
-  iree_slim_mutex_lock(&queue->mutex);
-  iree_task_t* next_task = iree_task_list_pop_front(&queue->list);
-  iree_slim_mutex_unlock(&queue->mutex);
+  iree_task_t* next_task = iree_task_queue_pop_bottom(queue);
+  if (IREE_LIKELY(iree_task_list_is_empty(&queue->overflow))) return next_task;
+  while (!next_task && !iree_task_list_is_empty(&queue->overflow)) {
+    // Ring drained (possibly by thieves); move the next batch of tasks from the
+    // overflow list into it. A thief may steal the refilled tasks before we can
+    // pop one so we keep going until we get one or run out.
+    iree_task_queue_refill_from_overflow(queue);
+    next_task = iree_task_queue_pop_bottom(queue);
+  }
+  if (next_task && iree_task_queue_ring_is_empty(queue)) {
+    // We took the last task in the ring. The overflow tasks run after it and
+    // can move into the ring now so that thieves can take them while we run
+    // the task instead of waiting for our next pop.
+    iree_task_queue_refill_from_overflow(queue);
+  }
   return next_task;
 }
 
+// Steals a single task from the top of the |queue| ring.
+// Returns NULL if the queue is empty or another thread won the race for the
+// task.
+static iree_task_t* iree_task_queue_steal_top(iree_task_queue_t* queue,
+                                              int64_t* out_remaining) {
+  *out_remaining = 0;
+  int64_t top = iree_atomic_load(&queue->top, iree_memory_order_acquire);
+  // Must observe top before bottom; pairs with the fence in pop_bottom.
+  iree_atomic_thread_fence(iree_memory_order_seq_cst);
+  int64_t bottom = iree_atomic_load(&queue->bottom, iree_memory_order_acquire);
+  if (top >= bottom) return NULL;  // empty
+  iree_task_t* task = (iree_task_t*)iree_atomic_load(
+      &queue->tasks[top & IREE_TASK_QUEUE_INDEX_MASK],
+      iree_memory_order_relaxed);
+  if (!iree_atomic_compare_exchange_strong(&queue->top, &top, top + 1,
+                                           iree_memory_order_seq_cst,
+                                           iree_memory_order_relaxed)) {
+    return NULL;  // lost the race with the owner or another thief
+  }
+  *out_remaining = bottom - top - 1;
+  return task;
+}
+
 iree_task_t* iree_task_queue_try_steal(iree_task_queue_t* source_queue,
                                        iree_task_queue_t* target_queue,
                                        iree_host_size_t max_tasks) {
-  // First attempt to steal up to max_tasks from the source queue.
+  // Tasks are stolen one at a time from the top of the source ring as there's
+  // no safe way to claim a range of tasks at once while the owner may be
+  // popping from the bottom. We take up to half of the tasks observed on the
+  // first steal (rounded up so that a single task can always be stolen) and
+  // stop at the first lost race.
+  //
+  // Stolen tasks come off in reverse FIFO order (the task the victim would have
+  // run last comes first) so we push them to the front of a FIFO list to
+  // preserve their relative order.
   iree_task_list_t stolen_tasks;
   iree_task_list_initialize(&stolen_tasks);
-  if (iree_slim_mutex_try_lock(&source_queue->mutex)) {
-    iree_task_list_split(&source_queue->list, max_tasks, &stolen_tasks);
-    iree_slim_mutex_unlock(&source_queue->mutex);
+  int64_t remaining = 0;
+  iree_task_t* task = iree_task_queue_steal_top(source_queue, &remaining);
+  if (!task) return NULL;
+  iree_task_list_push_front(&stolen_tasks, task);
+  iree_host_size_t steal_count =
+      iree_min(max_tasks, (iree_host_size_t)(remaining + 2) / 2);
+  for (iree_host_size_t i = 1; i < steal_count; ++i) {
+    task = iree_task_queue_steal_top(source_queue, &remaining);
+    if (!task) break;
+    iree_task_list_push_front(&stolen_tasks, task);
   }
 
-  // Add any stolen tasks to the target queue and pop off the head for return.
-  iree_task_t* next_task = NULL;
-  if (!iree_task_list_is_empty(&stolen_tasks)) {
-    iree_slim_mutex_lock(&target_queue->mutex);
-    iree_task_list_append(&target_queue->list, &stolen_tasks);
-    next_task = iree_task_list_pop_front(&target_queue->list);
-    iree_slim_mutex_unlock(&target_queue->mutex);
-  }
-  return next_task;
+  // Add the stolen tasks to the target queue and pop off the head for return.
+  iree_task_queue_append_fifo_list(target_queue, &stolen_tasks);
+  return iree_task_queue_pop_front(target_queue);
 }
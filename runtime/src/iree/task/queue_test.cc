@@ -6,6 +6,10 @@
 
 #include "iree/task/queue.h"
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include "iree/base/internal/threading.h"
 #include "iree/testing/gtest.h"
 
@@ -126,6 +130,70 @@ TEST(QueueTest, AppendListOrdered) {
   iree_task_queue_deinitialize(&queue);
 }
 
+TEST(QueueTest, AppendListOverflow) {
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+
+  // Make a lifo list with more tasks than fit in the ring.
+  static constexpr iree_host_size_t kTaskCount =
+      IREE_TASK_QUEUE_CAPACITY * 2 + 3;
+  std::vector<iree_task_t> tasks(kTaskCount);
+  iree_task_list_t list = {0};
+  for (auto& task : tasks) {
+    memset(&task, 0, sizeof(task));
+    iree_task_list_push_front(&list, &task);
+  }
+
+  // Append and pop everything; tasks spilled to the overflow must still come
+  // out in FIFO order.
+  iree_task_queue_append_from_lifo_list_unsafe(&queue, &list);
+  for (auto& task : tasks) {
+    EXPECT_FALSE(iree_task_queue_is_empty(&queue));
+    EXPECT_EQ(&task, iree_task_queue_pop_front(&queue));
+  }
+  EXPECT_TRUE(iree_task_queue_is_empty(&queue));
+
+  iree_task_queue_deinitialize(&queue);
+}
+
+// Tests that tasks appended behind a non-empty ring become stealable once the
+// owner pops the last task from the ring.
+TEST(QueueTest, TryStealFromOverflow) {
+  iree_task_queue_t source_queue;
+  iree_task_queue_initialize(&source_queue);
+  iree_task_queue_t target_queue;
+  iree_task_queue_initialize(&target_queue);
+
+  // task_a goes into the empty ring and the later tasks to the overflow.
+  iree_task_t task_a = {0};
+  iree_task_t task_b = {0};
+  iree_task_t task_c = {0};
+  iree_task_t task_d = {0};
+  iree_task_list_t list_a = {0};
+  iree_task_list_push_front(&list_a, &task_a);
+  iree_task_queue_append_from_lifo_list_unsafe(&source_queue, &list_a);
+  iree_task_list_t list_bcd = {0};
+  iree_task_list_push_front(&list_bcd, &task_b);
+  iree_task_list_push_front(&list_bcd, &task_c);
+  iree_task_list_push_front(&list_bcd, &task_d);
+  iree_task_queue_append_from_lifo_list_unsafe(&source_queue, &list_bcd);
+
+  // While task_a runs the tasks behind it must be visible to thieves. The last
+  // task the owner would run is the one stolen.
+  EXPECT_EQ(&task_a, iree_task_queue_pop_front(&source_queue));
+  EXPECT_EQ(&task_d, iree_task_queue_try_steal_until_success(
+                         &source_queue, &target_queue, /*max_tasks=*/1));
+  EXPECT_TRUE(iree_task_queue_is_empty(&target_queue));
+
+  // The owner continues with the remaining tasks in order.
+  EXPECT_EQ(&task_b, iree_task_queue_pop_front(&source_queue));
+  EXPECT_EQ(&task_c, iree_task_queue_pop_front(&source_queue));
+  EXPECT_TRUE(iree_task_queue_is_empty(&source_queue));
+
+  iree_task_queue_deinitialize(&target_queue);
+  iree_task_queue_deinitialize(&source_queue);
+}
+
 TEST(QueueTest, FlushSlistEmpty) {
   iree_task_queue_t queue;
   iree_task_queue_initialize(&queue);
@@ -336,4 +404,62 @@ TEST(QueueTest, TryStealAll) {
   iree_task_queue_deinitialize(&target_queue);
 }
 
+// Has the owner pop tasks while several thieves steal from it and ensures that
+// each task is taken exactly once.
+TEST(QueueTest, ConcurrentTheft) {
+  static constexpr int kBatchCount = 200;
+  static constexpr int kBatchSize = 100;
+  static constexpr int kThiefCount = 3;
+  std::vector<iree_task_t> tasks(kBatchCount * kBatchSize);
+  std::vector<std::atomic<int>> task_counts(tasks.size());
+  for (auto& count : task_counts) count = 0;
+  auto take_task = [&](iree_task_t* task) {
+    ++task_counts[task - tasks.data()];
+  };
+
+  iree_task_queue_t source_queue;
+  iree_task_queue_initialize(&source_queue);
+
+  std::atomic<bool> done = {false};
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < kThiefCount; ++i) {
+    thieves.emplace_back([&]() {
+      iree_task_queue_t target_queue;
+      iree_task_queue_initialize(&target_queue);
+      while (!done) {
+        iree_task_t* task =
+            iree_task_queue_try_steal(&source_queue, &target_queue, 8);
+        if (!task) {
+          iree_thread_yield();
+          continue;
+        }
+        do {
+          take_task(task);
+        } while ((task = iree_task_queue_pop_front(&target_queue)) != NULL);
+      }
+      iree_task_queue_deinitialize(&target_queue);
+    });
+  }
+
+  for (int batch = 0; batch < kBatchCount; ++batch) {
+    iree_task_list_t list = {0};
+    for (int i = 0; i < kBatchSize; ++i) {
+      iree_task_t* task = &tasks[batch * kBatchSize + i];
+      memset(task, 0, sizeof(*task));
+      iree_task_list_push_front(&list, task);
+    }
+    iree_task_queue_append_from_lifo_list_unsafe(&source_queue, &list);
+    iree_task_t* task = NULL;
+    while ((task = iree_task_queue_pop_front(&source_queue)) != NULL) {
+      take_task(task);
+    }
+  }
+  done = true;
+  for (auto& thief : thieves) thief.join();
+
+  for (auto& count : task_counts) EXPECT_EQ(1, count);
+
+  iree_task_queue_deinitialize(&source_queue);
+}
+
 }  // namespace
@@ -26,7 +26,7 @@ void iree_task_initialize(iree_task_type_t type, iree_task_scope_t* scope,
   // NOTE: only clears the header, not the task body.
   memset(out_task, 0, sizeof(*out_task));
   out_task->scope = scope;
-  out_task->affinity_set = iree_task_affinity_for_any_worker();
+  out_task->affinity = iree_task_affinity_for_any_worker();
   out_task->type = type;
 }
 
@@ -558,13 +558,11 @@ void iree_task_dispatch_initialize_indirect(
   out_task->workgroup_count.ptr = workgroup_count_ptr;
 }
 
-void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
-                              iree_task_pool_t* shard_task_pool,
-                              iree_task_submission_t* pending_submission,
-                              iree_task_post_batch_t* post_batch) {
-  IREE_TRACE_ZONE_BEGIN(z0);
-  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, dispatch_task->dispatch_id);
-
+// Marks |dispatch_task| as issued and sets up the iteration space that tiles
+// are reserved from. Indirect workgroup counts are resolved and the dispatch is
+// converted to a direct one.
+static void iree_task_dispatch_begin_issue(
+    iree_task_dispatch_t* dispatch_task) {
   // Mark the dispatch as having been issued; the next time it retires it'll be
   // because all work has completed.
   dispatch_task->header.flags |= IREE_TASK_FLAG_DISPATCH_RETIRE;
@@ -574,9 +572,8 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
     // By the task being ready to execute we know any dependencies on the
     // indirection buffer have been satisfied and its safe to read. We perform
     // the indirection here and convert the dispatch to a direct one such that
-    // following code can read the value.
-    // TODO(benvanik): non-one-shot command buffers won't be able to do this as
-    // the intent is that they can be dynamic per execution.
+    // following code can read the value. Reusable command buffers restore the
+    // indirect flag and pointer before each execution.
     const uint32_t* source_ptr = dispatch_task->workgroup_count.ptr;
     memcpy(dispatch_task->workgroup_count.value, source_ptr,
            sizeof(dispatch_task->workgroup_count.value));
@@ -584,9 +581,27 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
   }
   const uint32_t* workgroup_count = dispatch_task->workgroup_count.value;
 
+  // Setup the iteration space for shards to pull work from the complete grid.
+  iree_atomic_store(&dispatch_task->tile_index, 0, iree_memory_order_relaxed);
+  iree_atomic_store(&dispatch_task->tiles_completed, 0,
+                    iree_memory_order_relaxed);
+  dispatch_task->tile_count =
+      workgroup_count[0] * workgroup_count[1] * workgroup_count[2];
+}
+
+void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
+                              iree_task_pool_t* shard_task_pool,
+                              iree_task_submission_t* pending_submission,
+                              iree_task_post_batch_t* post_batch) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, dispatch_task->dispatch_id);
+
+  iree_task_dispatch_begin_issue(dispatch_task);
+
 #if IREE_HAL_VERBOSE_TRACING_ENABLE
   // TODO(benvanik): tracing.h helper that speeds this up; too slow.
   IREE_TRACE({
+    const uint32_t* workgroup_count = dispatch_task->workgroup_count.value;
     char xyz_string[32];
     int xyz_string_length =
         snprintf(xyz_string, IREE_ARRAYSIZE(xyz_string), "%ux%ux%u",
@@ -595,11 +610,6 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
   });
 #endif  // IREE_HAL_VERBOSE_TRACING_ENABLE
 
-  // Setup the iteration space for shards to pull work from the complete grid.
-  iree_atomic_store(&dispatch_task->tile_index, 0, iree_memory_order_relaxed);
-  dispatch_task->tile_count =
-      workgroup_count[0] * workgroup_count[1] * workgroup_count[2];
-
   // Compute shard count - almost always worker_count unless we are a very small
   // dispatch (1x1x1, etc).
   iree_host_size_t worker_count = iree_task_post_batch_worker_count(post_batch);
@@ -620,7 +630,7 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
 
   // Randomize starting worker.
   iree_host_size_t worker_offset = iree_task_post_batch_select_worker(
-      post_batch, dispatch_task->header.affinity_set);
+      post_batch, dispatch_task->header.affinity);
   iree_host_size_t worker_index = worker_offset;
 
   for (iree_host_size_t i = 0; i < shard_count; ++i) {
@@ -648,6 +658,30 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
   IREE_TRACE_ZONE_END(z0);
 }
 
+bool iree_task_dispatch_issue_persistent(
+    iree_task_dispatch_t* dispatch_task,
+    iree_task_submission_t* pending_submission) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, dispatch_task->dispatch_id);
+
+  iree_task_dispatch_begin_issue(dispatch_task);
+
+  // Workers size their reservations based on how long tiles take to execute
+  // and this is only the starting point for their first reservation.
+  dispatch_task->tiles_per_reservation = 1;
+
+  // As with sharded dispatches there may be no tiles to execute; we retire
+  // immediately as no worker will ever see the dispatch.
+  if (dispatch_task->tile_count == 0) {
+    iree_task_dispatch_retire(dispatch_task, pending_submission);
+    IREE_TRACE_ZONE_END(z0);
+    return false;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return true;
+}
+
 void iree_task_dispatch_retire(iree_task_dispatch_t* dispatch_task,
                                iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -677,6 +711,203 @@ void iree_task_dispatch_retire(iree_task_dispatch_t* dispatch_task,
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Prepares the |out_tile_context| shared for all tiles executed by a worker.
+// Returns false if the worker is unable to execute tiles from the dispatch; the
+// failure is propagated to the dispatch status.
+static bool iree_task_dispatch_prepare_tile_context(
+    iree_task_dispatch_t* dispatch_task, iree_cpu_processor_id_t processor_id,
+    uint32_t worker_id, iree_byte_span_t worker_local_memory,
+    iree_task_dispatch_statistics_t* statistics,
+    iree_task_tile_context_t* out_tile_context) {
+  // Require at least the requested amount of worker local memory but pass all
+  // of the available memory. This allows dispatches to use more when available
+  // but still get nice validation here when the minimums aren't met.
+  if (IREE_UNLIKELY(dispatch_task->local_memory_size >
+                    worker_local_memory.data_length)) {
+    iree_task_try_set_status(
+        &dispatch_task->status,
+        iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                         "dispatch requires %ub of local memory but only "
+                         "%" PRIhsz "b is available per-worker",
+                         dispatch_task->local_memory_size,
+                         worker_local_memory.data_length));
+    return false;
+  }
+
+  memcpy(&out_tile_context->workgroup_size, dispatch_task->workgroup_size,
+         sizeof(out_tile_context->workgroup_size));
+  memcpy(&out_tile_context->workgroup_count,
+         dispatch_task->workgroup_count.value,
+         sizeof(out_tile_context->workgroup_count));
+  out_tile_context->worker_id = worker_id;
+  out_tile_context->local_memory = worker_local_memory;
+  out_tile_context->statistics = statistics;
+
+  // Hint as to which processor we are running on.
+  out_tile_context->processor_id = processor_id;
+
+  return true;
+}
+
+// Executes tiles [tile_base, tile_end) of |dispatch_task|.
+// Returns false if any tile fails; the failure is propagated to the dispatch
+// status and the remaining tiles in the range are skipped.
+static bool iree_task_dispatch_execute_tile_range(
+    iree_task_dispatch_t* dispatch_task, iree_task_tile_context_t* tile_context,
+    uint32_t tile_base, uint32_t tile_end,
+    iree_task_submission_t* pending_submission) {
+  const uint32_t workgroup_count_x = tile_context->workgroup_count[0];
+  const uint32_t workgroup_count_y = tile_context->workgroup_count[1];
+  for (uint32_t tile_index = tile_base; tile_index < tile_end; ++tile_index) {
+    // TODO(benvanik): faster math here, especially knowing we pull off N
+    // sequential indices per reservation.
+    uint32_t tile_i = tile_index;
+    tile_context->workgroup_xyz[0] = tile_i % workgroup_count_x;
+    tile_i /= workgroup_count_x;
+    tile_context->workgroup_xyz[1] = tile_i % workgroup_count_y;
+    tile_i /= workgroup_count_y;
+    tile_context->workgroup_xyz[2] = tile_i;
+
+    IREE_TRACE_ZONE_BEGIN_NAMED(z_tile, "iree_task_dispatch_execute_tile");
+    IREE_TRACE_ZONE_SET_COLOR(z_tile, iree_task_tile_to_color(tile_context));
+
+#ifndef NDEBUG
+    // NOTE: these are useful for debugging but dramatically increase our
+    // cost here; only enable if needed for tracking work distribution:
+    IREE_TRACE_ZONE_APPEND_VALUE_I64(z_tile, tile_context->workgroup_xyz[0]);
+    IREE_TRACE_ZONE_APPEND_VALUE_I64(z_tile, tile_context->workgroup_xyz[1]);
+    IREE_TRACE_ZONE_APPEND_VALUE_I64(z_tile, tile_context->workgroup_xyz[2]);
+    // IREE_TRACE_ZONE_APPEND_VALUE_I64(z_tile, (uint64_t)task->closure.fn);
+#endif  // !NDEBUG
+
+    iree_status_t status =
+        dispatch_task->closure.fn(dispatch_task->closure.user_context,
+                                  tile_context, pending_submission);
+
+    IREE_TRACE_ZONE_END(z_tile);
+
+    // If any tile fails we bail early from the loop. This doesn't match
+    // what an accelerator would do but saves some unneeded work.
+    // Note that other workers may have completed execution, be executing
+    // concurrently with this one, or still be pending - this does not
+    // have any influence on them and they may continue to execute even
+    // after we bail from here.
+    if (!iree_status_is_ok(status)) {
+      // Propagate failures to the dispatch task.
+      iree_task_try_set_status(&dispatch_task->status, status);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the number of tiles a worker should reserve from a persistent
+// dispatch given that its last reservation of |tile_count| tiles took
+// |duration_ns| to execute.
+static uint32_t iree_task_dispatch_persistent_tiles_per_reservation(
+    uint32_t tile_count, iree_duration_t duration_ns) {
+  if (duration_ns <= 0) {
+    return IREE_TASK_DISPATCH_PERSISTENT_MAX_TILES_PER_RESERVATION;
+  }
+  int64_t tiles_per_reservation =
+      (int64_t)IREE_TASK_DISPATCH_PERSISTENT_TARGET_RESERVATION_NS *
+      tile_count / duration_ns;
+  return (uint32_t)iree_min(
+      iree_max(tiles_per_reservation, 1),
+      IREE_TASK_DISPATCH_PERSISTENT_MAX_TILES_PER_RESERVATION);
+}
+
+bool iree_task_dispatch_execute_persistent(
+    iree_task_dispatch_t* dispatch_task, iree_host_size_t worker_count,
+    iree_cpu_processor_id_t processor_id, uint32_t worker_id,
+    iree_byte_span_t worker_local_memory,
+    iree_task_submission_t* pending_submission, bool* out_completed) {
+  *out_completed = false;
+
+  // Cheap early-out for workers arriving after all tiles have been reserved.
+  const uint32_t tile_count = dispatch_task->tile_count;
+  if ((uint32_t)iree_atomic_load(&dispatch_task->tile_index,
+                                 iree_memory_order_relaxed) >= tile_count) {
+    return false;
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, dispatch_task->dispatch_id);
+  IREE_TRACE_ZONE_SET_COLOR(
+      z0, iree_math_ptr_to_xrgb(dispatch_task->closure.user_context));
+
+  // We perform all our statistics work locally here and only push back to the
+  // dispatch at the end; this avoids contention from each worker trying to
+  // update the statistics together.
+  iree_task_dispatch_statistics_t worker_statistics;
+  memset(&worker_statistics, 0, sizeof(worker_statistics));
+  iree_task_tile_context_t tile_context;
+  bool is_ok = iree_task_dispatch_prepare_tile_context(
+      dispatch_task, processor_id, worker_id, worker_local_memory,
+      &worker_statistics, &tile_context);
+
+  // Reserve ranges of tiles until the grid is exhausted. The size of each
+  // reservation adapts to the measured cost of the tiles this worker has
+  // executed but is never more than a fraction of the remaining tiles so that
+  // the tail of the grid is spread across all workers (guided scheduling).
+  uint32_t tiles_per_reservation = dispatch_task->tiles_per_reservation;
+  const uint32_t guided_divisor = (uint32_t)worker_count * 2;
+  bool did_reserve = false;
+  while (true) {
+    uint32_t tile_base = (uint32_t)iree_atomic_load(&dispatch_task->tile_index,
+                                                    iree_memory_order_relaxed);
+    if (tile_base >= tile_count) break;
+    uint32_t tile_reservation = iree_min(
+        tiles_per_reservation, (tile_count - tile_base) / guided_divisor);
+    if (!is_ok) {
+      // Failed workers drain tiles without executing them so that the
+      // dispatch can complete and report the failure as soon as possible.
+      tile_reservation =
+          IREE_TASK_DISPATCH_PERSISTENT_MAX_TILES_PER_RESERVATION;
+    }
+    tile_reservation = iree_max(tile_reservation, 1u);
+
+    // relaxed order because we only care about atomic increments, not about
+    // ordering of tile_index accesses w.r.t. other memory accesses.
+    tile_base =
+        (uint32_t)iree_atomic_fetch_add(&dispatch_task->tile_index,
+                                        tile_reservation,
+                                        iree_memory_order_relaxed);
+    if (tile_base >= tile_count) break;
+    const uint32_t tile_end = iree_min(tile_base + tile_reservation, tile_count);
+    did_reserve = true;
+
+    if (is_ok) {
+      iree_time_t start_ns = iree_time_now();
+      is_ok = iree_task_dispatch_execute_tile_range(
+          dispatch_task, &tile_context, tile_base, tile_end,
+          pending_submission);
+      tiles_per_reservation =
+          iree_task_dispatch_persistent_tiles_per_reservation(
+              tile_end - tile_base, iree_time_now() - start_ns);
+    }
+
+    // The worker completing the final tile of the grid is responsible for
+    // finishing the dispatch. acq_rel so that all tile side-effects from other
+    // workers are visible to whoever retires the dispatch.
+    const uint32_t range_count = tile_end - tile_base;
+    if ((uint32_t)iree_atomic_fetch_add(&dispatch_task->tiles_completed,
+                                        range_count,
+                                        iree_memory_order_acq_rel) +
+            range_count ==
+        tile_count) {
+      *out_completed = true;
+    }
+  }
+
+  // Push aggregate statistics up to the dispatch.
+  iree_task_dispatch_statistics_merge(&worker_statistics,
+                                      &dispatch_task->statistics);
+
+  IREE_TRACE_ZONE_END(z0);
+  return did_reserve;
+}
+
 //==============================================================================
 // IREE_TASK_TYPE_DISPATCH_SHARD
 //==============================================================================
@@ -718,43 +949,21 @@ void iree_task_dispatch_shard_execute(
   IREE_TRACE_ZONE_SET_COLOR(
       z0, iree_math_ptr_to_xrgb(dispatch_task->closure.user_context));
 
-  // Require at least the requested amount of worker local memory but pass all
-  // of the available memory. This allows dispatches to use more when available
-  // but still get nice validation here when the minimums aren't met.
-  if (IREE_UNLIKELY(dispatch_task->local_memory_size >
-                    worker_local_memory.data_length)) {
-    iree_task_try_set_status(
-        &dispatch_task->status,
-        iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
-                         "dispatch requires %ub of local memory but only "
-                         "%" PRIhsz "b is available per-worker",
-                         dispatch_task->local_memory_size,
-                         worker_local_memory.data_length));
-    iree_task_retire(&task->header, pending_submission, iree_ok_status());
-    IREE_TRACE_ZONE_END(z0);
-    return;
-  }
-
-  // Prepare context shared for all tiles in the shard.
-  iree_task_tile_context_t tile_context;
-  memcpy(&tile_context.workgroup_size, dispatch_task->workgroup_size,
-         sizeof(tile_context.workgroup_size));
-  memcpy(&tile_context.workgroup_count, dispatch_task->workgroup_count.value,
-         sizeof(tile_context.workgroup_count));
-  uint32_t workgroup_count_x = tile_context.workgroup_count[0];
-  uint32_t workgroup_count_y = tile_context.workgroup_count[1];
-  tile_context.worker_id = worker_id;
-  tile_context.local_memory = worker_local_memory;
-
   // We perform all our shard statistics work locally here and only push back to
   // the dispatch at the end; this avoids contention from each shard trying to
   // update the statistics together.
   iree_task_dispatch_statistics_t shard_statistics;
   memset(&shard_statistics, 0, sizeof(shard_statistics));
-  tile_context.statistics = &shard_statistics;
 
-  // Hint as to which processor we are running on.
-  tile_context.processor_id = processor_id;
+  // Prepare context shared for all tiles in the shard.
+  iree_task_tile_context_t tile_context;
+  if (IREE_UNLIKELY(!iree_task_dispatch_prepare_tile_context(
+          dispatch_task, processor_id, worker_id, worker_local_memory,
+          &shard_statistics, &tile_context))) {
+    iree_task_retire(&task->header, pending_submission, iree_ok_status());
+    IREE_TRACE_ZONE_END(z0);
+    return;
+  }
 
   // Loop over all tiles until they are all processed.
   const uint32_t tile_count = dispatch_task->tile_count;
@@ -767,47 +976,10 @@ void iree_task_dispatch_shard_execute(
   while (tile_base < tile_count) {
     const uint32_t tile_range =
         iree_min(tile_base + tiles_per_reservation, tile_count);
-    for (uint32_t tile_index = tile_base; tile_index < tile_range;
-         ++tile_index) {
-      // TODO(benvanik): faster math here, especially knowing we pull off N
-      // sequential indices per reservation.
-      uint32_t tile_i = tile_index;
-      tile_context.workgroup_xyz[0] = tile_i % workgroup_count_x;
-      tile_i /= workgroup_count_x;
-      tile_context.workgroup_xyz[1] = tile_i % workgroup_count_y;
-      tile_i /= workgroup_count_y;
-      tile_context.workgroup_xyz[2] = tile_i;
-
-      IREE_TRACE_ZONE_BEGIN_NAMED(z_tile,
-                                  "iree_task_dispatch_shard_execute_tile");
-      IREE_TRACE_ZONE_SET_COLOR(z_tile, iree_task_tile_to_color(&tile_context));
-
-#ifndef NDEBUG
-      // NOTE: these are useful for debugging but dramatically increase our
-      // cost here; only enable if needed for tracking work distribution:
-      IREE_TRACE_ZONE_APPEND_VALUE_I64(z_tile, tile_context.workgroup_xyz[0]);
-      IREE_TRACE_ZONE_APPEND_VALUE_I64(z_tile, tile_context.workgroup_xyz[1]);
-      IREE_TRACE_ZONE_APPEND_VALUE_I64(z_tile, tile_context.workgroup_xyz[2]);
-      // IREE_TRACE_ZONE_APPEND_VALUE_I64(z_tile, (uint64_t)task->closure.fn);
-#endif  // !NDEBUG
-
-      iree_status_t status =
-          dispatch_task->closure.fn(dispatch_task->closure.user_context,
-                                    &tile_context, pending_submission);
-
-      IREE_TRACE_ZONE_END(z_tile);
-
-      // If any tile fails we bail early from the loop. This doesn't match
-      // what an accelerator would do but saves some unneeded work.
-      // Note that other shards may have completed execution, be executing
-      // concurrently with this one, or still be pending - this does not
-      // have any influence on them and they may continue to execute even
-      // after we bail from here.
-      if (!iree_status_is_ok(status)) {
-        // Propagate failures to the dispatch task.
-        iree_task_try_set_status(&dispatch_task->status, status);
-        goto abort_shard;  // out of the while-for nest
-      }
+    if (!iree_task_dispatch_execute_tile_range(dispatch_task, &tile_context,
+                                               tile_base, tile_range,
+                                               pending_submission)) {
+      break;  // failure propagated to the dispatch
     }
 
     // Try to grab the next slice of tiles.
@@ -815,7 +987,6 @@ void iree_task_dispatch_shard_execute(
         iree_atomic_fetch_add(&dispatch_task->tile_index, tiles_per_reservation,
                               iree_memory_order_relaxed);
   }
-abort_shard:
 
   // Push aggregate statistics up to the dispatch.
   // Note that we may have partial information here if we errored out of the
@@ -162,7 +162,10 @@ struct iree_alignas(iree_max_align_t) iree_task_t {
   // of the specific work being performed. For example, some dispatches can be
   // limited to run on certain microarchitectures that workers have affinity
   // with at the OS scheduler level (such as little.BIG topologies).
-  iree_task_affinity_set_t affinity_set;
+  //
+  // LAYOUT: packed next to pending_dependency_count to fill what would
+  //         otherwise be padding.
+  iree_task_affinity_t affinity;
 
   // Total number of dependent tasks still outstanding. Decremented each time
   // a dependent task completes. The task is considered ready to execute when
@@ -653,6 +656,11 @@ typedef iree_alignas(iree_max_align_t) struct iree_task_dispatch_t {
   // per shard instead of once per slice and are less of a concern.
   iree_atomic_int32_t tile_index;
 
+  // The number of tiles that have finished executing. Only used when the
+  // dispatch is executed in persistent mode where there are no shard tasks to
+  // join on: the worker that completes the final tile finishes the dispatch.
+  iree_atomic_int32_t tiles_completed;
+
   // Incrementing process-lifetime dispatch identifier.
   IREE_TRACE(int64_t dispatch_id;)
 } iree_task_dispatch_t;
@@ -92,6 +92,35 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
                               iree_task_submission_t* pending_submission,
                               iree_task_post_batch_t* post_batch);
 
+// Prepares a dispatch for persistent execution without forking shards.
+// Workers claim tiles directly from the dispatch with
+// iree_task_dispatch_execute_persistent once it has been published by the
+// executor. Returns false if the dispatch had no tiles and was retired
+// immediately, in which case it must not be published.
+//
+// Only called during coordination and expects the coordinator lock to be held.
+bool iree_task_dispatch_issue_persistent(
+    iree_task_dispatch_t* dispatch_task,
+    iree_task_submission_t* pending_submission);
+
+// Executes tiles from a persistently issued dispatch on the calling worker
+// until all tiles in the grid have been reserved. Multiple workers may execute
+// the same dispatch concurrently. Returns true if any tiles were reserved by
+// the caller.
+//
+// |worker_count| is the total number of workers that may be executing the
+// dispatch and bounds the reservation size so the tail of the grid is spread
+// across them. |out_completed| is set to true if the caller completed the final
+// tile of the dispatch; the dispatch must then be retired once no other worker
+// is accessing it.
+//
+// Errors are propagated to the dispatch status and reported when it retires.
+bool iree_task_dispatch_execute_persistent(
+    iree_task_dispatch_t* dispatch_task, iree_host_size_t worker_count,
+    iree_cpu_processor_id_t processor_id, uint32_t worker_id,
+    iree_byte_span_t worker_local_memory,
+    iree_task_submission_t* pending_submission, bool* out_completed);
+
 // Retires a dispatch when all issued shards have completed executing.
 //
 // Only called during coordination and expects the coordinator lock to be held.
@@ -7,11 +7,13 @@
 #include <cstdint>
 #include <cstdio>
 #include <memory>
+#include <vector>
 
 #include "iree/base/api.h"
 #include "iree/task/submission.h"
 #include "iree/task/task.h"
 #include "iree/task/testing/task_test.h"
+#include "iree/task/tuning.h"
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
 
@@ -213,4 +215,97 @@ TEST_F(TaskDispatchTest, IssueFailureChained) {
               StatusIs(StatusCode::kDataLoss));
 }
 
+// Runs the same dispatches through an executor using persistent dispatches
+// where workers claim tiles directly instead of executing shard tasks.
+class TaskDispatchPersistentTest : public TaskDispatchTest {
+ public:
+  TaskDispatchPersistentTest() {
+    scheduling_mode_ = IREE_TASK_SCHEDULING_MODE_PERSISTENT_DISPATCH;
+  }
+};
+
+TEST_F(TaskDispatchPersistentTest, Issue000) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {0, 0, 0};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
+}
+
+TEST_F(TaskDispatchPersistentTest, Issue111) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {1, 1, 1};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
+}
+
+TEST_F(TaskDispatchPersistentTest, Issue345) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {3, 4, 5};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
+}
+
+TEST_F(TaskDispatchPersistentTest, IssueLarge) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {1000, 7, 3};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
+}
+
+// Issues more concurrent dispatches than there are persistent slots so that
+// some are sharded and others executed persistently.
+TEST_F(TaskDispatchPersistentTest, IssueConcurrent) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {33, 5, 1};
+  static const int kDispatchCount =
+      IREE_TASK_EXECUTOR_PERSISTENT_DISPATCH_SLOT_COUNT * 4;
+
+  std::vector<std::unique_ptr<GridCoverage>> coverages;
+  std::vector<iree_task_dispatch_t> dispatch_tasks(kDispatchCount);
+  iree_task_nop_t join_task;
+  iree_task_nop_initialize(&scope_, &join_task);
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  for (int i = 0; i < kDispatchCount; ++i) {
+    coverages.push_back(std::make_unique<GridCoverage>(kWorkgroupCount));
+    iree_task_dispatch_initialize(
+        &scope_,
+        iree_task_make_dispatch_closure(GridCoverage::Tile,
+                                        (void*)coverages.back().get()),
+        kWorkgroupSize, kWorkgroupCount, &dispatch_tasks[i]);
+    iree_task_set_completion_task(&dispatch_tasks[i].header,
+                                  &join_task.header);
+    iree_task_submission_enqueue(&submission, &dispatch_tasks[i].header);
+  }
+  IREE_ASSERT_OK(SubmitAndWaitIdle(&submission, &join_task.header));
+  for (auto& coverage : coverages) {
+    EXPECT_TRUE(coverage->Verify());
+  }
+}
+
+TEST_F(TaskDispatchPersistentTest, IssueFailure) {
+  IREE_TRACE_SCOPE();
+
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {64, 1, 1};
+
+  auto tile = [](void* user_context,
+                 const iree_task_tile_context_t* tile_context,
+                 iree_task_submission_t* pending_submission) -> iree_status_t {
+    IREE_TRACE_SCOPE();
+    return tile_context->workgroup_xyz[0] == 32
+               ? iree_make_status(IREE_STATUS_DATA_LOSS, "whoops!")
+               : iree_ok_status();
+  };
+
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(&scope_,
+                                iree_task_make_dispatch_closure(tile, NULL),
+                                kWorkgroupSize, kWorkgroupCount, &task);
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_THAT(Status(iree_task_scope_consume_status(&scope_)),
+              StatusIs(StatusCode::kDataLoss));
+}
+
 }  // namespace
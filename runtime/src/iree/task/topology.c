@@ -12,13 +12,88 @@
 #include "iree/base/api.h"
 
 void iree_task_topology_group_initialize(
-    uint8_t group_index, iree_task_topology_group_t* out_group) {
+    uint16_t group_index, iree_task_topology_group_t* out_group) {
   memset(out_group, 0, sizeof(*out_group));
   out_group->group_index = group_index;
   snprintf(out_group->name, IREE_ARRAYSIZE(out_group->name), "iree-worker-%u",
            group_index);
   iree_thread_affinity_set_any(&out_group->ideal_thread_affinity);
-  out_group->constructive_sharing_mask = IREE_TASK_TOPOLOGY_GROUP_MASK_ALL;
+  out_group->constructive_sharing_mask =
+      iree_task_affinity_set_ones(IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT);
+}
+
+// Parses a decimal ID containing only digits.
+static bool iree_task_topology_parse_id(iree_string_view_t value,
+                                        uint32_t* out_id) {
+  if (iree_string_view_is_empty(value)) return false;
+  uint64_t id = 0;
+  for (iree_host_size_t i = 0; i < value.size; ++i) {
+    const char c = value.data[i];
+    if (c < '0' || c > '9') return false;
+    id = id * 10 + (uint64_t)(c - '0');
+    if (id > UINT32_MAX) return false;
+  }
+  *out_id = (uint32_t)id;
+  return true;
+}
+
+// Walks the entries of an ID list and calls |visitor| (if provided) with each
+// ID. Parsing stops at the first malformed entry.
+static iree_status_t iree_task_topology_visit_id_list(
+    iree_string_view_t value, iree_task_topology_id_list_visitor_fn_t visitor,
+    void* user_data, uint32_t* out_count) {
+  uint32_t count = 0;
+  iree_string_view_t remaining = iree_string_view_trim(value);
+  while (!iree_string_view_is_empty(remaining)) {
+    iree_string_view_t entry = iree_string_view_empty();
+    const bool has_more =
+        iree_string_view_split(remaining, ',', &entry, &remaining) != -1;
+    if (has_more && iree_string_view_is_empty(remaining)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "trailing ',' in ID list '%.*s'",
+                              (int)value.size, value.data);
+    }
+    iree_string_view_t first_str = iree_string_view_empty();
+    iree_string_view_t last_str = iree_string_view_empty();
+    uint32_t first = 0;
+    uint32_t last = 0;
+    bool valid = false;
+    if (iree_string_view_split(entry, '-', &first_str, &last_str) == -1) {
+      valid = iree_task_topology_parse_id(entry, &first);
+      last = first;
+    } else {
+      valid = iree_task_topology_parse_id(first_str, &first) &&
+              iree_task_topology_parse_id(last_str, &last) && first <= last;
+    }
+    if (!valid || last - first >= UINT32_MAX - count) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "malformed ID list entry '%.*s' in '%.*s'",
+                              (int)entry.size, entry.data, (int)value.size,
+                              value.data);
+    }
+    if (visitor) {
+      for (uint64_t id = first; id <= last; ++id) {
+        visitor(user_data, (uint32_t)id);
+      }
+    }
+    count += last - first + 1;
+  }
+  *out_count = count;
+  return iree_ok_status();
+}
+
+iree_status_t iree_task_topology_parse_id_list(
+    iree_string_view_t value, iree_task_topology_id_list_visitor_fn_t visitor,
+    void* user_data, uint32_t* out_count) {
+  IREE_ASSERT_ARGUMENT(out_count);
+  *out_count = 0;
+  // Validate the entire list before visiting any ID so that visitors never
+  // observe a partial list.
+  IREE_RETURN_IF_ERROR(
+      iree_task_topology_visit_id_list(value, NULL, NULL, out_count));
+  if (!visitor) return iree_ok_status();
+  return iree_task_topology_visit_id_list(value, visitor, user_data,
+                                          out_count);
 }
 
 void iree_task_topology_initialize(iree_task_topology_t* out_topology) {
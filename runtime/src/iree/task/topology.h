@@ -13,6 +13,7 @@
 
 #include "iree/base/api.h"
 #include "iree/base/internal/threading.h"
+#include "iree/task/affinity_set.h"
 #include "iree/task/tuning.h"
 
 #ifdef __cplusplus
@@ -30,24 +31,44 @@ typedef uint32_t iree_task_topology_node_id_t;
 #define IREE_TASK_TOPOLOGY_NODE_ID_ANY ((iree_task_topology_node_id_t) - 1)
 
 // Returns the total number of NUMA nodes in the system or 1 if the query is
-// not available on the platform.
+// not available on the platform. On Linux nodes are discovered from sysfs and
+// on systems with a single NUMA node this may instead return the number of
+// processor clusters.
 iree_host_size_t iree_task_topology_query_node_count(void);
 
 // Returns the NUMA node ID of the currently executing thread or 0 if the query
 // is not available on the platform.
 iree_task_topology_node_id_t iree_task_topology_query_current_node(void);
 
+// Called with each ID listed in an ID list.
+typedef void (*iree_task_topology_id_list_visitor_fn_t)(void* user_data,
+                                                        uint32_t id);
+
+// Parses an ID list in the Linux sysfs format (like the `0-1,3` contents of
+// `/sys/devices/system/node/online` or a node `cpulist`) and calls |visitor|
+// (if provided) for each ID listed in order. Lists are comma-separated decimal
+// IDs or inclusive `first-last` ranges and may be sparse; surrounding
+// whitespace is ignored and an empty list is valid. |out_count| receives the
+// total number of IDs listed.
+//
+// Returns INVALID_ARGUMENT if the list is malformed, in which case |visitor| is
+// not called.
+iree_status_t iree_task_topology_parse_id_list(
+    iree_string_view_t value, iree_task_topology_id_list_visitor_fn_t visitor,
+    void* user_data, uint32_t* out_count);
+
 //===----------------------------------------------------------------------===//
 // Topology group (worker thread(s) assigned to a processor)
 //===----------------------------------------------------------------------===//
 
 // A bitmask indicating which other groups from 0 to N may constructively share
 // caches. For example, a value of 0b1100 indicates that group 2 and 3 share.
-typedef uint64_t iree_task_topology_group_mask_t;
+// Groups map 1:1 to executor workers and the mask uses the same multi-word
+// bitset as the executor worker masks.
+typedef iree_task_affinity_set_t iree_task_topology_group_mask_t;
 
-#define IREE_TASK_TOPOLOGY_GROUP_MASK_ALL UINT64_MAX
 #define IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT \
-  (sizeof(iree_task_topology_group_mask_t) * 8)
+  ((size_t)IREE_TASK_EXECUTOR_MAX_WORKER_COUNT)
 
 // Total cache sizes (that we care about).
 // More information may be available but we shouldn't be specializing on it
@@ -66,14 +87,19 @@ typedef struct iree_task_topology_caches_t {
 typedef struct iree_task_topology_group_t {
   // Group index within the topology matching a particular bit in
   // iree_task_topology_group_mask_t.
-  uint8_t group_index;
+  uint16_t group_index;
 
   // A name assigned to executor workers used for logging/tracing.
-  char name[32 - /*group_index*/ 1];
+  char name[32 - /*group_index*/ 2];
 
   // Logical processor index.
   uint32_t processor_index;
 
+  // NUMA node the processor resides on. Workers prefer stealing from other
+  // workers on the same node before crossing to remote nodes and their local
+  // memory is placed on this node when the platform supports it.
+  iree_task_topology_node_id_t node_id;
+
   // Total cache sizes (that we care about).
   iree_task_topology_caches_t caches;
 
@@ -91,7 +117,7 @@ typedef struct iree_task_topology_group_t {
 } iree_task_topology_group_t;
 
 // Initializes |out_group| with a |group_index| derived name.
-void iree_task_topology_group_initialize(uint8_t group_index,
+void iree_task_topology_group_initialize(uint16_t group_index,
                                          iree_task_topology_group_t* out_group);
 
 //===----------------------------------------------------------------------===//
@@ -212,7 +238,9 @@ typedef enum iree_task_topology_performance_level_e {
 
 // Initializes a topology with one group for each physical core with the given
 // NUMA |node_id| (usually package or cluster). Up to |max_core_count| physical
-// cores will be selected from the node.
+// cores will be selected from the node. IREE_TASK_TOPOLOGY_NODE_ID_ANY selects
+// cores from all nodes and records the node of each group such that workers
+// can prefer node-local memory and stealing.
 iree_status_t iree_task_topology_initialize_from_physical_cores(
     iree_task_topology_node_id_t node_id,
     iree_task_topology_performance_level_t performance_level,
@@ -5,12 +5,19 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
 #include "iree/base/api.h"
+#include "iree/base/internal/call_once.h"
 #include "iree/base/internal/math.h"
 #include "iree/task/topology.h"
 
 #if !defined(IREE_PLATFORM_APPLE) && !defined(IREE_PLATFORM_EMSCRIPTEN) && \
     !defined(IREE_PLATFORM_WINDOWS)
 
+#if defined(IREE_PLATFORM_LINUX)
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // IREE_PLATFORM_LINUX
+
 // Initializes |out_topology| with a standardized behavior when cpuinfo is not
 // available (unsupported arch, failed to query, etc).
 static void iree_task_topology_initialize_fallback(
@@ -28,12 +35,145 @@ static void iree_task_topology_initialize_fallback(
   IREE_TRACE_ZONE_END(z0);
 }
 
+//===----------------------------------------------------------------------===//
+// NUMA queries (sysfs)
+//===----------------------------------------------------------------------===//
+
+#if defined(IREE_PLATFORM_LINUX)
+
+// Reads a sysfs list file (like `/sys/devices/system/node/online` containing
+// `0-1,3`) and calls |visitor| for each ID listed. Returns the number of IDs
+// listed or 0 if the file could not be read or parsed.
+static uint32_t iree_task_topology_read_sysfs_list(
+    const char* path, iree_task_topology_id_list_visitor_fn_t visitor,
+    void* user_data) {
+  FILE* file = fopen(path, "r");
+  if (!file) return 0;
+  // sysfs attributes are at most one page so this reads the entire list.
+  char buffer[4096];
+  size_t length = fread(buffer, 1, sizeof(buffer), file);
+  fclose(file);
+  uint32_t count = 0;
+  iree_status_t status = iree_task_topology_parse_id_list(
+      iree_make_string_view(buffer, length), visitor, user_data, &count);
+  if (!iree_status_is_ok(status)) {
+    iree_status_ignore(status);
+    return 0;
+  }
+  return count;
+}
+
+// Maximum Linux processor ID tracked in the processor->node map. Processors
+// with larger IDs are reported as having an unknown node.
+#define IREE_TASK_TOPOLOGY_SYSFS_MAX_PROCESSOR_COUNT 4096
+
+// NUMA node information read from sysfs once per process.
+static iree_once_flag iree_task_topology_sysfs_nodes_flag = IREE_ONCE_FLAG_INIT;
+static struct {
+  // Total number of online NUMA nodes or 0 if unavailable.
+  uint32_t node_count;
+  // Node ID + 1 of each processor indexed by Linux processor ID or 0 if the
+  // processor is not listed by any node.
+  uint16_t processor_nodes[IREE_TASK_TOPOLOGY_SYSFS_MAX_PROCESSOR_COUNT];
+} iree_task_topology_sysfs_nodes;
+
+static void iree_task_topology_assign_sysfs_processor_node(void* user_data,
+                                                           uint32_t id) {
+  if (id >= IREE_TASK_TOPOLOGY_SYSFS_MAX_PROCESSOR_COUNT) return;
+  const uint32_t node_id = (uint32_t)(uintptr_t)user_data;
+  iree_task_topology_sysfs_nodes.processor_nodes[id] = (uint16_t)(node_id + 1);
+}
+
+static void iree_task_topology_query_sysfs_node_cpus(void* user_data,
+                                                     uint32_t node_id) {
+  if (node_id >= UINT16_MAX) return;
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist",
+           node_id);
+  iree_task_topology_read_sysfs_list(
+      path, iree_task_topology_assign_sysfs_processor_node,
+      (void*)(uintptr_t)node_id);
+}
+
+// Reads the online node list and the processors of each node. This is one
+// file per node instead of scanning one directory per processor.
+static void iree_task_topology_query_sysfs_nodes_once(void) {
+  iree_task_topology_sysfs_nodes.node_count =
+      iree_task_topology_read_sysfs_list(
+          "/sys/devices/system/node/online",
+          iree_task_topology_query_sysfs_node_cpus, NULL);
+}
+
+// Returns the number of NUMA nodes reported by sysfs or 0 if unavailable (no
+// sysfs, kernel built without CONFIG_NUMA, sandboxed, etc).
+static uint32_t iree_task_topology_query_sysfs_node_count(void) {
+  iree_call_once(&iree_task_topology_sysfs_nodes_flag,
+                 iree_task_topology_query_sysfs_nodes_once);
+  return iree_task_topology_sysfs_nodes.node_count;
+}
+
+// Queries the NUMA node of the logical processor with the given Linux
+// |processor_id| from the node cpulists read once from sysfs. Returns false if
+// the node could not be determined.
+static bool iree_task_topology_query_sysfs_processor_node(
+    uint32_t processor_id, iree_task_topology_node_id_t* out_node_id) {
+  *out_node_id = 0;
+  iree_call_once(&iree_task_topology_sysfs_nodes_flag,
+                 iree_task_topology_query_sysfs_nodes_once);
+  if (processor_id >= IREE_TASK_TOPOLOGY_SYSFS_MAX_PROCESSOR_COUNT) {
+    return false;
+  }
+  const uint16_t node_id_plus_one =
+      iree_task_topology_sysfs_nodes.processor_nodes[processor_id];
+  if (!node_id_plus_one) return false;
+  *out_node_id = (iree_task_topology_node_id_t)(node_id_plus_one - 1);
+  return true;
+}
+
+// Queries the NUMA node the calling thread is currently running on.
+// Returns false if the node could not be determined.
+static bool iree_task_topology_query_sysfs_current_node(
+    iree_task_topology_node_id_t* out_node_id) {
+  *out_node_id = 0;
+#if defined(SYS_getcpu)
+  unsigned int cpu = 0;
+  unsigned int node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0) {
+    *out_node_id = (iree_task_topology_node_id_t)node;
+    return true;
+  }
+#endif  // SYS_getcpu
+  return false;
+}
+
+#else
+
+static uint32_t iree_task_topology_query_sysfs_node_count(void) { return 0; }
+
+IREE_ATTRIBUTE_UNUSED static bool iree_task_topology_query_sysfs_processor_node(
+    uint32_t processor_id, iree_task_topology_node_id_t* out_node_id) {
+  *out_node_id = 0;
+  return false;
+}
+
+static bool iree_task_topology_query_sysfs_current_node(
+    iree_task_topology_node_id_t* out_node_id) {
+  *out_node_id = 0;
+  return false;
+}
+
+#endif  // IREE_PLATFORM_LINUX
+
 #if defined(IREE_TASK_CPUINFO_DISABLED)
 
-iree_host_size_t iree_task_topology_query_node_count(void) { return 1; }
+iree_host_size_t iree_task_topology_query_node_count(void) {
+  return iree_max(1u, iree_task_topology_query_sysfs_node_count());
+}
 
 iree_task_topology_node_id_t iree_task_topology_query_current_node(void) {
-  return 0;
+  iree_task_topology_node_id_t node_id = 0;
+  iree_task_topology_query_sysfs_current_node(&node_id);
+  return node_id;
 }
 
 iree_status_t iree_task_topology_fixup_constructive_sharing_masks(
@@ -64,14 +204,15 @@ iree_status_t iree_task_topology_initialize_from_logical_cpu_set(
     iree_task_topology_group_t* group = &out_topology->groups[i];
     iree_task_topology_group_initialize(i, group);
     group->processor_index = cpu_ids[i];
+    iree_task_topology_query_sysfs_processor_node(cpu_ids[i], &group->node_id);
 
     // NOTE: without cpuinfo we can't get cache sizes so we just guess some
     // conservative values.
     group->caches.l1_data = 32 * 1024;
     group->caches.l2_data = 128 * 1024;
 
-    // NOTE: without cpuinfo we can't get SMT and node info but this isn't
-    // really used on Linux today anyway.
+    // NOTE: without cpuinfo we can't get SMT info but this isn't really used on
+    // Linux today anyway.
     iree_thread_affinity_t* affinity = &group->ideal_thread_affinity;
     memset(affinity, 0, sizeof(*affinity));
     affinity->specified = 1;
@@ -101,9 +242,19 @@ static bool iree_task_topology_is_cpuinfo_available() {
   return cpuinfo_initialize() && cpuinfo_get_cores_count() > 0;
 }
 
+// Returns true if the system has more than one NUMA node and nodes should be
+// used instead of cpuinfo clusters. Single-node systems (desktops, phones) keep
+// using clusters so that heterogeneous cores can still be partitioned.
+static bool iree_task_topology_has_numa_nodes(void) {
+  return iree_task_topology_query_sysfs_node_count() > 1;
+}
+
 // TODO(benvanik): change to a system API and move to iree/base/allocator.h so
 // it can be used there for binding memory to nodes.
 iree_host_size_t iree_task_topology_query_node_count(void) {
+  if (iree_task_topology_has_numa_nodes()) {
+    return iree_task_topology_query_sysfs_node_count();
+  }
   if (!iree_task_topology_is_cpuinfo_available()) return 1;
   // NOTE: this may span across packages!
   return cpuinfo_get_clusters_count();
@@ -117,12 +268,33 @@ static const struct cpuinfo_core* iree_task_topology_get_current_core() {
 }
 
 iree_task_topology_node_id_t iree_task_topology_query_current_node(void) {
+  iree_task_topology_node_id_t node_id = 0;
+  if (iree_task_topology_has_numa_nodes() &&
+      iree_task_topology_query_sysfs_current_node(&node_id)) {
+    return node_id;
+  }
   if (!iree_task_topology_is_cpuinfo_available()) return 0;
   const struct cpuinfo_core* current_core =
       iree_task_topology_get_current_core();
   return current_core ? current_core->cluster->cluster_id : 0;
 }
 
+// Returns the node |processor| resides on as reported by
+// iree_task_topology_query_node_count: the NUMA node when the system has
+// multiple and otherwise the cpuinfo cluster.
+static iree_task_topology_node_id_t iree_task_topology_query_processor_node(
+    const struct cpuinfo_processor* processor) {
+#if defined(__linux__)
+  iree_task_topology_node_id_t node_id = 0;
+  if (iree_task_topology_has_numa_nodes() &&
+      iree_task_topology_query_sysfs_processor_node(processor->linux_id,
+                                                    &node_id)) {
+    return node_id;
+  }
+#endif  // __linux__
+  return processor->cluster->cluster_id;
+}
+
 // Returns |core_id| rotated by the calling base core ID.
 // On many systems the kernel will have already assigned a randomized starting
 // core for thread distribution and we can just reuse that.
@@ -182,6 +354,7 @@ static void iree_task_topology_group_initialize_from_processor(
   out_group->processor_index =
       processor->core->processor_start + processor->smt_id;
 #endif  // __linux__
+  out_group->node_id = iree_task_topology_query_processor_node(processor);
   out_group->caches.l1_data =
       processor->cache.l1d ? processor->cache.l1d->size : 0;
   out_group->caches.l2_data =
@@ -206,33 +379,26 @@ static void iree_task_topology_group_initialize_from_core(
                                                      out_group);
 }
 
-// Returns a bitset with all *processors* that share the same |cache|.
-static uint64_t iree_task_topology_calculate_cache_bits(
-    const struct cpuinfo_cache* cache) {
-  if (!cache) return 0;
-  uint64_t mask = 0;
-  for (uint32_t processor_i = 0; processor_i < cache->processor_count;
-       ++processor_i) {
-    uint32_t i = cache->processor_start + processor_i;
-    if (i < IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT) {
-      mask |= 1ull << i;
-    }
-  }
-  return mask;
+// Returns true if |processor_index| shares the given |cache|.
+static bool iree_task_topology_cache_contains_processor(
+    const struct cpuinfo_cache* cache, uint32_t processor_index) {
+  if (!cache) return false;
+  return processor_index - cache->processor_start < cache->processor_count;
 }
 
-// Constructs a constructive sharing mask for all *processors* that share the
-// same cache as the specified |processor|.
-static uint64_t iree_task_topology_calculate_constructive_sharing_mask(
-    const struct cpuinfo_processor* processor) {
-  uint64_t mask = 0;
-  mask |= iree_task_topology_calculate_cache_bits(processor->cache.l1i);
-  mask |= iree_task_topology_calculate_cache_bits(processor->cache.l1d);
-  mask |= iree_task_topology_calculate_cache_bits(processor->cache.l2);
+// Returns true if the processor with |processor_index| shares the same cache as
+// the specified |processor|.
+static bool iree_task_topology_is_constructive_sharing(
+    const struct cpuinfo_processor* processor, uint32_t processor_index) {
   // TODO(benvanik): include L3 here too (for systems that have it)? Or use L3
   // info purely for distribution and focus the group mask on lower-latency
   // caches?
-  return mask;
+  return iree_task_topology_cache_contains_processor(processor->cache.l1i,
+                                                     processor_index) ||
+         iree_task_topology_cache_contains_processor(processor->cache.l1d,
+                                                     processor_index) ||
+         iree_task_topology_cache_contains_processor(processor->cache.l2,
+                                                     processor_index);
 }
 
 iree_status_t iree_task_topology_fixup_constructive_sharing_masks(
@@ -242,22 +408,20 @@ iree_status_t iree_task_topology_fixup_constructive_sharing_masks(
     return iree_ok_status();
   }
 
-  // O(n^2), but n is always <= 64 (and often <= 8).
+  // O(n^2), but n is always <= IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT (and often
+  // <= 8).
   for (iree_host_size_t i = 0; i < topology->group_count; ++i) {
     iree_task_topology_group_t* group = &topology->groups[i];
 
-    // Compute the processors that we can constructively share with.
-    uint64_t constructive_sharing_mask =
-        iree_task_topology_calculate_constructive_sharing_mask(
-            cpuinfo_get_processor(group->processor_index));
-
-    iree_task_topology_group_mask_t group_mask = 0;
+    // Compute the groups whose processors we can constructively share with.
+    const struct cpuinfo_processor* processor =
+        cpuinfo_get_processor(group->processor_index);
+    iree_task_topology_group_mask_t group_mask = iree_task_affinity_set_empty();
     for (iree_host_size_t j = 0; j < topology->group_count; ++j) {
       const iree_task_topology_group_t* other_group = &topology->groups[j];
-      uint64_t group_processor_bits =
-          iree_math_rotl_u64(1ull, other_group->processor_index);
-      if (constructive_sharing_mask & group_processor_bits) {
-        group_mask |= iree_math_rotl_u64(1ull, other_group->group_index);
+      if (iree_task_topology_is_constructive_sharing(
+              processor, other_group->processor_index)) {
+        iree_task_affinity_set_insert(&group_mask, other_group->group_index);
       }
     }
 
@@ -322,17 +486,18 @@ typedef bool (*iree_task_topology_core_filter_t)(
     const struct cpuinfo_core* core, void* user_data);
 
 typedef struct iree_task_topology_core_filter_params_t {
-  uint32_t cluster_id;
+  iree_task_topology_node_id_t node_id;
   iree_task_topology_performance_level_t performance_level;
 } iree_task_topology_core_filter_params_t;
 
-// Matches all cores that have the provided cluster ID.
-static bool iree_task_topology_core_filter_by_cluster_id(
+// Matches all cores that reside on the provided node ID.
+static bool iree_task_topology_core_filter_by_node_id(
     const struct cpuinfo_core* core, void* user_data) {
   const iree_task_topology_core_filter_params_t* params =
       (const iree_task_topology_core_filter_params_t*)user_data;
-  if (params->cluster_id != IREE_TASK_TOPOLOGY_NODE_ID_ANY &&
-      core->cluster->cluster_id != params->cluster_id) {
+  if (params->node_id != IREE_TASK_TOPOLOGY_NODE_ID_ANY &&
+      iree_task_topology_query_processor_node(cpuinfo_get_processor(
+          core->processor_start)) != params->node_id) {
     return false;
   }
   // cpuinfo doesn't expose performance levels and instead we have to switch on
@@ -424,11 +589,11 @@ iree_status_t iree_task_topology_initialize_from_physical_cores(
     iree_task_topology_performance_level_t performance_level,
     iree_host_size_t max_core_count, iree_task_topology_t* out_topology) {
   iree_task_topology_core_filter_params_t params = {
-      .cluster_id = node_id,
+      .node_id = node_id,
       .performance_level = performance_level,
   };
   return iree_task_topology_initialize_from_physical_cores_with_filter(
-      iree_task_topology_core_filter_by_cluster_id, &params, max_core_count,
+      iree_task_topology_core_filter_by_node_id, &params, max_core_count,
       out_topology);
 }
 
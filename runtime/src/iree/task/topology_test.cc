@@ -7,6 +7,7 @@
 #include "iree/task/topology.h"
 
 #include <cstddef>
+#include <vector>
 
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
@@ -34,6 +35,84 @@ TEST(TopologyTest, Empty) {
   iree_task_topology_deinitialize(&topology);
 }
 
+// Parses |value| as an ID list and returns the IDs visited in order.
+static iree_status_t ParseIdList(const char* value,
+                                 std::vector<uint32_t>* out_ids) {
+  out_ids->clear();
+  uint32_t count = 0;
+  IREE_RETURN_IF_ERROR(iree_task_topology_parse_id_list(
+      iree_make_cstring_view(value),
+      [](void* user_data, uint32_t id) {
+        static_cast<std::vector<uint32_t>*>(user_data)->push_back(id);
+      },
+      out_ids, &count));
+  EXPECT_EQ(count, out_ids->size());
+  return iree_ok_status();
+}
+
+TEST(TopologyTest, ParseIdListEmpty) {
+  std::vector<uint32_t> ids;
+  IREE_EXPECT_OK(ParseIdList("", &ids));
+  EXPECT_TRUE(ids.empty());
+  // Nodes without processors have an empty cpulist containing only a newline.
+  IREE_EXPECT_OK(ParseIdList("\n", &ids));
+  EXPECT_TRUE(ids.empty());
+}
+
+TEST(TopologyTest, ParseIdListSingle) {
+  std::vector<uint32_t> ids;
+  IREE_EXPECT_OK(ParseIdList("0\n", &ids));
+  EXPECT_EQ(std::vector<uint32_t>({0}), ids);
+  IREE_EXPECT_OK(ParseIdList("1023", &ids));
+  EXPECT_EQ(std::vector<uint32_t>({1023}), ids);
+}
+
+TEST(TopologyTest, ParseIdListRanges) {
+  std::vector<uint32_t> ids;
+  IREE_EXPECT_OK(ParseIdList("0-3\n", &ids));
+  EXPECT_EQ(std::vector<uint32_t>({0, 1, 2, 3}), ids);
+  IREE_EXPECT_OK(ParseIdList("5-5", &ids));
+  EXPECT_EQ(std::vector<uint32_t>({5}), ids);
+  IREE_EXPECT_OK(ParseIdList("62-65", &ids));
+  EXPECT_EQ(std::vector<uint32_t>({62, 63, 64, 65}), ids);
+}
+
+TEST(TopologyTest, ParseIdListCommaSeparated) {
+  std::vector<uint32_t> ids;
+  IREE_EXPECT_OK(ParseIdList("0,2,4", &ids));
+  EXPECT_EQ(std::vector<uint32_t>({0, 2, 4}), ids);
+  IREE_EXPECT_OK(ParseIdList("0-1,4-5,8\n", &ids));
+  EXPECT_EQ(std::vector<uint32_t>({0, 1, 4, 5, 8}), ids);
+}
+
+// Tests that sparse node IDs are counted instead of taking the largest ID.
+TEST(TopologyTest, ParseIdListSparse) {
+  std::vector<uint32_t> ids;
+  uint32_t count = 0;
+  IREE_EXPECT_OK(iree_task_topology_parse_id_list(
+      iree_make_cstring_view("0,2\n"), NULL, NULL, &count));
+  EXPECT_EQ(2u, count);
+  IREE_EXPECT_OK(iree_task_topology_parse_id_list(
+      iree_make_cstring_view("1,3-4,254"), NULL, NULL, &count));
+  EXPECT_EQ(4u, count);
+  IREE_EXPECT_OK(ParseIdList("1,3-4,254", &ids));
+  EXPECT_EQ(std::vector<uint32_t>({1, 3, 4, 254}), ids);
+}
+
+// Tests that malformed lists fail without visiting any ID.
+TEST(TopologyTest, ParseIdListMalformed) {
+  for (const char* value :
+       {",", "0,", ",0", "0,,1", "-", "-1", "1-", "1--2", "1-2-3", "3-1",
+        "a", "0x1", "+1", "1 2", "0-1,x", "4294967296", "0-4294967295"}) {
+    std::vector<uint32_t> ids;
+    iree_status_t status = ParseIdList(value, &ids);
+    IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT, status)
+        << "value: '" << value << "'";
+    iree_status_free(status);
+    EXPECT_TRUE(ids.empty()) << "value: '" << value << "'";
+  }
+}
+
 TEST(TopologyTest, Parsing) {
   // TODO(benvanik): implement parsing.
 }
@@ -112,6 +191,7 @@ TEST(TopologyTest, FromGroupCount) {
     const iree_task_topology_group_t* group =
         iree_task_topology_get_group(&topology, i);
     EXPECT_EQ(i, group->group_index);
+    EXPECT_EQ(0, group->node_id);
   }
 
   iree_task_topology_deinitialize(&topology);
@@ -131,6 +211,7 @@ static void EnsureTopologyValid(iree_host_size_t max_group_count,
     const iree_task_topology_group_t* group =
         iree_task_topology_get_group(topology, i);
     EXPECT_EQ(i, group->group_index);
+    EXPECT_LT(group->node_id, iree_task_topology_query_node_count());
   }
 }
 
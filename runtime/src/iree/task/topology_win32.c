@@ -49,6 +49,19 @@ static inline int iree_task_count_kaffinity_bits(KAFFINITY affinity_mask) {
 #endif  // _WIN64
 }
 
+// Returns the NUMA node of the logical processor |number| in processor |group|
+// or 0 if it could not be queried.
+static iree_task_topology_node_id_t iree_task_topology_query_processor_node(
+    WORD group, int number) {
+  PROCESSOR_NUMBER processor_number = {
+      .Group = group,
+      .Number = (BYTE)number,
+  };
+  USHORT node_number = 0;
+  if (!GetNumaProcessorNodeEx(&processor_number, &node_number)) return 0;
+  return (iree_task_topology_node_id_t)node_number;
+}
+
 // Sets |out_affinity| to be pinned to |processor|.
 static void iree_task_topology_set_affinity_from_processor(
     const PROCESSOR_RELATIONSHIP* processor,
@@ -111,7 +124,8 @@ static void iree_task_topology_assign_constructive_sharing(
         iree_task_topology_group_t* other = &topology->groups[group_j];
         if (other->ideal_thread_affinity.group == group_mask.Group &&
             (group_mask.Mask & (1ull << other->ideal_thread_affinity.id))) {
-          group->constructive_sharing_mask |= 1ull << group_j;
+          iree_task_affinity_set_insert(&group->constructive_sharing_mask,
+                                        group_j);
         }
       }
     }
@@ -294,11 +308,12 @@ iree_status_t iree_task_topology_initialize_from_logical_cpu_set(
       iree_host_size_t global_processor_index = global_processor_count++;
       if (included_processors[global_processor_index]) {
         // Setup the group for the processor.
-        uint8_t group_index = (uint8_t)out_topology->group_count++;
+        uint16_t group_index = (uint16_t)out_topology->group_count++;
         iree_task_topology_group_t* group = &out_topology->groups[group_index];
         iree_task_topology_group_initialize(group_index, group);
         group->processor_index = (uint32_t)global_processor_index;
-        group->constructive_sharing_mask = 0;  // set below
+        group->constructive_sharing_mask =
+            iree_task_affinity_set_empty();  // set below
 
         // Pin group to the processor.
         iree_thread_affinity_t* affinity = &group->ideal_thread_affinity;
@@ -307,6 +322,9 @@ iree_status_t iree_task_topology_initialize_from_logical_cpu_set(
         affinity->smt = (p->Processor.Flags & LTP_PC_SMT) == LTP_PC_SMT;
         affinity->group = p->Processor.GroupMask[0].Group;
         affinity->id = group_offset + bit_offset;
+
+        group->node_id = iree_task_topology_query_processor_node(
+            affinity->group, affinity->id);
       }
       group_offset += bit_offset + 1;
       if (out_topology->group_count >= cpu_count) break;
@@ -538,13 +556,18 @@ iree_status_t iree_task_topology_initialize_from_physical_cores(
     }
     ++used_core_index;
 
-    uint8_t group_index = (uint8_t)out_topology->group_count++;
+    uint16_t group_index = (uint16_t)out_topology->group_count++;
     iree_task_topology_group_t* group = &out_topology->groups[group_index];
     iree_task_topology_group_initialize(group_index, group);
     group->processor_index = (uint32_t)adjusted_core_index;
-    group->constructive_sharing_mask = 0;  // set below
+    group->constructive_sharing_mask =
+        iree_task_affinity_set_empty();  // set below
     iree_task_topology_set_affinity_from_processor(
         core, &group->ideal_thread_affinity);
+
+    group->node_id = iree_task_topology_query_processor_node(
+        core->GroupMask[0].Group,
+        iree_task_count_trailing_zeros_kaffinity(core->GroupMask[0].Mask));
   }
 
   // Assign constructive sharing masks to each topology group.
@@ -12,10 +12,13 @@ extern "C" {
 #endif  // __cplusplus
 
 // Maximum number of workers that an executor can manage.
-// A 64 worker hard limit is based on us using uint64_t as a bitmask to select
-// workers. It's easy to go smaller (just use fewer bits) if it's known that
-// only <64 will ever be used (such as for devices with 2 cores).
-#define IREE_TASK_EXECUTOR_MAX_WORKER_COUNT (64)
+// Worker bitsets (iree_task_affinity_set_t) are sized to this value in 64-bit
+// words so raising it increases the cost of scanning the sets. It's easy to go
+// smaller if it's known that only <=64 will ever be used (such as for devices
+// with 2 cores) in which case the sets collapse to a single word.
+#if !defined(IREE_TASK_EXECUTOR_MAX_WORKER_COUNT)
+#define IREE_TASK_EXECUTOR_MAX_WORKER_COUNT (256)
+#endif  // !IREE_TASK_EXECUTOR_MAX_WORKER_COUNT
 
 // Initial number of shard tasks that are allocated in the executor pool.
 // Increasing this number will decrease initial allocation storms in cases of
@@ -77,8 +80,16 @@ extern "C" {
 // In real-time systems too few tasks is better (slightly more work for much
 // lower variance in execution) while in batch mode systems too many tasks is
 // better (as latencies don't matter so long as throughput is maximized).
-#define IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT \
-  IREE_TASK_EXECUTOR_MAX_WORKER_COUNT
+//
+// This is an upper bound: executors divide the capacity of a worker queue
+// across all workers so that executors with many workers don't have a few
+// thieves drain a victim while the rest find nothing.
+#define IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT (64)
+
+// Capacity of the lock-free ring buffer in each worker's local task queue.
+// Tasks beyond this are kept in a worker-private overflow list that thieves
+// cannot see until the ring drains. Must be a power of two.
+#define IREE_TASK_QUEUE_CAPACITY (256)
 
 // Number of tiles that will be batched into a single reservation from the grid.
 // This is a maximum; if there are fewer tiles that would otherwise allow for
@@ -94,6 +105,28 @@ extern "C" {
 // memory).
 #define IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION (8)
 
+// Minimum duration in nanoseconds a worker will spin waiting for work.
+// Adaptive spinning (see iree_task_executor_options_t::worker_spin_adaptive)
+// that computes a shorter budget will park immediately instead as the spin
+// would cost more in clock queries than it could save.
+#define IREE_TASK_WORKER_MIN_SPIN_NS (1 * 1000)
+
+// Maximum number of dispatches that can be executing in persistent mode at the
+// same time (see IREE_TASK_SCHEDULING_MODE_PERSISTENT_DISPATCH). Dispatches
+// issued while all slots are in use fall back to being sharded.
+#define IREE_TASK_EXECUTOR_PERSISTENT_DISPATCH_SLOT_COUNT (4)
+
+// Target duration in nanoseconds of each tile range reserved by a worker from a
+// persistent dispatch. Workers measure how long their tiles take and size their
+// next reservation to take about this long: cheap tiles are claimed in large
+// ranges to amortize the atomic reservation while expensive tiles are claimed
+// one at a time to keep the workers balanced.
+#define IREE_TASK_DISPATCH_PERSISTENT_TARGET_RESERVATION_NS (20 * 1000)
+
+// Maximum number of tiles that a worker will reserve at a time from a
+// persistent dispatch regardless of how cheap the tiles are.
+#define IREE_TASK_DISPATCH_PERSISTENT_MAX_TILES_PER_RESERVATION (1024)
+
 // Whether to enable per-tile colors for each tile tracing zone based on the
 // tile grid xyz. Not cheap and can be disabled to reduce tracing overhead.
 // TODO(#4017): make per-tile color tracing fast enough to always have on.
@@ -24,16 +24,18 @@ static int iree_task_worker_main(iree_task_worker_t* worker);
 iree_status_t iree_task_worker_initialize(
     iree_task_executor_t* executor, iree_host_size_t worker_index,
     const iree_task_topology_group_t* topology_group,
-    iree_host_size_t stack_size, iree_byte_span_t local_memory,
+    const iree_task_affinity_set_t* node_mask, iree_host_size_t stack_size,
+    iree_byte_span_t local_memory,
     iree_prng_splitmix64_state_t* seed_prng, iree_task_worker_t* out_worker) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   out_worker->executor = executor;
   out_worker->worker_index = executor->worker_base_index + worker_index;
-  out_worker->worker_bit = iree_task_affinity_for_worker(worker_index);
+  out_worker->local_worker_index = worker_index;
   out_worker->ideal_thread_affinity = topology_group->ideal_thread_affinity;
   out_worker->constructive_sharing_mask =
       topology_group->constructive_sharing_mask;
+  out_worker->node_mask = *node_mask;
   out_worker->max_theft_attempts =
       executor->worker_count / IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR;
   iree_prng_minilcg128_initialize(iree_prng_splitmix64_next(seed_prng),
@@ -41,6 +43,7 @@ iree_status_t iree_task_worker_initialize(
   out_worker->local_memory = local_memory;
   out_worker->processor_id = 0;
   out_worker->processor_tag = 0;
+  out_worker->spin_budget_ns = executor->worker_spin_ns;
 
   iree_notification_initialize(&out_worker->wake_notification);
   iree_notification_initialize(&out_worker->state_notification);
@@ -130,7 +133,6 @@ void iree_task_worker_deinitialize(iree_task_worker_t* worker) {
   // get anything more posted to it) and then discarding everything we still
   // have a reference to.
   iree_atomic_task_slist_discard(&worker->mailbox_slist);
-  iree_task_list_discard(&worker->local_task_queue.list);
 
   iree_notification_deinitialize(&worker->wake_notification);
   iree_notification_deinitialize(&worker->state_notification);
@@ -140,35 +142,34 @@ void iree_task_worker_deinitialize(iree_task_worker_t* worker) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Updates the executor occupancy plot after the idle mask has changed.
+static void iree_task_worker_plot_occupancy(iree_task_worker_t* worker) {
+  IREE_TRACE({
+    iree_task_affinity_set_t idle_mask = iree_atomic_task_affinity_set_load(
+        &worker->executor->worker_idle_mask, iree_memory_order_relaxed);
+    IREE_TRACE_PLOT_VALUE_F32(
+        worker->executor->trace_name,
+        100.0f - 100.0f * iree_task_affinity_set_count_ones(&idle_mask) /
+                     (float)worker->executor->worker_count);
+  });
+}
+
 // Marks the worker as "active" (scheduling work or executing it).
 // The idle mask is accessed with 'relaxed' order because it's just a hint.
 static void iree_task_worker_mark_active(iree_task_worker_t* worker) {
-  iree_task_affinity_set_t old_idle_mask =
-      iree_atomic_task_affinity_set_fetch_and(
-          &worker->executor->worker_idle_mask, ~worker->worker_bit,
-          iree_memory_order_relaxed);
-  (void)old_idle_mask;
-  IREE_TRACE_PLOT_VALUE_F32(
-      worker->executor->trace_name,
-      old_idle_mask
-          ? (100.0f -
-             100.0f * (iree_task_affinity_set_count_ones(old_idle_mask) - 1) /
-                 (float)worker->executor->worker_count)
-          : 100.0f);
+  iree_atomic_task_affinity_set_erase(&worker->executor->worker_idle_mask,
+                                      worker->local_worker_index,
+                                      iree_memory_order_relaxed);
+  iree_task_worker_plot_occupancy(worker);
 }
 
 // Marks the worker as "idle" (sleeping/spinning waiting to wake).
 // The idle mask is accessed with 'relaxed' order because it's just a hint.
 static void iree_task_worker_mark_idle(iree_task_worker_t* worker) {
-  iree_task_affinity_set_t old_idle_mask =
-      iree_atomic_task_affinity_set_fetch_or(
-          &worker->executor->worker_idle_mask, worker->worker_bit,
-          iree_memory_order_relaxed);
-  (void)old_idle_mask;
-  IREE_TRACE_PLOT_VALUE_F32(
-      worker->executor->trace_name,
-      100.0f - 100.0f * (iree_task_affinity_set_count_ones(old_idle_mask) + 1) /
-                   (float)worker->executor->worker_count);
+  iree_atomic_task_affinity_set_insert(&worker->executor->worker_idle_mask,
+                                       worker->local_worker_index,
+                                       iree_memory_order_relaxed);
+  iree_task_worker_plot_occupancy(worker);
 }
 
 void iree_task_worker_post_tasks(iree_task_worker_t* worker,
@@ -255,6 +256,16 @@ static bool iree_task_worker_pump_once(
                                                  &worker->mailbox_slist);
   }
 
+  // Help execute any dispatches published for persistent execution. These are
+  // preferred over stealing as the tiles are already sitting there waiting
+  // for any worker to claim them and the dispatch cannot complete until they
+  // are all executed.
+  if (!task && iree_task_executor_execute_persistent_dispatch(
+                   worker->executor, worker, pending_submission)) {
+    IREE_TRACE_ZONE_END(z0);
+    return true;  // try again
+  }
+
 #if IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR > 0
   // If we ran out of work assigned to this specific worker try to steal some
   // from other workers that we hopefully share some of the cache hierarchy
@@ -262,9 +273,12 @@ static bool iree_task_worker_pump_once(
   // the first task in the queue is popped off and returned.
   if (!task) {
     task = iree_task_executor_try_steal_task(
-        worker->executor, worker->constructive_sharing_mask,
-        worker->max_theft_attempts, &worker->theft_prng,
+        worker->executor, &worker->constructive_sharing_mask,
+        &worker->node_mask, worker->max_theft_attempts, &worker->theft_prng,
         &worker->local_task_queue);
+    if (task) {
+      iree_atomic_fetch_add(&worker->theft_count, 1, iree_memory_order_relaxed);
+    }
   }
 #endif  // IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR > 0
 
@@ -282,6 +296,72 @@ static bool iree_task_worker_pump_once(
   return true;  // try again
 }
 
+// Returns the next spin budget of |worker| after a wait of |wait_ns| given the
+// previous |budget_ns| and the executor |max_spin_ns|.
+//
+// The budget follows twice the recent wait durations so that the typical wait
+// is caught while spinning. Waits longer than the maximum pull the budget
+// towards zero as spinning would not have avoided parking anyway. The average
+// is weighted so that a single outlier doesn't flip the policy.
+static iree_duration_t iree_task_worker_adapt_spin_budget(
+    iree_duration_t budget_ns, iree_duration_t wait_ns,
+    iree_duration_t max_spin_ns) {
+  iree_duration_t target_ns = wait_ns < max_spin_ns ? wait_ns * 2 : 0;
+  budget_ns += (target_ns - budget_ns) / 4;
+  return iree_min(iree_max(budget_ns, IREE_DURATION_ZERO), max_spin_ns);
+}
+
+// Waits for |worker| to be woken with |wait_token|, first spinning for the
+// current spin budget and then parking in the kernel.
+static void iree_task_worker_wait(iree_task_worker_t* worker,
+                                  iree_wait_token_t wait_token) {
+  IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_task_worker_main_pump_wake_wait");
+  iree_task_executor_t* executor = worker->executor;
+
+  // Budgets below the minimum aren't worth the clock queries; we park
+  // immediately but keep tracking the wait durations so that spinning resumes
+  // if waits shorten again.
+  iree_duration_t spin_ns = worker->spin_budget_ns;
+  if (spin_ns < IREE_TASK_WORKER_MIN_SPIN_NS) spin_ns = IREE_DURATION_ZERO;
+
+  // Clock queries are only needed to track spinning; workers that never spin
+  // don't pay for them.
+  const bool track_time = executor->worker_spin_ns != IREE_DURATION_ZERO;
+  iree_time_t start_ns = track_time ? iree_time_now() : 0;
+  iree_notification_commit_wait(&worker->wake_notification, wait_token,
+                                spin_ns,
+                                /*deadline_ns=*/IREE_TIME_INFINITE_FUTURE);
+  iree_atomic_fetch_add(&worker->wake_count, 1, iree_memory_order_relaxed);
+  if (!track_time) {
+    iree_atomic_fetch_add(&worker->park_count, 1, iree_memory_order_relaxed);
+    IREE_TRACE_ZONE_END(z0);
+    return;
+  }
+
+  // We don't know exactly whether the wake happened during the spin or after
+  // parking but anything that returned within the spin budget almost certainly
+  // never made it to the kernel.
+  iree_duration_t wait_ns = iree_time_now() - start_ns;
+  if (wait_ns <= spin_ns) {
+    iree_atomic_fetch_add(&worker->spin_wake_count, 1,
+                          iree_memory_order_relaxed);
+    iree_atomic_fetch_add(&worker->spin_ns, wait_ns,
+                          iree_memory_order_relaxed);
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "spin");
+  } else {
+    iree_atomic_fetch_add(&worker->park_count, 1, iree_memory_order_relaxed);
+    iree_atomic_fetch_add(&worker->spin_ns, spin_ns,
+                          iree_memory_order_relaxed);
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "park");
+  }
+  if (executor->worker_spin_adaptive) {
+    worker->spin_budget_ns = iree_task_worker_adapt_spin_budget(
+        worker->spin_budget_ns, wait_ns, executor->worker_spin_ns);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
 // Updates the cached processor ID field in the worker.
 static void iree_task_worker_update_processor_id(iree_task_worker_t* worker) {
   iree_cpu_requery_processor_id(&worker->processor_tag, &worker->processor_id);
@@ -339,6 +419,7 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
     // This ensures that if any other thread comes in and wants to give us
     // work we will properly coordinate/wake below.
     iree_task_worker_mark_idle(worker);
+    iree_atomic_fetch_add(&worker->idle_count, 1, iree_memory_order_relaxed);
 
     // When we encounter a complete lack of work we can self-nominate to check
     // the global work queue and distribute work to other threads. Only one
@@ -352,21 +433,18 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
 
     // If nothing has been enqueued since we started this loop (so even
     // coordination didn't find anything) we go idle. Otherwise we fall
-    // through and try the loop again.
+    // through and try the loop again. Persistent dispatches are published
+    // without posting to our mailbox so we must check for them after marking
+    // ourselves idle: any published later will see us idle and wake us.
     if (schedule_dirty ||
-        !iree_task_queue_is_empty(&worker->local_task_queue)) {
+        !iree_task_queue_is_empty(&worker->local_task_queue) ||
+        iree_task_executor_has_persistent_dispatch(worker->executor, worker)) {
       // Have more work to do; loop around to try another pump.
       iree_notification_cancel_wait(&worker->wake_notification);
     } else {
       // Spin/wait in the kernel. We don't care if the condition fails as we're
       // just using it as a pulse.
-      IREE_TRACE_ZONE_BEGIN_NAMED(z_wait,
-                                  "iree_task_worker_main_pump_wake_wait");
-      iree_notification_commit_wait(
-          &worker->wake_notification, wait_token,
-          /*spin_ns=*/worker->executor->worker_spin_ns,
-          /*deadline_ns=*/IREE_TIME_INFINITE_FUTURE);
-      IREE_TRACE_ZONE_END(z_wait);
+      iree_task_worker_wait(worker, wait_token);
 
       // Woke from a wait - query the processor ID in case we migrated during
       // the sleep.
@@ -391,6 +469,14 @@ static int iree_task_worker_main(iree_task_worker_t* worker) {
   // TODO(benvanik): call this after waking in case CPU hotplugging happens.
   iree_thread_request_affinity(worker->thread, worker->ideal_thread_affinity);
 
+  // Touch the local memory from the worker thread now that it is (hopefully)
+  // running on its ideal processor. Operating systems using first-touch
+  // placement (Linux, Windows) will back the pages with memory from the NUMA
+  // node the worker is on.
+  if (worker->local_memory.data_length > 0) {
+    memset(worker->local_memory.data, 0, worker->local_memory.data_length);
+  }
+
   // Enter the running state immediately. Note that we could have been requested
   // to exit while suspended/still starting up, so check that here before we
   // mess with any data structures.
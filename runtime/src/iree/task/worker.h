@@ -84,9 +84,9 @@ typedef struct iree_task_worker_t {
   // Globally unique worker index (worker_base_index + local worker_index).
   iree_host_size_t worker_index;
 
-  // Bit the worker represents in the various worker bitsets.
-  // Local to the executor owning the worker.
-  iree_task_affinity_set_t worker_bit;
+  // Executor-local worker index selecting the bit the worker represents in the
+  // various worker bitsets.
+  iree_host_size_t local_worker_index;
 
   // Ideal thread affinity for the worker thread.
   iree_thread_affinity_t ideal_thread_affinity;
@@ -98,9 +98,13 @@ typedef struct iree_task_worker_t {
   // all share the same L3 cache.
   iree_task_affinity_set_t constructive_sharing_mask;
 
+  // A bitmask of workers that reside on the same NUMA node as this worker.
+  // Thefts from these workers are attempted before crossing to remote nodes.
+  iree_task_affinity_set_t node_mask;
+
   // Maximum number of attempts to make when trying to steal tasks from other
-  // workers. This could be 64 (try stealing from all workers) or just a handful
-  // (try stealing from these 3 other cores that share your L3 cache).
+  // workers. This could be 256 (try stealing from all workers) or just a
+  // handful (try stealing from these 3 other cores that share your L3 cache).
   uint32_t max_theft_attempts;
 
   // Rotation counter for work stealing (ensures we don't favor one victim).
@@ -120,6 +124,21 @@ typedef struct iree_task_worker_t {
   // An opaque tag used to reduce the cost of processor ID queries.
   iree_cpu_processor_tag_t processor_tag;
 
+  // Duration the worker will spin waiting for work before parking.
+  // Starts at the executor worker_spin_ns and, if the executor has adaptive
+  // spinning enabled, tracks about twice the recent wait durations. Only ever
+  // touched by the worker thread.
+  iree_duration_t spin_budget_ns;
+
+  // Scheduling statistics; only updated by the worker thread and read by
+  // iree_task_executor_query_statistics.
+  iree_atomic_int64_t theft_count;
+  iree_atomic_int64_t idle_count;
+  iree_atomic_int64_t wake_count;
+  iree_atomic_int64_t spin_wake_count;
+  iree_atomic_int64_t park_count;
+  iree_atomic_int64_t spin_ns;
+
   // Destructive interference padding between the mailbox and local task queue
   // to ensure that the worker - who is pounding on local_task_queue - doesn't
   // contend with submissions or coordinators dropping new tasks in the mailbox.
@@ -156,10 +175,15 @@ static_assert(offsetof(iree_task_worker_t, local_task_queue) >=
 // tasks. Where supported the worker will be created in a suspended state so
 // that we aren't creating a thundering herd on startup:
 // https://en.wikipedia.org/wiki/Thundering_herd_problem
+//
+// |node_mask| indicates which workers reside on the same NUMA node as the
+// worker. |local_memory| is zeroed by the worker thread itself when it starts
+// so that the pages are placed on the worker's node.
 iree_status_t iree_task_worker_initialize(
     iree_task_executor_t* executor, iree_host_size_t worker_index,
     const iree_task_topology_group_t* topology_group,
-    iree_host_size_t stack_size, iree_byte_span_t local_memory,
+    const iree_task_affinity_set_t* node_mask, iree_host_size_t stack_size,
+    iree_byte_span_t local_memory,
     iree_prng_splitmix64_state_t* seed_prng, iree_task_worker_t* out_worker);
 
 // Requests that the worker begin exiting (if it hasn't already).
@@ -13,6 +13,7 @@
 #include "iree/base/internal/file_io.h"
 #include "iree/base/internal/flags.h"
 #include "iree/base/internal/path.h"
+#include "iree/hal/local/executable_disk_cache.h"
 #include "iree/hal/local/loaders/registration/init.h"
 #include "iree/hal/local/plugins/registration/init.h"
 #include "iree/modules/hal/inline/module.h"
@@ -44,6 +45,52 @@ IREE_FLAG(
     "        warm-up time and variance as mapped pages are swapped\n"
     "        by the OS.");
 
+// Verification attestations for bytecode modules stored as small entries in the
+// persistent executable cache directory (--executable_cache_dir=).
+typedef struct iree_tooling_verification_cache_t {
+  iree_hal_executable_disk_cache_t* disk_cache;
+  iree_allocator_t host_allocator;
+} iree_tooling_verification_cache_t;
+
+static iree_hal_executable_disk_cache_key_t
+iree_tooling_verification_cache_make_key(
+    iree_tooling_verification_cache_t* cache,
+    iree_vm_bytecode_module_hash_t hash) {
+  return iree_hal_executable_disk_cache_make_key(
+      cache->disk_cache, IREE_SV("vm-bytecode-verified"),
+      iree_make_const_byte_span(hash.value, sizeof(hash.value)));
+}
+
+static bool iree_tooling_verification_cache_lookup(
+    void* self, iree_vm_bytecode_module_hash_t hash) {
+  iree_tooling_verification_cache_t* cache =
+      (iree_tooling_verification_cache_t*)self;
+  iree_file_contents_t* contents = NULL;
+  iree_status_t status = iree_hal_executable_disk_cache_map_entry(
+      cache->disk_cache, iree_tooling_verification_cache_make_key(cache, hash),
+      IREE_SV("verified"), cache->host_allocator, &contents);
+  if (!iree_status_is_ok(status)) {
+    iree_status_ignore(status);
+    return false;
+  }
+  // The entry stores the module hash to guard against key collisions.
+  bool is_verified =
+      contents->const_buffer.data_length == sizeof(hash.value) &&
+      memcmp(contents->const_buffer.data, hash.value, sizeof(hash.value)) == 0;
+  iree_file_contents_free(contents);
+  return is_verified;
+}
+
+static void iree_tooling_verification_cache_insert(
+    void* self, iree_vm_bytecode_module_hash_t hash) {
+  iree_tooling_verification_cache_t* cache =
+      (iree_tooling_verification_cache_t*)self;
+  iree_status_ignore(iree_hal_executable_disk_cache_store_entry(
+      cache->disk_cache, iree_tooling_verification_cache_make_key(cache, hash),
+      IREE_SV("verified"),
+      iree_make_const_byte_span(hash.value, sizeof(hash.value))));
+}
+
 static iree_status_t iree_tooling_load_bytecode_module(
     iree_vm_instance_t* instance, iree_string_view_t path,
     iree_allocator_t host_allocator, iree_vm_module_t** out_module) {
@@ -79,10 +126,29 @@ static iree_status_t iree_tooling_load_bytecode_module(
   // Try to load the module as bytecode (all we have today that we can use).
   // We could sniff the file ID and switch off to other module types.
   // The module takes ownership of the file contents (when successful).
+  // Modules previously verified by this or other processes sharing the
+  // persistent executable cache skip verification.
+  iree_tooling_verification_cache_t verification_cache = {
+      .disk_cache = NULL,
+      .host_allocator = host_allocator,
+  };
+  iree_status_t status = iree_hal_executable_disk_cache_create_from_flags(
+      host_allocator, &verification_cache.disk_cache);
+  iree_vm_bytecode_module_options_t options;
+  iree_vm_bytecode_module_options_initialize(&options);
+  if (verification_cache.disk_cache) {
+    options.verification_cache.self = &verification_cache;
+    options.verification_cache.lookup = iree_tooling_verification_cache_lookup;
+    options.verification_cache.insert = iree_tooling_verification_cache_insert;
+  }
+
   iree_vm_module_t* module = NULL;
-  iree_status_t status = iree_vm_bytecode_module_create(
-      instance, file_contents->const_buffer,
-      iree_file_contents_deallocator(file_contents), host_allocator, &module);
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_bytecode_module_create_with_options(
+        instance, &options, file_contents->const_buffer,
+        iree_file_contents_deallocator(file_contents), host_allocator, &module);
+  }
+  iree_hal_executable_disk_cache_release(verification_cache.disk_cache);
 
   if (iree_status_is_ok(status)) {
     *out_module = module;
@@ -312,13 +378,20 @@ static iree_status_t iree_tooling_load_hal_loader_module(
       z0, iree_hal_executable_plugin_manager_create_from_flags(
               host_allocator, &plugin_manager));
 
+  // Create the optional persistent executable cache.
+  iree_hal_executable_disk_cache_t* disk_cache = NULL;
+  iree_status_t status = iree_hal_executable_disk_cache_create_from_flags(
+      host_allocator, &disk_cache);
+
   // Create all executable loaders built into the binary.
   // We could allow users to choose the set with a flag.
   iree_host_size_t loader_count = 0;
   iree_hal_executable_loader_t* loaders[16];
-  iree_status_t status = iree_hal_create_all_available_executable_loaders(
-      plugin_manager, IREE_ARRAYSIZE(loaders), &loader_count, loaders,
-      host_allocator);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_create_all_available_executable_loaders(
+        plugin_manager, disk_cache, IREE_ARRAYSIZE(loaders), &loader_count,
+        loaders, host_allocator);
+  }
 
   // Create the module; it retains the loaders for its lifetime.
   iree_vm_module_t* module = NULL;
@@ -332,6 +405,7 @@ static iree_status_t iree_tooling_load_hal_loader_module(
   for (iree_host_size_t i = 0; i < loader_count; ++i) {
     iree_hal_executable_loader_release(loaders[i]);
   }
+  iree_hal_executable_disk_cache_release(disk_cache);
   iree_hal_executable_plugin_manager_release(plugin_manager);
 
   if (iree_status_is_ok(status)) {
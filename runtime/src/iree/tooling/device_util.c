@@ -11,6 +11,7 @@
 #include "iree/hal/drivers/init.h"
 #include "iree/hal/utils/allocators.h"
 #include "iree/hal/utils/mpi_channel_provider.h"
+#include "iree/hal/utils/shm_channel.h"
 
 //===----------------------------------------------------------------------===//
 // Shared driver registry
@@ -315,12 +316,22 @@ static iree_status_t iree_hal_configure_allocator_from_flags(
 // more meaningful representation of multi-device/multi-node.
 iree_status_t iree_hal_device_set_default_channel_provider(
     iree_hal_device_t* device) {
-  if (!iree_hal_mpi_is_configured()) return iree_ok_status();
   iree_hal_channel_provider_t* channel_provider = NULL;
-  IREE_RETURN_IF_ERROR(
-      iree_hal_mpi_channel_provider_create(
-          iree_hal_device_host_allocator(device), &channel_provider),
-      "creating MPI channel provider as detected in environment");
+  if (iree_hal_shm_is_configured()) {
+    // Shared memory groups are explicitly requested and take precedence over
+    // an MPI launcher that may also be present.
+    IREE_RETURN_IF_ERROR(
+        iree_hal_shm_channel_provider_create_from_environment(
+            iree_hal_device_host_allocator(device), &channel_provider),
+        "creating shared memory channel provider as detected in environment");
+  } else if (iree_hal_mpi_is_configured()) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_mpi_channel_provider_create(
+            iree_hal_device_host_allocator(device), &channel_provider),
+        "creating MPI channel provider as detected in environment");
+  } else {
+    return iree_ok_status();
+  }
   iree_hal_device_replace_channel_provider(device, channel_provider);
   iree_hal_channel_provider_release(channel_provider);
   return iree_ok_status();
@@ -42,8 +42,9 @@ iree_status_t iree_hal_create_devices_from_flags(
     iree_hal_device_list_t** out_device_list);
 
 // Configures the |device| channel provider based on the current environment.
-// Today this simply checks to see if the process is running under MPI and
-// initializes that unconditionally.
+// Today this checks whether a shared memory group has been configured with the
+// IREE_SHM_CHANNEL_* environment variables or the process is running under MPI
+// and initializes the corresponding provider unconditionally.
 //
 // WARNING: not thread-safe and must only be called immediately after device
 // creation.
@@ -20,11 +20,14 @@
 
 IREE_FLAG(
     string, parameter_mode, "mmap",
-    "A parameter I/O mode of ['preload', 'mmap'].\n"
+    "A parameter I/O mode of ['preload', 'mmap', 'file'].\n"
     "  preload: read entire parameter files into wired memory on startup.\n"
     "  mmap: maps the parameter files into discardable memory - can increase\n"
     "        warm-up time and variance as mapped pages are swapped\n"
-    "        by the OS.");
+    "        by the OS.\n"
+    "  file: keeps the parameter files open and streams parameters with\n"
+    "        positioned reads - allows files larger than available memory\n"
+    "        and avoids page cache pressure from mappings.");
 
 static void iree_file_contents_release_callback(
     void* user_data, iree_io_file_handle_primitive_t handle_primitive) {
@@ -42,6 +45,14 @@ static iree_status_t iree_io_open_parameter_file(
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_APPEND_TEXT(z0, path.data, path.size);
 
+  // Files are opened directly and not loaded into memory.
+  if (strcmp(FLAG_parameter_mode, "file") == 0) {
+    iree_status_t status = iree_io_file_handle_open(
+        IREE_IO_FILE_ACCESS_READ, path, host_allocator, out_file_handle);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
   char path_str[2048] = {0};
   iree_string_view_to_cstring(path, path_str, sizeof(path_str));
   iree_file_read_flags_t read_flags = 0;
@@ -165,6 +176,8 @@ iree_status_t iree_tooling_create_parameters_module_from_flags(
           scope_map.count * sizeof(iree_io_parameter_provider_t*));
   if (iree_status_is_ok(status)) {
     for (iree_host_size_t i = 0; i < scope_map.count; ++i) {
+      // No more parameters will be added so allow lock-free lookups.
+      iree_io_parameter_index_freeze(scope_map.entries[i]->index);
       status = iree_io_parameter_index_provider_create(
           scope_map.entries[i]->scope, scope_map.entries[i]->index,
           IREE_IO_PARAMETER_INDEX_PROVIDER_DEFAULT_MAX_CONCURRENT_OPERATIONS,
@@ -0,0 +1,618 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/vm/async_scheduler.h"
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
+#include "iree/base/internal/wait_handle.h"
+#include "iree/base/loop_sync.h"
+
+//===----------------------------------------------------------------------===//
+// Utilities
+//===----------------------------------------------------------------------===//
+
+// FIFO list of invocations linked through their intrusive |next| pointers.
+typedef struct iree_vm_async_scheduler_invocation_list_t {
+  iree_vm_async_scheduler_invocation_t* head;
+  iree_vm_async_scheduler_invocation_t* tail;
+} iree_vm_async_scheduler_invocation_list_t;
+
+static void iree_vm_async_scheduler_invocation_list_push_back(
+    iree_vm_async_scheduler_invocation_list_t* list,
+    iree_vm_async_scheduler_invocation_t* invocation) {
+  invocation->next = NULL;
+  if (list->tail) {
+    list->tail->next = invocation;
+  } else {
+    list->head = invocation;
+  }
+  list->tail = invocation;
+}
+
+static iree_vm_async_scheduler_invocation_t*
+iree_vm_async_scheduler_invocation_list_pop_front(
+    iree_vm_async_scheduler_invocation_list_t* list) {
+  iree_vm_async_scheduler_invocation_t* invocation = list->head;
+  if (!invocation) return NULL;
+  list->head = invocation->next;
+  if (!list->head) list->tail = NULL;
+  invocation->next = NULL;
+  return invocation;
+}
+
+// Moves the entire contents of |list| to the returned list.
+static iree_vm_async_scheduler_invocation_list_t
+iree_vm_async_scheduler_invocation_list_take(
+    iree_vm_async_scheduler_invocation_list_t* list) {
+  iree_vm_async_scheduler_invocation_list_t taken = *list;
+  list->head = NULL;
+  list->tail = NULL;
+  return taken;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_vm_async_scheduler_t
+//===----------------------------------------------------------------------===//
+
+struct iree_vm_async_scheduler_worker_t {
+  // Parent scheduler; not retained.
+  iree_vm_async_scheduler_t* scheduler;
+  // Thread running the worker loop.
+  iree_thread_t* thread;
+  // Signaled when new invocations are posted to the inbox or the scheduler is
+  // exiting. The worker loop always has a wait pending on this event so that
+  // it can be woken while blocked waiting on invocation wait sources.
+  iree_event_t wake_event;
+  // Loop that all invocations assigned to the worker run on.
+  // Only accessed from the worker thread after creation.
+  iree_loop_sync_t* loop_sync;
+  iree_loop_sync_scope_t scope;
+
+  // Invocations admitted to the worker but not yet begun on its loop.
+  // Guarded by the scheduler mutex.
+  iree_vm_async_scheduler_invocation_list_t inbox;
+  // Total invocations admitted to the worker and not yet completed.
+  // Guarded by the scheduler mutex.
+  iree_host_size_t in_flight_count;
+};
+
+struct iree_vm_async_scheduler_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  iree_vm_async_scheduler_options_t options;
+
+  // Posted whenever the scheduler transitions to idle.
+  iree_notification_t idle_notification;
+
+  iree_slim_mutex_t mutex;
+  // Set when the scheduler is being destroyed and workers should exit once
+  // their loops have drained.
+  bool exiting IREE_GUARDED_BY(mutex);
+  // Worker that dropped the last reference from within a completion callback
+  // and will destroy the scheduler once it exits. Workers can't join
+  // themselves so destruction is deferred until the scheduler is idle.
+  iree_vm_async_scheduler_worker_t* deferred_destroy_worker
+      IREE_GUARDED_BY(mutex);
+  // Invocations submitted but not yet admitted due to the in-flight cap.
+  iree_vm_async_scheduler_invocation_list_t pending IREE_GUARDED_BY(mutex);
+  iree_host_size_t pending_count IREE_GUARDED_BY(mutex);
+  iree_host_size_t in_flight_count IREE_GUARDED_BY(mutex);
+  iree_host_size_t peak_in_flight_count IREE_GUARDED_BY(mutex);
+  uint64_t completed_count IREE_GUARDED_BY(mutex);
+
+  iree_host_size_t worker_count;
+  iree_vm_async_scheduler_worker_t workers[];
+};
+
+static void iree_vm_async_scheduler_destroy(
+    iree_vm_async_scheduler_t* scheduler);
+static int iree_vm_async_scheduler_worker_main(
+    iree_vm_async_scheduler_worker_t* worker);
+static iree_status_t iree_vm_async_scheduler_worker_arm(
+    iree_vm_async_scheduler_worker_t* worker, iree_loop_t loop);
+static void iree_vm_async_scheduler_worker_error(void* user_data,
+                                                 iree_status_t status);
+
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201102L) && \
+    !__STDC_NO_THREADS__
+#define IREE_VM_ASYNC_SCHEDULER_THREAD_LOCAL _Thread_local
+#elif defined(IREE_COMPILER_MSVC)
+#define IREE_VM_ASYNC_SCHEDULER_THREAD_LOCAL __declspec(thread)
+#endif  // __STDC_NO_THREADS__
+
+#if defined(IREE_VM_ASYNC_SCHEDULER_THREAD_LOCAL)
+// Worker running on the calling thread, if any. Used to detect the scheduler
+// being released from within a completion callback.
+static IREE_VM_ASYNC_SCHEDULER_THREAD_LOCAL iree_vm_async_scheduler_worker_t*
+    iree_vm_async_scheduler_current_worker_ = NULL;
+#endif  // IREE_VM_ASYNC_SCHEDULER_THREAD_LOCAL
+
+// Returns the worker running on the calling thread or NULL if the thread is
+// not a scheduler worker (or thread-local storage is unavailable).
+static iree_vm_async_scheduler_worker_t*
+iree_vm_async_scheduler_current_worker(void) {
+#if defined(IREE_VM_ASYNC_SCHEDULER_THREAD_LOCAL)
+  return iree_vm_async_scheduler_current_worker_;
+#else
+  return NULL;
+#endif  // IREE_VM_ASYNC_SCHEDULER_THREAD_LOCAL
+}
+
+static void iree_vm_async_scheduler_set_current_worker(
+    iree_vm_async_scheduler_worker_t* worker) {
+#if defined(IREE_VM_ASYNC_SCHEDULER_THREAD_LOCAL)
+  iree_vm_async_scheduler_current_worker_ = worker;
+#endif  // IREE_VM_ASYNC_SCHEDULER_THREAD_LOCAL
+}
+
+IREE_API_EXPORT void iree_vm_async_scheduler_options_initialize(
+    iree_vm_async_scheduler_options_t* out_options) {
+  IREE_ASSERT_ARGUMENT(out_options);
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->worker_count = IREE_VM_ASYNC_SCHEDULER_DEFAULT_WORKER_COUNT;
+  out_options->max_in_flight = IREE_VM_ASYNC_SCHEDULER_DEFAULT_MAX_IN_FLIGHT;
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_async_scheduler_create(
+    iree_vm_async_scheduler_options_t options, iree_allocator_t host_allocator,
+    iree_vm_async_scheduler_t** out_scheduler) {
+  IREE_ASSERT_ARGUMENT(out_scheduler);
+  *out_scheduler = NULL;
+  if (options.worker_count == 0) {
+    options.worker_count = IREE_VM_ASYNC_SCHEDULER_DEFAULT_WORKER_COUNT;
+  }
+  if (options.max_in_flight == 0) {
+    options.max_in_flight = IREE_VM_ASYNC_SCHEDULER_DEFAULT_MAX_IN_FLIGHT;
+  }
+
+  // Workers are assigned invocations least-loaded first so no worker will ever
+  // have more than its even share of the in-flight cap. Each invocation has at
+  // most one operation (run or wait) pending in the loop at a time and the
+  // worker itself has one pending wait on its wake event. The loop keeps one
+  // slot of each of its queues in reserve.
+  const iree_host_size_t worker_capacity =
+      iree_host_size_ceil_div(options.max_in_flight, options.worker_count);
+  iree_loop_sync_options_t loop_options = {
+      .max_queue_depth = worker_capacity + 2,
+      .max_wait_count = worker_capacity + 2,
+  };
+  if (loop_options.max_queue_depth > UINT16_MAX / 2) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "max_in_flight %" PRIhsz
+        " exceeds the per-worker capacity with %" PRIhsz
+        " workers; increase the worker count",
+        options.max_in_flight, options.worker_count);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, (int64_t)options.worker_count);
+
+  iree_vm_async_scheduler_t* scheduler = NULL;
+  const iree_host_size_t total_size =
+      sizeof(*scheduler) + options.worker_count * sizeof(scheduler->workers[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_allocator_malloc(host_allocator, total_size, (void**)&scheduler));
+  memset(scheduler, 0, total_size);
+  iree_atomic_ref_count_init(&scheduler->ref_count);
+  scheduler->host_allocator = host_allocator;
+  scheduler->options = options;
+  iree_notification_initialize(&scheduler->idle_notification);
+  iree_slim_mutex_initialize(&scheduler->mutex);
+  scheduler->worker_count = options.worker_count;
+
+  // Set up all worker loops before starting any threads so that a failure
+  // part way through leaves nothing running. The initial wake wait is armed
+  // here as the worker thread has not yet started.
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < scheduler->worker_count; ++i) {
+    iree_vm_async_scheduler_worker_t* worker = &scheduler->workers[i];
+    worker->scheduler = scheduler;
+    status = iree_event_initialize(/*initial_state=*/false,
+                                   &worker->wake_event);
+    if (!iree_status_is_ok(status)) break;
+    status = iree_loop_sync_allocate(loop_options, host_allocator,
+                                     &worker->loop_sync);
+    if (!iree_status_is_ok(status)) break;
+    iree_loop_sync_scope_initialize(worker->loop_sync,
+                                    iree_vm_async_scheduler_worker_error,
+                                    worker, &worker->scope);
+    status = iree_vm_async_scheduler_worker_arm(
+        worker, iree_loop_sync_scope(&worker->scope));
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  for (iree_host_size_t i = 0;
+       i < scheduler->worker_count && iree_status_is_ok(status); ++i) {
+    iree_vm_async_scheduler_worker_t* worker = &scheduler->workers[i];
+    iree_thread_create_params_t thread_params;
+    memset(&thread_params, 0, sizeof(thread_params));
+    thread_params.name = iree_make_cstring_view("iree-vm-async-worker");
+    thread_params.priority_class = IREE_THREAD_PRIORITY_CLASS_NORMAL;
+    status = iree_thread_create(
+        (iree_thread_entry_t)iree_vm_async_scheduler_worker_main, worker,
+        thread_params, host_allocator, &worker->thread);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_scheduler = scheduler;
+  } else {
+    iree_vm_async_scheduler_destroy(scheduler);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static bool iree_vm_async_scheduler_is_idle(
+    iree_vm_async_scheduler_t* scheduler) {
+  iree_slim_mutex_lock(&scheduler->mutex);
+  bool is_idle = scheduler->pending_count == 0 &&
+                 scheduler->in_flight_count == 0;
+  iree_slim_mutex_unlock(&scheduler->mutex);
+  return is_idle;
+}
+
+// Wakes all workers so they observe the exit request and stop rearming their
+// wake waits. Their loops will then drain and the threads will exit.
+static void iree_vm_async_scheduler_request_exit_locked(
+    iree_vm_async_scheduler_t* scheduler) {
+  scheduler->exiting = true;
+  for (iree_host_size_t i = 0; i < scheduler->worker_count; ++i) {
+    iree_vm_async_scheduler_worker_t* worker = &scheduler->workers[i];
+    if (worker->loop_sync) iree_event_set(&worker->wake_event);
+  }
+}
+
+// Destroys |scheduler| once all outstanding work has completed. May be called
+// from a worker thread after it has exited its loop, in which case that
+// worker's thread is released without joining.
+static void iree_vm_async_scheduler_destroy(
+    iree_vm_async_scheduler_t* scheduler) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Let all outstanding work complete. Worker loops can't be torn down while
+  // invocations are suspended on them without aborting the invocations.
+  iree_notification_await(
+      &scheduler->idle_notification,
+      (iree_condition_fn_t)iree_vm_async_scheduler_is_idle, scheduler,
+      iree_infinite_timeout());
+
+  iree_slim_mutex_lock(&scheduler->mutex);
+  iree_vm_async_scheduler_request_exit_locked(scheduler);
+  iree_slim_mutex_unlock(&scheduler->mutex);
+
+  for (iree_host_size_t i = 0; i < scheduler->worker_count; ++i) {
+    iree_vm_async_scheduler_worker_t* worker = &scheduler->workers[i];
+    // Joins with the thread unless it is the calling thread.
+    iree_thread_release(worker->thread);
+    if (worker->loop_sync) {
+      // Aborts the wake wait if the thread was never started.
+      iree_loop_sync_scope_deinitialize(&worker->scope);
+      iree_loop_sync_free(worker->loop_sync);
+    }
+    iree_event_deinitialize(&worker->wake_event);
+  }
+
+  iree_slim_mutex_deinitialize(&scheduler->mutex);
+  iree_notification_deinitialize(&scheduler->idle_notification);
+  iree_allocator_free(scheduler->host_allocator, scheduler);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_vm_async_scheduler_retain(
+    iree_vm_async_scheduler_t* scheduler) {
+  if (scheduler) {
+    iree_atomic_ref_count_inc(&scheduler->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_vm_async_scheduler_release(
+    iree_vm_async_scheduler_t* scheduler) {
+  if (!scheduler || iree_atomic_ref_count_dec(&scheduler->ref_count) != 1) {
+    return;
+  }
+  iree_vm_async_scheduler_worker_t* current_worker =
+      iree_vm_async_scheduler_current_worker();
+  if (current_worker && current_worker->scheduler == scheduler) {
+    // Released from within a completion callback: the worker can't wait for
+    // itself to go idle or join its own thread. Have it destroy the scheduler
+    // once all work has completed and its loop has exited.
+    iree_slim_mutex_lock(&scheduler->mutex);
+    scheduler->deferred_destroy_worker = current_worker;
+    if (scheduler->pending_count == 0 && scheduler->in_flight_count == 0) {
+      iree_vm_async_scheduler_request_exit_locked(scheduler);
+    }
+    iree_slim_mutex_unlock(&scheduler->mutex);
+  } else {
+    iree_vm_async_scheduler_destroy(scheduler);
+  }
+}
+
+// Admits pending invocations up to the in-flight cap by assigning them to the
+// least-loaded worker and waking it.
+static void iree_vm_async_scheduler_admit_locked(
+    iree_vm_async_scheduler_t* scheduler) {
+  while (scheduler->pending.head &&
+         scheduler->in_flight_count < scheduler->options.max_in_flight) {
+    iree_vm_async_scheduler_worker_t* target_worker = &scheduler->workers[0];
+    for (iree_host_size_t i = 1; i < scheduler->worker_count; ++i) {
+      iree_vm_async_scheduler_worker_t* worker = &scheduler->workers[i];
+      if (worker->in_flight_count < target_worker->in_flight_count) {
+        target_worker = worker;
+      }
+    }
+    iree_vm_async_scheduler_invocation_t* invocation =
+        iree_vm_async_scheduler_invocation_list_pop_front(&scheduler->pending);
+    --scheduler->pending_count;
+    invocation->worker = target_worker;
+    ++target_worker->in_flight_count;
+    ++scheduler->in_flight_count;
+    scheduler->peak_in_flight_count = iree_max(
+        scheduler->peak_in_flight_count, scheduler->in_flight_count);
+    iree_vm_async_scheduler_invocation_list_push_back(&target_worker->inbox,
+                                                      invocation);
+    iree_event_set(&target_worker->wake_event);
+  }
+  IREE_TRACE_PLOT_VALUE_I64("iree_vm_async_scheduler_in_flight",
+                            scheduler->in_flight_count);
+}
+
+// Retires an invocation that has issued its callback. |worker| is the worker
+// it was admitted to or NULL if it was never admitted.
+static void iree_vm_async_scheduler_retire(
+    iree_vm_async_scheduler_t* scheduler,
+    iree_vm_async_scheduler_worker_t* worker) {
+  iree_slim_mutex_lock(&scheduler->mutex);
+  if (worker) {
+    --worker->in_flight_count;
+    --scheduler->in_flight_count;
+  }
+  ++scheduler->completed_count;
+  iree_vm_async_scheduler_admit_locked(scheduler);
+  bool is_idle =
+      scheduler->pending_count == 0 && scheduler->in_flight_count == 0;
+  if (is_idle && scheduler->deferred_destroy_worker) {
+    // Last reference was dropped from a completion callback; now that all work
+    // has completed the workers can exit and the scheduler be destroyed.
+    iree_vm_async_scheduler_request_exit_locked(scheduler);
+  }
+  iree_slim_mutex_unlock(&scheduler->mutex);
+  if (is_idle) {
+    iree_notification_post(&scheduler->idle_notification, IREE_ALL_WAITERS);
+  }
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_async_scheduler_invoke(
+    iree_vm_async_scheduler_t* scheduler,
+    iree_vm_async_scheduler_invocation_t* invocation,
+    iree_vm_context_t* context, iree_vm_function_t function,
+    iree_vm_invocation_flags_t flags, const iree_vm_invocation_policy_t* policy,
+    iree_vm_list_t* inputs, iree_vm_list_t* outputs,
+    iree_allocator_t host_allocator,
+    iree_vm_async_scheduler_callback_fn_t callback, void* user_data) {
+  IREE_ASSERT_ARGUMENT(scheduler);
+  IREE_ASSERT_ARGUMENT(invocation);
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(callback);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  invocation->next = NULL;
+  invocation->worker = NULL;
+  invocation->context = context;
+  iree_vm_context_retain(context);
+  invocation->function = function;
+  invocation->flags = flags;
+  invocation->policy = policy;
+  invocation->inputs = inputs;
+  iree_vm_list_retain(inputs);
+  invocation->outputs = outputs;
+  iree_vm_list_retain(outputs);
+  invocation->host_allocator = host_allocator;
+  invocation->callback = callback;
+  invocation->user_data = user_data;
+
+  iree_slim_mutex_lock(&scheduler->mutex);
+  iree_vm_async_scheduler_invocation_list_push_back(&scheduler->pending,
+                                                    invocation);
+  ++scheduler->pending_count;
+  iree_vm_async_scheduler_admit_locked(scheduler);
+  IREE_TRACE_PLOT_VALUE_I64("iree_vm_async_scheduler_pending",
+                            scheduler->pending_count);
+  iree_slim_mutex_unlock(&scheduler->mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_async_scheduler_wait_idle(
+    iree_vm_async_scheduler_t* scheduler, iree_timeout_t timeout) {
+  IREE_ASSERT_ARGUMENT(scheduler);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  bool is_idle = iree_notification_await(
+      &scheduler->idle_notification,
+      (iree_condition_fn_t)iree_vm_async_scheduler_is_idle, scheduler,
+      timeout);
+  IREE_TRACE_ZONE_END(z0);
+  return is_idle ? iree_ok_status()
+                 : iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+}
+
+IREE_API_EXPORT void iree_vm_async_scheduler_query_statistics(
+    iree_vm_async_scheduler_t* scheduler,
+    iree_vm_async_scheduler_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(scheduler);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  iree_slim_mutex_lock(&scheduler->mutex);
+  out_statistics->pending_count = scheduler->pending_count;
+  out_statistics->in_flight_count = scheduler->in_flight_count;
+  out_statistics->peak_in_flight_count = scheduler->peak_in_flight_count;
+  out_statistics->completed_count = scheduler->completed_count;
+  iree_slim_mutex_unlock(&scheduler->mutex);
+}
+
+//===----------------------------------------------------------------------===//
+// iree_vm_async_scheduler_worker_t
+//===----------------------------------------------------------------------===//
+
+// Issued from the worker loop when an invocation completes.
+static iree_status_t iree_vm_async_scheduler_invocation_complete(
+    void* user_data, iree_loop_t loop, iree_status_t status,
+    iree_vm_list_t* outputs) {
+  iree_vm_async_scheduler_invocation_t* invocation =
+      (iree_vm_async_scheduler_invocation_t*)user_data;
+  // The callback may free the invocation storage.
+  iree_vm_async_scheduler_worker_t* worker = invocation->worker;
+  invocation->callback(invocation->user_data, status, outputs);
+  iree_vm_async_scheduler_retire(worker->scheduler, worker);
+  // Invocation failures are routed to the user callback and must not
+  // propagate to the loop scope where they would abort unrelated invocations.
+  return iree_ok_status();
+}
+
+// Begins |invocation| on the worker |loop|. The invocation will run until it
+// first yields or waits.
+static void iree_vm_async_scheduler_worker_begin(
+    iree_vm_async_scheduler_worker_t* worker, iree_loop_t loop,
+    iree_vm_async_scheduler_invocation_t* invocation) {
+  // The async invocation retains its own references and may complete (and
+  // have the invocation storage freed) before returning.
+  iree_vm_context_t* context = invocation->context;
+  iree_vm_list_t* inputs = invocation->inputs;
+  iree_vm_list_t* outputs = invocation->outputs;
+  iree_status_t status = iree_vm_async_invoke(
+      loop, &invocation->state, context, invocation->function,
+      invocation->flags, invocation->policy, inputs, outputs,
+      invocation->host_allocator, iree_vm_async_scheduler_invocation_complete,
+      invocation);
+  iree_vm_list_release(outputs);
+  iree_vm_list_release(inputs);
+  iree_vm_context_release(context);
+  if (!iree_status_is_ok(status)) {
+    // Failed to enqueue; the callback was not issued.
+    invocation->callback(invocation->user_data, status, NULL);
+    iree_vm_async_scheduler_retire(worker->scheduler, worker);
+  }
+}
+
+// Issued from the worker loop when the wake event is signaled.
+static iree_status_t iree_vm_async_scheduler_worker_wake(
+    void* user_data, iree_loop_t loop, iree_status_t loop_status) {
+  iree_vm_async_scheduler_worker_t* worker =
+      (iree_vm_async_scheduler_worker_t*)user_data;
+  iree_vm_async_scheduler_t* scheduler = worker->scheduler;
+
+  if (IREE_UNLIKELY(!iree_status_is_ok(loop_status))) {
+    // The wake wait was aborted along with everything else on the worker loop.
+    // The inbox is left intact and the event signaled so that the worker picks
+    // it up after it rearms.
+    iree_status_ignore(loop_status);
+    return iree_ok_status();
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_slim_mutex_lock(&scheduler->mutex);
+  iree_event_reset(&worker->wake_event);
+  iree_vm_async_scheduler_invocation_list_t inbox =
+      iree_vm_async_scheduler_invocation_list_take(&worker->inbox);
+  bool exiting = scheduler->exiting;
+  iree_slim_mutex_unlock(&scheduler->mutex);
+
+  iree_vm_async_scheduler_invocation_t* invocation = NULL;
+  while ((invocation =
+              iree_vm_async_scheduler_invocation_list_pop_front(&inbox))) {
+    iree_vm_async_scheduler_worker_begin(worker, loop, invocation);
+  }
+
+  // Rearm unless exiting. The scheduler is only destroyed when idle so there
+  // will be no more invocations to run once the wait is dropped.
+  iree_status_t status = iree_ok_status();
+  if (!exiting) {
+    status = iree_vm_async_scheduler_worker_arm(worker, loop);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_vm_async_scheduler_worker_arm(
+    iree_vm_async_scheduler_worker_t* worker, iree_loop_t loop) {
+  return iree_loop_wait_one(loop, iree_event_await(&worker->wake_event),
+                            iree_infinite_timeout(),
+                            iree_vm_async_scheduler_worker_wake, worker);
+}
+
+// Handles errors propagated to the worker loop scope. All operations in the
+// scope will be aborted after this returns, which completes all invocations
+// running on the worker with IREE_STATUS_ABORTED. The failure is not latched:
+// the worker rearms its wake wait once its loop has drained and continues to
+// run newly admitted invocations.
+static void iree_vm_async_scheduler_worker_error(void* user_data,
+                                                 iree_status_t status) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_TEXT(
+      z0, iree_status_code_string(iree_status_code(status)));
+  iree_status_ignore(status);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Aborts all operations on the worker loop. Scopes abort their operations when
+// deinitialized and can be reinitialized in-place for reuse.
+static void iree_vm_async_scheduler_worker_abort(
+    iree_vm_async_scheduler_worker_t* worker) {
+  iree_loop_sync_scope_deinitialize(&worker->scope);
+  iree_loop_sync_scope_initialize(worker->loop_sync,
+                                  iree_vm_async_scheduler_worker_error, worker,
+                                  &worker->scope);
+}
+
+static int iree_vm_async_scheduler_worker_main(
+    iree_vm_async_scheduler_worker_t* worker) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_vm_async_scheduler_t* scheduler = worker->scheduler;
+  iree_vm_async_scheduler_set_current_worker(worker);
+
+  bool destroy = false;
+  while (true) {
+    // Run until the wake wait is no longer armed: either the scheduler is
+    // exiting or a failure aborted everything on the loop.
+    iree_status_t status =
+        iree_loop_sync_wait_idle(worker->loop_sync, iree_infinite_timeout());
+    if (!iree_status_is_ok(status)) {
+      // Drain failures are not attributed to a scope; treat them as scope
+      // failures and abort everything on this worker so waiters are released.
+      iree_vm_async_scheduler_worker_error(worker, status);
+      iree_vm_async_scheduler_worker_abort(worker);
+    }
+
+    iree_slim_mutex_lock(&scheduler->mutex);
+    bool exiting = scheduler->exiting;
+    destroy = scheduler->deferred_destroy_worker == worker;
+    iree_slim_mutex_unlock(&scheduler->mutex);
+    if (exiting) break;
+
+    // Recover from the failure by rearming the wake wait; any invocations
+    // admitted in the meantime are still in the inbox.
+    status = iree_vm_async_scheduler_worker_arm(
+        worker, iree_loop_sync_scope(&worker->scope));
+    if (!iree_status_is_ok(status)) {
+      iree_vm_async_scheduler_worker_error(worker, status);
+      break;
+    }
+  }
+
+  // If the last reference was released on this worker it is responsible for
+  // destroying the scheduler. The worker must not be touched afterward.
+  iree_vm_async_scheduler_set_current_worker(NULL);
+  if (destroy) iree_vm_async_scheduler_destroy(scheduler);
+
+  IREE_TRACE_ZONE_END(z0);
+  return 0;
+}
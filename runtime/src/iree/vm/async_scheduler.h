@@ -0,0 +1,181 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// See iree/base/api.h for documentation on the API conventions used.
+
+#ifndef IREE_VM_ASYNC_SCHEDULER_H_
+#define IREE_VM_ASYNC_SCHEDULER_H_
+
+#include "iree/base/api.h"
+#include "iree/vm/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+typedef struct iree_vm_async_scheduler_t iree_vm_async_scheduler_t;
+typedef struct iree_vm_async_scheduler_worker_t
+    iree_vm_async_scheduler_worker_t;
+
+//===----------------------------------------------------------------------===//
+// iree_vm_async_scheduler_t
+//===----------------------------------------------------------------------===//
+
+// Default number of worker threads used when none is specified.
+#define IREE_VM_ASYNC_SCHEDULER_DEFAULT_WORKER_COUNT 2
+
+// Default maximum number of invocations in-flight across all workers.
+#define IREE_VM_ASYNC_SCHEDULER_DEFAULT_MAX_IN_FLIGHT 1024
+
+// Options controlling scheduler behavior.
+typedef struct iree_vm_async_scheduler_options_t {
+  // Total number of worker threads. Each worker runs its own loop and may have
+  // many invocations suspended on it at a time.
+  iree_host_size_t worker_count;
+  // Maximum number of invocations that may have begun and not yet completed.
+  // Invocations submitted beyond this are queued in submission order and
+  // begun as others complete.
+  iree_host_size_t max_in_flight;
+} iree_vm_async_scheduler_options_t;
+
+// Initializes |out_options| to their default values.
+IREE_API_EXPORT void iree_vm_async_scheduler_options_initialize(
+    iree_vm_async_scheduler_options_t* out_options);
+
+// Point-in-time scheduler statistics.
+typedef struct iree_vm_async_scheduler_statistics_t {
+  // Invocations submitted but not yet begun due to the in-flight cap.
+  iree_host_size_t pending_count;
+  // Invocations that have begun and not yet completed.
+  iree_host_size_t in_flight_count;
+  // Highest in-flight count observed since creation.
+  iree_host_size_t peak_in_flight_count;
+  // Total invocations that have completed (successfully or not).
+  uint64_t completed_count;
+} iree_vm_async_scheduler_statistics_t;
+
+// Callback notifying the submitter of an invocation that it has completed.
+// If successful then |outputs| will contain the results. Ownership of both
+// |status| and |outputs| is transferred to the callee.
+//
+// This is executed on a scheduler worker thread and must not block; any
+// blocking work will stall all other invocations multiplexed on the worker.
+// The invocation storage may be reused or freed from within the callback.
+typedef void(IREE_API_PTR* iree_vm_async_scheduler_callback_fn_t)(
+    void* user_data, iree_status_t status, iree_vm_list_t* outputs);
+
+// Storage for an invocation submitted to the scheduler.
+// This is intended to be embedded within higher-level request objects or on
+// the heap and must remain live until the callback is issued. The scheduler
+// performs no allocations per invocation.
+typedef struct iree_vm_async_scheduler_invocation_t {
+  // Intrusive link used while queued for admission or for a worker.
+  struct iree_vm_async_scheduler_invocation_t* next;
+  // Worker the invocation was assigned to once admitted.
+  iree_vm_async_scheduler_worker_t* worker;
+  // Parameters retained until the invocation is begun on the worker.
+  iree_vm_context_t* context;
+  iree_vm_function_t function;
+  iree_vm_invocation_flags_t flags;
+  const iree_vm_invocation_policy_t* policy;
+  iree_vm_list_t* inputs;
+  iree_vm_list_t* outputs;
+  iree_allocator_t host_allocator;
+  // Callback issued when the invocation completes.
+  iree_vm_async_scheduler_callback_fn_t callback;
+  void* user_data;
+  // Loop-based invocation state used while running on the worker.
+  iree_vm_async_invoke_state_t state;
+} iree_vm_async_scheduler_invocation_t;
+
+// A cooperative scheduler multiplexing many concurrent invocations onto a
+// small pool of worker threads.
+//
+// Each worker runs an iree_loop_sync_t that invocations are begun on with
+// iree_vm_async_invoke. When an invocation yields or waits on a wait source it
+// is suspended on the worker loop and the worker continues running other
+// invocations; waiting invocations are resumed when their wait sources resolve
+// via the loop multi-wait. Invocations are never preempted: an invocation runs
+// until it yields, waits, or completes.
+//
+// Fairness is provided by admitting queued invocations in submission order,
+// assigning each admitted invocation to the worker with the fewest in-flight
+// invocations, and running resumed invocations in FIFO order on each worker.
+//
+// Invocations of the same context may only overlap if the context was created
+// with the IREE_VM_CONTEXT_FLAG_CONCURRENT flag set.
+//
+// Thread-safe: invocations may be submitted from any thread, including from
+// within completion callbacks.
+//
+// Usage:
+//  iree_vm_async_scheduler_options_t options;
+//  iree_vm_async_scheduler_options_initialize(&options);
+//  options.worker_count = 4;
+//  iree_vm_async_scheduler_t* scheduler = NULL;
+//  iree_vm_async_scheduler_create(options, host_allocator, &scheduler);
+//  for each request:
+//    request_t* request = ...;  // embeds iree_vm_async_scheduler_invocation_t
+//    iree_vm_async_scheduler_invoke(scheduler, &request->invocation, context,
+//                                   function, ..., callback, request);
+//  iree_vm_async_scheduler_release(scheduler);  // waits for all to complete
+
+// Allocates a new scheduler and starts its worker threads.
+// |out_scheduler| must be released by the caller.
+IREE_API_EXPORT iree_status_t iree_vm_async_scheduler_create(
+    iree_vm_async_scheduler_options_t options, iree_allocator_t host_allocator,
+    iree_vm_async_scheduler_t** out_scheduler);
+
+// Retains the given |scheduler| for the caller.
+IREE_API_EXPORT void iree_vm_async_scheduler_retain(
+    iree_vm_async_scheduler_t* scheduler);
+
+// Releases the given |scheduler| from the caller.
+// When the last reference is released all pending and in-flight invocations
+// are allowed to complete before the worker threads are joined. If released
+// from within a completion callback the call returns immediately and the
+// scheduler is destroyed by its worker once all invocations have completed.
+IREE_API_EXPORT void iree_vm_async_scheduler_release(
+    iree_vm_async_scheduler_t* scheduler);
+
+// Submits an invocation of |function| in |context| to the |scheduler|.
+// The call returns immediately and the |callback| will be issued on a worker
+// thread when the invocation completes (possibly before this call returns).
+//
+// |invocation| is caller-owned storage that must remain live until the
+// callback is issued. |context|, |inputs|, and |outputs| are retained until no
+// longer required; see iree_vm_async_invoke for their semantics.
+//
+// Failures of the invocation are reported only to its |callback|. If the worker
+// loop the invocation is running on fails then the invocations running on it
+// complete with IREE_STATUS_ABORTED and the worker continues with new work.
+//
+// Returns an error without issuing the callback if the invocation could not be
+// submitted.
+IREE_API_EXPORT iree_status_t iree_vm_async_scheduler_invoke(
+    iree_vm_async_scheduler_t* scheduler,
+    iree_vm_async_scheduler_invocation_t* invocation,
+    iree_vm_context_t* context, iree_vm_function_t function,
+    iree_vm_invocation_flags_t flags, const iree_vm_invocation_policy_t* policy,
+    iree_vm_list_t* inputs, iree_vm_list_t* outputs,
+    iree_allocator_t host_allocator,
+    iree_vm_async_scheduler_callback_fn_t callback, void* user_data);
+
+// Blocks the caller until there are no pending or in-flight invocations.
+// Returns IREE_STATUS_DEADLINE_EXCEEDED if |timeout| elapses first.
+IREE_API_EXPORT iree_status_t iree_vm_async_scheduler_wait_idle(
+    iree_vm_async_scheduler_t* scheduler, iree_timeout_t timeout);
+
+// Queries a point-in-time snapshot of scheduler statistics.
+IREE_API_EXPORT void iree_vm_async_scheduler_query_statistics(
+    iree_vm_async_scheduler_t* scheduler,
+    iree_vm_async_scheduler_statistics_t* out_statistics);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_VM_ASYNC_SCHEDULER_H_
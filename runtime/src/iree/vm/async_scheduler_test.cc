@@ -0,0 +1,494 @@
+// Copyright 2024 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Tests the scheduler with a native module so that the scheduling behavior
+// (wait resumption, ordering, and failure handling) can be observed directly
+// and with bytecode invocations of iree/vm/test/async_ops.mlir.
+
+#include "iree/vm/async_scheduler.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/wait_handle.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+#include "iree/vm/bytecode/module.h"
+
+// Compiled module embedded here to avoid file IO:
+#include "iree/vm/test/async_bytecode_modules.h"
+
+namespace iree {
+namespace {
+
+// Number of times each invocation of @yield yields before returning.
+static constexpr int32_t kYieldCount = 3;
+
+// State shared by all functions of the test module.
+struct TestModule {
+  // Resolves the waits of @wait.
+  iree_event_t wait_event;
+  // Unblocks @block.
+  iree_event_t block_event;
+  // Number of invocations of @block that have started.
+  std::atomic<int> block_count{0};
+  // Argument of @yield recorded each time one of its invocations ran.
+  std::mutex mutex;
+  std::vector<int32_t> trace;
+};
+
+typedef iree_status_t (*TestFunction)(iree_vm_stack_t* stack,
+                                      TestModule* module, int32_t* value);
+
+// Shim for `(i32) -> i32` functions that may be resumed. The argument is only
+// available on the initial call so it is stashed in the result storage where
+// the function operates on it in place until it completes.
+static iree_status_t CallShim(iree_vm_stack_t* stack,
+                              iree_vm_native_function_flags_t flags,
+                              iree_byte_span_t args_storage,
+                              iree_byte_span_t rets_storage,
+                              TestFunction target_fn, void* module,
+                              void* module_state) {
+  int32_t* value = reinterpret_cast<int32_t*>(rets_storage.data);
+  if (!iree_any_bit_set(flags, IREE_VM_NATIVE_FUNCTION_CALL_RESUME)) {
+    *value = *reinterpret_cast<const int32_t*>(args_storage.data);
+  }
+  return target_fn(stack, reinterpret_cast<TestModule*>(module), value);
+}
+
+// Blocks the worker thread until |block_event| is set.
+static iree_status_t Block(iree_vm_stack_t* stack, TestModule* module,
+                           int32_t* value) {
+  ++module->block_count;
+  return iree_wait_one(&module->block_event, IREE_TIME_INFINITE_FUTURE);
+}
+
+// Fails the invocation.
+static iree_status_t Fail(iree_vm_stack_t* stack, TestModule* module,
+                          int32_t* value) {
+  return iree_make_status(IREE_STATUS_DATA_LOSS, "failed %d", *value);
+}
+
+// Waits on |wait_event| and returns the argument plus one. If the argument is
+// negative the wait times out instead.
+static iree_status_t Wait(iree_vm_stack_t* stack, TestModule* module,
+                          int32_t* value) {
+  iree_vm_stack_frame_t* current_frame = iree_vm_stack_top(stack);
+  if (current_frame->pc == 0) {
+    current_frame->pc = 1;
+    iree_timeout_t timeout =
+        *value < 0 ? iree_make_timeout_ms(1) : iree_infinite_timeout();
+    iree_vm_wait_frame_t* wait_frame = NULL;
+    IREE_RETURN_IF_ERROR(iree_vm_stack_wait_enter(stack, IREE_VM_WAIT_ALL, 1,
+                                                  timeout, 0, &wait_frame));
+    wait_frame->wait_sources[0] = iree_event_await(&module->wait_event);
+    return iree_status_from_code(IREE_STATUS_DEFERRED);
+  }
+  iree_vm_wait_result_t wait_result;
+  IREE_RETURN_IF_ERROR(iree_vm_stack_wait_leave(stack, &wait_result));
+  IREE_RETURN_IF_ERROR(wait_result.status);
+  ++*value;
+  return iree_ok_status();
+}
+
+// Records the argument in the module trace and yields kYieldCount times before
+// returning the argument.
+static iree_status_t Yield(iree_vm_stack_t* stack, TestModule* module,
+                           int32_t* value) {
+  {
+    std::lock_guard<std::mutex> lock(module->mutex);
+    module->trace.push_back(*value);
+  }
+  iree_vm_stack_frame_t* current_frame = iree_vm_stack_top(stack);
+  if (current_frame->pc < kYieldCount) {
+    ++current_frame->pc;
+    return iree_status_from_code(IREE_STATUS_DEFERRED);
+  }
+  return iree_ok_status();
+}
+
+static const iree_vm_native_export_descriptor_t kTestModuleExports[] = {
+    {IREE_SV("block"), IREE_SV("0i_i"), 0, NULL},
+    {IREE_SV("fail"), IREE_SV("0i_i"), 0, NULL},
+    {IREE_SV("wait"), IREE_SV("0i_i"), 0, NULL},
+    {IREE_SV("yield"), IREE_SV("0i_i"), 0, NULL},
+};
+static const iree_vm_native_function_ptr_t kTestModuleFunctions[] = {
+    {(iree_vm_native_function_shim_t)CallShim,
+     (iree_vm_native_function_target_t)Block},
+    {(iree_vm_native_function_shim_t)CallShim,
+     (iree_vm_native_function_target_t)Fail},
+    {(iree_vm_native_function_shim_t)CallShim,
+     (iree_vm_native_function_target_t)Wait},
+    {(iree_vm_native_function_shim_t)CallShim,
+     (iree_vm_native_function_target_t)Yield},
+};
+static_assert(IREE_ARRAYSIZE(kTestModuleFunctions) ==
+                  IREE_ARRAYSIZE(kTestModuleExports),
+              "function pointer table must be 1:1 with exports");
+static const iree_vm_native_module_descriptor_t kTestModuleDescriptor = {
+    /*name=*/IREE_SV("test"),
+    /*version=*/0,
+    /*attr_count=*/0,
+    /*attrs=*/NULL,
+    /*dependency_count=*/0,
+    /*dependencies=*/NULL,
+    /*import_count=*/0,
+    /*imports=*/NULL,
+    /*export_count=*/IREE_ARRAYSIZE(kTestModuleExports),
+    /*exports=*/kTestModuleExports,
+    /*function_count=*/IREE_ARRAYSIZE(kTestModuleFunctions),
+    /*functions=*/kTestModuleFunctions,
+};
+
+struct Request {
+  iree_vm_async_scheduler_invocation_t invocation;
+  int32_t arg_value = 0;
+  int32_t ret_value = 0;
+  std::atomic<iree_status_code_t> status_code{IREE_STATUS_UNKNOWN};
+  // Reference released from within the completion callback, if any.
+  iree_vm_async_scheduler_t* scheduler = NULL;
+};
+
+static void OnRequestComplete(void* user_data, iree_status_t status,
+                              iree_vm_list_t* outputs) {
+  auto* request = reinterpret_cast<Request*>(user_data);
+  if (iree_status_is_ok(status)) {
+    iree_vm_value_t value;
+    status = iree_vm_list_get_value(outputs, 0, &value);
+    if (iree_status_is_ok(status)) request->ret_value = value.i32;
+  }
+  iree_vm_list_release(outputs);
+  iree_vm_async_scheduler_release(request->scheduler);
+  request->status_code = iree_status_consume_code(status);
+}
+
+// Counts live allocations made through the tracking allocator.
+static std::atomic<int> live_allocation_count{0};
+
+static iree_status_t TrackingAllocatorCtl(void* self,
+                                          iree_allocator_command_t command,
+                                          const void* params,
+                                          void** inout_ptr) {
+  bool is_new = command == IREE_ALLOCATOR_COMMAND_MALLOC ||
+                command == IREE_ALLOCATOR_COMMAND_CALLOC ||
+                (command == IREE_ALLOCATOR_COMMAND_REALLOC && !*inout_ptr);
+  if (command == IREE_ALLOCATOR_COMMAND_FREE) --live_allocation_count;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_system_ctl(NULL, command, params, inout_ptr));
+  if (is_new) ++live_allocation_count;
+  return iree_ok_status();
+}
+
+class VMAsyncSchedulerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(
+        iree_event_initialize(/*initial_state=*/false, &module_.wait_event));
+    IREE_ASSERT_OK(
+        iree_event_initialize(/*initial_state=*/false, &module_.block_event));
+    IREE_ASSERT_OK(iree_vm_instance_create(
+        IREE_VM_TYPE_CAPACITY_DEFAULT, iree_allocator_system(), &instance_));
+    iree_vm_module_t interface;
+    IREE_ASSERT_OK(iree_vm_module_initialize(&interface, &module_));
+    IREE_ASSERT_OK(iree_vm_native_module_create(
+        &interface, &kTestModuleDescriptor, instance_, iree_allocator_system(),
+        &native_module_));
+    const iree_file_toc_t* file = async_bytecode_modules_c_create();
+    IREE_ASSERT_OK(iree_vm_bytecode_module_create(
+        instance_,
+        iree_const_byte_span_t{reinterpret_cast<const uint8_t*>(file->data),
+                               static_cast<iree_host_size_t>(file->size)},
+        iree_allocator_null(), iree_allocator_system(), &bytecode_module_));
+    iree_vm_module_t* modules[] = {native_module_, bytecode_module_};
+    IREE_ASSERT_OK(iree_vm_context_create_with_modules(
+        instance_, IREE_VM_CONTEXT_FLAG_CONCURRENT, IREE_ARRAYSIZE(modules),
+        modules, iree_allocator_system(), &context_));
+  }
+
+  void TearDown() override {
+    iree_vm_context_release(context_);
+    iree_vm_module_release(bytecode_module_);
+    iree_vm_module_release(native_module_);
+    iree_vm_instance_release(instance_);
+    iree_event_deinitialize(&module_.block_event);
+    iree_event_deinitialize(&module_.wait_event);
+  }
+
+  iree_vm_async_scheduler_t* CreateScheduler(
+      iree_host_size_t worker_count, iree_host_size_t max_in_flight,
+      iree_allocator_t host_allocator = iree_allocator_system()) {
+    iree_vm_async_scheduler_options_t options;
+    iree_vm_async_scheduler_options_initialize(&options);
+    options.worker_count = worker_count;
+    options.max_in_flight = max_in_flight;
+    iree_vm_async_scheduler_t* scheduler = NULL;
+    IREE_CHECK_OK(
+        iree_vm_async_scheduler_create(options, host_allocator, &scheduler));
+    return scheduler;
+  }
+
+  // Submits |request| as an invocation of the native function named |name|.
+  iree_status_t Submit(iree_vm_async_scheduler_t* scheduler, const char* name,
+                       Request* request) {
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(iree_vm_module_lookup_function_by_name(
+        native_module_, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+        iree_make_cstring_view(name), &function));
+    return Submit(scheduler, function, request);
+  }
+
+  // Submits |request| as an invocation of |function|.
+  iree_status_t Submit(iree_vm_async_scheduler_t* scheduler,
+                       iree_vm_function_t function, Request* request) {
+    iree_vm_list_t* inputs = NULL;
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(iree_vm_make_undefined_type_def(),
+                                             1, iree_allocator_system(),
+                                             &inputs));
+    iree_vm_value_t arg = iree_vm_value_make_i32(request->arg_value);
+    iree_status_t status = iree_vm_list_push_value(inputs, &arg);
+    iree_vm_list_t* outputs = NULL;
+    if (iree_status_is_ok(status)) {
+      status = iree_vm_list_create(iree_vm_make_undefined_type_def(), 1,
+                                   iree_allocator_system(), &outputs);
+    }
+    if (iree_status_is_ok(status)) {
+      status = iree_vm_async_scheduler_invoke(
+          scheduler, &request->invocation, context_, function,
+          IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/NULL, inputs, outputs,
+          iree_allocator_system(), OnRequestComplete, request);
+    }
+    iree_vm_list_release(outputs);
+    iree_vm_list_release(inputs);
+    return status;
+  }
+
+  std::vector<int32_t> Trace() {
+    std::lock_guard<std::mutex> lock(module_.mutex);
+    return module_.trace;
+  }
+
+  TestModule module_;
+  iree_vm_instance_t* instance_ = NULL;
+  iree_vm_module_t* native_module_ = NULL;
+  iree_vm_module_t* bytecode_module_ = NULL;
+  iree_vm_context_t* context_ = NULL;
+};
+
+// Invocations waiting on wait sources must not block other invocations on the
+// same worker and must resume once their wait sources resolve.
+TEST_F(VMAsyncSchedulerTest, WaitSourceResumption) {
+  iree_vm_async_scheduler_t* scheduler =
+      CreateScheduler(/*worker_count=*/1, /*max_in_flight=*/8);
+
+  std::vector<Request> waits(4);
+  for (size_t i = 0; i < waits.size(); ++i) {
+    waits[i].arg_value = static_cast<int32_t>(i);
+    IREE_ASSERT_OK(Submit(scheduler, "wait", &waits[i]));
+  }
+
+  // Runs to completion on the worker while all of the waits are suspended.
+  Request yield;
+  IREE_ASSERT_OK(Submit(scheduler, "yield", &yield));
+  while (yield.status_code == IREE_STATUS_UNKNOWN) std::this_thread::yield();
+  EXPECT_EQ(yield.status_code, IREE_STATUS_OK);
+
+  iree_vm_async_scheduler_statistics_t statistics;
+  iree_vm_async_scheduler_query_statistics(scheduler, &statistics);
+  EXPECT_EQ(statistics.in_flight_count, waits.size());
+  for (auto& wait : waits) EXPECT_EQ(wait.status_code, IREE_STATUS_UNKNOWN);
+
+  iree_event_set(&module_.wait_event);
+  IREE_ASSERT_OK(
+      iree_vm_async_scheduler_wait_idle(scheduler, iree_infinite_timeout()));
+  for (auto& wait : waits) {
+    EXPECT_EQ(wait.status_code, IREE_STATUS_OK);
+    EXPECT_EQ(wait.ret_value, wait.arg_value + 1);
+  }
+
+  iree_vm_async_scheduler_release(scheduler);
+}
+
+// Yielding invocations on a worker are resumed round-robin so that no
+// invocation runs more than one step ahead of the others.
+TEST_F(VMAsyncSchedulerTest, YieldFairness) {
+  iree_vm_async_scheduler_t* scheduler =
+      CreateScheduler(/*worker_count=*/1, /*max_in_flight=*/8);
+
+  // Hold the worker so that all invocations are admitted before any begin.
+  Request block;
+  IREE_ASSERT_OK(Submit(scheduler, "block", &block));
+  while (module_.block_count < 1) std::this_thread::yield();
+  std::vector<Request> yields(4);
+  for (size_t i = 0; i < yields.size(); ++i) {
+    yields[i].arg_value = static_cast<int32_t>(i);
+    IREE_ASSERT_OK(Submit(scheduler, "yield", &yields[i]));
+  }
+  iree_event_set(&module_.block_event);
+  IREE_ASSERT_OK(
+      iree_vm_async_scheduler_wait_idle(scheduler, iree_infinite_timeout()));
+
+  std::vector<int32_t> trace = Trace();
+  ASSERT_EQ(trace.size(), yields.size() * (kYieldCount + 1));
+  for (size_t i = 0; i < trace.size(); ++i) {
+    EXPECT_EQ(trace[i], static_cast<int32_t>(i % yields.size()));
+  }
+  for (auto& yield : yields) {
+    EXPECT_EQ(yield.status_code, IREE_STATUS_OK);
+    EXPECT_EQ(yield.ret_value, yield.arg_value);
+  }
+
+  iree_vm_async_scheduler_release(scheduler);
+}
+
+// Invocations beyond the in-flight cap are begun in submission order.
+TEST_F(VMAsyncSchedulerTest, AdmissionOrder) {
+  iree_vm_async_scheduler_t* scheduler =
+      CreateScheduler(/*worker_count=*/2, /*max_in_flight=*/1);
+
+  std::vector<Request> yields(8);
+  for (size_t i = 0; i < yields.size(); ++i) {
+    yields[i].arg_value = static_cast<int32_t>(i);
+    IREE_ASSERT_OK(Submit(scheduler, "yield", &yields[i]));
+  }
+  IREE_ASSERT_OK(
+      iree_vm_async_scheduler_wait_idle(scheduler, iree_infinite_timeout()));
+
+  std::vector<int32_t> trace = Trace();
+  ASSERT_EQ(trace.size(), yields.size() * (kYieldCount + 1));
+  for (size_t i = 0; i < trace.size(); ++i) {
+    EXPECT_EQ(trace[i], static_cast<int32_t>(i / (kYieldCount + 1)));
+  }
+
+  iree_vm_async_scheduler_statistics_t statistics;
+  iree_vm_async_scheduler_query_statistics(scheduler, &statistics);
+  EXPECT_EQ(statistics.peak_in_flight_count, 1);
+  EXPECT_EQ(statistics.completed_count, yields.size());
+
+  iree_vm_async_scheduler_release(scheduler);
+}
+
+// Failures are reported only to the failing invocation and don't prevent
+// other invocations on the same worker or later submissions from running.
+TEST_F(VMAsyncSchedulerTest, FailurePropagation) {
+  iree_vm_async_scheduler_t* scheduler =
+      CreateScheduler(/*worker_count=*/1, /*max_in_flight=*/8);
+
+  Request block;
+  IREE_ASSERT_OK(Submit(scheduler, "block", &block));
+  Request fail;
+  IREE_ASSERT_OK(Submit(scheduler, "fail", &fail));
+  Request timed_out_wait;
+  timed_out_wait.arg_value = -1;
+  IREE_ASSERT_OK(Submit(scheduler, "wait", &timed_out_wait));
+  Request wait;
+  wait.arg_value = 1;
+  IREE_ASSERT_OK(Submit(scheduler, "wait", &wait));
+  Request yield;
+  IREE_ASSERT_OK(Submit(scheduler, "yield", &yield));
+  iree_event_set(&module_.block_event);
+  while (timed_out_wait.status_code == IREE_STATUS_UNKNOWN) {
+    std::this_thread::yield();
+  }
+  iree_event_set(&module_.wait_event);
+  IREE_ASSERT_OK(
+      iree_vm_async_scheduler_wait_idle(scheduler, iree_infinite_timeout()));
+
+  EXPECT_EQ(block.status_code, IREE_STATUS_OK);
+  EXPECT_EQ(fail.status_code, IREE_STATUS_DATA_LOSS);
+  EXPECT_EQ(timed_out_wait.status_code, IREE_STATUS_DEADLINE_EXCEEDED);
+  EXPECT_EQ(wait.status_code, IREE_STATUS_OK);
+  EXPECT_EQ(wait.ret_value, 2);
+  EXPECT_EQ(yield.status_code, IREE_STATUS_OK);
+
+  // The scheduler keeps accepting work after failures.
+  Request later_fail;
+  IREE_ASSERT_OK(Submit(scheduler, "fail", &later_fail));
+  Request later_yield;
+  later_yield.arg_value = 7;
+  IREE_ASSERT_OK(Submit(scheduler, "yield", &later_yield));
+  IREE_ASSERT_OK(
+      iree_vm_async_scheduler_wait_idle(scheduler, iree_infinite_timeout()));
+  EXPECT_EQ(later_fail.status_code, IREE_STATUS_DATA_LOSS);
+  EXPECT_EQ(later_yield.status_code, IREE_STATUS_OK);
+  EXPECT_EQ(later_yield.ret_value, 7);
+
+  iree_vm_async_scheduler_release(scheduler);
+}
+
+// Many more bytecode invocations than the in-flight cap all complete and the
+// cap is respected while they are interleaved across yields.
+// See iree/vm/test/async_ops.mlir > @yield_sequence
+TEST_F(VMAsyncSchedulerTest, BytecodeYieldSequenceMany) {
+  iree_vm_function_t function;
+  IREE_ASSERT_OK(iree_vm_module_lookup_function_by_name(
+      bytecode_module_, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+      IREE_SV("yield_sequence"), &function));
+  const iree_host_size_t max_in_flight = 8;
+  iree_vm_async_scheduler_t* scheduler =
+      CreateScheduler(/*worker_count=*/2, max_in_flight);
+
+  std::vector<Request> requests(256);
+  for (size_t i = 0; i < requests.size(); ++i) {
+    requests[i].arg_value = static_cast<int32_t>(i);
+    IREE_ASSERT_OK(Submit(scheduler, function, &requests[i]));
+  }
+  IREE_ASSERT_OK(
+      iree_vm_async_scheduler_wait_idle(scheduler, iree_infinite_timeout()));
+
+  for (auto& request : requests) {
+    EXPECT_EQ(request.status_code, IREE_STATUS_OK);
+    EXPECT_EQ(request.ret_value, request.arg_value + 3);
+  }
+
+  iree_vm_async_scheduler_statistics_t statistics;
+  iree_vm_async_scheduler_query_statistics(scheduler, &statistics);
+  EXPECT_EQ(statistics.pending_count, 0);
+  EXPECT_EQ(statistics.in_flight_count, 0);
+  EXPECT_LE(statistics.peak_in_flight_count, max_in_flight);
+  EXPECT_EQ(statistics.completed_count, requests.size());
+
+  iree_vm_async_scheduler_release(scheduler);
+}
+
+// Dropping the last reference from within a completion callback must not
+// deadlock the worker; the scheduler is destroyed once all work completes.
+TEST_F(VMAsyncSchedulerTest, ReleaseFromCallback) {
+  live_allocation_count = 0;
+  iree_allocator_t host_allocator = {NULL, TrackingAllocatorCtl};
+  iree_vm_async_scheduler_t* scheduler = CreateScheduler(
+      /*worker_count=*/2, /*max_in_flight=*/16, host_allocator);
+
+  // Each request holds a reference to the scheduler until its callback. Both
+  // workers are held so that no request can complete until after the caller
+  // has released its own reference.
+  std::vector<Request> blocks(2);
+  for (auto& block : blocks) {
+    IREE_ASSERT_OK(Submit(scheduler, "block", &block));
+  }
+  std::vector<Request> yields(8);
+  for (size_t i = 0; i < yields.size(); ++i) {
+    yields[i].arg_value = static_cast<int32_t>(i);
+    yields[i].scheduler = scheduler;
+    iree_vm_async_scheduler_retain(scheduler);
+    IREE_ASSERT_OK(Submit(scheduler, "yield", &yields[i]));
+  }
+  iree_vm_async_scheduler_release(scheduler);
+  iree_event_set(&module_.block_event);
+
+  for (auto& yield : yields) {
+    while (yield.status_code == IREE_STATUS_UNKNOWN) std::this_thread::yield();
+    EXPECT_EQ(yield.status_code, IREE_STATUS_OK);
+  }
+  while (live_allocation_count > 0) std::this_thread::yield();
+}
+
+}  // namespace
+}  // namespace iree
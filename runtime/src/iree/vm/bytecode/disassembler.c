@@ -1900,6 +1900,146 @@ iree_status_t iree_vm_bytecode_disassemble_op(
       break;
     }
 
+    //===------------------------------------------------------------------===//
+    // Fused ops
+    //===------------------------------------------------------------------===//
+
+#define DISASM_COND_BRANCH()                                                 \
+  int32_t true_block_pc = VM_ParseBranchTarget("true_dest");                 \
+  const iree_vm_register_remap_list_t* true_remap_list =                     \
+      VM_ParseBranchOperands("true_operands");                               \
+  int32_t false_block_pc = VM_ParseBranchTarget("false_dest");               \
+  const iree_vm_register_remap_list_t* false_remap_list =                    \
+      VM_ParseBranchOperands("false_operands");                              \
+  IREE_RETURN_IF_ERROR(                                                      \
+      iree_string_builder_append_format(b, ", ^%08X(", true_block_pc));      \
+  EMIT_REMAP_LIST(true_remap_list);                                          \
+  IREE_RETURN_IF_ERROR(                                                      \
+      iree_string_builder_append_format(b, "), ^%08X(", false_block_pc));    \
+  EMIT_REMAP_LIST(false_remap_list);                                         \
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ")"));
+
+#define DISASM_OP_CORE_COND_BRANCH_CMP_I32(op_name, op_mnemonic)       \
+  DISASM_OP(CORE, op_name) {                                           \
+    uint16_t lhs_reg = VM_ParseOperandRegI32("lhs");                   \
+    uint16_t rhs_reg = VM_ParseOperandRegI32("rhs");                   \
+    IREE_RETURN_IF_ERROR(                                              \
+        iree_string_builder_append_format(b, "%s ", op_mnemonic));     \
+    EMIT_I32_REG_NAME(lhs_reg);                                        \
+    EMIT_OPTIONAL_VALUE_I32(regs->i32[lhs_reg]);                       \
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ", ")); \
+    EMIT_I32_REG_NAME(rhs_reg);                                        \
+    EMIT_OPTIONAL_VALUE_I32(regs->i32[rhs_reg]);                       \
+    DISASM_COND_BRANCH();                                              \
+    break;                                                             \
+  }
+
+#define DISASM_OP_CORE_COND_BRANCH_CMP_I64(op_name, op_mnemonic)       \
+  DISASM_OP(CORE, op_name) {                                           \
+    uint16_t lhs_reg = VM_ParseOperandRegI64("lhs");                   \
+    uint16_t rhs_reg = VM_ParseOperandRegI64("rhs");                   \
+    IREE_RETURN_IF_ERROR(                                              \
+        iree_string_builder_append_format(b, "%s ", op_mnemonic));     \
+    EMIT_I64_REG_NAME(lhs_reg);                                        \
+    EMIT_OPTIONAL_VALUE_I64(regs->i32[lhs_reg]);                       \
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ", ")); \
+    EMIT_I64_REG_NAME(rhs_reg);                                        \
+    EMIT_OPTIONAL_VALUE_I64(regs->i32[rhs_reg]);                       \
+    DISASM_COND_BRANCH();                                              \
+    break;                                                             \
+  }
+
+    DISASM_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpEQI32,
+                                       "vm.cond_br.cmp.eq.i32");
+    DISASM_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpNEI32,
+                                       "vm.cond_br.cmp.ne.i32");
+    DISASM_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpLTI32S,
+                                       "vm.cond_br.cmp.lt.i32.s");
+    DISASM_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpLTI32U,
+                                       "vm.cond_br.cmp.lt.i32.u");
+    DISASM_OP_CORE_COND_BRANCH_CMP_I64(CondBranchCmpEQI64,
+                                       "vm.cond_br.cmp.eq.i64");
+    DISASM_OP_CORE_COND_BRANCH_CMP_I64(CondBranchCmpNEI64,
+                                       "vm.cond_br.cmp.ne.i64");
+    DISASM_OP_CORE_COND_BRANCH_CMP_I64(CondBranchCmpLTI64S,
+                                       "vm.cond_br.cmp.lt.i64.s");
+    DISASM_OP_CORE_COND_BRANCH_CMP_I64(CondBranchCmpLTI64U,
+                                       "vm.cond_br.cmp.lt.i64.u");
+
+#define DISASM_OP_CORE_ADD_CMP_I32(op_name, op_mnemonic)               \
+  DISASM_OP(CORE, op_name) {                                           \
+    uint16_t lhs_reg = VM_ParseOperandRegI32("lhs");                   \
+    uint16_t rhs_reg = VM_ParseOperandRegI32("rhs");                   \
+    uint16_t bound_reg = VM_ParseOperandRegI32("bound");               \
+    uint16_t sum_reg = VM_ParseResultRegI32("sum");                    \
+    uint16_t result_reg = VM_ParseResultRegI32("result");              \
+    EMIT_I32_REG_NAME(sum_reg);                                        \
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ", ")); \
+    EMIT_I32_REG_NAME(result_reg);                                     \
+    IREE_RETURN_IF_ERROR(                                              \
+        iree_string_builder_append_format(b, " = %s ", op_mnemonic));  \
+    EMIT_I32_REG_NAME(lhs_reg);                                        \
+    EMIT_OPTIONAL_VALUE_I32(regs->i32[lhs_reg]);                       \
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ", ")); \
+    EMIT_I32_REG_NAME(rhs_reg);                                        \
+    EMIT_OPTIONAL_VALUE_I32(regs->i32[rhs_reg]);                       \
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ", ")); \
+    EMIT_I32_REG_NAME(bound_reg);                                      \
+    EMIT_OPTIONAL_VALUE_I32(regs->i32[bound_reg]);                     \
+    break;                                                             \
+  }
+
+#define DISASM_OP_CORE_ADD_CMP_I64(op_name, op_mnemonic)               \
+  DISASM_OP(CORE, op_name) {                                           \
+    uint16_t lhs_reg = VM_ParseOperandRegI64("lhs");                   \
+    uint16_t rhs_reg = VM_ParseOperandRegI64("rhs");                   \
+    uint16_t bound_reg = VM_ParseOperandRegI64("bound");               \
+    uint16_t sum_reg = VM_ParseResultRegI64("sum");                    \
+    uint16_t result_reg = VM_ParseResultRegI32("result");              \
+    EMIT_I64_REG_NAME(sum_reg);                                        \
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ", ")); \
+    EMIT_I32_REG_NAME(result_reg);                                     \
+    IREE_RETURN_IF_ERROR(                                              \
+        iree_string_builder_append_format(b, " = %s ", op_mnemonic));  \
+    EMIT_I64_REG_NAME(lhs_reg);                                        \
+    EMIT_OPTIONAL_VALUE_I64(regs->i32[lhs_reg]);                       \
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ", ")); \
+    EMIT_I64_REG_NAME(rhs_reg);                                        \
+    EMIT_OPTIONAL_VALUE_I64(regs->i32[rhs_reg]);                       \
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ", ")); \
+    EMIT_I64_REG_NAME(bound_reg);                                      \
+    EMIT_OPTIONAL_VALUE_I64(regs->i32[bound_reg]);                     \
+    break;                                                             \
+  }
+
+    DISASM_OP_CORE_ADD_CMP_I32(AddCmpEQI32, "vm.add.cmp.eq.i32");
+    DISASM_OP_CORE_ADD_CMP_I32(AddCmpNEI32, "vm.add.cmp.ne.i32");
+    DISASM_OP_CORE_ADD_CMP_I32(AddCmpLTI32S, "vm.add.cmp.lt.i32.s");
+    DISASM_OP_CORE_ADD_CMP_I32(AddCmpLTI32U, "vm.add.cmp.lt.i32.u");
+    DISASM_OP_CORE_ADD_CMP_I64(AddCmpEQI64, "vm.add.cmp.eq.i64");
+    DISASM_OP_CORE_ADD_CMP_I64(AddCmpNEI64, "vm.add.cmp.ne.i64");
+    DISASM_OP_CORE_ADD_CMP_I64(AddCmpLTI64S, "vm.add.cmp.lt.i64.s");
+    DISASM_OP_CORE_ADD_CMP_I64(AddCmpLTI64U, "vm.add.cmp.lt.i64.u");
+
+    DISASM_OP(CORE, ListGetRefCast) {
+      bool list_is_move;
+      uint16_t list_reg = VM_ParseOperandRegRef("list", &list_is_move);
+      uint16_t index_reg = VM_ParseOperandRegI32("index");
+      const iree_vm_type_def_t type_def = VM_ParseTypeOf("result");
+      bool result_is_move;
+      uint16_t result_reg = VM_ParseResultRegRef("result", &result_is_move);
+      EMIT_REF_REG_NAME(result_reg);
+      IREE_RETURN_IF_ERROR(
+          iree_string_builder_append_cstring(b, " = vm.list.get.ref.cast "));
+      EMIT_REF_REG_NAME(list_reg);
+      EMIT_OPTIONAL_VALUE_REF(&regs->ref[list_reg]);
+      IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(b, ", "));
+      EMIT_I32_REG_NAME(index_reg);
+      EMIT_OPTIONAL_VALUE_I32(regs->i32[index_reg]);
+      EMIT_TYPE_NAME(type_def);
+      break;
+    }
+
     //===------------------------------------------------------------------===//
     // Extension trampolines
     //===------------------------------------------------------------------===//
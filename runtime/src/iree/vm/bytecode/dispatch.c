@@ -1871,6 +1871,112 @@ static iree_status_t iree_vm_bytecode_dispatch(
       pc = block_pc + IREE_VM_BLOCK_MARKER_SIZE;  // skip block marker
     });
 
+    //===------------------------------------------------------------------===//
+    // Fused ops
+    //===------------------------------------------------------------------===//
+
+#define DISPATCH_COND_BRANCH(condition)                                      \
+  int32_t true_block_pc = VM_DecBranchTarget("true_dest");                   \
+  const iree_vm_register_remap_list_t* true_remap_list =                     \
+      VM_DecBranchOperands("true_operands");                                 \
+  int32_t false_block_pc = VM_DecBranchTarget("false_dest");                 \
+  const iree_vm_register_remap_list_t* false_remap_list =                    \
+      VM_DecBranchOperands("false_operands");                                \
+  if (condition) {                                                           \
+    pc = true_block_pc + IREE_VM_BLOCK_MARKER_SIZE; /* skip block marker */  \
+    if (IREE_UNLIKELY(true_remap_list->size > 0)) {                          \
+      iree_vm_bytecode_dispatch_remap_branch_registers(regs_i32, regs_ref,   \
+                                                       true_remap_list);     \
+    }                                                                        \
+  } else {                                                                   \
+    pc = false_block_pc + IREE_VM_BLOCK_MARKER_SIZE; /* skip block marker */ \
+    if (IREE_UNLIKELY(false_remap_list->size > 0)) {                         \
+      iree_vm_bytecode_dispatch_remap_branch_registers(regs_i32, regs_ref,   \
+                                                       false_remap_list);    \
+    }                                                                        \
+  }
+
+#define DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(op_name, op_func) \
+  DISPATCH_OP(CORE, op_name, {                                 \
+    int32_t lhs = VM_DecOperandRegI32("lhs");                  \
+    int32_t rhs = VM_DecOperandRegI32("rhs");                  \
+    DISPATCH_COND_BRANCH(op_func(lhs, rhs));                   \
+  });
+
+#define DISPATCH_OP_CORE_COND_BRANCH_CMP_I64(op_name, op_func) \
+  DISPATCH_OP(CORE, op_name, {                                 \
+    int64_t lhs = VM_DecOperandRegI64("lhs");                  \
+    int64_t rhs = VM_DecOperandRegI64("rhs");                  \
+    DISPATCH_COND_BRANCH(op_func(lhs, rhs));                   \
+  });
+
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpEQI32, vm_cmp_eq_i32);
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpNEI32, vm_cmp_ne_i32);
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpLTI32S, vm_cmp_lt_i32s);
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpLTI32U, vm_cmp_lt_i32u);
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I64(CondBranchCmpEQI64, vm_cmp_eq_i64);
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I64(CondBranchCmpNEI64, vm_cmp_ne_i64);
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I64(CondBranchCmpLTI64S, vm_cmp_lt_i64s);
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I64(CondBranchCmpLTI64U, vm_cmp_lt_i64u);
+
+    // NOTE: all operands are read before any results are written as the
+    // register allocator may reuse an operand register for a result.
+#define DISPATCH_OP_CORE_ADD_CMP_I32(op_name, op_func) \
+  DISPATCH_OP(CORE, op_name, {                         \
+    int32_t lhs = VM_DecOperandRegI32("lhs");          \
+    int32_t rhs = VM_DecOperandRegI32("rhs");          \
+    int32_t bound = VM_DecOperandRegI32("bound");      \
+    int32_t* sum = VM_DecResultRegI32("sum");          \
+    int32_t* result = VM_DecResultRegI32("result");    \
+    int32_t sum_value = vm_add_i32(lhs, rhs);          \
+    *sum = sum_value;                                  \
+    *result = op_func(sum_value, bound);               \
+  });
+
+#define DISPATCH_OP_CORE_ADD_CMP_I64(op_name, op_func) \
+  DISPATCH_OP(CORE, op_name, {                         \
+    int64_t lhs = VM_DecOperandRegI64("lhs");          \
+    int64_t rhs = VM_DecOperandRegI64("rhs");          \
+    int64_t bound = VM_DecOperandRegI64("bound");      \
+    int64_t* sum = VM_DecResultRegI64("sum");          \
+    int32_t* result = VM_DecResultRegI32("result");    \
+    int64_t sum_value = vm_add_i64(lhs, rhs);          \
+    *sum = sum_value;                                  \
+    *result = op_func(sum_value, bound);               \
+  });
+
+    DISPATCH_OP_CORE_ADD_CMP_I32(AddCmpEQI32, vm_cmp_eq_i32);
+    DISPATCH_OP_CORE_ADD_CMP_I32(AddCmpNEI32, vm_cmp_ne_i32);
+    DISPATCH_OP_CORE_ADD_CMP_I32(AddCmpLTI32S, vm_cmp_lt_i32s);
+    DISPATCH_OP_CORE_ADD_CMP_I32(AddCmpLTI32U, vm_cmp_lt_i32u);
+    DISPATCH_OP_CORE_ADD_CMP_I64(AddCmpEQI64, vm_cmp_eq_i64);
+    DISPATCH_OP_CORE_ADD_CMP_I64(AddCmpNEI64, vm_cmp_ne_i64);
+    DISPATCH_OP_CORE_ADD_CMP_I64(AddCmpLTI64S, vm_cmp_lt_i64s);
+    DISPATCH_OP_CORE_ADD_CMP_I64(AddCmpLTI64U, vm_cmp_lt_i64u);
+
+    DISPATCH_OP(CORE, ListGetRefCast, {
+      bool list_is_move;
+      iree_vm_ref_t* list_ref = VM_DecOperandRegRef("list", &list_is_move);
+      iree_vm_list_t* list = iree_vm_list_deref(*list_ref);
+      if (IREE_UNLIKELY(!list)) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT, "list is null");
+      }
+      uint32_t index = VM_DecOperandRegI32("index");
+      const iree_vm_type_def_t type_def = VM_DecTypeOf("result");
+      bool result_is_move;
+      iree_vm_ref_t* result = VM_DecResultRegRef("result", &result_is_move);
+      IREE_RETURN_IF_ERROR(iree_vm_list_get_ref_retain(list, index, result));
+      const iree_vm_ref_type_t ref_type = iree_vm_type_def_as_ref(type_def);
+      if (IREE_UNLIKELY(result->type != IREE_VM_REF_TYPE_NULL &&
+                        result->type != ref_type &&
+                        ref_type != IREE_VM_REF_TYPE_ANY)) {
+        // Type mismatch; unlike ListGetRef this is an error as with CastAnyRef.
+        iree_vm_ref_release(result);
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "source ref type mismatch");
+      }
+    });
+
     //===------------------------------------------------------------------===//
     // Extension trampolines
     //===------------------------------------------------------------------===//
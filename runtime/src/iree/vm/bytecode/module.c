@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "iree/base/internal/hash.h"
 #include "iree/vm/bytecode/archive.h"
 #include "iree/vm/bytecode/module_impl.h"
 #include "iree/vm/bytecode/verifier.h"
@@ -853,11 +854,85 @@ static iree_status_t iree_vm_bytecode_module_resume_call(
   return iree_vm_bytecode_dispatch_resume(stack, module, call_results);  // tail
 }
 
+//===----------------------------------------------------------------------===//
+// Verification cache
+//===----------------------------------------------------------------------===//
+
+// Bumped whenever verification changes such that modules attested by prior
+// versions of the runtime may no longer pass.
+#define IREE_VM_BYTECODE_VERIFIER_VERSION 1
+
+// Hashes everything verification inspects: the FlatBuffer (including embedded
+// rodata and bytecode) and the bounds of the external rodata. The contents of
+// external rodata are not verified and are excluded so that large parameters
+// stored in the archive do not need to be hashed. A cryptographic digest is
+// used as a cache hit skips verification: a crafted module must not be able
+// to collide with one that has been verified.
+static void iree_vm_bytecode_module_hash_contents(
+    iree_const_byte_span_t archive_contents,
+    iree_const_byte_span_t flatbuffer_contents,
+    iree_host_size_t archive_rodata_offset,
+    iree_vm_bytecode_module_hash_t* out_hash) {
+  const uint64_t header[5] = {
+      IREE_VM_BYTECODE_VERIFIER_VERSION,
+      IREE_VM_BYTECODE_VERSION_MAJOR,
+      IREE_VM_BYTECODE_VERSION_MINOR,
+      archive_rodata_offset,
+      archive_contents.data_length,
+  };
+  static_assert(sizeof(out_hash->value) == IREE_HASH_SHA256_DIGEST_SIZE,
+                "module hash must hold a SHA-256 digest");
+  iree_hash_sha256_t hasher;
+  iree_hash_sha256_initialize(&hasher);
+  iree_hash_sha256_update(&hasher,
+                          iree_make_const_byte_span(header, sizeof(header)));
+  iree_hash_sha256_update(&hasher, flatbuffer_contents);
+  iree_hash_sha256_finalize(&hasher, out_hash->value);
+}
+
+IREE_API_EXPORT void iree_vm_bytecode_module_options_initialize(
+    iree_vm_bytecode_module_options_t* out_options) {
+  IREE_ASSERT_ARGUMENT(out_options);
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->verification_cache = iree_vm_bytecode_verification_cache_null();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_hash(
+    iree_const_byte_span_t archive_contents,
+    iree_vm_bytecode_module_hash_t* out_hash) {
+  IREE_ASSERT_ARGUMENT(out_hash);
+  memset(out_hash, 0, sizeof(*out_hash));
+  iree_const_byte_span_t flatbuffer_contents = iree_const_byte_span_empty();
+  iree_host_size_t archive_rodata_offset = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_archive_parse_header(
+      archive_contents, &flatbuffer_contents, &archive_rodata_offset));
+  iree_vm_bytecode_module_hash_contents(archive_contents, flatbuffer_contents,
+                                        archive_rodata_offset, out_hash);
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Module creation
+//===----------------------------------------------------------------------===//
+
 IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     iree_vm_instance_t* instance, iree_const_byte_span_t archive_contents,
     iree_allocator_t archive_allocator, iree_allocator_t allocator,
     iree_vm_module_t** out_module) {
+  iree_vm_bytecode_module_options_t options;
+  iree_vm_bytecode_module_options_initialize(&options);
+  return iree_vm_bytecode_module_create_with_options(
+      instance, &options, archive_contents, archive_allocator, allocator,
+      out_module);
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create_with_options(
+    iree_vm_instance_t* instance,
+    const iree_vm_bytecode_module_options_t* options,
+    iree_const_byte_span_t archive_contents, iree_allocator_t archive_allocator,
+    iree_allocator_t allocator, iree_vm_module_t** out_module) {
   IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(options);
   IREE_ASSERT_ARGUMENT(out_module);
   *out_module = NULL;
 
@@ -868,15 +943,36 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
       z0, iree_vm_bytecode_archive_parse_header(
               archive_contents, &flatbuffer_contents, &archive_rodata_offset));
 
-  IREE_TRACE_ZONE_BEGIN_NAMED(z1, "iree_vm_bytecode_module_flatbuffer_verify");
-  iree_status_t status = iree_vm_bytecode_module_flatbuffer_verify(
-      archive_contents, flatbuffer_contents, archive_rodata_offset);
-  if (!iree_status_is_ok(status)) {
+  // Skip verification of modules that have previously passed it. When the
+  // verifier is compiled out nothing is attested as modules are only partially
+  // verified.
+  const iree_vm_bytecode_verification_cache_t* verification_cache =
+      &options->verification_cache;
+  iree_vm_bytecode_module_hash_t hash;
+  memset(&hash, 0, sizeof(hash));
+  bool use_verification_cache = false;
+  bool is_verified = false;
+#if IREE_VM_BYTECODE_VERIFICATION_ENABLE
+  use_verification_cache = verification_cache->lookup != NULL;
+#endif  // IREE_VM_BYTECODE_VERIFICATION_ENABLE
+  if (use_verification_cache) {
+    IREE_TRACE_ZONE_BEGIN_NAMED(z1, "iree_vm_bytecode_module_hash");
+    IREE_TRACE_ZONE_APPEND_VALUE_I64(z1, flatbuffer_contents.data_length);
+    iree_vm_bytecode_module_hash_contents(archive_contents, flatbuffer_contents,
+                                          archive_rodata_offset, &hash);
+    is_verified = verification_cache->lookup(verification_cache->self, hash);
     IREE_TRACE_ZONE_END(z1);
-    IREE_TRACE_ZONE_END(z0);
-    return status;
   }
-  IREE_TRACE_ZONE_END(z1);
+  if (is_verified) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "verification skipped");
+  } else {
+    IREE_TRACE_ZONE_BEGIN_NAMED(z1,
+                                "iree_vm_bytecode_module_flatbuffer_verify");
+    iree_status_t status = iree_vm_bytecode_module_flatbuffer_verify(
+        archive_contents, flatbuffer_contents, archive_rodata_offset);
+    IREE_TRACE_ZONE_END(z1);
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(z0, status);
+  }
 
   iree_vm_BytecodeModuleDef_table_t module_def =
       iree_vm_BytecodeModuleDef_as_root(flatbuffer_contents.data);
@@ -985,7 +1081,8 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
   // need to do so.
   iree_status_t verify_status = iree_ok_status();
 #if IREE_VM_BYTECODE_VERIFICATION_ENABLE
-  for (uint16_t i = 0; i < module->function_descriptor_count; ++i) {
+  for (uint16_t i = 0; i < module->function_descriptor_count && !is_verified;
+       ++i) {
     IREE_TRACE_ZONE_BEGIN_NAMED(z1, "iree_vm_bytecode_function_verify");
     verify_status = iree_vm_bytecode_function_verify(module, i, allocator);
     IREE_TRACE_ZONE_END(z1);
@@ -993,6 +1090,9 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
   }
 #endif  // IREE_VM_BYTECODE_VERIFICATION_ENABLE
   if (iree_status_is_ok(verify_status)) {
+    if (use_verification_cache && !is_verified && verification_cache->insert) {
+      verification_cache->insert(verification_cache->self, hash);
+    }
     *out_module = &module->interface;
   } else {
     iree_allocator_free(allocator, module);
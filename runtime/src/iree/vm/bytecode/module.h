@@ -14,6 +14,56 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Identifies the contents of a bytecode module archive that are verified when
+// the module is loaded along with the version of the verifier.
+// This is a SHA-256 digest such that producing a module matching the hash of
+// another module is infeasible.
+typedef struct iree_vm_bytecode_module_hash_t {
+  uint8_t value[32];
+} iree_vm_bytecode_module_hash_t;
+
+// Records modules that previously passed verification so that loading them
+// again can skip it. Verifying large modules can be a significant part of their
+// load time and hashing is much cheaper.
+//
+// Attestations are trusted: a module whose hash is found is used without any
+// verification and malformed modules can corrupt memory. Only back the cache
+// with storage that cannot be written by the producers of untrusted modules.
+typedef struct iree_vm_bytecode_verification_cache_t {
+  // User-defined pointer passed to all functions.
+  void* self;
+  // Returns true if a module with |hash| previously passed verification.
+  bool(IREE_API_PTR* lookup)(void* self, iree_vm_bytecode_module_hash_t hash);
+  // Records that a module with |hash| passed verification. Failures to record
+  // are ignored and the module will be verified again on its next load.
+  void(IREE_API_PTR* insert)(void* self, iree_vm_bytecode_module_hash_t hash);
+} iree_vm_bytecode_verification_cache_t;
+
+// Returns a verification cache that never skips verification.
+static inline iree_vm_bytecode_verification_cache_t
+iree_vm_bytecode_verification_cache_null(void) {
+  iree_vm_bytecode_verification_cache_t cache = {NULL, NULL, NULL};
+  return cache;
+}
+
+// Options controlling bytecode module creation.
+typedef struct iree_vm_bytecode_module_options_t {
+  // Cache of modules that previously passed verification. Has no effect when
+  // verification is disabled in the build.
+  iree_vm_bytecode_verification_cache_t verification_cache;
+} iree_vm_bytecode_module_options_t;
+
+// Initializes |out_options| to the default values used by
+// iree_vm_bytecode_module_create.
+IREE_API_EXPORT void iree_vm_bytecode_module_options_initialize(
+    iree_vm_bytecode_module_options_t* out_options);
+
+// Computes the hash identifying the verified contents of |archive_contents| as
+// used to key the verification cache.
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_hash(
+    iree_const_byte_span_t archive_contents,
+    iree_vm_bytecode_module_hash_t* out_hash);
+
 // Creates a VM module from an in-memory ModuleDef FlatBuffer archive.
 // If a |archive_allocator| is provided then it will be used to free the
 // |archive_contents| when the module is destroyed and otherwise the ownership
@@ -23,6 +73,14 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     iree_allocator_t archive_allocator, iree_allocator_t allocator,
     iree_vm_module_t** out_module);
 
+// Creates a VM module from an in-memory ModuleDef FlatBuffer archive as with
+// iree_vm_bytecode_module_create using the given |options|.
+IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create_with_options(
+    iree_vm_instance_t* instance,
+    const iree_vm_bytecode_module_options_t* options,
+    iree_const_byte_span_t archive_contents, iree_allocator_t archive_allocator,
+    iree_allocator_t allocator, iree_vm_module_t** out_module);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -5,6 +5,7 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
 #include <array>
+#include <utility>
 #include <vector>
 
 #include "iree/base/api.h"
@@ -12,6 +13,7 @@
 #include "iree/vm/api.h"
 #include "iree/vm/bytecode/module.h"
 #include "iree/vm/bytecode/module_benchmark_module_c.h"
+#include "iree/vm/bytecode/module_benchmark_module_unfused_c.h"
 
 namespace {
 
@@ -70,11 +72,12 @@ static iree_status_t native_import_module_create(
                                       instance, allocator, out_module);
 }
 
-// Benchmarks the given exported function, optionally passing in arguments.
-static iree_status_t RunFunction(iree_benchmark_state_t* benchmark_state,
-                                 iree_string_view_t function_name,
-                                 std::vector<int32_t> i32_args,
-                                 int result_count, int64_t batch_size = 1) {
+// Benchmarks the given exported function from |module_file_toc|, optionally
+// passing in arguments.
+static iree_status_t RunFunctionInModule(
+    iree_benchmark_state_t* benchmark_state,
+    const iree_file_toc_t* module_file_toc, iree_string_view_t function_name,
+    std::vector<int32_t> i32_args, int result_count, int64_t batch_size = 1) {
   iree_vm_instance_t* instance = NULL;
   IREE_CHECK_OK(iree_vm_instance_create(IREE_VM_TYPE_CAPACITY_DEFAULT,
                                         iree_allocator_system(), &instance));
@@ -83,8 +86,6 @@ static iree_status_t RunFunction(iree_benchmark_state_t* benchmark_state,
   IREE_CHECK_OK(native_import_module_create(instance, iree_allocator_system(),
                                             &import_module));
 
-  const auto* module_file_toc =
-      iree_vm_bytecode_module_benchmark_module_create();
   iree_vm_module_t* bytecode_module = nullptr;
   IREE_CHECK_OK(iree_vm_bytecode_module_create(
       instance,
@@ -133,6 +134,31 @@ static iree_status_t RunFunction(iree_benchmark_state_t* benchmark_state,
   return iree_ok_status();
 }
 
+// Benchmarks the given exported function, optionally passing in arguments.
+static iree_status_t RunFunction(iree_benchmark_state_t* benchmark_state,
+                                 iree_string_view_t function_name,
+                                 std::vector<int32_t> i32_args,
+                                 int result_count, int64_t batch_size = 1) {
+  return RunFunctionInModule(benchmark_state,
+                             iree_vm_bytecode_module_benchmark_module_create(),
+                             function_name, std::move(i32_args), result_count,
+                             batch_size);
+}
+
+// Benchmarks the given exported function in the module compiled without
+// superinstruction fusion. Comparing against the RunFunction variant of the
+// same benchmark shows the effect of the fused opcodes on dispatch rate.
+static iree_status_t RunUnfusedFunction(iree_benchmark_state_t* benchmark_state,
+                                        iree_string_view_t function_name,
+                                        std::vector<int32_t> i32_args,
+                                        int result_count,
+                                        int64_t batch_size = 1) {
+  return RunFunctionInModule(
+      benchmark_state,
+      iree_vm_bytecode_module_benchmark_module_unfused_create(), function_name,
+      std::move(i32_args), result_count, batch_size);
+}
+
 IREE_BENCHMARK_FN(BM_ModuleCreate) {
   iree_vm_instance_t* instance = NULL;
   IREE_CHECK_OK(iree_vm_instance_create(IREE_VM_TYPE_CAPACITY_DEFAULT,
@@ -335,6 +361,16 @@ IREE_BENCHMARK_FN(BM_LoopSumBytecode) {
 }
 IREE_BENCHMARK_REGISTER(BM_LoopSumBytecode);
 
+IREE_BENCHMARK_FN(BM_LoopSumBytecodeUnfused) {
+  static const int batch = 100000;
+  return RunUnfusedFunction(
+      benchmark_state,
+      iree_make_cstring_view("bytecode_module_benchmark.loop_sum"), {batch},
+      /*result_count=*/1,
+      /*batch_size=*/batch);
+}
+IREE_BENCHMARK_REGISTER(BM_LoopSumBytecodeUnfused);
+
 IREE_BENCHMARK_FN(BM_BufferReduceReference) {
   static const int batch = 100000;
   static auto work = +[](int32_t* buffer, int i, int sum) {
@@ -374,6 +410,17 @@ IREE_BENCHMARK_FN(BM_BufferReduceBytecode) {
 }
 IREE_BENCHMARK_REGISTER(BM_BufferReduceBytecode);
 
+IREE_BENCHMARK_FN(BM_BufferReduceBytecodeUnfused) {
+  static const int batch = 100000;
+  return RunUnfusedFunction(
+      benchmark_state,
+      iree_make_cstring_view("bytecode_module_benchmark.buffer_reduce"),
+      {batch},
+      /*result_count=*/1,
+      /*batch_size=*/batch);
+}
+IREE_BENCHMARK_REGISTER(BM_BufferReduceBytecodeUnfused);
+
 // NOTE: unrolled 8x, requires %count to be % 8 = 0.
 IREE_BENCHMARK_FN(BM_BufferReduceBytecodeUnrolled) {
   static const int batch = 100000;
@@ -386,4 +433,38 @@ IREE_BENCHMARK_FN(BM_BufferReduceBytecodeUnrolled) {
 }
 IREE_BENCHMARK_REGISTER(BM_BufferReduceBytecodeUnrolled);
 
+IREE_BENCHMARK_FN(BM_BufferReduceBytecodeUnrolledUnfused) {
+  static const int batch = 100000;
+  return RunUnfusedFunction(
+      benchmark_state,
+      iree_make_cstring_view(
+          "bytecode_module_benchmark.buffer_reduce_unrolled"),
+      {batch},
+      /*result_count=*/1,
+      /*batch_size=*/batch);
+}
+IREE_BENCHMARK_REGISTER(BM_BufferReduceBytecodeUnrolledUnfused);
+
+IREE_BENCHMARK_FN(BM_ListGetCastBytecode) {
+  static const int batch = 100000;
+  return RunFunction(
+      benchmark_state,
+      iree_make_cstring_view("bytecode_module_benchmark.list_get_cast"),
+      {batch},
+      /*result_count=*/1,
+      /*batch_size=*/batch);
+}
+IREE_BENCHMARK_REGISTER(BM_ListGetCastBytecode);
+
+IREE_BENCHMARK_FN(BM_ListGetCastBytecodeUnfused) {
+  static const int batch = 100000;
+  return RunUnfusedFunction(
+      benchmark_state,
+      iree_make_cstring_view("bytecode_module_benchmark.list_get_cast"),
+      {batch},
+      /*result_count=*/1,
+      /*batch_size=*/batch);
+}
+IREE_BENCHMARK_REGISTER(BM_ListGetCastBytecodeUnfused);
+
 }  // namespace
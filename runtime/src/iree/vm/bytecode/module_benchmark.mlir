@@ -148,4 +148,30 @@ vm.module @bytecode_module_benchmark {
   ^loop_exit(%result : i32):
     vm.return %result : i32
   }
+
+  // Measures the cost of reading typed refs out of a variant list.
+  vm.export @list_get_cast
+  vm.func @list_get_cast(%count : i32) -> i32 {
+    %c0 = vm.const.i32.zero
+    %c1 = vm.const.i32 1
+    %c0_i64 = vm.const.i64.zero
+    %c4 = vm.const.i64 4
+    %alignment = vm.const.i32 16
+    %buf = vm.buffer.alloc %c4, %alignment : !vm.buffer
+    %list = vm.list.alloc %c1 : (i32) -> !vm.list<?>
+    vm.list.resize %list, %c1 : (!vm.list<?>, i32)
+    vm.list.set.ref %list, %c0, %buf : (!vm.list<?>, i32, !vm.buffer)
+    vm.br ^loop(%c0, %c0_i64 : i32, i64)
+  ^loop(%i : i32, %sum : i64):
+    %ref = vm.list.get.ref %list, %c0 : (!vm.list<?>, i32) -> !vm.ref<?>
+    %element = vm.cast.any.ref %ref : !vm.ref<?> -> !vm.buffer
+    %length = vm.buffer.length %element : !vm.buffer -> i64
+    %new_sum = vm.add.i64 %sum, %length : i64
+    %in = vm.add.i32 %i, %c1 : i32
+    %cmp = vm.cmp.lt.i32.s %in, %count : i32
+    vm.cond_br %cmp, ^loop(%in, %new_sum : i32, i64), ^loop_exit(%new_sum : i64)
+  ^loop_exit(%result : i64):
+    %result_i32 = vm.trunc.i64.i32 %result : i64 -> i32
+    vm.return %result_i32 : i32
+  }
 }
@@ -10,6 +10,7 @@
 
 #include "iree/vm/bytecode/module.h"
 
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -228,4 +229,116 @@ TEST_F(VMBytecodeModuleTest, FuncIO600) {
               IsOkAndHolds(Eq(MakeNullRefList(600))));
 }
 
+// Verification cache recording attested hashes in memory.
+struct TestVerificationCache {
+  std::vector<iree_vm_bytecode_module_hash_t> hashes;
+  int lookup_count = 0;
+
+  static bool Lookup(void* self, iree_vm_bytecode_module_hash_t hash) {
+    auto* cache = reinterpret_cast<TestVerificationCache*>(self);
+    ++cache->lookup_count;
+    for (const auto& entry : cache->hashes) {
+      if (memcmp(entry.value, hash.value, sizeof(hash.value)) == 0) return true;
+    }
+    return false;
+  }
+
+  static void Insert(void* self, iree_vm_bytecode_module_hash_t hash) {
+    reinterpret_cast<TestVerificationCache*>(self)->hashes.push_back(hash);
+  }
+
+  iree_vm_bytecode_verification_cache_t Get() {
+    return {this, TestVerificationCache::Lookup, TestVerificationCache::Insert};
+  }
+};
+
+TEST_F(VMBytecodeModuleTest, VerificationCache) {
+  const auto* module_file_toc = iree_vm_bytecode_module_test_module_create();
+  iree_const_byte_span_t contents = {
+      reinterpret_cast<const uint8_t*>(module_file_toc->data),
+      static_cast<iree_host_size_t>(module_file_toc->size)};
+
+  TestVerificationCache cache;
+  iree_vm_bytecode_module_options_t options;
+  iree_vm_bytecode_module_options_initialize(&options);
+  options.verification_cache = cache.Get();
+
+  // The first load verifies the module and records it; the second finds it.
+  for (int i = 0; i < 2; ++i) {
+    iree_vm_module_t* module = nullptr;
+    IREE_ASSERT_OK(iree_vm_bytecode_module_create_with_options(
+        instance_, &options, contents, iree_allocator_null(),
+        iree_allocator_system(), &module));
+    iree_vm_module_release(module);
+  }
+
+#if IREE_VM_BYTECODE_VERIFICATION_ENABLE
+  EXPECT_EQ(cache.lookup_count, 2);
+  ASSERT_EQ(cache.hashes.size(), 1u);
+  iree_vm_bytecode_module_hash_t hash;
+  IREE_ASSERT_OK(iree_vm_bytecode_module_hash(contents, &hash));
+  EXPECT_EQ(memcmp(cache.hashes[0].value, hash.value, sizeof(hash.value)), 0);
+#else
+  EXPECT_EQ(cache.lookup_count, 0);
+  EXPECT_TRUE(cache.hashes.empty());
+#endif  // IREE_VM_BYTECODE_VERIFICATION_ENABLE
+}
+
+#if IREE_VM_BYTECODE_VERIFICATION_ENABLE
+// Tests that modules differing from an attested one are verified again.
+TEST_F(VMBytecodeModuleTest, VerificationCacheModifiedModule) {
+  const auto* module_file_toc = iree_vm_bytecode_module_test_module_create();
+  std::vector<uint8_t> original(
+      reinterpret_cast<const uint8_t*>(module_file_toc->data),
+      reinterpret_cast<const uint8_t*>(module_file_toc->data) +
+          module_file_toc->size);
+
+  TestVerificationCache cache;
+  iree_vm_bytecode_module_options_t options;
+  iree_vm_bytecode_module_options_initialize(&options);
+  options.verification_cache = cache.Get();
+
+  // Attest the original module.
+  iree_vm_module_t* module = nullptr;
+  IREE_ASSERT_OK(iree_vm_bytecode_module_create_with_options(
+      instance_, &options,
+      iree_make_const_byte_span(original.data(), original.size()),
+      iree_allocator_null(), iree_allocator_system(), &module));
+  iree_vm_module_release(module);
+  ASSERT_EQ(cache.hashes.size(), 1u);
+
+  // A valid modification has a different digest and is verified and recorded.
+  std::vector<uint8_t> extended = original;
+  extended.resize(extended.size() + 16, 0);
+  iree_vm_bytecode_module_hash_t extended_hash;
+  IREE_ASSERT_OK(iree_vm_bytecode_module_hash(
+      iree_make_const_byte_span(extended.data(), extended.size()),
+      &extended_hash));
+  EXPECT_NE(memcmp(cache.hashes[0].value, extended_hash.value,
+                   sizeof(extended_hash.value)),
+            0);
+  IREE_ASSERT_OK(iree_vm_bytecode_module_create_with_options(
+      instance_, &options,
+      iree_make_const_byte_span(extended.data(), extended.size()),
+      iree_allocator_null(), iree_allocator_system(), &module));
+  iree_vm_module_release(module);
+  ASSERT_EQ(cache.hashes.size(), 2u);
+
+  // A corrupted module is verified (and rejected) instead of being skipped.
+  // The root table offset following the size prefix is pointed out of bounds.
+  std::vector<uint8_t> corrupted = original;
+  const uint32_t bad_root_offset = 0x7FFFFFF0u;
+  memcpy(corrupted.data() + sizeof(uint32_t), &bad_root_offset,
+         sizeof(bad_root_offset));
+  iree_status_t status = iree_vm_bytecode_module_create_with_options(
+      instance_, &options,
+      iree_make_const_byte_span(corrupted.data(), corrupted.size()),
+      iree_allocator_null(), iree_allocator_system(), &module);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_INVALID_ARGUMENT, status);
+  iree_status_free(status);
+  EXPECT_EQ(cache.hashes.size(), 2u);
+  EXPECT_EQ(cache.lookup_count, 3);
+}
+#endif  // IREE_VM_BYTECODE_VERIFICATION_ENABLE
+
 }  // namespace
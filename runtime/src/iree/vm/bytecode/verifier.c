@@ -1699,6 +1699,75 @@ static iree_status_t iree_vm_bytecode_function_verify_bytecode_op(
       verify_state->in_block = 0;  // terminator
     });
 
+    //===------------------------------------------------------------------===//
+    // Fused ops
+    //===------------------------------------------------------------------===//
+
+#define VERIFY_OP_CORE_COND_BRANCH_CMP_I32(op_name) \
+  VERIFY_OP(CORE, op_name, {                        \
+    VM_VerifyOperandRegI32(lhs);                    \
+    VM_VerifyOperandRegI32(rhs);                    \
+    VM_VerifyBranchTarget(true_dest_pc);            \
+    VM_VerifyBranchOperands(true_operands);         \
+    VM_VerifyBranchTarget(false_dest_pc);           \
+    VM_VerifyBranchOperands(false_operands);        \
+    verify_state->in_block = 0; /* terminator */    \
+  });
+
+#define VERIFY_OP_CORE_COND_BRANCH_CMP_I64(op_name) \
+  VERIFY_OP(CORE, op_name, {                        \
+    VM_VerifyOperandRegI64(lhs);                    \
+    VM_VerifyOperandRegI64(rhs);                    \
+    VM_VerifyBranchTarget(true_dest_pc);            \
+    VM_VerifyBranchOperands(true_operands);         \
+    VM_VerifyBranchTarget(false_dest_pc);           \
+    VM_VerifyBranchOperands(false_operands);        \
+    verify_state->in_block = 0; /* terminator */    \
+  });
+
+    VERIFY_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpEQI32);
+    VERIFY_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpNEI32);
+    VERIFY_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpLTI32S);
+    VERIFY_OP_CORE_COND_BRANCH_CMP_I32(CondBranchCmpLTI32U);
+    VERIFY_OP_CORE_COND_BRANCH_CMP_I64(CondBranchCmpEQI64);
+    VERIFY_OP_CORE_COND_BRANCH_CMP_I64(CondBranchCmpNEI64);
+    VERIFY_OP_CORE_COND_BRANCH_CMP_I64(CondBranchCmpLTI64S);
+    VERIFY_OP_CORE_COND_BRANCH_CMP_I64(CondBranchCmpLTI64U);
+
+#define VERIFY_OP_CORE_ADD_CMP_I32(op_name) \
+  VERIFY_OP(CORE, op_name, {                \
+    VM_VerifyOperandRegI32(lhs);            \
+    VM_VerifyOperandRegI32(rhs);            \
+    VM_VerifyOperandRegI32(bound);          \
+    VM_VerifyResultRegI32(sum);             \
+    VM_VerifyResultRegI32(result);          \
+  });
+
+#define VERIFY_OP_CORE_ADD_CMP_I64(op_name) \
+  VERIFY_OP(CORE, op_name, {                \
+    VM_VerifyOperandRegI64(lhs);            \
+    VM_VerifyOperandRegI64(rhs);            \
+    VM_VerifyOperandRegI64(bound);          \
+    VM_VerifyResultRegI64(sum);             \
+    VM_VerifyResultRegI32(result);          \
+  });
+
+    VERIFY_OP_CORE_ADD_CMP_I32(AddCmpEQI32);
+    VERIFY_OP_CORE_ADD_CMP_I32(AddCmpNEI32);
+    VERIFY_OP_CORE_ADD_CMP_I32(AddCmpLTI32S);
+    VERIFY_OP_CORE_ADD_CMP_I32(AddCmpLTI32U);
+    VERIFY_OP_CORE_ADD_CMP_I64(AddCmpEQI64);
+    VERIFY_OP_CORE_ADD_CMP_I64(AddCmpNEI64);
+    VERIFY_OP_CORE_ADD_CMP_I64(AddCmpLTI64S);
+    VERIFY_OP_CORE_ADD_CMP_I64(AddCmpLTI64U);
+
+    VERIFY_OP(CORE, ListGetRefCast, {
+      VM_VerifyOperandRegRef(list);
+      VM_VerifyOperandRegI32(index);
+      VM_VerifyTypeOf(type_def);
+      VM_VerifyResultRegRef(result);
+    });
+
     //===------------------------------------------------------------------===//
     // Extension trampolines
     //===------------------------------------------------------------------===//
@@ -468,6 +468,10 @@ IREE_API_EXPORT iree_status_t iree_vm_begin_invoke(
       iree_make_byte_span(state->stack_storage + reserved_storage_size,
                           sizeof(state->stack_storage) - reserved_storage_size),
       flags, iree_vm_context_state_resolver(context), host_allocator, &stack);
+  if (iree_status_is_ok(status) && policy && policy->stack_pool) {
+    status = iree_vm_stack_attach_pool(stack, policy->stack_pool);
+    if (!iree_status_is_ok(status)) iree_vm_stack_deinitialize(stack);
+  }
   if (!iree_status_is_ok(status)) {
     iree_vm_invoke_release_argument_storage(cconv_arguments, arguments,
                                             arguments_on_heap, host_allocator);
@@ -531,10 +535,15 @@ iree_vm_resume_invoke(iree_vm_invoke_state_t* state) {
   // return to the scheduler.
   do {
     if (iree_status_is_deferred(state->status)) {
-      // Wait required; top of the stack should be a wait frame.
-      IREE_ASSERT_EQ(iree_vm_stack_current_frame(state->stack)->type,
-                     IREE_VM_STACK_FRAME_WAIT);
-      return iree_status_from_code(IREE_STATUS_DEFERRED);
+      iree_vm_stack_frame_t* current_frame =
+          iree_vm_stack_current_frame(state->stack);
+      if (current_frame && current_frame->type == IREE_VM_STACK_FRAME_WAIT) {
+        // Wait required; the caller must perform it before resuming.
+        return iree_status_from_code(IREE_STATUS_DEFERRED);
+      }
+      // Cooperative yield without a wait; pick back up where we left off.
+      iree_status_ignore(state->status);
+      state->status = iree_ok_status();
     } else if (!iree_status_is_ok(state->status)) {
       // Invocation previously failed so return immediately. The user should
       // then call end() to get the result. By returning OK here we are telling
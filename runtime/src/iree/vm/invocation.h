@@ -14,13 +14,23 @@
 #include "iree/vm/list.h"
 #include "iree/vm/module.h"
 #include "iree/vm/ref.h"
+#include "iree/vm/stack.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 
 typedef struct iree_vm_invocation_t iree_vm_invocation_t;
-typedef struct iree_vm_invocation_policy_t iree_vm_invocation_policy_t;
+
+// Policy controlling how invocations are executed.
+// Zero-initialized policies have the default behavior.
+typedef struct iree_vm_invocation_policy_t {
+  // Optional pool that the invocation stack acquires grown storage from and
+  // returns it to upon completion. Invocations that routinely exceed the
+  // default inline stack storage should share a pool to avoid reallocating
+  // their stacks on every invocation.
+  iree_vm_stack_pool_t* stack_pool;
+} iree_vm_invocation_policy_t;
 
 //===----------------------------------------------------------------------===//
 // Synchronous invocation
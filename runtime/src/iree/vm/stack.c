@@ -12,6 +12,8 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/vm/module.h"
 
 //===----------------------------------------------------------------------===//
@@ -180,12 +182,227 @@ struct iree_vm_stack_t {
   // Allocator used for dynamic stack allocations. May be the null allocator
   // if growth is prohibited.
   iree_allocator_t allocator;
+
+  // Optional pool that owned frame storage is acquired from and returned to.
+  // When set the pool is used for growth instead of |allocator|.
+  iree_vm_stack_pool_t* pool;
+};
+
+//===----------------------------------------------------------------------===//
+// iree_vm_stack_pool_t
+//===----------------------------------------------------------------------===//
+
+struct iree_vm_stack_pool_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+
+  // Guards the retained storage list and statistics. Only held while updating
+  // the list; storage is allocated and freed outside of the lock.
+  iree_slim_mutex_t mutex;
+  iree_vm_stack_pool_statistics_t statistics IREE_GUARDED_BY(mutex);
+
+  // Unordered list of retained storage blocks; the first
+  // |statistics.retained_count| are valid.
+  iree_host_size_t max_retained_count;
+  iree_byte_span_t retained[];
 };
 
+IREE_API_EXPORT void iree_vm_stack_pool_options_initialize(
+    iree_vm_stack_pool_options_t* out_options) {
+  IREE_ASSERT_ARGUMENT(out_options);
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->max_retained_count =
+      IREE_VM_STACK_POOL_DEFAULT_MAX_RETAINED_COUNT;
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_stack_pool_create(
+    iree_vm_stack_pool_options_t options, iree_allocator_t host_allocator,
+    iree_vm_stack_pool_t** out_pool) {
+  IREE_ASSERT_ARGUMENT(out_pool);
+  *out_pool = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_stack_pool_t* pool = NULL;
+  iree_host_size_t total_size =
+      sizeof(*pool) + options.max_retained_count * sizeof(pool->retained[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&pool));
+  memset(pool, 0, sizeof(*pool));
+  iree_atomic_ref_count_init(&pool->ref_count);
+  pool->host_allocator = host_allocator;
+  iree_slim_mutex_initialize(&pool->mutex);
+  pool->max_retained_count = options.max_retained_count;
+
+  *out_pool = pool;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_vm_stack_pool_destroy(iree_vm_stack_pool_t* pool) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_vm_stack_pool_trim(pool);
+  iree_slim_mutex_deinitialize(&pool->mutex);
+  iree_allocator_free(pool->host_allocator, pool);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_vm_stack_pool_retain(iree_vm_stack_pool_t* pool) {
+  if (pool) iree_atomic_ref_count_inc(&pool->ref_count);
+}
+
+IREE_API_EXPORT void iree_vm_stack_pool_release(iree_vm_stack_pool_t* pool) {
+  if (pool && iree_atomic_ref_count_dec(&pool->ref_count) == 1) {
+    iree_vm_stack_pool_destroy(pool);
+  }
+}
+
+IREE_API_EXPORT void iree_vm_stack_pool_trim(iree_vm_stack_pool_t* pool) {
+  IREE_ASSERT_ARGUMENT(pool);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  for (;;) {
+    iree_byte_span_t storage = iree_make_byte_span(NULL, 0);
+    iree_slim_mutex_lock(&pool->mutex);
+    if (pool->statistics.retained_count > 0) {
+      storage = pool->retained[--pool->statistics.retained_count];
+      pool->statistics.retained_size -= storage.data_length;
+    }
+    iree_slim_mutex_unlock(&pool->mutex);
+    if (!storage.data) break;
+    iree_allocator_free(pool->host_allocator, storage.data);
+  }
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_vm_stack_pool_query_statistics(
+    iree_vm_stack_pool_t* pool,
+    iree_vm_stack_pool_statistics_t* out_statistics) {
+  IREE_ASSERT_ARGUMENT(pool);
+  IREE_ASSERT_ARGUMENT(out_statistics);
+  iree_slim_mutex_lock(&pool->mutex);
+  memcpy(out_statistics, &pool->statistics, sizeof(*out_statistics));
+  iree_slim_mutex_unlock(&pool->mutex);
+}
+
+// Removes and returns the retained storage at |index|.
+static iree_byte_span_t iree_vm_stack_pool_take_locked(
+    iree_vm_stack_pool_t* pool, iree_host_size_t index) {
+  iree_byte_span_t storage = pool->retained[index];
+  pool->retained[index] = pool->retained[--pool->statistics.retained_count];
+  pool->statistics.retained_size -= storage.data_length;
+  return storage;
+}
+
+// Acquires the largest retained storage if it is larger than
+// |current_capacity| for a stack being attached to the pool. Returns an empty
+// span if there is no suitable storage; no allocation is performed.
+static iree_byte_span_t iree_vm_stack_pool_acquire_for_attach(
+    iree_vm_stack_pool_t* pool, iree_host_size_t current_capacity) {
+  iree_byte_span_t storage = iree_make_byte_span(NULL, 0);
+  iree_slim_mutex_lock(&pool->mutex);
+  ++pool->statistics.attach_count;
+  iree_host_size_t best_index = IREE_HOST_SIZE_MAX;
+  iree_host_size_t best_length = current_capacity;
+  for (iree_host_size_t i = 0; i < pool->statistics.retained_count; ++i) {
+    if (pool->retained[i].data_length > best_length) {
+      best_index = i;
+      best_length = pool->retained[i].data_length;
+    }
+  }
+  if (best_index != IREE_HOST_SIZE_MAX) {
+    storage = iree_vm_stack_pool_take_locked(pool, best_index);
+    ++pool->statistics.reuse_count;
+  }
+  iree_slim_mutex_unlock(&pool->mutex);
+  return storage;
+}
+
+// Acquires storage of at least |minimum_capacity| for a growing stack.
+// The smallest suitable retained storage is used if available and otherwise
+// new storage is allocated.
+static iree_status_t iree_vm_stack_pool_acquire_for_growth(
+    iree_vm_stack_pool_t* pool, iree_host_size_t minimum_capacity,
+    iree_byte_span_t* out_storage) {
+  *out_storage = iree_make_byte_span(NULL, 0);
+  iree_slim_mutex_lock(&pool->mutex);
+  ++pool->statistics.growth_count;
+  iree_host_size_t best_index = IREE_HOST_SIZE_MAX;
+  iree_host_size_t best_length = IREE_HOST_SIZE_MAX;
+  for (iree_host_size_t i = 0; i < pool->statistics.retained_count; ++i) {
+    iree_host_size_t length = pool->retained[i].data_length;
+    if (length >= minimum_capacity && length < best_length) {
+      best_index = i;
+      best_length = length;
+    }
+  }
+  if (best_index != IREE_HOST_SIZE_MAX) {
+    *out_storage = iree_vm_stack_pool_take_locked(pool, best_index);
+  } else {
+    ++pool->statistics.allocation_count;
+  }
+  iree_host_size_t capacity =
+      out_storage->data ? out_storage->data_length : minimum_capacity;
+  pool->statistics.peak_capacity =
+      iree_max(pool->statistics.peak_capacity, capacity);
+  iree_slim_mutex_unlock(&pool->mutex);
+  if (out_storage->data) return iree_ok_status();
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE_I64(z0, minimum_capacity);
+  iree_status_t status = iree_allocator_malloc(
+      pool->host_allocator, minimum_capacity, (void**)&out_storage->data);
+  if (iree_status_is_ok(status)) {
+    out_storage->data_length = minimum_capacity;
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Returns |storage| to the pool for reuse. If the pool is full the smallest of
+// the retained storage and |storage| is freed.
+static void iree_vm_stack_pool_recycle(iree_vm_stack_pool_t* pool,
+                                       iree_byte_span_t storage) {
+  iree_slim_mutex_lock(&pool->mutex);
+  if (pool->statistics.retained_count < pool->max_retained_count) {
+    pool->retained[pool->statistics.retained_count++] = storage;
+    pool->statistics.retained_size += storage.data_length;
+    storage = iree_make_byte_span(NULL, 0);
+  } else if (pool->statistics.retained_count > 0) {
+    iree_host_size_t smallest_index = 0;
+    for (iree_host_size_t i = 1; i < pool->statistics.retained_count; ++i) {
+      if (pool->retained[i].data_length <
+          pool->retained[smallest_index].data_length) {
+        smallest_index = i;
+      }
+    }
+    iree_byte_span_t smallest = pool->retained[smallest_index];
+    if (smallest.data_length < storage.data_length) {
+      pool->retained[smallest_index] = storage;
+      pool->statistics.retained_size += storage.data_length;
+      pool->statistics.retained_size -= smallest.data_length;
+      storage = smallest;
+    }
+  }
+  iree_slim_mutex_unlock(&pool->mutex);
+  if (storage.data) iree_allocator_free(pool->host_allocator, storage.data);
+}
+
 //===----------------------------------------------------------------------===//
 // Stack implementation
 //===----------------------------------------------------------------------===//
 
+// Releases owned frame storage back to the pool or allocator it came from.
+static void iree_vm_stack_release_frame_storage(iree_vm_stack_t* stack) {
+  if (!stack->owns_frame_storage) return;
+  if (stack->pool) {
+    iree_vm_stack_pool_recycle(
+        stack->pool, iree_make_byte_span(stack->frame_storage,
+                                         stack->frame_storage_capacity));
+  } else {
+    iree_allocator_free(stack->allocator, stack->frame_storage);
+  }
+  stack->owns_frame_storage = false;
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_stack_initialize(
     iree_byte_span_t storage, iree_vm_invocation_flags_t flags,
     iree_vm_state_resolver_t state_resolver, iree_allocator_t allocator,
@@ -240,9 +457,9 @@ IREE_API_EXPORT void iree_vm_stack_deinitialize(iree_vm_stack_t* stack) {
   iree_vm_stack_reset(stack);
 
   // Drop allocated frame storage.
-  if (stack->owns_frame_storage) {
-    iree_allocator_free(stack->allocator, stack->frame_storage);
-  }
+  iree_vm_stack_release_frame_storage(stack);
+  iree_vm_stack_pool_release(stack->pool);
+  stack->pool = NULL;
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -281,6 +498,26 @@ IREE_API_EXPORT void iree_vm_stack_free(iree_vm_stack_t* stack) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+IREE_API_EXPORT iree_status_t iree_vm_stack_attach_pool(
+    iree_vm_stack_t* stack, iree_vm_stack_pool_t* pool) {
+  IREE_ASSERT_ARGUMENT(stack);
+  IREE_ASSERT_ARGUMENT(pool);
+  if (IREE_UNLIKELY(stack->top || stack->pool || stack->owns_frame_storage)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "pools can only be attached to fresh stacks");
+  }
+  stack->pool = pool;
+  iree_vm_stack_pool_retain(pool);
+  iree_byte_span_t storage = iree_vm_stack_pool_acquire_for_attach(
+      pool, stack->frame_storage_capacity);
+  if (storage.data) {
+    stack->frame_storage = storage.data;
+    stack->frame_storage_capacity = storage.data_length;
+    stack->owns_frame_storage = true;
+  }
+  return iree_ok_status();
+}
+
 IREE_API_EXPORT iree_allocator_t
 iree_vm_stack_allocator(const iree_vm_stack_t* stack) {
   return stack->allocator;
@@ -358,7 +595,19 @@ static iree_status_t iree_vm_stack_grow(iree_vm_stack_t* stack,
   void* old_storage = stack->frame_storage;
   void* new_storage = stack->frame_storage;
   iree_status_t status;
-  if (stack->owns_frame_storage) {
+  if (stack->pool) {
+    // Pooled storage is never reallocated in place; we take (possibly larger)
+    // storage from the pool and return the old storage to it.
+    iree_byte_span_t new_storage_span = iree_make_byte_span(NULL, 0);
+    status = iree_vm_stack_pool_acquire_for_growth(stack->pool, new_capacity,
+                                                   &new_storage_span);
+    if (iree_status_is_ok(status)) {
+      new_storage = new_storage_span.data;
+      new_capacity = new_storage_span.data_length;
+      memcpy(new_storage, old_storage, stack->frame_storage_size);
+      iree_vm_stack_release_frame_storage(stack);
+    }
+  } else if (stack->owns_frame_storage) {
     // We own the storage already likely from a previous growth operation.
     status =
         iree_allocator_realloc(stack->allocator, new_capacity, &new_storage);
@@ -161,6 +161,78 @@ typedef struct iree_vm_state_resolver_t {
       iree_vm_module_state_t** out_module_state);
 } iree_vm_state_resolver_t;
 
+//===----------------------------------------------------------------------===//
+// iree_vm_stack_pool_t
+//===----------------------------------------------------------------------===//
+
+// Default maximum number of storage blocks retained by a stack pool.
+#define IREE_VM_STACK_POOL_DEFAULT_MAX_RETAINED_COUNT 16
+
+// Options controlling stack pool behavior.
+typedef struct iree_vm_stack_pool_options_t {
+  // Maximum number of grown storage blocks retained for reuse. When exceeded
+  // the smallest blocks are freed in favor of larger ones.
+  iree_host_size_t max_retained_count;
+} iree_vm_stack_pool_options_t;
+
+// Initializes |out_options| to their default values.
+IREE_API_EXPORT void iree_vm_stack_pool_options_initialize(
+    iree_vm_stack_pool_options_t* out_options);
+
+// Cumulative stack pool statistics.
+typedef struct iree_vm_stack_pool_statistics_t {
+  // Total number of stacks attached to the pool.
+  uint64_t attach_count;
+  // Total number of attached stacks that started with retained storage.
+  uint64_t reuse_count;
+  // Total number of times an attached stack exhausted its storage and grew.
+  uint64_t growth_count;
+  // Total number of growth events that required a new heap allocation.
+  uint64_t allocation_count;
+  // Number of storage blocks currently retained for reuse.
+  iree_host_size_t retained_count;
+  // Total size, in bytes, of all storage blocks currently retained.
+  iree_host_size_t retained_size;
+  // Largest storage capacity, in bytes, provided to any stack.
+  iree_host_size_t peak_capacity;
+} iree_vm_stack_pool_statistics_t;
+
+// A pool of grown stack storage shared by stacks attached to it.
+// Stacks that outgrow their initial storage normally reallocate on every
+// invocation; attached stacks instead start with the largest storage retained
+// in the pool and return whatever storage they grew into when deinitialized.
+// Once the pool has warmed up steady-state invocations perform no heap
+// allocations for their stacks. Pools are usually created per context (or per
+// thread) and provided to invocations via iree_vm_invocation_policy_t.
+//
+// Thread-safe: any number of stacks may be attached concurrently.
+typedef struct iree_vm_stack_pool_t iree_vm_stack_pool_t;
+
+// Creates a new stack pool allocating storage from |host_allocator|.
+// |out_pool| must be released by the caller.
+IREE_API_EXPORT iree_status_t iree_vm_stack_pool_create(
+    iree_vm_stack_pool_options_t options, iree_allocator_t host_allocator,
+    iree_vm_stack_pool_t** out_pool);
+
+// Retains the given |pool| for the caller.
+IREE_API_EXPORT void iree_vm_stack_pool_retain(iree_vm_stack_pool_t* pool);
+
+// Releases the given |pool| from the caller.
+// Attached stacks retain the pool until they are deinitialized.
+IREE_API_EXPORT void iree_vm_stack_pool_release(iree_vm_stack_pool_t* pool);
+
+// Frees all storage retained by the |pool|.
+IREE_API_EXPORT void iree_vm_stack_pool_trim(iree_vm_stack_pool_t* pool);
+
+// Queries a snapshot of the |pool| statistics.
+IREE_API_EXPORT void iree_vm_stack_pool_query_statistics(
+    iree_vm_stack_pool_t* pool,
+    iree_vm_stack_pool_statistics_t* out_statistics);
+
+//===----------------------------------------------------------------------===//
+// iree_vm_stack_t
+//===----------------------------------------------------------------------===//
+
 // A fiber stack used for storing stack frame state during execution.
 // All required state is stored within the stack and no host thread-local state
 // is used allowing us to execute multiple fibers on the same host thread.
@@ -239,6 +311,16 @@ IREE_API_EXPORT iree_status_t iree_vm_stack_allocate(
 // Frees a dynamically-allocated |stack| from iree_vm_stack_allocate.
 IREE_API_EXPORT void iree_vm_stack_free(iree_vm_stack_t* stack);
 
+// Attaches an empty |stack| to |pool| such that storage growth is satisfied
+// from the pool and the storage is returned to the pool when the stack is
+// deinitialized. If the pool has retained storage larger than the current
+// stack capacity the stack switches to it immediately to avoid regrowing.
+// Stacks initialized with iree_allocator_null() still cannot grow when
+// attached and fail with IREE_STATUS_RESOURCE_EXHAUSTED as if they were not.
+// The pool is retained until the stack is deinitialized.
+IREE_API_EXPORT iree_status_t iree_vm_stack_attach_pool(
+    iree_vm_stack_t* stack, iree_vm_stack_pool_t* pool);
+
 // Returns the allocator used for growing the stack.
 IREE_API_EXPORT iree_allocator_t
 iree_vm_stack_allocator(const iree_vm_stack_t* stack);
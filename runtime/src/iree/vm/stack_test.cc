@@ -199,4 +199,156 @@ TEST(VMStackTest, ModuleStateQueryFailure) {
   iree_vm_stack_deinitialize(stack);
 }
 
+// Pushes |frame_count| frames of |frame_size| onto |stack| and pops them.
+static void PushAndPopFrames(iree_vm_stack_t* stack, int frame_count,
+                             iree_host_size_t frame_size) {
+  iree_vm_function_t function_a = {MODULE_A_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
+  for (int i = 0; i < frame_count; ++i) {
+    IREE_ASSERT_OK(iree_vm_stack_function_enter(
+        stack, &function_a, IREE_VM_STACK_FRAME_NATIVE, frame_size, NULL,
+        NULL));
+  }
+  for (int i = 0; i < frame_count; ++i) {
+    IREE_ASSERT_OK(iree_vm_stack_function_leave(stack));
+  }
+}
+
+// Tests that stacks attached to a pool only grow until the pool warms up.
+TEST(VMStackTest, PooledGrowthReuse) {
+  iree_vm_stack_pool_options_t options;
+  iree_vm_stack_pool_options_initialize(&options);
+  iree_vm_stack_pool_t* pool = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_stack_pool_create(options, iree_allocator_system(), &pool));
+
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  iree_vm_stack_pool_statistics_t warm_statistics;
+  for (int i = 0; i < 4; ++i) {
+    IREE_VM_INLINE_STACK_INITIALIZE(stack, IREE_VM_INVOCATION_FLAG_NONE,
+                                    state_resolver, iree_allocator_system());
+    IREE_ASSERT_OK(iree_vm_stack_attach_pool(stack, pool));
+    PushAndPopFrames(stack, 16, 4096);
+    iree_vm_stack_deinitialize(stack);
+    if (i == 0) {
+      // First use grows out of the inline storage.
+      iree_vm_stack_pool_query_statistics(pool, &warm_statistics);
+      EXPECT_GT(warm_statistics.growth_count, 0);
+      EXPECT_EQ(warm_statistics.growth_count,
+                warm_statistics.allocation_count);
+      EXPECT_EQ(0, warm_statistics.reuse_count);
+      EXPECT_GE(warm_statistics.peak_capacity, 16 * 4096);
+    }
+  }
+
+  // Subsequent uses start with the grown storage and never grow again.
+  iree_vm_stack_pool_statistics_t statistics;
+  iree_vm_stack_pool_query_statistics(pool, &statistics);
+  EXPECT_EQ(4, statistics.attach_count);
+  EXPECT_EQ(3, statistics.reuse_count);
+  EXPECT_EQ(warm_statistics.growth_count, statistics.growth_count);
+  EXPECT_EQ(warm_statistics.allocation_count, statistics.allocation_count);
+  EXPECT_GE(statistics.retained_count, 1);
+
+  iree_vm_stack_pool_trim(pool);
+  iree_vm_stack_pool_query_statistics(pool, &statistics);
+  EXPECT_EQ(0, statistics.retained_count);
+  EXPECT_EQ(0, statistics.retained_size);
+
+  iree_vm_stack_pool_release(pool);
+}
+
+// Tests that the pool retains the largest storage when over capacity.
+TEST(VMStackTest, PoolRetainsLargest) {
+  iree_vm_stack_pool_options_t options;
+  iree_vm_stack_pool_options_initialize(&options);
+  options.max_retained_count = 1;
+  iree_vm_stack_pool_t* pool = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_stack_pool_create(options, iree_allocator_system(), &pool));
+
+  // Two concurrently live stacks of differing depth both grow.
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  uint8_t small_stack_storage[IREE_VM_STACK_DEFAULT_SIZE];
+  iree_vm_stack_t* small_stack = nullptr;
+  IREE_ASSERT_OK(iree_vm_stack_initialize(
+      iree_make_byte_span(small_stack_storage, sizeof(small_stack_storage)),
+      IREE_VM_INVOCATION_FLAG_NONE, state_resolver, iree_allocator_system(),
+      &small_stack));
+  uint8_t large_stack_storage[IREE_VM_STACK_DEFAULT_SIZE];
+  iree_vm_stack_t* large_stack = nullptr;
+  IREE_ASSERT_OK(iree_vm_stack_initialize(
+      iree_make_byte_span(large_stack_storage, sizeof(large_stack_storage)),
+      IREE_VM_INVOCATION_FLAG_NONE, state_resolver, iree_allocator_system(),
+      &large_stack));
+  IREE_ASSERT_OK(iree_vm_stack_attach_pool(small_stack, pool));
+  IREE_ASSERT_OK(iree_vm_stack_attach_pool(large_stack, pool));
+  PushAndPopFrames(small_stack, 4, 4096);
+  PushAndPopFrames(large_stack, 64, 4096);
+  iree_vm_stack_deinitialize(large_stack);
+  iree_vm_stack_deinitialize(small_stack);
+
+  iree_vm_stack_pool_statistics_t statistics;
+  iree_vm_stack_pool_query_statistics(pool, &statistics);
+  EXPECT_EQ(1, statistics.retained_count);
+  EXPECT_EQ(statistics.peak_capacity, statistics.retained_size);
+
+  iree_vm_stack_pool_release(pool);
+}
+
+// Tests that stacks that cannot grow still cannot grow when attached to a pool.
+TEST(VMStackTest, PooledGrowthWithoutAllocator) {
+  iree_vm_stack_pool_options_t options;
+  iree_vm_stack_pool_options_initialize(&options);
+  iree_vm_stack_pool_t* pool = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_stack_pool_create(options, iree_allocator_system(), &pool));
+
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  IREE_VM_INLINE_STACK_INITIALIZE(stack, IREE_VM_INVOCATION_FLAG_NONE,
+                                  state_resolver, iree_allocator_null());
+  IREE_ASSERT_OK(iree_vm_stack_attach_pool(stack, pool));
+
+  // Push frames until we run out of the inline storage.
+  iree_vm_function_t function_a = {MODULE_A_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
+  iree_status_t status = iree_ok_status();
+  for (int i = 0; i < 64 && iree_status_is_ok(status); ++i) {
+    status = iree_vm_stack_function_enter(
+        stack, &function_a, IREE_VM_STACK_FRAME_NATIVE, 4096, NULL, NULL);
+  }
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_RESOURCE_EXHAUSTED, status);
+  iree_status_free(status);
+  iree_vm_stack_deinitialize(stack);
+
+  iree_vm_stack_pool_statistics_t statistics;
+  iree_vm_stack_pool_query_statistics(pool, &statistics);
+  EXPECT_EQ(0, statistics.growth_count);
+
+  iree_vm_stack_pool_release(pool);
+}
+
+// Tests that pools can only be attached to stacks with no frames.
+TEST(VMStackTest, AttachPoolToActiveStack) {
+  iree_vm_stack_pool_options_t options;
+  iree_vm_stack_pool_options_initialize(&options);
+  iree_vm_stack_pool_t* pool = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_stack_pool_create(options, iree_allocator_system(), &pool));
+
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  IREE_VM_INLINE_STACK_INITIALIZE(stack, IREE_VM_INVOCATION_FLAG_NONE,
+                                  state_resolver, iree_allocator_system());
+  iree_vm_function_t function_a = {MODULE_A_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
+  IREE_ASSERT_OK(iree_vm_stack_function_enter(
+      stack, &function_a, IREE_VM_STACK_FRAME_NATIVE, 0, NULL, NULL));
+  iree_status_t status = iree_vm_stack_attach_pool(stack, pool);
+  IREE_EXPECT_STATUS_IS(IREE_STATUS_FAILED_PRECONDITION, status);
+  iree_status_free(status);
+  iree_vm_stack_deinitialize(stack);
+
+  iree_vm_stack_pool_release(pool);
+}
+
 }  // namespace
@@ -124,6 +124,87 @@ vm.module @control_flow_ops {
     vm.return
   }
 
+  //===--------------------------------------------------------------------===//
+  // vm.cmp.* + vm.cond_br
+  //===--------------------------------------------------------------------===//
+  // Fused into vm.cond_br.cmp.* when targeting bytecode.
+
+  vm.export @test_cond_br_cmp_lt_i32_s
+  vm.func @test_cond_br_cmp_lt_i32_s() {
+    %cn1 = vm.const.i32 -1
+    %cn1dno = util.optimization_barrier %cn1 : i32
+    %c1 = vm.const.i32 1
+    %c1dno = util.optimization_barrier %c1 : i32
+    %slt = vm.cmp.lt.i32.s %cn1dno, %c1dno : i32
+    vm.cond_br %slt, ^bb1(%cn1dno : i32), ^bb2
+  ^bb1(%arg1 : i32):
+    vm.check.eq %arg1, %cn1dno, "error!" : i32
+    vm.return
+  ^bb2:
+    %code = vm.const.i32 4
+    vm.fail %code, "unreachable!"
+  }
+
+  vm.export @test_cond_br_cmp_lt_i32_u
+  vm.func @test_cond_br_cmp_lt_i32_u() {
+    %cn1 = vm.const.i32 -1
+    %cn1dno = util.optimization_barrier %cn1 : i32
+    %c1 = vm.const.i32 1
+    %c1dno = util.optimization_barrier %c1 : i32
+    %ult = vm.cmp.lt.i32.u %cn1dno, %c1dno : i32
+    vm.cond_br %ult, ^bb1, ^bb2(%c1dno : i32)
+  ^bb1:
+    %code = vm.const.i32 4
+    vm.fail %code, "unreachable!"
+  ^bb2(%arg2 : i32):
+    vm.check.eq %arg2, %c1dno, "error!" : i32
+    vm.return
+  }
+
+  vm.export @test_cond_br_cmp_ne_i64
+  vm.func @test_cond_br_cmp_ne_i64() {
+    %c1 = vm.const.i64 1
+    %c1dno = util.optimization_barrier %c1 : i64
+    %c2 = vm.const.i64 2
+    %c2dno = util.optimization_barrier %c2 : i64
+    %ne = vm.cmp.ne.i64 %c1dno, %c2dno : i64
+    vm.cond_br %ne, ^bb1(%c2dno : i64), ^bb2
+  ^bb1(%arg1 : i64):
+    vm.check.eq %arg1, %c2dno, "error!" : i64
+    vm.return
+  ^bb2:
+    %code = vm.const.i32 4
+    vm.fail %code, "unreachable!"
+  }
+
+  //===--------------------------------------------------------------------===//
+  // vm.add.* + vm.cmp.*
+  //===--------------------------------------------------------------------===//
+  // Fused into vm.add.cmp.* (and the loop exit into vm.cond_br.cmp.*) when
+  // targeting bytecode.
+
+  vm.export @test_add_cmp_loop
+  vm.func @test_add_cmp_loop() {
+    %c0 = vm.const.i64 0
+    %c1 = vm.const.i64 1
+    %c1dno = util.optimization_barrier %c1 : i64
+    %c10 = vm.const.i64 10
+    %c10dno = util.optimization_barrier %c10 : i64
+    %c45 = vm.const.i64 45
+    %false = vm.const.i32 0
+    vm.br ^loop(%c0, %c0 : i64, i64)
+  ^loop(%i : i64, %sum : i64):
+    %next_sum = vm.add.i64 %sum, %i : i64
+    %next = vm.add.i64 %i, %c1dno : i64
+    %slt = vm.cmp.lt.i64.s %next, %c10dno : i64
+    vm.cond_br %slt, ^loop(%next, %next_sum : i64, i64),
+                     ^exit(%next_sum, %slt : i64, i32)
+  ^exit(%result : i64, %last_slt : i32):
+    vm.check.eq %last_slt, %false, "exit on 10<10" : i32
+    vm.check.eq %result, %c45, "sum(0..9)=45" : i64
+    vm.return
+  }
+
   vm.export @test_br_table_inbounds
   vm.func private @test_br_table_inbounds() {
     %c0 = vm.const.i32 0
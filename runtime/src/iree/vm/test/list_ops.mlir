@@ -62,6 +62,24 @@ vm.module @list_ops {
     vm.return
   }
 
+  // Fused into vm.list.get.ref.cast when targeting bytecode.
+  vm.export @test_ref_get_cast attributes {emitc.exclude}
+  vm.func private @test_ref_get_cast() {
+    %c0 = vm.const.i32 0
+    %c1 = vm.const.i32 1
+    %c128 = vm.const.i64 128
+    %alignment = vm.const.i32 16
+    %buffer = vm.buffer.alloc %c128, %alignment : !vm.buffer
+    %buffer_any = vm.cast.ref.any %buffer : !vm.buffer -> !vm.ref<?>
+    %list = vm.list.alloc %c1 : (i32) -> !vm.list<?>
+    vm.list.resize %list, %c1 : (!vm.list<?>, i32)
+    vm.list.set.ref %list, %c0, %buffer_any : (!vm.list<?>, i32, !vm.ref<?>)
+    %ref = vm.list.get.ref %list, %c0 : (!vm.list<?>, i32) -> !vm.ref<?>
+    %ref_buffer = vm.cast.any.ref %ref : !vm.ref<?> -> !vm.buffer
+    vm.check.eq %buffer, %ref_buffer, "list.get(0)=buffer" : !vm.buffer
+    vm.return
+  }
+
   //===--------------------------------------------------------------------===//
   // Multiple lists within the same block
   //===--------------------------------------------------------------------===//
@@ -113,6 +131,22 @@ vm.module @list_ops {
     vm.return
   }
 
+  vm.export @fail_ref_get_cast_mismatch attributes {emitc.exclude}
+  vm.func private @fail_ref_get_cast_mismatch() {
+    %c0 = vm.const.i32 0
+    %c1 = vm.const.i32 1
+    %inner = vm.list.alloc %c1 : (i32) -> !vm.list<i32>
+    %inner_any = vm.cast.ref.any %inner : !vm.list<i32> -> !vm.ref<?>
+    %list = vm.list.alloc %c1 : (i32) -> !vm.list<?>
+    vm.list.resize %list, %c1 : (!vm.list<?>, i32)
+    vm.list.set.ref %list, %c0, %inner_any : (!vm.list<?>, i32, !vm.ref<?>)
+    %ref = vm.list.get.ref %list, %c0 : (!vm.list<?>, i32) -> !vm.ref<?>
+    // Should fail at runtime because of the type mismatch.
+    %buffer = vm.cast.any.ref %ref : !vm.ref<?> -> !vm.buffer
+    util.optimization_barrier %buffer : !vm.buffer
+    vm.return
+  }
+
   vm.export @fail_out_of_bounds_write
   vm.func @fail_out_of_bounds_write() {
     %c1 = vm.const.i32 1